@@ -10,11 +10,14 @@
 
 #include <asm/neon.h>
 #include <asm/hwcap.h>
+#include <asm/crypto/aes-xts.h>
+#include <asm/unaligned.h>
 #include <crypto/aes.h>
 #include <crypto/ablk_helper.h>
 #include <crypto/algapi.h>
 #include <linux/module.h>
 #include <linux/cpufeature.h>
+#include <linux/sizes.h>
 
 #ifdef USE_V8_CRYPTO_EXTENSIONS
 #define MODE			"ce"
@@ -274,6 +277,53 @@ static int xts_decrypt(struct blkcipher_desc *desc, struct scatterlist *dst,
 	return err;
 }
 
+#ifdef USE_V8_CRYPTO_EXTENSIONS
+/* bytes processed per NEON section, bounds the preempt off time */
+#define XTS_SECTORS_NEON_BYTES	SZ_64K
+
+int ce_aes_xts_crypt_sectors(struct crypto_blkcipher *tfm, u8 *dst,
+			     const u8 *src, unsigned int sector_size,
+			     unsigned int nsectors, u64 sector, bool enc)
+{
+	struct crypto_aes_xts_ctx *ctx = crypto_blkcipher_ctx(tfm);
+	int rounds = 6 + ctx->key1.key_length / 4;
+	unsigned int blocks = sector_size / AES_BLOCK_SIZE;
+	unsigned int done = 0;
+	u8 __aligned(8) iv[AES_BLOCK_SIZE];
+
+	if (crypto_blkcipher_alg(tfm)->encrypt != xts_encrypt)
+		return -EINVAL;
+	if (!blocks || sector_size % AES_BLOCK_SIZE)
+		return -EINVAL;
+
+	while (nsectors) {
+		kernel_neon_begin();
+		do {
+			memset(iv, 0, sizeof(iv));
+			put_unaligned_le64(sector++, iv);
+			if (enc)
+				aes_xts_encrypt(dst, src,
+						(u8 *)ctx->key1.key_enc,
+						rounds, blocks,
+						(u8 *)ctx->key2.key_enc, iv, 1);
+			else
+				aes_xts_decrypt(dst, src,
+						(u8 *)ctx->key1.key_dec,
+						rounds, blocks,
+						(u8 *)ctx->key2.key_enc, iv, 1);
+			dst += sector_size;
+			src += sector_size;
+			done += sector_size;
+		} while (--nsectors && done < XTS_SECTORS_NEON_BYTES);
+		kernel_neon_end();
+		done = 0;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(ce_aes_xts_crypt_sectors);
+#endif
+
 static struct crypto_alg aes_algs[] = { {
 	.cra_name		= "__ecb-aes-" MODE,
 	.cra_driver_name	= "__driver-ecb-aes-" MODE,
@@ -0,0 +1,265 @@
+/*
+ * crc32-arm64.c - CRC32 and CRC32C using the ARMv8 CRC32 instructions
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <asm/unaligned.h>
+#include <crypto/internal/hash.h>
+#include <linux/cpufeature.h>
+#include <linux/crypto.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/string.h>
+
+MODULE_DESCRIPTION("CRC32 and CRC32C using ARMv8 CRC32 instructions");
+MODULE_LICENSE("GPL v2");
+
+#define CHKSUM_BLOCK_SIZE	1
+#define CHKSUM_DIGEST_SIZE	4
+
+#define CRC32_INSN(insn, crc, value, reg)			\
+	asm(insn " %w[c], %w[c], %" reg "[v]"			\
+	    : [c] "+r" (crc) : [v] "r" (value))
+
+#define CRC32X(crc, value)	CRC32_INSN("crc32x", crc, value, "x")
+#define CRC32W(crc, value)	CRC32_INSN("crc32w", crc, value, "w")
+#define CRC32H(crc, value)	CRC32_INSN("crc32h", crc, value, "w")
+#define CRC32B(crc, value)	CRC32_INSN("crc32b", crc, value, "w")
+#define CRC32CX(crc, value)	CRC32_INSN("crc32cx", crc, value, "x")
+#define CRC32CW(crc, value)	CRC32_INSN("crc32cw", crc, value, "w")
+#define CRC32CH(crc, value)	CRC32_INSN("crc32ch", crc, value, "w")
+#define CRC32CB(crc, value)	CRC32_INSN("crc32cb", crc, value, "w")
+
+/*
+ * The 64-bit form consumes eight bytes per instruction, and the loop is
+ * unrolled so that independent loads can issue ahead of the CRC chain.
+ */
+static u32 crc32_arm64_le_hw(u32 crc, const u8 *p, unsigned int len)
+{
+	while (len >= 32) {
+		CRC32X(crc, get_unaligned_le64(p));
+		CRC32X(crc, get_unaligned_le64(p + 8));
+		CRC32X(crc, get_unaligned_le64(p + 16));
+		CRC32X(crc, get_unaligned_le64(p + 24));
+		p += 32;
+		len -= 32;
+	}
+	while (len >= 8) {
+		CRC32X(crc, get_unaligned_le64(p));
+		p += 8;
+		len -= 8;
+	}
+	if (len & 4) {
+		CRC32W(crc, get_unaligned_le32(p));
+		p += 4;
+	}
+	if (len & 2) {
+		CRC32H(crc, get_unaligned_le16(p));
+		p += 2;
+	}
+	if (len & 1)
+		CRC32B(crc, *p);
+
+	return crc;
+}
+
+static u32 crc32c_arm64_le_hw(u32 crc, const u8 *p, unsigned int len)
+{
+	while (len >= 32) {
+		CRC32CX(crc, get_unaligned_le64(p));
+		CRC32CX(crc, get_unaligned_le64(p + 8));
+		CRC32CX(crc, get_unaligned_le64(p + 16));
+		CRC32CX(crc, get_unaligned_le64(p + 24));
+		p += 32;
+		len -= 32;
+	}
+	while (len >= 8) {
+		CRC32CX(crc, get_unaligned_le64(p));
+		p += 8;
+		len -= 8;
+	}
+	if (len & 4) {
+		CRC32CW(crc, get_unaligned_le32(p));
+		p += 4;
+	}
+	if (len & 2) {
+		CRC32CH(crc, get_unaligned_le16(p));
+		p += 2;
+	}
+	if (len & 1)
+		CRC32CB(crc, *p);
+
+	return crc;
+}
+
+/*
+ * Setting the seed allows arbitrary accumulators and flexible XOR policy.
+ * The seed defaults to 0 for crc32 and ~0 for crc32c, as in the generic
+ * implementations.
+ */
+static int crc32_setkey(struct crypto_shash *hash, const u8 *key,
+			unsigned int keylen)
+{
+	u32 *mctx = crypto_shash_ctx(hash);
+
+	if (keylen != sizeof(u32)) {
+		crypto_shash_set_flags(hash, CRYPTO_TFM_RES_BAD_KEY_LEN);
+		return -EINVAL;
+	}
+	*mctx = get_unaligned_le32(key);
+	return 0;
+}
+
+static int crc32_cra_init(struct crypto_tfm *tfm)
+{
+	u32 *mctx = crypto_tfm_ctx(tfm);
+
+	*mctx = 0;
+	return 0;
+}
+
+static int crc32c_cra_init(struct crypto_tfm *tfm)
+{
+	u32 *mctx = crypto_tfm_ctx(tfm);
+
+	*mctx = ~0;
+	return 0;
+}
+
+static int crc32_init(struct shash_desc *desc)
+{
+	u32 *mctx = crypto_shash_ctx(desc->tfm);
+	u32 *crc = shash_desc_ctx(desc);
+
+	*crc = *mctx;
+	return 0;
+}
+
+static int crc32_update(struct shash_desc *desc, const u8 *data,
+			unsigned int len)
+{
+	u32 *crc = shash_desc_ctx(desc);
+
+	*crc = crc32_arm64_le_hw(*crc, data, len);
+	return 0;
+}
+
+static int crc32c_update(struct shash_desc *desc, const u8 *data,
+			 unsigned int len)
+{
+	u32 *crc = shash_desc_ctx(desc);
+
+	*crc = crc32c_arm64_le_hw(*crc, data, len);
+	return 0;
+}
+
+static int crc32_final(struct shash_desc *desc, u8 *out)
+{
+	u32 *crc = shash_desc_ctx(desc);
+
+	put_unaligned_le32(*crc, out);
+	return 0;
+}
+
+static int crc32c_final(struct shash_desc *desc, u8 *out)
+{
+	u32 *crc = shash_desc_ctx(desc);
+
+	put_unaligned_le32(~*crc, out);
+	return 0;
+}
+
+static int crc32_finup(struct shash_desc *desc, const u8 *data,
+		       unsigned int len, u8 *out)
+{
+	u32 *crc = shash_desc_ctx(desc);
+
+	put_unaligned_le32(crc32_arm64_le_hw(*crc, data, len), out);
+	return 0;
+}
+
+static int crc32c_finup(struct shash_desc *desc, const u8 *data,
+			unsigned int len, u8 *out)
+{
+	u32 *crc = shash_desc_ctx(desc);
+
+	put_unaligned_le32(~crc32c_arm64_le_hw(*crc, data, len), out);
+	return 0;
+}
+
+static int crc32_digest(struct shash_desc *desc, const u8 *data,
+			unsigned int len, u8 *out)
+{
+	u32 *mctx = crypto_shash_ctx(desc->tfm);
+
+	put_unaligned_le32(crc32_arm64_le_hw(*mctx, data, len), out);
+	return 0;
+}
+
+static int crc32c_digest(struct shash_desc *desc, const u8 *data,
+			 unsigned int len, u8 *out)
+{
+	u32 *mctx = crypto_shash_ctx(desc->tfm);
+
+	put_unaligned_le32(~crc32c_arm64_le_hw(*mctx, data, len), out);
+	return 0;
+}
+
+static struct shash_alg crc32_algs[] = { {
+	.setkey			= crc32_setkey,
+	.init			= crc32_init,
+	.update			= crc32_update,
+	.final			= crc32_final,
+	.finup			= crc32_finup,
+	.digest			= crc32_digest,
+	.descsize		= sizeof(u32),
+	.digestsize		= CHKSUM_DIGEST_SIZE,
+	.base			= {
+		.cra_name		= "crc32",
+		.cra_driver_name	= "crc32-arm64-hw",
+		.cra_priority		= 300,
+		.cra_flags		= CRYPTO_ALG_TYPE_SHASH,
+		.cra_blocksize		= CHKSUM_BLOCK_SIZE,
+		.cra_alignmask		= 0,
+		.cra_ctxsize		= sizeof(u32),
+		.cra_module		= THIS_MODULE,
+		.cra_init		= crc32_cra_init,
+	}
+}, {
+	.setkey			= crc32_setkey,
+	.init			= crc32_init,
+	.update			= crc32c_update,
+	.final			= crc32c_final,
+	.finup			= crc32c_finup,
+	.digest			= crc32c_digest,
+	.descsize		= sizeof(u32),
+	.digestsize		= CHKSUM_DIGEST_SIZE,
+	.base			= {
+		.cra_name		= "crc32c",
+		.cra_driver_name	= "crc32c-arm64-hw",
+		.cra_priority		= 300,
+		.cra_flags		= CRYPTO_ALG_TYPE_SHASH,
+		.cra_blocksize		= CHKSUM_BLOCK_SIZE,
+		.cra_alignmask		= 0,
+		.cra_ctxsize		= sizeof(u32),
+		.cra_module		= THIS_MODULE,
+		.cra_init		= crc32c_cra_init,
+	}
+} };
+
+static int __init crc32_mod_init(void)
+{
+	return crypto_register_shashes(crc32_algs, ARRAY_SIZE(crc32_algs));
+}
+
+static void __exit crc32_mod_exit(void)
+{
+	crypto_unregister_shashes(crc32_algs, ARRAY_SIZE(crc32_algs));
+}
+
+module_cpu_feature_match(CRC32, crc32_mod_init);
+module_exit(crc32_mod_exit);
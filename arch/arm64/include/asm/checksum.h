@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#ifndef __ASM_CHECKSUM_H
+#define __ASM_CHECKSUM_H
+
+#include <linux/in6.h>
+
+static inline __sum16 csum_fold(__wsum csum)
+{
+	u32 sum = (__force u32)csum;
+
+	/* the upper half ends up holding the end-around carried sum */
+	sum += (sum >> 16) | (sum << 16);
+	return (__force __sum16)~(sum >> 16);
+}
+#define csum_fold csum_fold
+
+/* IP headers are at least 20 bytes and unaligned loads are fine */
+static inline __sum16 ip_fast_csum(const void *iph, unsigned int ihl)
+{
+	const u32 *p = iph;
+	u64 sum = 0;
+
+	while (ihl--)
+		sum += *p++;
+
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	return csum_fold((__force __wsum)sum);
+}
+#define ip_fast_csum ip_fast_csum
+
+extern unsigned int do_csum(const unsigned char *buff, int len);
+#define do_csum do_csum
+
+#define _HAVE_ARCH_IPV6_CSUM
+extern __sum16 csum_ipv6_magic(const struct in6_addr *saddr,
+			       const struct in6_addr *daddr,
+			       __u32 len, unsigned short proto, __wsum sum);
+
+#include <asm-generic/checksum.h>
+
+#endif /* __ASM_CHECKSUM_H */
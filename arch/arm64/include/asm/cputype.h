@@ -68,6 +68,7 @@
 
 #define ARM_CPU_IMP_ARM		0x41
 #define ARM_CPU_IMP_APM		0x50
+#define ARM_CPU_IMP_QCOM	0x51
 
 #define ARM_CPU_PART_AEM_V8	0xD0F
 #define ARM_CPU_PART_FOUNDATION	0xD00
@@ -77,6 +78,10 @@
 
 #define APM_CPU_PART_POTENZA	0x000
 
+/* Kryo parts are 0x2xx, with the low bits telling the variants apart */
+#define QCOM_CPU_PART_KRYO	0x200
+#define QCOM_CPU_PART_KRYO_MASK	0xf00
+
 #define ID_AA64MMFR0_BIGENDEL0_SHIFT	16
 #define ID_AA64MMFR0_BIGENDEL0_MASK	(0xf << ID_AA64MMFR0_BIGENDEL0_SHIFT)
 #define ID_AA64MMFR0_BIGENDEL0(mmfr0)	\
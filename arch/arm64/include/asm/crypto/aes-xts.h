@@ -0,0 +1,17 @@
+#ifndef __ASM_CRYPTO_AES_XTS_H
+#define __ASM_CRYPTO_AES_XTS_H
+
+#include <linux/crypto.h>
+
+/*
+ * Encrypt or decrypt @nsectors consecutive sectors of @sector_size bytes
+ * in place or from @src to @dst, using the little endian sector number
+ * as the IV (plain64), starting at @sector. @tfm must be an instance of
+ * "__driver-xts-aes-ce". Data sectors are handled in a few NEON sections
+ * with no scatterlist walk, rather than one request per sector.
+ */
+int ce_aes_xts_crypt_sectors(struct crypto_blkcipher *tfm, u8 *dst,
+			     const u8 *src, unsigned int sector_size,
+			     unsigned int nsectors, u64 sector, bool enc);
+
+#endif /* __ASM_CRYPTO_AES_XTS_H */
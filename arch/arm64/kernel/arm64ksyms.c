@@ -58,6 +58,9 @@ EXPORT_SYMBOL(__memmove);
 EXPORT_SYMBOL(memchr);
 EXPORT_SYMBOL(memcmp);
 
+	/* checksum */
+EXPORT_SYMBOL(csum_ipv6_magic);
+
 	/* atomic bitops */
 EXPORT_SYMBOL(set_bit);
 EXPORT_SYMBOL(test_and_set_bit);
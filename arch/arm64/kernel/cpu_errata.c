@@ -58,6 +58,15 @@ is_affected_midr_range(struct arm64_cpu_capabilities *entry)
 	return (midr >= entry->midr_range_min && midr <= entry->midr_range_max);
 }
 
+static bool is_kryo_midr(struct arm64_cpu_capabilities *entry)
+{
+	u32 midr = read_cpuid_id();
+
+	return MIDR_IMPLEMENTOR(midr) == ARM_CPU_IMP_QCOM &&
+	       (MIDR_PARTNUM(midr) & QCOM_CPU_PART_KRYO_MASK) ==
+	       QCOM_CPU_PART_KRYO;
+}
+
 #define MIDR_RANGE(model, min, max) \
 	.is_affected = is_affected_midr_range, \
 	.midr_model = model, \
@@ -100,6 +109,12 @@ struct arm64_cpu_capabilities arm64_errata[] = {
 		MIDR_RANGE(MIDR_CORTEX_A53, 0x00, 0x04),
 	},
 #endif
+	{
+	/* Qualcomm Kryo, all revisions */
+		.desc = "Kryo copy and clear prefetch distance",
+		.capability = ARM64_KRYO_PREFETCH,
+		.is_affected = is_kryo_midr,
+	},
 	{
 	}
 };
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Internet checksum helpers. do_csum() backs the generic csum_partial()
+ * and sums large buffers with NEON, the rest with 64-bit adds. Words
+ * are loaded relative to the start of the buffer, whatever its
+ * alignment, so no byte swapping is needed for odd addresses.
+ */
+
+#include <linux/kernel.h>
+#include <linux/types.h>
+#include <asm/byteorder.h>
+#include <asm/checksum.h>
+#include <asm/neon.h>
+
+/* Below this, saving and restoring the NEON registers costs too much */
+#define CSUM_NEON_MIN_LEN	256
+
+u64 __csum_neon(const void *buf, unsigned long len);
+
+static inline u64 csum_add64(u64 sum, u64 val)
+{
+	sum += val;
+	return sum + (sum < val);
+}
+
+static inline u32 csum_from64(u64 sum)
+{
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	return sum;
+}
+
+unsigned int do_csum(const unsigned char *buff, int len)
+{
+	u64 sum = 0;
+	u32 res;
+
+	if (len <= 0)
+		return 0;
+
+	if (IS_ENABLED(CONFIG_KERNEL_MODE_NEON) && len >= CSUM_NEON_MIN_LEN) {
+		unsigned long n = len & ~63UL;
+
+		kernel_neon_begin_partial(8);
+		sum = __csum_neon(buff, n);
+		kernel_neon_end();
+		buff += n;
+		len -= n;
+	}
+
+	for (; len >= 8; buff += 8, len -= 8)
+		sum = csum_add64(sum, *(const u64 *)buff);
+	if (len >= 4) {
+		sum = csum_add64(sum, *(const u32 *)buff);
+		buff += 4;
+		len -= 4;
+	}
+	if (len >= 2) {
+		sum = csum_add64(sum, *(const u16 *)buff);
+		buff += 2;
+		len -= 2;
+	}
+	if (len) {
+#ifdef __LITTLE_ENDIAN
+		sum = csum_add64(sum, *buff);
+#else
+		sum = csum_add64(sum, *buff << 8);
+#endif
+	}
+
+	res = csum_from64(sum);
+	res = (res & 0xffff) + (res >> 16);
+	return (res & 0xffff) + (res >> 16);
+}
+
+__sum16 csum_ipv6_magic(const struct in6_addr *saddr,
+			const struct in6_addr *daddr,
+			__u32 len, unsigned short proto, __wsum csum)
+{
+	const u64 *s = (const u64 *)saddr->s6_addr32;
+	const u64 *d = (const u64 *)daddr->s6_addr32;
+	u64 sum = (__force u32)csum;
+
+	sum = csum_add64(sum, s[0]);
+	sum = csum_add64(sum, s[1]);
+	sum = csum_add64(sum, d[0]);
+	sum = csum_add64(sum, d[1]);
+	sum = csum_add64(sum, (__force u32)htonl(len));
+	sum = csum_add64(sum, (__force u32)htonl(proto));
+
+	return csum_fold((__force __wsum)csum_from64(sum));
+}
@@ -438,6 +438,11 @@ struct request_queue *blk_alloc_queue_node(gfp_t gfp_mask, int node_id)
 	if (blkcg_init_queue(q))
 		goto fail_bdi;
 
+#ifdef CONFIG_BLK_LATENCY_HIST
+	/* the histograms are optional, the queue works without them */
+	q->latency_hist = alloc_percpu(struct blk_latency_hist);
+#endif
+
 	return q;
 
 fail_bdi:
@@ -1792,6 +1797,57 @@ void blk_unprep_request(struct request *req)
 }
 EXPORT_SYMBOL_GPL(blk_unprep_request);
 
+#ifdef CONFIG_BLK_LATENCY_HIST
+static unsigned int blk_latency_bucket(u64 ns)
+{
+	u64 us = div_u64(ns, NSEC_PER_USEC);
+
+	if (!us)
+		return 0;
+
+	return min_t(unsigned int, ilog2(us) + 1, BLK_LAT_BUCKETS - 1);
+}
+
+/* Called with the queue lock held, for requests that were dispatched */
+static void blk_latency_hist_account(struct request *req)
+{
+	struct blk_latency_hist __percpu *hist = req->q->latency_hist;
+	u64 start = rq_start_time_ns(req);
+	u64 io_start = rq_io_start_time_ns(req);
+	u64 now;
+	int type;
+
+	if (!hist)
+		return;
+
+	if (req->cmd_flags & REQ_FLUSH)
+		type = BLK_LAT_FLUSH;
+	else if (rq_data_dir(req) == WRITE)
+		type = BLK_LAT_WRITE;
+	else
+		type = BLK_LAT_READ;
+
+	preempt_disable();
+	now = sched_clock();
+	preempt_enable();
+
+	/* sched_clock may be slightly off between cpus */
+	if (io_start < start)
+		io_start = start;
+	if (now < io_start)
+		now = io_start;
+
+	this_cpu_inc(hist->buckets[type][BLK_LAT_QUEUE]
+		     [blk_latency_bucket(io_start - start)]);
+	this_cpu_inc(hist->buckets[type][BLK_LAT_SERVICE]
+		     [blk_latency_bucket(now - io_start)]);
+	this_cpu_inc(hist->buckets[type][BLK_LAT_TOTAL]
+		     [blk_latency_bucket(now - start)]);
+}
+#else
+static inline void blk_latency_hist_account(struct request *req) { }
+#endif
+
 void blk_finish_request(struct request *req, int error)
 {
 	if (blk_rq_tagged(req))
@@ -1807,6 +1863,9 @@ void blk_finish_request(struct request *req, int error)
 	if (req->cmd_flags & REQ_DONTPREP)
 		blk_unprep_request(req);
 
+	if (blk_account_rq(req))
+		blk_latency_hist_account(req);
+
 	blk_account_io_done(req);
 
 	if (req->end_io)
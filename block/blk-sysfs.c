@@ -285,6 +285,77 @@ queue_rq_affinity_store(struct request_queue *q, const char *page, size_t count)
 	return ret;
 }
 
+#ifdef CONFIG_BLK_LATENCY_HIST
+static ssize_t queue_latency_hist_show(struct request_queue *q, char *page,
+				       int type)
+{
+	u64 sum[BLK_LAT_STAGES];
+	ssize_t len;
+	int b, s, cpu;
+
+	if (!q->latency_hist)
+		return -ENODEV;
+
+	len = sprintf(page, "usecs queue service total\n");
+	for (b = 0; b < BLK_LAT_BUCKETS; b++) {
+		memset(sum, 0, sizeof(sum));
+		for_each_possible_cpu(cpu) {
+			struct blk_latency_hist *hist =
+				per_cpu_ptr(q->latency_hist, cpu);
+
+			for (s = 0; s < BLK_LAT_STAGES; s++)
+				sum[s] += hist->buckets[type][s][b];
+		}
+		len += sprintf(page + len, "%lu %llu %llu %llu\n",
+			       b ? 1UL << (b - 1) : 0UL,
+			       sum[BLK_LAT_QUEUE], sum[BLK_LAT_SERVICE],
+			       sum[BLK_LAT_TOTAL]);
+	}
+
+	return len;
+}
+
+static ssize_t queue_latency_hist_clear(struct request_queue *q,
+					size_t count, int type)
+{
+	int cpu;
+
+	if (!q->latency_hist)
+		return -ENODEV;
+
+	for_each_possible_cpu(cpu) {
+		struct blk_latency_hist *hist =
+			per_cpu_ptr(q->latency_hist, cpu);
+
+		memset(hist->buckets[type], 0, sizeof(hist->buckets[type]));
+	}
+
+	return count;
+}
+
+#define QUEUE_LATENCY_HIST(name, type)					\
+static ssize_t queue_##name##_latency_show(struct request_queue *q,	\
+					   char *page)			\
+{									\
+	return queue_latency_hist_show(q, page, type);			\
+}									\
+static ssize_t queue_##name##_latency_store(struct request_queue *q,	\
+					    const char *page,		\
+					    size_t count)		\
+{									\
+	return queue_latency_hist_clear(q, count, type);		\
+}									\
+static struct queue_sysfs_entry queue_##name##_latency_entry = {	\
+	.attr = {.name = #name "_latency_hist", .mode = S_IRUGO | S_IWUSR },\
+	.show = queue_##name##_latency_show,				\
+	.store = queue_##name##_latency_store,				\
+}
+
+QUEUE_LATENCY_HIST(read, BLK_LAT_READ);
+QUEUE_LATENCY_HIST(write, BLK_LAT_WRITE);
+QUEUE_LATENCY_HIST(flush, BLK_LAT_FLUSH);
+#endif
+
 static struct queue_sysfs_entry queue_requests_entry = {
 	.attr = {.name = "nr_requests", .mode = S_IRUGO | S_IWUSR },
 	.show = queue_requests_show,
@@ -427,6 +498,11 @@ static struct attribute *default_attrs[] = {
 	&queue_rq_affinity_entry.attr,
 	&queue_iostats_entry.attr,
 	&queue_random_entry.attr,
+#ifdef CONFIG_BLK_LATENCY_HIST
+	&queue_read_latency_entry.attr,
+	&queue_write_latency_entry.attr,
+	&queue_flush_latency_entry.attr,
+#endif
 	NULL,
 };
 
@@ -520,6 +596,10 @@ static void blk_release_queue(struct kobject *kobj)
 
 	blk_trace_shutdown(q);
 
+#ifdef CONFIG_BLK_LATENCY_HIST
+	free_percpu(q->latency_hist);
+#endif
+
 	bdi_destroy(&q->backing_dev_info);
 
 	ida_simple_remove(&blk_queue_ida, q->id);
@@ -280,4 +280,28 @@ static inline int blk_throtl_init(struct request_queue *q) { return 0; }
 static inline void blk_throtl_exit(struct request_queue *q) { }
 #endif /* CONFIG_BLK_DEV_THROTTLING */
 
+/*
+ * Request latency histograms. Bucket 0 counts latencies under 1us and
+ * bucket n those in [2^(n-1), 2^n) us, the last bucket takes the rest.
+ */
+#define BLK_LAT_BUCKETS		24
+
+enum {
+	BLK_LAT_READ,
+	BLK_LAT_WRITE,
+	BLK_LAT_FLUSH,
+	BLK_LAT_TYPES,
+};
+
+enum {
+	BLK_LAT_QUEUE,		/* submit to dispatch */
+	BLK_LAT_SERVICE,	/* dispatch to completion */
+	BLK_LAT_TOTAL,		/* submit to completion */
+	BLK_LAT_STAGES,
+};
+
+struct blk_latency_hist {
+	u64 buckets[BLK_LAT_TYPES][BLK_LAT_STAGES][BLK_LAT_BUCKETS];
+};
+
 #endif /* BLK_INTERNAL_H */
@@ -29,6 +29,7 @@ static int cfq_slice_idle = HZ / 125;
 static int cfq_group_idle = HZ / 125;
 static const int cfq_target_latency = HZ * 3/10; 
 static const int cfq_hist_divisor = 4;
+static int cfq_fg_latency_target = HZ / 20;
 
 extern int launch_event_enabled;
 
@@ -39,6 +40,7 @@ extern int launch_event_enabled;
 #define CFQ_SLICE_SCALE		(5)
 #define CFQ_HW_QUEUE_MIN	(5)
 #define CFQ_SERVICE_SHIFT       12
+#define CFQ_LAT_SHIFT		3
 
 #define CFQQ_SEEK_THR		(sector_t)(8 * 100)
 #define CFQQ_CLOSE_THR		(sector_t)(8 * 1024)
@@ -285,6 +287,17 @@ struct cfq_data {
 	unsigned int cfq_group_idle;
 	unsigned int cfq_latency;
 	unsigned int cfq_target_latency;
+	unsigned int cfq_fg_latency_target;
+	unsigned int cfq_bg_weight;
+
+	/*
+	 * Foreground sync read latency, in jiffies << CFQ_LAT_SHIFT, and
+	 * the dispatch depth it currently allows each background group.
+	 */
+	unsigned long fg_read_lat;
+	unsigned long last_fg_read;
+	unsigned long bg_depth_stamp;
+	unsigned int bg_depth;
 
 	struct cfq_queue oom_cfqq;
 
@@ -2383,6 +2396,64 @@ static void cfq_arm_slice_timer(struct cfq_data *cfqd)
 			group_idle ? 1 : 0);
 }
 
+/*
+ * Groups weighted below bg_weight hold background apps. They are not
+ * idled for, and their dispatch depth shrinks while foreground reads
+ * miss fg_latency_target.
+ */
+static inline bool cfq_group_is_bg(struct cfq_data *cfqd,
+				   struct cfq_group *cfqg)
+{
+	return cfqg->weight < cfqd->cfq_bg_weight;
+}
+
+static bool cfq_bg_throttled(struct cfq_data *cfqd, struct cfq_queue *cfqq)
+{
+	if (!cfqd->cfq_fg_latency_target ||
+	    !cfq_group_is_bg(cfqd, cfqq->cfqg))
+		return false;
+
+	/* nothing to protect if the foreground has not read lately */
+	if (time_after(jiffies, cfqd->last_fg_read + cfqd->cfq_target_latency))
+		return false;
+
+	return cfqq->cfqg->dispatched >= cfqd->bg_depth;
+}
+
+/*
+ * Additive increase, multiplicative decrease of the background depth,
+ * halving it at most once per target period while the foreground read
+ * latency is above target.
+ */
+static void cfq_update_fg_latency(struct cfq_data *cfqd, struct request *rq,
+				  unsigned long now)
+{
+	unsigned long lat;
+
+	if (!cfqd->cfq_fg_latency_target ||
+	    cfq_group_is_bg(cfqd, RQ_CFQG(rq)) ||
+	    rq_data_dir(rq) != READ || !rq_is_sync(rq))
+		return;
+
+	lat = (now - rq->start_time) << CFQ_LAT_SHIFT;
+	cfqd->fg_read_lat = (cfqd->fg_read_lat * 7 + lat) >> 3;
+	cfqd->last_fg_read = now;
+
+	if (cfqd->fg_read_lat >
+	    (cfqd->cfq_fg_latency_target << CFQ_LAT_SHIFT)) {
+		if (time_after(now, cfqd->bg_depth_stamp +
+			       cfqd->cfq_fg_latency_target)) {
+			cfqd->bg_depth = max(cfqd->bg_depth / 2, 1U);
+			cfqd->bg_depth_stamp = now;
+			cfq_log(cfqd, "fg read lat %lu bg depth %u",
+				cfqd->fg_read_lat >> CFQ_LAT_SHIFT,
+				cfqd->bg_depth);
+		}
+	} else if (cfqd->bg_depth < cfqd->cfq_quantum) {
+		cfqd->bg_depth++;
+	}
+}
+
 static void cfq_dispatch_insert(struct request_queue *q, struct request *rq)
 {
 	struct cfq_data *cfqd = q->elevator->elevator_data;
@@ -2635,6 +2706,7 @@ static struct cfq_queue *cfq_select_queue(struct cfq_data *cfqd)
 
 check_group_idle:
 	if (cfqd->cfq_group_idle && cfqq->cfqg->nr_cfqq == 1 &&
+	    !cfq_group_is_bg(cfqd, cfqq->cfqg) &&
 	    cfqq->cfqg->dispatched &&
 	    !cfq_io_thinktime_big(cfqd, &cfqq->cfqg->ttime, true)) {
 		cfqq = NULL;
@@ -2709,6 +2781,9 @@ static bool cfq_may_dispatch(struct cfq_data *cfqd, struct cfq_queue *cfqq)
 	if (cfqd->rq_in_flight[BLK_RW_SYNC] && !cfq_cfqq_sync(cfqq))
 		return false;
 
+	if (cfq_bg_throttled(cfqd, cfqq))
+		return false;
+
 	max_dispatch = max_t(unsigned int, cfqd->cfq_quantum / 2, 1);
 	if (cfq_class_idle(cfqq))
 		max_dispatch = 1;
@@ -2785,8 +2860,12 @@ static int cfq_dispatch_requests(struct request_queue *q, int force)
 	if (!cfqq)
 		return 0;
 
-	if (!cfq_dispatch_request(cfqd, cfqq))
+	if (!cfq_dispatch_request(cfqd, cfqq)) {
+		/* hand the disk to the others rather than wait on the depth */
+		if (cfqd->busy_queues > 1 && cfq_bg_throttled(cfqd, cfqq))
+			cfq_slice_expired(cfqd, 0);
 		return 0;
+	}
 
 	cfqq->slice_dispatch++;
 	cfq_clear_cfqq_must_dispatch(cfqq);
@@ -3392,6 +3471,7 @@ static void cfq_completed_request(struct request_queue *q, struct request *rq)
 				     rq_io_start_time_ns(rq), rq->cmd_flags);
 
 	cfqd->rq_in_flight[cfq_cfqq_sync(cfqq)]--;
+	cfq_update_fg_latency(cfqd, rq, now);
 
 	if (sync) {
 		struct cfq_rb_root *st;
@@ -3732,8 +3812,12 @@ static int cfq_init_queue(struct request_queue *q, struct elevator_type *e)
 	cfqd->cfq_slice_idle = cfq_slice_idle;
 	cfqd->cfq_group_idle = cfq_group_idle;
 	cfqd->cfq_latency = 1;
+	cfqd->cfq_fg_latency_target = cfq_fg_latency_target;
+	cfqd->cfq_bg_weight = CFQ_WEIGHT_DEFAULT;
+	cfqd->bg_depth = cfq_quantum;
 	cfqd->hw_tag = -1;
 	cfqd->last_delayed_sync = jiffies - HZ;
+	cfqd->last_fg_read = jiffies - HZ;
 	return 0;
 
 out_free:
@@ -3778,6 +3862,8 @@ SHOW_FUNCTION(cfq_slice_async_show, cfqd->cfq_slice[0], 1);
 SHOW_FUNCTION(cfq_slice_async_rq_show, cfqd->cfq_slice_async_rq, 0);
 SHOW_FUNCTION(cfq_low_latency_show, cfqd->cfq_latency, 0);
 SHOW_FUNCTION(cfq_target_latency_show, cfqd->cfq_target_latency, 1);
+SHOW_FUNCTION(cfq_fg_latency_target_show, cfqd->cfq_fg_latency_target, 1);
+SHOW_FUNCTION(cfq_bg_weight_show, cfqd->cfq_bg_weight, 0);
 #undef SHOW_FUNCTION
 
 #define STORE_FUNCTION(__FUNC, __PTR, MIN, MAX, __CONV)			\
@@ -3812,6 +3898,10 @@ STORE_FUNCTION(cfq_slice_async_rq_store, &cfqd->cfq_slice_async_rq, 1,
 		UINT_MAX, 0);
 STORE_FUNCTION(cfq_low_latency_store, &cfqd->cfq_latency, 0, 1, 0);
 STORE_FUNCTION(cfq_target_latency_store, &cfqd->cfq_target_latency, 1, UINT_MAX, 1);
+STORE_FUNCTION(cfq_fg_latency_target_store, &cfqd->cfq_fg_latency_target, 0,
+		UINT_MAX, 1);
+STORE_FUNCTION(cfq_bg_weight_store, &cfqd->cfq_bg_weight, 0, CFQ_WEIGHT_MAX,
+		0);
 #undef STORE_FUNCTION
 
 #define CFQ_ATTR(name) \
@@ -3830,6 +3920,8 @@ static struct elv_fs_entry cfq_attrs[] = {
 	CFQ_ATTR(group_idle),
 	CFQ_ATTR(low_latency),
 	CFQ_ATTR(target_latency),
+	CFQ_ATTR(fg_latency_target),
+	CFQ_ATTR(bg_weight),
 	__ATTR_NULL
 };
 
@@ -28,6 +28,8 @@
 #include <linux/debugfs.h>
 #include <linux/test-iosched.h>
 #include <linux/delay.h>
+#include <linux/random.h>
+#include <linux/uaccess.h>
 #include "blk.h"
 
 #define MODULE_NAME "test-iosched"
@@ -35,6 +37,8 @@
 #define UNIQUE_START_REQ_ID 5678
 #define TIMEOUT_TIMER_MS 40000
 #define TEST_MAX_TESTCASE_ROUNDS 15
+#define TEST_IOPS_NR_REQS 2000
+#define TEST_IOPS_READ_PERCENT 70
 
 
 static DEFINE_MUTEX(blk_dev_test_list_lock);
@@ -146,6 +150,10 @@ static void end_test_req(struct request *rq, int err)
 	test_rq->req_result = err;
 
 	check_test_completion(tios);
+
+	/* a depth limited test has to be kicked for its next request */
+	if (tios->queue_depth && tios->test_state == TEST_RUNNING)
+		blk_run_queue_async(rq->q);
 }
 
 /**
@@ -874,6 +882,154 @@ void test_iosched_set_ignore_round(struct test_iosched *tios,
 }
 EXPORT_SYMBOL(test_iosched_set_ignore_round);
 
+/*
+ * The IOPS benchmark issues single page requests at random page aligned
+ * offsets of the test range, TEST_IOPS_READ_PERCENT of them reads. It is
+ * run once with no depth limit, letting the driver queue as many requests
+ * as it can (e.g. eMMC command queueing), and once with a single request
+ * in flight, which is what the device sees in legacy mode. The queue depth
+ * sweep repeats it for each depth of test_iops_qd_steps, so the point at
+ * which a device (e.g. UFS) stops scaling with depth shows up.
+ */
+static const u32 test_iops_qd_steps[TEST_IOPS_QD_STEPS] = {
+	1, 2, 4, 8, 16, 32, 0
+};
+
+static char *test_iops_case_str(int testcase)
+{
+	if (!testcase)
+		return "IOPS benchmark queued";
+	if (testcase == 1)
+		return "IOPS benchmark serial";
+	return "IOPS benchmark depth limited";
+}
+
+static int test_iops_prepare(struct test_iosched *tios)
+{
+	u32 nr_pages = tios->sector_range >> (PAGE_SHIFT - 9);
+	int i, ret;
+
+	if (!nr_pages)
+		return -EINVAL;
+
+	for (i = 0; i < TEST_IOPS_NR_REQS; i++) {
+		u32 sector = tios->start_sector +
+			((prandom_u32() % nr_pages) << (PAGE_SHIFT - 9));
+		int dir = prandom_u32() % 100 < TEST_IOPS_READ_PERCENT ?
+			READ : WRITE;
+
+		ret = test_iosched_add_wr_rd_test_req(tios, 0, dir, sector, 1,
+				TEST_NO_PATTERN, NULL);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int test_iops_run_round(struct test_iosched *tios, u32 depth,
+		unsigned long *iops)
+{
+	struct test_info t_info;
+	s64 usecs;
+	int ret;
+
+	memset(&t_info, 0, sizeof(t_info));
+	t_info.testcase = depth;
+	t_info.get_test_case_str_fn = test_iops_case_str;
+	t_info.prepare_test_fn = test_iops_prepare;
+
+	tios->queue_depth = depth;
+	ret = test_iosched_start_test(tios, &t_info);
+	tios->queue_depth = 0;
+	if (ret)
+		return ret;
+
+	usecs = ktime_to_us(t_info.test_duration);
+	*iops = usecs > 0 ?
+		div64_s64((s64)TEST_IOPS_NR_REQS * USEC_PER_SEC, usecs) : 0;
+	pr_info("%s: %s: depth %u: %lu IOPS", __func__,
+		test_iops_case_str(depth), depth, *iops);
+
+	return 0;
+}
+
+static ssize_t test_iops_benchmark_write(struct file *file,
+		const char __user *buf, size_t count, loff_t *ppos)
+{
+	struct test_iosched *tios = file->private_data;
+	int ret;
+
+	tios->iops[0] = tios->iops[1] = 0;
+
+	ret = test_iops_run_round(tios, 0, &tios->iops[0]);
+	if (!ret) {
+		/* let the FS requests postponed by the test go first */
+		msleep(1000);
+		ret = test_iops_run_round(tios, 1, &tios->iops[1]);
+	}
+
+	return ret ? ret : count;
+}
+
+static ssize_t test_iops_benchmark_read(struct file *file,
+		char __user *buf, size_t count, loff_t *ppos)
+{
+	struct test_iosched *tios = file->private_data;
+	char str[64];
+	int len;
+
+	len = snprintf(str, sizeof(str), "queued %lu IOPS\nserial %lu IOPS\n",
+		tios->iops[0], tios->iops[1]);
+
+	return simple_read_from_buffer(buf, count, ppos, str, len);
+}
+
+static const struct file_operations test_iops_benchmark_ops = {
+	.open = simple_open,
+	.write = test_iops_benchmark_write,
+	.read = test_iops_benchmark_read,
+};
+
+static ssize_t test_iops_qd_sweep_write(struct file *file,
+		const char __user *buf, size_t count, loff_t *ppos)
+{
+	struct test_iosched *tios = file->private_data;
+	int i, ret = 0;
+
+	memset(tios->qd_iops, 0, sizeof(tios->qd_iops));
+
+	for (i = 0; i < TEST_IOPS_QD_STEPS && !ret; i++) {
+		if (i)
+			msleep(1000);
+		ret = test_iops_run_round(tios, test_iops_qd_steps[i],
+				&tios->qd_iops[i]);
+	}
+
+	return ret ? ret : count;
+}
+
+static ssize_t test_iops_qd_sweep_read(struct file *file,
+		char __user *buf, size_t count, loff_t *ppos)
+{
+	struct test_iosched *tios = file->private_data;
+	char str[TEST_IOPS_QD_STEPS * 32];
+	int i, len = 0;
+
+	for (i = 0; i < TEST_IOPS_QD_STEPS; i++)
+		len += scnprintf(str + len, sizeof(str) - len,
+				"depth %u iops %lu\n",
+				test_iops_qd_steps[i], tios->qd_iops[i]);
+
+	return simple_read_from_buffer(buf, count, ppos, str, len);
+}
+
+static const struct file_operations test_iops_qd_sweep_ops = {
+	.open = simple_open,
+	.write = test_iops_qd_sweep_write,
+	.read = test_iops_qd_sweep_read,
+};
+
 static int test_debugfs_init(struct test_iosched *tios)
 {
 	char name[2*BDEVNAME_SIZE];
@@ -921,6 +1077,32 @@ static int test_debugfs_init(struct test_iosched *tios)
 	if (!tios->debug.sector_range)
 		goto err;
 
+	tios->debug.queue_depth = debugfs_create_u32(
+						"queue_depth",
+						S_IRUGO | S_IWUGO,
+						tios->debug.debug_utils_root,
+						&tios->queue_depth);
+	if (!tios->debug.queue_depth)
+		goto err;
+
+	tios->debug.iops_benchmark = debugfs_create_file(
+						"iops_benchmark",
+						S_IRUGO | S_IWUGO,
+						tios->debug.debug_tests_root,
+						tios,
+						&test_iops_benchmark_ops);
+	if (!tios->debug.iops_benchmark)
+		goto err;
+
+	tios->debug.iops_qd_sweep = debugfs_create_file(
+						"iops_qd_sweep",
+						S_IRUGO | S_IWUGO,
+						tios->debug.debug_tests_root,
+						tios,
+						&test_iops_qd_sweep_ops);
+	if (!tios->debug.iops_qd_sweep)
+		goto err;
+
 	return 0;
 
 err:
@@ -982,6 +1164,17 @@ static int test_dispatch_from(struct request_queue *q,
 		goto err;
 
 	spin_lock_irqsave(&tios->lock, flags);
+	if (tios->queue_depth && queue == &tios->test_queue) {
+		unsigned int in_flight = 0;
+
+		list_for_each_entry(test_rq, &tios->dispatched_queue, queuelist)
+			if (!test_rq->req_completed)
+				in_flight++;
+		if (in_flight >= tios->queue_depth) {
+			spin_unlock_irqrestore(&tios->lock, flags);
+			goto err;
+		}
+	}
 	if (!list_empty(queue)) {
 		test_rq = list_entry(queue->next, struct test_request,
 				queuelist);
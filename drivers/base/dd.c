@@ -24,6 +24,8 @@
 #include <linux/wait.h>
 #include <linux/async.h>
 #include <linux/pm_runtime.h>
+#include <linux/of.h>
+#include <linux/of_platform.h>
 #include <linux/pinctrl/devinfo.h>
 
 #include "base.h"
@@ -43,7 +45,9 @@
  * list.  A driver returning -EPROBE_DEFER causes the device to be added to the
  * pending list.  A successful driver probe will trigger moving all devices
  * from the pending to the active list so that the workqueue will eventually
- * retry them.
+ * retry them. Devices with a device tree supplier (regulator, clock or GPIO
+ * provider) that is itself still deferred are left pending until a full
+ * retry cycle, as their probe is bound to defer again.
  *
  * The deferred_probe_mutex must be held any time the deferred_probe_*_list
  * of the (struct device*)->p->deferred_probe pointers are manipulated
@@ -129,13 +133,117 @@ void driver_deferred_probe_del(struct device *dev)
 	mutex_unlock(&deferred_probe_mutex);
 }
 
+#ifdef CONFIG_OF
+/* Caller holds deferred_probe_mutex, drops the reference on @np */
+static bool deferred_probe_node_deferred(struct device *dev,
+					 struct device_node *np)
+{
+	struct platform_device *pdev;
+	bool deferred;
+
+	if (!np)
+		return false;
+
+	pdev = of_find_device_by_node(np);
+	of_node_put(np);
+	if (!pdev)
+		return false;
+
+	deferred = &pdev->dev != dev && pdev->dev.p &&
+		   !list_empty(&pdev->dev.p->deferred_probe);
+	put_device(&pdev->dev);
+
+	return deferred;
+}
+
+static bool deferred_probe_prop_ends_with(struct property *prop,
+					  const char *suffix)
+{
+	size_t len = strlen(prop->name), slen = strlen(suffix);
+
+	return len > slen && !strcmp(prop->name + len - slen, suffix);
+}
+
+/*
+ * deferred_probe_supplier_deferred() - Check the suppliers of a device
+ *
+ * Returns true if one of the regulators, clocks or GPIOs that @dev refers
+ * to in the device tree is provided by a device that is itself waiting
+ * for a deferred probe. Suppliers without a platform device are treated
+ * as available.
+ */
+static bool deferred_probe_supplier_deferred(struct device *dev)
+{
+	struct device_node *np = dev->of_node;
+	struct of_phandle_args args;
+	struct property *prop;
+	const char *cells;
+	int i;
+
+	if (!np)
+		return false;
+
+	for_each_property_of_node(np, prop) {
+		if (deferred_probe_prop_ends_with(prop, "-supply")) {
+			if (deferred_probe_node_deferred(dev,
+					of_parse_phandle(np, prop->name, 0)))
+				return true;
+			continue;
+		}
+
+		if (!strcmp(prop->name, "clocks"))
+			cells = "#clock-cells";
+		else if (!strcmp(prop->name, "gpios") ||
+			 deferred_probe_prop_ends_with(prop, "-gpios") ||
+			 deferred_probe_prop_ends_with(prop, "-gpio"))
+			cells = "#gpio-cells";
+		else
+			continue;
+
+		for (i = 0; !of_parse_phandle_with_args(np, prop->name, cells,
+							i, &args); i++)
+			if (deferred_probe_node_deferred(dev, args.np))
+				return true;
+	}
+
+	return false;
+}
+#else
+static inline bool deferred_probe_supplier_deferred(struct device *dev)
+{
+	return false;
+}
+#endif
+
+/* Caller holds deferred_probe_mutex */
+static void __driver_deferred_probe_trigger(bool all)
+{
+	struct device_private *private, *next;
+
+	atomic_inc(&deferred_trigger_count);
+	if (all) {
+		list_splice_tail_init(&deferred_probe_pending_list,
+				      &deferred_probe_active_list);
+		return;
+	}
+
+	list_for_each_entry_safe(private, next, &deferred_probe_pending_list,
+				 deferred_probe) {
+		if (deferred_probe_supplier_deferred(private->device))
+			continue;
+		list_move_tail(&private->deferred_probe,
+			       &deferred_probe_active_list);
+	}
+}
+
 static bool driver_deferred_probe_enable = false;
 /**
  * driver_deferred_probe_trigger() - Kick off re-probing deferred devices
  *
- * This functions moves all devices from the pending list to the active
- * list and schedules the deferred probe workqueue to process them.  It
- * should be called anytime a driver is successfully bound to a device.
+ * This functions moves the devices whose suppliers are not deferred
+ * themselves from the pending list to the active list and schedules the
+ * deferred probe workqueue to process them.  It should be called anytime a
+ * driver is successfully bound to a device.
  *
  * Note, there is a race condition in multi-threaded probe. In the case where
  * more than one device is probing at the same time, it is possible for one
@@ -154,14 +262,13 @@ static void driver_deferred_probe_trigger(void)
 		return;
 
 	/*
-	 * A successful probe means that all the devices in the pending list
-	 * should be triggered to be reprobed.  Move all the deferred devices
-	 * into the active list so they can be retried by the workqueue
+	 * A successful probe means that the devices in the pending list
+	 * should be triggered to be reprobed.  Move the deferred devices
+	 * whose suppliers are not deferred themselves into the active list
+	 * so they can be retried by the workqueue
 	 */
 	mutex_lock(&deferred_probe_mutex);
-	atomic_inc(&deferred_trigger_count);
-	list_splice_tail_init(&deferred_probe_pending_list,
-			      &deferred_probe_active_list);
+	__driver_deferred_probe_trigger(false);
 	mutex_unlock(&deferred_probe_mutex);
 
 	/*
@@ -174,7 +281,12 @@ static void driver_deferred_probe_trigger(void)
 static void enable_trigger_defer_cycle(void)
 {
 	driver_deferred_probe_enable = true;
-	driver_deferred_probe_trigger();
+
+	/* Retry every pending device once per cycle, whatever its suppliers */
+	mutex_lock(&deferred_probe_mutex);
+	__driver_deferred_probe_trigger(true);
+	mutex_unlock(&deferred_probe_mutex);
+	queue_work(deferred_wq, &deferred_probe_work);
 	/*
 	 * Sort as many dependencies as possible before the next initcall
 	 * level
@@ -370,6 +482,11 @@ done:
 	return ret;
 }
 
+bool driver_allows_async_probing(struct device_driver *drv)
+{
+	return drv->probe_type == PROBE_PREFER_ASYNCHRONOUS;
+}
+
 /**
  * driver_probe_done
  * Determine if the probe sequence is finished or not.
@@ -33,6 +33,8 @@
 #include <linux/cpuidle.h>
 #include <linux/timer.h>
 #include <linux/wakeup_reason.h>
+#include <linux/seq_file.h>
+#include <linux/debugfs.h>
 
 #include "../base.h"
 #include "power.h"
@@ -756,6 +758,8 @@ static int device_resume(struct device *dev, pm_message_t state, bool async)
 	TRACE_DEVICE(dev);
 	TRACE_RESUME(0);
 
+	dev->power.resume_start = ktime_get();
+
 	if (dev->power.syscore)
 		goto Complete;
 
@@ -766,6 +770,7 @@ static int device_resume(struct device *dev, pm_message_t state, bool async)
 	}
 
 	dpm_wait(dev->parent, async);
+	dev->power.resume_start = ktime_get();
 	dpm_watchdog_set(&wd, dev);
 	device_lock(dev);
 
@@ -828,6 +833,7 @@ static int device_resume(struct device *dev, pm_message_t state, bool async)
 	dpm_watchdog_clear(&wd);
 
  Complete:
+	dev->power.resume_end = ktime_get();
 	complete_all(&dev->power.completion);
 
 	TRACE_RESUME(error);
@@ -870,6 +876,150 @@ static void dpm_drv_timeout(unsigned long data)
 	BUG();
 }
 
+#define DPM_REPORT_SLOWEST	10
+#define DPM_REPORT_PATH		16
+
+struct dpm_resume_rec {
+	char name[32];
+	s64 start_us;
+	s64 end_us;
+	bool async;
+};
+
+/* Timing of the last dpm_resume(), protected by dpm_list_mtx */
+static struct dpm_resume_report {
+	s64 total_us;
+	s64 sync_us;
+	unsigned int nr_devs;
+	unsigned int nr_async;
+	unsigned int nr_slowest;
+	unsigned int nr_path;
+	struct dpm_resume_rec slowest[DPM_REPORT_SLOWEST];
+	struct dpm_resume_rec path[DPM_REPORT_PATH];
+} dpm_resume_report;
+
+static void dpm_resume_rec_fill(struct dpm_resume_rec *rec,
+				struct device *dev, ktime_t starttime)
+{
+	strlcpy(rec->name, dev_name(dev), sizeof(rec->name));
+	rec->start_us = ktime_us_delta(dev->power.resume_start, starttime);
+	rec->end_us = ktime_us_delta(dev->power.resume_end, starttime);
+	rec->async = is_async(dev);
+}
+
+/*
+ * Record the slowest resume callbacks and the critical path, i.e. the
+ * device that finished last and the chain of parents it had to wait for.
+ * Caller holds dpm_list_mtx, with every resumed device on
+ * dpm_prepared_list.
+ */
+static void dpm_resume_record(ktime_t starttime)
+{
+	struct dpm_resume_report *rep = &dpm_resume_report;
+	struct device *dev, *last = NULL;
+	unsigned int i;
+	s64 dur;
+
+	memset(rep, 0, sizeof(*rep));
+	rep->total_us = ktime_us_delta(ktime_get(), starttime);
+
+	list_for_each_entry(dev, &dpm_prepared_list, power.entry) {
+		if (ktime_before(dev->power.resume_start, starttime))
+			continue;
+
+		dur = ktime_us_delta(dev->power.resume_end,
+				     dev->power.resume_start);
+		rep->nr_devs++;
+		if (is_async(dev))
+			rep->nr_async++;
+		else
+			rep->sync_us += dur;
+
+		if (!last || ktime_after(dev->power.resume_end,
+					 last->power.resume_end))
+			last = dev;
+
+		/* insertion into the slowest list, longest first */
+		for (i = rep->nr_slowest; i > 0; i--) {
+			struct dpm_resume_rec *prev = &rep->slowest[i - 1];
+
+			if (prev->end_us - prev->start_us >= dur)
+				break;
+			if (i < DPM_REPORT_SLOWEST)
+				rep->slowest[i] = *prev;
+		}
+		if (i < DPM_REPORT_SLOWEST) {
+			dpm_resume_rec_fill(&rep->slowest[i], dev, starttime);
+			if (rep->nr_slowest < DPM_REPORT_SLOWEST)
+				rep->nr_slowest++;
+		}
+	}
+
+	if (rep->nr_slowest)
+		log_suspend_slowest_dev(true, rep->slowest[0].name,
+					rep->slowest[0].end_us -
+					rep->slowest[0].start_us);
+
+	for (dev = last; dev && rep->nr_path < DPM_REPORT_PATH;
+	     dev = dev->parent) {
+		if (ktime_before(dev->power.resume_start, starttime))
+			break;
+		dpm_resume_rec_fill(&rep->path[rep->nr_path++], dev,
+				    starttime);
+	}
+}
+
+static int dpm_resume_report_show(struct seq_file *m, void *unused)
+{
+	struct dpm_resume_report *rep = &dpm_resume_report;
+	struct dpm_resume_rec *rec;
+	unsigned int i;
+
+	mutex_lock(&dpm_list_mtx);
+	seq_printf(m, "total_us %lld sync_us %lld devices %u async %u\n",
+		   rep->total_us, rep->sync_us, rep->nr_devs, rep->nr_async);
+
+	seq_puts(m, "\nslowest:\n");
+	for (i = 0; i < rep->nr_slowest; i++) {
+		rec = &rep->slowest[i];
+		seq_printf(m, "%-32s %8lld us start %8lld %s\n", rec->name,
+			   rec->end_us - rec->start_us, rec->start_us,
+			   rec->async ? "async" : "sync");
+	}
+
+	seq_puts(m, "\ncritical path, last to finish first:\n");
+	for (i = 0; i < rep->nr_path; i++) {
+		rec = &rep->path[i];
+		seq_printf(m, "%-32s start %8lld end %8lld %s\n", rec->name,
+			   rec->start_us, rec->end_us,
+			   rec->async ? "async" : "sync");
+	}
+	mutex_unlock(&dpm_list_mtx);
+
+	return 0;
+}
+
+static int dpm_resume_report_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dpm_resume_report_show, NULL);
+}
+
+static const struct file_operations dpm_resume_report_fops = {
+	.owner = THIS_MODULE,
+	.open = dpm_resume_report_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int __init dpm_resume_report_init(void)
+{
+	debugfs_create_file("resume_timing", S_IRUGO, NULL, NULL,
+			    &dpm_resume_report_fops);
+	return 0;
+}
+postcore_initcall(dpm_resume_report_init);
+
 /**
  * dpm_resume - Execute "resume" callbacks for non-sysdev devices.
  * @state: PM transition of the system being carried out.
@@ -923,6 +1073,10 @@ void dpm_resume(pm_message_t state)
 	async_synchronize_full();
 	dpm_show_time(starttime, state, NULL);
 
+	mutex_lock(&dpm_list_mtx);
+	dpm_resume_record(starttime);
+	mutex_unlock(&dpm_list_mtx);
+
 	cpufreq_resume();
 	trace_suspend_resume(TPS("dpm_resume"), state.event, false);
 }
@@ -1382,6 +1536,7 @@ static int __device_suspend(struct device *dev, pm_message_t state, bool async)
 	struct timer_list timer;
 	struct dpm_drv_wd_data data;
 	char suspend_abort[MAX_SUSPEND_ABORT_LEN];
+	ktime_t calltime;
 	DECLARE_DPM_WATCHDOG_ON_STACK(wd);
 
 	dpm_wait_for_children(dev, async);
@@ -1408,7 +1563,8 @@ static int __device_suspend(struct device *dev, pm_message_t state, bool async)
 
 	if (dev->power.syscore)
 		goto Complete;
-	
+
+	calltime = ktime_get();
 	data.dev = dev;
 	data.tsk = get_current();
 	init_timer_on_stack(&timer);
@@ -1498,6 +1654,7 @@ static int __device_suspend(struct device *dev, pm_message_t state, bool async)
 
 	del_timer_sync(&timer);
 	destroy_timer_on_stack(&timer);
+	dpm_note_suspend_time(dev, calltime);
 
  Complete:
 	complete_all(&dev->power.completion);
@@ -1507,6 +1664,26 @@ static int __device_suspend(struct device *dev, pm_message_t state, bool async)
 	return error;
 }
 
+/* Slowest device of the current dpm_suspend(), for the suspend history */
+static DEFINE_SPINLOCK(dpm_slowest_lock);
+static struct {
+	char name[32];
+	s64 usecs;
+} dpm_slowest_suspend;
+
+static void dpm_note_suspend_time(struct device *dev, ktime_t calltime)
+{
+	s64 usecs = ktime_us_delta(ktime_get(), calltime);
+
+	spin_lock(&dpm_slowest_lock);
+	if (usecs > dpm_slowest_suspend.usecs) {
+		strlcpy(dpm_slowest_suspend.name, dev_name(dev),
+			sizeof(dpm_slowest_suspend.name));
+		dpm_slowest_suspend.usecs = usecs;
+	}
+	spin_unlock(&dpm_slowest_lock);
+}
+
 static void async_suspend(void *data, async_cookie_t cookie)
 {
 	struct device *dev = (struct device *)data;
@@ -1551,6 +1728,7 @@ int dpm_suspend(pm_message_t state)
 	mutex_lock(&dpm_list_mtx);
 	pm_transition = state;
 	async_error = 0;
+	memset(&dpm_slowest_suspend, 0, sizeof(dpm_slowest_suspend));
 	while (!list_empty(&dpm_prepared_list)) {
 		struct device *dev = to_device(dpm_prepared_list.prev);
 
@@ -1581,6 +1759,9 @@ int dpm_suspend(pm_message_t state)
 		dpm_save_failed_step(SUSPEND_SUSPEND);
 	} else
 		dpm_show_time(starttime, state, NULL);
+	if (dpm_slowest_suspend.name[0])
+		log_suspend_slowest_dev(false, dpm_slowest_suspend.name,
+					dpm_slowest_suspend.usecs);
 	trace_suspend_resume(TPS("dpm_suspend"), state.event, false);
 	return error;
 }
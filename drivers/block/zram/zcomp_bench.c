@@ -0,0 +1,245 @@
+/*
+ * Compression backend benchmark for zram
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+
+/*
+ * Runs one of the zcomp backends zram was built with over a fixed page
+ * corpus, on demand from debugfs:
+ *
+ *	echo "<alg> <iters>" > zram_bench/run
+ *	cat zram_bench/run
+ *
+ * Each iteration compresses and then decompresses every corpus page
+ * through the same zcomp_compress()/zcomp_decompress() calls zram uses on
+ * its write and read paths, and checks the round trip. The corpus is
+ * generated from a fixed seed, so runs on different kernels see the same
+ * data: a mix of zero runs, small integers, repeated text and random
+ * bytes, 64 bytes at a time.
+ */
+
+#define KMSG_COMPONENT "zram"
+#define pr_fmt(fmt) KMSG_COMPONENT ": " fmt
+
+#include <linux/kernel.h>
+#include <linux/debugfs.h>
+#include <linux/err.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
+#include <linux/random.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
+#include "zcomp.h"
+#include "zcomp_bench.h"
+
+#define ZCOMP_BENCH_PAGES	64
+#define ZCOMP_BENCH_MAX_ITERS	1024
+#define ZCOMP_BENCH_CHUNK	64
+#define ZCOMP_BENCH_SEED	0x7a72616dULL
+#define ZCOMP_BENCH_RESULT_BUF	512
+
+static struct dentry *zcomp_bench_dent;
+static DEFINE_MUTEX(zcomp_bench_mutex);
+static char zcomp_bench_result[ZCOMP_BENCH_RESULT_BUF];
+
+static const char zcomp_bench_text[ZCOMP_BENCH_CHUNK] =
+	"com.android.systemui/.statusbar.phone.PhoneStatusBar onResume()";
+
+static void zcomp_bench_fill(unsigned char *page, struct rnd_state *rnd)
+{
+	unsigned int off, i;
+	u32 *word;
+
+	for (off = 0; off < PAGE_SIZE; off += ZCOMP_BENCH_CHUNK) {
+		switch (prandom_u32_state(rnd) % 10) {
+		case 0 ... 3:
+			memset(page + off, 0, ZCOMP_BENCH_CHUNK);
+			break;
+		case 4 ... 6:
+			word = (u32 *)(page + off);
+			for (i = 0; i < ZCOMP_BENCH_CHUNK / sizeof(u32); i++)
+				word[i] = prandom_u32_state(rnd) & 0xff;
+			break;
+		case 7 ... 8:
+			memcpy(page + off, zcomp_bench_text,
+			       ZCOMP_BENCH_CHUNK);
+			break;
+		default:
+			prandom_bytes_state(rnd, page + off,
+					    ZCOMP_BENCH_CHUNK);
+			break;
+		}
+	}
+}
+
+static int zcomp_bench_u32_cmp(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int zcomp_bench_exec(const char *alg, unsigned int iters)
+{
+	struct zcomp *comp;
+	struct zcomp_strm *zstrm = NULL;
+	struct rnd_state rnd;
+	unsigned char *corpus = NULL, *dst = NULL;
+	u32 *comp_lat = NULL, *decomp_lat = NULL;
+	u64 comp_ns = 0, decomp_ns = 0, comp_bytes = 0, total;
+	unsigned int nr = ZCOMP_BENCH_PAGES * iters, i, n = 0;
+	size_t clen;
+	ktime_t start;
+	int ret;
+
+	comp = zcomp_create_unpooled(alg);
+	if (IS_ERR(comp)) {
+		ret = PTR_ERR(comp);
+		goto out_result;
+	}
+
+	ret = -ENOMEM;
+	zstrm = zcomp_strm_alloc(comp);
+	corpus = vmalloc(ZCOMP_BENCH_PAGES * PAGE_SIZE);
+	dst = kmalloc(PAGE_SIZE, GFP_KERNEL);
+	comp_lat = vmalloc(nr * sizeof(*comp_lat));
+	decomp_lat = vmalloc(nr * sizeof(*decomp_lat));
+	if (!zstrm || !corpus || !dst || !comp_lat || !decomp_lat)
+		goto out;
+
+	prandom_seed_state(&rnd, ZCOMP_BENCH_SEED);
+	for (i = 0; i < ZCOMP_BENCH_PAGES; i++)
+		zcomp_bench_fill(corpus + i * PAGE_SIZE, &rnd);
+
+	while (iters--) {
+		for (i = 0; i < ZCOMP_BENCH_PAGES; i++, n++) {
+			unsigned char *src = corpus + i * PAGE_SIZE;
+
+			start = ktime_get();
+			ret = zcomp_compress(comp, zstrm, src, &clen);
+			comp_lat[n] = ktime_to_ns(ktime_sub(ktime_get(),
+							    start));
+			if (ret)
+				goto out;
+
+			start = ktime_get();
+			ret = zcomp_decompress(comp, zstrm->buffer, clen, dst);
+			decomp_lat[n] = ktime_to_ns(ktime_sub(ktime_get(),
+							      start));
+			if (ret)
+				goto out;
+
+			if (memcmp(src, dst, PAGE_SIZE)) {
+				ret = -EILSEQ;
+				goto out;
+			}
+
+			comp_ns += comp_lat[n];
+			decomp_ns += decomp_lat[n];
+			comp_bytes += min_t(size_t, clen, PAGE_SIZE);
+		}
+	}
+
+	sort(comp_lat, nr, sizeof(*comp_lat), zcomp_bench_u32_cmp, NULL);
+	sort(decomp_lat, nr, sizeof(*decomp_lat), zcomp_bench_u32_cmp, NULL);
+
+	total = (u64)nr * PAGE_SIZE;
+	scnprintf(zcomp_bench_result, sizeof(zcomp_bench_result),
+		"alg %s pages %u iters %u ratio_pct %llu\n"
+		"comp_kBps %llu comp_p50_ns %u comp_p99_ns %u comp_max_ns %u\n"
+		"decomp_kBps %llu decomp_p50_ns %u decomp_p99_ns %u decomp_max_ns %u\n",
+		alg, ZCOMP_BENCH_PAGES, nr / ZCOMP_BENCH_PAGES,
+		div64_u64(comp_bytes * 100, total),
+		div64_u64(total * USEC_PER_SEC, max_t(u64, comp_ns, 1)),
+		comp_lat[nr / 2], comp_lat[nr * 99 / 100], comp_lat[nr - 1],
+		div64_u64(total * USEC_PER_SEC, max_t(u64, decomp_ns, 1)),
+		decomp_lat[nr / 2], decomp_lat[nr * 99 / 100],
+		decomp_lat[nr - 1]);
+out:
+	vfree(decomp_lat);
+	vfree(comp_lat);
+	kfree(dst);
+	vfree(corpus);
+	if (zstrm)
+		zcomp_strm_free(comp, zstrm);
+	zcomp_destroy(comp);
+out_result:
+	if (ret)
+		scnprintf(zcomp_bench_result, sizeof(zcomp_bench_result),
+			  "alg %s error %d\n", alg, ret);
+
+	return ret;
+}
+
+static ssize_t zcomp_bench_run_write(struct file *file,
+		const char __user *ubuf, size_t count, loff_t *ppos)
+{
+	char buf[64], alg[32];
+	unsigned int iters;
+	int ret;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sscanf(buf, "%31s %u", alg, &iters) != 2)
+		return -EINVAL;
+	if (!iters || iters > ZCOMP_BENCH_MAX_ITERS)
+		return -EINVAL;
+
+	mutex_lock(&zcomp_bench_mutex);
+	ret = zcomp_bench_exec(alg, iters);
+	mutex_unlock(&zcomp_bench_mutex);
+
+	return ret ? ret : count;
+}
+
+static ssize_t zcomp_bench_run_read(struct file *file, char __user *ubuf,
+		size_t count, loff_t *ppos)
+{
+	ssize_t ret;
+
+	mutex_lock(&zcomp_bench_mutex);
+	ret = simple_read_from_buffer(ubuf, count, ppos, zcomp_bench_result,
+				      strlen(zcomp_bench_result));
+	mutex_unlock(&zcomp_bench_mutex);
+
+	return ret;
+}
+
+static const struct file_operations zcomp_bench_run_ops = {
+	.open = simple_open,
+	.read = zcomp_bench_run_read,
+	.write = zcomp_bench_run_write,
+};
+
+void zcomp_bench_init(void)
+{
+	zcomp_bench_dent = debugfs_create_dir("zram_bench", NULL);
+	if (IS_ERR_OR_NULL(zcomp_bench_dent)) {
+		pr_warn("Unable to create the benchmark debugfs directory\n");
+		zcomp_bench_dent = NULL;
+		return;
+	}
+
+	if (!debugfs_create_file("run", S_IRUSR | S_IWUSR, zcomp_bench_dent,
+				 NULL, &zcomp_bench_run_ops)) {
+		debugfs_remove_recursive(zcomp_bench_dent);
+		zcomp_bench_dent = NULL;
+	}
+}
+
+void zcomp_bench_exit(void)
+{
+	debugfs_remove_recursive(zcomp_bench_dent);
+}
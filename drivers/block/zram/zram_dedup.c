@@ -0,0 +1,168 @@
+/*
+ * Same content page deduplication for zram
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+
+#define KMSG_COMPONENT "zram"
+#define pr_fmt(fmt) KMSG_COMPONENT ": " fmt
+
+#include <linux/kernel.h>
+#include <linux/jhash.h>
+#include <linux/log2.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+
+#include "zram_drv.h"
+
+/*
+ * Every object stored while dedup is enabled is entered here, keyed by a
+ * checksum of its uncompressed contents. Slots sharing an object all point
+ * at the same zsmalloc handle and the entry counts them; the object is freed
+ * when the last one goes away.
+ */
+struct zram_dedup_entry {
+	struct hlist_node node;
+	unsigned long handle;
+	u32 checksum;
+	u32 len;
+	unsigned long refcount;
+};
+
+/* Stored pages per hash bucket, on average, with a full device. */
+#define ZRAM_DEDUP_PAGES_PER_BUCKET	16
+
+u32 zram_dedup_checksum(const unsigned char *mem)
+{
+	return jhash2((const u32 *)mem, PAGE_SIZE / sizeof(u32), 0);
+}
+
+static struct zram_hash *zram_dedup_bucket(struct zram_meta *meta,
+		u32 checksum)
+{
+	return &meta->hash[checksum & (meta->hash_size - 1)];
+}
+
+/*
+ * Look for an object with the given checksum whose stored bytes equal
+ * @src and take a reference on it. @src holds what would be stored for
+ * the new page, so equal contents mean an equal page.
+ */
+unsigned long zram_dedup_find(struct zram *zram, u32 checksum,
+		const unsigned char *src, size_t len)
+{
+	struct zram_meta *meta = zram->meta;
+	struct zram_hash *hash = zram_dedup_bucket(meta, checksum);
+	struct zram_dedup_entry *entry;
+	unsigned long handle = 0;
+
+	spin_lock(&hash->lock);
+	hlist_for_each_entry(entry, &hash->head, node) {
+		unsigned char *cmem;
+		bool match;
+
+		if (entry->checksum != checksum || entry->len != len)
+			continue;
+
+		cmem = zs_map_object(meta->mem_pool, entry->handle, ZS_MM_RO);
+		match = !memcmp(cmem, src, len);
+		zs_unmap_object(meta->mem_pool, entry->handle);
+		if (match) {
+			entry->refcount++;
+			handle = entry->handle;
+			break;
+		}
+	}
+	spin_unlock(&hash->lock);
+
+	return handle;
+}
+
+bool zram_dedup_insert(struct zram *zram, u32 checksum,
+		unsigned long handle, size_t len)
+{
+	struct zram_hash *hash = zram_dedup_bucket(zram->meta, checksum);
+	struct zram_dedup_entry *entry;
+
+	entry = kmalloc(sizeof(*entry), GFP_NOIO | __GFP_NOWARN);
+	if (!entry)
+		return false;
+
+	entry->handle = handle;
+	entry->checksum = checksum;
+	entry->len = len;
+	entry->refcount = 1;
+
+	spin_lock(&hash->lock);
+	hlist_add_head(&entry->node, &hash->head);
+	spin_unlock(&hash->lock);
+
+	atomic64_add(sizeof(*entry), &zram->stats.meta_data_size);
+	return true;
+}
+
+/*
+ * Drop a slot's reference on a shared object. Returns true if that was the
+ * last one, in which case the entry is gone and the caller frees the object.
+ */
+bool zram_dedup_put(struct zram *zram, u32 checksum, unsigned long handle)
+{
+	struct zram_hash *hash = zram_dedup_bucket(zram->meta, checksum);
+	struct zram_dedup_entry *entry;
+	bool last = false;
+
+	spin_lock(&hash->lock);
+	hlist_for_each_entry(entry, &hash->head, node) {
+		if (entry->handle != handle)
+			continue;
+
+		if (!--entry->refcount) {
+			hlist_del(&entry->node);
+			last = true;
+		}
+		break;
+	}
+	spin_unlock(&hash->lock);
+
+	if (WARN_ON_ONCE(!entry))
+		return true;
+
+	if (last) {
+		kfree(entry);
+		atomic64_sub(sizeof(*entry), &zram->stats.meta_data_size);
+	}
+
+	return last;
+}
+
+int zram_dedup_init(struct zram_meta *meta, size_t num_pages)
+{
+	size_t i;
+
+	meta->hash_size = num_pages / ZRAM_DEDUP_PAGES_PER_BUCKET;
+	meta->hash_size = meta->hash_size ?
+		rounddown_pow_of_two(meta->hash_size) : 1;
+	meta->hash = vzalloc(meta->hash_size * sizeof(struct zram_hash));
+	if (!meta->hash) {
+		pr_err("Error allocating zram dedup hash\n");
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < meta->hash_size; i++) {
+		spin_lock_init(&meta->hash[i].lock);
+		INIT_HLIST_HEAD(&meta->hash[i].head);
+	}
+
+	return 0;
+}
+
+void zram_dedup_fini(struct zram_meta *meta)
+{
+	vfree(meta->hash);
+	meta->hash = NULL;
+	meta->hash_size = 0;
+}
@@ -0,0 +1,60 @@
+/*
+ * Same content page deduplication for zram
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+
+#ifndef _ZRAM_DEDUP_H_
+#define _ZRAM_DEDUP_H_
+
+#include <linux/types.h>
+
+struct zram;
+struct zram_meta;
+
+#ifdef CONFIG_ZRAM_DEDUP
+u32 zram_dedup_checksum(const unsigned char *mem);
+unsigned long zram_dedup_find(struct zram *zram, u32 checksum,
+		const unsigned char *src, size_t len);
+bool zram_dedup_insert(struct zram *zram, u32 checksum,
+		unsigned long handle, size_t len);
+bool zram_dedup_put(struct zram *zram, u32 checksum, unsigned long handle);
+
+int zram_dedup_init(struct zram_meta *meta, size_t num_pages);
+void zram_dedup_fini(struct zram_meta *meta);
+#else
+static inline u32 zram_dedup_checksum(const unsigned char *mem)
+{
+	return 0;
+}
+
+static inline unsigned long zram_dedup_find(struct zram *zram, u32 checksum,
+		const unsigned char *src, size_t len)
+{
+	return 0;
+}
+
+static inline bool zram_dedup_insert(struct zram *zram, u32 checksum,
+		unsigned long handle, size_t len)
+{
+	return false;
+}
+
+static inline bool zram_dedup_put(struct zram *zram, u32 checksum,
+		unsigned long handle)
+{
+	return true;
+}
+
+static inline int zram_dedup_init(struct zram_meta *meta, size_t num_pages)
+{
+	return 0;
+}
+
+static inline void zram_dedup_fini(struct zram_meta *meta) {}
+#endif
+
+#endif /* _ZRAM_DEDUP_H_ */
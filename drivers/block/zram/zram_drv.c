@@ -34,8 +34,11 @@
 #include <linux/err.h>
 #include <linux/show_mem_notifier.h>
 #include <linux/ratelimit.h>
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
 
 #include "zram_drv.h"
+#include "zcomp_bench.h"
 
 static int zram_major;
 static struct zram *zram_devices;
@@ -43,6 +46,11 @@ static const char *default_compressor = "lzo";
 
 #define ALLOC_ERROR_LOG_RATE_MS 1000
 
+/* default compact_threshold, in percent of compr_data_size */
+#define ZRAM_COMPACT_THRESHOLD	30
+/* minimum delay between two background compactions */
+#define ZRAM_COMPACT_INTERVAL	(10 * HZ)
+
 static unsigned int num_devices = 4;
 
 #define ZRAM_ATTR_RO(name)						\
@@ -155,17 +163,14 @@ static ssize_t mem_used_total_show(struct device *dev,
 	return scnprintf(buf, PAGE_SIZE, "%llu\n", val << PAGE_SHIFT);
 }
 
+/*
+ * Compression streams are per-cpu now, so there is one per online CPU and
+ * max_comp_streams is kept for compatibility only.
+ */
 static ssize_t max_comp_streams_show(struct device *dev,
 		struct device_attribute *attr, char *buf)
 {
-	int val;
-	struct zram *zram = dev_to_zram(dev);
-
-	down_read(&zram->init_lock);
-	val = zram->max_comp_streams;
-	up_read(&zram->init_lock);
-
-	return scnprintf(buf, PAGE_SIZE, "%d\n", val);
+	return scnprintf(buf, PAGE_SIZE, "%d\n", num_online_cpus());
 }
 
 static ssize_t mem_limit_show(struct device *dev,
@@ -235,33 +240,52 @@ static ssize_t mem_used_max_store(struct device *dev,
 	return len;
 }
 
-static ssize_t max_comp_streams_store(struct device *dev,
+static ssize_t compact_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t len)
 {
-	int num;
 	struct zram *zram = dev_to_zram(dev);
-	int ret;
 
-	ret = kstrtoint(buf, 0, &num);
-	if (ret < 0)
-		return ret;
-	if (num < 1)
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		up_read(&zram->init_lock);
 		return -EINVAL;
-
-	down_write(&zram->init_lock);
-	if (init_done(zram)) {
-		if (!zcomp_set_max_streams(zram->comp, num)) {
-			pr_info("Cannot change max compression streams\n");
-			ret = -EINVAL;
-			goto out;
-		}
 	}
 
-	zram->max_comp_streams = num;
-	ret = len;
-out:
-	up_write(&zram->init_lock);
-	return ret;
+	zram_compact(zram);
+	up_read(&zram->init_lock);
+
+	return len;
+}
+
+static ssize_t compact_threshold_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", zram->compact_threshold);
+}
+
+static ssize_t compact_threshold_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	int err;
+	unsigned int val;
+	struct zram *zram = dev_to_zram(dev);
+
+	err = kstrtouint(buf, 10, &val);
+	if (err)
+		return -EINVAL;
+
+	/* 0 disables background compaction */
+	zram->compact_threshold = val;
+
+	return len;
+}
+
+static ssize_t max_comp_streams_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	return len;
 }
 
 static ssize_t comp_algorithm_show(struct device *dev,
@@ -292,6 +316,73 @@ static ssize_t comp_algorithm_store(struct device *dev,
 	return len;
 }
 
+#ifdef CONFIG_ZRAM_DEDUP
+static ssize_t use_dedup_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	bool val;
+	struct zram *zram = dev_to_zram(dev);
+
+	down_read(&zram->init_lock);
+	val = zram->use_dedup;
+	up_read(&zram->init_lock);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", (int)val);
+}
+
+static ssize_t use_dedup_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	bool val;
+	struct zram *zram = dev_to_zram(dev);
+
+	if (strtobool(buf, &val))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change dedup usage for initialized device\n");
+		return -EBUSY;
+	}
+	zram->use_dedup = val;
+	up_write(&zram->init_lock);
+	return len;
+}
+#endif
+
+static ssize_t recomp_algorithm_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	size_t sz;
+	struct zram *zram = dev_to_zram(dev);
+
+	down_read(&zram->init_lock);
+	sz = zcomp_available_show(zram->recomp_algorithm, buf);
+	up_read(&zram->init_lock);
+
+	return sz;
+}
+
+static ssize_t recomp_algorithm_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change algorithm for initialized device\n");
+		return -EBUSY;
+	}
+	if (sysfs_streq(buf, "none"))
+		zram->recomp_algorithm[0] = '\0';
+	else
+		strlcpy(zram->recomp_algorithm, buf,
+			sizeof(zram->recomp_algorithm));
+	up_write(&zram->init_lock);
+	return len;
+}
+
 static int zram_test_flag(struct zram_meta *meta, u32 index,
 			enum zram_pageflags flag)
 {
@@ -323,6 +414,67 @@ static void zram_set_obj_size(struct zram_meta *meta,
 	meta->table[index].value = (flags << ZRAM_FLAG_SHIFT) | size;
 }
 
+#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+static u32 zram_boot_secs(void)
+{
+	return div_u64(ktime_get_boot_ns(), NSEC_PER_SEC);
+}
+
+static void zram_accessed(struct zram_meta *meta, u32 index)
+{
+	zram_clear_flag(meta, index, ZRAM_IDLE);
+	meta->table[index].ac_time = zram_boot_secs();
+}
+#else
+static void zram_accessed(struct zram_meta *meta, u32 index)
+{
+	zram_clear_flag(meta, index, ZRAM_IDLE);
+}
+#endif
+
+#ifdef CONFIG_ZRAM_DEDUP
+static bool zram_dedup_enabled(struct zram_meta *meta)
+{
+	return meta->hash != NULL;
+}
+
+static u32 zram_get_checksum(struct zram_meta *meta, u32 index)
+{
+	return meta->table[index].checksum;
+}
+
+static void zram_set_checksum(struct zram_meta *meta, u32 index,
+			      u32 checksum)
+{
+	meta->table[index].checksum = checksum;
+}
+
+static void zram_dup_data_add(struct zram *zram, size_t size)
+{
+	atomic64_add(size, &zram->stats.dup_data_size);
+}
+
+static void zram_dup_data_sub(struct zram *zram, size_t size)
+{
+	atomic64_sub(size, &zram->stats.dup_data_size);
+}
+#else
+static bool zram_dedup_enabled(struct zram_meta *meta)
+{
+	return false;
+}
+
+static u32 zram_get_checksum(struct zram_meta *meta, u32 index)
+{
+	return 0;
+}
+
+static void zram_set_checksum(struct zram_meta *meta, u32 index,
+			      u32 checksum) {}
+static void zram_dup_data_add(struct zram *zram, size_t size) {}
+static void zram_dup_data_sub(struct zram *zram, size_t size) {}
+#endif
+
 static inline int is_partial_io(struct bio_vec *bvec)
 {
 	return bvec->bv_len != PAGE_SIZE;
@@ -352,6 +504,7 @@ static inline int valid_io_request(struct zram *zram, struct bio *bio)
 
 static void zram_meta_free(struct zram_meta *meta)
 {
+	zram_dedup_fini(meta);
 	zs_destroy_pool(meta->mem_pool);
 	vfree(meta->table);
 	kfree(meta);
@@ -360,7 +513,7 @@ static void zram_meta_free(struct zram_meta *meta)
 static struct zram_meta *zram_meta_alloc(u64 disksize)
 {
 	size_t num_pages;
-	struct zram_meta *meta = kmalloc(sizeof(*meta), GFP_KERNEL);
+	struct zram_meta *meta = kzalloc(sizeof(*meta), GFP_KERNEL);
 	if (!meta)
 		goto out;
 
@@ -425,12 +578,117 @@ static void handle_zero_page(struct bio_vec *bvec)
 	flush_dcache_page(page);
 }
 
+#ifdef CONFIG_ZRAM_WRITEBACK
+static bool zram_wb_enabled(struct zram *zram)
+{
+	return zram->backing_dev != NULL;
+}
+
+static unsigned long zram_alloc_block(struct zram *zram)
+{
+	unsigned long blk_idx = 1;
+retry:
+	/* skip bit 0 so a zero handle never refers to a block */
+	blk_idx = find_next_zero_bit(zram->bitmap, zram->nr_pages, blk_idx);
+	if (blk_idx == zram->nr_pages)
+		return 0;
+
+	if (test_and_set_bit(blk_idx, zram->bitmap))
+		goto retry;
+
+	atomic64_inc(&zram->stats.bd_count);
+	return blk_idx;
+}
+
+static void zram_free_block(struct zram *zram, unsigned long blk_idx)
+{
+	WARN_ON_ONCE(!test_and_clear_bit(blk_idx, zram->bitmap));
+	atomic64_dec(&zram->stats.bd_count);
+}
+
+struct zram_work {
+	struct work_struct work;
+	struct zram *zram;
+	unsigned long blk_idx;
+	struct page *page;
+	int ret;
+};
+
+static void zram_sync_read(struct work_struct *work)
+{
+	struct zram_work *zw = container_of(work, struct zram_work, work);
+	struct bio *bio;
+
+	bio = bio_alloc(GFP_NOIO, 1);
+	bio->bi_bdev = zw->zram->bdev;
+	bio->bi_iter.bi_sector = zw->blk_idx * (PAGE_SIZE >> SECTOR_SHIFT);
+	bio_add_page(bio, zw->page, PAGE_SIZE, 0);
+	zw->ret = submit_bio_wait(READ_SYNC, bio);
+	bio_put(bio);
+}
+
+/*
+ * Reads are issued from our make_request function, where the block layer
+ * holds back newly submitted bios until we return. Waiting for the read
+ * there would deadlock, so hand it to a worker and wait for that instead.
+ */
+static int zram_read_from_bdev(struct zram *zram, struct page *page,
+			       unsigned long blk_idx)
+{
+	struct zram_work work;
+
+	work.zram = zram;
+	work.blk_idx = blk_idx;
+	work.page = page;
+
+	INIT_WORK_ONSTACK(&work.work, zram_sync_read);
+	queue_work(system_unbound_wq, &work.work);
+	flush_work(&work.work);
+	destroy_work_on_stack(&work.work);
+
+	atomic64_inc(&zram->stats.bd_reads);
+	return work.ret;
+}
+
+static void zram_reset_bdev(struct zram *zram)
+{
+	if (!zram_wb_enabled(zram))
+		return;
+
+	if (zram->old_block_size)
+		set_blocksize(zram->bdev, zram->old_block_size);
+	blkdev_put(zram->bdev, FMODE_READ | FMODE_WRITE | FMODE_EXCL);
+	filp_close(zram->backing_dev, NULL);
+	zram->backing_dev = NULL;
+	zram->bdev = NULL;
+	zram->old_block_size = 0;
+	vfree(zram->bitmap);
+	zram->bitmap = NULL;
+	zram->nr_pages = 0;
+}
+#else
+static inline void zram_reset_bdev(struct zram *zram) {}
+#endif
 
 static void zram_free_page(struct zram *zram, size_t index)
 {
 	struct zram_meta *meta = zram->meta;
 	unsigned long handle = meta->table[index].handle;
 
+	zram_clear_flag(meta, index, ZRAM_IDLE);
+	zram_clear_flag(meta, index, ZRAM_HUGE);
+	zram_clear_flag(meta, index, ZRAM_UNDER_WB);
+
+#ifdef CONFIG_ZRAM_WRITEBACK
+	if (zram_test_flag(meta, index, ZRAM_WB)) {
+		zram_clear_flag(meta, index, ZRAM_WB);
+		zram_free_block(zram, handle);
+		atomic64_dec(&zram->stats.pages_stored);
+		meta->table[index].handle = 0;
+		return;
+	}
+#endif
+
 	if (unlikely(!handle)) {
 		if (zram_test_flag(meta, index, ZRAM_ZERO)) {
 			zram_clear_flag(meta, index, ZRAM_ZERO);
@@ -439,10 +697,26 @@ static void zram_free_page(struct zram *zram, size_t index)
 		return;
 	}
 
+	if (zram_test_flag(meta, index, ZRAM_RECOMP)) {
+		zram_clear_flag(meta, index, ZRAM_RECOMP);
+		atomic64_dec(&zram->stats.recomp_pages);
+	}
+
+	if (zram_test_flag(meta, index, ZRAM_DEDUP)) {
+		zram_clear_flag(meta, index, ZRAM_DEDUP);
+		/* other slots still share the object */
+		if (!zram_dedup_put(zram, zram_get_checksum(meta, index),
+				    handle)) {
+			zram_dup_data_sub(zram, zram_get_obj_size(meta, index));
+			goto out;
+		}
+	}
+
 	zs_free(meta->mem_pool, handle);
 
 	atomic64_sub(zram_get_obj_size(meta, index),
 			&zram->stats.compr_data_size);
+out:
 	atomic64_dec(&zram->stats.pages_stored);
 
 	meta->table[index].handle = 0;
@@ -467,11 +741,32 @@ static int zram_decompress_page(struct zram *zram, char *mem, u32 index)
 		return 0;
 	}
 
+#ifdef CONFIG_ZRAM_WRITEBACK
+	if (zram_test_flag(meta, index, ZRAM_WB)) {
+		struct page *page;
+
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+		page = alloc_page(GFP_NOIO);
+		if (!page)
+			return -ENOMEM;
+		ret = zram_read_from_bdev(zram, page, handle);
+		if (!ret)
+			copy_page(mem, page_address(page));
+		__free_page(page);
+		if (unlikely(ret))
+			pr_err("Backing device read failed! err=%d, page=%u\n",
+				ret, index);
+		return ret;
+	}
+#endif
+
 	cmem = zs_map_object(meta->mem_pool, handle, ZS_MM_RO);
 	if (size == PAGE_SIZE)
 		copy_page(mem, cmem);
 	else
-		ret = zcomp_decompress(zram->comp, cmem, size, mem);
+		ret = zcomp_decompress(zram_test_flag(meta, index, ZRAM_RECOMP) ?
+				       zram->recomp : zram->comp,
+				       cmem, size, mem);
 	zs_unmap_object(meta->mem_pool, handle);
 	bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
 
@@ -500,13 +795,15 @@ static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
 		handle_zero_page(bvec);
 		return 0;
 	}
+	zram_accessed(meta, index);
 	bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
 
 	if (is_partial_io(bvec))
 		
 		uncmem = kmalloc(PAGE_SIZE, GFP_NOIO);
 
-	user_mem = kmap_atomic(page);
+	/* not kmap_atomic: pages on the backing device are read in sleeping */
+	user_mem = kmap(page);
 	if (!is_partial_io(bvec))
 		uncmem = user_mem;
 
@@ -528,7 +825,7 @@ static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
 	flush_dcache_page(page);
 	ret = 0;
 out_cleanup:
-	kunmap_atomic(user_mem);
+	kunmap(page);
 	if (is_partial_io(bvec))
 		kfree(uncmem);
 	return ret;
@@ -549,6 +846,48 @@ static inline void update_used_max(struct zram *zram,
 	} while (old_max != cur_max);
 }
 
+static void zram_compact(struct zram *zram)
+{
+	unsigned long pages;
+
+	pages = zs_compact(zram->meta->mem_pool);
+	atomic64_inc(&zram->stats.num_compactions);
+	atomic64_add(pages, &zram->stats.pages_compacted);
+}
+
+static void zram_compact_work(struct work_struct *work)
+{
+	struct zram *zram = container_of(work, struct zram, compact_work);
+
+	down_read(&zram->init_lock);
+	if (init_done(zram))
+		zram_compact(zram);
+	up_read(&zram->init_lock);
+}
+
+/*
+ * The pool holds more memory than the compressed objects need when
+ * frees leave zspages partially used. Once that excess goes over
+ * compact_threshold percent of compr_data_size, compact the pool from
+ * a worker, at most once per ZRAM_COMPACT_INTERVAL.
+ */
+static void zram_maybe_compact(struct zram *zram)
+{
+	u64 used, compr;
+	unsigned int threshold = ACCESS_ONCE(zram->compact_threshold);
+
+	if (!threshold || time_before(jiffies, zram->compact_next))
+		return;
+
+	compr = atomic64_read(&zram->stats.compr_data_size);
+	used = (u64)zs_get_total_pages(zram->meta->mem_pool) << PAGE_SHIFT;
+	if (used <= compr || (used - compr) * 100 <= compr * threshold)
+		return;
+
+	zram->compact_next = jiffies + ZRAM_COMPACT_INTERVAL;
+	queue_work(system_unbound_wq, &zram->compact_work);
+}
+
 static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 			   int offset)
 {
@@ -562,7 +901,10 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 	bool locked = false;
 	unsigned long alloced_pages;
 	static unsigned long zram_rs_time;
+	u32 checksum = 0;
+	bool dedup = false, dup = false;
 
+	handle = 0;
 	page = bvec->bv_page;
 	if (is_partial_io(bvec)) {
 		uncmem = kmalloc(PAGE_SIZE, GFP_NOIO);
@@ -575,6 +917,7 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 			goto out;
 	}
 
+compress_again:
 	zstrm = zcomp_strm_find(zram->comp);
 	locked = true;
 	user_mem = kmap_atomic(page);
@@ -599,9 +942,12 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 
 		atomic64_inc(&zram->stats.zero_pages);
 		ret = 0;
-		goto out;
+		goto out_free_handle;
 	}
 
+	if (zram_dedup_enabled(meta))
+		checksum = zram_dedup_checksum(uncmem);
+
 	ret = zcomp_compress(zram->comp, zstrm, uncmem, &clen);
 	if (!is_partial_io(bvec)) {
 		kunmap_atomic(user_mem);
@@ -611,7 +957,7 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 
 	if (unlikely(ret)) {
 		pr_err("Compression failed! err=%d\n", ret);
-		goto out;
+		goto out_free_handle;
 	}
 	src = zstrm->buffer;
 	if (unlikely(clen > max_zpage_size)) {
@@ -620,8 +966,41 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 			src = uncmem;
 	}
 
-	handle = zs_malloc(meta->mem_pool, clen);
+	if (!handle && zram_dedup_enabled(meta)) {
+		if ((clen == PAGE_SIZE) && !is_partial_io(bvec)) {
+			src = kmap_atomic(page);
+			handle = zram_dedup_find(zram, checksum, src, clen);
+			kunmap_atomic(src);
+		} else {
+			handle = zram_dedup_find(zram, checksum, src, clen);
+		}
+
+		if (handle) {
+			zcomp_strm_release(zram->comp, zstrm);
+			locked = false;
+			dedup = dup = true;
+			goto store;
+		}
+	}
+
+	/*
+	 * The stream is per-cpu and holds preemption off, so the object is
+	 * first allocated without sleeping. If that fails, drop the stream,
+	 * allocate with reclaim allowed and compress the page again; the
+	 * result has the same size, so the handle fits. A handle set here
+	 * means we are on that second pass.
+	 */
+	if (!handle)
+		handle = zs_malloc_gfp(meta->mem_pool, clen,
+				       __GFP_NOWARN | __GFP_HIGHMEM);
 	if (!handle) {
+		zcomp_strm_release(zram->comp, zstrm);
+		locked = false;
+		atomic64_inc(&zram->stats.writestall);
+		handle = zs_malloc(meta->mem_pool, clen);
+		if (handle)
+			goto compress_again;
+
 		if (printk_timed_ratelimit(&zram_rs_time,
 					   ALLOC_ERROR_LOG_RATE_MS))
 			pr_info("Error allocating memory for compressed page: %u, size=%zu\n",
@@ -654,16 +1033,35 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 	locked = false;
 	zs_unmap_object(meta->mem_pool, handle);
 
+	if (zram_dedup_enabled(meta))
+		dedup = zram_dedup_insert(zram, checksum, handle, clen);
+store:
 	bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
 	zram_free_page(zram, index);
 
 	meta->table[index].handle = handle;
 	zram_set_obj_size(meta, index, clen);
+	if (clen == PAGE_SIZE)
+		zram_set_flag(meta, index, ZRAM_HUGE);
+	if (dedup) {
+		zram_set_flag(meta, index, ZRAM_DEDUP);
+		zram_set_checksum(meta, index, checksum);
+	}
+	zram_accessed(meta, index);
 	bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
 
 	
-	atomic64_add(clen, &zram->stats.compr_data_size);
+	if (dup)
+		zram_dup_data_add(zram, clen);
+	else
+		atomic64_add(clen, &zram->stats.compr_data_size);
 	atomic64_inc(&zram->stats.pages_stored);
+	zram_maybe_compact(zram);
+	goto out;
+
+out_free_handle:
+	if (handle)
+		zs_free(meta->mem_pool, handle);
 out:
 	if (locked)
 		zcomp_strm_release(zram->comp, zstrm);
@@ -720,6 +1118,522 @@ static void zram_bio_discard(struct zram *zram, u32 index,
 	}
 }
 
+/*
+ * Writing "all" marks every stored page idle. With memory tracking, writing
+ * a number of seconds marks only the pages not accessed for that long.
+ */
+static ssize_t idle_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	struct zram_meta *meta;
+	size_t index, nr_pages;
+	ssize_t ret = len;
+	u32 min_age = 0;
+#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+	u32 now = zram_boot_secs();
+#endif
+
+	if (!sysfs_streq(buf, "all")) {
+#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+		if (kstrtou32(buf, 10, &min_age))
+			return -EINVAL;
+#else
+		return -EINVAL;
+#endif
+	}
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	meta = zram->meta;
+	nr_pages = zram->disksize >> PAGE_SHIFT;
+	for (index = 0; index < nr_pages; index++) {
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		if (!meta->table[index].handle ||
+				zram_test_flag(meta, index, ZRAM_WB))
+			goto next;
+#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+		if (now - meta->table[index].ac_time < min_age)
+			goto next;
+#endif
+		zram_set_flag(meta, index, ZRAM_IDLE);
+next:
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+	}
+out:
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+
+/*
+ * Writing "idle" recompresses every idle page with recomp_algorithm and
+ * keeps the result if it is smaller. Pages shared through dedup, stored
+ * uncompressed or on the backing device are left alone.
+ */
+static ssize_t recompress_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	struct zram_meta *meta;
+	struct zcomp_strm *zstrm = NULL;
+	struct page *page;
+	size_t index, nr_pages;
+	ssize_t ret = len;
+
+	if (!sysfs_streq(buf, "idle"))
+		return -EINVAL;
+
+	page = alloc_page(GFP_KERNEL);
+	if (!page)
+		return -ENOMEM;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram) || !zram->recomp) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	zstrm = zcomp_strm_alloc(zram->recomp);
+	if (!zstrm) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	meta = zram->meta;
+	nr_pages = zram->disksize >> PAGE_SHIFT;
+	for (index = 0; index < nr_pages; index++) {
+		unsigned long handle;
+		unsigned char *cmem;
+		size_t size, clen;
+
+		cond_resched();
+
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		if (!meta->table[index].handle ||
+				!zram_test_flag(meta, index, ZRAM_IDLE) ||
+				zram_test_flag(meta, index, ZRAM_WB) ||
+				zram_test_flag(meta, index, ZRAM_UNDER_WB) ||
+				zram_test_flag(meta, index, ZRAM_HUGE) ||
+				zram_test_flag(meta, index, ZRAM_DEDUP) ||
+				zram_test_flag(meta, index, ZRAM_RECOMP)) {
+			bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+			continue;
+		}
+		/* cleared by zram_free_page() if the slot changes under us */
+		zram_set_flag(meta, index, ZRAM_UNDER_WB);
+		size = zram_get_obj_size(meta, index);
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+
+		if (zram_decompress_page(zram, page_address(page), index))
+			goto next;
+		if (zcomp_compress(zram->recomp, zstrm, page_address(page),
+				   &clen))
+			goto next;
+		if (clen >= size)
+			goto next;
+
+		handle = zs_malloc(meta->mem_pool, clen);
+		if (!handle) {
+			ret = -ENOMEM;
+			goto next;
+		}
+		cmem = zs_map_object(meta->mem_pool, handle, ZS_MM_WO);
+		memcpy(cmem, zstrm->buffer, clen);
+		zs_unmap_object(meta->mem_pool, handle);
+
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		if (!zram_test_flag(meta, index, ZRAM_UNDER_WB)) {
+			bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+			zs_free(meta->mem_pool, handle);
+			continue;
+		}
+		zs_free(meta->mem_pool, meta->table[index].handle);
+		meta->table[index].handle = handle;
+		zram_set_obj_size(meta, index, clen);
+		zram_set_flag(meta, index, ZRAM_RECOMP);
+		zram_clear_flag(meta, index, ZRAM_UNDER_WB);
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+
+		atomic64_sub(size - clen, &zram->stats.compr_data_size);
+		atomic64_inc(&zram->stats.recomp_pages);
+		continue;
+next:
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		zram_clear_flag(meta, index, ZRAM_UNDER_WB);
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+		if (ret < 0)
+			break;
+	}
+out:
+	if (zstrm)
+		zcomp_strm_free(zram->recomp, zstrm);
+	up_read(&zram->init_lock);
+	__free_page(page);
+
+	return ret;
+}
+
+#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+/* Upper bounds, in seconds, of the age_histogram buckets. */
+static const u32 zram_age_buckets[] = {
+	60, 5 * 60, 15 * 60, 60 * 60, 4 * 60 * 60, 24 * 60 * 60,
+};
+#define ZRAM_AGE_BUCKETS	(ARRAY_SIZE(zram_age_buckets) + 1)
+
+static ssize_t age_histogram_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	struct zram_meta *meta;
+	unsigned long count[ZRAM_AGE_BUCKETS] = { 0 };
+	unsigned long idle = 0;
+	size_t index, nr_pages;
+	u32 now = zram_boot_secs();
+	ssize_t sz = 0;
+	int i;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		up_read(&zram->init_lock);
+		return -EINVAL;
+	}
+
+	meta = zram->meta;
+	nr_pages = zram->disksize >> PAGE_SHIFT;
+	for (index = 0; index < nr_pages; index++) {
+		u32 age;
+
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		if (!meta->table[index].handle ||
+				zram_test_flag(meta, index, ZRAM_WB)) {
+			bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+			continue;
+		}
+		age = now - meta->table[index].ac_time;
+		if (zram_test_flag(meta, index, ZRAM_IDLE))
+			idle++;
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+
+		for (i = 0; i < ARRAY_SIZE(zram_age_buckets); i++)
+			if (age < zram_age_buckets[i])
+				break;
+		count[i]++;
+	}
+	up_read(&zram->init_lock);
+
+	for (i = 0; i < ARRAY_SIZE(zram_age_buckets); i++)
+		sz += scnprintf(buf + sz, PAGE_SIZE - sz, "<%u %lu\n",
+				zram_age_buckets[i], count[i]);
+	sz += scnprintf(buf + sz, PAGE_SIZE - sz, ">=%u %lu\n",
+			zram_age_buckets[i - 1], count[i]);
+	sz += scnprintf(buf + sz, PAGE_SIZE - sz, "idle %lu\n", idle);
+
+	return sz;
+}
+#endif
+
+#ifdef CONFIG_ZRAM_WRITEBACK
+static ssize_t backing_dev_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	char *p;
+	ssize_t ret;
+
+	down_read(&zram->init_lock);
+	if (!zram_wb_enabled(zram)) {
+		up_read(&zram->init_lock);
+		return scnprintf(buf, PAGE_SIZE, "none\n");
+	}
+
+	p = d_path(&zram->backing_dev->f_path, buf, PAGE_SIZE - 1);
+	if (IS_ERR(p)) {
+		ret = PTR_ERR(p);
+	} else {
+		ret = strlen(p);
+		memmove(buf, p, ret);
+		buf[ret++] = '\n';
+	}
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+
+static ssize_t backing_dev_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	char *file_name;
+	size_t sz;
+	struct file *backing_dev = NULL;
+	struct inode *inode;
+	struct block_device *bdev = NULL;
+	unsigned long nr_pages, *bitmap = NULL;
+	unsigned int old_block_size;
+	struct zram *zram = dev_to_zram(dev);
+	int err;
+
+	file_name = kmalloc(PATH_MAX, GFP_KERNEL);
+	if (!file_name)
+		return -ENOMEM;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		pr_info("Can't setup backing device for initialized device\n");
+		err = -EBUSY;
+		goto out;
+	}
+
+	strlcpy(file_name, buf, PATH_MAX);
+	sz = strlen(file_name);
+	if (sz > 0 && file_name[sz - 1] == '\n')
+		file_name[sz - 1] = '\0';
+
+	backing_dev = filp_open(file_name, O_RDWR | O_LARGEFILE, 0);
+	if (IS_ERR(backing_dev)) {
+		err = PTR_ERR(backing_dev);
+		backing_dev = NULL;
+		goto out;
+	}
+
+	inode = backing_dev->f_mapping->host;
+	/* Only block devices are supported as backing store for now */
+	if (!S_ISBLK(inode->i_mode)) {
+		err = -ENOTBLK;
+		goto out;
+	}
+
+	bdev = bdgrab(I_BDEV(inode));
+	err = blkdev_get(bdev, FMODE_READ | FMODE_WRITE | FMODE_EXCL, zram);
+	if (err < 0) {
+		/* blkdev_get() drops the reference on failure */
+		bdev = NULL;
+		goto out;
+	}
+
+	nr_pages = i_size_read(inode) >> PAGE_SHIFT;
+	if (nr_pages < 2) {
+		err = -EINVAL;
+		goto out;
+	}
+
+	bitmap = vzalloc(BITS_TO_LONGS(nr_pages) * sizeof(long));
+	if (!bitmap) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	old_block_size = block_size(bdev);
+	err = set_blocksize(bdev, PAGE_SIZE);
+	if (err)
+		goto out;
+
+	zram_reset_bdev(zram);
+
+	zram->old_block_size = old_block_size;
+	zram->bdev = bdev;
+	zram->backing_dev = backing_dev;
+	zram->bitmap = bitmap;
+	zram->nr_pages = nr_pages;
+	up_write(&zram->init_lock);
+
+	pr_info("setup backing device %s\n", file_name);
+	kfree(file_name);
+
+	return len;
+out:
+	vfree(bitmap);
+	if (bdev)
+		blkdev_put(bdev, FMODE_READ | FMODE_WRITE | FMODE_EXCL);
+	if (backing_dev)
+		filp_close(backing_dev, NULL);
+	up_write(&zram->init_lock);
+	kfree(file_name);
+
+	return err;
+}
+
+/* Pages written to the backing device per batch. */
+#define ZRAM_WB_BATCH	32
+
+struct zram_wb_batch {
+	atomic_t pending;
+	struct completion done;
+	int nr_reqs;
+	struct zram_wb_req {
+		struct zram_wb_batch *batch;
+		struct page *page;
+		u32 index;
+		unsigned long blk_idx;
+		int error;
+	} reqs[ZRAM_WB_BATCH];
+};
+
+static void zram_wb_end_io(struct bio *bio, int error)
+{
+	struct zram_wb_req *req = bio->bi_private;
+
+	req->error = error;
+	if (atomic_dec_and_test(&req->batch->pending))
+		complete(&req->batch->done);
+	bio_put(bio);
+}
+
+/*
+ * Wait for the batch in flight and release the memory of every page that
+ * made it to the backing device intact. A slot rewritten or freed while its
+ * old contents were being written loses ZRAM_UNDER_WB, in which case the
+ * block is dropped instead.
+ */
+static void zram_wb_complete(struct zram *zram, struct zram_wb_batch *batch)
+{
+	struct zram_meta *meta = zram->meta;
+	int i;
+
+	if (!atomic_dec_and_test(&batch->pending))
+		wait_for_completion(&batch->done);
+
+	for (i = 0; i < batch->nr_reqs; i++) {
+		struct zram_wb_req *req = &batch->reqs[i];
+		u32 index = req->index;
+
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		if (req->error ||
+				!zram_test_flag(meta, index, ZRAM_UNDER_WB)) {
+			zram_clear_flag(meta, index, ZRAM_UNDER_WB);
+			bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+			zram_free_block(zram, req->blk_idx);
+			continue;
+		}
+
+		zram_free_page(zram, index);
+		zram_set_flag(meta, index, ZRAM_WB);
+		meta->table[index].handle = req->blk_idx;
+		atomic64_inc(&zram->stats.pages_stored);
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+		atomic64_inc(&zram->stats.bd_writes);
+	}
+
+	batch->nr_reqs = 0;
+	atomic_set(&batch->pending, 1);
+	reinit_completion(&batch->done);
+}
+
+static ssize_t writeback_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	struct zram_meta *meta;
+	struct zram_wb_batch *batch;
+	struct blk_plug plug;
+	size_t index, nr_pages;
+	enum zram_pageflags mode;
+	ssize_t ret = len;
+	int i;
+
+	if (sysfs_streq(buf, "idle"))
+		mode = ZRAM_IDLE;
+	else if (sysfs_streq(buf, "huge"))
+		mode = ZRAM_HUGE;
+	else
+		return -EINVAL;
+
+	batch = kzalloc(sizeof(*batch), GFP_KERNEL);
+	if (!batch)
+		return -ENOMEM;
+	atomic_set(&batch->pending, 1);
+	init_completion(&batch->done);
+	for (i = 0; i < ZRAM_WB_BATCH; i++) {
+		batch->reqs[i].batch = batch;
+		batch->reqs[i].page = alloc_page(GFP_KERNEL);
+		if (!batch->reqs[i].page) {
+			ret = -ENOMEM;
+			goto out_free;
+		}
+	}
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram) || !zram_wb_enabled(zram)) {
+		ret = -ENODEV;
+		goto out_unlock;
+	}
+
+	meta = zram->meta;
+	nr_pages = zram->disksize >> PAGE_SHIFT;
+	blk_start_plug(&plug);
+	for (index = 0; index < nr_pages; index++) {
+		struct zram_wb_req *req = &batch->reqs[batch->nr_reqs];
+		struct bio *bio;
+
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		if (!meta->table[index].handle ||
+				zram_test_flag(meta, index, ZRAM_WB) ||
+				zram_test_flag(meta, index, ZRAM_UNDER_WB) ||
+				!zram_test_flag(meta, index, mode)) {
+			bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+			continue;
+		}
+		zram_set_flag(meta, index, ZRAM_UNDER_WB);
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+
+		req->blk_idx = zram_alloc_block(zram);
+		if (!req->blk_idx) {
+			ret = -ENOSPC;
+			goto clear_under_wb;
+		}
+
+		if (zram_decompress_page(zram, page_address(req->page),
+					 index)) {
+			zram_free_block(zram, req->blk_idx);
+			goto clear_under_wb;
+		}
+
+		bio = bio_alloc(GFP_KERNEL, 1);
+		bio->bi_bdev = zram->bdev;
+		bio->bi_iter.bi_sector = req->blk_idx *
+					 (PAGE_SIZE >> SECTOR_SHIFT);
+		bio_add_page(bio, req->page, PAGE_SIZE, 0);
+		bio->bi_end_io = zram_wb_end_io;
+		bio->bi_private = req;
+
+		req->index = index;
+		req->error = 0;
+		atomic_inc(&batch->pending);
+		submit_bio(WRITE, bio);
+
+		if (++batch->nr_reqs == ZRAM_WB_BATCH) {
+			blk_finish_plug(&plug);
+			zram_wb_complete(zram, batch);
+			blk_start_plug(&plug);
+		}
+		continue;
+
+clear_under_wb:
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		zram_clear_flag(meta, index, ZRAM_UNDER_WB);
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+		if (ret < 0)
+			break;
+	}
+	blk_finish_plug(&plug);
+	zram_wb_complete(zram, batch);
+
+out_unlock:
+	up_read(&zram->init_lock);
+out_free:
+	for (i = 0; i < ZRAM_WB_BATCH; i++)
+		if (batch->reqs[i].page)
+			__free_page(batch->reqs[i].page);
+	kfree(batch);
+
+	return ret;
+}
+#endif
+
 static void zram_reset_device(struct zram *zram, bool reset_capacity)
 {
 	size_t index;
@@ -728,6 +1642,7 @@ static void zram_reset_device(struct zram *zram, bool reset_capacity)
 	down_write(&zram->init_lock);
 
 	zram->limit_pages = 0;
+	zram_reset_bdev(zram);
 
 	if (!init_done(zram)) {
 		up_write(&zram->init_lock);
@@ -738,14 +1653,22 @@ static void zram_reset_device(struct zram *zram, bool reset_capacity)
 	
 	for (index = 0; index < zram->disksize >> PAGE_SHIFT; index++) {
 		unsigned long handle = meta->table[index].handle;
-		if (!handle)
+		if (!handle || zram_test_flag(meta, index, ZRAM_WB))
+			continue;
+
+		if (zram_test_flag(meta, index, ZRAM_DEDUP) &&
+		    !zram_dedup_put(zram, zram_get_checksum(meta, index),
+				    handle))
 			continue;
 
 		zs_free(meta->mem_pool, handle);
 	}
 
 	zcomp_destroy(zram->comp);
-	zram->max_comp_streams = 1;
+	if (zram->recomp) {
+		zcomp_destroy(zram->recomp);
+		zram->recomp = NULL;
+	}
 
 	zram_meta_free(zram->meta);
 	zram->meta = NULL;
@@ -766,7 +1689,7 @@ static ssize_t disksize_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t len)
 {
 	u64 disksize;
-	struct zcomp *comp;
+	struct zcomp *comp, *recomp = NULL;
 	struct zram_meta *meta;
 	struct zram *zram = dev_to_zram(dev);
 	int err;
@@ -780,7 +1703,15 @@ static ssize_t disksize_store(struct device *dev,
 	if (!meta)
 		return -ENOMEM;
 
-	comp = zcomp_create(zram->compressor, zram->max_comp_streams);
+#ifdef CONFIG_ZRAM_DEDUP
+	if (zram->use_dedup) {
+		err = zram_dedup_init(meta, disksize >> PAGE_SHIFT);
+		if (err)
+			goto out_free_meta;
+	}
+#endif
+
+	comp = zcomp_create(zram->compressor);
 	if (IS_ERR(comp)) {
 		pr_info("Cannot initialise %s compressing backend\n",
 				zram->compressor);
@@ -788,6 +1719,16 @@ static ssize_t disksize_store(struct device *dev,
 		goto out_free_meta;
 	}
 
+	if (zram->recomp_algorithm[0]) {
+		recomp = zcomp_create_unpooled(zram->recomp_algorithm);
+		if (IS_ERR(recomp)) {
+			pr_info("Cannot initialise %s compressing backend\n",
+					zram->recomp_algorithm);
+			err = PTR_ERR(recomp);
+			goto out_free_comp;
+		}
+	}
+
 	down_write(&zram->init_lock);
 	if (init_done(zram)) {
 		pr_info("Cannot change disksize for initialized device\n");
@@ -797,6 +1738,7 @@ static ssize_t disksize_store(struct device *dev,
 
 	zram->meta = meta;
 	zram->comp = comp;
+	zram->recomp = recomp;
 	zram->disksize = disksize;
 	set_capacity(zram->disk, zram->disksize >> SECTOR_SHIFT);
 	up_write(&zram->init_lock);
@@ -807,6 +1749,9 @@ static ssize_t disksize_store(struct device *dev,
 
 out_destroy_comp:
 	up_write(&zram->init_lock);
+	if (recomp)
+		zcomp_destroy(recomp);
+out_free_comp:
 	zcomp_destroy(comp);
 out_free_meta:
 	zram_meta_free(meta);
@@ -960,6 +1905,25 @@ static DEVICE_ATTR(max_comp_streams, S_IRUGO | S_IWUSR,
 		max_comp_streams_show, max_comp_streams_store);
 static DEVICE_ATTR(comp_algorithm, S_IRUGO | S_IWUSR,
 		comp_algorithm_show, comp_algorithm_store);
+static DEVICE_ATTR(compact, S_IWUSR, NULL, compact_store);
+static DEVICE_ATTR(compact_threshold, S_IRUGO | S_IWUSR,
+		compact_threshold_show, compact_threshold_store);
+static DEVICE_ATTR(idle, S_IWUSR, NULL, idle_store);
+static DEVICE_ATTR(recomp_algorithm, S_IRUGO | S_IWUSR,
+		recomp_algorithm_show, recomp_algorithm_store);
+static DEVICE_ATTR(recompress, S_IWUSR, NULL, recompress_store);
+#ifdef CONFIG_ZRAM_DEDUP
+static DEVICE_ATTR(use_dedup, S_IRUGO | S_IWUSR, use_dedup_show,
+		use_dedup_store);
+#endif
+#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+static DEVICE_ATTR(age_histogram, S_IRUGO, age_histogram_show, NULL);
+#endif
+#ifdef CONFIG_ZRAM_WRITEBACK
+static DEVICE_ATTR(backing_dev, S_IRUGO | S_IWUSR,
+		backing_dev_show, backing_dev_store);
+static DEVICE_ATTR(writeback, S_IWUSR, NULL, writeback_store);
+#endif
 
 ZRAM_ATTR_RO(num_reads);
 ZRAM_ATTR_RO(num_writes);
@@ -969,6 +1933,19 @@ ZRAM_ATTR_RO(invalid_io);
 ZRAM_ATTR_RO(notify_free);
 ZRAM_ATTR_RO(zero_pages);
 ZRAM_ATTR_RO(compr_data_size);
+ZRAM_ATTR_RO(writestall);
+ZRAM_ATTR_RO(recomp_pages);
+ZRAM_ATTR_RO(num_compactions);
+ZRAM_ATTR_RO(pages_compacted);
+#ifdef CONFIG_ZRAM_WRITEBACK
+ZRAM_ATTR_RO(bd_count);
+ZRAM_ATTR_RO(bd_reads);
+ZRAM_ATTR_RO(bd_writes);
+#endif
+#ifdef CONFIG_ZRAM_DEDUP
+ZRAM_ATTR_RO(dup_data_size);
+ZRAM_ATTR_RO(meta_data_size);
+#endif
 
 static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_disksize.attr,
@@ -988,6 +1965,30 @@ static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_mem_used_max.attr,
 	&dev_attr_max_comp_streams.attr,
 	&dev_attr_comp_algorithm.attr,
+	&dev_attr_writestall.attr,
+	&dev_attr_compact.attr,
+	&dev_attr_compact_threshold.attr,
+	&dev_attr_num_compactions.attr,
+	&dev_attr_pages_compacted.attr,
+	&dev_attr_idle.attr,
+	&dev_attr_recomp_algorithm.attr,
+	&dev_attr_recompress.attr,
+	&dev_attr_recomp_pages.attr,
+#ifdef CONFIG_ZRAM_DEDUP
+	&dev_attr_use_dedup.attr,
+	&dev_attr_dup_data_size.attr,
+	&dev_attr_meta_data_size.attr,
+#endif
+#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+	&dev_attr_age_histogram.attr,
+#endif
+#ifdef CONFIG_ZRAM_WRITEBACK
+	&dev_attr_backing_dev.attr,
+	&dev_attr_writeback.attr,
+	&dev_attr_bd_count.attr,
+	&dev_attr_bd_reads.attr,
+	&dev_attr_bd_writes.attr,
+#endif
 	NULL,
 };
 
@@ -1000,6 +2001,8 @@ static int create_device(struct zram *zram, int device_id)
 	int ret = -ENOMEM;
 
 	init_rwsem(&zram->init_lock);
+	INIT_WORK(&zram->compact_work, zram_compact_work);
+	zram->compact_threshold = ZRAM_COMPACT_THRESHOLD;
 
 	zram->queue = blk_alloc_queue(GFP_KERNEL);
 	if (!zram->queue) {
@@ -1055,7 +2058,6 @@ static int create_device(struct zram *zram, int device_id)
 	}
 	strlcpy(zram->compressor, default_compressor, sizeof(zram->compressor));
 	zram->meta = NULL;
-	zram->max_comp_streams = 1;
 	return 0;
 
 out_free_disk:
@@ -1071,6 +2073,7 @@ static void destroy_device(struct zram *zram)
 {
 	sysfs_remove_group(&disk_to_dev(zram->disk)->kobj,
 			&zram_disk_attr_group);
+	cancel_work_sync(&zram->compact_work);
 
 	del_gendisk(zram->disk);
 	put_disk(zram->disk);
@@ -1110,6 +2113,7 @@ static int __init zram_init(void)
 	}
 
 	show_mem_notifier_register(&zram_show_mem_notifier_block);
+	zcomp_bench_init();
 	pr_info("Created %u device(s) ...\n", num_devices);
 
 	return 0;
@@ -1129,6 +2133,8 @@ static void __exit zram_exit(void)
 	int i;
 	struct zram *zram;
 
+	zcomp_bench_exit();
+
 	for (i = 0; i < num_devices; i++) {
 		zram = &zram_devices[i];
 
@@ -17,8 +17,10 @@
 
 #include <linux/spinlock.h>
 #include <linux/zsmalloc.h>
+#include <linux/workqueue.h>
 
 #include "zcomp.h"
+#include "zram_dedup.h"
 
 /*
  * Some arbitrary value. This is just to catch
@@ -59,15 +61,22 @@ static const size_t max_zpage_size = PAGE_SIZE / 4 * 3;
  * zram is mainly used for memory efficiency so we want to keep memory
  * footprint small so we can squeeze size and flags into a field.
  * The lower ZRAM_FLAG_SHIFT bits is for object size (excluding header),
- * the higher bits is for zram_pageflags.
+ * the higher bits is for zram_pageflags. Object size never exceeds
+ * PAGE_SIZE, so PAGE_SHIFT + 1 bits are enough to hold it.
  */
-#define ZRAM_FLAG_SHIFT 24
+#define ZRAM_FLAG_SHIFT (PAGE_SHIFT + 1)
 
 /* Flags for zram pages (table[page_no].value) */
 enum zram_pageflags {
 	/* Page consists entirely of zeros */
 	ZRAM_ZERO = ZRAM_FLAG_SHIFT + 1,
 	ZRAM_ACCESS,	/* page in now accessed */
+	ZRAM_WB,	/* page is stored on backing_device */
+	ZRAM_UNDER_WB,	/* page is being written back or recompressed */
+	ZRAM_HUGE,	/* incompressible page, stored at full size */
+	ZRAM_IDLE,	/* not accessed since last idle marking */
+	ZRAM_DEDUP,	/* handle is shared through the dedup table */
+	ZRAM_RECOMP,	/* compressed with recomp_algorithm */
 
 	__NR_ZRAM_PAGEFLAGS,
 };
@@ -78,6 +87,12 @@ enum zram_pageflags {
 struct zram_table_entry {
 	unsigned long handle;
 	unsigned long value;
+#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+	u32 ac_time;	/* last access, in seconds since boot */
+#endif
+#ifdef CONFIG_ZRAM_DEDUP
+	u32 checksum;	/* of the uncompressed page, if ZRAM_DEDUP */
+#endif
 };
 
 struct zram_stats {
@@ -91,11 +106,36 @@ struct zram_stats {
 	atomic64_t zero_pages;		/* no. of zero filled pages */
 	atomic64_t pages_stored;	/* no. of pages currently stored */
 	atomic_long_t max_used_pages;	/* no. of maximum pages stored */
+	atomic64_t writestall;		/* no. of write slow paths */
+	atomic64_t recomp_pages;	/* no. of pages stored recompressed */
+	atomic64_t num_compactions;	/* no. of pool compaction runs */
+	atomic64_t pages_compacted;	/* no. of pages freed by compaction */
+#ifdef CONFIG_ZRAM_WRITEBACK
+	atomic64_t bd_count;		/* no. of pages in backing device */
+	atomic64_t bd_reads;		/* no. of reads from backing device */
+	atomic64_t bd_writes;		/* no. of writes to backing device */
+#endif
+#ifdef CONFIG_ZRAM_DEDUP
+	atomic64_t dup_data_size;	/* compressed bytes saved by dedup */
+	atomic64_t meta_data_size;	/* bytes used by dedup entries */
+#endif
+};
+
+#ifdef CONFIG_ZRAM_DEDUP
+struct zram_hash {
+	spinlock_t lock;
+	struct hlist_head head;
 };
+#endif
 
 struct zram_meta {
 	struct zram_table_entry *table;
 	struct zs_pool *mem_pool;
+#ifdef CONFIG_ZRAM_DEDUP
+	/* NULL unless dedup was enabled when the device was initialized */
+	struct zram_hash *hash;
+	size_t hash_size;
+#endif
 };
 
 struct zram {
@@ -103,6 +143,8 @@ struct zram {
 	struct request_queue *queue;
 	struct gendisk *disk;
 	struct zcomp *comp;
+	/* secondary algorithm for idle pages, NULL if not configured */
+	struct zcomp *recomp;
 
 	/* Prevent concurrent execution of device init, reset and R/W request */
 	struct rw_semaphore init_lock;
@@ -111,7 +153,6 @@ struct zram {
 	 * we can store in a disk.
 	 */
 	u64 disksize;	/* bytes */
-	int max_comp_streams;
 	struct zram_stats stats;
 	/*
 	 * the number of pages zram can consume for storing compressed data
@@ -119,5 +160,21 @@ struct zram {
 	unsigned long limit_pages;
 
 	char compressor[10];
+	char recomp_algorithm[10];
+	/* background pool compaction, see zram_maybe_compact() */
+	struct work_struct compact_work;
+	unsigned long compact_next;	/* jiffies */
+	unsigned int compact_threshold;	/* percent, 0 disables */
+#ifdef CONFIG_ZRAM_DEDUP
+	bool use_dedup;
+#endif
+#ifdef CONFIG_ZRAM_WRITEBACK
+	struct file *backing_dev;
+	struct block_device *bdev;
+	unsigned int old_block_size;
+	/* one bit per page sized block of the backing device, bit 0 unused */
+	unsigned long *bitmap;
+	unsigned long nr_pages;
+#endif
 };
 #endif
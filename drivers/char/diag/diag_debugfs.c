@@ -361,8 +361,11 @@ static ssize_t diag_dbgfs_read_mempool(struct file *file, char __user *ubuf,
 			"%-10s\t"
 			"%-5s\t"
 			"%-5s\t"
+			"%-5s\t"
+			"%-5s\t"
 			"%-5s\n",
-			"POOL", "HANDLE", "COUNT", "SIZE", "ITEMSIZE");
+			"POOL", "HANDLE", "COUNT", "SIZE", "ITEMSIZE", "HWM",
+			"FAIL");
 	bytes_in_buffer += bytes_written;
 	bytes_remaining = buf_size - bytes_in_buffer;
 
@@ -373,12 +376,16 @@ static ssize_t diag_dbgfs_read_mempool(struct file *file, char __user *ubuf,
 			"%-10p\t"
 			"%-5d\t"
 			"%-5d\t"
-			"%-5d\n",
+			"%-5d\t"
+			"%-5d\t"
+			"%-5u\n",
 			mempool->name,
 			mempool->pool,
 			mempool->count,
 			mempool->poolsize,
-			mempool->itemsize);
+			mempool->itemsize,
+			mempool->hwm,
+			mempool->fail_count);
 		bytes_in_buffer += bytes_written;
 
 		/* Check if there is room to add another table entry */
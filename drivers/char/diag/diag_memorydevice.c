@@ -22,6 +22,9 @@
 #include <linux/delay.h>
 #include <linux/kmemleak.h>
 #include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
+#include <linux/log2.h>
 #include "diagchar.h"
 #include "diag_memorydevice.h"
 #include "diagfwd_bridge.h"
@@ -123,9 +126,185 @@ void diag_md_close_all()
 	diag_ws_reset(DIAG_WS_MUX);
 }
 
+/* Largest data area a client can map, in bytes */
+#define DIAG_MD_RING_MAX	(16 * 1024 * 1024)
+
+/* Protects the ring of every session and its lifetime */
+static DEFINE_SPINLOCK(diag_md_ring_lock);
+
+/*
+ * Copy one packet into the session ring. Called with diag_md_ring_lock
+ * held. The tail is written by the client, so it is only trusted to tell
+ * how much room is left.
+ */
+static int diag_md_ring_write(struct diag_md_ring *ring, int token,
+			      unsigned char *buf, int len)
+{
+	struct diag_md_ring_rec rec;
+	uint32_t tail = ACCESS_ONCE(ring->hdr->tail);
+	uint32_t used = ring->head - tail;
+	uint32_t rec_len = ALIGN(sizeof(rec) + len, 4);
+	uint32_t off = ring->head & (ring->size - 1);
+	uint32_t pad = 0;
+
+	if (rec_len > ring->size - off)
+		pad = ring->size - off;
+	if (used > ring->size || used + pad + rec_len > ring->size) {
+		ring->hdr->dropped++;
+		return -ENOMEM;
+	}
+
+	if (pad >= sizeof(rec)) {
+		rec.token = 0;
+		rec.len = DIAG_MD_RING_PAD;
+		memcpy(ring->data + off, &rec, sizeof(rec));
+	}
+	if (pad)
+		off = 0;
+
+	rec.token = token;
+	rec.len = len;
+	memcpy(ring->data + off, &rec, sizeof(rec));
+	memcpy(ring->data + off + sizeof(rec), buf, len);
+
+	/* make the record visible before the client can see the new head */
+	smp_wmb();
+	ring->head += pad + rec_len;
+	ACCESS_ONCE(ring->hdr->head) = ring->head;
+
+	return 0;
+}
+
+int diag_md_ring_mmap(struct diag_md_session_t *session,
+		      struct vm_area_struct *vma)
+{
+	struct diag_md_ring *ring;
+	unsigned long size = vma->vm_end - vma->vm_start;
+	unsigned long flags;
+	void *base;
+	int err;
+
+	if (!session)
+		return -EINVAL;
+	if (vma->vm_pgoff || size <= PAGE_SIZE)
+		return -EINVAL;
+	size -= PAGE_SIZE;
+	if (!is_power_of_2(size) || size > DIAG_MD_RING_MAX)
+		return -EINVAL;
+
+	ring = kzalloc(sizeof(*ring), GFP_KERNEL);
+	if (!ring)
+		return -ENOMEM;
+
+	base = vmalloc_user(size + PAGE_SIZE);
+	if (!base) {
+		kfree(ring);
+		return -ENOMEM;
+	}
+
+	err = remap_vmalloc_range(vma, base, 0);
+	if (err)
+		goto fail;
+
+	ring->hdr = base;
+	ring->data = base + PAGE_SIZE;
+	ring->size = size;
+	ring->hdr->magic = DIAG_MD_RING_MAGIC;
+	ring->hdr->size = size;
+
+	spin_lock_irqsave(&diag_md_ring_lock, flags);
+	if (session->ring) {
+		spin_unlock_irqrestore(&diag_md_ring_lock, flags);
+		err = -EBUSY;
+		goto fail;
+	}
+	session->ring = ring;
+	spin_unlock_irqrestore(&diag_md_ring_lock, flags);
+
+	return 0;
+
+fail:
+	/* pages already mapped stay alive until the client unmaps them */
+	vfree(base);
+	kfree(ring);
+	return err;
+}
+
+void diag_md_ring_free(struct diag_md_session_t *session)
+{
+	struct diag_md_ring *ring;
+	unsigned long flags;
+
+	if (!session)
+		return;
+
+	spin_lock_irqsave(&diag_md_ring_lock, flags);
+	ring = session->ring;
+	session->ring = NULL;
+	spin_unlock_irqrestore(&diag_md_ring_lock, flags);
+
+	if (!ring)
+		return;
+	vfree(ring->hdr);
+	kfree(ring);
+}
+
+/* Returns 1 if the session ring has records the client has not consumed */
+int diag_md_ring_avail(struct diag_md_session_t *session)
+{
+	unsigned long flags;
+	int avail = 0;
+
+	spin_lock_irqsave(&diag_md_ring_lock, flags);
+	if (session && session->ring)
+		avail = ACCESS_ONCE(session->ring->hdr->tail) !=
+			session->ring->head;
+	spin_unlock_irqrestore(&diag_md_ring_lock, flags);
+
+	return avail;
+}
+
+/*
+ * Hand a packet to a session that mapped a ring. The peripheral buffer is
+ * given back right away instead of waiting for the next read().
+ */
+static int diag_md_ring_push(struct diag_md_info *ch, int id,
+			     struct diag_md_session_t *session,
+			     unsigned char *buf, int len, int ctx)
+{
+	unsigned long flags;
+	int token = (id > 0) ? diag_get_remote(id) : 0;
+	int err = -ENODEV;
+
+	spin_lock_irqsave(&diag_md_ring_lock, flags);
+	if (session->ring)
+		err = diag_md_ring_write(session->ring, token, buf, len);
+	spin_unlock_irqrestore(&diag_md_ring_lock, flags);
+
+	if (err == -ENODEV)
+		return err;
+
+	spin_lock_irqsave(&ch->lock, flags);
+	diag_ws_on_read(DIAG_WS_MUX, len);
+	if (ch->ops && ch->ops->write_done)
+		ch->ops->write_done(buf, len, ctx, DIAG_MEMORY_DEVICE_MODE);
+	diag_ws_on_copy(DIAG_WS_MUX);
+	spin_unlock_irqrestore(&ch->lock, flags);
+	diag_ws_on_copy_complete(DIAG_WS_MUX);
+
+	if (err)
+		pr_err_ratelimited("diag: ring full, dropping packet of len: %d, proc: %d\n",
+				   len, id);
+	else
+		wake_up_interruptible(&driver->wait_q);
+
+	return err;
+}
+
 int diag_md_write(int id, unsigned char *buf, int len, int ctx)
 {
 	int i;
+	int err;
 	uint8_t found = 0;
 	unsigned long flags;
 	struct diag_md_info *ch = NULL;
@@ -148,6 +327,12 @@ int diag_md_write(int id, unsigned char *buf, int len, int ctx)
 
 	ch = &diag_md[id];
 
+	if (session_info->ring) {
+		err = diag_md_ring_push(ch, id, session_info, buf, len, ctx);
+		if (err != -ENODEV)
+			return err;
+	}
+
 	spin_lock_irqsave(&ch->lock, flags);
 	for (i = 0; i < ch->num_tbl_entries && !found; i++) {
 		if (ch->tbl[i].buf != buf)
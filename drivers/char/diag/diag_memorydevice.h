@@ -43,6 +43,13 @@ struct diag_md_info {
 	struct diag_mux_ops *ops;
 };
 
+struct diag_md_ring {
+	struct diag_md_ring_hdr *hdr;
+	unsigned char *data;
+	uint32_t size;
+	uint32_t head;
+};
+
 extern struct diag_md_info diag_md[NUM_DIAG_MD_DEV];
 
 int diag_md_init(void);
@@ -54,4 +61,8 @@ int diag_md_close_peripheral(int id, uint8_t peripheral);
 int diag_md_write(int id, unsigned char *buf, int len, int ctx);
 int diag_md_copy_to_user(char __user *buf, int *pret, size_t buf_size,
 			 struct diag_md_session_t *info);
+int diag_md_ring_mmap(struct diag_md_session_t *session,
+		      struct vm_area_struct *vma);
+void diag_md_ring_free(struct diag_md_session_t *session);
+int diag_md_ring_avail(struct diag_md_session_t *session);
 #endif
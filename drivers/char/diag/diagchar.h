@@ -377,6 +377,7 @@ struct diag_md_session_t {
 	struct diag_mask_info *log_mask;
 	struct diag_mask_info *event_mask;
 	struct task_struct *task;
+	struct diag_md_ring *ring;
 };
 
 struct diag_mask_info {
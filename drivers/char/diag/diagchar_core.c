@@ -22,6 +22,8 @@
 #include <linux/sched.h>
 #include <linux/ratelimit.h>
 #include <linux/timer.h>
+#include <linux/poll.h>
+#include <linux/mm.h>
 #ifdef CONFIG_DIAG_OVER_USB
 #include <linux/usb/usbdiag.h>
 #endif
@@ -1416,6 +1418,7 @@ static void diag_md_session_close(struct diag_md_session_t *session_info)
 	}
 
 	driver->md_session_mode = (found) ? DIAG_MD_PERIPHERAL : DIAG_MD_NONE;
+	diag_md_ring_free(session_info);
 	kfree(session_info);
 	session_info = NULL;
 	mutex_unlock(&driver->md_session_lock);
@@ -2982,6 +2985,48 @@ end:
 	return ret;
 }
 
+/*
+ * Memory device mode clients may map a ring to receive their data without
+ * a read() per batch. See struct diag_md_ring_hdr for the layout.
+ */
+static int diagchar_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct diag_md_session_t *session_info;
+	int err;
+
+	mutex_lock(&driver->md_session_lock);
+	session_info = diag_md_session_get_pid(current->tgid);
+	err = diag_md_ring_mmap(session_info, vma);
+	mutex_unlock(&driver->md_session_lock);
+
+	return err;
+}
+
+static unsigned int diagchar_poll(struct file *file, poll_table *wait)
+{
+	struct diag_md_session_t *session_info;
+	unsigned int mask = 0;
+	int i;
+
+	poll_wait(file, &driver->wait_q, wait);
+
+	mutex_lock(&driver->diagchar_mutex);
+	for (i = 0; i < driver->num_clients; i++) {
+		if (driver->client_map[i].pid == current->tgid &&
+		    driver->data_ready[i])
+			mask |= POLLIN | POLLRDNORM;
+	}
+	mutex_unlock(&driver->diagchar_mutex);
+
+	mutex_lock(&driver->md_session_lock);
+	session_info = diag_md_session_get_pid(current->tgid);
+	if (diag_md_ring_avail(session_info))
+		mask |= POLLIN | POLLRDNORM;
+	mutex_unlock(&driver->md_session_lock);
+
+	return mask;
+}
+
 static ssize_t diagchar_write(struct file *file, const char __user *buf,
 			      size_t count, loff_t *ppos)
 {
@@ -3283,6 +3328,8 @@ static const struct file_operations diagcharfops = {
 	.compat_ioctl = diagchar_compat_ioctl,
 #endif
 	.unlocked_ioctl = diagchar_ioctl,
+	.mmap = diagchar_mmap,
+	.poll = diagchar_poll,
 	.open = diagchar_open,
 	.release = diagchar_close
 };
@@ -3411,6 +3458,7 @@ static int __init diagchar_init(void)
 	diag_stats_init();
 	diag_debug_init();
 	diag_md_session_init();
+	diag_hdlc_init();
 
 	driver->incoming_pkt.capacity = DIAG_MAX_REQ_SIZE;
 	driver->incoming_pkt.data = kzalloc(DIAG_MAX_REQ_SIZE, GFP_KERNEL);
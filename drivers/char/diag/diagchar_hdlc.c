@@ -31,6 +31,66 @@ MODULE_LICENSE("GPL v2");
 #define CRC_16_L_STEP(xx_crc, xx_c) \
 	crc_ccitt_byte(xx_crc, xx_c)
 
+/*
+ * Slicing-by-8 tables for the reflected CRC-CCITT. Entry x of table k is
+ * the CRC of byte x followed by k zero bytes, table 0 is crc_ccitt_table.
+ */
+static u16 diag_crc16_tbl[8][256];
+
+/* Lookup of the bytes that need escaping, CONTROL_CHAR and ESC_CHAR */
+static u8 diag_hdlc_esc_tbl[256];
+
+void diag_hdlc_init(void)
+{
+	int i, k;
+
+	for (i = 0; i < 256; i++)
+		diag_crc16_tbl[0][i] = crc_ccitt_table[i];
+	for (k = 1; k < 8; k++) {
+		for (i = 0; i < 256; i++) {
+			u16 crc = diag_crc16_tbl[k - 1][i];
+
+			diag_crc16_tbl[k][i] = (crc >> 8) ^
+					       diag_crc16_tbl[0][crc & 0xFF];
+		}
+	}
+
+	diag_hdlc_esc_tbl[CONTROL_CHAR] = 1;
+	diag_hdlc_esc_tbl[ESC_CHAR] = 1;
+}
+
+static uint16_t diag_crc16(uint16_t crc, const uint8_t *buf, size_t len)
+{
+	while (len >= 8) {
+		crc ^= buf[0] | (buf[1] << 8);
+		crc = diag_crc16_tbl[7][crc & 0xFF] ^
+		      diag_crc16_tbl[6][crc >> 8] ^
+		      diag_crc16_tbl[5][buf[2]] ^
+		      diag_crc16_tbl[4][buf[3]] ^
+		      diag_crc16_tbl[3][buf[4]] ^
+		      diag_crc16_tbl[2][buf[5]] ^
+		      diag_crc16_tbl[1][buf[6]] ^
+		      diag_crc16_tbl[0][buf[7]];
+		buf += 8;
+		len -= 8;
+	}
+	while (len--)
+		crc = CRC_16_L_STEP(crc, *buf++);
+
+	return crc;
+}
+
+/* Number of leading bytes of @buf, at most @len, that need no escaping */
+static inline size_t diag_hdlc_plain_run(const uint8_t *buf, size_t len)
+{
+	size_t n = 0;
+
+	while (n < len && !diag_hdlc_esc_tbl[buf[n]])
+		n++;
+
+	return n;
+}
+
 void diag_hdlc_encode(struct diag_send_desc_type *src_desc,
 		      struct diag_hdlc_dest_type *enc)
 {
@@ -42,6 +102,7 @@ void diag_hdlc_encode(struct diag_send_desc_type *src_desc,
 	unsigned char src_byte = 0;
 	enum diag_send_state_enum_type state;
 	unsigned int used = 0;
+	size_t run;
 
 	if (src_desc && enc) {
 
@@ -63,6 +124,18 @@ void diag_hdlc_encode(struct diag_send_desc_type *src_desc,
 		if (dest && dest_last) {
 			while (src <= src_last && dest <= dest_last) {
 
+				/* copy up to the next byte to escape */
+				run = min(src_last - src, dest_last - dest) + 1;
+				run = diag_hdlc_plain_run(src, run);
+				if (run) {
+					crc = diag_crc16(crc, src, run);
+					memcpy(dest, src, run);
+					src += run;
+					dest += run;
+					used += run;
+					continue;
+				}
+
 				src_byte = *src++;
 
 				if ((src_byte == CONTROL_CHAR) ||
@@ -165,6 +238,7 @@ int diag_hdlc_decode(struct diag_hdlc_decode_type *hdlc)
 
 	unsigned int len = 0;
 	unsigned int i;
+	unsigned int run;
 	uint8_t src_byte;
 
 	int pkt_bnd = HDLC_INCOMPLETE;
@@ -186,6 +260,20 @@ int diag_hdlc_decode(struct diag_hdlc_decode_type *hdlc)
 
 		for (i = 0; i < src_length; i++) {
 
+			if (!hdlc->escaping) {
+				run = min(src_length - i, dest_length - len);
+				run = diag_hdlc_plain_run(&src_ptr[i], run);
+				if (run) {
+					memcpy(dest_ptr + len, src_ptr + i,
+					       run);
+					len += run;
+					i += run;
+					if (len >= dest_length ||
+					    i >= src_length)
+						break;
+				}
+			}
+
 			src_byte = src_ptr[i];
 
 			if (hdlc->escaping) {
@@ -235,7 +323,7 @@ int crc_check(uint8_t *buf, uint16_t len)
 		return -EIO;
 	}
 
-	crc = crc_ccitt(crc, buf, len-3);
+	crc = diag_crc16(crc, buf, len-3);
 	crc ^= CRC_16_L_SEED;
 
 	
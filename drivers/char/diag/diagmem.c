@@ -158,11 +158,40 @@ void diagmem_setsize(int pool_idx, int itemsize, int poolsize)
 		 diag_mempools[pool_idx].poolsize);
 }
 
+/*
+ * Reserve one of the poolsize items of the pool. The count is kept with
+ * atomics so that peripherals sharing a pool do not serialize on a lock
+ * around mempool_alloc(), which has its own.
+ */
+static int diagmem_get_item(struct diag_mempool_t *mempool)
+{
+	atomic_t *count = (atomic_t *)&mempool->count;
+	atomic_t *hwm = (atomic_t *)&mempool->hwm;
+	int old, cur = atomic_read(count);
+
+	do {
+		if (cur >= (int)mempool->poolsize)
+			return 0;
+		old = cur;
+		cur = atomic_cmpxchg(count, old, old + 1);
+	} while (cur != old);
+
+	cur = atomic_read(hwm);
+	while (cur <= old) {
+		int prev = atomic_cmpxchg(hwm, cur, old + 1);
+
+		if (prev == cur)
+			break;
+		cur = prev;
+	}
+
+	return 1;
+}
+
 void *diagmem_alloc(struct diagchar_dev *driver, int size, int pool_type)
 {
 	void *buf = NULL;
 	int i = 0;
-	unsigned long flags;
 	struct diag_mempool_t *mempool = NULL;
 
 	if (!driver)
@@ -182,14 +211,15 @@ void *diagmem_alloc(struct diagchar_dev *driver, int size, int pool_type)
 					   mempool->name, size);
 			break;
 		}
-		spin_lock_irqsave(&mempool->lock, flags);
-		if (mempool->count < mempool->poolsize) {
-			atomic_add(1, (atomic_t *)&mempool->count);
+		if (diagmem_get_item(mempool)) {
 			buf = mempool_alloc(mempool->pool, GFP_ATOMIC);
-			kmemleak_not_leak(buf);
+			if (buf)
+				kmemleak_not_leak(buf);
+			else
+				atomic_dec((atomic_t *)&mempool->count);
 		}
-		spin_unlock_irqrestore(&mempool->lock, flags);
 		if (!buf) {
+			atomic_inc((atomic_t *)&mempool->fail_count);
 			DIAG_DBUG("diag: Unable to allocate buffer from memory pool %s, size: %d/%d count: %d/%d\n",
 					     mempool->name,
 					     size, mempool->itemsize,
@@ -205,7 +235,6 @@ void *diagmem_alloc(struct diagchar_dev *driver, int size, int pool_type)
 void diagmem_free(struct diagchar_dev *driver, void *buf, int pool_type)
 {
 	int i = 0;
-	unsigned long flags;
 	struct diag_mempool_t *mempool = NULL;
 
 	if (!driver || !buf)
@@ -220,15 +249,12 @@ void diagmem_free(struct diagchar_dev *driver, void *buf, int pool_type)
 					   mempool->name);
 			break;
 		}
-		spin_lock_irqsave(&mempool->lock, flags);
-		if (mempool->count > 0) {
+		if (atomic_add_unless((atomic_t *)&mempool->count, -1, 0)) {
 			mempool_free(buf, mempool->pool);
-			atomic_add(-1, (atomic_t *)&mempool->count);
 		} else {
 			pr_err_ratelimited("diag: Attempting to free items from %s mempool which is already empty\n",
 					   mempool->name);
 		}
-		spin_unlock_irqrestore(&mempool->lock, flags);
 		break;
 	}
 }
@@ -49,8 +49,10 @@ struct diag_mempool_t {
 	unsigned int itemsize;
 	unsigned int poolsize;
 	int count;
+	int hwm;
+	unsigned int fail_count;
 	spinlock_t lock;
-} __packed;
+};
 
 extern struct diag_mempool_t diag_mempools[NUM_MEMORY_POOLS];
 
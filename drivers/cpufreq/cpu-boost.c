@@ -15,6 +15,7 @@
 
 #include <linux/kernel.h>
 #include <linux/init.h>
+#include <linux/export.h>
 #include <linux/notifier.h>
 #include <linux/cpufreq.h>
 #include <linux/cpu.h>
@@ -26,6 +27,8 @@
 #include <linux/slab.h>
 #include <linux/input.h>
 #include <linux/time.h>
+#include <linux/msm_mdp.h>
+#include <linux/cpu_boost.h>
 
 #define NUM_CLUSTER 2
 
@@ -77,6 +80,33 @@ static const unsigned long little_cluster_mask = CONFIG_POWER_CLUSTER_CPU_MASK;
 static struct delayed_work input_boost_rem;
 static u64 last_input_time;
 
+/*
+ * Frame driven input boost. When frame_boost_frames is set, an input
+ * boost lasts until that many frames have been committed by the display
+ * after the last input event, until the display goes idle, or until no
+ * frame is committed for frame_boost_timeout_ms. While it lasts, the boost
+ * frequency of each cluster is scaled up by how far the recent frame time
+ * is above frame_boost_target_us.
+ */
+static unsigned int frame_boost_frames;
+module_param(frame_boost_frames, uint, 0644);
+
+static unsigned int frame_boost_timeout_ms = 64;
+module_param(frame_boost_timeout_ms, uint, 0644);
+
+static unsigned int frame_boost_target_us = 16667;
+module_param(frame_boost_target_us, uint, 0644);
+
+#define FRAME_SCALE_SHIFT	10
+#define FRAME_SCALE		(1 << FRAME_SCALE_SHIFT)
+
+static DEFINE_SPINLOCK(frame_boost_lock);
+static bool frame_boost_active;
+static unsigned int frames_left;
+static unsigned int frame_time_avg;
+static unsigned int frame_scale = FRAME_SCALE;
+static struct work_struct frame_boost_work;
+
 static int set_input_boost_freq(const char *buf, const struct kernel_param *kp)
 {
 	int i, ntokens = 0;
@@ -259,7 +289,12 @@ static void do_input_boost_rem(struct work_struct *work)
 {
 	unsigned int i, ret;
 	struct cpu_sync *i_sync_info;
+	unsigned long flags;
 
+	spin_lock_irqsave(&frame_boost_lock, flags);
+	frame_boost_active = false;
+	frame_scale = FRAME_SCALE;
+	spin_unlock_irqrestore(&frame_boost_lock, flags);
 	
 	pr_debug("Resetting input boost min for all CPUs\n");
 	for_each_possible_cpu(i) {
@@ -379,11 +414,51 @@ static struct notifier_block boost_migration_nb = {
 	.notifier_call = boost_migration_notify,
 };
 
-static int do_input_boost(void *data)
+/*
+ * Apply the input boost of the first online cpu in @mask to its policy,
+ * scaled by @scale/FRAME_SCALE and capped at the hardware maximum.
+ * Called with cpu hotplug locked.
+ */
+static int apply_input_boost(const struct cpumask *mask, unsigned int scale)
 {
 	struct cpu_sync *i_sync_info, *cpu_sync_info;
 	struct cpufreq_policy policy;
+	unsigned int freq, old_min;
 	int ret, i, cpu;
+
+	for_each_online_cpu(i) {
+		if (!cpumask_test_cpu(i, mask))
+			continue;
+
+		ret = cpufreq_get_policy(&policy, i);
+		if (ret)
+			return ret;
+
+		cpu = policy.cpu;
+		i_sync_info = &per_cpu(sync_info, i);
+		cpu_sync_info = &per_cpu(sync_info, cpu);
+
+		freq = i_sync_info->input_boost_freq;
+		if (freq && scale > FRAME_SCALE)
+			freq = min_t(u64, policy.cpuinfo.max_freq,
+				     ((u64)freq * scale) >> FRAME_SCALE_SHIFT);
+
+		old_min = cpu_sync_info->input_boost_min;
+		cpu_sync_info->input_boost_min = freq;
+
+		if (policy.min < freq || freq < old_min)
+			cpufreq_update_policy(i);
+
+		if (freq)
+			break;
+	}
+
+	return 0;
+}
+
+static int do_input_boost(void *data)
+{
+	int ret;
 	struct cpumask *mask = (struct cpumask *)data;
 
 	while (1) {
@@ -397,24 +472,9 @@ static int do_input_boost(void *data)
 
 		get_online_cpus();
 
-		for_each_online_cpu(i) {
-			if (cpumask_test_cpu(i, mask)) {
-				ret = cpufreq_get_policy(&policy, i);
-				if (ret)
-					goto bail_incorrect_governor;
-
-				cpu = policy.cpu;
-				i_sync_info = &per_cpu(sync_info, i);
-				cpu_sync_info = &per_cpu(sync_info, cpu);
-				cpu_sync_info->input_boost_min = i_sync_info->input_boost_freq;
-
-				if (policy.min < cpu_sync_info->input_boost_min)
-					cpufreq_update_policy(i);
-
-				if (cpu_sync_info->input_boost_min)
-					break;
-			}
-		}
+		ret = apply_input_boost(mask, FRAME_SCALE);
+		if (ret)
+			goto bail_incorrect_governor;
 
 		
 		if (sched_boost_on_input) {
@@ -432,6 +492,21 @@ bail_incorrect_governor:
 	return 0;
 }
 
+static ATOMIC_NOTIFIER_HEAD(cpu_boost_notifier_head);
+
+/* Lets other drivers, e.g. storage, follow the input boost */
+int cpu_boost_register_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_register(&cpu_boost_notifier_head, nb);
+}
+EXPORT_SYMBOL(cpu_boost_register_notifier);
+
+int cpu_boost_unregister_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_unregister(&cpu_boost_notifier_head, nb);
+}
+EXPORT_SYMBOL(cpu_boost_unregister_notifier);
+
 static void cpuboost_input_event(struct input_handle *handle,
 		unsigned int type, unsigned int code, int value)
 {
@@ -466,9 +541,25 @@ static void cpuboost_input_event(struct input_handle *handle,
 	if (wake_lc)
 		wake_up_process(up_task[1]);
 
-	queue_delayed_work(cpu_boost_wq, &input_boost_rem, msecs_to_jiffies(input_boost_ms));
+	if (frame_boost_frames) {
+		unsigned long flags;
+
+		spin_lock_irqsave(&frame_boost_lock, flags);
+		frame_boost_active = true;
+		frames_left = frame_boost_frames;
+		spin_unlock_irqrestore(&frame_boost_lock, flags);
+
+		queue_delayed_work(cpu_boost_wq, &input_boost_rem,
+				   msecs_to_jiffies(frame_boost_timeout_ms));
+	} else {
+		queue_delayed_work(cpu_boost_wq, &input_boost_rem,
+				   msecs_to_jiffies(input_boost_ms));
+	}
 
 	last_input_time = ktime_to_us(ktime_get());
+
+	atomic_notifier_call_chain(&cpu_boost_notifier_head, CPU_BOOST_INPUT,
+				   &input_boost_ms);
 }
 
 static int cpuboost_input_connect(struct input_handler *handler,
@@ -542,6 +633,76 @@ static struct input_handler cpuboost_input_handler = {
 	.id_table       = cpuboost_ids,
 };
 
+static void do_frame_boost(struct work_struct *work)
+{
+	unsigned long flags;
+	unsigned int scale;
+	bool active;
+
+	spin_lock_irqsave(&frame_boost_lock, flags);
+	active = frame_boost_active;
+	scale = frame_scale;
+	spin_unlock_irqrestore(&frame_boost_lock, flags);
+
+	if (!active)
+		return;
+
+	get_online_cpus();
+	if (wake_bc)
+		apply_input_boost((struct cpumask *)&big_cluster_mask, scale);
+	if (wake_lc)
+		apply_input_boost((struct cpumask *)&little_cluster_mask, scale);
+	put_online_cpus();
+}
+
+static int cpuboost_frame_notify(struct notifier_block *nb,
+				 unsigned long event, void *data)
+{
+	unsigned long flags, delay;
+	unsigned int scale, old_scale;
+	u64 frame_us;
+
+	spin_lock_irqsave(&frame_boost_lock, flags);
+	if (!frame_boost_active || !frame_boost_frames) {
+		spin_unlock_irqrestore(&frame_boost_lock, flags);
+		return NOTIFY_OK;
+	}
+
+	if (event == MDSS_FB_FRAME_IDLE) {
+		spin_unlock_irqrestore(&frame_boost_lock, flags);
+		mod_delayed_work(cpu_boost_wq, &input_boost_rem, 0);
+		return NOTIFY_OK;
+	}
+
+	/* The first frame after a pause says nothing about frame time */
+	frame_us = *(u64 *)data;
+	if (frame_us < frame_boost_timeout_ms * USEC_PER_MSEC)
+		frame_time_avg = frame_time_avg ?
+			(3 * frame_time_avg + frame_us) / 4 : frame_us;
+
+	old_scale = frame_scale;
+	scale = FRAME_SCALE;
+	if (frame_boost_target_us && frame_time_avg > frame_boost_target_us)
+		scale = (frame_time_avg << FRAME_SCALE_SHIFT) /
+			frame_boost_target_us;
+	frame_scale = scale;
+
+	delay = msecs_to_jiffies(frame_boost_timeout_ms);
+	if (frames_left && !--frames_left)
+		delay = 0;
+	spin_unlock_irqrestore(&frame_boost_lock, flags);
+
+	mod_delayed_work(cpu_boost_wq, &input_boost_rem, delay);
+	if (delay && scale != old_scale)
+		queue_work(cpu_boost_wq, &frame_boost_work);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block cpuboost_frame_nb = {
+	.notifier_call = cpuboost_frame_notify,
+};
+
 static int cpu_boost_init(void)
 {
 	int cpu, ret;
@@ -556,6 +717,7 @@ static int cpu_boost_init(void)
 		return -EFAULT;
 
 	INIT_DELAYED_WORK(&input_boost_rem, do_input_boost_rem);
+	INIT_WORK(&frame_boost_work, do_frame_boost);
 
 	for_each_possible_cpu(cpu) {
 		s = &per_cpu(sync_info, cpu);
@@ -581,6 +743,7 @@ static int cpu_boost_init(void)
 	atomic_notifier_chain_register(&migration_notifier_head,
 					&boost_migration_nb);
 	ret = input_register_handler(&cpuboost_input_handler);
+	mdss_fb_register_frame_notifier(&cpuboost_frame_nb);
 
 	return 0;
 }
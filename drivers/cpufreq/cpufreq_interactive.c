@@ -396,6 +396,7 @@ static void __cpufreq_interactive_timer(unsigned long data, bool is_notif)
 	bool skip_hispeed_logic, skip_min_sample_time;
 	bool policy_max_fast_restore = false;
 	bool jump_to_max = false;
+	unsigned int task_floor_freq = 0;
 
 	if (!down_read_trylock(&ppol->enable_sem))
 		return;
@@ -425,6 +426,7 @@ static void __cpufreq_interactive_timer(unsigned long data, bool is_notif)
 			if (sl->prev_load)
 				new_load_pct = sl->new_task_load * 100 /
 						sl->prev_load;
+			task_floor_freq = max(task_floor_freq, sl->min_freq);
 		} else {
 			now = update_load(i);
 			delta_time = (unsigned int)
@@ -488,7 +490,11 @@ static void __cpufreq_interactive_timer(unsigned long data, bool is_notif)
 	    tunables->max_freq_hysteresis)
 		new_freq = max(tunables->hispeed_freq, new_freq);
 
+	/* Honour the floors of latency critical tasks runnable here */
+	new_freq = max(new_freq, task_floor_freq);
+
 	if (!skip_hispeed_logic &&
+	    ppol->target_freq >= task_floor_freq &&
 	    ppol->target_freq >= tunables->hispeed_freq &&
 	    new_freq > ppol->target_freq &&
 	    now - ppol->hispeed_validate_time <
@@ -671,6 +677,8 @@ static int load_change_callback(struct notifier_block *nb, unsigned long val,
 
 	if (speedchange_task == current)
 		return 0;
+	if (val != LOAD_ALERT_FREQ_CHANGE)
+		return 0;
 	if (!ppol || ppol->reject_notification)
 		return 0;
 
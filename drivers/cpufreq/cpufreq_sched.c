@@ -0,0 +1,462 @@
+/*
+ * drivers/cpufreq/cpufreq_sched.c
+ *
+ * Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * 'sched' governor: picks frequency straight from the scheduler's window
+ * based busy time. The scheduler alerts the governor when a window rolls
+ * over, when load moves between frequency domains and when a heavy task
+ * wakes up, so frequency follows load without waiting for a sampling
+ * timer. A deferrable timer one window long is kept only as a backstop
+ * for cpus that stop ticking.
+ */
+
+#include <linux/cpu.h>
+#include <linux/cpumask.h>
+#include <linux/cpufreq.h>
+#include <linux/init.h>
+#include <linux/kthread.h>
+#include <linux/mutex.h>
+#include <linux/notifier.h>
+#include <linux/rwsem.h>
+#include <linux/sched.h>
+#include <linux/sched/rt.h>
+#include <linux/slab.h>
+#include <linux/timer.h>
+
+struct cpufreq_sched_policyinfo {
+	struct cpufreq_policy *policy;
+	struct sched_load *sl;
+	struct timer_list timer;
+	struct rw_semaphore enable_sem;
+	int governor_enabled;
+	unsigned int target_freq;
+	u64 down_validate_time;
+};
+
+static DEFINE_PER_CPU(struct cpufreq_sched_policyinfo *, polinfo);
+
+static struct task_struct *speedchange_task;
+static cpumask_t speedchange_cpumask;
+static DEFINE_SPINLOCK(speedchange_cpumask_lock);
+static DEFINE_MUTEX(gov_lock);
+static int usage_count;
+
+/* Busy percentage of a window the chosen frequency should run at */
+#define DEFAULT_TARGET_LOAD 90
+static unsigned int target_load = DEFAULT_TARGET_LOAD;
+
+/* Minimum time a frequency is held before ramping down, in usecs */
+#define DEFAULT_DOWN_DELAY (20 * USEC_PER_MSEC)
+static unsigned int down_delay_us = DEFAULT_DOWN_DELAY;
+
+/* Scheduler window size, in usecs */
+#define DEFAULT_WINDOW_SIZE (20 * USEC_PER_MSEC)
+static unsigned int window_us = DEFAULT_WINDOW_SIZE;
+
+static int set_window_helper(void)
+{
+	return sched_set_window(get_jiffies_64(), usecs_to_jiffies(window_us));
+}
+
+static void cpufreq_sched_kick(struct cpufreq_sched_policyinfo *ppol)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&speedchange_cpumask_lock, flags);
+	cpumask_set_cpu(cpumask_first(ppol->policy->related_cpus),
+			&speedchange_cpumask);
+	spin_unlock_irqrestore(&speedchange_cpumask_lock, flags);
+
+	wake_up_process(speedchange_task);
+}
+
+static void cpufreq_sched_timer(unsigned long data)
+{
+	struct cpufreq_sched_policyinfo *ppol = per_cpu(polinfo, data);
+
+	if (ppol)
+		cpufreq_sched_kick(ppol);
+}
+
+static void cpufreq_sched_timer_resched(struct cpufreq_sched_policyinfo *ppol)
+{
+	mod_timer(&ppol->timer, jiffies + usecs_to_jiffies(window_us));
+}
+
+/*
+ * Frequency at which the busiest cpu in the policy would have been
+ * target_load percent busy over the last window. prev_load is already
+ * scaled by the scheduler to the policy's maximum frequency and includes
+ * the predicted demand of heavy tasks that woke up in this window. The
+ * result is raised to the highest floor of the tasks runnable in the
+ * policy.
+ */
+static unsigned int cpufreq_sched_choose_freq(
+				struct cpufreq_sched_policyinfo *ppol)
+{
+	struct cpufreq_policy *policy = ppol->policy;
+	unsigned long max_load = 0;
+	unsigned int floor_freq = 0;
+	int i, fcpu = cpumask_first(policy->related_cpus);
+	u64 freq;
+
+	sched_get_cpus_busy(ppol->sl, policy->related_cpus);
+
+	for_each_cpu(i, policy->cpus) {
+		max_load = max(max_load, ppol->sl[i - fcpu].prev_load);
+		floor_freq = max(floor_freq, ppol->sl[i - fcpu].min_freq);
+	}
+
+	freq = (u64)max_load * policy->cpuinfo.max_freq * 100;
+	do_div(freq, window_us * target_load);
+	freq = max_t(u64, freq, floor_freq);
+
+	return clamp_t(unsigned int, freq, policy->min, policy->max);
+}
+
+static void cpufreq_sched_evaluate(struct cpufreq_sched_policyinfo *ppol)
+{
+	struct cpufreq_policy *policy;
+	unsigned int new_freq;
+	u64 now;
+
+	if (!down_read_trylock(&ppol->enable_sem))
+		return;
+	if (!ppol->governor_enabled)
+		goto exit;
+
+	policy = ppol->policy;
+	new_freq = cpufreq_sched_choose_freq(ppol);
+	now = ktime_to_us(ktime_get());
+
+	if (new_freq >= ppol->target_freq) {
+		ppol->down_validate_time = now;
+	} else if (now - ppol->down_validate_time < down_delay_us) {
+		goto resched;
+	}
+
+	ppol->target_freq = new_freq;
+	if (ppol->target_freq != policy->cur)
+		__cpufreq_driver_target(policy, ppol->target_freq,
+					CPUFREQ_RELATION_L);
+
+resched:
+	cpufreq_sched_timer_resched(ppol);
+exit:
+	up_read(&ppol->enable_sem);
+}
+
+static int cpufreq_sched_speedchange_task(void *data)
+{
+	unsigned int cpu;
+	cpumask_t tmp_mask;
+	unsigned long flags;
+
+	while (1) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		spin_lock_irqsave(&speedchange_cpumask_lock, flags);
+
+		if (cpumask_empty(&speedchange_cpumask)) {
+			spin_unlock_irqrestore(&speedchange_cpumask_lock,
+					       flags);
+			schedule();
+
+			if (kthread_should_stop())
+				break;
+
+			spin_lock_irqsave(&speedchange_cpumask_lock, flags);
+		}
+
+		set_current_state(TASK_RUNNING);
+		tmp_mask = speedchange_cpumask;
+		cpumask_clear(&speedchange_cpumask);
+		spin_unlock_irqrestore(&speedchange_cpumask_lock, flags);
+
+		for_each_cpu(cpu, &tmp_mask)
+			cpufreq_sched_evaluate(per_cpu(polinfo, cpu));
+	}
+
+	return 0;
+}
+
+static int load_alert_callback(struct notifier_block *nb, unsigned long val,
+			       void *data)
+{
+	unsigned long cpu = (unsigned long) data;
+	struct cpufreq_sched_policyinfo *ppol = per_cpu(polinfo, cpu);
+
+	/* Our own frequency changes must not feed back into us */
+	if (speedchange_task == current)
+		return 0;
+	if (!ppol || !ppol->governor_enabled)
+		return 0;
+
+	cpufreq_sched_kick(ppol);
+	return 0;
+}
+
+static struct notifier_block load_alert_notifier_block = {
+	.notifier_call = load_alert_callback,
+};
+
+#define show_one(name)							\
+static ssize_t show_##name(struct kobject *kobj,			\
+			   struct attribute *attr, char *buf)		\
+{									\
+	return snprintf(buf, PAGE_SIZE, "%u\n", name);			\
+}
+
+show_one(target_load);
+show_one(down_delay_us);
+show_one(window_us);
+
+static ssize_t store_target_load(struct kobject *kobj,
+				 struct attribute *attr, const char *buf,
+				 size_t count)
+{
+	unsigned int val;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &val);
+	if (ret < 0)
+		return ret;
+	if (!val || val > 100)
+		return -EINVAL;
+
+	target_load = val;
+	return count;
+}
+
+static ssize_t store_down_delay_us(struct kobject *kobj,
+				   struct attribute *attr, const char *buf,
+				   size_t count)
+{
+	unsigned int val;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &val);
+	if (ret < 0)
+		return ret;
+
+	down_delay_us = val;
+	return count;
+}
+
+static ssize_t store_window_us(struct kobject *kobj,
+			       struct attribute *attr, const char *buf,
+			       size_t count)
+{
+	unsigned int val, old;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &val);
+	if (ret < 0)
+		return ret;
+
+	mutex_lock(&gov_lock);
+	old = window_us;
+	window_us = val;
+	ret = set_window_helper();
+	if (ret)
+		window_us = old;
+	mutex_unlock(&gov_lock);
+
+	return ret ? ret : count;
+}
+
+define_one_global_rw(target_load);
+define_one_global_rw(down_delay_us);
+define_one_global_rw(window_us);
+
+static struct attribute *cpufreq_sched_attributes[] = {
+	&target_load.attr,
+	&down_delay_us.attr,
+	&window_us.attr,
+	NULL,
+};
+
+static struct attribute_group cpufreq_sched_attr_group = {
+	.attrs = cpufreq_sched_attributes,
+	.name = "sched",
+};
+
+static struct cpufreq_sched_policyinfo *get_policyinfo(
+					struct cpufreq_policy *policy)
+{
+	struct cpufreq_sched_policyinfo *ppol = per_cpu(polinfo, policy->cpu);
+	struct sched_load *sl;
+	int i;
+
+	/* Reuse what the last governor instance left behind */
+	if (ppol)
+		return ppol;
+
+	ppol = kzalloc(sizeof(*ppol), GFP_KERNEL);
+	if (!ppol)
+		return ERR_PTR(-ENOMEM);
+
+	sl = kcalloc(cpumask_weight(policy->related_cpus), sizeof(*sl),
+		     GFP_KERNEL);
+	if (!sl) {
+		kfree(ppol);
+		return ERR_PTR(-ENOMEM);
+	}
+	ppol->sl = sl;
+
+	init_timer_deferrable(&ppol->timer);
+	ppol->timer.function = cpufreq_sched_timer;
+	init_rwsem(&ppol->enable_sem);
+
+	for_each_cpu(i, policy->related_cpus)
+		per_cpu(polinfo, i) = ppol;
+	return ppol;
+}
+
+static int cpufreq_sched_policy_init(struct cpufreq_policy *policy)
+{
+	struct cpufreq_sched_policyinfo *ppol;
+	int rc;
+
+	ppol = get_policyinfo(policy);
+	if (IS_ERR(ppol))
+		return PTR_ERR(ppol);
+
+	mutex_lock(&gov_lock);
+	if (usage_count++)
+		goto out;
+
+	rc = set_window_helper();
+	if (rc) {
+		pr_err("%s: Failed to set sched window\n", __func__);
+		goto fail;
+	}
+
+	WARN_ON(cpufreq_get_global_kobject());
+	rc = sysfs_create_group(cpufreq_global_kobject,
+				&cpufreq_sched_attr_group);
+	if (rc) {
+		cpufreq_put_global_kobject();
+		goto fail;
+	}
+
+	atomic_notifier_chain_register(&load_alert_notifier_head,
+				       &load_alert_notifier_block);
+out:
+	mutex_unlock(&gov_lock);
+	return 0;
+fail:
+	usage_count--;
+	mutex_unlock(&gov_lock);
+	return rc;
+}
+
+static void cpufreq_sched_policy_exit(struct cpufreq_policy *policy)
+{
+	mutex_lock(&gov_lock);
+	if (!--usage_count) {
+		atomic_notifier_chain_unregister(&load_alert_notifier_head,
+						 &load_alert_notifier_block);
+		sysfs_remove_group(cpufreq_global_kobject,
+				   &cpufreq_sched_attr_group);
+		cpufreq_put_global_kobject();
+	}
+	mutex_unlock(&gov_lock);
+}
+
+static int cpufreq_governor_sched(struct cpufreq_policy *policy,
+				  unsigned int event)
+{
+	struct cpufreq_sched_policyinfo *ppol;
+
+	switch (event) {
+	case CPUFREQ_GOV_POLICY_INIT:
+		return cpufreq_sched_policy_init(policy);
+
+	case CPUFREQ_GOV_POLICY_EXIT:
+		cpufreq_sched_policy_exit(policy);
+		break;
+
+	case CPUFREQ_GOV_START:
+		ppol = per_cpu(polinfo, policy->cpu);
+
+		down_write(&ppol->enable_sem);
+		ppol->policy = policy;
+		ppol->target_freq = policy->cur;
+		ppol->down_validate_time = ktime_to_us(ktime_get());
+		ppol->timer.data = policy->cpu;
+		ppol->timer.expires = jiffies + usecs_to_jiffies(window_us);
+		add_timer_on(&ppol->timer, policy->cpu);
+		ppol->governor_enabled = 1;
+		up_write(&ppol->enable_sem);
+		break;
+
+	case CPUFREQ_GOV_STOP:
+		ppol = per_cpu(polinfo, policy->cpu);
+
+		down_write(&ppol->enable_sem);
+		ppol->governor_enabled = 0;
+		ppol->target_freq = 0;
+		del_timer_sync(&ppol->timer);
+		up_write(&ppol->enable_sem);
+		break;
+
+	case CPUFREQ_GOV_LIMITS:
+		ppol = per_cpu(polinfo, policy->cpu);
+
+		down_read(&ppol->enable_sem);
+		if (ppol->governor_enabled) {
+			ppol->target_freq = clamp(ppol->target_freq,
+						  policy->min, policy->max);
+			__cpufreq_driver_target(policy, ppol->target_freq,
+						CPUFREQ_RELATION_L);
+		}
+		up_read(&ppol->enable_sem);
+		break;
+	}
+
+	return 0;
+}
+
+#ifndef CONFIG_CPU_FREQ_DEFAULT_GOV_SCHED
+static
+#endif
+struct cpufreq_governor cpufreq_gov_sched = {
+	.name = "sched",
+	.governor = cpufreq_governor_sched,
+	.max_transition_latency = 10000000,
+	.owner = THIS_MODULE,
+};
+
+static int __init cpufreq_sched_init(void)
+{
+	struct sched_param param = { .sched_priority = MAX_RT_PRIO-1 };
+
+	speedchange_task = kthread_create(cpufreq_sched_speedchange_task,
+					  NULL, "cfsched");
+	if (IS_ERR(speedchange_task))
+		return PTR_ERR(speedchange_task);
+
+	sched_setscheduler_nocheck(speedchange_task, SCHED_FIFO, &param);
+	get_task_struct(speedchange_task);
+
+	/* Park the thread in its loop until there is work for it */
+	wake_up_process(speedchange_task);
+
+	return cpufreq_register_governor(&cpufreq_gov_sched);
+}
+
+#ifdef CONFIG_CPU_FREQ_DEFAULT_GOV_SCHED
+arch_initcall(cpufreq_sched_init);
+#else
+device_initcall(cpufreq_sched_init);
+#endif
@@ -17,6 +17,10 @@
 #include <linux/of.h>
 #include <linux/sched.h>
 #include <linux/cputime.h>
+#include <linux/cred.h>
+#include <linux/hashtable.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
 
 static spinlock_t cpufreq_stats_lock;
 
@@ -57,6 +61,28 @@ static DEFINE_PER_CPU(struct all_cpufreq_stats *, all_cpufreq_stats);
 static DEFINE_PER_CPU(struct cpufreq_stats *, cpufreq_stats_table);
 static DEFINE_PER_CPU(struct cpufreq_power_stats *, cpufreq_power_stats);
 
+/*
+ * Per-uid time in state. Every distinct frequency of any policy gets a
+ * slot the first time it is seen; slots never move, so uid entries can be
+ * updated without coordinating with frequency table changes. The hot path
+ * is an RCU hash lookup and an atomic add; uid_lock only serializes
+ * insertion of new uids.
+ */
+#define UID_HASH_BITS	10
+#define MAX_UID_FREQS	64
+
+struct uid_entry {
+	uid_t uid;
+	struct hlist_node hash;
+	atomic64_t time_in_state[MAX_UID_FREQS];
+};
+
+static DECLARE_HASHTABLE(uid_hash_table, UID_HASH_BITS);
+static DEFINE_SPINLOCK(uid_lock);
+static unsigned int uid_freqs[MAX_UID_FREQS];
+static unsigned int uid_freqs_count;
+static DEFINE_PER_CPU(int, uid_freq_slot) = -1;
+
 struct cpufreq_stats_attribute {
 	struct attribute attr;
 	ssize_t(*show) (struct cpufreq_stats *, char *);
@@ -126,6 +152,83 @@ static int get_index_all_cpufreq_stat(struct all_cpufreq_stats *all_stat,
 	return -1;
 }
 
+/* Called with cpufreq_stats_lock held */
+static void uid_set_freq_slot(unsigned int cpu, unsigned int freq)
+{
+	int i;
+
+	for (i = 0; i < uid_freqs_count; i++) {
+		if (uid_freqs[i] == freq)
+			goto found;
+	}
+
+	if (uid_freqs_count == MAX_UID_FREQS) {
+		pr_warn_once("cpufreq_stats: too many frequencies for uid stats\n");
+		per_cpu(uid_freq_slot, cpu) = -1;
+		return;
+	}
+
+	uid_freqs[uid_freqs_count] = freq;
+	/* Publish the frequency before a reader can see the slot in use */
+	smp_wmb();
+	i = uid_freqs_count++;
+found:
+	per_cpu(uid_freq_slot, cpu) = i;
+}
+
+static struct uid_entry *find_uid_entry(uid_t uid)
+{
+	struct uid_entry *uid_entry;
+
+	hash_for_each_possible_rcu(uid_hash_table, uid_entry, hash, uid) {
+		if (uid_entry->uid == uid)
+			return uid_entry;
+	}
+	return NULL;
+}
+
+static struct uid_entry *find_or_register_uid(uid_t uid)
+{
+	struct uid_entry *uid_entry;
+	unsigned long flags;
+
+	uid_entry = find_uid_entry(uid);
+	if (likely(uid_entry))
+		return uid_entry;
+
+	spin_lock_irqsave(&uid_lock, flags);
+	uid_entry = find_uid_entry(uid);
+	if (!uid_entry) {
+		uid_entry = kzalloc(sizeof(*uid_entry), GFP_ATOMIC);
+		if (uid_entry) {
+			uid_entry->uid = uid;
+			hash_add_rcu(uid_hash_table, &uid_entry->hash, uid);
+		}
+	}
+	spin_unlock_irqrestore(&uid_lock, flags);
+
+	return uid_entry;
+}
+
+static void uid_update_time_in_state(struct task_struct *task,
+				     unsigned int cpu, cputime_t cputime)
+{
+	struct uid_entry *uid_entry;
+	int slot = per_cpu(uid_freq_slot, cpu);
+	uid_t uid;
+
+	if (slot < 0)
+		return;
+
+	rcu_read_lock();
+	uid = from_kuid_munged(&init_user_ns, task_uid(task));
+	uid_entry = find_or_register_uid(uid);
+	if (uid_entry)
+		atomic64_add((__force u64)cputime,
+			     &uid_entry->time_in_state[slot]);
+	rcu_read_unlock();
+}
+
 void acct_update_power(struct task_struct *task, cputime_t cputime) {
 	struct cpufreq_power_stats *powerstats;
 	struct cpufreq_stats *stats;
@@ -134,6 +237,7 @@ void acct_update_power(struct task_struct *task, cputime_t cputime) {
 	if (!task)
 		return;
 	cpu_num = task_cpu(task);
+	uid_update_time_in_state(task, cpu_num, cputime);
 	powerstats = per_cpu(cpufreq_power_stats, cpu_num);
 	stats = per_cpu(cpufreq_stats_table, cpu_num);
 	if (!powerstats || !stats)
@@ -404,6 +508,8 @@ static int __cpufreq_stats_create_table(struct cpufreq_policy *policy,
 	spin_lock(&cpufreq_stats_lock);
 	stat->last_time = get_jiffies_64();
 	stat->last_index = freq_table_get_index(stat, policy->cur);
+	for_each_cpu(i, policy->cpus)
+		uid_set_freq_slot(i, policy->cur);
 	spin_unlock(&cpufreq_stats_lock);
 	return 0;
 error_alloc:
@@ -650,6 +756,10 @@ static int cpufreq_stat_notifier_trans(struct notifier_block *nb,
 
 	cpufreq_stats_update(freq->cpu);
 
+	spin_lock(&cpufreq_stats_lock);
+	uid_set_freq_slot(freq->cpu, freq->new);
+	spin_unlock(&cpufreq_stats_lock);
+
 	if (old_index == new_index)
 		return 0;
 
@@ -663,6 +773,57 @@ static int cpufreq_stat_notifier_trans(struct notifier_block *nb,
 	return 0;
 }
 
+static int uid_freq_cmp(const void *lhs, const void *rhs)
+{
+	unsigned int l = uid_freqs[*(const int *)lhs];
+	unsigned int r = uid_freqs[*(const int *)rhs];
+
+	return l < r ? -1 : l > r;
+}
+
+static int uid_time_in_state_show(struct seq_file *m, void *v)
+{
+	struct uid_entry *uid_entry;
+	int order[MAX_UID_FREQS];
+	unsigned int i, count, bkt;
+
+	count = ACCESS_ONCE(uid_freqs_count);
+	smp_rmb();
+	for (i = 0; i < count; i++)
+		order[i] = i;
+	sort(order, count, sizeof(order[0]), uid_freq_cmp, NULL);
+
+	seq_puts(m, "uid:");
+	for (i = 0; i < count; i++)
+		seq_printf(m, " %u", uid_freqs[order[i]]);
+	seq_putc(m, '\n');
+
+	rcu_read_lock();
+	hash_for_each_rcu(uid_hash_table, bkt, uid_entry, hash) {
+		seq_printf(m, "%d:", uid_entry->uid);
+		for (i = 0; i < count; i++)
+			seq_printf(m, " %llu", (unsigned long long)
+				cputime64_to_clock_t(atomic64_read(
+				&uid_entry->time_in_state[order[i]])));
+		seq_putc(m, '\n');
+	}
+	rcu_read_unlock();
+
+	return 0;
+}
+
+static int uid_time_in_state_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, uid_time_in_state_show, NULL);
+}
+
+static const struct file_operations uid_time_in_state_fops = {
+	.open		= uid_time_in_state_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static struct notifier_block notifier_policy_block = {
 	.notifier_call = cpufreq_stat_notifier_policy
 };
@@ -707,6 +868,10 @@ static int __init cpufreq_stats_init(void)
 	if (ret)
 		pr_warn("Cannot create sysfs file for cpufreq current stats\n");
 
+	if (!proc_create("uid_time_in_state", 0444, NULL,
+			 &uid_time_in_state_fops))
+		pr_warn("Cannot create proc file for uid time in state\n");
+
 	return 0;
 }
 static void __exit cpufreq_stats_exit(void)
@@ -722,6 +887,7 @@ static void __exit cpufreq_stats_exit(void)
 	cpufreq_allstats_free();
 	cpufreq_powerstats_free();
 	cpufreq_put_global_kobject();
+	remove_proc_entry("uid_time_in_state", NULL);
 }
 
 MODULE_AUTHOR("Zou Nan hai <nanhai.zou@intel.com>");
@@ -40,6 +40,7 @@
 #include <soc/qcom/rpm-notifier.h>
 #include <soc/qcom/event_timer.h>
 #include <soc/qcom/lpm-stats.h>
+#include <soc/qcom/lpm-sync.h>
 #include <soc/qcom/jtag.h>
 #include <asm/cputype.h>
 #include <asm/arch_timer.h>
@@ -150,10 +151,59 @@ module_param_named(
 	print_parsed_dt, print_parsed_dt, bool, S_IRUGO | S_IWUSR | S_IWGRP
 );
 
+/*
+ * Wakeup history used to predict the next idle duration. Interrupt and
+ * IPI driven wakeups are invisible to the timer based sleep length, so
+ * the recent residencies are used to cap it when they agree with each
+ * other.
+ */
+#define LPM_HISTORY_SAMPLES 8
+
+struct lpm_history {
+	uint32_t resi[LPM_HISTORY_SAMPLES];
+	int nsamp;
+	int hptr;
+	uint64_t predicted_wake_us;
+};
+
+static DEFINE_PER_CPU(struct lpm_history, lpm_hist);
+
+static bool lpm_prediction = true;
+module_param_named(
+	lpm_prediction, lpm_prediction, bool, S_IRUGO | S_IWUSR | S_IWGRP
+);
+
+static uint32_t ref_stddev = 500;
+module_param_named(
+	ref_stddev, ref_stddev, uint, S_IRUGO | S_IWUSR | S_IWGRP
+);
+
 static bool sleep_disabled;
 module_param_named(sleep_disabled,
 	sleep_disabled, bool, S_IRUGO | S_IWUSR | S_IWGRP);
 
+/*
+ * Periodic wakeup sources such as display vsync and the video codec.
+ * While one of them fires at a steady rate its next occurrence bounds the
+ * cluster sleep, instead of the wakeup history which is skewed by the
+ * bursts of interrupts around each frame.
+ */
+#define LPM_SYNC_MAX_PERIOD_US	100000
+
+struct lpm_sync {
+	uint64_t last_us;
+	uint32_t period_us;
+	uint32_t jitter_us;
+};
+
+static struct lpm_sync lpm_sync[LPM_SYNC_NR];
+static DEFINE_SPINLOCK(lpm_sync_lock);
+
+static bool lpm_sync_enable = true;
+module_param_named(
+	sync_enable, lpm_sync_enable, bool, S_IRUGO | S_IWUSR | S_IWGRP
+);
+
 s32 msm_cpuidle_get_deep_idle_latency(void)
 {
 	return 10;
@@ -351,6 +401,69 @@ static int set_device_mode(struct lpm_cluster *cluster, int ndevice,
 		return -EINVAL;
 }
 
+/*
+ * Return the typical recent idle duration, or 0 if the history is too
+ * short or too scattered to be trusted. Large outliers are discarded one
+ * at a time as long as three quarters of the samples remain.
+ */
+static uint32_t lpm_cpu_predict(struct lpm_history *history)
+{
+	uint32_t max, threshold = ~0U;
+	uint64_t avg, stddev;
+	int64_t diff;
+	int i, divisor;
+
+	if (history->nsamp < LPM_HISTORY_SAMPLES)
+		return 0;
+
+again:
+	max = 0;
+	avg = 0;
+	divisor = 0;
+	for (i = 0; i < LPM_HISTORY_SAMPLES; i++) {
+		uint32_t value = history->resi[i];
+
+		if (value <= threshold) {
+			avg += value;
+			divisor++;
+			if (value > max)
+				max = value;
+		}
+	}
+	do_div(avg, divisor);
+
+	stddev = 0;
+	for (i = 0; i < LPM_HISTORY_SAMPLES; i++) {
+		uint32_t value = history->resi[i];
+
+		if (value <= threshold) {
+			diff = (int64_t)value - (int64_t)avg;
+			stddev += diff * diff;
+		}
+	}
+	do_div(stddev, divisor);
+	stddev = int_sqrt(stddev);
+
+	if (stddev <= ref_stddev || avg > 6 * stddev)
+		return (uint32_t)avg;
+
+	if (divisor * 4 <= LPM_HISTORY_SAMPLES * 3)
+		return 0;
+
+	threshold = max - 1;
+	goto again;
+}
+
+static void lpm_update_history(struct lpm_history *history,
+		uint32_t residency_us)
+{
+	history->resi[history->hptr] = residency_us;
+	history->hptr = (history->hptr + 1) % LPM_HISTORY_SAMPLES;
+	if (history->nsamp < LPM_HISTORY_SAMPLES)
+		history->nsamp++;
+	history->predicted_wake_us = 0;
+}
+
 static int cpu_power_select(struct cpuidle_device *dev,
 		struct lpm_cpu *cpu)
 {
@@ -367,6 +480,8 @@ static int cpu_power_select(struct cpuidle_device *dev,
 	uint32_t lvl_latency_us = 0;
 	uint32_t lvl_overhead_us = 0;
 	uint32_t lvl_overhead_energy = 0;
+	struct lpm_history *history = &per_cpu(lpm_hist, dev->cpu);
+	uint32_t predicted_us;
 
 	if (!cpu)
 		return -EINVAL;
@@ -376,6 +491,16 @@ static int cpu_power_select(struct cpuidle_device *dev,
 
 	next_event_us = (uint32_t)(ktime_to_us(get_next_event_time(dev->cpu)));
 
+	history->predicted_wake_us = 0;
+	if (lpm_prediction) {
+		predicted_us = lpm_cpu_predict(history);
+		if (predicted_us && predicted_us < sleep_us) {
+			sleep_us = predicted_us;
+			history->predicted_wake_us =
+				ktime_to_us(ktime_get()) + predicted_us;
+		}
+	}
+
 	for (i = 0; i < cpu->nlevels; i++) {
 		struct lpm_cpu_level *level = &cpu->levels[i];
 		struct power_params *pwr_params = &level->pwr;
@@ -480,6 +605,89 @@ static uint64_t get_cluster_sleep_time(struct lpm_cluster *cluster,
 		return 0;
 }
 
+/*
+ * The cluster stays down until its first cpu wakes up, so its predicted
+ * sleep is the earliest predicted wakeup among the cpus in sync. Returns
+ * ~0ULL when none of them has a prediction.
+ */
+static uint64_t get_cluster_predicted_sleep(struct lpm_cluster *cluster)
+{
+	uint64_t now_us = ktime_to_us(ktime_get());
+	uint64_t wake_us, min_wake_us = ~0ULL;
+	int cpu;
+
+	for_each_cpu_and(cpu, &cluster->num_children_in_sync,
+			cpu_online_mask) {
+		wake_us = per_cpu(lpm_hist, cpu).predicted_wake_us;
+		if (wake_us && wake_us < min_wake_us)
+			min_wake_us = wake_us;
+	}
+
+	if (min_wake_us == ~0ULL)
+		return ~0ULL;
+
+	return min_wake_us > now_us ? min_wake_us - now_us : 0;
+}
+
+void lpm_sync_event(enum lpm_sync_source src)
+{
+	uint64_t now_us = ktime_to_us(ktime_get());
+	struct lpm_sync *sync;
+	uint32_t delta_us, err_us;
+	unsigned long flags;
+
+	if (src >= LPM_SYNC_NR)
+		return;
+
+	sync = &lpm_sync[src];
+	spin_lock_irqsave(&lpm_sync_lock, flags);
+	if (!sync->last_us || now_us - sync->last_us > LPM_SYNC_MAX_PERIOD_US) {
+		sync->period_us = 0;
+		sync->jitter_us = 0;
+	} else {
+		delta_us = (uint32_t)(now_us - sync->last_us);
+		if (!sync->period_us)
+			sync->period_us = delta_us;
+		err_us = abs((int32_t)(delta_us - sync->period_us));
+		sync->period_us = (3 * sync->period_us + delta_us) / 4;
+		sync->jitter_us = (3 * sync->jitter_us + err_us) / 4;
+	}
+	sync->last_us = now_us;
+	spin_unlock_irqrestore(&lpm_sync_lock, flags);
+}
+EXPORT_SYMBOL(lpm_sync_event);
+
+/*
+ * Time until the earliest expected occurrence of a periodic source, or
+ * ~0ULL when none is running steadily. A source is dropped once it
+ * misses two periods.
+ */
+static uint64_t lpm_sync_sleep_time(void)
+{
+	uint64_t now_us = ktime_to_us(ktime_get());
+	uint64_t next_us, elapsed_us, min_us = ~0ULL;
+	struct lpm_sync *sync;
+	int i;
+
+	spin_lock(&lpm_sync_lock);
+	for (i = 0; i < LPM_SYNC_NR; i++) {
+		sync = &lpm_sync[i];
+		if (!sync->period_us || sync->jitter_us > sync->period_us / 8)
+			continue;
+		elapsed_us = now_us - sync->last_us;
+		if (now_us < sync->last_us ||
+				elapsed_us > 2 * (uint64_t)sync->period_us)
+			continue;
+		next_us = sync->period_us -
+			(uint32_t)elapsed_us % sync->period_us;
+		if (next_us < min_us)
+			min_us = next_us;
+	}
+	spin_unlock(&lpm_sync_lock);
+
+	return min_us;
+}
+
 static int cluster_select(struct lpm_cluster *cluster, bool from_idle)
 {
 	int best_level = -1;
@@ -489,12 +697,26 @@ static int cluster_select(struct lpm_cluster *cluster, bool from_idle)
 	struct cpumask mask;
 	uint32_t latency_us = ~0U;
 	uint32_t sleep_us;
+	uint64_t sync_us = ~0ULL;
 
 	if (!cluster)
 		return -EINVAL;
 
 	sleep_us = (uint32_t)get_cluster_sleep_time(cluster, NULL, from_idle);
 
+	if (from_idle && lpm_sync_enable)
+		sync_us = lpm_sync_sleep_time();
+
+	if (sync_us != ~0ULL) {
+		if (sync_us < sleep_us)
+			sleep_us = (uint32_t)sync_us;
+	} else if (from_idle && lpm_prediction) {
+		uint64_t predicted_us = get_cluster_predicted_sleep(cluster);
+
+		if (predicted_us < sleep_us)
+			sleep_us = (uint32_t)predicted_us;
+	}
+
 	if (cpumask_and(&mask, cpu_online_mask, &cluster->child_cpus))
 		latency_us = pm_qos_request_for_cpumask(PM_QOS_CPU_DMA_LATENCY,
 							&mask);
@@ -608,6 +830,7 @@ static int cluster_configure(struct lpm_cluster *cluster, int idx,
 	sched_set_cluster_dstate(&cluster->child_cpus, idx, 0, 0);
 
 	cluster->last_level = idx;
+	cluster->enter_time_us = ktime_to_us(ktime_get());
 	return 0;
 
 failed_set_mode:
@@ -698,6 +921,11 @@ static void cluster_unprepare(struct lpm_cluster *cluster,
 	lpm_stats_cluster_exit(cluster->stats, cluster->last_level, true);
 
 	level = &cluster->levels[cluster->last_level];
+	if (ktime_to_us(ktime_get()) - cluster->enter_time_us <
+			level->pwr.time_overhead_us)
+		lpm_stats_cluster_mispredict(cluster->stats,
+				cluster->last_level);
+
 	if (level->notify_rpm) {
 		msm_rpm_exit_sleep();
 
@@ -1046,6 +1274,7 @@ static int lpm_cpuidle_enter(struct cpuidle_device *dev,
 	struct lpm_cpu_level *level;
 #endif
 	bool success = true;
+	bool entered = false;
 	const struct cpumask *cpumask = get_cpu_mask(dev->cpu);
 	int64_t start_time = ktime_to_ns(ktime_get()), end_time;
 	struct power_params *pwr_params;
@@ -1065,6 +1294,7 @@ static int lpm_cpuidle_enter(struct cpuidle_device *dev,
 
 	trace_cpu_idle_enter(idx);
 	lpm_stats_cpu_enter(idx);
+	entered = true;
 
 	if (!use_psci) {
 		if (idx > 0)
@@ -1096,7 +1326,15 @@ exit:
 	trace_cpu_idle_exit(idx, success);
 	trace_cpu_idle_rcuidle(PWR_EVENT_EXIT, dev->cpu);
 	end_time = ktime_to_ns(ktime_get()) - start_time;
-	dev->last_residency = do_div(end_time, 1000);
+	do_div(end_time, 1000);
+	dev->last_residency = end_time;
+
+	if (entered && success) {
+		lpm_update_history(&per_cpu(lpm_hist, dev->cpu),
+				(uint32_t)end_time);
+		if (idx > 0 && end_time < pwr_params->time_overhead_us)
+			lpm_stats_cpu_mispredict(idx);
+	}
 	local_irq_enable();
 
 	return idx;
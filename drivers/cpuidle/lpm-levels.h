@@ -100,6 +100,7 @@ struct lpm_cluster {
 	unsigned int psci_mode_shift;
 	unsigned int psci_mode_mask;
 	bool no_saw_devices;
+	uint64_t enter_time_us;
 };
 
 int set_l2_mode(struct low_power_ops *ops, int mode, bool notify_rpm);
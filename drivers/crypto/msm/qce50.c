@@ -66,8 +66,14 @@ static LIST_HEAD(qce50_bam_list);
 
 /* Used to determine the mode */
 #define MAX_BUNCH_MODE_REQ 2
-/* Max number of request supported */
-#define MAX_QCE_BAM_REQ 8
+/*
+ * Max number of request supported. In bunch mode only one request in
+ * SET_INTR_AT_REQ raises an interrupt, so a deeper queue means fewer
+ * interrupts per request. 12 keeps the descriptor FIFO sized for the
+ * worst case of QCE_MAX_NUM_DSCR descriptors per request below
+ * MAX_SPS_DESC_FIFO_SIZE.
+ */
+#define MAX_QCE_BAM_REQ 12
 /* Interrupt flag will be set for every SET_INTR_AT_REQ request */
 #define SET_INTR_AT_REQ			(MAX_QCE_BAM_REQ - 2)
 /* To create extra request space to hold dummy request */
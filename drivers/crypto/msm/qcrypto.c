@@ -51,7 +51,7 @@
 #include "qce.h"
 
 #define DEBUG_MAX_FNAME  16
-#define DEBUG_MAX_RW_BUF 2048
+#define DEBUG_MAX_RW_BUF 4096
 #define QCRYPTO_BIG_NUMBER 9999999 /* a big number */
 
 /*
@@ -61,6 +61,26 @@
 
 #define QCRYPTO_HIGH_BANDWIDTH_TIMEOUT 1000
 
+/*
+ * AES ECB/CBC/CTR requests smaller than sw_crossover bytes are handed to
+ * the software fallback (the ARMv8 CE instructions where present), as the
+ * BAM setup and interrupt cost more than the engine saves. While no
+ * engine holds a bus vote, requests below sw_cold_bytes also go to
+ * software rather than waiting for the vote. Larger requests always go to
+ * the engine and warm the bus up.
+ */
+static unsigned int sw_crossover = 512;
+module_param(sw_crossover, uint, S_IRUGO | S_IWUSR);
+static unsigned int sw_cold_bytes = 4096;
+module_param(sw_cold_bytes, uint, S_IRUGO | S_IWUSR);
+
+/*
+ * Requests in flight per engine, 0 uses the engine maximum. Read when an
+ * engine is probed.
+ */
+static unsigned int max_req_per_engine;
+module_param(max_req_per_engine, uint, S_IRUGO);
+
 
 
 /* Status of response workq */
@@ -113,6 +133,9 @@ struct crypto_stat {
 	u64 ablk_cipher_3des_dec;
 	u64 ablk_cipher_op_success;
 	u64 ablk_cipher_op_fail;
+	u64 ablk_cipher_aes_sw;
+	u64 ablk_cipher_aes_sw_bytes;
+	u64 ablk_cipher_aes_hw_bytes;
 	u64 sha1_digest;
 	u64 sha256_digest;
 	u64 sha1_hmac_digest;
@@ -390,7 +413,9 @@ struct qcrypto_cipher_ctx {
 
 	u8 ccm4309_nonce[QCRYPTO_CCM4309_NONCE_LEN];
 
+	/* software AES, for AES-192 without engine support and small reqs */
 	struct crypto_ablkcipher *cipher_aes192_fb;
+	bool fb_key_set;	/* cipher_aes192_fb holds the engine key */
 
 	struct crypto_ahash *ahash_aead_aes192_fb;
 };
@@ -1084,6 +1109,15 @@ static int _disp_stats(int id)
 	len += scnprintf(_debug_read_buf + len, DEBUG_MAX_RW_BUF - len - 1,
 			"   ABLK CIPHER operation fail          : %llu\n",
 					pstat->ablk_cipher_op_fail);
+	len += scnprintf(_debug_read_buf + len, DEBUG_MAX_RW_BUF - len - 1,
+			"   ABLK CIPHER AES software            : %llu\n",
+					pstat->ablk_cipher_aes_sw);
+	len += scnprintf(_debug_read_buf + len, DEBUG_MAX_RW_BUF - len - 1,
+			"   ABLK CIPHER AES software bytes      : %llu\n",
+					pstat->ablk_cipher_aes_sw_bytes);
+	len += scnprintf(_debug_read_buf + len, DEBUG_MAX_RW_BUF - len - 1,
+			"   ABLK CIPHER AES engine bytes        : %llu\n",
+					pstat->ablk_cipher_aes_hw_bytes);
 	len += scnprintf(_debug_read_buf + len, DEBUG_MAX_RW_BUF - len - 1,
 			"\n");
 
@@ -1294,6 +1328,26 @@ static int _qcrypto_setkey_aes_192_fallback(struct crypto_ablkcipher *cipher,
 	return ret;
 }
 
+/*
+ * Give the software fallback the same key so that small requests can be
+ * sent to it. Failing here only keeps every request on the engine.
+ */
+static void _qcrypto_setkey_aes_sw(struct crypto_ablkcipher *cipher,
+		const u8 *key, unsigned int len)
+{
+	struct crypto_tfm *tfm = crypto_ablkcipher_tfm(cipher);
+	struct qcrypto_cipher_ctx *ctx = crypto_tfm_ctx(tfm);
+
+	if (!ctx->cipher_aes192_fb)
+		return;
+
+	ctx->cipher_aes192_fb->base.crt_flags &= ~CRYPTO_TFM_REQ_MASK;
+	ctx->cipher_aes192_fb->base.crt_flags |=
+			(cipher->base.crt_flags & CRYPTO_TFM_REQ_MASK);
+	if (!crypto_ablkcipher_setkey(ctx->cipher_aes192_fb, key, len))
+		ctx->fb_key_set = true;
+}
+
 static int _qcrypto_setkey_aes(struct crypto_ablkcipher *cipher, const u8 *key,
 		unsigned int len)
 {
@@ -1301,6 +1355,7 @@ static int _qcrypto_setkey_aes(struct crypto_ablkcipher *cipher, const u8 *key,
 	struct qcrypto_cipher_ctx *ctx = crypto_tfm_ctx(tfm);
 	struct crypto_priv *cp = ctx->cp;
 
+	ctx->fb_key_set = false;
 	if ((ctx->flags & QCRYPTO_CTX_USE_HW_KEY) == QCRYPTO_CTX_USE_HW_KEY)
 		return 0;
 
@@ -1319,6 +1374,7 @@ static int _qcrypto_setkey_aes(struct crypto_ablkcipher *cipher, const u8 *key,
 				pr_err("%s Inavlid key pointer\n", __func__);
 				return -EINVAL;
 			}
+			_qcrypto_setkey_aes_sw(cipher, key, len);
 		}
 	}
 	return 0;
@@ -1414,33 +1470,29 @@ static int _qcrypto_setkey_3des(struct crypto_ablkcipher *cipher, const u8 *key,
 	return 0;
 };
 
-static struct crypto_engine *eng_sel_avoid_first(struct crypto_priv *cp)
+static void eng_restart_avoid_first(struct crypto_priv *cp)
 {
 	/*
 	 * This function need not be spinlock protected when called from
 	 * the seq_response workq as it will not have any contentions when all
 	 * request processing is stopped.
+	 *
+	 * Every engine but the first one with room is restarted, so that a
+	 * backlog drains through all of them rather than one at a time.
 	 */
 	struct crypto_engine *p;
-	struct crypto_engine *q = NULL;
-	int max_user =  QCRYPTO_BIG_NUMBER;
-	int use_cnt;
 
 	if (unlikely(list_empty(&cp->engine_list))) {
 		pr_err("%s: no valid ce to schedule\n", __func__);
-		return NULL;
+		return;
 	}
 
 	p = list_first_entry(&cp->engine_list, struct crypto_engine,
 								elist);
 	list_for_each_entry_continue(p, &cp->engine_list, elist) {
-		use_cnt = atomic_read(&p->req_count);
-		if ((use_cnt < p->max_req) && (use_cnt < max_user)) {
-			q = p;
-			max_user = use_cnt;
-		}
+		if (atomic_read(&p->req_count) < p->max_req)
+			_start_qcrypto_process(cp, p);
 	}
-	return q;
 }
 
 static void seq_response(struct work_struct *work)
@@ -1467,7 +1519,6 @@ again:
 	while (rev) {
 		struct qcrypto_resp_ctx *arsp;
 		struct crypto_async_request *areq;
-		struct crypto_engine *pengine;
 
 		arsp = container_of(rev, struct qcrypto_resp_ctx, llist);
 		rev = llist_next(rev);
@@ -1479,11 +1530,8 @@ again:
 		atomic_dec(&cp->resp_cnt);
 		if (ACCESS_ONCE(cp->ce_req_proc_sts) == STOPPED &&
 				atomic_read(&cp->resp_cnt) <=
-				(COMPLETION_CB_BACKLOG_LENGTH / 2)) {
-			pengine = eng_sel_avoid_first(cp);
-			if (pengine)
-				_start_qcrypto_process(cp, pengine);
-		}
+				(COMPLETION_CB_BACKLOG_LENGTH / 2))
+			eng_restart_avoid_first(cp);
 	}
 end:
 	if (cmpxchg(&cp->sched_resp_workq_status, SCHEDULE_AGAIN,
@@ -2398,10 +2446,18 @@ again:
 
 static struct crypto_engine *_avail_eng(struct crypto_priv *cp)
 {
-	/* call this function with spinlock set */
+	/*
+	 * call this function with spinlock set
+	 *
+	 * The least busy engine that already holds a bus vote is preferred,
+	 * so a light load stays on the warm engines and another engine is
+	 * only voted up once those are full.
+	 */
 	struct crypto_engine *p;
 	struct crypto_engine *q = NULL;
+	struct crypto_engine *warm = NULL;
 	int max_user =  QCRYPTO_BIG_NUMBER;
+	int max_warm = QCRYPTO_BIG_NUMBER;
 	int use_cnt;
 
 	if (unlikely(list_empty(&cp->engine_list))) {
@@ -2411,12 +2467,18 @@ static struct crypto_engine *_avail_eng(struct crypto_priv *cp)
 
 	list_for_each_entry(p, &cp->engine_list, elist) {
 		use_cnt = atomic_read(&p->req_count);
-		if ((use_cnt < p->max_req) && (use_cnt < max_user)) {
+		if (use_cnt >= p->max_req)
+			continue;
+		if (use_cnt < max_user) {
 			q = p;
 			max_user = use_cnt;
 		}
+		if (p->bw_state == BUS_HAS_BANDWIDTH && use_cnt < max_warm) {
+			warm = p;
+			max_warm = use_cnt;
+		}
 	}
-	return q;
+	return warm ? warm : q;
 }
 
 static int _qcrypto_queue_req(struct crypto_priv *cp,
@@ -2471,6 +2533,54 @@ static int _qcrypto_queue_req(struct crypto_priv *cp,
 	return ret;
 }
 
+/* Caller holds no lock, bw_state is only sampled */
+static bool _qcrypto_bw_cold(struct crypto_priv *cp,
+				struct crypto_engine *pengine)
+{
+	struct crypto_engine *pe;
+
+	if (pengine)
+		return pengine->bw_state != BUS_HAS_BANDWIDTH;
+
+	list_for_each_entry(pe, &cp->engine_list, elist) {
+		if (pe->bw_state == BUS_HAS_BANDWIDTH)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Decide whether an AES ECB/CBC/CTR request is done by the software
+ * fallback rather than queued to an engine.
+ */
+static bool _qcrypto_aes_use_sw(struct qcrypto_cipher_ctx *ctx,
+				unsigned int nbytes)
+{
+	struct crypto_priv *cp = ctx->cp;
+	struct crypto_stat *pstat = &_qcrypto_stat;
+
+	if (!ctx->cipher_aes192_fb)
+		return false;
+
+	if ((ctx->enc_key_len == AES_KEYSIZE_192) &&
+			(!cp->ce_support.aes_key_192))
+		goto sw;
+
+	if (!ctx->fb_key_set)
+		goto hw;
+	if (nbytes < sw_crossover)
+		goto sw;
+	if (nbytes < sw_cold_bytes && _qcrypto_bw_cold(cp, ctx->pengine))
+		goto sw;
+hw:
+	pstat->ablk_cipher_aes_hw_bytes += nbytes;
+	return false;
+sw:
+	pstat->ablk_cipher_aes_sw++;
+	pstat->ablk_cipher_aes_sw_bytes += nbytes;
+	return true;
+}
+
 static int _qcrypto_enc_aes_192_fallback(struct ablkcipher_request *req)
 {
 	struct crypto_tfm *tfm =
@@ -2513,9 +2623,7 @@ static int _qcrypto_enc_aes_ecb(struct ablkcipher_request *req)
 	dev_info(&ctx->pengine->pdev->dev, "_qcrypto_enc_aes_ecb: %p\n", req);
 #endif
 
-	if ((ctx->enc_key_len == AES_KEYSIZE_192) &&
-			(!cp->ce_support.aes_key_192) &&
-				ctx->cipher_aes192_fb)
+	if (_qcrypto_aes_use_sw(ctx, req->nbytes))
 		return _qcrypto_enc_aes_192_fallback(req);
 
 	rctx = ablkcipher_request_ctx(req);
@@ -2543,9 +2651,7 @@ static int _qcrypto_enc_aes_cbc(struct ablkcipher_request *req)
 	dev_info(&ctx->pengine->pdev->dev, "_qcrypto_enc_aes_cbc: %p\n", req);
 #endif
 
-	if ((ctx->enc_key_len == AES_KEYSIZE_192) &&
-			(!cp->ce_support.aes_key_192) &&
-				ctx->cipher_aes192_fb)
+	if (_qcrypto_aes_use_sw(ctx, req->nbytes))
 		return _qcrypto_enc_aes_192_fallback(req);
 
 	rctx = ablkcipher_request_ctx(req);
@@ -2573,9 +2679,7 @@ static int _qcrypto_enc_aes_ctr(struct ablkcipher_request *req)
 	dev_info(&ctx->pengine->pdev->dev, "_qcrypto_enc_aes_ctr: %p\n", req);
 #endif
 
-	if ((ctx->enc_key_len == AES_KEYSIZE_192) &&
-			(!cp->ce_support.aes_key_192) &&
-				ctx->cipher_aes192_fb)
+	if (_qcrypto_aes_use_sw(ctx, req->nbytes))
 		return _qcrypto_enc_aes_192_fallback(req);
 
 	rctx = ablkcipher_request_ctx(req);
@@ -2757,9 +2861,7 @@ static int _qcrypto_dec_aes_ecb(struct ablkcipher_request *req)
 	dev_info(&ctx->pengine->pdev->dev, "_qcrypto_dec_aes_ecb: %p\n", req);
 #endif
 
-	if ((ctx->enc_key_len == AES_KEYSIZE_192) &&
-			(!cp->ce_support.aes_key_192) &&
-				ctx->cipher_aes192_fb)
+	if (_qcrypto_aes_use_sw(ctx, req->nbytes))
 		return _qcrypto_dec_aes_192_fallback(req);
 
 	rctx = ablkcipher_request_ctx(req);
@@ -2787,9 +2889,7 @@ static int _qcrypto_dec_aes_cbc(struct ablkcipher_request *req)
 	dev_info(&ctx->pengine->pdev->dev, "_qcrypto_dec_aes_cbc: %p\n", req);
 #endif
 
-	if ((ctx->enc_key_len == AES_KEYSIZE_192) &&
-			(!cp->ce_support.aes_key_192) &&
-				ctx->cipher_aes192_fb)
+	if (_qcrypto_aes_use_sw(ctx, req->nbytes))
 		return _qcrypto_dec_aes_192_fallback(req);
 
 	rctx = ablkcipher_request_ctx(req);
@@ -2817,9 +2917,7 @@ static int _qcrypto_dec_aes_ctr(struct ablkcipher_request *req)
 	dev_info(&ctx->pengine->pdev->dev, "_qcrypto_dec_aes_ctr: %p\n", req);
 #endif
 
-	if ((ctx->enc_key_len == AES_KEYSIZE_192) &&
-			(!cp->ce_support.aes_key_192) &&
-				ctx->cipher_aes192_fb)
+	if (_qcrypto_aes_use_sw(ctx, req->nbytes))
 		return _qcrypto_dec_aes_192_fallback(req);
 
 	rctx = ablkcipher_request_ctx(req);
@@ -5097,6 +5195,8 @@ static int  _qcrypto_probe(struct platform_device *pdev)
 	qce_hw_support(pengine->qce, &cp->ce_support);
 	pengine->ce_hw_instance = cp->ce_support.ce_hw_instance;
 	pengine->max_req = cp->ce_support.max_request;
+	if (max_req_per_engine && max_req_per_engine < pengine->max_req)
+		pengine->max_req = max_req_per_engine;
 	pqcrypto_req_control = kzalloc(sizeof(struct qcrypto_req_control) *
 			pengine->max_req, GFP_KERNEL);
 	if (pqcrypto_req_control == NULL) {
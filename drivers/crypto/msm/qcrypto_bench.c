@@ -0,0 +1,399 @@
+/* Qualcomm crypto throughput and latency benchmark
+ *
+ * Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Runs a crypto API algorithm, named either by its algorithm name or its
+ * driver name, over one buffer size, on demand from debugfs:
+ *
+ *	echo "<type> <alg> <keylen> <size> <iters>" > qcrypto_bench/run
+ *	cat qcrypto_bench/run
+ *
+ * <type> is cipher, hash or aead. Pass keylen 0 for an unkeyed hash.
+ * Every request is issued and waited for on its own, so the percentiles
+ * are per operation latencies as seen by a synchronous caller. cpu_us is
+ * the time the benchmark thread spent on CPU setting up and submitting
+ * requests, completion work on other CPUs is not included.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/types.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/sort.h>
+#include <linux/ktime.h>
+#include <linux/sched.h>
+#include <linux/sizes.h>
+#include <linux/mutex.h>
+#include <linux/completion.h>
+#include <linux/scatterlist.h>
+#include <linux/crypto.h>
+#include <linux/debugfs.h>
+#include <linux/uaccess.h>
+
+#include <crypto/aead.h>
+#include <crypto/hash.h>
+
+#define BENCH_MAX_SIZE		SZ_64K
+#define BENCH_MAX_ITERS		4096
+#define BENCH_MAX_KEYLEN	64
+#define BENCH_AUTHSIZE		16
+#define BENCH_RESULT_BUF	512
+
+enum bench_type {
+	BENCH_CIPHER,
+	BENCH_HASH,
+	BENCH_AEAD,
+};
+
+struct bench_result {
+	struct completion completion;
+	int err;
+};
+
+struct bench_run {
+	enum bench_type type;
+	union {
+		struct crypto_ablkcipher *cipher;
+		struct crypto_ahash *hash;
+		struct crypto_aead *aead;
+	} tfm;
+	union {
+		struct ablkcipher_request *cipher;
+		struct ahash_request *hash;
+		struct aead_request *aead;
+	} req;
+	struct bench_result res;
+	struct scatterlist sg, assoc_sg;
+	u8 *buf;
+	u8 iv[32];
+	u8 digest[64];
+	unsigned int size;
+};
+
+static DEFINE_MUTEX(bench_mutex);
+static char bench_result_buf[BENCH_RESULT_BUF];
+static struct dentry *bench_dent;
+
+static void bench_complete(struct crypto_async_request *req, int err)
+{
+	struct bench_result *res = req->data;
+
+	if (err == -EINPROGRESS)
+		return;
+
+	res->err = err;
+	complete(&res->completion);
+}
+
+static int bench_wait(struct bench_result *res, int ret)
+{
+	if (ret == -EINPROGRESS || ret == -EBUSY) {
+		wait_for_completion(&res->completion);
+		reinit_completion(&res->completion);
+		ret = res->err;
+	}
+	return ret;
+}
+
+static int bench_setup(struct bench_run *run, const char *alg,
+		       const u8 *key, unsigned int keylen)
+{
+	int ret = 0;
+
+	switch (run->type) {
+	case BENCH_CIPHER:
+		run->tfm.cipher = crypto_alloc_ablkcipher(alg, 0, 0);
+		if (IS_ERR(run->tfm.cipher))
+			return PTR_ERR(run->tfm.cipher);
+		ret = crypto_ablkcipher_setkey(run->tfm.cipher, key, keylen);
+		if (ret)
+			return ret;
+		run->req.cipher = ablkcipher_request_alloc(run->tfm.cipher,
+							   GFP_KERNEL);
+		if (!run->req.cipher)
+			return -ENOMEM;
+		ablkcipher_request_set_callback(run->req.cipher,
+				CRYPTO_TFM_REQ_MAY_BACKLOG,
+				bench_complete, &run->res);
+		ablkcipher_request_set_crypt(run->req.cipher, &run->sg,
+					     &run->sg, run->size, run->iv);
+		break;
+	case BENCH_HASH:
+		run->tfm.hash = crypto_alloc_ahash(alg, 0, 0);
+		if (IS_ERR(run->tfm.hash))
+			return PTR_ERR(run->tfm.hash);
+		if (keylen)
+			ret = crypto_ahash_setkey(run->tfm.hash, key, keylen);
+		if (ret)
+			return ret;
+		run->req.hash = ahash_request_alloc(run->tfm.hash, GFP_KERNEL);
+		if (!run->req.hash)
+			return -ENOMEM;
+		ahash_request_set_callback(run->req.hash,
+				CRYPTO_TFM_REQ_MAY_BACKLOG,
+				bench_complete, &run->res);
+		ahash_request_set_crypt(run->req.hash, &run->sg, run->digest,
+					run->size);
+		break;
+	case BENCH_AEAD:
+		run->tfm.aead = crypto_alloc_aead(alg, 0, 0);
+		if (IS_ERR(run->tfm.aead))
+			return PTR_ERR(run->tfm.aead);
+		ret = crypto_aead_setkey(run->tfm.aead, key, keylen);
+		if (!ret)
+			ret = crypto_aead_setauthsize(run->tfm.aead,
+						      BENCH_AUTHSIZE);
+		if (ret)
+			return ret;
+		run->req.aead = aead_request_alloc(run->tfm.aead, GFP_KERNEL);
+		if (!run->req.aead)
+			return -ENOMEM;
+		aead_request_set_callback(run->req.aead,
+				CRYPTO_TFM_REQ_MAY_BACKLOG,
+				bench_complete, &run->res);
+		/* the buffer has room for the tag after the payload */
+		aead_request_set_crypt(run->req.aead, &run->sg, &run->sg,
+				       run->size, run->iv);
+		sg_init_one(&run->assoc_sg, run->digest, 0);
+		aead_request_set_assoc(run->req.aead, &run->assoc_sg, 0);
+		break;
+	}
+
+	return 0;
+}
+
+static void bench_teardown(struct bench_run *run)
+{
+	switch (run->type) {
+	case BENCH_CIPHER:
+		if (IS_ERR_OR_NULL(run->tfm.cipher))
+			break;
+		ablkcipher_request_free(run->req.cipher);
+		crypto_free_ablkcipher(run->tfm.cipher);
+		break;
+	case BENCH_HASH:
+		if (IS_ERR_OR_NULL(run->tfm.hash))
+			break;
+		ahash_request_free(run->req.hash);
+		crypto_free_ahash(run->tfm.hash);
+		break;
+	case BENCH_AEAD:
+		if (IS_ERR_OR_NULL(run->tfm.aead))
+			break;
+		aead_request_free(run->req.aead);
+		crypto_free_aead(run->tfm.aead);
+		break;
+	}
+}
+
+static int bench_one(struct bench_run *run)
+{
+	int ret = 0;
+
+	switch (run->type) {
+	case BENCH_CIPHER:
+		ret = crypto_ablkcipher_encrypt(run->req.cipher);
+		break;
+	case BENCH_HASH:
+		ret = crypto_ahash_digest(run->req.hash);
+		break;
+	case BENCH_AEAD:
+		ret = crypto_aead_encrypt(run->req.aead);
+		break;
+	}
+
+	return bench_wait(&run->res, ret);
+}
+
+static const char *bench_driver_name(struct bench_run *run)
+{
+	switch (run->type) {
+	case BENCH_CIPHER:
+		return crypto_tfm_alg_driver_name(
+				crypto_ablkcipher_tfm(run->tfm.cipher));
+	case BENCH_HASH:
+		return crypto_tfm_alg_driver_name(
+				crypto_ahash_tfm(run->tfm.hash));
+	case BENCH_AEAD:
+		return crypto_tfm_alg_driver_name(
+				crypto_aead_tfm(run->tfm.aead));
+	}
+
+	return "";
+}
+
+static int bench_u32_cmp(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int bench_exec(enum bench_type type, const char *alg,
+		      unsigned int keylen, unsigned int size,
+		      unsigned int iters)
+{
+	struct bench_run *run;
+	u8 key[BENCH_MAX_KEYLEN];
+	u32 *lat = NULL;
+	u64 start_cpu, cpu_ns, total_ns;
+	ktime_t start, op_start;
+	unsigned int i;
+	int ret;
+
+	run = kzalloc(sizeof(*run), GFP_KERNEL);
+	if (!run)
+		return -ENOMEM;
+
+	run->type = type;
+	run->size = size;
+	init_completion(&run->res.completion);
+
+	ret = -ENOMEM;
+	run->buf = kzalloc(size + BENCH_AUTHSIZE, GFP_KERNEL);
+	lat = vmalloc(iters * sizeof(*lat));
+	if (!run->buf || !lat)
+		goto out;
+	sg_init_one(&run->sg, run->buf, size + BENCH_AUTHSIZE);
+	memset(key, 0x5a, sizeof(key));
+
+	ret = bench_setup(run, alg, key, keylen);
+	if (ret)
+		goto out;
+
+	/* one request untimed, so the first does not pay for setup */
+	ret = bench_one(run);
+	if (ret)
+		goto out;
+
+	start_cpu = current->se.sum_exec_runtime;
+	start = ktime_get();
+	for (i = 0; i < iters; i++) {
+		op_start = ktime_get();
+		ret = bench_one(run);
+		if (ret)
+			goto out;
+		lat[i] = ktime_to_ns(ktime_sub(ktime_get(), op_start));
+	}
+	total_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	cpu_ns = current->se.sum_exec_runtime - start_cpu;
+
+	sort(lat, iters, sizeof(*lat), bench_u32_cmp, NULL);
+
+	scnprintf(bench_result_buf, sizeof(bench_result_buf),
+		"alg %s driver %s size %u iters %u\n"
+		"kBps %llu p50_ns %u p90_ns %u p99_ns %u max_ns %u cpu_us %llu\n",
+		alg, bench_driver_name(run), size, iters,
+		div64_u64((u64)size * iters * USEC_PER_SEC,
+			  max_t(u64, total_ns, 1)),
+		lat[iters / 2], lat[iters * 9 / 10], lat[iters * 99 / 100],
+		lat[iters - 1], div_u64(cpu_ns, NSEC_PER_USEC));
+out:
+	if (ret)
+		scnprintf(bench_result_buf, sizeof(bench_result_buf),
+			  "alg %s error %d\n", alg, ret);
+	bench_teardown(run);
+	vfree(lat);
+	kfree(run->buf);
+	kfree(run);
+
+	return ret;
+}
+
+static ssize_t bench_run_write(struct file *file, const char __user *ubuf,
+			       size_t count, loff_t *ppos)
+{
+	char buf[128], type[8], alg[CRYPTO_MAX_ALG_NAME];
+	unsigned int keylen, size, iters;
+	enum bench_type t;
+	int ret;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sscanf(buf, "%7s %63s %u %u %u", type, alg, &keylen, &size,
+		   &iters) != 5)
+		return -EINVAL;
+
+	if (!strcmp(type, "cipher"))
+		t = BENCH_CIPHER;
+	else if (!strcmp(type, "hash"))
+		t = BENCH_HASH;
+	else if (!strcmp(type, "aead"))
+		t = BENCH_AEAD;
+	else
+		return -EINVAL;
+
+	if (keylen > BENCH_MAX_KEYLEN || !size || size > BENCH_MAX_SIZE ||
+	    !iters || iters > BENCH_MAX_ITERS)
+		return -EINVAL;
+
+	mutex_lock(&bench_mutex);
+	ret = bench_exec(t, alg, keylen, size, iters);
+	mutex_unlock(&bench_mutex);
+
+	return ret ? ret : count;
+}
+
+static ssize_t bench_run_read(struct file *file, char __user *ubuf,
+			      size_t count, loff_t *ppos)
+{
+	ssize_t ret;
+
+	mutex_lock(&bench_mutex);
+	ret = simple_read_from_buffer(ubuf, count, ppos, bench_result_buf,
+				      strlen(bench_result_buf));
+	mutex_unlock(&bench_mutex);
+
+	return ret;
+}
+
+static const struct file_operations bench_run_ops = {
+	.open = simple_open,
+	.read = bench_run_read,
+	.write = bench_run_write,
+};
+
+static int __init qcrypto_bench_init(void)
+{
+	bench_dent = debugfs_create_dir("qcrypto_bench", NULL);
+	if (IS_ERR_OR_NULL(bench_dent)) {
+		pr_err("qcrypto_bench: debugfs_create_dir fail, error %ld\n",
+		       PTR_ERR(bench_dent));
+		return -ENODEV;
+	}
+
+	if (!debugfs_create_file("run", S_IRUSR | S_IWUSR, bench_dent, NULL,
+				 &bench_run_ops)) {
+		debugfs_remove_recursive(bench_dent);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void __exit qcrypto_bench_exit(void)
+{
+	debugfs_remove_recursive(bench_dent);
+}
+
+module_init(qcrypto_bench_init);
+module_exit(qcrypto_bench_exit);
+
+MODULE_LICENSE("GPL v2");
+MODULE_DESCRIPTION("Qualcomm crypto throughput and latency benchmark");
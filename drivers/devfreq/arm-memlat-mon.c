@@ -28,9 +28,11 @@
 #include <linux/irq.h>
 #include <linux/cpu_pm.h>
 #include <linux/cpu.h>
+#include <linux/sched.h>
 #include "governor.h"
 #include "governor_memlat.h"
 #include <linux/perf_event.h>
+#include <trace/events/sched.h>
 
 enum ev_index {
 	INST_IDX,
@@ -47,13 +49,31 @@ struct event_data {
 	unsigned long prev_count;
 };
 
+/*
+ * Busy time of the CPU since the last sample and the part of it spent
+ * in tasks of memlat_background cgroups, accounted at context switch.
+ */
+struct memlat_task_time {
+	raw_spinlock_t lock;
+	bool tracked;
+	bool cur_busy;
+	bool cur_bg;
+	u64 switch_ts;
+	u64 busy_ns;
+	u64 bg_ns;
+};
+
 struct memlat_hwmon_data {
 	struct event_data events[NUM_EVENTS];
 	ktime_t prev_ts;
 	bool init_pending;
+	struct memlat_task_time tt;
 };
 static DEFINE_PER_CPU(struct memlat_hwmon_data, pm_data);
 
+static DEFINE_MUTEX(switch_mutex);
+static unsigned int switch_refcount;
+
 struct cpu_grp_info {
 	cpumask_t cpus;
 	struct memlat_hwmon hw;
@@ -100,6 +120,80 @@ static inline unsigned long read_event(struct event_data *event)
 	return ev_count;
 }
 
+static void memlat_sched_switch(void *data, struct task_struct *prev,
+				struct task_struct *next)
+{
+	struct memlat_task_time *tt = &this_cpu_ptr(&pm_data)->tt;
+	u64 now;
+
+	if (!tt->tracked)
+		return;
+
+	raw_spin_lock(&tt->lock);
+	now = sched_clock();
+	if (tt->cur_busy)
+		tt->busy_ns += now - tt->switch_ts;
+	if (tt->cur_bg)
+		tt->bg_ns += now - tt->switch_ts;
+	tt->switch_ts = now;
+	tt->cur_busy = !is_idle_task(next);
+	tt->cur_bg = tt->cur_busy && sched_memlat_background(next);
+	raw_spin_unlock(&tt->lock);
+}
+
+/* Percentage of the busy time since the last call spent in background */
+static unsigned int read_bg_pct(struct memlat_task_time *tt)
+{
+	unsigned long flags;
+	u64 now, busy, bg;
+
+	raw_spin_lock_irqsave(&tt->lock, flags);
+	now = sched_clock();
+	busy = tt->busy_ns;
+	bg = tt->bg_ns;
+	if (tt->cur_busy)
+		busy += now - tt->switch_ts;
+	if (tt->cur_bg)
+		bg += now - tt->switch_ts;
+	tt->busy_ns = tt->bg_ns = 0;
+	tt->switch_ts = now;
+	raw_spin_unlock_irqrestore(&tt->lock, flags);
+
+	if (!busy)
+		return 0;
+
+	return div64_u64(bg * 100, busy);
+}
+
+static void track_task_time(struct cpu_grp_info *cpu_grp, bool enable)
+{
+	int cpu;
+	unsigned long flags;
+	struct memlat_task_time *tt;
+
+	mutex_lock(&switch_mutex);
+	if (enable && !switch_refcount++) {
+		if (register_trace_sched_switch(memlat_sched_switch, NULL))
+			pr_warn("Unable to track background task time\n");
+	}
+
+	for_each_cpu(cpu, &cpu_grp->cpus) {
+		tt = &per_cpu(pm_data, cpu).tt;
+		raw_spin_lock_irqsave(&tt->lock, flags);
+		tt->tracked = enable;
+		tt->cur_busy = tt->cur_bg = false;
+		tt->busy_ns = tt->bg_ns = 0;
+		tt->switch_ts = sched_clock();
+		raw_spin_unlock_irqrestore(&tt->lock, flags);
+	}
+
+	if (!enable && !--switch_refcount) {
+		unregister_trace_sched_switch(memlat_sched_switch, NULL);
+		tracepoint_synchronize_unregister();
+	}
+	mutex_unlock(&switch_mutex);
+}
+
 static void read_perf_counters(int cpu, struct cpu_grp_info *cpu_grp)
 {
 	int cpu_idx;
@@ -120,6 +214,8 @@ static void read_perf_counters(int cpu, struct cpu_grp_info *cpu_grp)
 
 	cyc_cnt = read_event(&hw_data->events[CYC_IDX]);
 	hw->core_stats[cpu_idx].freq = compute_freq(hw_data, cyc_cnt);
+
+	hw->core_stats[cpu_idx].bg_pct = read_bg_pct(&hw_data->tt);
 }
 
 static unsigned long get_cnt(struct memlat_hwmon *hw)
@@ -151,6 +247,8 @@ static void stop_hwmon(struct memlat_hwmon *hw)
 	struct cpu_grp_info *cpu_grp = container_of(hw,
 					struct cpu_grp_info, hw);
 
+	track_task_time(cpu_grp, false);
+
 	get_online_cpus();
 	for_each_cpu(cpu, &cpu_grp->cpus) {
 		hw_data = &per_cpu(pm_data, cpu);
@@ -164,6 +262,7 @@ static void stop_hwmon(struct memlat_hwmon *hw)
 		hw->core_stats[idx].inst_count = 0;
 		hw->core_stats[idx].mem_count = 0;
 		hw->core_stats[idx].freq = 0;
+		hw->core_stats[idx].bg_pct = 0;
 	}
 	put_online_cpus();
 
@@ -298,6 +397,10 @@ static int start_hwmon(struct memlat_hwmon *hw)
 	}
 
 	put_online_cpus();
+
+	if (!ret)
+		track_task_time(cpu_grp, true);
+
 	return ret;
 }
 
@@ -393,6 +496,11 @@ static struct platform_driver arm_memlat_mon_driver = {
 
 static int __init arm_memlat_mon_init(void)
 {
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		raw_spin_lock_init(&per_cpu(pm_data, cpu).tt.lock);
+
 	return platform_driver_register(&arm_memlat_mon_driver);
 }
 module_init(arm_memlat_mon_init);
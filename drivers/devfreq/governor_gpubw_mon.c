@@ -12,6 +12,7 @@
  */
 
 #include <linux/devfreq.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/msm_adreno_devfreq.h>
 #include <linux/slab.h>
@@ -26,6 +27,43 @@
 #define CAP                     75
 /* AB vote is in multiple of BW_STEP Mega bytes */
 #define BW_STEP                 160
+/*
+ * Percentage of busy GPU cycles spent waiting on memory above which the
+ * workload is treated as memory bound, and below which it is ALU bound.
+ */
+#define MEM_BOUND               50
+#define ALU_BOUND               10
+
+static struct devfreq_governor devfreq_gpubw_coupled;
+
+/*
+ * In the coupled mode the GPU clock and the bus are voted together. A
+ * workload stalled on memory gets more bandwidth and gives up a GPU power
+ * level since the extra core cycles are only spent waiting. A workload that
+ * rarely touches memory lets the bus come down and leaves the core clock to
+ * the GPU governor. Both changes are applied in a single bus update by KGSL.
+ */
+static void _coupled_vote(struct devfreq_msm_adreno_tz_data *priv,
+		struct msm_busmon_extended_profile *bus_profile,
+		unsigned long gpu_freq, int level, int act_level)
+{
+	u64 gpu_cycles;
+	unsigned int stall;
+
+	gpu_cycles = priv->bus.gpu_time * (gpu_freq / 1000000);
+	if (gpu_cycles == 0)
+		return;
+
+	stall = (unsigned int) div64_u64(100 * priv->bus.ram_wait, gpu_cycles);
+
+	if (stall >= MEM_BOUND) {
+		if (act_level < priv->bus.num - 1)
+			bus_profile->flag = DEVFREQ_FLAG_FAST_HINT;
+		bus_profile->gpu_mod = 1;
+	} else if (stall <= ALU_BOUND && level) {
+		bus_profile->flag = DEVFREQ_FLAG_SLOW_HINT;
+	}
+}
 
 static void _update_cutoff(struct devfreq_msm_adreno_tz_data *priv,
 					unsigned int norm_max)
@@ -108,6 +146,10 @@ static int devfreq_gpubw_get_target(struct devfreq *df,
 			bus_profile->flag = DEVFREQ_FLAG_FAST_HINT;
 		else if (norm_cycles < priv->bus.down[act_level] && level)
 			bus_profile->flag = DEVFREQ_FLAG_SLOW_HINT;
+
+		if (df->governor == &devfreq_gpubw_coupled)
+			_coupled_vote(priv, bus_profile,
+				stats.current_frequency, level, act_level);
 	}
 
 	/* Calculate the AB vote based on bus width if defined */
@@ -174,18 +216,27 @@ static int gpubw_start(struct devfreq *devfreq)
 		priv->bus.p_up[priv->bus.num - 1] = 100;
 	_update_cutoff(priv, priv->bus.max);
 
+	bus_profile->gpu_mod = 0;
+	bus_profile->coupled = (devfreq->governor == &devfreq_gpubw_coupled);
+
 	return 0;
 }
 
 static int gpubw_stop(struct devfreq *devfreq)
 {
 	struct devfreq_msm_adreno_tz_data *priv = devfreq->data;
+	struct msm_busmon_extended_profile *bus_profile = container_of(
+					(devfreq->profile),
+					struct msm_busmon_extended_profile,
+					profile);
 	if (priv) {
 		kfree(priv->bus.up);
 		kfree(priv->bus.down);
 		kfree(priv->bus.p_up);
 		kfree(priv->bus.p_down);
 	}
+	bus_profile->coupled = false;
+	bus_profile->gpu_mod = 0;
 	devfreq->data = NULL;
 	return 0;
 }
@@ -231,9 +282,25 @@ static struct devfreq_governor devfreq_gpubw = {
 	.event_handler = devfreq_gpubw_event_handler,
 };
 
+static struct devfreq_governor devfreq_gpubw_coupled = {
+	.name = "gpubw_coupled",
+	.get_target_freq = devfreq_gpubw_get_target,
+	.event_handler = devfreq_gpubw_event_handler,
+};
+
 static int __init devfreq_gpubw_init(void)
 {
-	return devfreq_add_governor(&devfreq_gpubw);
+	int ret;
+
+	ret = devfreq_add_governor(&devfreq_gpubw);
+	if (ret)
+		return ret;
+
+	ret = devfreq_add_governor(&devfreq_gpubw_coupled);
+	if (ret)
+		devfreq_remove_governor(&devfreq_gpubw);
+
+	return ret;
 }
 subsys_initcall(devfreq_gpubw_init);
 
@@ -241,6 +308,10 @@ static void __exit devfreq_gpubw_exit(void)
 {
 	int ret;
 
+	ret = devfreq_remove_governor(&devfreq_gpubw_coupled);
+	if (ret)
+		pr_err("%s: failed remove governor %d\n", __func__, ret);
+
 	ret = devfreq_remove_governor(&devfreq_gpubw);
 	if (ret)
 		pr_err("%s: failed remove governor %d\n", __func__, ret);
@@ -37,6 +37,7 @@ struct memlat_node {
 	unsigned int ratio_ceil;
 	unsigned int freq_thresh_mhz;
 	unsigned int mult_factor;
+	unsigned int bg_weight;
 	bool mon_started;
 	struct list_head list;
 	void *orig_data;
@@ -88,8 +89,8 @@ static unsigned long compute_dev_vote(struct devfreq *df)
 	int i, lat_dev;
 	struct memlat_node *node = df->data;
 	struct memlat_hwmon *hw = node->hw;
-	unsigned long max_freq = 0;
-	unsigned int ratio;
+	unsigned long max_freq = 0, freq;
+	unsigned int ratio, weight;
 
 	hw->get_cnt(hw);
 
@@ -105,11 +106,19 @@ static unsigned long compute_dev_vote(struct devfreq *df)
 					hw->core_stats[i].mem_count,
 					hw->core_stats[i].freq, ratio);
 
+		/*
+		 * Time spent in background cgroups only counts for
+		 * bg_weight percent of the core's vote, 0 ignores it.
+		 */
+		weight = 100 - hw->core_stats[i].bg_pct *
+				(100 - node->bg_weight) / 100;
+		freq = hw->core_stats[i].freq * weight / 100;
+
 		if (ratio && ratio <= node->ratio_ceil
-		    && hw->core_stats[i].freq >= node->freq_thresh_mhz
-		    && hw->core_stats[i].freq > max_freq) {
+		    && freq >= node->freq_thresh_mhz
+		    && freq > max_freq) {
 			lat_dev = i;
-			max_freq = hw->core_stats[i].freq;
+			max_freq = freq;
 		}
 	}
 
@@ -236,11 +245,13 @@ static int devfreq_memlat_get_freq(struct devfreq *df,
 gov_attr(ratio_ceil, 1U, 1000U);
 gov_attr(freq_thresh_mhz, 300U, 5000U);
 gov_attr(mult_factor, 1U, 10U);
+gov_attr(bg_weight, 0U, 100U);
 
 static struct attribute *dev_attr[] = {
 	&dev_attr_ratio_ceil.attr,
 	&dev_attr_freq_thresh_mhz.attr,
 	&dev_attr_mult_factor.attr,
+	&dev_attr_bg_weight.attr,
 	NULL,
 };
 
@@ -313,6 +324,7 @@ int register_memlat(struct device *dev, struct memlat_hwmon *hw)
 	node->ratio_ceil = 10;
 	node->freq_thresh_mhz = 900;
 	node->mult_factor = 8;
+	node->bg_weight = 100;
 	node->hw = hw;
 
 	mutex_lock(&list_lock);
@@ -23,12 +23,16 @@
  * @mem_count:			Number of memory accesses made.
  * @freq:			Effective frequency of the device in the
  *				last interval.
+ * @bg_pct:			Percentage of the busy time in the last
+ *				interval spent running tasks of
+ *				memlat_background cgroups.
  */
 struct dev_stats {
 	int id;
 	unsigned long inst_count;
 	unsigned long mem_count;
 	unsigned long freq;
+	unsigned int bg_pct;
 };
 
 /**
@@ -56,6 +56,12 @@ static DEFINE_SPINLOCK(suspend_lock);
 
 #define TAG "msm_adreno_tz: "
 
+/*
+ * In frame mode the GPU should be busy for at most FRAME_BUDGET_PCT of the
+ * observed frame interval at the selected frequency.
+ */
+#define FRAME_BUDGET_PCT	85
+
 static u64 suspend_time;
 static u64 suspend_start;
 static unsigned long acc_total, acc_relative_busy;
@@ -68,6 +74,21 @@ static void do_partner_resume_event(struct work_struct *work);
 
 static struct workqueue_struct *workqueue;
 
+/*
+ * Frame mode state. frame_gap is the time since the last sample that
+ * carried a retired frame, frame_predicted the busy time per frame expected
+ * at the last selected frequency. The frame_stats counters are reset when
+ * read from sysfs, like gpu_load.
+ */
+static u64 frame_gap;
+static u64 frame_predicted;
+static struct {
+	u32 frames;
+	u32 over_budget;
+	u64 predicted;
+	u64 actual;
+} frame_stats;
+
 /*
  * Returns GPU suspend time in millisecond.
  */
@@ -131,15 +152,83 @@ static ssize_t suspend_time_show(struct device *dev,
 	return snprintf(buf, PAGE_SIZE, "%llu\n", time_diff);
 }
 
+/*
+ * Returns the average predicted and actual GPU busy time per frame in usec
+ * and the number of frames over budget since the last time the entry is
+ * read.
+ */
+static ssize_t frame_stats_show(struct device *dev,
+		struct device_attribute *attr,
+		char *buf)
+{
+	u64 predicted = 0, actual = 0;
+	u32 frames, over_budget;
+
+	spin_lock(&sample_lock);
+	frames = frame_stats.frames;
+	over_budget = frame_stats.over_budget;
+	if (frames) {
+		predicted = div_u64(frame_stats.predicted, frames);
+		actual = div_u64(frame_stats.actual, frames);
+	}
+	memset(&frame_stats, 0, sizeof(frame_stats));
+	spin_unlock(&sample_lock);
+
+	return snprintf(buf, PAGE_SIZE,
+		"frames %u predicted_us %llu actual_us %llu over_budget %u\n",
+		frames, predicted, actual, over_budget);
+}
+
+static ssize_t frame_dcvs_show(struct device *dev,
+		struct device_attribute *attr,
+		char *buf)
+{
+	struct devfreq *devfreq = to_devfreq(dev);
+	struct devfreq_msm_adreno_tz_data *priv = devfreq->data;
+
+	return snprintf(buf, PAGE_SIZE, "%d\n", priv ? priv->frame.enable : 0);
+}
+
+static ssize_t frame_dcvs_store(struct device *dev,
+		struct device_attribute *attr,
+		const char *buf, size_t count)
+{
+	struct devfreq *devfreq = to_devfreq(dev);
+	struct devfreq_msm_adreno_tz_data *priv = devfreq->data;
+	unsigned int val;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &val);
+	if (ret)
+		return ret;
+
+	if (priv == NULL)
+		return -ENODEV;
+
+	mutex_lock(&devfreq->lock);
+	priv->frame.enable = !!val;
+	frame_gap = 0;
+	frame_predicted = 0;
+	mutex_unlock(&devfreq->lock);
+
+	return count;
+}
+
 static DEVICE_ATTR(gpu_load, 0444, gpu_load_show, NULL);
 
 static DEVICE_ATTR(suspend_time, 0444,
 		suspend_time_show,
 		NULL);
 
+static DEVICE_ATTR(frame_stats, 0444, frame_stats_show, NULL);
+
+static DEVICE_ATTR(frame_dcvs, 0644, frame_dcvs_show, frame_dcvs_store);
+
 static const struct device_attribute *adreno_tz_attr_list[] = {
 		&dev_attr_gpu_load,
 		&dev_attr_suspend_time,
+		&dev_attr_frame_stats,
+		&dev_attr_frame_dcvs,
 		NULL
 };
 
@@ -267,6 +356,71 @@ static int tz_init(struct devfreq_msm_adreno_tz_data *priv,
 	return ret;
 }
 
+/*
+ * tz_frame_target() - Pick a frequency from the frames retired in a sample
+ *
+ * Select the lowest frequency at which the average GPU busy time per frame,
+ * scaled from the current frequency, fits in FRAME_BUDGET_PCT of the average
+ * frame interval. Returns false if there is no usable frame data and the
+ * regular algorithm should run instead.
+ */
+static bool tz_frame_target(struct devfreq *devfreq,
+		struct devfreq_msm_adreno_tz_data *priv,
+		struct devfreq_dev_status *stats, unsigned long *freq)
+{
+	u64 busy, interval, budget, predicted;
+	int level;
+
+	if (!priv->frame.enable)
+		return false;
+
+	if (priv->frame.num == 0) {
+		/*
+		 * Hold the current level between frames unless they
+		 * stopped coming altogether.
+		 */
+		frame_gap += stats->total_time;
+		return frame_gap < CEILING;
+	}
+
+	busy = div_u64(priv->frame.busy_time, priv->frame.num);
+	interval = div_u64(priv->frame.total_time, priv->frame.num);
+
+	/* Anything longer than CEILING is not a rendering loop */
+	if (interval == 0 || interval > CEILING)
+		return false;
+
+	frame_gap = 0;
+	budget = div_u64(interval * FRAME_BUDGET_PCT, 100);
+
+	spin_lock(&sample_lock);
+	if (frame_predicted) {
+		frame_stats.frames += priv->frame.num;
+		frame_stats.predicted += frame_predicted * priv->frame.num;
+		frame_stats.actual += priv->frame.busy_time;
+		if (busy > budget)
+			frame_stats.over_budget += priv->frame.num;
+	}
+	spin_unlock(&sample_lock);
+
+	/* freq_table[0] is the fastest level */
+	for (level = devfreq->profile->max_state - 1; level > 0; level--) {
+		predicted = div_u64(busy * stats->current_frequency,
+				devfreq->profile->freq_table[level]);
+		if (predicted <= budget)
+			break;
+	}
+
+	frame_predicted = div_u64(busy * stats->current_frequency,
+			devfreq->profile->freq_table[level]);
+
+	priv->bin.total_time = 0;
+	priv->bin.busy_time = 0;
+
+	*freq = devfreq->profile->freq_table[level];
+	return true;
+}
+
 static int tz_get_target_freq(struct devfreq *devfreq, unsigned long *freq,
 				u32 *flag)
 {
@@ -289,6 +443,12 @@ static int tz_get_target_freq(struct devfreq *devfreq, unsigned long *freq,
 
 	/* Update the GPU load statistics */
 	compute_work_load(&stats, priv, devfreq);
+
+	if (stats.current_frequency &&
+		tz_frame_target(devfreq, priv, &stats, freq))
+		return 0;
+
+	frame_predicted = 0;
 	/*
 	 * Do not waste CPU cycles running this algorithm if
 	 * the GPU just started, or if less than FLOOR time
@@ -446,6 +606,8 @@ static int tz_suspend(struct devfreq *devfreq)
 
 	priv->bin.total_time = 0;
 	priv->bin.busy_time = 0;
+	frame_gap = 0;
+	frame_predicted = 0;
 	return 0;
 }
 
@@ -322,6 +322,8 @@ struct adreno_gpu_core {
  * @speed_bin: Indicate which power level set to use
  * @csdev: Pointer to a coresight device (if applicable)
  * @gpmu_throttle_counters - counteers for number of throttled clocks
+ * @preempt_budget_us: Preemption latency, in microseconds, that the low latency
+ * mode is expected to stay within; longer preemptions are counted as misses
  */
 struct adreno_device {
 	struct kgsl_device dev;    /* Must be first field in this struct */
@@ -382,6 +384,7 @@ struct adreno_device {
 
 	struct coresight_device *csdev;
 	uint32_t gpmu_throttle_counters[ADRENO_GPMU_THROTTLE_COUNTERS];
+	unsigned int preempt_budget_us;
 };
 
 /**
@@ -403,6 +406,8 @@ struct adreno_device {
  * @ADRENO_DEVICE_GPMU_INITIALIZED - Set if GPMU firmware initialization succeed
  * @ADRENO_DEVICE_ISDB_ENABLED - Set if the Integrated Shader DeBugger is
  * attached and enabled
+ * @ADRENO_DEVICE_PREEMPT_LOW_LATENCY - Reserve the highest priority ringbuffer
+ * for priority 0 contexts and make everything else preemptible at draw level
  */
 enum adreno_device_flags {
 	ADRENO_DEVICE_PWRON = 0,
@@ -418,6 +423,7 @@ enum adreno_device_flags {
 	ADRENO_DEVICE_SOFT_FAULT_DETECT = 10,
 	ADRENO_DEVICE_GPMU_INITIALIZED = 11,
 	ADRENO_DEVICE_ISDB_ENABLED = 12,
+	ADRENO_DEVICE_PREEMPT_LOW_LATENCY = 13,
 };
 
 /**
@@ -1361,6 +1367,17 @@ static inline struct adreno_ringbuffer *adreno_ctx_get_rb(
 	 * Divide up the context priority based on number of ringbuffer levels.
 	 */
 	level = context->priority / adreno_dev->num_ringbuffers;
+
+	/*
+	 * In low latency mode only the priority 0 contexts (compositor, VR
+	 * timewarp) get the highest priority ringbuffer, so that they never
+	 * queue up behind another client's work on it
+	 */
+	if (level == 0 && context->priority != 0 &&
+		adreno_dev->num_ringbuffers > 1 &&
+		test_bit(ADRENO_DEVICE_PREEMPT_LOW_LATENCY, &adreno_dev->priv))
+		level = 1;
+
 	if (level < adreno_dev->num_ringbuffers)
 		return &(adreno_dev->ringbuffers[level]);
 	else
@@ -308,6 +308,16 @@ static int a5xx_preemption_pre_ibsubmit(
 		 */
 		if (context->flags & KGSL_CONTEXT_SECURE)
 			preempt_style = KGSL_CONTEXT_PREEMPT_STYLE_RINGBUFFER;
+		/*
+		 * In low latency mode everything below the highest priority
+		 * ringbuffer has to give way at the next draw, not at the end
+		 * of its IB. The UMD can still protect a section with
+		 * CP_PREEMPT_ENABLE_LOCAL.
+		 */
+		else if (test_bit(ADRENO_DEVICE_PREEMPT_LOW_LATENCY,
+				&adreno_dev->priv) &&
+				rb != &adreno_dev->ringbuffers[0])
+			preempt_style = KGSL_CONTEXT_PREEMPT_STYLE_FINEGRAIN;
 		else
 			preempt_style = ADRENO_PREEMPT_STYLE(context->flags);
 	}
@@ -3602,6 +3612,7 @@ static void a5xx_preempt_trig_state(
 				trace_adreno_hw_preempt_trig_to_comp(
 					adreno_dev->cur_rb,
 					adreno_dev->next_rb);
+				dispatcher->preempt_done_time = ktime_get();
 				atomic_set(&dispatcher->preemption_state,
 					ADRENO_DISPATCHER_PREEMPT_COMPLETE);
 			} else {
@@ -3731,6 +3742,7 @@ static void a5xx_preempt_clear_state(
 	trace_adreno_hw_preempt_clear_to_trig(adreno_dev->cur_rb,
 						adreno_dev->next_rb);
 	/* issue PREEMPT trigger */
+	dispatcher->preempt_trig_time = ktime_get();
 	adreno_writereg(adreno_dev, ADRENO_REG_CP_PREEMPT, 1);
 
 	adreno_dispatcher_schedule(device);
@@ -3801,6 +3813,8 @@ static void a5xx_preempt_complete_state(
 	adreno_dev->cur_rb->wptr_preempt_end = 0xFFFFFFFF;
 	adreno_dev->next_rb = NULL;
 
+	adreno_dispatcher_preempt_account(adreno_dev);
+
 	if (adreno_disp_preempt_fair_sched) {
 		/* starved rb is now scheduled so unhalt dispatcher */
 		if (ADRENO_DISPATCHER_RB_STARVE_TIMER_ELAPSED ==
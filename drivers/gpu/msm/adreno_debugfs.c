@@ -123,6 +123,66 @@ static int _active_count_get(void *data, u64 *val)
 
 DEFINE_SIMPLE_ATTRIBUTE(_active_count_fops, _active_count_get, NULL, "%llu\n");
 
+static int _preempt_stats_print(struct seq_file *s, void *unused)
+{
+	struct kgsl_device *device = s->private;
+	struct adreno_device *adreno_dev = ADRENO_DEVICE(device);
+	struct adreno_preempt_stats stats;
+	unsigned int i;
+
+	mutex_lock(&device->mutex);
+	stats = adreno_dev->dispatcher.preempt_stats;
+	mutex_unlock(&device->mutex);
+
+	seq_printf(s, "low_latency: %d\n",
+		test_bit(ADRENO_DEVICE_PREEMPT_LOW_LATENCY, &adreno_dev->priv));
+	seq_printf(s, "budget_us: %u\n", adreno_dev->preempt_budget_us);
+	seq_printf(s, "count: %u\n", stats.count);
+	seq_printf(s, "over_budget: %u\n", stats.over_budget);
+	seq_printf(s, "max_us: %u\n", stats.max_us);
+	seq_printf(s, "avg_us: %llu\n", stats.count ?
+		div_u64(stats.total_us, stats.count) : 0);
+
+	for (i = 0; i < adreno_dev->num_ringbuffers; i++)
+		seq_printf(s, "to_rb%u: %u\n", i, stats.to_rb[i]);
+
+	seq_printf(s, "%8s %8s\n", "<us", "count");
+	for (i = 0; i < ADRENO_PREEMPT_HIST_BUCKETS - 1; i++)
+		seq_printf(s, "%8u %8u\n", 16 << i, stats.hist[i]);
+	seq_printf(s, "%8s %8u\n", "inf", stats.hist[i]);
+
+	return 0;
+}
+
+static int _preempt_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, _preempt_stats_print, inode->i_private);
+}
+
+/* Any write clears the statistics */
+static ssize_t _preempt_stats_write(struct file *file,
+		const char __user *buf, size_t count, loff_t *ppos)
+{
+	struct kgsl_device *device =
+		((struct seq_file *)file->private_data)->private;
+	struct adreno_device *adreno_dev = ADRENO_DEVICE(device);
+
+	mutex_lock(&device->mutex);
+	memset(&adreno_dev->dispatcher.preempt_stats, 0,
+		sizeof(adreno_dev->dispatcher.preempt_stats));
+	mutex_unlock(&device->mutex);
+
+	return count;
+}
+
+static const struct file_operations _preempt_stats_fops = {
+	.open = _preempt_stats_open,
+	.read = seq_read,
+	.write = _preempt_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 typedef void (*reg_read_init_t)(struct kgsl_device *device);
 typedef void (*reg_read_fill_t)(struct kgsl_device *device, int i,
 	unsigned int *vals, int linec);
@@ -374,7 +434,10 @@ void adreno_debugfs_init(struct adreno_device *adreno_dev)
 			device->d_debugfs, device, &_lm_threshold_fops);
 	}
 
-	if (adreno_is_a5xx(adreno_dev))
+	if (adreno_is_a5xx(adreno_dev)) {
 		debugfs_create_file("isdb", 0644, device->d_debugfs,
 			device, &_isdb_fops);
+		debugfs_create_file("preempt_stats", 0644, device->d_debugfs,
+			device, &_preempt_stats_fops);
+	}
 }
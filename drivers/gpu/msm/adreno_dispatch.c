@@ -79,6 +79,10 @@ unsigned int adreno_cmdbatch_timeout = 2000;
 /* Interval for reading and comparing fault detection registers */
 static unsigned int _fault_timer_interval = 200;
 
+/* Number of command batches with a deadline that retired before / after it */
+static unsigned int _deadline_met;
+static unsigned int _deadline_missed;
+
 /**
  * _track_context - Add a context ID to the list of recently seen contexts
  * for the command queue
@@ -310,11 +314,44 @@ static bool _marker_expired(struct kgsl_cmdbatch *cmdbatch)
 			cmdbatch->marker_timestamp);
 }
 
+/**
+ * _update_context_deadline() - Recompute the earliest deadline of a context
+ * @drawctxt: Pointer to the adreno draw context
+ *
+ * Walk the queued command batches and cache the earliest deadline so the
+ * dispatcher can sort contexts without taking the context lock. Must be
+ * called with drawctxt->lock held.
+ */
+static void _update_context_deadline(struct adreno_context *drawctxt)
+{
+	unsigned int i = drawctxt->cmdqueue_head;
+	uint64_t deadline = 0;
+
+	while (i != drawctxt->cmdqueue_tail) {
+		uint64_t d = drawctxt->cmdqueue[i]->deadline;
+
+		if (d && (!deadline || d < deadline))
+			deadline = d;
+
+		i = CMDQUEUE_NEXT(i, ADRENO_CONTEXT_CMDQUEUE_SIZE);
+	}
+
+	drawctxt->deadline = deadline;
+}
+
 static inline void _pop_cmdbatch(struct adreno_context *drawctxt)
 {
+	struct kgsl_cmdbatch *cmdbatch =
+		drawctxt->cmdqueue[drawctxt->cmdqueue_head];
+	uint64_t deadline = cmdbatch->deadline;
+
 	drawctxt->cmdqueue_head = CMDQUEUE_NEXT(drawctxt->cmdqueue_head,
 		ADRENO_CONTEXT_CMDQUEUE_SIZE);
 	drawctxt->queued--;
+
+	/* Only rescan if the batch going away could have been the earliest */
+	if (deadline && deadline <= drawctxt->deadline)
+		_update_context_deadline(drawctxt);
 }
 /**
  * Removes all expired marker and sync cmdbatches from
@@ -473,6 +510,11 @@ static inline int adreno_dispatcher_requeue_cmdbatch(
 
 	/* Reset the command queue head to reflect the newly requeued change */
 	drawctxt->cmdqueue_head = prev;
+
+	if (cmdbatch->deadline && (!drawctxt->deadline ||
+		cmdbatch->deadline < drawctxt->deadline))
+		drawctxt->deadline = cmdbatch->deadline;
+
 	spin_unlock(&drawctxt->lock);
 	return 0;
 }
@@ -558,8 +600,18 @@ static int sendcmd(struct adreno_device *adreno_dev,
 			ADRENO_CMDBATCH_PROFILE_COUNT;
 	}
 
+	/*
+	 * If the GPU already has work queued on this ringbuffer there is no
+	 * hurry to tell it about this batch. Hold the wptr so that a burst
+	 * of small batches goes out with a single register write once the
+	 * dispatcher is done filling the ringbuffers.
+	 */
+	drawctxt->rb->wptr_defer = (dispatch_q->inflight > 1);
+
 	ret = adreno_ringbuffer_submitcmd(adreno_dev, cmdbatch, &time);
 
+	drawctxt->rb->wptr_defer = false;
+
 	/*
 	 * On the first command, if the submission was successful, then read the
 	 * fault registers.  If it failed then turn off the GPU. Sad face.
@@ -752,6 +804,36 @@ static int dispatcher_context_sendcmds(struct adreno_device *adreno_dev,
 	return ret;
 }
 
+/**
+ * _next_pending_context() - Pick the next context to dispatch from
+ * @dispatcher: Pointer to the adreno dispatcher struct
+ *
+ * Contexts with a deadline go first, earliest deadline first. If nobody has
+ * a deadline fall back to the head of the priority list. Must be called with
+ * the plist_lock held and the pending list not empty.
+ */
+static struct adreno_context *_next_pending_context(
+		struct adreno_dispatcher *dispatcher)
+{
+	struct adreno_context *drawctxt, *next = NULL;
+	uint64_t deadline = 0;
+
+	plist_for_each_entry(drawctxt, &dispatcher->pending, pending) {
+		uint64_t d = ACCESS_ONCE(drawctxt->deadline);
+
+		if (d && (!deadline || d < deadline)) {
+			deadline = d;
+			next = drawctxt;
+		}
+	}
+
+	if (next == NULL)
+		next = plist_first_entry(&dispatcher->pending,
+			struct adreno_context, pending);
+
+	return next;
+}
+
 /**
  * _adreno_dispatcher_issuecmds() - Issue commmands from pending contexts
  * @adreno_dev: Pointer to the adreno device struct
@@ -761,10 +843,12 @@ static int dispatcher_context_sendcmds(struct adreno_device *adreno_dev,
  */
 static void _adreno_dispatcher_issuecmds(struct adreno_device *adreno_dev)
 {
+	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
 	struct adreno_dispatcher *dispatcher = &adreno_dev->dispatcher;
 	struct adreno_context *drawctxt, *next;
+	struct adreno_ringbuffer *rb;
 	struct plist_head requeue, busy_list;
-	int ret;
+	int ret, i;
 
 	/* Leave early if the dispatcher isn't in a happy state */
 	if (adreno_gpu_fault(adreno_dev) != 0)
@@ -791,8 +875,7 @@ static void _adreno_dispatcher_issuecmds(struct adreno_device *adreno_dev)
 		}
 
 		/* Get the next entry on the list */
-		drawctxt = plist_first_entry(&dispatcher->pending,
-			struct adreno_context, pending);
+		drawctxt = _next_pending_context(dispatcher);
 
 		plist_del(&drawctxt->pending, &dispatcher->pending);
 
@@ -861,6 +944,17 @@ static void _adreno_dispatcher_issuecmds(struct adreno_device *adreno_dev)
 	}
 
 	spin_unlock(&dispatcher->plist_lock);
+
+	/*
+	 * Kick off anything that was queued with a deferred wptr. On a
+	 * fault the recovery restarts the ringbuffers so leave them be.
+	 */
+	mutex_lock(&device->mutex);
+	if (adreno_gpu_fault(adreno_dev) == 0) {
+		FOR_EACH_RINGBUFFER(adreno_dev, rb, i)
+			adreno_ringbuffer_flush_wptr(rb);
+	}
+	mutex_unlock(&device->mutex);
 }
 
 /**
@@ -937,17 +1031,61 @@ static void adreno_dispatcher_preempt_timer(unsigned long data)
 	adreno_dispatcher_schedule(KGSL_DEVICE(adreno_dev));
 }
 
+/**
+ * _dispatch_q_deadline() - Return the earliest deadline inflight on a RB
+ * @dispatch_q: Dispatch queue of the ringbuffer
+ *
+ * Returns 0 if none of the inflight command batches has a deadline
+ */
+static uint64_t _dispatch_q_deadline(
+		struct adreno_dispatcher_cmdqueue *dispatch_q)
+{
+	unsigned int i = dispatch_q->head;
+	uint64_t deadline = 0;
+
+	while (i != dispatch_q->tail) {
+		uint64_t d = dispatch_q->cmd_q[i]->deadline;
+
+		if (d && (!deadline || d < deadline))
+			deadline = d;
+
+		i = CMDQUEUE_NEXT(i, ADRENO_DISPATCH_CMDQUEUE_SIZE);
+	}
+
+	return deadline;
+}
+
 /**
  * adreno_dispatcher_get_highest_busy_rb() - Returns the highest priority RB
  * which is busy
  * @adreno_dev: Device whose RB is returned
+ *
+ * A busy RB carrying the earliest inflight deadline is returned ahead of
+ * the priority order so that frame work can preempt background work.
  */
 struct adreno_ringbuffer *adreno_dispatcher_get_highest_busy_rb(
 					struct adreno_device *adreno_dev)
 {
 	struct adreno_ringbuffer *rb, *highest_busy_rb = NULL;
+	uint64_t deadline = 0;
 	int i;
 
+	FOR_EACH_RINGBUFFER(adreno_dev, rb, i) {
+		uint64_t d;
+
+		if (rb->rptr == rb->wptr)
+			continue;
+
+		d = _dispatch_q_deadline(&rb->dispatch_q);
+		if (d && (!deadline || d < deadline)) {
+			deadline = d;
+			highest_busy_rb = rb;
+		}
+	}
+
+	if (highest_busy_rb)
+		goto done;
+
 	FOR_EACH_RINGBUFFER(adreno_dev, rb, i) {
 		if (rb->rptr != rb->wptr && !highest_busy_rb) {
 			highest_busy_rb = rb;
@@ -1176,6 +1314,11 @@ int adreno_dispatcher_queue_cmd(struct adreno_device *adreno_dev,
 	}
 
 	drawctxt->queued++;
+
+	if (cmdbatch->deadline && (!drawctxt->deadline ||
+		cmdbatch->deadline < drawctxt->deadline))
+		drawctxt->deadline = cmdbatch->deadline;
+
 	trace_adreno_cmdbatch_queued(cmdbatch, drawctxt->queued);
 
 	_track_context(dispatch_q, drawctxt->base.id);
@@ -2003,14 +2146,38 @@ int adreno_dispatch_process_cmdqueue(struct adreno_device *adreno_dev,
 			 * retired ticks from the buffer
 			 */
 
-			if (test_bit(CMDBATCH_FLAG_PROFILE, &cmdbatch->priv))
+			if (test_bit(CMDBATCH_FLAG_PROFILE, &cmdbatch->priv)) {
 				cmdbatch_profile_ticks(adreno_dev, cmdbatch,
 					&start_ticks, &retire_ticks);
 
+				/* Charge the GPU time to the owning process */
+				if (start_ticks && retire_ticks > start_ticks) {
+					struct kgsl_process_private *proc =
+						cmdbatch->context->proc_priv;
+
+					atomic64_add(retire_ticks - start_ticks,
+						&proc->gpu_ticks);
+				}
+			}
+
 			trace_adreno_cmdbatch_retired(cmdbatch,
 				(int) dispatcher->inflight, start_ticks,
 				retire_ticks, ADRENO_CMDBATCH_RB(cmdbatch));
 
+			/* Let pwrscale close the frame once we hold the lock */
+			if (cmdbatch->flags & KGSL_CMDBATCH_END_OF_FRAME)
+				set_bit(ADRENO_DISPATCHER_FRAME,
+					&dispatcher->priv);
+
+			if (cmdbatch->deadline) {
+				uint64_t now = ktime_to_ns(ktime_get());
+
+				if (now > cmdbatch->deadline)
+					_deadline_missed++;
+				else
+					_deadline_met++;
+			}
+
 			/* Record the delta between submit and retire ticks */
 			drawctxt->submit_retire_ticks[drawctxt->ticks_index] =
 				retire_ticks - cmdbatch->submit_ticks;
@@ -2153,6 +2320,9 @@ done:
 
 		/* There are still things in flight - update the idle counts */
 		mutex_lock(&device->mutex);
+		if (test_and_clear_bit(ADRENO_DISPATCHER_FRAME,
+			&dispatcher->priv))
+			kgsl_pwrscale_frame_retire(device);
 		kgsl_pwrscale_update(device);
 		mod_timer(&device->idle_timer, jiffies +
 				device->pwrctrl.interval_timeout);
@@ -2161,6 +2331,10 @@ done:
 		/* There is nothing left in the pipeline.  Shut 'er down boys */
 		mutex_lock(&device->mutex);
 
+		if (test_and_clear_bit(ADRENO_DISPATCHER_FRAME,
+			&dispatcher->priv))
+			kgsl_pwrscale_frame_retire(device);
+
 		if (test_and_clear_bit(ADRENO_DISPATCHER_ACTIVE,
 			&dispatcher->priv))
 			complete_all(&dispatcher->idle_gate);
@@ -2394,6 +2568,8 @@ static DISPATCHER_UINT_ATTR(dispatch_time_slice, 0644, 0,
 	_dispatch_time_slice);
 static DISPATCHER_UINT_ATTR(dispatch_starvation_time, 0644, 0,
 	_dispatch_starvation_time);
+static DISPATCHER_UINT_ATTR(deadline_met, 0444, 0, _deadline_met);
+static DISPATCHER_UINT_ATTR(deadline_missed, 0444, 0, _deadline_missed);
 
 static struct attribute *dispatcher_attrs[] = {
 	&dispatcher_attr_inflight.attr,
@@ -2408,6 +2584,8 @@ static struct attribute *dispatcher_attrs[] = {
 	&dispatcher_attr_disp_preempt_fair_sched.attr,
 	&dispatcher_attr_dispatch_time_slice.attr,
 	&dispatcher_attr_dispatch_starvation_time.attr,
+	&dispatcher_attr_deadline_met.attr,
+	&dispatcher_attr_deadline_missed.attr,
 	NULL,
 };
 
@@ -2484,6 +2662,8 @@ int adreno_dispatcher_init(struct adreno_device *adreno_dev)
 	atomic_set(&dispatcher->preemption_state,
 		ADRENO_DISPATCHER_PREEMPT_CLEAR);
 
+	adreno_dev->preempt_budget_us = ADRENO_PREEMPT_BUDGET_US;
+
 	ret = kobject_init_and_add(&dispatcher->kobj, &ktype_dispatcher,
 		&device->dev->kobj, "dispatch");
 
@@ -2583,7 +2763,44 @@ void adreno_dispatcher_preempt_callback(struct adreno_device *adreno_dev,
 	}
 	trace_adreno_hw_preempt_trig_to_comp_int(adreno_dev->cur_rb,
 			      adreno_dev->next_rb);
+	dispatcher->preempt_done_time = ktime_get();
 	atomic_set(&dispatcher->preemption_state,
 			ADRENO_DISPATCHER_PREEMPT_COMPLETE);
 	adreno_dispatcher_schedule(KGSL_DEVICE(adreno_dev));
 }
+
+/**
+ * adreno_dispatcher_preempt_account() - Record the latency of a preemption
+ * @adreno_dev: The device on which the preemption completed
+ *
+ * Called with the device mutex held once the switch to the new ringbuffer
+ * has been committed, i.e. adreno_dev->cur_rb is the destination
+ */
+void adreno_dispatcher_preempt_account(struct adreno_device *adreno_dev)
+{
+	struct adreno_dispatcher *dispatcher = &(adreno_dev->dispatcher);
+	struct adreno_preempt_stats *stats = &dispatcher->preempt_stats;
+	unsigned int us, bucket;
+
+	us = ktime_us_delta(dispatcher->preempt_done_time,
+			dispatcher->preempt_trig_time);
+	bucket = min_t(unsigned int, fls(us >> 4),
+			ADRENO_PREEMPT_HIST_BUCKETS - 1);
+
+	stats->count++;
+	stats->to_rb[adreno_dev->cur_rb->id]++;
+	stats->hist[bucket]++;
+	stats->total_us += us;
+	if (us > stats->max_us)
+		stats->max_us = us;
+
+	if (us > adreno_dev->preempt_budget_us) {
+		stats->over_budget++;
+		if (test_bit(ADRENO_DEVICE_PREEMPT_LOW_LATENCY,
+				&adreno_dev->priv))
+			KGSL_DRV_INFO(KGSL_DEVICE(adreno_dev),
+				"Preemption to RB%d took %uus, budget %uus\n",
+				adreno_dev->cur_rb->id, us,
+				adreno_dev->preempt_budget_us);
+	}
+}
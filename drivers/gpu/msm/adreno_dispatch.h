@@ -18,6 +18,12 @@
 /* Time to allow preemption to complete (in ms) */
 #define ADRENO_DISPATCH_PREEMPT_TIMEOUT 10000
 
+/* Default preemption latency budget for the low latency mode (in us) */
+#define ADRENO_PREEMPT_BUDGET_US 1000
+
+/* Number of log2 buckets in the preemption latency histogram */
+#define ADRENO_PREEMPT_HIST_BUCKETS 12
+
 extern unsigned int adreno_disp_preempt_fair_sched;
 extern unsigned int adreno_cmdbatch_timeout;
 
@@ -89,6 +95,25 @@ struct adreno_dispatcher_cmdqueue {
 	int active_context_count;
 };
 
+/**
+ * struct adreno_preempt_stats - Ringbuffer preemption latency statistics
+ * @count: Number of preemptions that completed
+ * @to_rb: Number of preemptions that completed, per destination ringbuffer
+ * @hist: Latency histogram, bucket 0 is < 16us and bucket n covers
+ * [8 << n, 16 << n) us; the last bucket also holds everything above it
+ * @max_us: Longest preemption seen
+ * @total_us: Sum of all preemption latencies
+ * @over_budget: Number of preemptions that took longer than the budget
+ */
+struct adreno_preempt_stats {
+	unsigned int count;
+	unsigned int to_rb[KGSL_PRIORITY_MAX_RB_LEVELS];
+	unsigned int hist[ADRENO_PREEMPT_HIST_BUCKETS];
+	unsigned int max_us;
+	uint64_t total_us;
+	unsigned int over_budget;
+};
+
 /**
  * struct adreno_dispatcher - container for the adreno GPU dispatcher
  * @mutex: Mutex to protect the structure
@@ -109,6 +134,9 @@ struct adreno_dispatcher_cmdqueue {
  * @disp_preempt_fair_sched: If set then dispatcher will try to be fair to
  * starving RB's by scheduling them in and enforcing a minimum time slice
  * for every RB that is scheduled to run on the device
+ * @preempt_trig_time: Time the current preemption was triggered
+ * @preempt_done_time: Time the current preemption was seen to complete
+ * @preempt_stats: Preemption latency statistics
  */
 struct adreno_dispatcher {
 	struct mutex mutex;
@@ -126,11 +154,15 @@ struct adreno_dispatcher {
 	int preempt_token_submit;
 	struct timer_list preempt_timer;
 	unsigned int disp_preempt_fair_sched;
+	ktime_t preempt_trig_time;
+	ktime_t preempt_done_time;
+	struct adreno_preempt_stats preempt_stats;
 };
 
 enum adreno_dispatcher_flags {
 	ADRENO_DISPATCHER_POWER = 0,
 	ADRENO_DISPATCHER_ACTIVE = 1,
+	ADRENO_DISPATCHER_FRAME = 2,
 };
 
 void adreno_dispatcher_start(struct kgsl_device *device);
@@ -157,5 +189,6 @@ int adreno_dispatch_process_cmdqueue(struct adreno_device *adreno_dev,
 				int long_ib_detect);
 void adreno_preempt_process_dispatch_queue(struct adreno_device *adreno_dev,
 	struct adreno_dispatcher_cmdqueue *dispatch_q);
+void adreno_dispatcher_preempt_account(struct adreno_device *adreno_dev);
 
 #endif /* __ADRENO_DISPATCHER_H */
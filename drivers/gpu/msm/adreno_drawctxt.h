@@ -49,6 +49,8 @@ struct kgsl_context;
  *                       to retire
  * @ticks_index: The index into submit_retire_ticks[] where the new delta will
  *		 be written.
+ * @deadline: Earliest deadline (in ns) of the command batches waiting in the
+ *	      cmdqueue or 0 if none of them has one
  */
 struct adreno_context {
 	struct kgsl_context base;
@@ -74,6 +76,7 @@ struct adreno_context {
 	unsigned int submitted_timestamp;
 	uint64_t submit_retire_ticks[SUBMIT_RETIRE_TICKS_SIZE];
 	int ticks_index;
+	uint64_t deadline;
 };
 
 /* Flag definitions for flag field in adreno_context */
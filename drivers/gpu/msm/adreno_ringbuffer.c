@@ -130,7 +130,42 @@ void adreno_ringbuffer_submit(struct adreno_ringbuffer *rb,
 		 * been submitted.
 		 */
 		kgsl_pwrscale_busy(KGSL_DEVICE(adreno_dev));
+
+		/*
+		 * The dispatcher is queueing more commands behind this
+		 * one, hold the wptr until the whole batch is in the
+		 * ringbuffer
+		 */
+		if (rb->wptr_defer) {
+			rb->wptr_pending = true;
+			return;
+		}
+
 		adreno_writereg(adreno_dev, ADRENO_REG_CP_RB_WPTR, rb->wptr);
+		rb->wptr_pending = false;
+		rb->irq_cmd = NULL;
+	}
+}
+
+/**
+ * adreno_ringbuffer_flush_wptr() - Give deferred commands to the hardware
+ * @rb: Pointer to the ringbuffer
+ *
+ * Write the wptr for any commands that were queued while the dispatcher was
+ * deferring wptr updates. Must be called with the device mutex held.
+ */
+void adreno_ringbuffer_flush_wptr(struct adreno_ringbuffer *rb)
+{
+	struct adreno_device *adreno_dev = ADRENO_RB_DEVICE(rb);
+
+	if (!rb->wptr_pending)
+		return;
+
+	if (adreno_preempt_state(adreno_dev, ADRENO_DISPATCHER_PREEMPT_CLEAR) &&
+		(adreno_dev->cur_rb == rb)) {
+		adreno_writereg(adreno_dev, ADRENO_REG_CP_RB_WPTR, rb->wptr);
+		rb->wptr_pending = false;
+		rb->irq_cmd = NULL;
 	}
 }
 
@@ -180,6 +215,9 @@ adreno_ringbuffer_waitspace(struct adreno_ringbuffer *rb,
 	unsigned int rptr;
 	struct adreno_device *adreno_dev = ADRENO_RB_DEVICE(rb);
 
+	/* The rptr can't move past commands the hardware hasn't seen yet */
+	adreno_ringbuffer_flush_wptr(rb);
+
 	/* if wptr ahead, fill the remaining with NOPs */
 	if (wptr_ahead) {
 		/* -1 for header */
@@ -306,6 +344,8 @@ static void _ringbuffer_setup_common(struct adreno_device *adreno_dev)
 		rb->wptr = 0;
 		rb->rptr = 0;
 		rb->wptr_preempt_end = 0xFFFFFFFF;
+		rb->wptr_pending = false;
+		rb->irq_cmd = NULL;
 		rb->starve_timer_state =
 		ADRENO_DISPATCHER_RB_STARVE_TIMER_UNINIT;
 		adreno_iommu_set_pt_generate_rb_cmds(rb,
@@ -752,9 +792,22 @@ adreno_ringbuffer_addcmds(struct adreno_ringbuffer *rb,
 	 * set and hence the rb timestamp will be used in else statement below.
 	 */
 	*ringcmds++ = cp_mem_packet(adreno_dev, CP_EVENT_WRITE, 3, 1);
-	if (drawctxt || (flags & KGSL_CMD_FLAGS_INTERNAL_ISSUE))
+	if (drawctxt || (flags & KGSL_CMD_FLAGS_INTERNAL_ISSUE)) {
+		/*
+		 * If the previous submission is still waiting for its wptr
+		 * then only the last timestamp in the batch needs to raise
+		 * an interrupt. The hardware can't have fetched the earlier
+		 * dword yet so it is safe to rewrite it. Preemption moves
+		 * the wptr behind our back so leave it alone in that case.
+		 */
+		if (rb->wptr_defer && rb->wptr_pending && rb->irq_cmd &&
+			!device->cff_dump_enable &&
+			!adreno_is_preemption_enabled(adreno_dev))
+			*rb->irq_cmd &= ~(1 << 31);
+
+		rb->irq_cmd = rb->wptr_defer ? ringcmds : NULL;
 		*ringcmds++ = CACHE_FLUSH_TS | (1 << 31);
-	else
+	} else
 		*ringcmds++ = CACHE_FLUSH_TS;
 
 	if (drawctxt && !(flags & KGSL_CMD_FLAGS_INTERNAL_ISSUE)) {
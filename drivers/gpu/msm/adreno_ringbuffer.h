@@ -102,6 +102,11 @@ struct adreno_ringbuffer_pagetable_info {
  * @sched_timer: Timer that tracks how long RB has been waiting to be scheduled
  * or how long it has been scheduled for after preempting in
  * @starve_timer_state: Indicates the state of the wait.
+ * @wptr_defer: Set by the dispatcher while it queues commands that can wait
+ * for a later wptr update
+ * @wptr_pending: True if rb->wptr is ahead of the wptr given to the hardware
+ * @irq_cmd: CACHE_FLUSH_TS dword of the last deferred submission, used to
+ * fold the retire interrupts of a batch into one
  */
 struct adreno_ringbuffer {
 	uint32_t flags;
@@ -125,6 +130,9 @@ struct adreno_ringbuffer {
 	int preempted_midway;
 	unsigned long sched_timer;
 	enum adreno_dispatcher_starve_timer_states starve_timer_state;
+	bool wptr_defer;
+	bool wptr_pending;
+	unsigned int *irq_cmd;
 };
 
 /* enable timestamp (...scratch0) memory shadowing */
@@ -174,6 +182,8 @@ void adreno_ringbuffer_submit(struct adreno_ringbuffer *rb,
 int adreno_ringbuffer_submit_spin(struct adreno_ringbuffer *rb,
 		struct adreno_submit_time *time, unsigned int timeout);
 
+void adreno_ringbuffer_flush_wptr(struct adreno_ringbuffer *rb);
+
 int adreno_ringbuffer_submit_spin_retry(struct adreno_ringbuffer *rb,
 		struct adreno_submit_time *time, unsigned int timeout,
 		unsigned int retry);
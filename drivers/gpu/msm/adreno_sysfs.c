@@ -190,6 +190,46 @@ static unsigned int _preemption_show(struct adreno_device *adreno_dev)
 	return adreno_is_preemption_enabled(adreno_dev);
 }
 
+/*
+ * The ringbuffer of a context is picked when it is created, so the low
+ * latency mode applies to contexts created after it is changed. The
+ * preemption style is picked per submission and changes right away.
+ */
+static int _preempt_low_latency_store(struct adreno_device *adreno_dev,
+		unsigned int val)
+{
+	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
+
+	mutex_lock(&device->mutex);
+	if (val)
+		set_bit(ADRENO_DEVICE_PREEMPT_LOW_LATENCY, &adreno_dev->priv);
+	else
+		clear_bit(ADRENO_DEVICE_PREEMPT_LOW_LATENCY, &adreno_dev->priv);
+	mutex_unlock(&device->mutex);
+
+	return 0;
+}
+
+static unsigned int _preempt_low_latency_show(struct adreno_device *adreno_dev)
+{
+	return test_bit(ADRENO_DEVICE_PREEMPT_LOW_LATENCY, &adreno_dev->priv);
+}
+
+static int _preempt_budget_us_store(struct adreno_device *adreno_dev,
+		unsigned int val)
+{
+	if (val == 0)
+		return -EINVAL;
+
+	adreno_dev->preempt_budget_us = val;
+	return 0;
+}
+
+static unsigned int _preempt_budget_us_show(struct adreno_device *adreno_dev)
+{
+	return adreno_dev->preempt_budget_us;
+}
+
 static int _sptp_pc_store(struct adreno_device *adreno_dev,
 		unsigned int val)
 {
@@ -303,6 +343,8 @@ static DEVICE_INT_ATTR(wake_timeout, 0644, adreno_wake_timeout);
 static ADRENO_SYSFS_BOOL(sptp_pc);
 static ADRENO_SYSFS_BOOL(lm);
 static ADRENO_SYSFS_BOOL(preemption);
+static ADRENO_SYSFS_BOOL(preempt_low_latency);
+static ADRENO_SYSFS_U32(preempt_budget_us);
 
 static const struct device_attribute *_attr_list[] = {
 	&adreno_attr_ft_policy.attr,
@@ -315,6 +357,8 @@ static const struct device_attribute *_attr_list[] = {
 	&adreno_attr_sptp_pc.attr,
 	&adreno_attr_lm.attr,
 	&adreno_attr_preemption.attr,
+	&adreno_attr_preempt_low_latency.attr,
+	&adreno_attr_preempt_budget_us.attr,
 	NULL,
 };
 
@@ -42,6 +42,7 @@
 #include "kgsl_sync.h"
 #include "kgsl_compat.h"
 #include "kgsl_htc.h"
+#include "kgsl_pool.h"
 
 #undef MODULE_PARAM_PREFIX
 #define MODULE_PARAM_PREFIX "kgsl."
@@ -273,23 +274,14 @@ static void kgsl_destroy_ion(struct kgsl_dma_buf_meta *meta)
 }
 #endif
 
-void
-kgsl_mem_entry_destroy(struct kref *kref)
+/* Free the memory of an entry that is no longer mapped by the GPU */
+static void kgsl_mem_entry_free(struct kgsl_mem_entry *entry)
 {
-	struct kgsl_mem_entry *entry = container_of(kref,
-						    struct kgsl_mem_entry,
-						    refcount);
 	unsigned int memtype;
 
-	if (entry == NULL)
-		return;
-
 	/* pull out the memtype before the flags get cleared */
 	memtype = kgsl_memdesc_usermem_type(&entry->memdesc);
 
-	/* Detach from process list */
-	kgsl_mem_entry_detach_process(entry);
-
 	if (memtype != KGSL_MEM_ENTRY_KERNEL)
 		atomic_long_sub(entry->memdesc.size,
 			&kgsl_driver.stats.mapped);
@@ -331,6 +323,67 @@ kgsl_mem_entry_destroy(struct kref *kref)
 
 	kfree(entry);
 }
+
+/*
+ * Entries that were unmapped without a TLB invalidate wait on this list
+ * until the next batched flush, so that the GPU can't reach their pages
+ * through a stale translation after they have been freed.
+ */
+static DEFINE_SPINLOCK(deferred_free_lock);
+static LIST_HEAD(deferred_free_list);
+
+static void _deferred_free(struct work_struct *work)
+{
+	struct kgsl_mem_entry *entry, *tmp;
+	LIST_HEAD(list);
+	int i;
+
+	spin_lock(&deferred_free_lock);
+	list_splice_init(&deferred_free_list, &list);
+	spin_unlock(&deferred_free_lock);
+
+	/* One invalidate covers every unmap that happened before the splice */
+	for (i = 0; i < KGSL_DEVICE_MAX; i++) {
+		if (kgsl_driver.devp[i] != NULL)
+			kgsl_mmu_flush_tlb(&kgsl_driver.devp[i]->mmu);
+	}
+
+	list_for_each_entry_safe(entry, tmp, &list, deferred_node) {
+		list_del(&entry->deferred_node);
+		kgsl_mem_entry_free(entry);
+	}
+}
+
+static DECLARE_WORK(deferred_free_work, _deferred_free);
+
+void
+kgsl_mem_entry_destroy(struct kref *kref)
+{
+	struct kgsl_mem_entry *entry = container_of(kref,
+						    struct kgsl_mem_entry,
+						    refcount);
+	struct kgsl_mmu *mmu = NULL;
+
+	if (entry == NULL)
+		return;
+
+	if (entry->memdesc.pagetable != NULL)
+		mmu = entry->memdesc.pagetable->mmu;
+
+	/* Detach from process list */
+	kgsl_mem_entry_detach_process(entry);
+
+	if (mmu != NULL && kgsl_mmu_tlb_flush_pending(mmu)) {
+		spin_lock(&deferred_free_lock);
+		list_add_tail(&entry->deferred_node, &deferred_free_list);
+		spin_unlock(&deferred_free_lock);
+
+		queue_work(kgsl_driver.workqueue, &deferred_free_work);
+		return;
+	}
+
+	kgsl_mem_entry_free(entry);
+}
 EXPORT_SYMBOL(kgsl_mem_entry_destroy);
 
 /**
@@ -3972,6 +4025,13 @@ int kgsl_device_platform_probe(struct kgsl_device *device)
 
 	kgsl_device_htc_init(device);
 
+	/*
+	 * Suspend and resume only move the GPU between SUSPEND and SLUMBER
+	 * under the device mutex and touch no other device, so they can run
+	 * in parallel with the rest of the platform.
+	 */
+	device_enable_async_suspend(&device->pdev->dev);
+
 	dev_info(device->dev, "Initialized %s: mmu=%s\n", device->name,
 		kgsl_mmu_enabled() ? "on" : "off");
 
@@ -4034,6 +4094,7 @@ static void kgsl_core_exit(void)
 	kgsl_cmdbatch_exit();
 
 	kgsl_memfree_exit();
+	kgsl_exit_page_pools();
 	unregister_chrdev_region(kgsl_driver.major, KGSL_DEVICE_MAX);
 }
 
@@ -4093,13 +4154,16 @@ static int __init kgsl_core_init(void)
 	kgsl_core_debugfs_init();
 
 	kgsl_sharedmem_init_sysfs();
+	kgsl_init_page_pools();
 	kgsl_cffdump_init();
 
 	INIT_LIST_HEAD(&kgsl_driver.process_list);
 
 	INIT_LIST_HEAD(&kgsl_driver.pagetable_list);
 
-	kgsl_driver.workqueue = create_singlethread_workqueue("kgsl-workqueue");
+	/* runs the dispatcher, keep it off the little-cluster-only policy */
+	kgsl_driver.workqueue = alloc_ordered_workqueue("kgsl-workqueue",
+				WQ_MEM_RECLAIM | WQ_LATENCY_SENSITIVE);
 	kgsl_driver.mem_workqueue =
 		create_singlethread_workqueue("kgsl-mementry");
 
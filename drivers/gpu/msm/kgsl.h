@@ -97,6 +97,8 @@ struct kgsl_driver {
 		atomic_long_t vmalloc_max;
 		atomic_long_t page_alloc;
 		atomic_long_t page_alloc_max;
+		atomic_long_t page_alloc_64k;
+		atomic_long_t page_alloc_2m;
 		atomic_long_t coherent;
 		atomic_long_t coherent_max;
 		atomic_long_t secure;
@@ -217,6 +219,7 @@ struct kgsl_mem_entry {
 	int pending_free;
 	char metadata[KGSL_GPUOBJ_ALLOC_METADATA_MAX + 1];
 	struct work_struct work;
+	struct list_head deferred_node;
 };
 
 struct kgsl_device_private;
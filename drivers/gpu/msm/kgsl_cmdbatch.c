@@ -429,6 +429,28 @@ done:
 	return ret;
 }
 
+/* kgsl_cmdbatch_add_sync_deadline() - Set the target retire time for a cmdbatch
+ * @device: KGSL device
+ * @cmdbatch: KGSL cmdbatch to add the deadline to
+ * @priv: Private sructure passed by the user
+ *
+ * A deadline doesn't create a sync event, it only tags the cmdbatch for the
+ * dispatcher. If more than one is given the earliest one wins.
+ */
+static int kgsl_cmdbatch_add_sync_deadline(struct kgsl_device *device,
+		struct kgsl_cmdbatch *cmdbatch, void *priv)
+{
+	struct kgsl_cmd_syncpoint_deadline *sync = priv;
+
+	if (sync->deadline_ns == 0)
+		return -EINVAL;
+
+	if (cmdbatch->deadline == 0 || sync->deadline_ns < cmdbatch->deadline)
+		cmdbatch->deadline = sync->deadline_ns;
+
+	return 0;
+}
+
 /**
  * kgsl_cmdbatch_add_sync() - Add a sync point to a command batch
  * @device: Pointer to the KGSL device struct for the GPU
@@ -456,6 +478,10 @@ int kgsl_cmdbatch_add_sync(struct kgsl_device *device,
 		psize = sizeof(struct kgsl_cmd_syncpoint_fence);
 		func = kgsl_cmdbatch_add_sync_fence;
 		break;
+	case KGSL_CMD_SYNCPOINT_TYPE_DEADLINE:
+		psize = sizeof(struct kgsl_cmd_syncpoint_deadline);
+		func = kgsl_cmdbatch_add_sync_deadline;
+		break;
 	default:
 		KGSL_DRV_ERR(device,
 			"bad syncpoint type ctxt %d type 0x%x size %zu\n",
@@ -50,6 +50,8 @@
  * @global_ts: The ringbuffer timestamp corresponding to this cmdbatch
  * @timeout_jiffies: For a syncpoint cmdbatch the jiffies at which the
  * timer will expire
+ * @deadline: CLOCK_MONOTONIC time in ns by which the cmdbatch should retire,
+ * or 0 if no deadline was given
  * This structure defines an atomic batch of command buffers issued from
  * userspace.
  */
@@ -76,6 +78,7 @@ struct kgsl_cmdbatch {
 	uint64_t submit_ticks;
 	unsigned int global_ts;
 	unsigned long timeout_jiffies;
+	uint64_t deadline;
 };
 
 /**
@@ -105,6 +105,9 @@ enum kgsl_event_results {
 /* Allocate 600K for the snapshot static region*/
 #define KGSL_SNAPSHOT_MEMSIZE (600 * 1024)
 
+/* Upper bound on the memory holding the GPU objects of a snapshot */
+#define KGSL_SNAPSHOT_MEMPOOL_MAX (8 * 1024 * 1024)
+
 struct kgsl_device;
 struct platform_device;
 struct kgsl_device_private;
@@ -265,6 +268,8 @@ struct kgsl_device {
 	struct {
 		void *ptr;
 		size_t size;
+		size_t mempool_max;
+		bool compress;
 	} snapshot_memory;
 
 	struct kgsl_snapshot *snapshot;
@@ -405,6 +410,7 @@ struct kgsl_context {
  * @syncsource_idr: sync sources created by this process
  * @syncsource_lock: Spinlock to protect the syncsource idr
  * @fd_count: Counter for the number of FDs for this process
+ * @gpu_ticks: Always on counter ticks spent on the GPU by this process
  */
 struct kgsl_process_private {
 	unsigned long priv;
@@ -424,6 +430,7 @@ struct kgsl_process_private {
 	struct idr syncsource_idr;
 	spinlock_t syncsource_lock;
 	int fd_count;
+	atomic64_t gpu_ticks;
 };
 
 /**
@@ -448,6 +455,8 @@ struct kgsl_device_private {
  * @timestamp: Timestamp of the snapshot instance (in seconds since boot)
  * @mempool: Pointer to the memory pool for storing memory objects
  * @mempool_size: Size of the memory pool
+ * @mempool_max: Upper bound on the mempool size
+ * @compress: Set if the GPU objects are to be LZ4 compressed in the mempool
  * @obj_list: List of frozen GPU buffers that are waiting to be dumped.
  * @cp_list: List of IB's to be dumped.
  * @work: worker to dump the frozen memory
@@ -463,6 +472,8 @@ struct kgsl_snapshot {
 	unsigned long timestamp;
 	u8 *mempool;
 	size_t mempool_size;
+	size_t mempool_max;
+	bool compress;
 	struct list_head obj_list;
 	struct list_head cp_list;
 	struct work_struct work;
@@ -38,6 +38,11 @@
 static struct kgsl_mmu_pt_ops iommu_pt_ops;
 static bool need_iommu_sync;
 
+/* Serializes the batched TLB invalidates for deferred unmaps */
+static DEFINE_MUTEX(kgsl_iommu_tlb_lock);
+
+static void kgsl_iommu_flush_tlb(struct kgsl_mmu *mmu);
+
 const unsigned int kgsl_iommu_reg_list[KGSL_IOMMU_REG_MAX] = {
 	0x0,/* SCTLR */
 	0x20,/* TTBR0 */
@@ -728,6 +733,7 @@ static void kgsl_iommu_destroy_pagetable(struct kgsl_pagetable *pt)
 	else {
 		ctx = &iommu->ctx[KGSL_IOMMU_CONTEXT_USER];
 		kgsl_iommu_unmap_globals(pt);
+		kgsl_iommu_flush_tlb(mmu);
 	}
 
 	if (iommu_pt->domain) {
@@ -813,6 +819,7 @@ _alloc_pt(struct device *dev, struct kgsl_mmu *mmu, struct kgsl_pagetable *pt)
 {
 	struct kgsl_iommu_pt *iommu_pt;
 	struct bus_type *bus = kgsl_mmu_get_bus(dev);
+	int use_cont_hint = 1;
 
 	if (bus == NULL)
 		return ERR_PTR(-ENODEV);
@@ -827,6 +834,13 @@ _alloc_pt(struct device *dev, struct kgsl_mmu *mmu, struct kgsl_pagetable *pt)
 		return ERR_PTR(-ENODEV);
 	}
 
+	/*
+	 * Let the SMMU driver mark 64K aligned runs of pages with the
+	 * contiguous hint. This has to be set before the domain is attached.
+	 */
+	iommu_domain_set_attr(iommu_pt->domain, DOMAIN_ATTR_USE_CONT_HINT,
+				&use_cont_hint);
+
 	pt->pt_ops = &iommu_pt_ops;
 	pt->priv = iommu_pt;
 	iommu_pt->rbtree = RB_ROOT;
@@ -993,6 +1007,7 @@ static int _init_per_process_pt(struct kgsl_mmu *mmu, struct kgsl_pagetable *pt)
 	struct kgsl_iommu *iommu = mmu->priv;
 	struct kgsl_iommu_context *ctx = &iommu->ctx[KGSL_IOMMU_CONTEXT_USER];
 	int dynamic = 1;
+	int defer_tlb_flush = 1;
 	unsigned int cb_num = ctx->cb_num;
 	int disable_htw = !MMU_FEATURE(mmu, KGSL_MMU_COHERENT_HTW);
 
@@ -1024,6 +1039,15 @@ static int _init_per_process_pt(struct kgsl_mmu *mmu, struct kgsl_pagetable *pt)
 	iommu_domain_set_attr(iommu_pt->domain,
 				DOMAIN_ATTR_COHERENT_HTW_DISABLE, &disable_htw);
 
+	/*
+	 * User buffers are unmapped from the per-process pagetables without
+	 * a TLB invalidate. kgsl_iommu_flush_tlb() does a single TLBIALL on
+	 * the context bank for all of them before any of the pages are freed.
+	 */
+	if (!iommu_domain_set_attr(iommu_pt->domain,
+				DOMAIN_ATTR_DEFER_TLB_FLUSH, &defer_tlb_flush))
+		iommu_pt->defer_tlb_flush = true;
+
 	ret = _attach_pt(iommu_pt, ctx);
 	if (ret)
 		goto done;
@@ -1320,12 +1344,19 @@ static int
 kgsl_iommu_unmap(struct kgsl_pagetable *pt,
 		struct kgsl_memdesc *memdesc)
 {
+	struct kgsl_iommu_pt *iommu_pt = pt->priv;
 	uint64_t size = memdesc->size;
+	int ret;
 
 	if (kgsl_memdesc_has_guard_page(memdesc))
 		size += kgsl_memdesc_guard_page_size(pt->mmu, memdesc);
 
-	return _iommu_unmap_sync_pc(pt, memdesc, memdesc->gpuaddr, size);
+	ret = _iommu_unmap_sync_pc(pt, memdesc, memdesc->gpuaddr, size);
+
+	if (iommu_pt->defer_tlb_flush)
+		atomic_set(&pt->mmu->tlb_dirty, 1);
+
+	return ret;
 }
 
 /**
@@ -1388,6 +1419,13 @@ kgsl_iommu_map(struct kgsl_pagetable *pt,
 
 	BUG_ON(NULL == pt->priv);
 
+	/*
+	 * The range may have been unmapped without a TLB invalidate, so get
+	 * rid of any stale translations before it is reused
+	 */
+	if (((struct kgsl_iommu_pt *) pt->priv)->defer_tlb_flush)
+		kgsl_iommu_flush_tlb(pt->mmu);
+
 	flags = IOMMU_READ | IOMMU_WRITE | IOMMU_NOEXEC;
 
 	/* Set up the protection for the page(s) */
@@ -1519,6 +1557,62 @@ kgsl_iommu_get_current_ttbr0(struct kgsl_mmu *mmu)
 	return val;
 }
 
+/* Invalidate the whole TLB of a context bank and wait for it to finish */
+static void _iommu_tlbiall(struct kgsl_mmu *mmu,
+		struct kgsl_iommu_context *ctx)
+{
+	unsigned long wait_for_flush;
+
+	KGSL_IOMMU_SET_CTX_REG(ctx, TLBIALL, 1);
+	/* make sure the TBLI write completes before we wait */
+	mb();
+	/*
+	 * Wait for flush to complete by polling the flush
+	 * status bit of TLBSTATUS register for not more than
+	 * 2 s. After 2s just exit, at that point the SMMU h/w
+	 * may be stuck and will eventually cause GPU to hang
+	 * or bring the system down.
+	 */
+	wait_for_flush = jiffies + msecs_to_jiffies(2000);
+	KGSL_IOMMU_SET_CTX_REG(ctx, TLBSYNC, 0);
+	while (KGSL_IOMMU_GET_CTX_REG(ctx, TLBSTATUS) &
+		(KGSL_IOMMU_CTX_TLBSTATUS_SACTIVE)) {
+		if (time_after(jiffies, wait_for_flush)) {
+			KGSL_DRV_WARN(KGSL_MMU_DEVICE(mmu),
+			"Wait limit reached for IOMMU tlb flush\n");
+			break;
+		}
+		cpu_relax();
+	}
+}
+
+/*
+ * kgsl_iommu_flush_tlb - Do the TLB invalidate for all deferred unmaps
+ * @mmu - Pointer to mmu structure
+ *
+ * All per-process pagetables share the user context bank, so a single
+ * TLBIALL covers every unmap done since the last flush. The lock makes
+ * sure that a caller that finds nothing to do still waits for a flush
+ * that is already in progress.
+ */
+static void kgsl_iommu_flush_tlb(struct kgsl_mmu *mmu)
+{
+	struct kgsl_iommu *iommu = mmu->priv;
+	struct kgsl_iommu_context *ctx = &iommu->ctx[KGSL_IOMMU_CONTEXT_USER];
+
+	mutex_lock(&kgsl_iommu_tlb_lock);
+
+	if (atomic_xchg(&mmu->tlb_dirty, 0)) {
+		_iommu_sync_mmu_pc(true);
+		kgsl_iommu_enable_clk(mmu);
+		_iommu_tlbiall(mmu, ctx);
+		kgsl_iommu_disable_clk(mmu);
+		_iommu_sync_mmu_pc(false);
+	}
+
+	mutex_unlock(&kgsl_iommu_tlb_lock);
+}
+
 /*
  * kgsl_iommu_set_pt - Change the IOMMU pagetable of the primary context bank
  * @mmu - Pointer to mmu structure
@@ -1538,7 +1632,6 @@ static int kgsl_iommu_set_pt(struct kgsl_mmu *mmu,
 	int ret = 0;
 	uint64_t ttbr0, temp;
 	unsigned int contextidr;
-	unsigned long wait_for_flush;
 
 	/*
 	 * If using a global pagetable, we can skip all this
@@ -1567,27 +1660,7 @@ static int kgsl_iommu_set_pt(struct kgsl_mmu *mmu,
 	mb();
 	temp = KGSL_IOMMU_GET_CTX_REG_Q(ctx, TTBR0);
 
-	KGSL_IOMMU_SET_CTX_REG(ctx, TLBIALL, 1);
-	/* make sure the TBLI write completes before we wait */
-	mb();
-	/*
-	 * Wait for flush to complete by polling the flush
-	 * status bit of TLBSTATUS register for not more than
-	 * 2 s. After 2s just exit, at that point the SMMU h/w
-	 * may be stuck and will eventually cause GPU to hang
-	 * or bring the system down.
-	 */
-	wait_for_flush = jiffies + msecs_to_jiffies(2000);
-	KGSL_IOMMU_SET_CTX_REG(ctx, TLBSYNC, 0);
-	while (KGSL_IOMMU_GET_CTX_REG(ctx, TLBSTATUS) &
-		(KGSL_IOMMU_CTX_TLBSTATUS_SACTIVE)) {
-		if (time_after(jiffies, wait_for_flush)) {
-			KGSL_DRV_WARN(KGSL_MMU_DEVICE(mmu),
-			"Wait limit reached for IOMMU tlb flush\n");
-			break;
-		}
-		cpu_relax();
-	}
+	_iommu_tlbiall(mmu, ctx);
 
 	/* Disable smmu clock */
 	kgsl_iommu_disable_clk(mmu);
@@ -2017,6 +2090,7 @@ struct kgsl_mmu_ops kgsl_iommu_ops = {
 	.mmu_init_pt = kgsl_iommu_init_pt,
 	.mmu_add_global = kgsl_iommu_add_global,
 	.mmu_remove_global = kgsl_iommu_remove_global,
+	.mmu_flush_tlb = kgsl_iommu_flush_tlb,
 };
 
 static struct kgsl_mmu_pt_ops iommu_pt_ops = {
@@ -166,12 +166,14 @@ struct kgsl_iommu {
  * @svm_end: End of the shared virtual memory range.
  * @svm_start: 32 bit compatible range, for old clients who lack bits
  * @svm_end: end of 32 bit compatible range
+ * @defer_tlb_flush: unmaps leave the TLB invalidate to kgsl_mmu_flush_tlb()
  */
 struct kgsl_iommu_pt {
 	struct iommu_domain *domain;
 	u64 ttbr0;
 	u32 contextidr;
 	bool attached;
+	bool defer_tlb_flush;
 
 	struct rb_root rbtree;
 
@@ -70,6 +70,7 @@ struct kgsl_mmu_ops {
 			struct kgsl_memdesc *memdesc);
 	void (*mmu_remove_global)(struct kgsl_mmu *mmu,
 			struct kgsl_memdesc *memdesc);
+	void (*mmu_flush_tlb)(struct kgsl_mmu *mmu);
 };
 
 struct kgsl_mmu_pt_ops {
@@ -123,6 +124,8 @@ struct kgsl_mmu {
 	bool secured;
 	uint features;
 	unsigned int secure_align_mask;
+	/* set when unmaps were done without invalidating the TLB */
+	atomic_t tlb_dirty;
 };
 
 extern struct kgsl_mmu_ops kgsl_iommu_ops;
@@ -236,6 +239,30 @@ static inline void kgsl_mmu_disable_clk(struct kgsl_mmu *mmu)
 		mmu->mmu_ops->mmu_disable_clk(mmu);
 }
 
+/*
+ * kgsl_mmu_tlb_flush_pending() - Check for unmaps waiting on a TLB flush
+ * @mmu: Pointer to the device mmu
+ *
+ * Memory that was unmapped while this returns true must not be freed until
+ * after the next kgsl_mmu_flush_tlb()
+ */
+static inline bool kgsl_mmu_tlb_flush_pending(struct kgsl_mmu *mmu)
+{
+	return atomic_read(&mmu->tlb_dirty) != 0;
+}
+
+/*
+ * kgsl_mmu_flush_tlb() - Invalidate the TLB for all batched unmaps
+ * @mmu: Pointer to the device mmu
+ *
+ * Returns once the invalidate has completed
+ */
+static inline void kgsl_mmu_flush_tlb(struct kgsl_mmu *mmu)
+{
+	if (MMU_OP_VALID(mmu, mmu_flush_tlb))
+		mmu->mmu_ops->mmu_flush_tlb(mmu);
+}
+
 /*
  * kgsl_mmu_get_reg_ahbaddr() - Calls the mmu specific function pointer to
  * return the address that GPU can use to access register
@@ -0,0 +1,338 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <linux/vmalloc.h>
+#include <asm/cacheflush.h>
+#include <linux/slab.h>
+#include <linux/highmem.h>
+#include <linux/shrinker.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+
+#include "kgsl.h"
+#include "kgsl_debugfs.h"
+#include "kgsl_pool.h"
+
+/*
+ * struct kgsl_page_pool - Pool of zeroed pages of a single order
+ * @pool_order: Order of the pages held by this pool
+ * @page_count: Number of pages currently in the pool
+ * @reserved_pages: Number of pages filled at init and kept by the shrinker
+ * @hits: Allocations served from the pool
+ * @misses: Allocations that had to go to the page allocator
+ * @list_lock: Protects page_list and page_count
+ * @page_list: List of free pages
+ */
+struct kgsl_page_pool {
+	unsigned int pool_order;
+	int page_count;
+	unsigned int reserved_pages;
+	unsigned long hits;
+	unsigned long misses;
+	spinlock_t list_lock;
+	struct list_head page_list;
+};
+
+static struct kgsl_page_pool kgsl_pools[] = {
+	{
+		.pool_order = 0,
+		.reserved_pages = 256,
+		.list_lock = __SPIN_LOCK_UNLOCKED(kgsl_pools[0].list_lock),
+		.page_list = LIST_HEAD_INIT(kgsl_pools[0].page_list),
+	},
+#ifndef CONFIG_ALLOC_BUFFERS_IN_4K_CHUNKS
+	{
+		.pool_order = 4,
+		.reserved_pages = 32,
+		.list_lock = __SPIN_LOCK_UNLOCKED(kgsl_pools[1].list_lock),
+		.page_list = LIST_HEAD_INIT(kgsl_pools[1].page_list),
+	},
+	{
+		.pool_order = 9,
+		.reserved_pages = 2,
+		.list_lock = __SPIN_LOCK_UNLOCKED(kgsl_pools[2].list_lock),
+		.page_list = LIST_HEAD_INIT(kgsl_pools[2].page_list),
+	},
+#endif
+};
+
+#define KGSL_NUM_POOLS ARRAY_SIZE(kgsl_pools)
+
+/* Upper bound on the memory held by all pools, in PAGE_SIZE units */
+#define KGSL_POOL_MAX_PAGES 16384
+
+/* Returns the pool holding pages of @order, or NULL if there is none */
+static struct kgsl_page_pool *_kgsl_get_pool_from_order(unsigned int order)
+{
+	int i;
+
+	for (i = 0; i < KGSL_NUM_POOLS; i++) {
+		if (kgsl_pools[i].pool_order == order)
+			return &kgsl_pools[i];
+	}
+
+	return NULL;
+}
+
+/* Returns the number of PAGE_SIZE pages held in @pool */
+static int kgsl_pool_size(struct kgsl_page_pool *pool)
+{
+	return pool->page_count << pool->pool_order;
+}
+
+/* Returns the number of PAGE_SIZE pages held in all the pools */
+static int kgsl_pool_size_total(void)
+{
+	int i, total = 0;
+
+	for (i = 0; i < KGSL_NUM_POOLS; i++)
+		total += kgsl_pool_size(&kgsl_pools[i]);
+
+	return total;
+}
+
+/*
+ * Pages are zeroed and flushed on their way into the pool so that the
+ * allocation path can hand them out without mapping them again.
+ */
+static void _kgsl_pool_zero_page(struct page *page, unsigned int order)
+{
+	int i;
+
+	for (i = 0; i < (1 << order); i++) {
+		struct page *p = nth_page(page, i);
+		void *addr = kmap_atomic(p);
+
+		memset(addr, 0, PAGE_SIZE);
+		dmac_flush_range(addr, addr + PAGE_SIZE);
+		kunmap_atomic(addr);
+	}
+}
+
+static void _kgsl_pool_add_page(struct kgsl_page_pool *pool,
+		struct page *p)
+{
+	spin_lock(&pool->list_lock);
+	list_add_tail(&p->lru, &pool->page_list);
+	pool->page_count++;
+	spin_unlock(&pool->list_lock);
+}
+
+static struct page *_kgsl_pool_get_page(struct kgsl_page_pool *pool)
+{
+	struct page *p = NULL;
+
+	spin_lock(&pool->list_lock);
+	if (pool->page_count) {
+		p = list_first_entry(&pool->page_list, struct page, lru);
+		pool->page_count--;
+		list_del(&p->lru);
+		pool->hits++;
+	} else {
+		pool->misses++;
+	}
+	spin_unlock(&pool->list_lock);
+
+	return p;
+}
+
+/*
+ * Free up to @target_pages PAGE_SIZE pages from @pool without going below
+ * its reserve. Returns the number of PAGE_SIZE pages freed.
+ */
+static int _kgsl_pool_shrink(struct kgsl_page_pool *pool, int target_pages,
+		bool keep_reserve)
+{
+	int freed = 0;
+
+	while (freed < target_pages) {
+		struct page *p = NULL;
+
+		spin_lock(&pool->list_lock);
+		if (pool->page_count &&
+		   (!keep_reserve || pool->page_count > pool->reserved_pages)) {
+			p = list_first_entry(&pool->page_list, struct page,
+					lru);
+			pool->page_count--;
+			list_del(&p->lru);
+		}
+		spin_unlock(&pool->list_lock);
+
+		if (p == NULL)
+			break;
+
+		__free_pages(p, pool->pool_order);
+		freed += 1 << pool->pool_order;
+	}
+
+	return freed;
+}
+
+/**
+ * kgsl_pool_alloc_page() - Allocate a page of the requested order
+ * @order: Order of the page to allocate
+ * @gfp_mask: Flags to use if the page has to come from the page allocator
+ * @zeroed: Set to true if the returned page is already zeroed and flushed
+ *
+ * Try the pool of matching order first and fall back to alloc_pages().
+ * Return: The allocated page or NULL on failure
+ */
+struct page *kgsl_pool_alloc_page(unsigned int order, gfp_t gfp_mask,
+		bool *zeroed)
+{
+	struct kgsl_page_pool *pool = _kgsl_get_pool_from_order(order);
+	struct page *page = NULL;
+
+	if (pool != NULL)
+		page = _kgsl_pool_get_page(pool);
+
+	*zeroed = (page != NULL);
+	if (page == NULL)
+		page = alloc_pages(gfp_mask, order);
+
+	return page;
+}
+
+/**
+ * kgsl_pool_free_page() - Return a page to its pool
+ * @page: Page (or compound page head) to free
+ *
+ * The page goes back to the pool of its order unless there is no such pool
+ * or the pools are full, in which case it is given back to the system.
+ */
+void kgsl_pool_free_page(struct page *page)
+{
+	unsigned int order = compound_order(page);
+	struct kgsl_page_pool *pool = _kgsl_get_pool_from_order(order);
+
+	if (pool != NULL &&
+		kgsl_pool_size_total() + (1 << order) <= KGSL_POOL_MAX_PAGES) {
+		_kgsl_pool_zero_page(page, order);
+		_kgsl_pool_add_page(pool, page);
+		return;
+	}
+
+	__free_pages(page, order);
+}
+
+static unsigned long
+kgsl_pool_shrink_scan_objects(struct shrinker *shrinker,
+					struct shrink_control *sc)
+{
+	int i, freed = 0;
+
+	/* Give back the small pages first, large ones are harder to find */
+	for (i = 0; i < KGSL_NUM_POOLS && freed < sc->nr_to_scan; i++)
+		freed += _kgsl_pool_shrink(&kgsl_pools[i],
+				sc->nr_to_scan - freed, true);
+
+	return freed;
+}
+
+static unsigned long
+kgsl_pool_shrink_count_objects(struct shrinker *shrinker,
+					struct shrink_control *sc)
+{
+	int i, count = 0;
+
+	for (i = 0; i < KGSL_NUM_POOLS; i++) {
+		struct kgsl_page_pool *pool = &kgsl_pools[i];
+
+		if (pool->page_count > pool->reserved_pages)
+			count += (pool->page_count - pool->reserved_pages)
+				<< pool->pool_order;
+	}
+
+	return count;
+}
+
+static struct shrinker kgsl_pool_shrinker = {
+	.count_objects = kgsl_pool_shrink_count_objects,
+	.scan_objects = kgsl_pool_shrink_scan_objects,
+	.seeks = DEFAULT_SEEKS,
+	.batch = 0,
+};
+
+static int kgsl_pool_stats_show(struct seq_file *s, void *unused)
+{
+	int i;
+
+	seq_puts(s, "order pages reserved hits misses\n");
+	for (i = 0; i < KGSL_NUM_POOLS; i++) {
+		struct kgsl_page_pool *pool = &kgsl_pools[i];
+
+		seq_printf(s, "%u %d %u %lu %lu\n", pool->pool_order,
+			pool->page_count, pool->reserved_pages,
+			pool->hits, pool->misses);
+	}
+
+	return 0;
+}
+
+static int kgsl_pool_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, kgsl_pool_stats_show, NULL);
+}
+
+static const struct file_operations kgsl_pool_stats_fops = {
+	.open = kgsl_pool_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+/* Fill each pool with its reserve of zeroed pages */
+static void kgsl_pool_reserve_pages(void)
+{
+	int i, j;
+
+	for (i = 0; i < KGSL_NUM_POOLS; i++) {
+		struct kgsl_page_pool *pool = &kgsl_pools[i];
+		gfp_t gfp_mask = GFP_KERNEL | __GFP_HIGHMEM | __GFP_NORETRY |
+				__GFP_NOWARN;
+
+		if (pool->pool_order)
+			gfp_mask |= __GFP_COMP | __GFP_NO_KSWAPD;
+
+		for (j = 0; j < pool->reserved_pages; j++) {
+			struct page *p = alloc_pages(gfp_mask,
+					pool->pool_order);
+
+			if (p == NULL)
+				break;
+
+			_kgsl_pool_zero_page(p, pool->pool_order);
+			_kgsl_pool_add_page(pool, p);
+		}
+	}
+}
+
+void kgsl_init_page_pools(void)
+{
+	kgsl_pool_reserve_pages();
+
+	register_shrinker(&kgsl_pool_shrinker);
+
+	debugfs_create_file("page_pools", 0444, kgsl_get_debugfs_dir(), NULL,
+		&kgsl_pool_stats_fops);
+}
+
+void kgsl_exit_page_pools(void)
+{
+	int i;
+
+	unregister_shrinker(&kgsl_pool_shrinker);
+
+	for (i = 0; i < KGSL_NUM_POOLS; i++)
+		_kgsl_pool_shrink(&kgsl_pools[i], INT_MAX, false);
+}
@@ -0,0 +1,22 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+#ifndef __KGSL_POOL_H
+#define __KGSL_POOL_H
+
+struct page *kgsl_pool_alloc_page(unsigned int order, gfp_t gfp_mask,
+		bool *zeroed);
+void kgsl_pool_free_page(struct page *page);
+void kgsl_init_page_pools(void);
+void kgsl_exit_page_pools(void);
+
+#endif /* __KGSL_POOL_H */
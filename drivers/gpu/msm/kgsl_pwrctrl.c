@@ -1588,6 +1588,142 @@ static int _get_clocks(struct kgsl_device *device)
 	return 0;
 }
 
+/*
+ * Thermal cooling device for the GPU. Cooling state N caps the GPU at
+ * power level N, the same limit as the thermal_pwrlevel sysfs node.
+ * With qcom,gpu-power-coeff in DT it is also a power actor, so a
+ * power_allocator zone can split its budget between the CPU clusters
+ * and the GPU by what each is asking for.
+ */
+static int kgsl_cooling_get_max_state(struct thermal_cooling_device *cdev,
+				      unsigned long *state)
+{
+	struct kgsl_device *device = cdev->devdata;
+
+	*state = device->pwrctrl.num_pwrlevels - 2;
+	return 0;
+}
+
+static int kgsl_cooling_get_cur_state(struct thermal_cooling_device *cdev,
+				      unsigned long *state)
+{
+	struct kgsl_device *device = cdev->devdata;
+
+	*state = device->pwrctrl.thermal_pwrlevel;
+	return 0;
+}
+
+static int kgsl_cooling_set_cur_state(struct thermal_cooling_device *cdev,
+				      unsigned long state)
+{
+	struct kgsl_device *device = cdev->devdata;
+	struct kgsl_pwrctrl *pwr = &device->pwrctrl;
+
+	if (state > pwr->num_pwrlevels - 2)
+		return -EINVAL;
+
+	mutex_lock(&device->mutex);
+	pwr->thermal_pwrlevel = state;
+	kgsl_pwrctrl_pwrlevel_change(device, pwr->active_pwrlevel);
+	mutex_unlock(&device->mutex);
+
+	return 0;
+}
+
+static u32 kgsl_level_power(struct kgsl_pwrctrl *pwr, unsigned int level)
+{
+	return div_u64((u64)pwr->power_coeff * pwr->pwrlevels[level].gpu_freq,
+		       NSEC_PER_SEC);
+}
+
+/* Power at the current level scaled by the last busy ratio */
+static int kgsl_cooling_get_requested_power(
+		struct thermal_cooling_device *cdev,
+		struct thermal_zone_device *tz, u32 *power)
+{
+	struct kgsl_device *device = cdev->devdata;
+	struct kgsl_pwrctrl *pwr = &device->pwrctrl;
+	struct kgsl_clk_stats *stats = &pwr->clk_stats;
+	u32 level_power = kgsl_level_power(pwr, pwr->active_pwrlevel);
+
+	if (!stats->total_old || device->state != KGSL_STATE_ACTIVE) {
+		*power = 0;
+		return 0;
+	}
+
+	*power = div_u64((u64)level_power * stats->busy_old,
+			 stats->total_old);
+	return 0;
+}
+
+static int kgsl_cooling_state2power(struct thermal_cooling_device *cdev,
+				    struct thermal_zone_device *tz,
+				    unsigned long state, u32 *power)
+{
+	struct kgsl_device *device = cdev->devdata;
+	struct kgsl_pwrctrl *pwr = &device->pwrctrl;
+
+	if (state > pwr->num_pwrlevels - 2)
+		return -EINVAL;
+
+	*power = kgsl_level_power(pwr, state);
+	return 0;
+}
+
+/* The fastest level that fits in @power, or the slowest one */
+static int kgsl_cooling_power2state(struct thermal_cooling_device *cdev,
+				    struct thermal_zone_device *tz,
+				    u32 power, unsigned long *state)
+{
+	struct kgsl_device *device = cdev->devdata;
+	struct kgsl_pwrctrl *pwr = &device->pwrctrl;
+	unsigned int level;
+
+	for (level = 0; level < pwr->num_pwrlevels - 2; level++)
+		if (kgsl_level_power(pwr, level) <= power)
+			break;
+
+	*state = level;
+	return 0;
+}
+
+static struct thermal_cooling_device_ops kgsl_cooling_ops = {
+	.get_max_state = kgsl_cooling_get_max_state,
+	.get_cur_state = kgsl_cooling_get_cur_state,
+	.set_cur_state = kgsl_cooling_set_cur_state,
+};
+
+static struct thermal_cooling_device_ops kgsl_power_cooling_ops = {
+	.get_max_state = kgsl_cooling_get_max_state,
+	.get_cur_state = kgsl_cooling_get_cur_state,
+	.set_cur_state = kgsl_cooling_set_cur_state,
+	.get_requested_power = kgsl_cooling_get_requested_power,
+	.state2power = kgsl_cooling_state2power,
+	.power2state = kgsl_cooling_power2state,
+};
+
+static void kgsl_pwrctrl_cooling_init(struct kgsl_device *device)
+{
+	struct kgsl_pwrctrl *pwr = &device->pwrctrl;
+	struct device_node *node = device->pdev->dev.of_node;
+
+	if (pwr->num_pwrlevels < 2)
+		return;
+
+	if (of_property_read_u32(node, "qcom,gpu-power-coeff",
+				 &pwr->power_coeff))
+		pwr->power_coeff = 0;
+
+	pwr->cooling_dev = thermal_of_cooling_device_register(node,
+			"kgsl-gpu", device, pwr->power_coeff ?
+			&kgsl_power_cooling_ops : &kgsl_cooling_ops);
+	if (IS_ERR(pwr->cooling_dev)) {
+		KGSL_PWR_ERR(device, "cooling device register failed %ld\n",
+			     PTR_ERR(pwr->cooling_dev));
+		pwr->cooling_dev = NULL;
+	}
+}
+
 int kgsl_pwrctrl_init(struct kgsl_device *device)
 {
 	int i, k, m, n = 0, result;
@@ -1776,6 +1912,8 @@ int kgsl_pwrctrl_init(struct kgsl_device *device)
 			(unsigned long) device);
 	devfreq_vbif_register_callback(kgsl_get_bw);
 
+	kgsl_pwrctrl_cooling_init(device);
+
 	return result;
 }
 
@@ -1786,6 +1924,10 @@ void kgsl_pwrctrl_close(struct kgsl_device *device)
 
 	KGSL_PWR_INFO(device, "close device %d\n", device->id);
 
+	if (!IS_ERR_OR_NULL(pwr->cooling_dev))
+		thermal_cooling_device_unregister(pwr->cooling_dev);
+	pwr->cooling_dev = NULL;
+
 	pm_runtime_disable(&device->pdev->dev);
 
 	if (pwr->pcl)
@@ -14,6 +14,7 @@
 #define __KGSL_PWRCTRL_H
 
 #include <linux/pm_qos.h>
+#include <linux/thermal.h>
 
 /*****************************************************************************
 ** power flags
@@ -152,6 +153,8 @@ struct kgsl_regulator {
  * @deep_nap_timer - Timer struct for entering deep nap
  * @deep_nap_timeout - Timeout for entering deep nap
  * @gx_retention - true if retention voltage is allowed
+ * @power_coeff - GPU dynamic power in mW per GHz, 0 if there is no model
+ * @cooling_dev - thermal cooling device driving thermal_pwrlevel
  */
 
 struct kgsl_pwrctrl {
@@ -200,6 +203,8 @@ struct kgsl_pwrctrl {
 	struct timer_list deep_nap_timer;
 	uint32_t deep_nap_timeout;
 	bool gx_retention;
+	uint32_t power_coeff;
+	struct thermal_cooling_device *cooling_dev;
 };
 
 int kgsl_pwrctrl_init(struct kgsl_device *device);
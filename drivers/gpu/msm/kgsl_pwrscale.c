@@ -91,6 +91,9 @@ void kgsl_pwrscale_wake(struct kgsl_device *device)
 	/* clear old stats before waking */
 	memset(&psc->accum_stats, 0, sizeof(psc->accum_stats));
 	memset(&last_xstats, 0, sizeof(last_xstats));
+	memset(&psc->frame_stats, 0, sizeof(psc->frame_stats));
+	psc->frame_busy = 0;
+	psc->frame_time = ktime_set(0, 0);
 
 	/* and any hw activity from waking up*/
 	device->ftbl->power_stats(device, &stats);
@@ -153,10 +156,56 @@ void kgsl_pwrscale_update_stats(struct kgsl_device *device)
 		device->pwrscale.accum_stats.busy_time += stats.busy_time;
 		device->pwrscale.accum_stats.ram_time += stats.ram_time;
 		device->pwrscale.accum_stats.ram_wait += stats.ram_wait;
+		device->pwrscale.frame_busy += stats.busy_time;
 	}
 }
 EXPORT_SYMBOL(kgsl_pwrscale_update_stats);
 
+/**
+ * kgsl_pwrscale_frame_retire() - account for a retired frame
+ * @device: The device
+ *
+ * Called when the last command batch of a frame retires. Close the frame
+ * with the GPU busy time seen since the previous one and, if the governor
+ * asked for per-frame samples, notify it right away instead of waiting for
+ * the next sample window. This function must be called with the device
+ * mutex locked.
+ */
+void kgsl_pwrscale_frame_retire(struct kgsl_device *device)
+{
+	struct kgsl_pwrscale *psc = &device->pwrscale;
+	struct devfreq_msm_adreno_tz_data *data = psc->gpu_profile.private_data;
+	ktime_t t;
+
+	BUG_ON(!mutex_is_locked(&device->mutex));
+
+	if (!psc->enabled)
+		return;
+
+	kgsl_pwrscale_update_stats(device);
+
+	t = ktime_get();
+
+	/* The first frame after a wake up only starts the measurement */
+	if (ktime_to_ns(psc->frame_time) != 0) {
+		psc->frame_stats.total_time += ktime_us_delta(t,
+				psc->frame_time);
+		psc->frame_stats.busy_time += psc->frame_busy;
+		psc->frame_stats.num++;
+	}
+
+	psc->frame_busy = 0;
+	psc->frame_time = t;
+
+	if (data != NULL && data->frame.enable &&
+		device->state != KGSL_STATE_SLUMBER) {
+		psc->next_governor_call = ktime_add_us(t,
+				KGSL_GOVERNOR_CALL_INTERVAL);
+		queue_work(psc->devfreq_wq, &psc->devfreq_notify_ws);
+	}
+}
+EXPORT_SYMBOL(kgsl_pwrscale_frame_retire);
+
 /**
  * kgsl_pwrscale_update() - update device busy statistics
  * @device: The device
@@ -483,8 +532,18 @@ int kgsl_devfreq_target(struct device *dev, unsigned long *freq, u32 flags)
 					level = popp_trans2(device, i);
 				break;
 			}
-		if (level != pwr->active_pwrlevel)
+		if (level != pwr->active_pwrlevel) {
+			/*
+			 * When the bus is voted together with the GPU let
+			 * it follow the new power level instead of keeping
+			 * a modifier picked for the old one.
+			 */
+			if (device->pwrscale.bus_profile.coupled) {
+				pwr->bus_mod = 0;
+				pwr->bus_percent_ab = 0;
+			}
 			kgsl_pwrctrl_pwrlevel_change(device, level);
+		}
 	} else if (popp_stable(device)) {
 		popp_trans1(device);
 	}
@@ -536,6 +595,17 @@ int kgsl_devfreq_get_dev_status(struct device *dev,
 
 	stat->current_frequency = kgsl_pwrctrl_active_freq(&device->pwrctrl);
 
+	/* Hand the frames retired in this sample over to the governor */
+	if (pwrscale->gpu_profile.private_data != NULL) {
+		struct devfreq_msm_adreno_tz_data *data =
+			pwrscale->gpu_profile.private_data;
+
+		data->frame.total_time = pwrscale->frame_stats.total_time;
+		data->frame.busy_time = pwrscale->frame_stats.busy_time;
+		data->frame.num = pwrscale->frame_stats.num;
+	}
+	memset(&pwrscale->frame_stats, 0, sizeof(pwrscale->frame_stats));
+
 	/*
 	 * keep the latest devfreq_dev_status values
 	 * and vbif counters data
@@ -673,7 +743,7 @@ int kgsl_busmon_target(struct device *dev, unsigned long *freq, u32 flags)
 	struct kgsl_device *device = dev_get_drvdata(dev);
 	struct kgsl_pwrctrl *pwr;
 	struct kgsl_pwrlevel *pwr_level;
-	int  level, b;
+	int  level, b, gpu_mod;
 	u32 bus_flag;
 	unsigned long ab_mbytes;
 
@@ -694,6 +764,8 @@ int kgsl_busmon_target(struct device *dev, unsigned long *freq, u32 flags)
 	pwr_level = &pwr->pwrlevels[level];
 	bus_flag = device->pwrscale.bus_profile.flag;
 	device->pwrscale.bus_profile.flag = 0;
+	gpu_mod = device->pwrscale.bus_profile.gpu_mod;
+	device->pwrscale.bus_profile.gpu_mod = 0;
 	ab_mbytes = device->pwrscale.bus_profile.ab_mbytes;
 
 	/*
@@ -715,6 +787,35 @@ int kgsl_busmon_target(struct device *dev, unsigned long *freq, u32 flags)
 		((pwr_level->bus_freq + pwr->bus_mod) > pwr_level->bus_min))
 			pwr->bus_mod--;
 
+	/*
+	 * The coupled governor asked for the GPU clock to come down as well.
+	 * Carry the bus vote over to the new power level so that both move
+	 * with a single bus update.
+	 */
+	if (gpu_mod > 0 && level < pwr->min_pwrlevel) {
+		struct kgsl_pwrlevel *new_level = &pwr->pwrlevels[level + 1];
+		unsigned long percent_ab = pwr->bus_percent_ab;
+		unsigned long bus_ab_mbytes = pwr->bus_ab_mbytes;
+		int mod = pwr->bus_mod;
+
+		pwr->bus_mod = min_t(int, pwr_level->bus_freq + pwr->bus_mod,
+				new_level->bus_max) - new_level->bus_freq;
+		pwr->bus_mod = max_t(int, pwr->bus_mod, 0);
+		pwr->bus_percent_ab = device->pwrscale.bus_profile.percent_ab;
+		pwr->bus_ab_mbytes = ab_mbytes;
+
+		kgsl_pwrctrl_pwrlevel_change(device, level + 1);
+		if (pwr->active_pwrlevel != level) {
+			mutex_unlock(&device->mutex);
+			return 0;
+		}
+
+		/* The level is pinned, fall back to a plain bus update */
+		pwr->bus_mod = mod;
+		pwr->bus_percent_ab = percent_ab;
+		pwr->bus_ab_mbytes = bus_ab_mbytes;
+	}
+
 	/* Update bus vote if AB or IB is modified */
 	if ((pwr->bus_mod != b) || (pwr->bus_ab_mbytes != ab_mbytes)) {
 		pwr->bus_percent_ab = device->pwrscale.bus_profile.percent_ab;
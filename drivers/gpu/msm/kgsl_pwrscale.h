@@ -61,6 +61,18 @@ struct kgsl_pwr_event {
 	s64 duration;
 };
 
+/**
+ * struct kgsl_frame_stats - GPU usage of the frames retired in a sample
+ * @total_time: Sum of the frame intervals in usec
+ * @busy_time: Sum of the GPU busy time of the frames in usec
+ * @num: Number of frames
+ */
+struct kgsl_frame_stats {
+	u64 total_time;
+	u64 busy_time;
+	u32 num;
+};
+
 struct kgsl_pwr_history {
 	struct kgsl_pwr_event *events;
 	unsigned int type;
@@ -90,6 +102,9 @@ struct kgsl_pwr_history {
  * @history - History of power events with timestamps and durations
  * @popp_level - Current level of POPP mitigation
  * @popp_state - Control state for POPP, on/off, recently pushed, etc
+ * @frame_busy - GPU busy time accumulated since the last frame retired
+ * @frame_time - Timestamp of the last retired frame
+ * @frame_stats - Frames retired since the last devfreq sample
  */
 struct kgsl_pwrscale {
 	struct devfreq *devfreqptr;
@@ -111,6 +126,9 @@ struct kgsl_pwrscale {
 	struct kgsl_pwr_history history[KGSL_PWREVENT_MAX];
 	int popp_level;
 	unsigned long popp_state;
+	u64 frame_busy;
+	ktime_t frame_time;
+	struct kgsl_frame_stats frame_stats;
 };
 
 int kgsl_pwrscale_init(struct device *dev, const char *governor);
@@ -119,6 +137,7 @@ void kgsl_pwrscale_close(struct kgsl_device *device);
 void kgsl_pwrscale_update(struct kgsl_device *device);
 void kgsl_pwrscale_update_stats(struct kgsl_device *device);
 void kgsl_pwrscale_busy(struct kgsl_device *device);
+void kgsl_pwrscale_frame_retire(struct kgsl_device *device);
 void kgsl_pwrscale_sleep(struct kgsl_device *device);
 void kgsl_pwrscale_wake(struct kgsl_device *device);
 
@@ -28,6 +28,7 @@
 #include "kgsl_device.h"
 #include "kgsl_log.h"
 #include "kgsl_mmu.h"
+#include "kgsl_pool.h"
 
 /*
  * The user can set this from debugfs to force failed memory allocations to
@@ -146,6 +147,88 @@ static ssize_t mem_entry_sysfs_show(struct kobject *kobj,
 	return ret;
 }
 
+static const char * const memtype_str[] = {
+	[KGSL_MEMTYPE_OBJECTANY] = "any(0)",
+	[KGSL_MEMTYPE_FRAMEBUFFER] = "framebuffer",
+	[KGSL_MEMTYPE_RENDERBUFFER] = "renderbuffer",
+	[KGSL_MEMTYPE_ARRAYBUFFER] = "arraybuffer",
+	[KGSL_MEMTYPE_ELEMENTARRAYBUFFER] = "elementarraybuffer",
+	[KGSL_MEMTYPE_VERTEXARRAYBUFFER] = "vertexarraybuffer",
+	[KGSL_MEMTYPE_TEXTURE] = "texture",
+	[KGSL_MEMTYPE_SURFACE] = "surface",
+	[KGSL_MEMTYPE_EGL_SURFACE] = "egl_surface",
+	[KGSL_MEMTYPE_GL] = "gl",
+	[KGSL_MEMTYPE_CL] = "cl",
+	[KGSL_MEMTYPE_CL_BUFFER_MAP] = "cl_buffer_map",
+	[KGSL_MEMTYPE_CL_BUFFER_NOMAP] = "cl_buffer_nomap",
+	[KGSL_MEMTYPE_CL_IMAGE_MAP] = "cl_image_map",
+	[KGSL_MEMTYPE_CL_IMAGE_NOMAP] = "cl_image_nomap",
+	[KGSL_MEMTYPE_CL_KERNEL_STACK] = "cl_kernel_stack",
+	[KGSL_MEMTYPE_COMMAND] = "command",
+	[KGSL_MEMTYPE_2D] = "2d",
+	[KGSL_MEMTYPE_EGL_IMAGE] = "egl_image",
+	[KGSL_MEMTYPE_EGL_SHADOW] = "egl_shadow",
+	[KGSL_MEMTYPE_MULTISAMPLE] = "egl_multisample",
+	/* KGSL_MEMTYPE_KERNEL handled below, to avoid huge array */
+};
+
+/**
+ * Show the GPU time consumed by the process in microseconds, measured from
+ * the start and retire ticks of its command batches
+ */
+
+static ssize_t
+gpu_busy_show(struct kgsl_process_private *priv, int type, char *buf)
+{
+	uint64_t ticks = atomic64_read(&priv->gpu_ticks);
+
+	/* The always on counter ticks KGSL_RBBMTIMER_CLK_FREQ times a second */
+	return snprintf(buf, PAGE_SIZE, "%llu\n",
+		div_u64(ticks * 10, KGSL_RBBMTIMER_CLK_FREQ / 100000));
+}
+
+static int _memtype_usage(int id, void *ptr, void *data)
+{
+	struct kgsl_mem_entry *entry = ptr;
+	uint64_t *usage = data;
+	unsigned int type = kgsl_memdesc_get_memtype(&entry->memdesc);
+
+	/* The last slot collects kernel and unknown types */
+	if (type >= ARRAY_SIZE(memtype_str) || memtype_str[type] == NULL)
+		type = ARRAY_SIZE(memtype_str);
+
+	usage[type] += entry->memdesc.size;
+	return 0;
+}
+
+/**
+ * Show the memory currently allocated by the process broken down by the
+ * memtype userspace set on each allocation, one "<type> <bytes>" per line
+ */
+
+static ssize_t
+gpumem_types_show(struct kgsl_process_private *priv, int type, char *buf)
+{
+	uint64_t usage[ARRAY_SIZE(memtype_str) + 1] = { 0 };
+	ssize_t len = 0;
+	int i;
+
+	spin_lock(&priv->mem_lock);
+	idr_for_each(&priv->mem_idr, _memtype_usage, usage);
+	spin_unlock(&priv->mem_lock);
+
+	for (i = 0; i < ARRAY_SIZE(usage); i++) {
+		if (usage[i] == 0)
+			continue;
+
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%s %llu\n",
+			i < ARRAY_SIZE(memtype_str) ? memtype_str[i] : "other",
+			usage[i]);
+	}
+
+	return len;
+}
+
 static const struct sysfs_ops mem_entry_sysfs_ops = {
 	.show = mem_entry_sysfs_show,
 };
@@ -162,11 +245,19 @@ static struct mem_entry_stats mem_stats[] = {
 #endif
 };
 
+static struct kgsl_mem_entry_attribute proc_attrs[] = {
+	__MEM_ENTRY_ATTR(0, gpu_busy_us, gpu_busy_show),
+	__MEM_ENTRY_ATTR(0, gpumem_types, gpumem_types_show),
+};
+
 void
 kgsl_process_uninit_sysfs(struct kgsl_process_private *private)
 {
 	int i;
 
+	for (i = 0; i < ARRAY_SIZE(proc_attrs); i++)
+		sysfs_remove_file(&private->kobj, &proc_attrs[i].attr);
+
 	for (i = 0; i < ARRAY_SIZE(mem_stats); i++) {
 		sysfs_remove_file(&private->kobj, &mem_stats[i].attr.attr);
 		sysfs_remove_file(&private->kobj,
@@ -217,6 +308,12 @@ void kgsl_process_init_sysfs(struct kgsl_device *device,
 				mem_stats[i].max_attr.attr.name);
 
 	}
+
+	for (i = 0; i < ARRAY_SIZE(proc_attrs); i++) {
+		if (sysfs_create_file(&private->kobj, &proc_attrs[i].attr))
+			WARN(1, "Couldn't create sysfs file '%s'\n",
+				proc_attrs[i].attr.name);
+	}
 }
 
 static ssize_t kgsl_drv_memstat_show(struct device *dev,
@@ -233,6 +330,10 @@ static ssize_t kgsl_drv_memstat_show(struct device *dev,
 		val = atomic_long_read(&kgsl_driver.stats.page_alloc);
 	else if (!strcmp(attr->attr.name, "page_alloc_max"))
 		val = atomic_long_read(&kgsl_driver.stats.page_alloc_max);
+	else if (!strcmp(attr->attr.name, "page_alloc_64k"))
+		val = atomic_long_read(&kgsl_driver.stats.page_alloc_64k);
+	else if (!strcmp(attr->attr.name, "page_alloc_2m"))
+		val = atomic_long_read(&kgsl_driver.stats.page_alloc_2m);
 	else if (!strcmp(attr->attr.name, "coherent"))
 		val = atomic_long_read(&kgsl_driver.stats.coherent);
 	else if (!strcmp(attr->attr.name, "coherent_max"))
@@ -285,6 +386,8 @@ static DEVICE_ATTR(vmalloc, 0444, kgsl_drv_memstat_show, NULL);
 static DEVICE_ATTR(vmalloc_max, 0444, kgsl_drv_memstat_show, NULL);
 static DEVICE_ATTR(page_alloc, 0444, kgsl_drv_memstat_show, NULL);
 static DEVICE_ATTR(page_alloc_max, 0444, kgsl_drv_memstat_show, NULL);
+static DEVICE_ATTR(page_alloc_64k, 0444, kgsl_drv_memstat_show, NULL);
+static DEVICE_ATTR(page_alloc_2m, 0444, kgsl_drv_memstat_show, NULL);
 static DEVICE_ATTR(coherent, 0444, kgsl_drv_memstat_show, NULL);
 static DEVICE_ATTR(coherent_max, 0444, kgsl_drv_memstat_show, NULL);
 static DEVICE_ATTR(secure, 0444, kgsl_drv_memstat_show, NULL);
@@ -301,6 +404,8 @@ static const struct device_attribute *drv_attr_list[] = {
 	&dev_attr_vmalloc_max,
 	&dev_attr_page_alloc,
 	&dev_attr_page_alloc_max,
+	&dev_attr_page_alloc_64k,
+	&dev_attr_page_alloc_2m,
 	&dev_attr_coherent,
 	&dev_attr_coherent_max,
 	&dev_attr_secure,
@@ -425,7 +530,7 @@ static void kgsl_page_alloc_unmap_kernel(struct kgsl_memdesc *memdesc)
 	memdesc->hostptr_count--;
 	if (memdesc->hostptr_count)
 		goto done;
-	vunmap(memdesc->hostptr);
+	vm_unmap_ram(memdesc->hostptr, PAGE_ALIGN(memdesc->size) >> PAGE_SHIFT);
 
 	atomic_long_sub(memdesc->size, &kgsl_driver.stats.vmalloc);
 	memdesc->hostptr = NULL;
@@ -433,6 +538,27 @@ done:
 	mutex_unlock(&kernel_map_global_lock);
 }
 
+/*
+ * Track how much of the page allocations is backed by chunks large enough
+ * to be mapped with 64K contiguous or 2M block entries in the IOMMU
+ */
+static void kgsl_large_page_stats(unsigned int order, bool add)
+{
+	atomic_long_t *stat;
+
+	if (order == get_order(SZ_2M))
+		stat = &kgsl_driver.stats.page_alloc_2m;
+	else if (order == get_order(SZ_64K))
+		stat = &kgsl_driver.stats.page_alloc_64k;
+	else
+		return;
+
+	if (add)
+		atomic_long_add(PAGE_SIZE << order, stat);
+	else
+		atomic_long_sub(PAGE_SIZE << order, stat);
+}
+
 static void kgsl_page_alloc_free(struct kgsl_memdesc *memdesc)
 {
 	unsigned int i = 0;
@@ -479,7 +605,8 @@ static void kgsl_page_alloc_free(struct kgsl_memdesc *memdesc)
 
 			count = 1 << compound_order(p);
 			next = nth_page(p, count);
-			__free_pages(p, compound_order(p));
+			kgsl_large_page_stats(compound_order(p), false);
+			kgsl_pool_free_page(p);
 			p = next;
 			j += count;
 
@@ -530,9 +657,14 @@ static int kgsl_page_alloc_map_kernel(struct kgsl_memdesc *memdesc)
 				pages[count++] = page++;
 		}
 
+		/* vm_unmap_ram() needs the count back from the size */
+		if (WARN_ON(count != npages)) {
+			kgsl_free(pages);
+			ret = -EINVAL;
+			goto done;
+		}
 
-		memdesc->hostptr = vmap(pages, count,
-					VM_IOREMAP, page_prot);
+		memdesc->hostptr = vm_map_ram(pages, count, -1, page_prot);
 		if (memdesc->hostptr)
 			KGSL_STATS_ADD(memdesc->size,
 				&kgsl_driver.stats.vmalloc,
@@ -684,6 +816,9 @@ EXPORT_SYMBOL(kgsl_cache_range_op);
 #ifndef CONFIG_ALLOC_BUFFERS_IN_4K_CHUNKS
 static inline int get_page_size(size_t size, unsigned int align)
 {
+	if (align >= ilog2(SZ_2M) && size >= SZ_2M)
+		return SZ_2M;
+
 	return (align >= ilog2(SZ_64K) && size >= SZ_64K)
 					? SZ_64K : PAGE_SIZE;
 }
@@ -703,6 +838,7 @@ kgsl_sharedmem_page_alloc_user(struct kgsl_memdesc *memdesc,
 	unsigned int j, pcount = 0, page_size, len_alloc;
 	size_t len;
 	struct page **pages = NULL;
+	unsigned long *zeroed = NULL;
 	pgprot_t page_prot = pgprot_writecombine(PAGE_KERNEL);
 	void *ptr;
 	unsigned int align;
@@ -750,16 +886,25 @@ kgsl_sharedmem_page_alloc_user(struct kgsl_memdesc *memdesc,
 		goto done;
 	}
 
+	/* One bit per page, set if the page came out of the pool pre-zeroed */
+	zeroed = kgsl_malloc(BITS_TO_LONGS(len_alloc) * sizeof(unsigned long));
+	if (zeroed == NULL) {
+		ret = -ENOMEM;
+		goto done;
+	}
+	memset(zeroed, 0, BITS_TO_LONGS(len_alloc) * sizeof(unsigned long));
+
 	len = size;
 
 	while (len > 0) {
 		struct page *page;
 		gfp_t gfp_mask = __GFP_HIGHMEM;
+		bool page_zeroed;
 		int j;
 
 		/* don't waste space at the end of the allocation*/
 		if (len < page_size)
-			page_size = PAGE_SIZE;
+			page_size = get_page_size(len, align);
 
 		/*
 		 * Don't do some of the more aggressive memory recovery
@@ -774,10 +919,15 @@ kgsl_sharedmem_page_alloc_user(struct kgsl_memdesc *memdesc,
 		if (sharedmem_noretry_flag == true)
 			gfp_mask |= __GFP_NORETRY | __GFP_NOWARN;
 
-		page = alloc_pages(gfp_mask, get_order(page_size));
+		page = kgsl_pool_alloc_page(get_order(page_size), gfp_mask,
+				&page_zeroed);
 
 		if (page == NULL) {
-			if (page_size != PAGE_SIZE) {
+			/* Step down to the next smaller size and try again */
+			if (page_size == SZ_2M) {
+				page_size = SZ_64K;
+				continue;
+			} else if (page_size != PAGE_SIZE) {
 				page_size = PAGE_SIZE;
 				continue;
 			}
@@ -798,6 +948,11 @@ kgsl_sharedmem_page_alloc_user(struct kgsl_memdesc *memdesc,
 			goto done;
 		}
 
+		if (page_zeroed)
+			bitmap_set(zeroed, pcount, page_size >> PAGE_SHIFT);
+
+		kgsl_large_page_stats(get_order(page_size), true);
+
 		for (j = 0; j < page_size >> PAGE_SHIFT; j++)
 			pages[pcount++] = nth_page(page, j);
 
@@ -852,22 +1007,26 @@ kgsl_sharedmem_page_alloc_user(struct kgsl_memdesc *memdesc,
 	 * buffers. There is a small decrease in speed for small buffers,
 	 * but only on the order of a few microseconds at best. The 'step'
 	 * size is based on a guess at the amount of free vmalloc space, but
-	 * will scale down if there's not enough free space.
+	 * will scale down if there's not enough free space. Pages that came
+	 * from the page pool were zeroed when they were put there, so only
+	 * the runs of pages that came straight from the allocator are done.
 	 */
-	for (j = 0; j < pcount; j += step) {
-		step = min(step, pcount - j);
+	j = find_first_zero_bit(zeroed, pcount);
+	while (j < pcount) {
+		unsigned int count = min(step, (unsigned int)
+				find_next_bit(zeroed, pcount, j) - j);
 
-		ptr = vmap(&pages[j], step, VM_IOREMAP, page_prot);
+		ptr = vmap(&pages[j], count, VM_IOREMAP, page_prot);
 
 		if (ptr != NULL) {
-			memset(ptr, 0, step * PAGE_SIZE);
-			dmac_flush_range(ptr, ptr + step * PAGE_SIZE);
+			memset(ptr, 0, count * PAGE_SIZE);
+			dmac_flush_range(ptr, ptr + count * PAGE_SIZE);
 			vunmap(ptr);
 		} else {
 			int k;
 			/* Very, very, very slow path */
 
-			for (k = j; k < j + step; k++) {
+			for (k = j; k < j + count; k++) {
 				ptr = kmap_atomic(pages[k]);
 				memset(ptr, 0, PAGE_SIZE);
 				dmac_flush_range(ptr, ptr + PAGE_SIZE);
@@ -877,6 +1036,8 @@ kgsl_sharedmem_page_alloc_user(struct kgsl_memdesc *memdesc,
 			if (step > 1)
 				step >>= 1;
 		}
+
+		j = find_next_zero_bit(zeroed, pcount, j + count);
 	}
 
 	KGSL_STATS_ADD(memdesc->size, &kgsl_driver.stats.page_alloc,
@@ -889,12 +1050,14 @@ done:
 		unsigned int count = 1;
 		for (j = 0; j < pcount; j += count) {
 			count = 1 << compound_order(pages[j]);
-			__free_pages(pages[j], compound_order(pages[j]));
+			kgsl_large_page_stats(compound_order(pages[j]), false);
+			kgsl_pool_free_page(pages[j]);
 		}
 
 		kfree(memdesc->sgt);
 		memset(memdesc, 0, sizeof(*memdesc));
 	}
+	kgsl_free(zeroed);
 	kgsl_free(pages);
 
 	return ret;
@@ -1045,31 +1208,6 @@ kgsl_sharedmem_set(struct kgsl_device *device,
 }
 EXPORT_SYMBOL(kgsl_sharedmem_set);
 
-static const char * const memtype_str[] = {
-	[KGSL_MEMTYPE_OBJECTANY] = "any(0)",
-	[KGSL_MEMTYPE_FRAMEBUFFER] = "framebuffer",
-	[KGSL_MEMTYPE_RENDERBUFFER] = "renderbuffer",
-	[KGSL_MEMTYPE_ARRAYBUFFER] = "arraybuffer",
-	[KGSL_MEMTYPE_ELEMENTARRAYBUFFER] = "elementarraybuffer",
-	[KGSL_MEMTYPE_VERTEXARRAYBUFFER] = "vertexarraybuffer",
-	[KGSL_MEMTYPE_TEXTURE] = "texture",
-	[KGSL_MEMTYPE_SURFACE] = "surface",
-	[KGSL_MEMTYPE_EGL_SURFACE] = "egl_surface",
-	[KGSL_MEMTYPE_GL] = "gl",
-	[KGSL_MEMTYPE_CL] = "cl",
-	[KGSL_MEMTYPE_CL_BUFFER_MAP] = "cl_buffer_map",
-	[KGSL_MEMTYPE_CL_BUFFER_NOMAP] = "cl_buffer_nomap",
-	[KGSL_MEMTYPE_CL_IMAGE_MAP] = "cl_image_map",
-	[KGSL_MEMTYPE_CL_IMAGE_NOMAP] = "cl_image_nomap",
-	[KGSL_MEMTYPE_CL_KERNEL_STACK] = "cl_kernel_stack",
-	[KGSL_MEMTYPE_COMMAND] = "command",
-	[KGSL_MEMTYPE_2D] = "2d",
-	[KGSL_MEMTYPE_EGL_IMAGE] = "egl_image",
-	[KGSL_MEMTYPE_EGL_SHADOW] = "egl_shadow",
-	[KGSL_MEMTYPE_MULTISAMPLE] = "egl_multisample",
-	/* KGSL_MEMTYPE_KERNEL handled below, to avoid huge array */
-};
-
 void kgsl_get_memory_usage(char *name, size_t name_size, uint64_t memflags)
 {
 	unsigned int type = MEMFLAGS(memflags, KGSL_MEMTYPE_MASK,
@@ -16,6 +16,8 @@
 #include <linux/utsname.h>
 #include <linux/sched.h>
 #include <linux/idr.h>
+#include <linux/vmalloc.h>
+#include <linux/lz4.h>
 
 #include "kgsl.h"
 #include "kgsl_log.h"
@@ -608,6 +610,8 @@ void kgsl_device_snapshot(struct kgsl_device *device,
 	snapshot->start = device->snapshot_memory.ptr;
 	snapshot->ptr = device->snapshot_memory.ptr;
 	snapshot->remain = device->snapshot_memory.size;
+	snapshot->mempool_max = device->snapshot_memory.mempool_max;
+	snapshot->compress = device->snapshot_memory.compress;
 	atomic_set(&snapshot->sysfs_read, 0);
 
 	header = (struct kgsl_snapshot_header *) snapshot->ptr;
@@ -813,6 +817,28 @@ static ssize_t timestamp_show(struct kgsl_device *device, char *buf)
 	return snprintf(buf, PAGE_SIZE, "%lu\n", timestamp);
 }
 
+/* Show if the GPU objects in the snapshot get compressed */
+static ssize_t compress_show(struct kgsl_device *device, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%d\n",
+		device->snapshot_memory.compress);
+}
+
+/* Enable or disable LZ4 compression of the snapshot GPU objects */
+static ssize_t compress_store(struct kgsl_device *device, const char *buf,
+	size_t count)
+{
+	unsigned int val = 0;
+	int ret;
+
+	ret = kgsl_sysfs_store(buf, &val);
+	if (ret)
+		return ret;
+
+	device->snapshot_memory.compress = val ? true : false;
+	return count;
+}
+
 static struct bin_attribute snapshot_attr = {
 	.attr.name = "dump",
 	.attr.mode = 0444,
@@ -829,6 +855,7 @@ struct kgsl_snapshot_attribute attr_##_name = { \
 
 static SNAPSHOT_ATTR(timestamp, 0444, timestamp_show, NULL);
 static SNAPSHOT_ATTR(faultcount, 0644, faultcount_show, faultcount_store);
+static SNAPSHOT_ATTR(compress, 0644, compress_show, compress_store);
 
 static ssize_t snapshot_sysfs_show(struct kobject *kobj,
 	struct attribute *attr, char *buf)
@@ -884,6 +911,12 @@ int kgsl_device_snapshot_init(struct kgsl_device *device)
 		(unsigned int *) &(device->snapshot_memory.size)))
 		device->snapshot_memory.size = KGSL_SNAPSHOT_MEMSIZE;
 
+	if (kgsl_property_read_u32(device, "qcom,snapshot-mempool-size",
+		(unsigned int *) &(device->snapshot_memory.mempool_max)))
+		device->snapshot_memory.mempool_max = KGSL_SNAPSHOT_MEMPOOL_MAX;
+
+	device->snapshot_memory.compress = true;
+
 	/*
 	 * Choosing a memory size of 0 is essentially the same as disabling
 	 * snapshotting
@@ -923,6 +956,10 @@ int kgsl_device_snapshot_init(struct kgsl_device *device)
 		goto done;
 
 	ret  = sysfs_create_file(&device->snapshot_kobj, &attr_faultcount.attr);
+	if (ret)
+		goto done;
+
+	ret  = sysfs_create_file(&device->snapshot_kobj, &attr_compress.attr);
 
 done:
 	return ret;
@@ -940,6 +977,7 @@ void kgsl_device_snapshot_close(struct kgsl_device *device)
 {
 	sysfs_remove_bin_file(&device->snapshot_kobj, &snapshot_attr);
 	sysfs_remove_file(&device->snapshot_kobj, &attr_timestamp.attr);
+	sysfs_remove_file(&device->snapshot_kobj, &attr_compress.attr);
 
 	kobject_put(&device->snapshot_kobj);
 
@@ -975,7 +1013,54 @@ int kgsl_snapshot_add_ib_obj_list(struct kgsl_snapshot *snapshot,
 	return 0;
 }
 
-static size_t _mempool_add_object(u8 *data, struct kgsl_snapshot_object *obj)
+/* Worst case mempool space needed for an object */
+static size_t _mempool_object_size(struct kgsl_snapshot *snapshot,
+		struct kgsl_snapshot_object *obj)
+{
+	if (snapshot->compress)
+		return lz4_compressbound(obj->size) +
+			sizeof(struct kgsl_snapshot_gpu_object_lz4) +
+			sizeof(struct kgsl_snapshot_section_header);
+
+	return obj->size + sizeof(struct kgsl_snapshot_gpu_object_v2) +
+		sizeof(struct kgsl_snapshot_section_header);
+}
+
+/*
+ * Compress the object straight from its GPU mapping into the mempool.
+ * Returns the size of the section or 0 if the data didn't compress, in
+ * which case the caller stores it uncompressed.
+ */
+static size_t _mempool_add_object_lz4(u8 *data,
+		struct kgsl_snapshot_object *obj, void *wrkmem)
+{
+	struct kgsl_snapshot_section_header *section =
+		(struct kgsl_snapshot_section_header *)data;
+	struct kgsl_snapshot_gpu_object_lz4 *header =
+		(void *)(data + sizeof(*section));
+	u8 *dest = data + sizeof(*section) + sizeof(*header);
+	size_t dst_len = 0;
+
+	if (lz4_compress(obj->entry->memdesc.hostptr + obj->offset, obj->size,
+		dest, &dst_len, wrkmem) || dst_len >= obj->size)
+		return 0;
+
+	section->magic = SNAPSHOT_SECTION_MAGIC;
+	section->id = KGSL_SNAPSHOT_SECTION_GPU_OBJECT_LZ4;
+	section->size = dst_len + sizeof(*header) + sizeof(*section);
+
+	header->size = obj->size >> 2;
+	header->compressed_size = dst_len;
+	header->gpuaddr = obj->gpuaddr;
+	header->ptbase =
+		kgsl_mmu_pagetable_get_ttbr0(obj->entry->priv->pagetable);
+	header->type = obj->type;
+
+	return section->size;
+}
+
+static size_t _mempool_add_object(u8 *data, struct kgsl_snapshot_object *obj,
+		void *wrkmem)
 {
 	struct kgsl_snapshot_section_header *section =
 		(struct kgsl_snapshot_section_header *)data;
@@ -983,6 +1068,7 @@ static size_t _mempool_add_object(u8 *data, struct kgsl_snapshot_object *obj)
 		(struct kgsl_snapshot_gpu_object_v2 *)(data + sizeof(*section));
 	u8 *dest = data + sizeof(*section) + sizeof(*header);
 	uint64_t size;
+	size_t ret;
 
 	size = obj->size;
 
@@ -991,6 +1077,14 @@ static size_t _mempool_add_object(u8 *data, struct kgsl_snapshot_object *obj)
 		return 0;
 	}
 
+	if (wrkmem != NULL) {
+		ret = _mempool_add_object_lz4(data, obj, wrkmem);
+		if (ret) {
+			kgsl_memdesc_unmap(&obj->entry->memdesc);
+			return ret;
+		}
+	}
+
 	section->magic = SNAPSHOT_SECTION_MAGIC;
 	section->id = KGSL_SNAPSHOT_SECTION_GPU_OBJECT_V2;
 	section->size = size + sizeof(*header) + sizeof(*section);
@@ -1012,13 +1106,19 @@ static size_t _mempool_add_object(u8 *data, struct kgsl_snapshot_object *obj)
  * memory so that the data reported in these objects is correct when snapshot
  * is taken
  * @work: The work item that scheduled this work
+ *
+ * This runs after recovery has been allowed to proceed. The objects are
+ * (optionally) LZ4 compressed into a mempool that is capped at
+ * mempool_max; objects that don't fit are dropped.
  */
 void kgsl_snapshot_save_frozen_objs(struct work_struct *work)
 {
 	struct kgsl_snapshot *snapshot = container_of(work,
 				struct kgsl_snapshot, work);
 	struct kgsl_snapshot_object *obj, *tmp;
-	size_t size = 0;
+	size_t size = 0, remain;
+	void *wrkmem = NULL;
+	int dropped = 0;
 	void *ptr;
 
 	kgsl_snapshot_process_ib_obj_list(snapshot);
@@ -1026,14 +1126,17 @@ void kgsl_snapshot_save_frozen_objs(struct work_struct *work)
 	list_for_each_entry(obj, &snapshot->obj_list, node) {
 		obj->size = ALIGN(obj->size, 4);
 
-		size += ((size_t) obj->size +
-			sizeof(struct kgsl_snapshot_gpu_object_v2) +
-			sizeof(struct kgsl_snapshot_section_header));
+		size += _mempool_object_size(snapshot, obj);
 	}
 
 	if (size == 0)
 		goto done;
 
+	size = min_t(size_t, size, snapshot->mempool_max);
+
+	if (snapshot->compress)
+		wrkmem = vmalloc(LZ4_MEM_COMPRESS);
+
 	snapshot->mempool = vmalloc(size);
 	if (snapshot->mempool != NULL)
 		KGSL_CORE_ERR("snapshot: mempool address %p, size %zx\n",
@@ -1041,17 +1144,31 @@ void kgsl_snapshot_save_frozen_objs(struct work_struct *work)
 
 	ptr = snapshot->mempool;
 	snapshot->mempool_size = 0;
+	remain = size;
 
 	/* even if vmalloc fails, make sure we clean up the obj_list */
 	list_for_each_entry_safe(obj, tmp, &snapshot->obj_list, node) {
 		if (snapshot->mempool) {
-			size_t ret = _mempool_add_object(ptr, obj);
+			size_t ret = 0;
+
+			if (_mempool_object_size(snapshot, obj) <= remain)
+				ret = _mempool_add_object(ptr, obj, wrkmem);
+			else
+				dropped++;
+
 			ptr += ret;
+			remain -= ret;
 			snapshot->mempool_size += ret;
 		}
 
 		kgsl_snapshot_put_object(obj);
 	}
+
+	if (dropped)
+		KGSL_CORE_ERR("snapshot: %d objects dropped, mempool full\n",
+				dropped);
+
+	vfree(wrkmem);
 done:
 	/*
 	 * Get rid of the process struct here, so that it doesn't sit
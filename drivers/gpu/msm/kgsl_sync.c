@@ -351,6 +351,9 @@ int kgsl_sync_timeline_create(struct kgsl_context *context)
 	ktimeline->device = context->device;
 	ktimeline->context_id = context->id;
 
+	/* Timestamps on a context always retire in order */
+	context->timeline->ordered = true;
+
 	spin_lock_init(&ktimeline->lock);
 	return 0;
 }
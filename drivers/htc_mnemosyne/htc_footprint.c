@@ -48,6 +48,47 @@ static inline int cpu_sw_idx_to_hw_idx(int cpu)
 	return (cluster_id * MAX_CPUS_PER_CLUSTER + cpu_id);
 }
 
+/*
+ * Per-cpu footprint slots resolved once at boot, so that the power
+ * collapse paths neither walk the MPIDR nor read back the uncached
+ * mnemosyne region to update a field.
+ */
+struct footprint_cpu {
+	MNEMOSYNE_ELEMENT_TYPE *footprint;
+	MNEMOSYNE_ELEMENT_TYPE *exit_counter;
+	u64 *events;
+	uint32_t state;
+	uint32_t exit_count;
+	uint32_t seq;
+} ____cacheline_aligned_in_smp;
+
+static struct footprint_cpu footprint_cpus[NR_CPUS];
+
+void __htc_footprint_event(unsigned cpu, enum footprint_event ev, u32 arg)
+{
+	struct footprint_cpu *fc;
+	unsigned long flags;
+	unsigned this_cpu;
+	u64 entry;
+
+	local_irq_save(flags);
+	this_cpu = smp_processor_id();
+	if (unlikely(this_cpu >= NR_CPUS))
+		goto out;
+
+	fc = &footprint_cpus[this_cpu];
+	if (unlikely(!fc->events))
+		goto out;
+
+	fc->seq++;
+	entry = (u64)(fc->seq & FP_EV_SEQ_MASK) << FP_EV_SEQ_SHIFT |
+		(u64)(cpu & FP_EV_CPU_MASK) << FP_EV_CPU_SHIFT |
+		(u64)ev << FP_EV_ID_SHIFT | arg;
+	fc->events[fc->seq & (FOOTPRINT_EVENT_LOG_LEN - 1)] = entry;
+out:
+	local_irq_restore(flags);
+}
+
 int clk_get_cpu_idx(struct clk *c);
 
 int __weak clk_get_cpu_idx(struct clk *c)
@@ -186,6 +227,7 @@ void set_acpuclk_footprint(unsigned cpu, unsigned state)
 	}
 
 	MNEMOSYNE_SET_I(acpuclk_set_rate_footprint_cpu, S2H(cpu), (CPU_FOOT_PRINT_MAGIC | state));
+	htc_footprint_event(cpu, ACPUCLK, state);
 	mb();
 }
 
@@ -216,12 +258,15 @@ void set_acpuclk_cpu_freq_footprint(enum FREQ_TYPE type, unsigned cpu, unsigned
 	switch (type) {
 		case FT_PREV_RATE:
 			MNEMOSYNE_SET_I(cpu_prev_frequency, S2H(cpu), khz);
+			htc_footprint_event(cpu, CPU_PREV_RATE, khz);
 			break;
 		case FT_CUR_RATE:
 			MNEMOSYNE_SET_I(cpu_frequency, S2H(cpu), khz);
+			htc_footprint_event(cpu, CPU_CUR_RATE, khz);
 			break;
 		case FT_NEW_RATE:
 			MNEMOSYNE_SET_I(cpu_new_frequency, S2H(cpu), khz);
+			htc_footprint_event(cpu, CPU_NEW_RATE, khz);
 			break;
 	}
 	mb();
@@ -272,20 +317,26 @@ void set_acpuclk_l2_freq_footprint_by_clk(enum FREQ_TYPE type, struct clk* c, un
 
 void inc_kernel_exit_counter_from_pc(unsigned cpu)
 {
-	unsigned int counter;
+	struct footprint_cpu *fc;
+
 	if (unlikely(cpu >= NR_CPUS)) {
 		WARN(1, "Only %d cores, but try to increase kernel exit counter from PC for core %d\n",
 			NR_CPUS, cpu);
 		return;
 	}
 
-	counter = MNEMOSYNE_GET_I(kernel_exit_counter_from_cpu, S2H(cpu)) + 1;
-	MNEMOSYNE_SET_I(kernel_exit_counter_from_cpu, S2H(cpu), counter);
-	mb();
+	fc = &footprint_cpus[cpu];
+	if (unlikely(!fc->exit_counter))
+		return;
+
+	*fc->exit_counter = ++fc->exit_count;
+	htc_footprint_event(cpu, PC_EXIT, fc->exit_count);
+	wmb();
 }
 
 void init_cpu_foot_print(unsigned cpu, bool from_idle, bool notify_rpm)
 {
+	struct footprint_cpu *fc;
 	unsigned state = CPU_FOOT_PRINT_MAGIC_HOTPLUG;
 	bool is_FPC = !notify_rpm;
 	bool not_hotplug = !cpu || from_idle;
@@ -302,24 +353,34 @@ void init_cpu_foot_print(unsigned cpu, bool from_idle, bool notify_rpm)
 			state = (from_idle) ? CPU_FOOT_PRINT_MAGIC_FROM_IDLE : CPU_FOOT_PRINT_MAGIC;
 	}
 
-	MNEMOSYNE_SET_I(kernel_footprint_cpu, S2H(cpu), state);
-	mb();
+	fc = &footprint_cpus[cpu];
+	if (unlikely(!fc->footprint))
+		return;
+
+	fc->state = state;
+	*fc->footprint = state;
+	htc_footprint_event(cpu, PC_INIT, state);
+	wmb();
 }
 
 void set_cpu_foot_print(unsigned cpu, unsigned state)
 {
+	struct footprint_cpu *fc;
 	unsigned mask = 0xFF;
-	unsigned new_state;
 
 	if (unlikely(cpu >= NR_CPUS)) {
 		WARN(1, "Only %d cores, but try to set footprint for core %d\n", NR_CPUS, cpu);
 		return;
 	}
 
-	new_state = (MNEMOSYNE_GET_I(kernel_footprint_cpu, S2H(cpu)) & ~mask) | (state & mask);
+	fc = &footprint_cpus[cpu];
+	if (unlikely(!fc->footprint))
+		return;
 
-	MNEMOSYNE_SET_I(kernel_footprint_cpu, S2H(cpu), new_state)
-	mb();
+	fc->state = (fc->state & ~mask) | (state & mask);
+	*fc->footprint = fc->state;
+	htc_footprint_event(cpu, PC_STATE, state & mask);
+	wmb();
 }
 
 void clean_reset_vector_debug_info(unsigned cpu)
@@ -386,6 +447,7 @@ void set_hotplug_on_footprint(unsigned cpu, unsigned value)
 	}
 
 	MNEMOSYNE_SET_I(cpu_hotplug_on, S2H(cpu), HOTPLUG_ON_MAGIC | (value & 0xFF));
+	htc_footprint_event(cpu, HOTPLUG_ON, value & 0xFF);
 	mb();
 }
 
@@ -403,12 +465,26 @@ static int __init boot_init_footprint(void)
 	}
 
 	for (i = 0; i < NR_CPUS; i++) {
-		MNEMOSYNE_SET_I(kernel_footprint_cpu, S2H(i), CPU_FOOT_PRINT_MAGIC_HOTPLUG | 0x1);
-		MNEMOSYNE_SET_I(kernel_exit_counter_from_cpu, S2H(i), 0x0);
+		struct footprint_cpu *fc = &footprint_cpus[i];
+		int hw = S2H(i);
+
+		fc->state = i ? CPU_FOOT_PRINT_MAGIC_HOTPLUG | 0x1 :
+				CPU_FOOT_PRINT_MAGIC | 0xb;
+		fc->exit_count = 0;
+		MNEMOSYNE_SET_I(kernel_footprint_cpu, hw, fc->state);
+		MNEMOSYNE_SET_I(kernel_exit_counter_from_cpu, hw, 0x0);
+		fc->footprint = MNEMOSYNE_GET_ADDR_I(kernel_footprint_cpu, hw);
+		fc->exit_counter =
+			MNEMOSYNE_GET_ADDR_I(kernel_exit_counter_from_cpu, hw);
+#ifdef CONFIG_HTC_DEBUG_FOOTPRINT_EVENTS
+		fc->events = (u64 *)MNEMOSYNE_GET_ADDR(footprint_event_log);
+		if (fc->events) {
+			fc->events += hw * FOOTPRINT_EVENT_LOG_LEN;
+			memset(fc->events, 0,
+			       FOOTPRINT_EVENT_LOG_LEN * sizeof(u64));
+		}
+#endif
 	}
-	
-	
-	MNEMOSYNE_SET_I(kernel_footprint_cpu, S2H(0), CPU_FOOT_PRINT_MAGIC | 0xb);
 	mb();
 	pr_info("%s: htc footprint init done.\n", __func__);
 
@@ -25,6 +25,7 @@
 #include <asm/uaccess.h>
 #include <asm/atomic.h>
 #include <htc_mnemosyne/htc_mnemosyne.h>
+#include <htc_mnemosyne/htc_footprint.h>
 
 #define MNEMOSYNE_MODULE_NAME	"mnemosyne"
 #define MNEMOSYNE_DT_NAME	"htc_mnemosyne"
@@ -276,6 +277,81 @@ static const struct file_operations rawdata_fops = {
 	.owner		= THIS_MODULE,
 };
 
+#ifdef CONFIG_HTC_DEBUG_FOOTPRINT_EVENTS
+#define DECLARE_FOOTPRINT_EVENT(name, category)	[FP_EV_##name] = #name,
+static const char * const footprint_event_names[FP_EV_NR] = {
+	[FP_EV_NONE] = "NONE",
+#include <htc_mnemosyne/htc_footprint_event.inc>
+};
+#undef DECLARE_FOOTPRINT_EVENT
+
+#define FP_EV_SEQ(e)	(((e) >> FP_EV_SEQ_SHIFT) & FP_EV_SEQ_MASK)
+#define FP_EV_CPU(e)	(((e) >> FP_EV_CPU_SHIFT) & FP_EV_CPU_MASK)
+#define FP_EV_ID(e)	(((e) >> FP_EV_ID_SHIFT) & FP_EV_ID_MASK)
+
+/* The oldest event follows the first break in the sequence numbers */
+static int footprint_events_oldest(const u64 *log)
+{
+	u64 prev = FP_EV_SEQ(log[0]);
+	int i;
+
+	for (i = 1; i < FOOTPRINT_EVENT_LOG_LEN; i++) {
+		if (FP_EV_ID(log[i]) == FP_EV_NONE)
+			break;
+		if (FP_EV_SEQ(log[i]) != ((prev + 1) & FP_EV_SEQ_MASK))
+			return i;
+		prev = FP_EV_SEQ(log[i]);
+	}
+
+	return 0;
+}
+
+static int footprint_events_show(struct seq_file *sfile, void *v)
+{
+	const u64 *log;
+	u64 e;
+	int ring, i, oldest, id;
+
+	if (atomic_read(&mnemosync_is_init) == 0) {
+		pr_warn("%s: not init!\n", MNEMOSYNE_MODULE_NAME);
+		return 0;
+	}
+
+	for (ring = 0; ring < NR_CPUS; ring++) {
+		log = (const u64 *)mnemosyne_base->footprint_event_log +
+			ring * FOOTPRINT_EVENT_LOG_LEN;
+		oldest = footprint_events_oldest(log);
+
+		seq_printf(sfile, "ring %d:\n", ring);
+		for (i = 0; i < FOOTPRINT_EVENT_LOG_LEN; i++) {
+			e = log[(oldest + i) & (FOOTPRINT_EVENT_LOG_LEN - 1)];
+			id = FP_EV_ID(e);
+			if (id == FP_EV_NONE)
+				continue;
+			seq_printf(sfile, "%7llu cpu%llu %-14s 0x%08x\n",
+				   FP_EV_SEQ(e), FP_EV_CPU(e),
+				   id < FP_EV_NR ? footprint_event_names[id] :
+				   "UNKNOWN", (uint32_t)e);
+		}
+	}
+
+	return 0;
+}
+
+static int footprint_events_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, footprint_events_show, NULL);
+}
+
+static const struct file_operations footprint_events_fops = {
+	.open		= footprint_events_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+	.owner		= THIS_MODULE,
+};
+#endif
+
 static struct dentry *base_dir;
 
 static int mnemosyne_debugfs_setup(void)
@@ -289,6 +365,10 @@ static int mnemosyne_debugfs_setup(void)
 
 	debugfs_create_file("is_init", S_IRUGO, base_dir, NULL, &is_init_fops);
 	debugfs_create_file("rawdata", S_IRUGO, base_dir, NULL, &rawdata_fops);
+#ifdef CONFIG_HTC_DEBUG_FOOTPRINT_EVENTS
+	debugfs_create_file("footprint_events", S_IRUGO, base_dir, NULL,
+			    &footprint_events_fops);
+#endif
 
 	return 0;
 }
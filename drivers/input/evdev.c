@@ -14,6 +14,7 @@
 #define EVDEV_MINORS		32
 #define EVDEV_MIN_BUFFER_SIZE	64U
 #define EVDEV_BUF_PACKETS	8
+#define EVDEV_MAX_BATCH_MS	1000U
 
 #include <linux/poll.h>
 #include <linux/sched.h>
@@ -55,10 +56,71 @@ struct evdev_client {
 	struct list_head node;
 	int clkid;
 	bool revoked;
+	/*
+	 * With batching, complete packets are queued up to batch_head but
+	 * only made visible to the reader, by moving packet_head, once the
+	 * batch is full or batch_timer expires.
+	 */
+	struct input_batch batch;
+	unsigned int batch_head;
+	unsigned int batch_limit;
+	struct timer_list batch_timer;
 	unsigned int bufsize;
 	struct input_event buffer[];
 };
 
+/* publish held back packets, caller must hold client->buffer_lock */
+static bool __evdev_batch_flush(struct evdev_client *client)
+{
+	if (client->packet_head == client->batch_head)
+		return false;
+
+	client->packet_head = client->batch_head;
+	kill_fasync(&client->fasync, SIGIO, POLL_IN);
+
+	return true;
+}
+
+/*
+ * Decide whether the packet just completed at batch_head is held back,
+ * caller must hold client->buffer_lock.
+ */
+static bool evdev_batch_hold(struct evdev_client *client)
+{
+	unsigned int pending;
+
+	if (!client->batch.max_latency_ms ||
+	    (client->batch.flags & INPUT_BATCH_LOW_LATENCY))
+		return false;
+
+	pending = (client->batch_head - client->packet_head) &
+			(client->bufsize - 1);
+	if (pending >= client->batch_limit) {
+		del_timer(&client->batch_timer);
+		return false;
+	}
+
+	if (!timer_pending(&client->batch_timer))
+		mod_timer(&client->batch_timer, jiffies +
+			  msecs_to_jiffies(client->batch.max_latency_ms));
+
+	return true;
+}
+
+static void evdev_batch_timeout(unsigned long data)
+{
+	struct evdev_client *client = (struct evdev_client *)data;
+	unsigned long flags;
+	bool flushed;
+
+	spin_lock_irqsave(&client->buffer_lock, flags);
+	flushed = __evdev_batch_flush(client);
+	spin_unlock_irqrestore(&client->buffer_lock, flags);
+
+	if (flushed)
+		wake_up_interruptible(&client->evdev->wait);
+}
+
 /* flush queued events of type @type, caller must hold client->buffer_lock */
 static void __evdev_flush_queue(struct evdev_client *client, unsigned int type)
 {
@@ -103,6 +165,7 @@ static void __evdev_flush_queue(struct evdev_client *client, unsigned int type)
 	}
 
 	client->head = head;
+	client->batch_head = client->packet_head;
 }
 
 /* queue SYN_DROPPED event */
@@ -129,12 +192,14 @@ static void evdev_queue_syn_dropped(struct evdev_client *client)
 		/* drop queue but keep our SYN_DROPPED event */
 		client->tail = (client->head - 1) & (client->bufsize - 1);
 		client->packet_head = client->tail;
+		client->batch_head = client->tail;
 	}
 
 	spin_unlock_irqrestore(&client->buffer_lock, flags);
 }
 
-static void __pass_event(struct evdev_client *client,
+/* returns true when a packet was made visible to the reader */
+static bool __pass_event(struct evdev_client *client,
 			 const struct input_event *event)
 {
 	client->buffer[client->head++] = *event;
@@ -153,16 +218,21 @@ static void __pass_event(struct evdev_client *client,
 		client->buffer[client->tail].value = 0;
 
 		client->packet_head = client->tail;
+		client->batch_head = client->tail;
 		if (client->use_wake_lock)
 			wake_unlock(&client->wake_lock);
 	}
 
 	if (event->type == EV_SYN && event->code == SYN_REPORT) {
-		client->packet_head = client->head;
+		client->batch_head = client->head;
 		if (client->use_wake_lock)
 			wake_lock(&client->wake_lock);
-		kill_fasync(&client->fasync, SIGIO, POLL_IN);
+		if (evdev_batch_hold(client))
+			return false;
+		return __evdev_batch_flush(client);
 	}
+
+	return false;
 }
 
 static void evdev_pass_values(struct evdev_client *client,
@@ -187,8 +257,7 @@ static void evdev_pass_values(struct evdev_client *client,
 		event.type = v->type;
 		event.code = v->code;
 		event.value = v->value;
-		__pass_event(client, &event);
-		if (v->type == EV_SYN && v->code == SYN_REPORT)
+		if (__pass_event(client, &event))
 			wakeup = true;
 	}
 
@@ -378,6 +447,7 @@ static int evdev_release(struct inode *inode, struct file *file)
 	mutex_unlock(&evdev->mutex);
 
 	evdev_detach_client(evdev, client);
+	del_timer_sync(&client->batch_timer);
 
 	if (client->use_wake_lock)
 		wake_lock_destroy(&client->wake_lock);
@@ -418,6 +488,8 @@ static int evdev_open(struct inode *inode, struct file *file)
 
 	client->bufsize = bufsize;
 	spin_lock_init(&client->buffer_lock);
+	setup_timer(&client->batch_timer, evdev_batch_timeout,
+		    (unsigned long)client);
 	snprintf(client->name, sizeof(client->name), "%s-%d",
 			dev_name(&evdev->dev), task_tgid_vnr(current));
 	client->evdev = evdev;
@@ -487,7 +559,8 @@ static int evdev_fetch_next_event(struct evdev_client *client,
 		*event = client->buffer[client->tail++];
 		client->tail &= client->bufsize - 1;
 		if (client->use_wake_lock &&
-		    client->packet_head == client->tail)
+		    client->packet_head == client->tail &&
+		    client->batch_head == client->packet_head)
 			wake_unlock(&client->wake_lock);
 	}
 
@@ -857,6 +930,39 @@ static int evdev_disable_suspend_block(struct evdev *evdev,
 	return 0;
 }
 
+static int evdev_set_batch(struct evdev_client *client, void __user *p)
+{
+	struct input_batch batch;
+	unsigned int limit;
+	bool flushed;
+
+	if (copy_from_user(&batch, p, sizeof(batch)))
+		return -EFAULT;
+
+	if (batch.flags & ~INPUT_BATCH_LOW_LATENCY)
+		return -EINVAL;
+	if (batch.max_latency_ms > EVDEV_MAX_BATCH_MS)
+		return -EINVAL;
+
+	/* leave room so that a full batch never overruns the buffer */
+	limit = client->bufsize / 2;
+	if (batch.max_events && batch.max_events < limit)
+		limit = batch.max_events;
+
+	spin_lock_irq(&client->buffer_lock);
+	client->batch = batch;
+	client->batch_limit = limit;
+	/* anything held under the old settings goes out now */
+	del_timer(&client->batch_timer);
+	flushed = __evdev_batch_flush(client);
+	spin_unlock_irq(&client->buffer_lock);
+
+	if (flushed)
+		wake_up_interruptible(&client->evdev->wait);
+
+	return 0;
+}
+
 static long evdev_do_ioctl(struct file *file, unsigned int cmd,
 			   void __user *p, int compat_mode)
 {
@@ -938,6 +1044,14 @@ static long evdev_do_ioctl(struct file *file, unsigned int cmd,
 		client->clkid = i;
 		return 0;
 
+	case EVIOCGBATCH:
+		if (copy_to_user(p, &client->batch, sizeof(client->batch)))
+			return -EFAULT;
+		return 0;
+
+	case EVIOCSBATCH:
+		return evdev_set_batch(client, p);
+
 	case EVIOCGKEYCODE:
 		return evdev_handle_get_keycode(dev, p);
 
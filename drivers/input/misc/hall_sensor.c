@@ -480,6 +480,7 @@ static struct platform_driver hall_sensor_driver = {
 	.driver = {
 		.name = "AK8789_HALL_SENSOR",
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 #ifdef CONFIG_PM
 		.pm = &hall_sensor_pm_ops,
 #endif
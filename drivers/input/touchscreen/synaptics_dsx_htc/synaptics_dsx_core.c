@@ -20,6 +20,8 @@
 #include <linux/module.h>
 #include <linux/slab.h>
 #include <linux/interrupt.h>
+#include <linux/sched.h>
+#include <linux/ktime.h>
 #include <linux/delay.h>
 #include <linux/input.h>
 #include <linux/gpio.h>
@@ -130,6 +132,9 @@ static int synaptics_rmi4_reinit_device(struct synaptics_rmi4_data *rmi4_data);
 static int synaptics_rmi4_reset_device(struct synaptics_rmi4_data *rmi4_data);
 static int synaptics_rmi4_hw_reset_device(struct synaptics_rmi4_data *rmi4_data);
 static irqreturn_t synaptics_rmi4_irq(int irq, void *data);
+#ifndef MTK_PLATFORM
+static irqreturn_t synaptics_rmi4_hardirq(int irq, void *data);
+#endif
 #ifdef MTK_PLATFORM
 static int irq_registration(unsigned int *irq, irq_handler_t handler, unsigned long flags, const char *name, void *dev);
 #endif
@@ -1207,11 +1212,13 @@ static ssize_t int_status_store(struct device *dev,
 				synaptics_rmi4_irq, bdata->irq_flags,
 				PLATFORM_DRIVER_NAME, rmi4_data);
 #else
-		ret = request_threaded_irq(rmi4_data->irq, NULL,
+		ret = request_threaded_irq(rmi4_data->irq,
+				synaptics_rmi4_hardirq,
 				synaptics_rmi4_irq, bdata->irq_flags,
 				PLATFORM_DRIVER_NAME, rmi4_data);
 #endif
 		if (ret == 0) {
+			rmi4_data->irq_thread_setup = true;
 			rmi4_data->irq_enabled = true;
 			pr_info("%s: interrupt enable: %x\n", __func__, rmi4_data->irq_enabled);
 		}
@@ -1988,6 +1995,13 @@ static unsigned short synaptics_sqrt(unsigned int num)
 	return root;
 }
 
+static void synaptics_rmi4_report_timestamp(
+		struct synaptics_rmi4_data *rmi4_data)
+{
+	input_event(rmi4_data->input_dev, EV_MSC, MSC_TIMESTAMP,
+			(u32)ktime_to_us(rmi4_data->irq_time));
+}
+
 static int synaptics_rmi4_f11_abs_report(struct synaptics_rmi4_data *rmi4_data,
 		struct synaptics_rmi4_fn *fhandler)
 {
@@ -2158,6 +2172,7 @@ static int synaptics_rmi4_f11_abs_report(struct synaptics_rmi4_data *rmi4_data,
 #endif
 	}
 
+	synaptics_rmi4_report_timestamp(rmi4_data);
 	input_sync(rmi4_data->input_dev);
 
 exit:
@@ -2170,6 +2185,7 @@ static int synaptics_rmi4_f12_abs_report(struct synaptics_rmi4_data *rmi4_data,
 		struct synaptics_rmi4_fn *fhandler)
 {
 	int retval;
+	bool data15_prefetched;
 	unsigned char touch_count = 0; 
 	unsigned char finger;
 	unsigned char fingers_to_process;
@@ -2199,6 +2215,10 @@ static int synaptics_rmi4_f12_abs_report(struct synaptics_rmi4_data *rmi4_data,
 	extra_data = (struct synaptics_rmi4_f12_extra_data *)fhandler->extra;
 	size_of_2d_data = sizeof(struct synaptics_rmi4_f12_finger_data);
 
+	/* set by synaptics_rmi4_sensor_report() for this interrupt only */
+	data15_prefetched = extra_data->data15_prefetched;
+	extra_data->data15_prefetched = false;
+
 	if (rmi4_data->suspend && rmi4_data->enable_wakeup_gesture) {
 		dev_dbg(rmi4_data->pdev->dev.parent, " %s, enable_wakeup_gesture\n", __func__);
 		retval = synaptics_rmi4_reg_read(rmi4_data,
@@ -2221,7 +2241,7 @@ static int synaptics_rmi4_f12_abs_report(struct synaptics_rmi4_data *rmi4_data,
 	}
 
 	
-	if (extra_data->data15_size) {
+	if (extra_data->data15_size && !data15_prefetched) {
 		retval = synaptics_rmi4_reg_read(rmi4_data,
 				data_addr + extra_data->data15_offset,
 				extra_data->data15_data,
@@ -2468,6 +2488,7 @@ static int synaptics_rmi4_f12_abs_report(struct synaptics_rmi4_data *rmi4_data,
 		}
 	}
 
+	synaptics_rmi4_report_timestamp(rmi4_data);
 	input_sync(rmi4_data->input_dev);
 
 	if (debug_mask & BIT(2)) {
@@ -2706,6 +2727,65 @@ static void synaptics_rmi4_report_touch(struct synaptics_rmi4_data *rmi4_data,
 	return;
 }
 
+/*
+ * Read the interrupt status and, speculatively, the F12 object present
+ * bitmap in one bus transaction. Almost every interrupt is a touch
+ * report which needs both, so this saves a full i2c round trip on the
+ * way to the first input event. Falls back to the plain status read when
+ * the bus has no batched read or the registers sit on different pages.
+ */
+static int synaptics_rmi4_read_status(struct synaptics_rmi4_data *rmi4_data,
+		unsigned char *data)
+{
+	int retval;
+	unsigned short data15_addr;
+	struct synaptics_rmi4_fn *fhandler;
+	struct synaptics_rmi4_f12_extra_data *extra_data;
+	struct synaptics_rmi4_read_req req[2];
+	const struct synaptics_dsx_bus_access *bus_access =
+			rmi4_data->hw_if->bus_access;
+
+	if (!bus_access->read_multi)
+		goto single;
+	if (rmi4_data->suspend && rmi4_data->enable_wakeup_gesture)
+		goto single;
+
+	list_for_each_entry(fhandler, &rmi4_data->rmi4_mod_info.support_fn_list,
+			link) {
+		if (fhandler->fn_number != SYNAPTICS_RMI4_F12)
+			continue;
+
+		extra_data = (struct synaptics_rmi4_f12_extra_data *)
+				fhandler->extra;
+		data15_addr = fhandler->full_addr.data_base +
+				extra_data->data15_offset;
+		if (!extra_data->data15_size ||
+				(data15_addr >> 8) !=
+				(rmi4_data->f01_data_base_addr >> 8))
+			break;
+
+		req[0].addr = rmi4_data->f01_data_base_addr;
+		req[0].data = data;
+		req[0].length = rmi4_data->num_of_intr_regs + 1;
+		req[1].addr = data15_addr;
+		req[1].data = extra_data->data15_data;
+		req[1].length = extra_data->data15_size;
+
+		retval = bus_access->read_multi(rmi4_data, req, 2);
+		if (retval < 0)
+			break;
+
+		extra_data->data15_prefetched = true;
+		return 0;
+	}
+
+single:
+	return synaptics_rmi4_reg_read(rmi4_data,
+			rmi4_data->f01_data_base_addr,
+			data,
+			rmi4_data->num_of_intr_regs + 1);
+}
+
 static void synaptics_rmi4_sensor_report(struct synaptics_rmi4_data *rmi4_data)
 {
 	int retval;
@@ -2718,10 +2798,7 @@ static void synaptics_rmi4_sensor_report(struct synaptics_rmi4_data *rmi4_data)
 
 	rmi = &(rmi4_data->rmi4_mod_info);
 
-	retval = synaptics_rmi4_reg_read(rmi4_data,
-			rmi4_data->f01_data_base_addr,
-			data,
-			rmi4_data->num_of_intr_regs + 1);
+	retval = synaptics_rmi4_read_status(rmi4_data, data);
 	if (retval < 0) {
 		dev_err(rmi4_data->pdev->dev.parent,
 				"%s: Failed to read interrupt status\n",
@@ -2782,6 +2859,8 @@ static irqreturn_t synaptics_rmi4_irq(int irq, void *data)
 	const struct synaptics_dsx_board_data *bdata =
 			rmi4_data->hw_if->board_data;
 
+	rmi4_data->irq_time = ktime_get();
+
 	if (debug_mask & BIT(2)) {
 		getnstimeofday(&time_start);
 	}
@@ -2793,12 +2872,73 @@ exit:
 	return IRQ_HANDLED;
 }
 #else
+/*
+ * Only stamp the interrupt here, the bus traffic is done by the irq
+ * thread. The stamp is reported with the touch frame as MSC_TIMESTAMP
+ * so that userspace can measure latency from the panel interrupt.
+ */
+static irqreturn_t synaptics_rmi4_hardirq(int irq, void *data)
+{
+	struct synaptics_rmi4_data *rmi4_data = data;
+
+	rmi4_data->irq_time = ktime_get();
+
+	return IRQ_WAKE_THREAD;
+}
+
+/*
+ * Apply the board's cpu pinning and RT priority to the irq thread. Runs
+ * in the thread itself on its first interrupt, since the thread is only
+ * created by request_threaded_irq().
+ */
+static void synaptics_rmi4_irq_thread_setup(
+		struct synaptics_rmi4_data *rmi4_data)
+{
+	int retval;
+	int cpu;
+	cpumask_t mask;
+	struct sched_param param;
+	const struct synaptics_dsx_board_data *bdata =
+			rmi4_data->hw_if->board_data;
+
+	if (bdata->irq_cpu_mask) {
+		cpumask_clear(&mask);
+		for_each_possible_cpu(cpu) {
+			if (cpu < 32 && (bdata->irq_cpu_mask & BIT(cpu)))
+				cpumask_set_cpu(cpu, &mask);
+		}
+		retval = cpumask_empty(&mask) ? -EINVAL :
+				set_cpus_allowed_ptr(current, &mask);
+		if (retval < 0) {
+			dev_err(rmi4_data->pdev->dev.parent,
+					"%s: Failed to pin irq thread (%d)\n",
+					__func__, retval);
+		}
+	}
+
+	if (bdata->irq_thread_prio) {
+		param.sched_priority = bdata->irq_thread_prio;
+		retval = sched_setscheduler_nocheck(current, SCHED_FIFO,
+				&param);
+		if (retval < 0) {
+			dev_err(rmi4_data->pdev->dev.parent,
+					"%s: Failed to set irq thread priority (%d)\n",
+					__func__, retval);
+		}
+	}
+}
+
 static irqreturn_t synaptics_rmi4_irq(int irq, void *data)
 {
 	struct synaptics_rmi4_data *rmi4_data = data;
 	const struct synaptics_dsx_board_data *bdata =
 			rmi4_data->hw_if->board_data;
 
+	if (unlikely(rmi4_data->irq_thread_setup)) {
+		rmi4_data->irq_thread_setup = false;
+		synaptics_rmi4_irq_thread_setup(rmi4_data);
+	}
+
 	if (debug_mask & BIT(2)) {
 		getnstimeofday(&time_start);
 	}
@@ -4263,6 +4403,7 @@ static int synaptics_rmi4_set_input_dev(struct synaptics_rmi4_data *rmi4_data)
 	set_bit(EV_SYN, rmi4_data->input_dev->evbit);
 	set_bit(EV_KEY, rmi4_data->input_dev->evbit);
 	set_bit(EV_ABS, rmi4_data->input_dev->evbit);
+	input_set_capability(rmi4_data->input_dev, EV_MSC, MSC_TIMESTAMP);
 #ifdef INPUT_PROP_DIRECT
 	set_bit(INPUT_PROP_DIRECT, rmi4_data->input_dev->propbit);
 #endif
@@ -5178,7 +5319,8 @@ static int synaptics_rmi4_probe(struct platform_device *pdev)
 			synaptics_rmi4_irq, bdata->irq_flags,
 			PLATFORM_DRIVER_NAME, rmi4_data);
 #else
-	retval = request_threaded_irq(rmi4_data->irq, NULL,
+	rmi4_data->irq_thread_setup = true;
+	retval = request_threaded_irq(rmi4_data->irq, synaptics_rmi4_hardirq,
 			synaptics_rmi4_irq, bdata->irq_flags,
 			PLATFORM_DRIVER_NAME, rmi4_data);
 #endif
@@ -208,6 +208,7 @@ struct synaptics_rmi4_f12_extra_data {
 	unsigned char data15_offset;
 	unsigned char data15_size;
 	unsigned char data15_data[(F12_FINGERS_TO_SUPPORT + 7) / 8];
+	bool data15_prefetched;
 	unsigned char ctrl9_offset;
 	unsigned char ctrl10_offset;
 	unsigned char ctrl11_offset;
@@ -319,6 +320,8 @@ struct synaptics_rmi4_data {
 	unsigned int firmware_id;
 	unsigned int chip_id;
 	int irq;
+	ktime_t irq_time;
+	bool irq_thread_setup;
 	int sensor_max_x;
 	int sensor_max_y;
 	int sensor_max_z;
@@ -368,10 +371,21 @@ struct synaptics_rmi4_data {
 	uint8_t hall_block_touch_event;
 };
 
+#define SYN_READ_MULTI_MAX 4
+
+struct synaptics_rmi4_read_req {
+	unsigned short addr;
+	unsigned char *data;
+	unsigned short length;
+};
+
 struct synaptics_dsx_bus_access {
 	unsigned char type;
 	int (*read)(struct synaptics_rmi4_data *rmi4_data, unsigned short addr,
 		unsigned char *data, unsigned short length);
+	/* optional, all requests must be on the same page */
+	int (*read_multi)(struct synaptics_rmi4_data *rmi4_data,
+		struct synaptics_rmi4_read_req *req, unsigned char count);
 	int (*write)(struct synaptics_rmi4_data *rmi4_data, unsigned short addr,
 		unsigned char *data, unsigned short length);
 };
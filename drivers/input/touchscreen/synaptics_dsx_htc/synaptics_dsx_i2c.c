@@ -22,6 +22,7 @@
 #include <linux/i2c.h>
 #include <linux/delay.h>
 #include <linux/input.h>
+#include <linux/sched.h>
 #include <linux/types.h>
 #include <linux/of_gpio.h>
 #include <linux/platform_device.h>
@@ -363,6 +364,19 @@ static int parse_dt(struct device *dev, struct synaptics_dsx_board_data *bdata)
 	else
 		bdata->hall_block_touch_time = value;
 
+	retval = of_property_read_u32(np, "synaptics,irq-cpu-mask", &value);
+	if (retval < 0)
+		bdata->irq_cpu_mask = 0;
+	else
+		bdata->irq_cpu_mask = value;
+
+	retval = of_property_read_u32(np, "synaptics,irq-thread-prio",
+			&value);
+	if (retval < 0 || value >= MAX_USER_RT_PRIO)
+		bdata->irq_thread_prio = 0;
+	else
+		bdata->irq_thread_prio = value;
+
 	prop = of_find_property(np, "synaptics,display-coords", NULL);
 	if (prop) {
 		coords_size = prop->length / sizeof(u32);
@@ -585,9 +599,78 @@ exit:
 	return retval;
 }
 
+#if !GTP_SUPPORT_I2C_DMA
+/*
+ * Read several registers of one page in a single i2c_transfer(), so that
+ * the interrupt path pays for one bus transaction instead of one per
+ * register. Every request gets its own address/read message pair.
+ */
+static int synaptics_rmi4_i2c_read_multi(struct synaptics_rmi4_data *rmi4_data,
+		struct synaptics_rmi4_read_req *req, unsigned char count)
+{
+	int retval;
+	unsigned char ii;
+	unsigned char retry;
+	unsigned char buf[SYN_READ_MULTI_MAX];
+	struct i2c_msg msg[SYN_READ_MULTI_MAX * 2];
+	struct i2c_client *i2c = to_i2c_client(rmi4_data->pdev->dev.parent);
+
+	if (!count || count > SYN_READ_MULTI_MAX)
+		return -EINVAL;
+
+	for (ii = 0; ii < count; ii++) {
+		if ((req[ii].addr >> 8) != (req[0].addr >> 8))
+			return -EINVAL;
+
+		buf[ii] = req[ii].addr & MASK_8BIT;
+		msg[ii * 2].addr = i2c->addr;
+		msg[ii * 2].flags = 0;
+		msg[ii * 2].len = 1;
+		msg[ii * 2].buf = &buf[ii];
+		msg[ii * 2 + 1].addr = i2c->addr;
+		msg[ii * 2 + 1].flags = I2C_M_RD;
+		msg[ii * 2 + 1].len = req[ii].length;
+		msg[ii * 2 + 1].buf = req[ii].data;
+	}
+
+	mutex_lock(&rmi4_data->rmi4_io_ctrl_mutex);
+
+	retval = synaptics_rmi4_i2c_set_page(rmi4_data, req[0].addr);
+	if (retval != PAGE_SELECT_LEN) {
+		retval = -EIO;
+		goto exit;
+	}
+
+	for (retry = 0; retry < SYN_I2C_RETRY_TIMES; retry++) {
+		retval = i2c_transfer(i2c->adapter, msg, count * 2);
+		if (retval == count * 2) {
+			retval = 0;
+			break;
+		} else if (retval == I2C_ERROR_ARB_LOST ||
+				retval == I2C_ERROR_TIMEOUT ||
+				retry == SYN_I2C_RETRY_RESET_TIMES)
+			synaptics_rmi4_reset();
+		dev_dbg(rmi4_data->pdev->dev.parent,
+				"%s: I2C retry %d (%d)\n",
+				__func__, retry + 1, retval);
+	}
+
+	if (retval > 0)
+		retval = -EIO;
+
+exit:
+	mutex_unlock(&rmi4_data->rmi4_io_ctrl_mutex);
+
+	return retval;
+}
+#endif
+
 static struct synaptics_dsx_bus_access bus_access = {
 	.type = BUS_I2C,
 	.read = synaptics_rmi4_i2c_read,
+#if !GTP_SUPPORT_I2C_DMA
+	.read_multi = synaptics_rmi4_i2c_read_multi,
+#endif
 	.write = synaptics_rmi4_i2c_write,
 };
 
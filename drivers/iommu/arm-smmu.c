@@ -915,6 +915,19 @@ static void arm_smmu_tlb_sync(void *cookie)
 }
 
 /* Must be called with clocks/regulators enabled */
+/* Page table quirks requested through the domain attributes */
+static int arm_smmu_pgtbl_quirks(struct arm_smmu_domain *smmu_domain)
+{
+	int quirks = 0;
+
+	if (smmu_domain->attributes & (1 << DOMAIN_ATTR_USE_CONT_HINT))
+		quirks |= IO_PGTABLE_QUIRK_CONT_HINT;
+	if (smmu_domain->attributes & (1 << DOMAIN_ATTR_DEFER_TLB_FLUSH))
+		quirks |= IO_PGTABLE_QUIRK_DEFER_TLB_FLUSH;
+
+	return quirks;
+}
+
 static void arm_smmu_tlb_inv_context(void *cookie)
 {
 	struct arm_smmu_domain *smmu_domain = cookie;
@@ -1567,6 +1580,7 @@ static int arm_smmu_init_domain_context(struct iommu_domain *domain,
 	}
 
 	smmu_domain->pgtbl_cfg = (struct io_pgtable_cfg) {
+		.quirks		= arm_smmu_pgtbl_quirks(smmu_domain),
 		.pgsize_bitmap	= arm_smmu_ops.pgsize_bitmap,
 		.ias		= ias,
 		.oas		= oas,
@@ -1880,6 +1894,7 @@ static int arm_smmu_attach_dynamic(struct iommu_domain *domain,
 	}
 
 	smmu_domain->pgtbl_cfg = (struct io_pgtable_cfg) {
+		.quirks		= arm_smmu_pgtbl_quirks(smmu_domain),
 		.pgsize_bitmap	= arm_smmu_ops.pgsize_bitmap,
 		.ias		= smmu->va_size,
 		.oas		= smmu->ipa_size,
@@ -2689,6 +2704,16 @@ static int arm_smmu_domain_get_attr(struct iommu_domain *domain,
 				    & (1 << DOMAIN_ATTR_NON_FATAL_FAULTS));
 		ret = 0;
 		break;
+	case DOMAIN_ATTR_USE_CONT_HINT:
+		*((int *)data) = !!(smmu_domain->attributes
+				    & (1 << DOMAIN_ATTR_USE_CONT_HINT));
+		ret = 0;
+		break;
+	case DOMAIN_ATTR_DEFER_TLB_FLUSH:
+		*((int *)data) = !!(smmu_domain->attributes
+				    & (1 << DOMAIN_ATTR_DEFER_TLB_FLUSH));
+		ret = 0;
+		break;
 	default:
 		ret = -ENODEV;
 		break;
@@ -2800,6 +2825,42 @@ static int arm_smmu_domain_set_attr(struct iommu_domain *domain,
 		smmu_domain->non_fatal_faults = *((int *)data);
 		ret = 0;
 		break;
+	case DOMAIN_ATTR_USE_CONT_HINT: {
+		int use_cont = *((int *)data);
+
+		/* the page table quirks are fixed once we are attached */
+		if (smmu_domain->smmu != NULL) {
+			ret = -EBUSY;
+			break;
+		}
+
+		if (use_cont)
+			smmu_domain->attributes |=
+				1 << DOMAIN_ATTR_USE_CONT_HINT;
+		else
+			smmu_domain->attributes &=
+				~(1 << DOMAIN_ATTR_USE_CONT_HINT);
+		ret = 0;
+		break;
+	}
+	case DOMAIN_ATTR_DEFER_TLB_FLUSH: {
+		int defer = *((int *)data);
+
+		/* the page table quirks are fixed once we are attached */
+		if (smmu_domain->smmu != NULL) {
+			ret = -EBUSY;
+			break;
+		}
+
+		if (defer)
+			smmu_domain->attributes |=
+				1 << DOMAIN_ATTR_DEFER_TLB_FLUSH;
+		else
+			smmu_domain->attributes &=
+				~(1 << DOMAIN_ATTR_DEFER_TLB_FLUSH);
+		ret = 0;
+		break;
+	}
 	default:
 		ret = -ENODEV;
 		break;
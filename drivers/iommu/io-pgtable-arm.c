@@ -85,6 +85,7 @@
 
 #define ARM_LPAE_PTE_NSTABLE		(((arm_lpae_iopte)1) << 63)
 #define ARM_LPAE_PTE_XN			(((arm_lpae_iopte)3) << 53)
+#define ARM_LPAE_PTE_CONT		(((arm_lpae_iopte)1) << 52)
 #define ARM_LPAE_PTE_AF			(((arm_lpae_iopte)1) << 10)
 #define ARM_LPAE_PTE_SH_NS		(((arm_lpae_iopte)0) << 8)
 #define ARM_LPAE_PTE_SH_OS		(((arm_lpae_iopte)2) << 8)
@@ -197,6 +198,8 @@ struct arm_lpae_io_pgtable {
 	unsigned long		bits_per_level;
 
 	void			*pgd;
+	/* set when an unmap frees a table, which can't wait for the flush */
+	bool			freed_table;
 };
 
 typedef u64 arm_lpae_iopte;
@@ -322,6 +325,9 @@ struct map_state {
 /* map state optimization works at level 3 (the 2nd-to-last level) */
 #define MAP_STATE_LVL 3
 
+/* Number of 4K page entries covered by a single contiguous hint */
+#define ARM_LPAE_CONT_PTES 16
+
 static int __arm_lpae_map(struct arm_lpae_io_pgtable *data, unsigned long iova,
 			  phys_addr_t paddr, size_t size, arm_lpae_iopte prot,
 			  int lvl, arm_lpae_iopte *ptep,
@@ -476,6 +482,9 @@ static int arm_lpae_map_sg(struct io_pgtable_ops *ops, unsigned long iova,
 	int i, ret;
 	unsigned int min_pagesz;
 	struct map_state ms;
+	unsigned int cont_ptes = 0;
+	bool use_cont = (data->iop.cfg.quirks & IO_PGTABLE_QUIRK_CONT_HINT) &&
+			data->pg_shift == 12;
 
 	/* If no access, then nothing to do */
 	if (!(iommu_prot & (IOMMU_READ | IOMMU_WRITE)))
@@ -503,18 +512,36 @@ static int arm_lpae_map_sg(struct io_pgtable_ops *ops, unsigned long iova,
 		while (size) {
 			size_t pgsize = iommu_pgsize(
 				data->iop.cfg.pgsize_bitmap, iova | phys, size);
+			arm_lpae_iopte pte_prot = prot;
+
+			/*
+			 * Mark each run of 16 pages that is 64K aligned in
+			 * both iova and phys so that the TLB can hold it in
+			 * a single entry.
+			 */
+			if (use_cont && pgsize == SZ_4K) {
+				if (!cont_ptes && size >= SZ_64K &&
+				    IS_ALIGNED(iova | phys, SZ_64K))
+					cont_ptes = ARM_LPAE_CONT_PTES;
+
+				if (cont_ptes) {
+					pte_prot |= ARM_LPAE_PTE_CONT;
+					cont_ptes--;
+				}
+			}
 
 			if (ms.pgtable && (iova < ms.iova_end)) {
 				arm_lpae_iopte *ptep = ms.pgtable +
 					ARM_LPAE_LVL_IDX(iova, MAP_STATE_LVL,
 							 data);
 				arm_lpae_init_pte(
-					data, iova, phys, prot, MAP_STATE_LVL,
-					ptep, ms.prev_pgtable, false);
+					data, iova, phys, pte_prot,
+					MAP_STATE_LVL, ptep, ms.prev_pgtable,
+					false);
 				ms.num_pte++;
 			} else {
 				ret = __arm_lpae_map(data, iova, phys, pgsize,
-						prot, lvl, ptep, NULL, &ms);
+						pte_prot, lvl, ptep, NULL, &ms);
 				if (ret)
 					goto out_err;
 			}
@@ -579,6 +606,24 @@ static void arm_lpae_free_pgtable(struct io_pgtable *iop)
 	kfree(data);
 }
 
+/*
+ * Drop the contiguous hint from the entries [start, end) of a last level
+ * table. This is needed when only part of a contiguous run is unmapped,
+ * since the hint must never cover an invalid or unrelated entry.
+ */
+static void arm_lpae_clear_cont(struct arm_lpae_io_pgtable *data,
+				arm_lpae_iopte *table, int start, int end)
+{
+	int i;
+
+	for (i = start; i < end; i++)
+		table[i] &= ~ARM_LPAE_PTE_CONT;
+
+	data->iop.cfg.tlb->flush_pgtable(&table[start],
+					 (end - start) * sizeof(*table),
+					 data->iop.cookie);
+}
+
 static int arm_lpae_split_blk_unmap(struct arm_lpae_io_pgtable *data,
 				    unsigned long iova, size_t size,
 				    arm_lpae_iopte prot, int lvl,
@@ -646,6 +691,7 @@ static int __arm_lpae_unmap(struct arm_lpae_io_pgtable *data,
 			/* Also flush any partial walks */
 			ptep = iopte_deref(pte, data);
 			__arm_lpae_free_pgtable(data, lvl + 1, ptep);
+			data->freed_table = true;
 		}
 
 		return size;
@@ -666,6 +712,19 @@ static int __arm_lpae_unmap(struct arm_lpae_io_pgtable *data,
 		 * swoop.
 		 */
 
+		if ((tl_offset % ARM_LPAE_CONT_PTES) &&
+		    (table_base[tl_offset] & ARM_LPAE_PTE_CONT))
+			arm_lpae_clear_cont(data, table_base,
+				round_down(tl_offset, ARM_LPAE_CONT_PTES),
+				tl_offset);
+
+		if (((tl_offset + entries) % ARM_LPAE_CONT_PTES) &&
+		    (table_base[tl_offset + entries - 1] & ARM_LPAE_PTE_CONT))
+			arm_lpae_clear_cont(data, table_base,
+				tl_offset + entries,
+				round_up(tl_offset + entries,
+					 ARM_LPAE_CONT_PTES));
+
 		table += tl_offset;
 
 		memset(table, 0, table_len);
@@ -679,6 +738,7 @@ static int __arm_lpae_unmap(struct arm_lpae_io_pgtable *data,
 			io_pgtable_free_pages_exact(
 				&data->iop.cfg, cookie, table_base,
 				max_entries * sizeof(*table_base));
+			data->freed_table = true;
 		}
 
 		return entries * entry_size;
@@ -723,8 +783,15 @@ static size_t arm_lpae_unmap(struct io_pgtable_ops *ops, unsigned long iova,
 		unmapped += ret;
 		iova += ret;
 	}
-	if (unmapped)
+	/*
+	 * The owner of the domain may batch up the TLB invalidation for
+	 * several unmaps, but only as long as no table memory was given
+	 * back, since the walk caches could still point at it.
+	 */
+	if (unmapped && (!(iop->cfg.quirks & IO_PGTABLE_QUIRK_DEFER_TLB_FLUSH)
+			 || data->freed_table))
 		iop->cfg.tlb->tlb_flush_all(iop->cookie);
+	data->freed_table = false;
 
 	return unmapped;
 }
@@ -52,6 +52,8 @@ struct iommu_gather_ops {
  */
 struct io_pgtable_cfg {
 	#define IO_PGTABLE_QUIRK_ARM_NS	(1 << 0)	/* Set NS bit in PTEs */
+	#define IO_PGTABLE_QUIRK_CONT_HINT	(1 << 1) /* Use contiguous hint */
+	#define IO_PGTABLE_QUIRK_DEFER_TLB_FLUSH (1 << 2) /* Caller flushes */
 	int				quirks;
 	unsigned long			pgsize_bitmap;
 	unsigned int			ias;
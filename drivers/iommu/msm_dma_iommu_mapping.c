@@ -17,32 +17,42 @@
 #include <linux/rbtree.h>
 #include <linux/mutex.h>
 #include <linux/err.h>
+#include <linux/jiffies.h>
+#include <linux/module.h>
+#include <linux/workqueue.h>
 
 #include <linux/msm_dma_iommu_mapping.h>
 
 /**
  * struct msm_iommu_map - represents a mapping of an ion buffer to an iommu
  * @lnode - list node to exist in the buffer's list of iommu mappings
- * @dev - Device this is mapped to. Used as key
+ * @dev - Device this was first mapped for. Used for the unmap
+ * @domain - IOVA space of @dev, or @dev itself if it has none. Used as key
  * @sgl - The scatterlist for this mapping
  * @nents - Number of entries in sgl
  * @dir - The direction for the unmap.
  * @meta - Backpointer to the meta this guy belongs to.
  * @ref - for reference counting this mapping
+ * @late_unmap - an extra reference is held until the buffer is freed
+ * @last_used - jiffies of the last client unmap, for the idle reaper
  *
- * Represents a mapping of one dma_buf buffer to a particular device
- * and address range. There may exist other mappings of this buffer in
- * different devices. All mappings will have the same cacheability and security.
+ * Represents a mapping of one dma_buf buffer to a particular IOVA space
+ * and address range. Devices which share an IOVA space share the mapping.
+ * There may exist other mappings of this buffer in different IOVA spaces.
+ * All mappings will have the same cacheability and security.
  */
 struct msm_iommu_map {
 	struct list_head lnode;
 	struct rb_node node;
 	struct device *dev;
+	void *domain;
 	struct scatterlist sgl;
 	unsigned int nents;
 	enum dma_data_direction dir;
 	struct msm_iommu_meta *meta;
 	struct kref ref;
+	bool late_unmap;
+	unsigned long last_used;
 };
 
 struct msm_iommu_meta {
@@ -56,6 +66,24 @@ struct msm_iommu_meta {
 static struct rb_root iommu_root;
 static DEFINE_MUTEX(msm_iommu_map_mutex);
 
+/*
+ * Lazily unmapped mappings which no client has used for idle_reap_ms are
+ * torn down by a background reaper rather than lingering until the
+ * buffer is freed.  0 disables the reaper.
+ */
+static unsigned int idle_reap_ms = 5000;
+module_param(idle_reap_ms, uint, S_IRUGO | S_IWUSR);
+
+static void msm_iommu_reap_idle(struct work_struct *work);
+static DECLARE_DELAYED_WORK(msm_iommu_reap_work, msm_iommu_reap_idle);
+
+static void *msm_iommu_domain_key(struct device *dev)
+{
+	void *mapping = to_dma_iommu_mapping(dev);
+
+	return mapping ? mapping : dev;
+}
+
 static void msm_iommu_meta_add(struct msm_iommu_meta *meta)
 {
 	struct rb_root *root = &iommu_root;
@@ -110,7 +138,7 @@ static void msm_iommu_add(struct msm_iommu_meta *meta,
 	struct msm_iommu_map *entry;
 
 	list_for_each_entry(entry, &meta->iommu_maps, lnode) {
-		if (entry->dev == iommu->dev) {
+		if (entry->domain == iommu->domain) {
 			pr_err("%s: dma_buf %p already has mapping to device %p\n",
 				__func__, meta->buffer, iommu->dev);
 			BUG();
@@ -125,9 +153,10 @@ static struct msm_iommu_map *msm_iommu_lookup(struct msm_iommu_meta *meta,
 					      struct device *dev)
 {
 	struct msm_iommu_map *entry;
+	void *domain = msm_iommu_domain_key(dev);
 
 	list_for_each_entry(entry, &meta->iommu_maps, lnode) {
-		if (entry->dev == dev)
+		if (entry->domain == domain)
 			return entry;
 	}
 
@@ -205,10 +234,14 @@ static inline int __msm_dma_map_sg(struct device *dev, struct scatterlist *sg,
 		kref_init(&iommu_map->ref);
 		if (late_unmap)
 			kref_get(&iommu_map->ref);
+		iommu_map->late_unmap = late_unmap;
 		iommu_map->meta = iommu_meta;
 		iommu_map->sgl.dma_address = sg->dma_address;
 		iommu_map->sgl.dma_length = sg->dma_length;
+		iommu_map->nents = nents;
+		iommu_map->dir = dir;
 		iommu_map->dev = dev;
+		iommu_map->domain = msm_iommu_domain_key(dev);
 		msm_iommu_add(iommu_meta, iommu_map);
 
 	} else {
@@ -334,8 +367,13 @@ void msm_dma_unmap_sg(struct device *dev, struct scatterlist *sgl, int nents,
 	 * to unmap
 	 */
 	iommu_map->dir = dir;
+	iommu_map->last_used = jiffies;
 
-	kref_put(&iommu_map->ref, msm_iommu_map_release);
+	if (!kref_put(&iommu_map->ref, msm_iommu_map_release) &&
+	    iommu_map->late_unmap && idle_reap_ms &&
+	    atomic_read(&iommu_map->ref.refcount) == 1)
+		schedule_delayed_work(&msm_iommu_reap_work,
+				      msecs_to_jiffies(idle_reap_ms));
 	mutex_unlock(&meta->lock);
 
 	msm_iommu_meta_put(meta);
@@ -344,6 +382,47 @@ out:
 	return;
 }
 
+/*
+ * Drops the late-unmap reference of mappings whose clients have all
+ * unmapped and which have been idle for idle_reap_ms.  A later map of
+ * the buffer simply creates a fresh mapping.
+ */
+static void msm_iommu_reap_idle(struct work_struct *work)
+{
+	struct msm_iommu_meta *meta;
+	struct msm_iommu_map *map, *map_next;
+	unsigned long timeout = msecs_to_jiffies(idle_reap_ms);
+	bool pending = false;
+	struct rb_node *n;
+
+	if (!idle_reap_ms)
+		return;
+
+	mutex_lock(&msm_iommu_map_mutex);
+	for (n = rb_first(&iommu_root); n; n = rb_next(n)) {
+		meta = rb_entry(n, struct msm_iommu_meta, node);
+
+		mutex_lock(&meta->lock);
+		list_for_each_entry_safe(map, map_next, &meta->iommu_maps,
+					 lnode) {
+			if (!map->late_unmap ||
+			    atomic_read(&map->ref.refcount) != 1)
+				continue;
+			if (time_before(jiffies, map->last_used + timeout)) {
+				pending = true;
+				continue;
+			}
+			map->late_unmap = false;
+			kref_put(&map->ref, msm_iommu_map_release);
+		}
+		mutex_unlock(&meta->lock);
+	}
+	mutex_unlock(&msm_iommu_map_mutex);
+
+	if (pending)
+		schedule_delayed_work(&msm_iommu_reap_work, timeout);
+}
+
 /*
  * Only to be called by ION code when a buffer is freed
  */
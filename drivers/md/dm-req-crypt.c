@@ -71,6 +71,12 @@ struct req_crypt_result {
 	int err;
 };
 
+/* Per engine throughput, reported through the target status */
+struct req_crypt_engine_stats {
+	atomic_t reqs;
+	atomic64_t bytes;
+};
+
 #define FDE_KEY_ID	0
 #define PFE_KEY_ID	1
 
@@ -92,6 +98,7 @@ unsigned int num_engines;
 unsigned int num_engines_fde, fde_cursor;
 unsigned int num_engines_pfe, pfe_cursor;
 struct crypto_engine_entry *fde_eng, *pfe_eng;
+static struct req_crypt_engine_stats *fde_eng_stats, *pfe_eng_stats;
 DEFINE_MUTEX(engine_list_mutex);
 
 struct req_dm_crypt_io {
@@ -104,15 +111,19 @@ struct req_dm_crypt_io {
 	bool should_encrypt;
 	bool should_decrypt;
 	u32 key_id;
+	int cpu;
 };
 
 struct req_dm_split_req_io {
 	struct work_struct work;
 	struct scatterlist *req_split_sg_read;
+	struct scatterlist *req_split_sg_write;
 	struct req_crypt_result result;
 	struct crypto_engine_entry *engine;
+	struct req_crypt_engine_stats *stats;
 	u8 IV[AES_XTS_IV_LEN];
 	int size;
+	bool encrypt;
 	struct request *clone;
 };
 
@@ -132,6 +143,11 @@ static void req_cryptd_split_req_queue_cb
 		(struct work_struct *work);
 static void req_cryptd_split_req_queue
 		(struct req_dm_split_req_io *io);
+static int req_cryptd_split_req(struct request *clone,
+		struct scatterlist *sg_in, struct scatterlist *sg_out,
+		int total_bytes, struct crypto_engine_entry *engines,
+		struct req_crypt_engine_stats *stats,
+		unsigned int nr_engines, bool encrypt);
 static void req_crypt_split_io_complete
 		(struct req_crypt_result *res, int err);
 
@@ -272,15 +288,13 @@ static void req_cryptd_crypt_read_convert(struct req_dm_crypt_io *io)
 {
 	struct request *clone = NULL;
 	int error = DM_REQ_CRYPT_ERROR;
-	int total_sg_len = 0, total_bytes_in_req = 0, temp_size = 0, i = 0;
-	struct scatterlist *sg = NULL;
+	int total_sg_len = 0, total_bytes_in_req = 0;
 	struct scatterlist *req_sg_read = NULL;
 
 	unsigned int engine_list_total = 0;
 	struct crypto_engine_entry *curr_engine_list = NULL;
+	struct req_crypt_engine_stats *curr_eng_stats = NULL;
 	bool split_transfers = 0;
-	sector_t tempiv;
-	struct req_dm_split_req_io *split_io = NULL;
 
 	if (io) {
 		error = io->error;
@@ -311,8 +325,18 @@ static void req_cryptd_crypt_read_convert(struct req_dm_crypt_io *io)
 						   (io->key_id == PFE_KEY_ID ?
 							pfe_eng : NULL));
 
+	curr_eng_stats = (io->key_id == FDE_KEY_ID ? fde_eng_stats :
+						 (io->key_id == PFE_KEY_ID ?
+						  pfe_eng_stats : NULL));
+
 	mutex_unlock(&engine_list_mutex);
 
+	if ((engine_list_total < 1) || (NULL == curr_engine_list)) {
+		DMERR("%s Unknown Key ID!\n", __func__);
+		error = DM_REQ_CRYPT_ERROR;
+		goto submit_request;
+	}
+
 	req_sg_read = (struct scatterlist *)mempool_alloc(req_scatterlist_pool,
 								GFP_KERNEL);
 	if (!req_sg_read) {
@@ -344,83 +368,12 @@ static void req_cryptd_crypt_read_convert(struct req_dm_crypt_io *io)
 		&& (engine_list_total > 1))
 		split_transfers = 1;
 
-	if (split_transfers) {
-		split_io = kzalloc(sizeof(struct req_dm_split_req_io)
-				* engine_list_total, GFP_KERNEL);
-		if (!split_io) {
-			DMERR("%s split_io allocation failed\n", __func__);
-			error = DM_REQ_CRYPT_ERROR;
-			goto ablkcipher_req_alloc_failure;
-		}
-
-		split_io[0].req_split_sg_read = sg = req_sg_read;
-		split_io[engine_list_total - 1].size = total_bytes_in_req;
-		for (i = 0; i < (engine_list_total); i++) {
-			while ((sg) && i < (engine_list_total - 1)) {
-				split_io[i].size += sg->length;
-				split_io[engine_list_total - 1].size -=
-						sg->length;
-				if (split_io[i].size >=
-						(total_bytes_in_req /
-							engine_list_total)) {
-					split_io[i + 1].req_split_sg_read =
-							sg_next(sg);
-					sg_mark_end(sg);
-					break;
-				}
-				sg = sg_next(sg);
-			}
-			split_io[i].engine = &curr_engine_list[i];
-			init_completion(&split_io[i].result.completion);
-			memset(&split_io[i].IV, 0, AES_XTS_IV_LEN);
-			tempiv = clone->__sector + (temp_size / SECTOR_SIZE);
-			memcpy(&split_io[i].IV, &tempiv, sizeof(sector_t));
-			temp_size +=  split_io[i].size;
-			split_io[i].clone = clone;
-			req_cryptd_split_req_queue(&split_io[i]);
-		}
-	} else {
-		split_io = kzalloc(sizeof(struct req_dm_split_req_io),
-				GFP_KERNEL);
-		if (!split_io) {
-			DMERR("%s split_io allocation failed\n", __func__);
-			error = DM_REQ_CRYPT_ERROR;
-			goto ablkcipher_req_alloc_failure;
-		}
-		split_io->engine = &curr_engine_list[0];
-		init_completion(&split_io->result.completion);
-		memcpy(split_io->IV, &clone->__sector, sizeof(sector_t));
-		split_io->req_split_sg_read = req_sg_read;
-		split_io->size = total_bytes_in_req;
-		split_io->clone = clone;
-		req_cryptd_split_req_queue(split_io);
-	}
-
-	if (!split_transfers) {
-		wait_for_completion_interruptible(&split_io->result.completion);
-		if (split_io->result.err) {
-			DMERR("%s error = %d for request\n",
-				 __func__, split_io->result.err);
-			error = DM_REQ_CRYPT_ERROR;
-			goto ablkcipher_req_alloc_failure;
-		}
-	} else {
-		for (i = 0; i < (engine_list_total); i++) {
-			wait_for_completion_interruptible(
-					&split_io[i].result.completion);
-			if (split_io[i].result.err) {
-				DMERR("%s error = %d for %dst request\n",
-					 __func__, split_io[i].result.err, i);
-				error = DM_REQ_CRYPT_ERROR;
-				goto ablkcipher_req_alloc_failure;
-			}
-		}
-	}
-	error = 0;
+	error = req_cryptd_split_req(clone, req_sg_read, NULL,
+			total_bytes_in_req, curr_engine_list, curr_eng_stats,
+			split_transfers ? engine_list_total : 1, false);
 ablkcipher_req_alloc_failure:
 
 	mempool_free(req_sg_read, req_scatterlist_pool);
-	kfree(split_io);
 submit_request:
 	if (io)
 		io->error = error;
@@ -447,6 +400,23 @@ static void req_cryptd_crypt_read_plain(struct req_dm_crypt_io *io)
 	mempool_free(io, req_io_pool);
 }
 
+/*
+ * Returns true if both scatterlists have the same number of entries with
+ * the same lengths, so they can be split at the same points.
+ */
+static bool req_crypt_sg_match(struct scatterlist *sg_a,
+		struct scatterlist *sg_b)
+{
+	while (sg_a && sg_b) {
+		if (sg_a->length != sg_b->length)
+			return false;
+		sg_a = sg_next(sg_a);
+		sg_b = sg_next(sg_b);
+	}
+
+	return !sg_a && !sg_b;
+}
+
 /*
  * The callback that will be called by the worker queue to perform Encryption
  * for writes and submit the request using the elevelator.
@@ -472,6 +442,8 @@ static void req_cryptd_crypt_write_convert(struct req_dm_crypt_io *io)
 	struct crypto_engine_entry engine;
 	unsigned int engine_list_total = 0;
 	struct crypto_engine_entry *curr_engine_list = NULL;
+	struct req_crypt_engine_stats *curr_eng_stats = NULL;
+	struct req_crypt_engine_stats *eng_stats = NULL;
 	unsigned int *engine_cursor = NULL;
 
 
@@ -513,6 +485,10 @@ static void req_cryptd_crypt_write_convert(struct req_dm_crypt_io *io)
 						(io->key_id == PFE_KEY_ID ?
 						pfe_eng : NULL));
 
+	curr_eng_stats = (io->key_id == FDE_KEY_ID ? fde_eng_stats :
+						(io->key_id == PFE_KEY_ID ?
+						pfe_eng_stats : NULL));
+
 	engine_cursor = (io->key_id == FDE_KEY_ID ? &fde_cursor :
 					(io->key_id == PFE_KEY_ID ? &pfe_cursor
 					: NULL));
@@ -526,6 +502,7 @@ static void req_cryptd_crypt_write_convert(struct req_dm_crypt_io *io)
 	}
 
 	engine = curr_engine_list[*engine_cursor];
+	eng_stats = &curr_eng_stats[*engine_cursor];
 	(*engine_cursor)++;
 	(*engine_cursor) %= engine_list_total;
 
@@ -614,36 +591,56 @@ static void req_cryptd_crypt_write_convert(struct req_dm_crypt_io *io)
 		goto ablkcipher_req_alloc_failure;
 	}
 
-	memset(IV, 0, AES_XTS_IV_LEN);
-	memcpy(IV, &clone->__sector, sizeof(sector_t));
+	/*
+	 * Large writes are spread over all the engines of the key the same
+	 * way reads are, as long as the bounce pages line up with the source
+	 * segments so both lists can be cut at the same entry.
+	 */
+	if ((total_bytes_in_req >= (MIN_CRYPTO_TRANSFER_SIZE *
+		engine_list_total)) && (engine_list_total > 1) &&
+		req_crypt_sg_match(req_sg_in, req_sg_out)) {
+		err = req_cryptd_split_req(clone, req_sg_in, req_sg_out,
+				total_bytes_in_req, curr_engine_list,
+				curr_eng_stats, engine_list_total, true);
+		if (err) {
+			error = DM_REQ_CRYPT_ERROR_AFTER_PAGE_MALLOC;
+			goto ablkcipher_req_alloc_failure;
+		}
+	} else {
+		memset(IV, 0, AES_XTS_IV_LEN);
+		memcpy(IV, &clone->__sector, sizeof(sector_t));
 
-	ablkcipher_request_set_crypt(req, req_sg_in, req_sg_out,
-			total_bytes_in_req, (void *) IV);
+		ablkcipher_request_set_crypt(req, req_sg_in, req_sg_out,
+				total_bytes_in_req, (void *) IV);
 
-	rc = crypto_ablkcipher_encrypt(req);
+		rc = crypto_ablkcipher_encrypt(req);
 
-	switch (rc) {
-	case 0:
-		break;
+		switch (rc) {
+		case 0:
+			break;
 
-	case -EBUSY:
-		/*
-		 * Lets make this synchronous request by waiting on
-		 * in progress as well
-		 */
-	case -EINPROGRESS:
-		wait_for_completion_interruptible(&result.completion);
-		if (result.err) {
-			DMERR("%s error = %d encrypting the request\n",
-				 __func__, result.err);
+		case -EBUSY:
+			/*
+			 * Lets make this synchronous request by waiting on
+			 * in progress as well
+			 */
+		case -EINPROGRESS:
+			wait_for_completion_interruptible(&result.completion);
+			if (result.err) {
+				DMERR("%s error = %d encrypting the request\n",
+					 __func__, result.err);
+				error = DM_REQ_CRYPT_ERROR_AFTER_PAGE_MALLOC;
+				goto ablkcipher_req_alloc_failure;
+			}
+			break;
+
+		default:
 			error = DM_REQ_CRYPT_ERROR_AFTER_PAGE_MALLOC;
 			goto ablkcipher_req_alloc_failure;
 		}
-		break;
 
-	default:
-		error = DM_REQ_CRYPT_ERROR_AFTER_PAGE_MALLOC;
-		goto ablkcipher_req_alloc_failure;
+		atomic_inc(&eng_stats->reqs);
+		atomic64_add(total_bytes_in_req, &eng_stats->bytes);
 	}
 
 	__rq_for_each_bio(bio_src, clone) {
@@ -764,9 +761,13 @@ static void req_cryptd_split_req_queue_cb(struct work_struct *work)
 	crypto_ablkcipher_setkey(tfm, NULL, KEY_SIZE_XTS);
 
 	ablkcipher_request_set_crypt(req, io->req_split_sg_read,
+			io->req_split_sg_write ? io->req_split_sg_write :
 			io->req_split_sg_read, io->size, (void *) io->IV);
 
-	err = crypto_ablkcipher_decrypt(req);
+	if (io->encrypt)
+		err = crypto_ablkcipher_encrypt(req);
+	else
+		err = crypto_ablkcipher_decrypt(req);
 	switch (err) {
 	case 0:
 		break;
@@ -791,6 +792,10 @@ static void req_cryptd_split_req_queue_cb(struct work_struct *work)
 		goto ablkcipher_req_alloc_failure;
 	}
 	err = 0;
+	if (io->stats) {
+		atomic_inc(&io->stats->reqs);
+		atomic64_add(io->size, &io->stats->bytes);
+	}
 ablkcipher_req_alloc_failure:
 	if (req)
 		ablkcipher_request_free(req);
@@ -804,10 +809,91 @@ static void req_cryptd_split_req_queue(struct req_dm_split_req_io *io)
 	queue_work(req_crypt_split_io_queue, &io->work);
 }
 
+/*
+ * Split the transfer of @clone over up to @nr_engines engines. @sg_in is cut
+ * into contiguous runs of roughly equal size, and @sg_out, when it is not
+ * NULL, is cut at the same entries. The pieces are waited for in order, and
+ * all of them are waited for even after an error since they share the
+ * scatterlists.
+ */
+static int req_cryptd_split_req(struct request *clone,
+		struct scatterlist *sg_in, struct scatterlist *sg_out,
+		int total_bytes, struct crypto_engine_entry *engines,
+		struct req_crypt_engine_stats *stats,
+		unsigned int nr_engines, bool encrypt)
+{
+	struct req_dm_split_req_io *split_io = NULL;
+	struct scatterlist *sg = sg_in, *sg_o = sg_out;
+	struct scatterlist *next = NULL, *next_o = NULL;
+	int chunk = total_bytes / nr_engines, offset = 0, err = 0;
+	unsigned int i, nr_split = 0;
+	sector_t tempiv;
+
+	split_io = kzalloc(sizeof(struct req_dm_split_req_io) * nr_engines,
+			GFP_KERNEL);
+	if (!split_io) {
+		DMERR("%s split_io allocation failed\n", __func__);
+		return DM_REQ_CRYPT_ERROR;
+	}
+
+	while (sg && nr_split < nr_engines) {
+		struct req_dm_split_req_io *piece = &split_io[nr_split++];
+
+		piece->req_split_sg_read = sg;
+		piece->req_split_sg_write = sg_o;
+		/* The last piece takes whatever is left */
+		while (sg) {
+			next = sg_next(sg);
+			next_o = sg_o ? sg_next(sg_o) : NULL;
+			piece->size += sg->length;
+			if (nr_split < nr_engines && piece->size >= chunk) {
+				sg_mark_end(sg);
+				if (sg_o)
+					sg_mark_end(sg_o);
+				sg = next;
+				sg_o = next_o;
+				break;
+			}
+			sg = next;
+			sg_o = next_o;
+		}
+
+		piece->engine = &engines[nr_split - 1];
+		piece->stats = stats ? &stats[nr_split - 1] : NULL;
+		init_completion(&piece->result.completion);
+		tempiv = clone->__sector + (offset / SECTOR_SIZE);
+		memcpy(piece->IV, &tempiv, sizeof(sector_t));
+		offset += piece->size;
+		piece->encrypt = encrypt;
+		piece->clone = clone;
+		req_cryptd_split_req_queue(piece);
+	}
+
+	for (i = 0; i < nr_split; i++) {
+		wait_for_completion_io(&split_io[i].result.completion);
+		if (split_io[i].result.err && !err) {
+			DMERR("%s error = %d for %dst request\n",
+				 __func__, split_io[i].result.err, i);
+			err = DM_REQ_CRYPT_ERROR;
+		}
+	}
+
+	kfree(split_io);
+	return err;
+}
+
+/*
+ * The work is kept on the CPU that mapped the request, so the crypto
+ * setup runs next to the submitter and the load follows the CPUs issuing
+ * I/O instead of piling up on whichever CPU takes the completion irq.
+ */
 static void req_cryptd_queue_crypt(struct req_dm_crypt_io *io)
 {
 	INIT_WORK(&io->work, req_cryptd_crypt);
-	queue_work(req_crypt_queue, &io->work);
+	if (cpu_online(io->cpu))
+		queue_work_on(io->cpu, req_crypt_queue, &io->work);
+	else
+		queue_work(req_crypt_queue, &io->work);
 }
 
 /*
@@ -929,6 +1015,7 @@ static int req_crypt_map(struct dm_target *ti, struct request *clone,
 	 * queue will get the req_io
 	 */
 	req_io->cloned_request = clone;
+	req_io->cpu = raw_smp_processor_id();
 	map_context->ptr = req_io;
 	atomic_set(&req_io->pending, 0);
 
@@ -1029,6 +1116,10 @@ static void deconfigure_qcrypto(void)
 	pfe_eng = NULL;
 	kfree(fde_eng);
 	fde_eng = NULL;
+	kfree(pfe_eng_stats);
+	pfe_eng_stats = NULL;
+	kfree(fde_eng_stats);
+	fde_eng_stats = NULL;
 	mutex_unlock(&engine_list_mutex);
 
 	if (tfm) {
@@ -1125,6 +1216,17 @@ static int configure_qcrypto(void)
 		goto exit_err;
 	}
 
+	fde_eng_stats = kcalloc(num_engines_fde, sizeof(*fde_eng_stats),
+				GFP_KERNEL);
+	pfe_eng_stats = kcalloc(num_engines_pfe, sizeof(*pfe_eng_stats),
+				GFP_KERNEL);
+	if ((num_engines_fde && !fde_eng_stats) ||
+	    (num_engines_pfe && !pfe_eng_stats)) {
+		DMERR("%s engine stats allocation failed\n", __func__);
+		mutex_unlock(&engine_list_mutex);
+		goto exit_err;
+	}
+
 	fde_cursor = 0;
 	pfe_cursor = 0;
 
@@ -1145,8 +1247,8 @@ static int configure_qcrypto(void)
 	if (!_req_dm_scatterlist_pool)
 		goto exit_err;
 
+	/* Bound, so that work queued on a CPU runs on that CPU */
 	req_crypt_queue = alloc_workqueue("req_cryptd",
-					WQ_UNBOUND |
 					WQ_CPU_INTENSIVE |
 					WQ_MEM_RECLAIM,
 					0);
@@ -1312,6 +1414,55 @@ ctr_exit:
 	return err;
 }
 
+static void req_crypt_engine_status(const char *name,
+		struct crypto_engine_entry *engines,
+		struct req_crypt_engine_stats *stats, unsigned int nr_engines,
+		char *result, unsigned int maxlen, unsigned int *size)
+{
+	unsigned int i, sz = *size;
+
+	if (!engines || !stats)
+		return;
+
+	for (i = 0; i < nr_engines; i++)
+		DMEMIT(" %s%u:%u %d %lld", name, i, engines[i].hw_instance,
+		       atomic_read(&stats[i].reqs),
+		       (long long)atomic64_read(&stats[i].bytes));
+
+	*size = sz;
+}
+
+/*
+ * The info status reports, for every engine, its key type and index, the
+ * hw instance it maps to, and the requests and bytes it has processed.
+ */
+static void req_crypt_status(struct dm_target *ti, status_type_t type,
+			     unsigned status_flags, char *result,
+			     unsigned maxlen)
+{
+	unsigned int sz = 0;
+
+	switch (type) {
+	case STATUSTYPE_INFO:
+		result[0] = '\0';
+		if (encryption_mode == DM_REQ_CRYPT_ENCRYPTION_MODE_TRANSPARENT)
+			break;
+
+		mutex_lock(&engine_list_mutex);
+		DMEMIT("%u", num_engines_fde + num_engines_pfe);
+		req_crypt_engine_status("fde", fde_eng, fde_eng_stats,
+				num_engines_fde, result, maxlen, &sz);
+		req_crypt_engine_status("pfe", pfe_eng, pfe_eng_stats,
+				num_engines_pfe, result, maxlen, &sz);
+		mutex_unlock(&engine_list_mutex);
+		break;
+
+	case STATUSTYPE_TABLE:
+		result[0] = '\0';
+		break;
+	}
+}
+
 static int req_crypt_iterate_devices(struct dm_target *ti,
 				 iterate_devices_callout_fn fn, void *data)
 {
@@ -1331,12 +1482,13 @@ EXPORT_SYMBOL(set_qcrypto_func_dm);
 
 static struct target_type req_crypt_target = {
 	.name   = "req-crypt",
-	.version = {1, 0, 0},
+	.version = {1, 1, 0},
 	.module = THIS_MODULE,
 	.ctr    = req_crypt_ctr,
 	.dtr    = req_crypt_dtr,
 	.map_rq = req_crypt_map,
 	.rq_end_io = req_crypt_endio,
+	.status = req_crypt_status,
 	.iterate_devices = req_crypt_iterate_devices,
 };
 
@@ -12,6 +12,11 @@
  * hash device. Setting this greatly improves performance when data and hash
  * are on the same disk on different partitions on devices with poor random
  * access behavior.
+ *
+ * The top levels of the hash tree, up to DM_VERITY_PIN_BLOCKS hash blocks,
+ * are read and held in memory when the table is loaded. Bios larger than
+ * DM_VERITY_SPLIT_BLOCKS data blocks are verified in parallel on several
+ * CPUs.
  */
 
 #include "dm-bufio.h"
@@ -33,6 +38,10 @@
 #define DM_VERITY_MAX_LEVELS		63
 #define DM_VERITY_MAX_CORRUPTED_ERRS	100
 
+#define DM_VERITY_PIN_BLOCKS		256
+#define DM_VERITY_SEQ_PREFETCH_BLOCKS	256
+#define DM_VERITY_SPLIT_BLOCKS		32
+
 static unsigned dm_verity_prefetch_cluster = DM_VERITY_DEFAULT_PREFETCH_SIZE;
 
 module_param_named(prefetch_cluster, dm_verity_prefetch_cluster, uint, S_IRUGO | S_IWUSR);
@@ -79,6 +88,15 @@ struct dm_verity {
 
 	
 	sector_t hash_level_block[DM_VERITY_MAX_LEVELS];
+
+	/* buffers of the levels from pin_level up, held until dtr */
+	struct dm_buffer **pinned;
+	unsigned n_pinned;
+	int pin_level;
+
+	/* sequential stream detection for hash prefetch */
+	sector_t seq_next_block;
+	sector_t prefetch_end;
 };
 
 struct dm_verity_io {
@@ -95,6 +113,11 @@ struct dm_verity_io {
 
 	struct work_struct work;
 
+	/* set in the pieces of a bio split across CPUs, see verity_split_io */
+	struct dm_verity_io *parent;
+	void *pieces;
+	atomic_t pending;
+	int error;
 };
 
 struct dm_verity_prefetch_work {
@@ -304,11 +327,18 @@ release_ret_r:
 	return r;
 }
 
+static struct bio *verity_io_bio(struct dm_verity_io *io)
+{
+	if (io->parent)
+		io = io->parent;
+
+	return dm_bio_from_per_bio_data(io, io->v->ti->per_bio_data_size);
+}
+
 static int verity_verify_io(struct dm_verity_io *io)
 {
 	struct dm_verity *v = io->v;
-	struct bio *bio = dm_bio_from_per_bio_data(io,
-						   v->ti->per_bio_data_size);
+	struct bio *bio = verity_io_bio(io);
 	unsigned b;
 	int i;
 
@@ -421,10 +451,84 @@ static void verity_finish_io(struct dm_verity_io *io, int error)
 	bio_endio_nodec(bio, error);
 }
 
+static void verity_piece_done(struct dm_verity_io *piece, int error)
+{
+	struct dm_verity_io *io = piece->parent;
+
+	if (error)
+		cmpxchg(&io->error, 0, error);
+
+	if (atomic_dec_and_test(&io->pending)) {
+		kfree(io->pieces);
+		verity_finish_io(io, io->error);
+	}
+}
+
+static void verity_work(struct work_struct *w);
+
+/*
+ * Split the verification of a large bio into pieces of consecutive blocks,
+ * each with its own hash descriptor, and run them on the unbound workqueue
+ * so that they are hashed on several CPUs at once. Returns false if the
+ * bio is verified inline instead.
+ */
+static bool verity_split_io(struct dm_verity_io *io)
+{
+	struct dm_verity *v = io->v;
+	struct bio *bio = verity_io_bio(io);
+	size_t size = v->ti->per_bio_data_size;
+	struct bvec_iter iter = io->iter;
+	unsigned nr, per_piece, i;
+
+	nr = min_t(unsigned, num_online_cpus(),
+		   io->n_blocks / DM_VERITY_SPLIT_BLOCKS);
+	if (nr < 2)
+		return false;
+
+	per_piece = DIV_ROUND_UP(io->n_blocks, nr);
+	nr = DIV_ROUND_UP(io->n_blocks, per_piece);
+
+	io->pieces = kmalloc(nr * size, GFP_NOIO | __GFP_NORETRY |
+			     __GFP_NOMEMALLOC | __GFP_NOWARN);
+	if (!io->pieces)
+		return false;
+
+	atomic_set(&io->pending, nr);
+	io->error = 0;
+
+	for (i = 0; i < nr; i++) {
+		struct dm_verity_io *piece = io->pieces + i * size;
+
+		piece->v = v;
+		piece->parent = io;
+		piece->block = io->block + i * per_piece;
+		piece->n_blocks = min(per_piece, io->n_blocks - i * per_piece);
+		piece->iter = iter;
+		bio_advance_iter(bio, &iter,
+				 piece->n_blocks << v->data_dev_block_bits);
+		INIT_WORK(&piece->work, verity_work);
+		if (i)
+			queue_work(v->verify_wq, &piece->work);
+	}
+
+	/* the first piece is verified right here */
+	verity_work(&((struct dm_verity_io *)io->pieces)->work);
+
+	return true;
+}
+
 static void verity_work(struct work_struct *w)
 {
 	struct dm_verity_io *io = container_of(w, struct dm_verity_io, work);
 
+	if (io->parent) {
+		verity_piece_done(io, verity_verify_io(io));
+		return;
+	}
+
+	if (verity_split_io(io))
+		return;
+
 	verity_finish_io(io, verity_verify_io(io));
 }
 
@@ -448,7 +552,8 @@ static void verity_prefetch_io(struct work_struct *work)
 	struct dm_verity *v = pw->v;
 	int i;
 
-	for (i = v->levels - 2; i >= 0; i--) {
+	/* pinned levels are in memory already */
+	for (i = min(v->levels - 2, v->pin_level - 1); i >= 0; i--) {
 		sector_t hash_block_start;
 		sector_t hash_block_end;
 		verity_hash_at_level(v, pw->block, i, &hash_block_start, NULL);
@@ -479,6 +584,25 @@ no_prefetch_cluster:
 static void verity_submit_prefetch(struct dm_verity *v, struct dm_verity_io *io)
 {
 	struct dm_verity_prefetch_work *pw;
+	sector_t n_blocks = io->n_blocks;
+
+	/*
+	 * For a sequential stream, prefetch the hash blocks of a window of
+	 * data ahead and skip the bios that fall inside a window already
+	 * prefetched.
+	 */
+	if (io->block == ACCESS_ONCE(v->seq_next_block)) {
+		v->seq_next_block = io->block + io->n_blocks;
+		if (io->block + io->n_blocks <= ACCESS_ONCE(v->prefetch_end))
+			return;
+
+		n_blocks = min_t(sector_t,
+				 n_blocks + DM_VERITY_SEQ_PREFETCH_BLOCKS,
+				 v->data_blocks - io->block);
+		v->prefetch_end = io->block + n_blocks;
+	} else {
+		v->seq_next_block = io->block + io->n_blocks;
+	}
 
 	pw = kmalloc(sizeof(struct dm_verity_prefetch_work),
 		GFP_NOIO | __GFP_NORETRY | __GFP_NOMEMALLOC | __GFP_NOWARN);
@@ -489,7 +613,7 @@ static void verity_submit_prefetch(struct dm_verity *v, struct dm_verity_io *io)
 	INIT_WORK(&pw->work, verity_prefetch_io);
 	pw->v = v;
 	pw->block = io->block;
-	pw->n_blocks = io->n_blocks;
+	pw->n_blocks = n_blocks;
 	queue_work(v->verify_wq, &pw->work);
 }
 
@@ -518,6 +642,7 @@ static int verity_map(struct dm_target *ti, struct bio *bio)
 
 	io = dm_per_bio_data(bio, ti->per_bio_data_size);
 	io->v = v;
+	io->parent = NULL;
 	io->orig_bi_end_io = bio->bi_end_io;
 	io->orig_bi_private = bio->bi_private;
 	io->block = bio->bi_iter.bi_sector >> (v->data_dev_block_bits - SECTOR_SHIFT);
@@ -628,6 +753,14 @@ static void verity_dtr(struct dm_target *ti)
 	if (v->vec_mempool)
 		mempool_destroy(v->vec_mempool);
 
+	if (v->pinned) {
+		unsigned i;
+
+		for (i = 0; i < v->n_pinned; i++)
+			dm_bufio_release(v->pinned[i]);
+		kfree(v->pinned);
+	}
+
 	if (v->bufio)
 		dm_bufio_client_destroy(v->bufio);
 
@@ -648,6 +781,53 @@ static void verity_dtr(struct dm_target *ti)
 	kfree(v);
 }
 
+/*
+ * Read the levels at the top of the hash tree, as many as fit in
+ * DM_VERITY_PIN_BLOCKS blocks, and keep their buffers held so that bufio
+ * never evicts them. The levels are laid out top down from hash_start.
+ */
+static void verity_pin_hash_levels(struct dm_verity *v)
+{
+	sector_t pin_end = v->hash_start;
+	int pin_level = v->levels;
+	unsigned n, i;
+	int level;
+
+	for (level = v->levels - 1; level >= 0; level--) {
+		sector_t end = level ? v->hash_level_block[level - 1] :
+				       v->hash_blocks;
+
+		if (end - v->hash_start > DM_VERITY_PIN_BLOCKS)
+			break;
+		pin_level = level;
+		pin_end = end;
+	}
+
+	n = pin_end - v->hash_start;
+	if (!n)
+		return;
+
+	v->pinned = kcalloc(n, sizeof(struct dm_buffer *), GFP_KERNEL);
+	if (!v->pinned)
+		return;
+
+	dm_bufio_prefetch(v->bufio, v->hash_start, n);
+	for (i = 0; i < n; i++) {
+		u8 *data = dm_bufio_read(v->bufio, v->hash_start + i,
+					 &v->pinned[i]);
+
+		if (unlikely(IS_ERR(data))) {
+			DMWARN("cannot pin hash block %llu: %ld",
+			       (unsigned long long)(v->hash_start + i),
+			       PTR_ERR(data));
+			return;
+		}
+		v->n_pinned++;
+	}
+
+	v->pin_level = pin_level;
+}
+
 static int verity_ctr(struct dm_target *ti, unsigned argc, char **argv)
 {
 	struct dm_verity *v;
@@ -852,6 +1032,9 @@ static int verity_ctr(struct dm_target *ti, unsigned argc, char **argv)
 		goto bad;
 	}
 
+	v->pin_level = v->levels;
+	verity_pin_hash_levels(v);
+
 	ti->per_bio_data_size = roundup(sizeof(struct dm_verity_io) + v->shash_descsize + v->digest_size * 2, __alignof__(struct dm_verity_io));
 
 	v->vec_mempool = mempool_create_kmalloc_pool(DM_VERITY_MEMPOOL_SIZE,
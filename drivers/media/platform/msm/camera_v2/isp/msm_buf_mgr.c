@@ -20,6 +20,8 @@
 #include <linux/proc_fs.h>
 #include <linux/videodev2.h>
 #include <linux/vmalloc.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 
 #include <media/v4l2-dev.h>
@@ -162,6 +164,7 @@ static int msm_isp_free_bufq_handle(struct msm_isp_buf_mgr *buf_mgr,
 	bufq->stream_id = 0;
 	bufq->num_bufs = 0;
 	bufq->buf_type = 0;
+	bufq->persistent_map = false;
 	INIT_LIST_HEAD(&bufq->head);
 
 	return 0;
@@ -180,6 +183,31 @@ static void msm_isp_copy_planes_from_v4l2_buffer(
 	}
 }
 
+static void msm_isp_unprepare_v4l2_buf(
+	struct msm_isp_buf_mgr *buf_mgr,
+	struct msm_isp_buffer *buf_info,
+	uint32_t stream_id);
+
+/* Returns true if the planes of @qbuf_buf are the ones still mapped */
+static bool msm_isp_buf_mapping_matches(struct msm_isp_buffer *buf_info,
+	struct msm_isp_qbuf_buffer *qbuf_buf)
+{
+	int i;
+
+	if (!buf_info->mapped || buf_info->num_planes != qbuf_buf->num_planes)
+		return false;
+
+	for (i = 0; i < qbuf_buf->num_planes; i++) {
+		if (buf_info->mapped_info[i].buf_fd !=
+				qbuf_buf->planes[i].addr ||
+			buf_info->mapped_info[i].plane_len !=
+				qbuf_buf->planes[i].length)
+			return false;
+	}
+
+	return true;
+}
+
 static int msm_isp_prepare_v4l2_buf(struct msm_isp_buf_mgr *buf_mgr,
 	struct msm_isp_buffer *buf_info,
 	struct msm_isp_qbuf_buffer *qbuf_buf,
@@ -188,11 +216,29 @@ static int msm_isp_prepare_v4l2_buf(struct msm_isp_buf_mgr *buf_mgr,
 	int i, rc = -1;
 	int ret;
 	struct msm_isp_buffer_mapped_info *mapped_info;
+	struct msm_isp_bufq *bufq;
 	uint32_t accu_length = 0;
 
+	bufq = msm_isp_get_bufq(buf_mgr, buf_info->bufq_handle);
+	if (!bufq) {
+		pr_err("%s: Invalid bufq, stream id %x\n",
+			__func__, stream_id);
+		return rc;
+	}
+
+	if (buf_info->mapped) {
+		if (msm_isp_buf_mapping_matches(buf_info, qbuf_buf)) {
+			bufq->map_reuse_cnt++;
+			return 0;
+		}
+		msm_isp_unprepare_v4l2_buf(buf_mgr, buf_info, stream_id);
+	}
+	bufq->map_cnt++;
+
 	for (i = 0; i < qbuf_buf->num_planes; i++) {
 		mapped_info = &buf_info->mapped_info[i];
 		mapped_info->buf_fd = qbuf_buf->planes[i].addr;
+		mapped_info->plane_len = qbuf_buf->planes[i].length;
 		ret = cam_smmu_get_phy_addr(buf_mgr->iommu_hdl,
 					mapped_info->buf_fd,
 					CAM_SMMU_MAP_RW,
@@ -246,6 +292,7 @@ static void msm_isp_unprepare_v4l2_buf(
 
 		cam_smmu_put_phy_addr(buf_mgr->iommu_hdl, mapped_info->buf_fd);
 	}
+	buf_info->mapped = false;
 	return;
 }
 
@@ -372,11 +419,16 @@ static int msm_isp_buf_unprepare_all(struct msm_isp_buf_mgr *buf_mgr,
 			pr_err("%s: buf not found\n", __func__);
 			return rc;
 		}
-		if (buf_info->state == MSM_ISP_BUFFER_STATE_UNUSED ||
-				buf_info->state ==
-					MSM_ISP_BUFFER_STATE_INITIALIZED)
+		if (buf_info->state == MSM_ISP_BUFFER_STATE_UNUSED)
 			continue;
 
+		if (buf_info->state == MSM_ISP_BUFFER_STATE_INITIALIZED) {
+			if (buf_info->mapped)
+				msm_isp_unprepare_v4l2_buf(buf_mgr, buf_info,
+					bufq->stream_id);
+			continue;
+		}
+
 		if (MSM_ISP_BUFFER_SRC_HAL == BUF_SRC(bufq->stream_id)) {
 			if (buf_info->state == MSM_ISP_BUFFER_STATE_DEQUEUED ||
 			buf_info->state == MSM_ISP_BUFFER_STATE_DIVERTED)
@@ -395,8 +447,6 @@ static int msm_isp_get_buf_by_index(struct msm_isp_buf_mgr *buf_mgr,
 	int rc = -EINVAL;
 	unsigned long flags;
 	struct msm_isp_bufq *bufq = NULL;
-	struct msm_isp_buffer *temp_buf_info;
-	uint32_t i = 0;
 
 	bufq = msm_isp_get_bufq(buf_mgr, bufq_handle);
 	if (!bufq) {
@@ -412,19 +462,10 @@ static int msm_isp_get_buf_by_index(struct msm_isp_buf_mgr *buf_mgr,
 		return rc;
 	}
 
-	*buf_info = NULL;
-	for (i = 0; bufq->num_bufs; i++) {
-		temp_buf_info = &bufq->bufs[i];
-		if (temp_buf_info && temp_buf_info->buf_idx == buf_index) {
-			*buf_info = temp_buf_info;
-			break;
-		}
-	}
-
-	if (*buf_info) {
-		pr_debug("Found buf in isp buf mgr");
-		rc = 0;
-	}
+	/* buffers are allocated in index order, see msm_isp_request_bufq */
+	*buf_info = &bufq->bufs[buf_index];
+	pr_debug("Found buf in isp buf mgr");
+	rc = 0;
 	spin_unlock_irqrestore(&bufq->bufq_lock, flags);
 	return rc;
 }
@@ -455,7 +496,11 @@ static int msm_isp_buf_unprepare(struct msm_isp_buf_mgr *buf_mgr,
 			buf_mgr->vb2_ops->put_buf(buf_info->vb2_buf,
 				bufq->session_id, bufq->stream_id);
 	}
-	msm_isp_unprepare_v4l2_buf(buf_mgr, buf_info, bufq->stream_id);
+
+	if (bufq->persistent_map)
+		buf_info->mapped = true;
+	else
+		msm_isp_unprepare_v4l2_buf(buf_mgr, buf_info, bufq->stream_id);
 
 	return 0;
 }
@@ -549,6 +594,8 @@ static int msm_isp_get_buf(struct msm_isp_buf_mgr *buf_mgr, uint32_t id,
 	}
 
 	if (!(*buf_info)) {
+		bufq->drop_cnt++;
+		bufq->starved = true;
 		rc = -ENOMEM;
 	} else {
 		(*buf_info)->state = MSM_ISP_BUFFER_STATE_DEQUEUED;
@@ -599,6 +646,10 @@ static int msm_isp_put_buf_unsafe(struct msm_isp_buf_mgr *buf_mgr,
 				bufq->session_id, bufq->stream_id);
 		}
 		buf_info->state = MSM_ISP_BUFFER_STATE_QUEUED;
+		if (bufq->starved) {
+			bufq->late_cnt++;
+			bufq->starved = false;
+		}
 		rc = 0;
 		break;
 	case MSM_ISP_BUFFER_STATE_DISPATCHED:
@@ -980,7 +1031,7 @@ static int msm_isp_get_buf_src(struct msm_isp_buf_mgr *buf_mgr,
 }
 
 static int msm_isp_request_bufq(struct msm_isp_buf_mgr *buf_mgr,
-	struct msm_isp_buf_request *buf_request)
+	struct msm_isp_buf_request_ver2 *buf_request)
 {
 	int i;
 	struct msm_isp_bufq *bufq = NULL;
@@ -1019,6 +1070,13 @@ static int msm_isp_request_bufq(struct msm_isp_buf_mgr *buf_mgr,
 	bufq->stream_id = buf_request->stream_id;
 	bufq->num_bufs = buf_request->num_buf;
 	bufq->buf_type = buf_request->buf_type;
+	bufq->persistent_map = !!(buf_request->flags &
+		ISP_BUF_REQ_FLAG_PERSISTENT_MAP);
+	bufq->drop_cnt = 0;
+	bufq->late_cnt = 0;
+	bufq->map_cnt = 0;
+	bufq->map_reuse_cnt = 0;
+	bufq->starved = false;
 	for (i = 0; i < ISP_NUM_BUF_MASK; i++)
 		bufq->put_buf_mask[i] = 0;
 	INIT_LIST_HEAD(&bufq->head);
@@ -1242,8 +1300,21 @@ int msm_isp_proc_buf_cmd(struct msm_isp_buf_mgr *buf_mgr,
 	switch (cmd) {
 	case VIDIOC_MSM_ISP_REQUEST_BUF: {
 		struct msm_isp_buf_request *buf_req = arg;
+		struct msm_isp_buf_request_ver2 buf_req_ver2;
+
+		memset(&buf_req_ver2, 0, sizeof(buf_req_ver2));
+		buf_req_ver2.session_id = buf_req->session_id;
+		buf_req_ver2.stream_id = buf_req->stream_id;
+		buf_req_ver2.num_buf = buf_req->num_buf;
+		buf_req_ver2.buf_type = buf_req->buf_type;
+		buf_mgr->ops->request_buf(buf_mgr, &buf_req_ver2);
+		buf_req->handle = buf_req_ver2.handle;
+		break;
+	}
+	case VIDIOC_MSM_ISP_REQUEST_BUF_VER2: {
+		struct msm_isp_buf_request_ver2 *buf_req_ver2 = arg;
 
-		buf_mgr->ops->request_buf(buf_mgr, buf_req);
+		buf_mgr->ops->request_buf(buf_mgr, buf_req_ver2);
 		break;
 	}
 	case VIDIOC_MSM_ISP_ENQUEUE_BUF: {
@@ -1401,6 +1472,45 @@ static int msm_isp_buf_mgr_debug(struct msm_isp_buf_mgr *buf_mgr,
 	return rc;
 }
 
+static int msm_isp_bufq_stats_show(struct seq_file *s, void *unused)
+{
+	struct msm_isp_buf_mgr *buf_mgr = s->private;
+	struct msm_isp_bufq *bufq;
+	unsigned long flags;
+	int i;
+
+	seq_puts(s, "handle stream bufs persist drop late map reuse\n");
+	for (i = 0; i < BUF_MGR_NUM_BUF_Q; i++) {
+		bufq = &buf_mgr->bufq[i];
+		/* the lock is set up when the queue is first requested */
+		if (!bufq->bufq_handle)
+			continue;
+
+		spin_lock_irqsave(&bufq->bufq_lock, flags);
+		if (bufq->bufq_handle)
+			seq_printf(s, "%x %x %u %d %lu %lu %lu %lu\n",
+				bufq->bufq_handle, bufq->stream_id,
+				bufq->num_bufs, bufq->persistent_map,
+				bufq->drop_cnt, bufq->late_cnt,
+				bufq->map_cnt, bufq->map_reuse_cnt);
+		spin_unlock_irqrestore(&bufq->bufq_lock, flags);
+	}
+
+	return 0;
+}
+
+static int msm_isp_bufq_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, msm_isp_bufq_stats_show, inode->i_private);
+}
+
+static const struct file_operations msm_isp_bufq_stats_fops = {
+	.open = msm_isp_bufq_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static struct msm_isp_buf_ops isp_buf_ops = {
 	.request_buf = msm_isp_request_bufq,
 	.enqueue_buf = msm_isp_buf_enqueue,
@@ -1441,5 +1551,11 @@ int msm_isp_create_isp_buf_mgr(
 	buf_mgr->scratch_buf_range = scratch_buf_range;
 	mutex_init(&buf_mgr->lock);
 
+	buf_mgr->debugfs_root = debugfs_create_dir("msm_isp_buf_mgr", NULL);
+	if (!IS_ERR_OR_NULL(buf_mgr->debugfs_root))
+		debugfs_create_file("bufq_stats", S_IRUGO,
+			buf_mgr->debugfs_root, buf_mgr,
+			&msm_isp_bufq_stats_fops);
+
 	return 0;
 }
@@ -68,6 +68,7 @@ struct msm_isp_buffer_mapped_info {
 	size_t len;
 	dma_addr_t paddr;
 	int buf_fd;
+	uint32_t plane_len;
 };
 
 struct buffer_cmd {
@@ -97,6 +98,9 @@ struct msm_isp_buffer {
 
 	struct msm_isp_buffer_debug_t buf_debug;
 
+	/* planes are still mapped from an earlier enqueue */
+	bool mapped;
+
 	
 	struct vb2_buffer *vb2_buf;
 };
@@ -112,11 +116,23 @@ struct msm_isp_bufq {
 	uint8_t put_buf_mask[ISP_NUM_BUF_MASK];
 	
 	struct list_head head;
+
+	/* keep buffers mapped across dequeue, see ISP_BUF_REQ_FLAG_* */
+	bool persistent_map;
+	/* frames that found no buffer */
+	unsigned long drop_cnt;
+	/* buffers enqueued after a frame found no buffer */
+	unsigned long late_cnt;
+	/* enqueues that had to map the buffer */
+	unsigned long map_cnt;
+	/* enqueues that reused a persistent mapping */
+	unsigned long map_reuse_cnt;
+	bool starved;
 };
 
 struct msm_isp_buf_ops {
 	int (*request_buf)(struct msm_isp_buf_mgr *buf_mgr,
-		struct msm_isp_buf_request *buf_request);
+		struct msm_isp_buf_request_ver2 *buf_request);
 
 	int (*enqueue_buf)(struct msm_isp_buf_mgr *buf_mgr,
 		struct msm_isp_qbuf_info *info);
@@ -198,6 +214,7 @@ struct msm_isp_buf_mgr {
 	
 	dma_addr_t scratch_buf_addr;
 	uint32_t scratch_buf_range;
+	struct dentry *debugfs_root;
 };
 
 int msm_isp_create_isp_buf_mgr(struct msm_isp_buf_mgr *buf_mgr,
@@ -16,6 +16,7 @@
 #include <linux/module.h>
 #include <linux/proc_fs.h>
 #include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/videodev2.h>
 #include <linux/of_device.h>
 #include <linux/sched_clock.h>
@@ -274,6 +275,59 @@ static const struct file_operations ub_info_ops = {
 	.write = ub_info_write,
 };
 
+static uint64_t frame_latency_to_us(struct timeval *tv)
+{
+	return (uint64_t)tv->tv_sec * USEC_PER_SEC + tv->tv_usec;
+}
+
+static int frame_latency_show(struct seq_file *s, void *unused)
+{
+	struct vfe_device *vfe_dev = s->private;
+	struct msm_vfe_axi_stream *stream_info;
+	struct msm_isp_frame_latency *latency;
+	uint64_t sof_us, done_us;
+	unsigned long flags;
+	int i, j;
+
+	seq_puts(s, "stream frame sof_us done_us sof_to_done_us\n");
+	for (i = 0; i < VFE_AXI_SRC_MAX; i++) {
+		stream_info = &vfe_dev->axi_data.stream_info[i];
+		if (stream_info->state == AVAILABLE)
+			continue;
+
+		spin_lock_irqsave(&stream_info->lock, flags);
+		/* oldest entry first */
+		for (j = 0; j < MSM_ISP_FRAME_LATENCY_SIZE; j++) {
+			latency = &stream_info->latency[
+				(stream_info->latency_idx + j) %
+				MSM_ISP_FRAME_LATENCY_SIZE];
+			done_us = frame_latency_to_us(&latency->done_time);
+			if (!done_us)
+				continue;
+
+			sof_us = frame_latency_to_us(&latency->sof_time);
+			seq_printf(s, "%x %u %llu %llu %lld\n",
+				stream_info->stream_id, latency->frame_id,
+				sof_us, done_us, (int64_t)(done_us - sof_us));
+		}
+		spin_unlock_irqrestore(&stream_info->lock, flags);
+	}
+
+	return 0;
+}
+
+static int frame_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, frame_latency_show, inode->i_private);
+}
+
+static const struct file_operations frame_latency_ops = {
+	.open = frame_latency_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int msm_isp_enable_debugfs(struct vfe_device *vfe_dev,
 	struct msm_isp_bw_req_info *isp_req_hist)
 {
@@ -296,6 +350,14 @@ static int msm_isp_enable_debugfs(struct vfe_device *vfe_dev,
 		debugfs_base, vfe_dev, &ub_info_ops))
 		return -ENOMEM;
 
+	if (!debugfs_create_file("frame_latency", S_IRUGO, debugfs_base,
+		vfe_dev, &frame_latency_ops))
+		return -ENOMEM;
+
+	if (!debugfs_create_bool("stats_batch", S_IRUGO | S_IWUSR,
+		debugfs_base, &vfe_dev->stats_batch_notify))
+		return -ENOMEM;
+
 	return 0;
 }
 
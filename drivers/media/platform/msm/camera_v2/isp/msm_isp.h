@@ -332,6 +332,20 @@ struct msm_vfe_frame_request_queue {
 
 #define MSM_VFE_REQUESTQ_SIZE 8
 
+#define MSM_ISP_FRAME_LATENCY_SIZE 32
+
+/*
+ * struct msm_isp_frame_latency - timing of one frame written by a stream
+ * @frame_id: Frame id of the source at write done
+ * @sof_time: Monotonic time of the start of frame
+ * @done_time: Monotonic time the write masters completed the frame
+ */
+struct msm_isp_frame_latency {
+	uint32_t frame_id;
+	struct timeval sof_time;
+	struct timeval done_time;
+};
+
 struct msm_vfe_axi_stream {
 	uint32_t frame_id;
 	enum msm_vfe_axi_state state;
@@ -374,6 +388,10 @@ struct msm_vfe_axi_stream {
 	enum msm_stream_memory_input_t  memory_input;
 	struct msm_isp_sw_framskip sw_skip;
 	uint8_t sw_ping_pong_bit;
+
+	/* last frames written, protected by lock */
+	struct msm_isp_frame_latency latency[MSM_ISP_FRAME_LATENCY_SIZE];
+	uint32_t latency_idx;
 };
 
 struct msm_vfe_axi_composite_info {
@@ -486,6 +504,10 @@ struct msm_vfe_stats_shared_data {
 	atomic_t stats_comp_mask[MAX_NUM_STATS_COMP_MASK];
 	uint16_t stream_handle_cnt;
 	atomic_t stats_update;
+
+	/* stats types gathered in batch_event, see stats_batch_notify */
+	uint32_t batch_mask;
+	struct msm_isp_event_data batch_event;
 };
 
 struct msm_vfe_tasklet_queue_cmd {
@@ -707,6 +729,8 @@ struct vfe_device {
 	uint32_t isp_raw1_debug;
 	uint32_t isp_raw2_debug;
 	uint8_t is_camif_raw_crop_supported;
+	/* send the stats of one frame in a single composite notification */
+	u32 stats_batch_notify;
 };
 
 struct vfe_parent_device {
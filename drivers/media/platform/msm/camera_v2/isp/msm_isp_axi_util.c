@@ -14,6 +14,7 @@
 #include <asm/div64.h>
 #include "msm_isp_util.h"
 #include "msm_isp_axi_util.h"
+#include "msm_isp_stats_util.h"
 
 #define HANDLE_TO_IDX(handle) (handle & 0xFF)
 #define ISP_SOF_DEBUG_COUNT 0
@@ -690,6 +691,8 @@ void msm_isp_increment_frame_id(struct vfe_device *vfe_dev,
 			vfe_dev->axi_data.src_info[frame_src].frame_id++;
 	}
 
+	vfe_dev->axi_data.src_info[frame_src].time_stamp = ts->buf_time;
+
 	sof_info = vfe_dev->axi_data.src_info[frame_src].
 		dual_hw_ms_info.sof_info;
 	if (dual_hw_type == DUAL_HW_MASTER_SLAVE &&
@@ -719,6 +722,7 @@ void msm_isp_notify(struct vfe_device *vfe_dev, uint32_t event_type,
 	switch (event_type) {
 	case ISP_EVENT_SOF:
 		if (frame_src == VFE_PIX_0) {
+			msm_isp_stats_flush_batch(vfe_dev);
 			if (vfe_dev->isp_sof_debug < ISP_SOF_DEBUG_COUNT)
 				pr_err("%s: PIX0 frame id: %u\n", __func__,
 				vfe_dev->axi_data.src_info[VFE_PIX_0].frame_id);
@@ -3164,6 +3168,22 @@ int msm_isp_update_axi_stream(struct vfe_device *vfe_dev, void *arg)
 	return rc;
 }
 
+/* Called with stream_info->lock held */
+static void msm_isp_record_frame_latency(struct vfe_device *vfe_dev,
+	struct msm_vfe_axi_stream *stream_info, uint32_t frame_id,
+	struct timeval *done_time)
+{
+	struct msm_isp_frame_latency *latency;
+
+	latency = &stream_info->latency[stream_info->latency_idx];
+	latency->frame_id = frame_id;
+	latency->sof_time = vfe_dev->axi_data.
+		src_info[SRC_TO_INTF(stream_info->stream_src)].time_stamp;
+	latency->done_time = *done_time;
+	stream_info->latency_idx = (stream_info->latency_idx + 1) %
+		MSM_ISP_FRAME_LATENCY_SIZE;
+}
+
 void msm_isp_process_axi_irq_stream(struct vfe_device *vfe_dev,
 		struct msm_vfe_axi_stream *stream_info,
 		uint32_t pingpong_status,
@@ -3285,6 +3305,8 @@ void msm_isp_process_axi_irq_stream(struct vfe_device *vfe_dev,
 		return;
 	}
 
+	msm_isp_record_frame_latency(vfe_dev, stream_info, frame_id,
+		&ts->buf_time);
 	spin_unlock_irqrestore(&stream_info->lock, flags);
 
 	if ((done_buf->frame_id != frame_id) &&
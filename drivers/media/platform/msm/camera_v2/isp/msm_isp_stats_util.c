@@ -251,21 +251,73 @@ static int32_t msm_isp_stats_buf_divert(struct vfe_device *vfe_dev,
 	return rc;
 }
 
+/**
+ * msm_isp_stats_flush_batch() - send the stats gathered for a frame
+ * @vfe_dev: vfe device
+ *
+ * Called once every active stats stream has reported for the frame, and
+ * at the start of the next frame for streams skipped by their framedrop
+ * pattern.
+ */
+void msm_isp_stats_flush_batch(struct vfe_device *vfe_dev)
+{
+	struct msm_vfe_stats_shared_data *stats_data = &vfe_dev->stats_data;
+
+	if (!stats_data->batch_mask)
+		return;
+
+	ISP_DBG("%s: vfe_id %d batch frameid %x mask %x\n", __func__,
+		vfe_dev->pdev->id, stats_data->batch_event.frame_id,
+		stats_data->batch_mask);
+	stats_data->batch_event.u.stats.stats_mask = stats_data->batch_mask;
+	msm_isp_send_event(vfe_dev, ISP_EVENT_COMP_STATS_NOTIFY,
+		&stats_data->batch_event);
+	stats_data->batch_mask = 0;
+}
+
+static uint32_t msm_isp_stats_active_mask(struct vfe_device *vfe_dev)
+{
+	uint32_t mask = 0;
+	int i;
+
+	for (i = 0; i < vfe_dev->hw_info->stats_hw_info->num_stats_type; i++) {
+		if (vfe_dev->stats_data.stream_info[i].state == STATS_ACTIVE)
+			mask |= 1 << i;
+	}
+
+	return mask;
+}
+
 static int32_t msm_isp_stats_configure(struct vfe_device *vfe_dev,
 	uint32_t stats_irq_mask, struct msm_isp_timestamp *ts,
 	bool is_composite)
 {
 	int i, rc = 0;
-	struct msm_isp_event_data buf_event;
-	struct msm_isp_stats_event *stats_event = &buf_event.u.stats;
+	struct msm_vfe_stats_shared_data *stats_data = &vfe_dev->stats_data;
+	struct msm_isp_event_data local_event;
+	struct msm_isp_event_data *buf_event = &local_event;
+	struct msm_isp_stats_event *stats_event;
 	struct msm_vfe_stats_stream *stream_info = NULL;
 	uint32_t pingpong_status;
 	uint32_t comp_stats_type_mask = 0;
+	uint32_t *stats_type_mask = is_composite ? &comp_stats_type_mask : NULL;
+	uint32_t frame_id = vfe_dev->axi_data.src_info[VFE_PIX_0].frame_id;
 	int result = 0;
 
-	memset(&buf_event, 0, sizeof(struct msm_isp_event_data));
-	buf_event.timestamp = ts->buf_time;
-	buf_event.frame_id = vfe_dev->axi_data.src_info[VFE_PIX_0].frame_id;
+	if (vfe_dev->stats_batch_notify) {
+		if (stats_data->batch_mask &&
+			stats_data->batch_event.frame_id != frame_id)
+			msm_isp_stats_flush_batch(vfe_dev);
+		buf_event = &stats_data->batch_event;
+		stats_type_mask = &stats_data->batch_mask;
+	}
+
+	if (buf_event == &local_event || !stats_data->batch_mask) {
+		memset(buf_event, 0, sizeof(struct msm_isp_event_data));
+		buf_event->timestamp = ts->buf_time;
+		buf_event->frame_id = frame_id;
+	}
+	stats_event = &buf_event->u.stats;
 	pingpong_status = vfe_dev->hw_info->
 		vfe_ops.stats_ops.get_pingpong_status(vfe_dev);
 
@@ -280,8 +332,7 @@ static int32_t msm_isp_stats_configure(struct vfe_device *vfe_dev,
 		}
 
 		rc = msm_isp_stats_buf_divert(vfe_dev, ts,
-				&buf_event, stream_info,
-				is_composite ? &comp_stats_type_mask : NULL,
+				buf_event, stream_info, stats_type_mask,
 				pingpong_status);
 		if (rc < 0) {
 			pr_err("%s:%d failed: stats buf divert rc %d\n",
@@ -290,13 +341,18 @@ static int32_t msm_isp_stats_configure(struct vfe_device *vfe_dev,
 				result = rc;
 		}
 	}
-	if (is_composite && comp_stats_type_mask) {
+	if (vfe_dev->stats_batch_notify) {
+		uint32_t active_mask = msm_isp_stats_active_mask(vfe_dev);
+
+		if ((stats_data->batch_mask & active_mask) == active_mask)
+			msm_isp_stats_flush_batch(vfe_dev);
+	} else if (is_composite && comp_stats_type_mask) {
 		ISP_DBG("%s:vfe_id %d comp_stats frameid %x,comp_mask %x\n",
-			__func__, vfe_dev->pdev->id, buf_event.frame_id,
+			__func__, vfe_dev->pdev->id, buf_event->frame_id,
 			comp_stats_type_mask);
 		stats_event->stats_mask = comp_stats_type_mask;
 		msm_isp_send_event(vfe_dev,
-			ISP_EVENT_COMP_STATS_NOTIFY, &buf_event);
+			ISP_EVENT_COMP_STATS_NOTIFY, buf_event);
 		comp_stats_type_mask = 0;
 	}
 	return result;
@@ -792,6 +848,8 @@ static int msm_isp_stop_stats_stream(struct vfe_device *vfe_dev,
 
 		stats_data->num_active_stream--;
 		stats_mask |= 1 << idx;
+		/* its buffer is about to be flushed, don't report it */
+		stats_data->batch_mask &= ~(1 << idx);
 
 		if (stream_info->composite_flag > 0)
 			comp_stats_mask[stream_info->composite_flag-1] |=
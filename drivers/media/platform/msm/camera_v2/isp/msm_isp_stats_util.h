@@ -27,4 +27,5 @@ void msm_isp_update_stats_framedrop_reg(struct vfe_device *vfe_dev);
 void msm_isp_stats_disable(struct vfe_device *vfe_dev);
 int msm_isp_stats_reset(struct vfe_device *vfe_dev);
 int msm_isp_stats_restart(struct vfe_device *vfe_dev);
+void msm_isp_stats_flush_batch(struct vfe_device *vfe_dev);
 #endif /* __MSM_ISP_STATS_UTIL_H__ */
@@ -952,6 +952,8 @@ static long msm_isp_ioctl_unlocked(struct v4l2_subdev *sd,
 	}
 	case VIDIOC_MSM_ISP_REQUEST_BUF:
 		
+	case VIDIOC_MSM_ISP_REQUEST_BUF_VER2:
+		
 	case VIDIOC_MSM_ISP_ENQUEUE_BUF:
 		
 	case VIDIOC_MSM_ISP_DEQUEUE_BUF:
@@ -39,6 +39,7 @@
 #include "msm_isp_util.h"
 #include "msm_camera_io_util.h"
 #include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include "cam_smmu_api.h"
 #include "cam_hw_ops.h"
 
@@ -1539,6 +1540,26 @@ static int msm_cpp_buffer_ops(struct cpp_device *cpp_dev,
 	return rc;
 }
 
+static void msm_cpp_record_frame_latency(struct cpp_device *cpp_dev,
+	struct msm_cpp_frame_info_t *frame)
+{
+	struct msm_cpp_frame_latency *latency;
+	unsigned long flags;
+
+	spin_lock_irqsave(&cpp_dev->latency_lock, flags);
+	latency = &cpp_dev->latency[cpp_dev->latency_idx];
+	latency->identity = frame->identity;
+	latency->frame_id = frame->frame_id;
+	latency->frame_time = frame->timestamp;
+	latency->done_time = ktime_to_timeval(ktime_get());
+	latency->process_us =
+		(int64_t)(frame->out_time.tv_sec - frame->in_time.tv_sec) *
+		USEC_PER_SEC + frame->out_time.tv_usec - frame->in_time.tv_usec;
+	cpp_dev->latency_idx = (cpp_dev->latency_idx + 1) %
+		MSM_CPP_FRAME_LATENCY_SIZE;
+	spin_unlock_irqrestore(&cpp_dev->latency_lock, flags);
+}
+
 static int msm_cpp_notify_frame_done(struct cpp_device *cpp_dev,
 	uint8_t put_buf)
 {
@@ -1554,6 +1575,7 @@ static int msm_cpp_notify_frame_done(struct cpp_device *cpp_dev,
 	if (frame_qcmd) {
 		processed_frame = frame_qcmd->command;
 		do_gettimeofday(&(processed_frame->out_time));
+		msm_cpp_record_frame_latency(cpp_dev, processed_frame);
 		kfree(frame_qcmd);
 		event_qcmd = kzalloc(sizeof(struct msm_queue_cmd), GFP_ATOMIC);
 		if (!event_qcmd) {
@@ -4139,6 +4161,7 @@ static int cpp_probe(struct platform_device *pdev)
 	platform_set_drvdata(pdev, &cpp_dev->msm_sd.sd);
 	mutex_init(&cpp_dev->mutex);
 	spin_lock_init(&cpp_dev->tasklet_lock);
+	spin_lock_init(&cpp_dev->latency_lock);
 	spin_lock_init(&cpp_timer.data.processed_frame_lock);
 
 	if (pdev->dev.of_node)
@@ -4351,6 +4374,52 @@ static int msm_cpp_debugfs_error_s(void *data, u64 val)
 DEFINE_SIMPLE_ATTRIBUTE(cpp_debugfs_error, NULL,
 	msm_cpp_debugfs_error_s, "%llu\n");
 
+static uint64_t msm_cpp_latency_to_us(struct timeval *tv)
+{
+	return (uint64_t)tv->tv_sec * USEC_PER_SEC + tv->tv_usec;
+}
+
+static int msm_cpp_frame_latency_show(struct seq_file *s, void *unused)
+{
+	struct cpp_device *cpp_dev = s->private;
+	struct msm_cpp_frame_latency *latency;
+	uint64_t frame_us, done_us;
+	unsigned long flags;
+	int i;
+
+	seq_puts(s, "identity frame frame_us done_us delta_us process_us\n");
+	spin_lock_irqsave(&cpp_dev->latency_lock, flags);
+	/* oldest entry first */
+	for (i = 0; i < MSM_CPP_FRAME_LATENCY_SIZE; i++) {
+		latency = &cpp_dev->latency[(cpp_dev->latency_idx + i) %
+			MSM_CPP_FRAME_LATENCY_SIZE];
+		done_us = msm_cpp_latency_to_us(&latency->done_time);
+		if (!done_us)
+			continue;
+
+		frame_us = msm_cpp_latency_to_us(&latency->frame_time);
+		seq_printf(s, "%x %d %llu %llu %lld %lld\n",
+			latency->identity, latency->frame_id, frame_us,
+			done_us, (int64_t)(done_us - frame_us),
+			latency->process_us);
+	}
+	spin_unlock_irqrestore(&cpp_dev->latency_lock, flags);
+
+	return 0;
+}
+
+static int msm_cpp_frame_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, msm_cpp_frame_latency_show, inode->i_private);
+}
+
+static const struct file_operations cpp_debugfs_frame_latency = {
+	.open = msm_cpp_frame_latency_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int msm_cpp_enable_debugfs(struct cpp_device *cpp_dev)
 {
 	struct dentry *debugfs_base;
@@ -4362,6 +4431,10 @@ static int msm_cpp_enable_debugfs(struct cpp_device *cpp_dev)
 		(void *)cpp_dev, &cpp_debugfs_error))
 		return -ENOMEM;
 
+	if (!debugfs_create_file("frame_latency", S_IRUGO, debugfs_base,
+		(void *)cpp_dev, &cpp_debugfs_frame_latency))
+		return -ENOMEM;
+
 	return 0;
 }
 
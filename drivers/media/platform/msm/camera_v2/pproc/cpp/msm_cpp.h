@@ -89,6 +89,7 @@
 
 #define MSM_CPP_POLL_RETRIES		200
 #define MSM_CPP_TASKLETQ_SIZE		16
+#define MSM_CPP_FRAME_LATENCY_SIZE	32
 #define MSM_CPP_TX_FIFO_LEVEL		16
 #define MSM_CPP_RX_FIFO_LEVEL		512
 
@@ -196,6 +197,22 @@ struct msm_cpp_payload_params {
 	uint32_t dup_frame_indicator_off;
 };
 
+/*
+ * struct msm_cpp_frame_latency - timing of one frame processed by the cpp
+ * @identity: Session and stream of the output
+ * @frame_id: Frame id given by userspace
+ * @frame_time: Frame timestamp, the isp write done time for camera frames
+ * @done_time: Monotonic time the cpp completed the frame
+ * @process_us: Time from frame submission to completion
+ */
+struct msm_cpp_frame_latency {
+	uint32_t identity;
+	int32_t frame_id;
+	struct timeval frame_time;
+	struct timeval done_time;
+	int64_t process_us;
+};
+
 struct cpp_device {
 	struct platform_device *pdev;
 	struct msm_sd_subdev msm_sd;
@@ -263,5 +280,9 @@ struct cpp_device {
 	uint32_t bus_idx;
 	uint32_t bus_master_flag;
 	struct msm_cpp_payload_params payload_params;
+
+	spinlock_t latency_lock;
+	struct msm_cpp_frame_latency latency[MSM_CPP_FRAME_LATENCY_SIZE];
+	uint32_t latency_idx;
 };
 #endif /* __MSM_CPP_H__ */
@@ -387,13 +387,18 @@ static int32_t msm_cci_calc_cmd_len(struct cci_device *cci_dev,
 		len = data_len + addr_len;
 		pack_max_len = size < (cci_dev->payload_size-len) ?
 			size : (cci_dev->payload_size-len);
-		for (i = 0; i < pack_max_len;) {
+		/*
+		 * The slave auto-increments its address per byte, so an
+		 * entry can ride in the same burst only if it starts where
+		 * the previous one's data ended.  pack counts entries.
+		 */
+		for (i = 0; i + data_len <= pack_max_len;) {
 			if (cmd->delay || ((cmd - i2c_cmd) >= (cmd_size - 1)))
 				break;
-			if (cmd->reg_addr + 1 ==
+			if (cmd->reg_addr + data_len ==
 				(cmd+1)->reg_addr) {
 				len += data_len;
-				*pack += data_len;
+				(*pack)++;
 			} else
 				break;
 			i += data_len;
@@ -688,6 +693,17 @@ static int32_t msm_cci_data_queue(struct cci_device *cci_dev,
 			if (i2c_msg->data_type == MSM_CAMERA_I2C_BYTE_DATA) {
 				data[i++] = i2c_cmd->reg_data;
 				reg_addr++;
+			} else if (i2c_msg->data_type ==
+				MSM_CAMERA_I2C_DWORD_DATA) {
+				if ((i + 3) > cci_dev->payload_size)
+					break;
+				/* reg_data is 16 bit, the high half is 0 */
+				data[i++] = 0;
+				data[i++] = 0;
+				data[i++] = (i2c_cmd->reg_data &
+					0xFF00) >> 8;
+				data[i++] = i2c_cmd->reg_data & 0x00FF;
+				reg_addr++;
 			} else {
 				if ((i + 1) <= cci_dev->payload_size) {
 					data[i++] = (i2c_cmd->reg_data &
@@ -716,6 +732,11 @@ static int32_t msm_cci_data_queue(struct cci_device *cci_dev,
 		}
 		len = ((i-1)/4) + 1;
 
+		/*
+		 * Load the whole command with relaxed writes and expose it
+		 * to the engine with a single exec count update; the
+		 * barrier in msm_camera_io_w_mb() orders the data first.
+		 */
 		read_val = msm_camera_io_r_mb(cci_dev->base +
 			CCI_I2C_M0_Q0_CUR_WORD_CNT_ADDR + reg_offset);
 		for (h = 0, k = 0; h < len; h++) {
@@ -724,13 +745,10 @@ static int32_t msm_cci_data_queue(struct cci_device *cci_dev,
 				cmd |= (data[k++] << (j * 8));
 			CDBG("%s LOAD_DATA_ADDR 0x%x, q: %d, len:%d, cnt: %d\n",
 				__func__, cmd, queue, len, read_val);
-			msm_camera_io_w_mb(cmd, cci_dev->base +
+			msm_camera_io_w(cmd, cci_dev->base +
 				CCI_I2C_M0_Q0_LOAD_DATA_ADDR +
 				master * 0x200 + queue * 0x100);
-
 			read_val += 1;
-			msm_camera_io_w_mb(read_val, cci_dev->base +
-				CCI_I2C_M0_Q0_EXEC_WORD_CNT_ADDR + reg_offset);
 		}
 
 		if ((delay > 0) && (delay < CCI_MAX_DELAY) &&
@@ -741,13 +759,13 @@ static int32_t msm_cci_data_queue(struct cci_device *cci_dev,
 			cmd |= CCI_I2C_WAIT_CMD;
 			CDBG("%s CCI_I2C_M0_Q0_LOAD_DATA_ADDR 0x%x\n",
 				__func__, cmd);
-			msm_camera_io_w_mb(cmd, cci_dev->base +
+			msm_camera_io_w(cmd, cci_dev->base +
 				CCI_I2C_M0_Q0_LOAD_DATA_ADDR +
 				master * 0x200 + queue * 0x100);
 			read_val += 1;
-			msm_camera_io_w_mb(read_val, cci_dev->base +
-				CCI_I2C_M0_Q0_EXEC_WORD_CNT_ADDR + reg_offset);
 		}
+		msm_camera_io_w_mb(read_val, cci_dev->base +
+			CCI_I2C_M0_Q0_EXEC_WORD_CNT_ADDR + reg_offset);
 	}
 
 	rc = msm_cci_transfer_end(cci_dev, master, queue);
@@ -613,6 +613,17 @@ static int eeprom_config_read_cal_data(struct msm_eeprom_ctrl_t *e_ctrl,
 	return rc;
 }
 
+/*
+ * Kernel-probed EEPROMs are read once, asynchronously, at boot and the
+ * calibration is kept for the lifetime of the device; wait here for that
+ * read before answering any query about it.
+ */
+static void msm_eeprom_wait_cal_data(struct msm_eeprom_ctrl_t *e_ctrl)
+{
+	if (e_ctrl->userspace_probe == 0)
+		async_synchronize_full_domain(&msm_camera_probe_domain);
+}
+
 static int msm_eeprom_config(struct msm_eeprom_ctrl_t *e_ctrl,
 	void __user *argp)
 {
@@ -621,6 +632,7 @@ static int msm_eeprom_config(struct msm_eeprom_ctrl_t *e_ctrl,
 	int rc = 0;
 
 	CDBG("%s E\n", __func__);
+	msm_eeprom_wait_cal_data(e_ctrl);
 	switch (cdata->cfgtype) {
 	case CFG_EEPROM_GET_INFO:
 		if (e_ctrl->userspace_probe == 1) {
@@ -1453,6 +1465,7 @@ static int msm_eeprom_config32(struct msm_eeprom_ctrl_t *e_ctrl,
 	int rc = 0;
 
 	CDBG("%s E\n", __func__);
+	msm_eeprom_wait_cal_data(e_ctrl);
 	switch (cdata->cfgtype) {
 	case CFG_EEPROM_GET_INFO:
 		if (e_ctrl->userspace_probe == 1) {
@@ -1538,10 +1551,60 @@ static long msm_eeprom_subdev_fops_ioctl32(struct file *file, unsigned int cmd,
 
 #endif
 
+/*
+ * Power the module, read and check the calibration map, and power it
+ * down again.  This runs off the probe path so that EEPROMs on different
+ * modules, and the rest of the boot, proceed concurrently.
+ */
+static void msm_eeprom_read_cal_async(void *data, async_cookie_t cookie)
+{
+	struct msm_eeprom_ctrl_t *e_ctrl = data;
+	struct msm_camera_power_ctrl_t *power_info =
+		&e_ctrl->eboard_info->power_info;
+	uint8_t is_supported;
+	int rc, j;
+
+	rc = msm_camera_power_up(power_info, e_ctrl->eeprom_device_type,
+		&e_ctrl->i2c_client);
+	if (rc) {
+		pr_err("failed rc %d\n", rc);
+		goto memdata_free;
+	}
+	rc = read_eeprom_memory(e_ctrl, &e_ctrl->cal_data);
+	if (rc < 0) {
+		pr_err("%s read_eeprom_memory failed\n", __func__);
+		msm_camera_power_down(power_info, e_ctrl->eeprom_device_type,
+			&e_ctrl->i2c_client);
+		goto memdata_free;
+	}
+	for (j = 0; j < e_ctrl->cal_data.num_data; j++)
+		CDBG("memory_data[%d] = 0x%X\n", j,
+			e_ctrl->cal_data.mapdata[j]);
+
+	is_supported = msm_eeprom_match_crc(&e_ctrl->cal_data);
+
+	rc = msm_camera_power_down(power_info,
+		e_ctrl->eeprom_device_type, &e_ctrl->i2c_client);
+	if (rc) {
+		pr_err("failed rc %d\n", rc);
+		goto memdata_free;
+	}
+	e_ctrl->is_supported = (is_supported << 1) | 1;
+	return;
+
+memdata_free:
+	/* report the EEPROM as unsupported rather than half read */
+	kfree(e_ctrl->cal_data.mapdata);
+	kfree(e_ctrl->cal_data.map);
+	e_ctrl->cal_data.mapdata = NULL;
+	e_ctrl->cal_data.map = NULL;
+	e_ctrl->cal_data.num_data = 0;
+	e_ctrl->is_supported = 0;
+}
+
 static int msm_eeprom_platform_probe(struct platform_device *pdev)
 {
 	int rc = 0;
-	int j = 0;
 	uint32_t temp;
 
 	struct msm_camera_cci_client *cci_client = NULL;
@@ -1662,32 +1725,7 @@ static int msm_eeprom_platform_probe(struct platform_device *pdev)
 		rc = msm_eeprom_parse_memory_map(of_node, &e_ctrl->cal_data);
 		if (rc < 0)
 			goto board_free;
-
-		rc = msm_camera_power_up(power_info, e_ctrl->eeprom_device_type,
-			&e_ctrl->i2c_client);
-		if (rc) {
-			pr_err("failed rc %d\n", rc);
-			goto memdata_free;
-		}
-		rc = read_eeprom_memory(e_ctrl, &e_ctrl->cal_data);
-		if (rc < 0) {
-			pr_err("%s read_eeprom_memory failed\n", __func__);
-			goto power_down;
-		}
-		for (j = 0; j < e_ctrl->cal_data.num_data; j++)
-			CDBG("memory_data[%d] = 0x%X\n", j,
-				e_ctrl->cal_data.mapdata[j]);
-
-		e_ctrl->is_supported |= msm_eeprom_match_crc(&e_ctrl->cal_data);
-
-		rc = msm_camera_power_down(power_info,
-			e_ctrl->eeprom_device_type, &e_ctrl->i2c_client);
-		if (rc) {
-			pr_err("failed rc %d\n", rc);
-			goto memdata_free;
-		}
-	} else
-		e_ctrl->is_supported = 1;
+	}
 
 	v4l2_subdev_init(&e_ctrl->msm_sd.sd,
 		e_ctrl->eeprom_v4l2_subdev_ops);
@@ -1709,16 +1747,14 @@ static int msm_eeprom_platform_probe(struct platform_device *pdev)
 	e_ctrl->msm_sd.sd.devnode->fops = &msm_eeprom_v4l2_subdev_fops;
 #endif
 
-	e_ctrl->is_supported = (e_ctrl->is_supported << 1) | 1;
+	if (e_ctrl->userspace_probe == 0)
+		async_schedule_domain(msm_eeprom_read_cal_async, e_ctrl,
+			&msm_camera_probe_domain);
+	else
+		e_ctrl->is_supported = (1 << 1) | 1;
 	CDBG("%s X\n", __func__);
 	return rc;
 
-power_down:
-	msm_camera_power_down(power_info, e_ctrl->eeprom_device_type,
-		&e_ctrl->i2c_client);
-memdata_free:
-	kfree(e_ctrl->cal_data.mapdata);
-	kfree(e_ctrl->cal_data.map);
 board_free:
 	kfree(e_ctrl->eboard_info);
 cciclient_free:
@@ -1742,6 +1778,7 @@ static int msm_eeprom_platform_remove(struct platform_device *pdev)
 		return 0;
 	}
 
+	msm_eeprom_wait_cal_data(e_ctrl);
 	kfree(e_ctrl->i2c_client.cci_client);
 	kfree(e_ctrl->cal_data.mapdata);
 	kfree(e_ctrl->cal_data.map);
@@ -21,6 +21,7 @@
 #define I2C_COMPARE_MATCH 0
 #define I2C_COMPARE_MISMATCH 1
 #define I2C_POLL_MAX_ITERATION 20
+#define I2C_CONF_TBL_BATCH 16
 
 int32_t msm_camera_cci_i2c_read(struct msm_camera_i2c_client *client,
 	uint32_t addr, uint16_t *data,
@@ -306,7 +307,8 @@ int32_t msm_camera_cci_i2c_write_table_w_microdelay(
 	if ((client->addr_type != MSM_CAMERA_I2C_BYTE_ADDR
 		&& client->addr_type != MSM_CAMERA_I2C_WORD_ADDR)
 		|| (write_setting->data_type != MSM_CAMERA_I2C_BYTE_DATA
-		&& write_setting->data_type != MSM_CAMERA_I2C_WORD_DATA))
+		&& write_setting->data_type != MSM_CAMERA_I2C_WORD_DATA
+		&& write_setting->data_type != MSM_CAMERA_I2C_DWORD_DATA))
 		return rc;
 
 	cci_ctrl.cmd = MSM_CCI_I2C_WRITE;
@@ -331,30 +333,18 @@ int32_t msm_camera_cci_i2c_write_table_w_microdelay_htc(
 	struct msm_camera_i2c_reg_setting *write_setting)
 {
 	int32_t rc = -EFAULT;
-	int i;
-	struct msm_camera_i2c_seq_reg_array reg_setting;
 
 	if (!client || !write_setting)
 		return rc;
 
-	if (client->addr_type == MSM_CAMERA_I2C_WORD_ADDR && write_setting->data_type == MSM_CAMERA_I2C_DWORD_DATA) {
-		for (i=0; i<write_setting->size; i++) {
-			reg_setting.reg_addr = write_setting->reg_setting[i].reg_addr;
-			reg_setting.reg_data[0] = 0;
-			reg_setting.reg_data[1] = 0;
-			reg_setting.reg_data[2] = (uint8_t)((write_setting->reg_setting[i].reg_data & 0xFF00) >> 8);
-			reg_setting.reg_data[3] = (uint8_t)(write_setting->reg_setting[i].reg_data & 0x00FF);
-			reg_setting.reg_data_size = 4;
-			rc = msm_camera_cci_i2c_write_seq(client, reg_setting.reg_addr, reg_setting.reg_data, reg_setting.reg_data_size);
-			if (rc < 0) {
-				pr_err("i2c write sequence error:%d\n", rc);
-				return rc;
-			}
-		}
-		return rc;
-	} else {
-		rc = msm_camera_cci_i2c_write_table_w_microdelay(client, write_setting);
-	}
+	/*
+	 * DWORD tables used to go out one write_seq transaction per entry;
+	 * the CCI queue packs them natively now, so the whole table is
+	 * issued with a single completion wait.
+	 */
+	rc = msm_camera_cci_i2c_write_table_w_microdelay(client, write_setting);
+	if (rc < 0)
+		pr_err("i2c write table error:%d\n", rc);
 
 	return rc;
 }
@@ -485,6 +475,40 @@ static int32_t msm_camera_cci_i2c_set_write_mask_data(
 	return rc;
 }
 
+/*
+ * Issue a run of plain writes with the same data type from a conf table
+ * as one CCI table, so the queue can pack consecutive addresses and the
+ * caller waits for completion once per run instead of once per entry.
+ */
+static int32_t msm_camera_cci_i2c_write_conf_run(
+	struct msm_camera_i2c_client *client,
+	struct msm_camera_i2c_reg_conf *reg_conf_tbl, uint16_t size,
+	enum msm_camera_i2c_data_type data_type,
+	enum msm_camera_i2c_data_type dt, uint16_t *written)
+{
+	struct msm_camera_i2c_reg_array reg_array[I2C_CONF_TBL_BATCH];
+	struct msm_camera_i2c_reg_setting setting = {
+		.reg_setting = reg_array,
+		.addr_type = client->addr_type,
+		.data_type = dt,
+	};
+	uint16_t i;
+
+	for (i = 0; i < size && i < I2C_CONF_TBL_BATCH; i++) {
+		if (reg_conf_tbl[i].cmd_type == MSM_CAMERA_I2C_CMD_POLL ||
+			(reg_conf_tbl[i].dt ? reg_conf_tbl[i].dt : data_type)
+			!= dt)
+			break;
+		reg_array[i].reg_addr = reg_conf_tbl[i].reg_addr;
+		reg_array[i].reg_data = reg_conf_tbl[i].reg_data;
+		reg_array[i].delay = 0;
+	}
+	setting.size = i;
+	*written = i;
+
+	return msm_camera_cci_i2c_write_table_w_microdelay(client, &setting);
+}
+
 int32_t msm_camera_cci_i2c_write_conf_tbl(
 	struct msm_camera_i2c_client *client,
 	struct msm_camera_i2c_reg_conf *reg_conf_tbl, uint16_t size,
@@ -492,6 +516,7 @@ int32_t msm_camera_cci_i2c_write_conf_tbl(
 {
 	int i;
 	int32_t rc = -EFAULT;
+	uint16_t written;
 	for (i = 0; i < size; i++) {
 		enum msm_camera_i2c_data_type dt;
 		if (reg_conf_tbl->cmd_type == MSM_CAMERA_I2C_CMD_POLL) {
@@ -507,10 +532,11 @@ int32_t msm_camera_cci_i2c_write_conf_tbl(
 			switch (dt) {
 			case MSM_CAMERA_I2C_BYTE_DATA:
 			case MSM_CAMERA_I2C_WORD_DATA:
-				rc = msm_camera_cci_i2c_write(
-					client,
-					reg_conf_tbl->reg_addr,
-					reg_conf_tbl->reg_data, dt);
+				rc = msm_camera_cci_i2c_write_conf_run(client,
+					reg_conf_tbl, size - i, data_type, dt,
+					&written);
+				i += written - 1;
+				reg_conf_tbl += written - 1;
 				break;
 			case MSM_CAMERA_I2C_SET_BYTE_MASK:
 				rc = msm_camera_cci_i2c_set_mask(client,
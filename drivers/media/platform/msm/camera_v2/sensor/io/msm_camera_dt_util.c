@@ -24,6 +24,9 @@
 #undef CDBG
 #define CDBG(fmt, args...) pr_info("[CAM]"fmt, ##args)
 
+ASYNC_DOMAIN_EXCLUSIVE(msm_camera_probe_domain);
+EXPORT_SYMBOL(msm_camera_probe_domain);
+
 int msm_camera_fill_vreg_params(struct camera_vreg_t *cam_vreg,
 	int num_vreg, struct msm_sensor_power_setting *power_setting,
 	uint16_t power_setting_size)
@@ -16,6 +16,7 @@
 #include <soc/qcom/camera2.h>
 #include <linux/gpio.h>
 #include <linux/of.h>
+#include <linux/async.h>
 #include "msm_camera_i2c.h"
 
 #define INVALID_VREG 100
@@ -56,4 +57,11 @@ int msm_camera_fill_vreg_params(struct camera_vreg_t *cam_vreg,
 	int num_vreg, struct msm_sensor_power_setting *power_setting,
 	uint16_t power_setting_size);
 
+/*
+ * Sub-module work that powers a camera module on its own at boot (EEPROM
+ * calibration reads) runs in this domain; sensor probe and the sub-module
+ * ioctls synchronize against it before touching the same rails.
+ */
+extern struct async_domain msm_camera_probe_domain;
+
 #endif
@@ -64,24 +64,21 @@ int htc_ois_FWupdate(struct msm_sensor_ctrl_t *s_ctrl)
 {
 	int rc = -1;
 	uint16_t cci_client_sid_backup;
-    static int m_first = 0;
-    static int f_first = 0;
+	/* one firmware check per camera id, not one per power up */
+	static unsigned long fw_checked;
     pr_info("%s:E s_ctrl->id = %d.\n", __func__, s_ctrl->id);
 
+	if (s_ctrl->id >= BITS_PER_LONG ||
+		test_and_set_bit(s_ctrl->id, &fw_checked))
+		return 0;
+
 	
 	cci_client_sid_backup = s_ctrl->sensor_i2c_client->cci_client->sid;
 
 	
 	s_ctrl->sensor_i2c_client->cci_client->sid = OIS_COMPONENT_I2C_ADDR_WRITE >> 1;
 
-    if (m_first ==0||f_first==0)
-    {
-        rc = htc_checkFWUpdate(s_ctrl);
-        if (s_ctrl->id ==0)
-            m_first = 1;
-        if (s_ctrl->id ==1)
-            f_first = 1;
-    }
+	rc = htc_checkFWUpdate(s_ctrl);
 
 	
 	s_ctrl->sensor_i2c_client->cci_client->sid = cci_client_sid_backup;
@@ -891,6 +891,9 @@ int32_t msm_sensor_driver_probe(void *setting,
 	unsigned long                        mount_pos = 0;
 	uint32_t                             is_yuv;
 
+	/* boot-time EEPROM reads may still be using this module's rails */
+	async_synchronize_full_domain(&msm_camera_probe_domain);
+
 	
 	if (!setting) {
 		pr_err("failed: slave_info %p", setting);
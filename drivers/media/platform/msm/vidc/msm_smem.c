@@ -18,17 +18,36 @@
 #include <linux/iommu.h>
 #include <linux/msm_dma_iommu_mapping.h>
 #include <linux/msm_ion.h>
+#include <linux/mutex.h>
 #include <linux/slab.h>
 #include <linux/types.h>
 #include "media/msm_vidc.h"
 #include "msm_vidc_debug.h"
 #include "msm_vidc_resources.h"
 
+/* Number of unused client buffer mappings kept per smem client */
+#define SMEM_MAP_CACHE_MAX_IDLE 32
+
 struct smem_client {
 	int mem_type;
 	void *clnt;
 	struct msm_vidc_platform_resources *res;
 	enum session_type session_type;
+	struct mutex map_cache_lock;
+	struct list_head map_cache;
+	int map_cache_idle;
+};
+
+/*
+ * A client buffer mapping that outlives the msm_smem it was created for,
+ * so that mapping the same dma-buf again (e.g. a dynamic output buffer
+ * coming back from display) does not go through ION and the IOMMU.
+ */
+struct smem_map_cache_entry {
+	struct list_head list;
+	struct dma_buf *dma_buf;
+	struct msm_smem mem;
+	int refcount;
 };
 
 static int get_device_address(struct smem_client *smem_client,
@@ -430,6 +449,131 @@ static void ion_delete_client(struct smem_client *client)
 	ion_client_destroy(client->clnt);
 }
 
+static bool smem_map_cache_get(struct smem_client *client, int fd,
+		enum hal_buffer buffer_type, struct msm_smem *mem)
+{
+	struct smem_map_cache_entry *entry;
+	struct dma_buf *dma_buf;
+	bool found = false;
+
+	dma_buf = dma_buf_get(fd);
+	if (IS_ERR_OR_NULL(dma_buf))
+		return false;
+
+	mutex_lock(&client->map_cache_lock);
+	list_for_each_entry(entry, &client->map_cache, list) {
+		if (entry->dma_buf != dma_buf ||
+			entry->mem.buffer_type != buffer_type)
+			continue;
+
+		if (!entry->refcount++)
+			client->map_cache_idle--;
+		/* Most recently used entries are kept at the head */
+		list_move(&entry->list, &client->map_cache);
+		*mem = entry->mem;
+		found = true;
+		break;
+	}
+	mutex_unlock(&client->map_cache_lock);
+
+	dma_buf_put(dma_buf);
+
+	if (found)
+		dprintk(VIDC_DBG, "%s: reusing mapping of fd %d at %pa\n",
+				__func__, fd, &mem->device_addr);
+	return found;
+}
+
+static void smem_map_cache_add(struct smem_client *client, int fd,
+		struct msm_smem *mem)
+{
+	struct smem_map_cache_entry *entry;
+
+	entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+	if (!entry)
+		return;
+
+	entry->dma_buf = dma_buf_get(fd);
+	if (IS_ERR_OR_NULL(entry->dma_buf)) {
+		kfree(entry);
+		return;
+	}
+
+	entry->mem = *mem;
+	entry->refcount = 1;
+
+	mutex_lock(&client->map_cache_lock);
+	list_add(&entry->list, &client->map_cache);
+	mutex_unlock(&client->map_cache_lock);
+}
+
+static void smem_map_cache_release(struct smem_client *client,
+		struct smem_map_cache_entry *entry)
+{
+	list_del(&entry->list);
+	free_ion_mem(client, &entry->mem);
+	dma_buf_put(entry->dma_buf);
+	kfree(entry);
+}
+
+/*
+ * Drops a reference on the cached mapping backing @mem.  Returns false if
+ * @mem is not a cached mapping and still has to be freed by the caller.
+ */
+static bool smem_map_cache_put(struct smem_client *client,
+		struct msm_smem *mem)
+{
+	struct smem_map_cache_entry *entry, *temp;
+	bool found = false;
+
+	mutex_lock(&client->map_cache_lock);
+	list_for_each_entry(entry, &client->map_cache, list) {
+		if (entry->mem.smem_priv != mem->smem_priv)
+			continue;
+
+		if (!--entry->refcount)
+			client->map_cache_idle++;
+		found = true;
+		break;
+	}
+
+	/* Trim the least recently used idle mappings */
+	list_for_each_entry_safe_reverse(entry, temp, &client->map_cache,
+			list) {
+		if (client->map_cache_idle <= SMEM_MAP_CACHE_MAX_IDLE)
+			break;
+		if (entry->refcount)
+			continue;
+
+		smem_map_cache_release(client, entry);
+		client->map_cache_idle--;
+	}
+	mutex_unlock(&client->map_cache_lock);
+
+	return found;
+}
+
+void msm_smem_flush_map_cache(void *clt)
+{
+	struct smem_client *client = clt;
+	struct smem_map_cache_entry *entry, *temp;
+
+	if (!client) {
+		dprintk(VIDC_ERR, "Invalid  client passed\n");
+		return;
+	}
+
+	mutex_lock(&client->map_cache_lock);
+	list_for_each_entry_safe(entry, temp, &client->map_cache, list) {
+		if (entry->refcount)
+			continue;
+
+		smem_map_cache_release(client, entry);
+		client->map_cache_idle--;
+	}
+	mutex_unlock(&client->map_cache_lock);
+}
+
 struct msm_smem *msm_smem_user_to_kernel(void *clt, int fd, u32 offset,
 		enum hal_buffer buffer_type)
 {
@@ -447,7 +591,12 @@ struct msm_smem *msm_smem_user_to_kernel(void *clt, int fd, u32 offset,
 	}
 	switch (client->mem_type) {
 	case SMEM_ION:
+		if (smem_map_cache_get(client, fd, buffer_type, mem))
+			break;
+
 		rc = ion_user_to_kernel(clt, fd, offset, mem, buffer_type);
+		if (!rc)
+			smem_map_cache_add(client, fd, mem);
 		break;
 	default:
 		dprintk(VIDC_ERR, "Mem type not supported\n");
@@ -555,6 +704,8 @@ void *msm_smem_new_client(enum smem_type mtype,
 			client->clnt = clnt;
 			client->res = res;
 			client->session_type = stype;
+			mutex_init(&client->map_cache_lock);
+			INIT_LIST_HEAD(&client->map_cache);
 		}
 	} else {
 		dprintk(VIDC_ERR, "Failed to create new client: mtype = %d\n",
@@ -611,7 +762,8 @@ void msm_smem_free(void *clt, struct msm_smem *mem)
 	}
 	switch (client->mem_type) {
 	case SMEM_ION:
-		free_ion_mem(client, mem);
+		if (!smem_map_cache_put(client, mem))
+			free_ion_mem(client, mem);
 		break;
 	default:
 		dprintk(VIDC_ERR, "Mem type not supported\n");
@@ -627,6 +779,11 @@ void msm_smem_delete_client(void *clt)
 		dprintk(VIDC_ERR, "Invalid  client passed\n");
 		return;
 	}
+
+	msm_smem_flush_map_cache(client);
+	if (!list_empty(&client->map_cache))
+		dprintk(VIDC_WARN, "%s: mappings still in use\n", __func__);
+
 	switch (client->mem_type) {
 	case SMEM_ION:
 		ion_delete_client(client);
@@ -796,6 +796,9 @@ free_and_unmap:
 		}
 	}
 	mutex_unlock(&inst->registeredbufs.lock);
+
+	/* The client may free these buffers now, drop the cached mappings */
+	msm_comm_smem_flush_map_cache(inst);
 	return rc;
 }
 EXPORT_SYMBOL(msm_vidc_release_buffers);
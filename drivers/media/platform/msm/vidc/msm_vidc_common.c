@@ -1923,6 +1923,10 @@ static void handle_fbd(enum hal_command_response cmd, void *data)
 	}
 
 	if (vb) {
+		if (inst->session_type == MSM_VIDC_ENCODER)
+			msm_dcvs_record_frame_size(inst,
+					fill_buf_done->filled_len1);
+
 		vb->v4l2_planes[0].bytesused = fill_buf_done->filled_len1;
 		vb->v4l2_planes[0].data_offset = fill_buf_done->offset1;
 		vb->v4l2_planes[0].reserved[2] = fill_buf_done->start_x_coord;
@@ -2205,6 +2209,9 @@ int msm_comm_scale_clocks_load(struct msm_vidc_core *core,
 
 		if (inst->dcvs_mode)
 			clk_scale_data.load[num_sessions] = inst->dcvs.load;
+		else if (msm_vidc_dcvs_content_mode && inst->dcvs.content_load)
+			clk_scale_data.load[num_sessions] =
+				inst->dcvs.content_load;
 		else
 			clk_scale_data.load[num_sessions] =
 				msm_comm_get_inst_load(inst, quirks);
@@ -3541,11 +3548,14 @@ static void log_frame(struct msm_vidc_inst *inst, struct vidc_frame_data *data,
 
 		if (msm_vidc_bitrate_clock_scaling &&
 			inst->session_type == MSM_VIDC_DECODER &&
-			!inst->dcvs_mode)
+			!inst->dcvs_mode && !msm_vidc_dcvs_content_mode)
 				inst->instant_bitrate =
 					data->filled_len * 8 * inst->prop.fps;
 		else
 			inst->instant_bitrate = 0;
+
+		if (inst->session_type == MSM_VIDC_DECODER)
+			msm_dcvs_record_frame_size(inst, data->filled_len);
 	} else if (type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) {
 		dprintk(VIDC_DBG,
 				"Sending ftb (%pa) to hal: size: %d, ts: %lld, flags = %#x\n",
@@ -3558,6 +3568,7 @@ static void log_frame(struct msm_vidc_inst *inst, struct vidc_frame_data *data,
 			type == V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE);
 
 	if (msm_vidc_bitrate_clock_scaling && !inst->dcvs_mode &&
+		!msm_vidc_dcvs_content_mode &&
 		type == V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE &&
 		inst->session_type == MSM_VIDC_DECODER)
 		if (msm_comm_scale_clocks(inst->core))
@@ -3747,6 +3758,39 @@ int msm_comm_qbuf(struct msm_vidc_inst *inst, struct vb2_buffer *vb)
 		}
 	}
 
+	/*
+	 * Several pending buffers flushed together in non-batch mode are
+	 * written to the cmdq in one go so that firmware is only interrupted
+	 * once.  Sequence header requests must stay between the ETBs and the
+	 * FTBs, so those still go one at a time below.
+	 */
+	if (!batch_mode && etbs.count + ftbs.count > 1 &&
+			!atomic_read(&inst->seq_hdr_reqs) &&
+			hdev->session_queue_buffers) {
+		int c = 0;
+
+		rc = call_hfi_op(hdev, session_queue_buffers, inst->session,
+				etbs.count, etbs.data, ftbs.count, ftbs.data);
+		if (rc) {
+			dprintk(VIDC_ERR,
+				"Failed to queue %d ETBs and %d FTBs\n",
+				etbs.count, ftbs.count);
+			goto err_bad_input;
+		}
+
+		for (c = 0; c < etbs.count; ++c) {
+			log_frame(inst, &etbs.data[c],
+					V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE);
+		}
+
+		for (c = 0; c < ftbs.count; ++c) {
+			log_frame(inst, &ftbs.data[c],
+					V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE);
+		}
+
+		etbs.count = ftbs.count = 0;
+	}
+
 	if (!batch_mode && etbs.count) {
 		int c = 0;
 
@@ -4916,6 +4960,15 @@ void msm_comm_smem_free(struct msm_vidc_inst *inst, struct msm_smem *mem)
 	msm_smem_free(inst->mem_client, mem);
 }
 
+void msm_comm_smem_flush_map_cache(struct msm_vidc_inst *inst)
+{
+	if (!inst) {
+		dprintk(VIDC_ERR, "%s: invalid inst: %p\n", __func__, inst);
+		return;
+	}
+	msm_smem_flush_map_cache(inst->mem_client);
+}
+
 int msm_comm_smem_cache_operations(struct msm_vidc_inst *inst,
 		struct msm_smem *mem, enum smem_cache_ops cache_ops)
 {
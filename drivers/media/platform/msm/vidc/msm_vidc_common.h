@@ -73,6 +73,7 @@ struct msm_smem *msm_comm_smem_alloc(struct msm_vidc_inst *inst,
 			size_t size, u32 align, u32 flags,
 			enum hal_buffer buffer_type, int map_kernel);
 void msm_comm_smem_free(struct msm_vidc_inst *inst, struct msm_smem *mem);
+void msm_comm_smem_flush_map_cache(struct msm_vidc_inst *inst);
 int msm_comm_smem_cache_operations(struct msm_vidc_inst *inst,
 		struct msm_smem *mem, enum smem_cache_ops cache_ops);
 struct msm_smem *msm_comm_smem_user_to_kernel(struct msm_vidc_inst *inst,
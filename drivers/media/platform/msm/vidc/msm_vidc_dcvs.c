@@ -11,6 +11,7 @@
  *
  */
 
+#include <asm/div64.h>
 #include "msm_vidc_common.h"
 #include "vidc_hfi_api.h"
 #include "msm_vidc_debug.h"
@@ -23,6 +24,7 @@ static bool msm_dcvs_check_supported(struct msm_vidc_inst *inst);
 static bool msm_dcvs_enc_check(struct msm_vidc_inst *inst);
 static int msm_dcvs_enc_scale_clocks(struct msm_vidc_inst *inst);
 static int msm_dcvs_dec_scale_clocks(struct msm_vidc_inst *inst, bool fbd);
+static void msm_dcvs_content_scale_clocks(struct msm_vidc_core *core);
 
 static inline int msm_dcvs_get_mbs_per_frame(struct msm_vidc_inst *inst)
 {
@@ -166,6 +168,116 @@ void msm_dcvs_check_and_scale_clocks(struct msm_vidc_inst *inst, bool is_etb)
 		msm_dcvs_enc_check_and_scale_clocks(inst);
 	else
 		msm_dcvs_dec_check_and_scale_clocks(inst);
+
+	/*
+	 * Sessions that the buffer based algorithm gave up on (e.g. because
+	 * several of them are running) are scaled together from their
+	 * content instead.
+	 */
+	if (msm_vidc_dcvs_content_mode && !inst->dcvs_mode)
+		msm_dcvs_content_scale_clocks(inst->core);
+}
+
+void msm_dcvs_record_frame_size(struct msm_vidc_inst *inst, u32 bytes)
+{
+	struct dcvs_stats *dcvs;
+
+	if (!inst) {
+		dprintk(VIDC_ERR, "%s Invalid args: %p\n", __func__, inst);
+		return;
+	}
+
+	if (!msm_vidc_dcvs_content_mode || !bytes)
+		return;
+
+	dcvs = &inst->dcvs;
+	dcvs->frame_bytes[dcvs->frame_bytes_index] = bytes;
+	dcvs->frame_bytes_index =
+		(dcvs->frame_bytes_index + 1) % DCVS_FTB_WINDOW;
+
+	if (dcvs->frame_bytes_count < DCVS_FTB_WINDOW)
+		dcvs->frame_bytes_count++;
+}
+
+/*
+ * Predicts the load of a session from the size of its last compressed
+ * frames.  Part of the work is done per MB whatever the content is, the
+ * rest (mostly entropy coding) grows with the number of bits, so simple
+ * content can be processed with less than the nominal load.
+ */
+static int msm_dcvs_get_content_load(struct msm_vidc_inst *inst)
+{
+	struct dcvs_stats *dcvs = &inst->dcvs;
+	int load, num_mbs_per_frame, i, pct;
+	u64 bits = 0;
+
+	load = msm_comm_get_inst_load(inst, LOAD_CALC_NO_QUIRKS);
+	num_mbs_per_frame = msm_dcvs_get_mbs_per_frame(inst);
+
+	if (!load || !num_mbs_per_frame || msm_comm_turbo_session(inst) ||
+		dcvs->frame_bytes_count < DCVS_FTB_WINDOW)
+		return load;
+
+	for (i = 0; i < DCVS_FTB_WINDOW; i++)
+		bits += dcvs->frame_bytes[i];
+
+	bits *= 8 * (100 - DCVS_CONTENT_MIN_PCT);
+	do_div(bits, DCVS_FTB_WINDOW * num_mbs_per_frame *
+			DCVS_CONTENT_NOMINAL_BITS_PER_MB);
+	pct = min_t(u64, DCVS_CONTENT_MIN_PCT + bits, 100);
+
+	dprintk(VIDC_PROF, "DCVS: %p content load %d%% of %d\n",
+			inst, pct, load);
+
+	return load * pct / 100;
+}
+
+/*
+ * Sums the predicted load of every session on the core and rescales the
+ * clocks, but only once one of them has moved past the hysteresis so
+ * that the clock rate is not touched on every frame.
+ */
+static void msm_dcvs_content_scale_clocks(struct msm_vidc_core *core)
+{
+	struct msm_vidc_inst *temp = NULL;
+	bool rescale = false;
+	int total_load = 0, rc = 0;
+
+	if (!core) {
+		dprintk(VIDC_ERR, "%s Invalid args: %p\n", __func__, core);
+		return;
+	}
+
+	mutex_lock(&core->lock);
+	list_for_each_entry(temp, &core->instances, list) {
+		int load = msm_dcvs_get_content_load(temp);
+		int delta = abs(load - temp->dcvs.content_load);
+
+		if (delta * 100 >
+			temp->dcvs.content_load * DCVS_CONTENT_HYSTERESIS_PCT)
+			rescale = true;
+	}
+
+	if (rescale) {
+		list_for_each_entry(temp, &core->instances, list) {
+			temp->dcvs.content_load =
+				msm_dcvs_get_content_load(temp);
+			total_load += temp->dcvs.content_load;
+		}
+	}
+	mutex_unlock(&core->lock);
+
+	if (!rescale)
+		return;
+
+	dprintk(VIDC_PROF, "DCVS: content load of all sessions %d\n",
+			total_load);
+
+	rc = msm_comm_scale_clocks_load(core, total_load,
+			LOAD_CALC_NO_QUIRKS);
+	if (rc)
+		dprintk(VIDC_ERR, "%s: Failed to scale clocks: %d\n",
+				__func__, rc);
 }
 
 static inline int get_pending_bufs_fw(struct msm_vidc_inst *inst)
@@ -222,6 +334,8 @@ void msm_dcvs_init_load(struct msm_vidc_inst *inst)
 	dcvs = &inst->dcvs;
 	res = &core->resources;
 	dcvs->load = msm_comm_get_inst_load(inst, LOAD_CALC_NO_QUIRKS);
+	dcvs->frame_bytes_count = 0;
+	dcvs->content_load = 0;
 
 	num_rows = res->dcvs_tbl_size;
 	table = res->dcvs_tbl;
@@ -31,6 +31,13 @@
 /* Considering one safeguard buffer */
 #define DCVS_BUFFER_SAFEGUARD (DCVS_DEC_EXTRA_OUTPUT_BUFFERS - 1)
 
+/* Share of the nominal load that is spent regardless of content */
+#define DCVS_CONTENT_MIN_PCT 60
+/* Compressed bits per MB at which a session needs its nominal load */
+#define DCVS_CONTENT_NOMINAL_BITS_PER_MB 64
+/* Change in predicted load (in percent) needed to rescale the clocks */
+#define DCVS_CONTENT_HYSTERESIS_PCT 10
+
 void msm_dcvs_init(struct msm_vidc_inst *inst);
 void msm_dcvs_init_load(struct msm_vidc_inst *inst);
 void msm_dcvs_monitor_buffer(struct msm_vidc_inst *inst);
@@ -38,4 +45,5 @@ void msm_dcvs_check_and_scale_clocks(struct msm_vidc_inst *inst, bool is_etb);
 int  msm_dcvs_get_extra_buff_count(struct msm_vidc_inst *inst);
 void msm_dcvs_enc_set_power_save_mode(struct msm_vidc_inst *inst,
 		bool is_power_save_mode);
+void msm_dcvs_record_frame_size(struct msm_vidc_inst *inst, u32 bytes);
 #endif
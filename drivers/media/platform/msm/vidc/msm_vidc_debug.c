@@ -25,6 +25,7 @@ int msm_vidc_fw_coverage = 0;
 int msm_vidc_vpe_csc_601_to_709 = 0;
 int msm_vidc_dec_dcvs_mode = 1;
 int msm_vidc_enc_dcvs_mode = 1;
+int msm_vidc_dcvs_content_mode = 0;
 int msm_vidc_sys_idle_indicator = 0;
 int msm_vidc_firmware_unload_delay = 15000;
 int msm_vidc_thermal_mitigation_disabled = 0;
@@ -167,6 +168,8 @@ struct dentry *msm_vidc_debugfs_init_drv(void)
 	__debugfs_create(bool, "fw_coverage", &msm_vidc_fw_coverage) &&
 	__debugfs_create(bool, "dcvs_dec_mode", &msm_vidc_dec_dcvs_mode) &&
 	__debugfs_create(bool, "dcvs_enc_mode", &msm_vidc_enc_dcvs_mode) &&
+	__debugfs_create(bool, "dcvs_content_mode",
+			&msm_vidc_dcvs_content_mode) &&
 	__debugfs_create(u32, "fw_low_power_mode",
 			&msm_vidc_fw_low_power_mode) &&
 	__debugfs_create(u32, "debug_output", &msm_vidc_debug_out) &&
@@ -62,6 +62,7 @@ extern int msm_vidc_fw_coverage;
 extern int msm_vidc_vpe_csc_601_to_709;
 extern int msm_vidc_dec_dcvs_mode;
 extern int msm_vidc_enc_dcvs_mode;
+extern int msm_vidc_dcvs_content_mode;
 extern int msm_vidc_sys_idle_indicator;
 extern int msm_vidc_firmware_unload_delay;
 extern int msm_vidc_thermal_mitigation_disabled;
@@ -201,6 +201,10 @@ struct dcvs_stats {
 	int etb_counter;
 	bool is_power_save_mode;
 	u32 supported_codecs;
+	int frame_bytes[DCVS_FTB_WINDOW];
+	int frame_bytes_index;
+	int frame_bytes_count;
+	int content_load;
 };
 
 struct profile_data {
@@ -359,6 +363,7 @@ struct msm_smem *msm_smem_alloc(void *clt, size_t size, u32 align, u32 flags,
 		enum hal_buffer buffer_type, int map_kernel);
 void msm_smem_free(void *clt, struct msm_smem *mem);
 void msm_smem_delete_client(void *clt);
+void msm_smem_flush_map_cache(void *clt);
 int msm_smem_cache_operations(void *clt, struct msm_smem *mem,
 		enum smem_cache_ops);
 struct msm_smem *msm_smem_user_to_kernel(void *clt, int fd, u32 offset,
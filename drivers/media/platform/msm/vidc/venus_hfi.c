@@ -27,6 +27,7 @@
 #include <linux/regulator/consumer.h>
 #include <linux/slab.h>
 #include <linux/workqueue.h>
+#include <soc/qcom/lpm-sync.h>
 #include <soc/qcom/scm.h>
 #include <soc/qcom/smem.h>
 #include <soc/qcom/subsystem_restart.h>
@@ -2991,6 +2992,60 @@ err_etbs_and_ftbs:
 	return rc;
 }
 
+/*
+ * Queues a set of ETBs and FTBs back to back and raises a single interrupt
+ * once all of them are in the cmdq, rather than one per buffer.  Unlike
+ * venus_hfi_session_process_batch() no sync packet is sent, so firmware
+ * processes the buffers as if they had been queued individually.
+ */
+static int venus_hfi_session_queue_buffers(void *sess,
+		int num_etbs, struct vidc_frame_data etbs[],
+		int num_ftbs, struct vidc_frame_data ftbs[])
+{
+	int rc = 0, c = 0, queued = 0;
+	struct hal_session *session = sess;
+	struct venus_hfi_device *device;
+	struct hfi_queue_header *queue;
+
+	if (!session || !session->device) {
+		dprintk(VIDC_ERR, "%s: Invalid Params\n", __func__);
+		return -EINVAL;
+	}
+
+	device = session->device;
+
+	mutex_lock(&device->lock);
+	for (c = 0; c < num_etbs; ++c, ++queued) {
+		rc = __session_etb(session, &etbs[c], true);
+		if (rc) {
+			dprintk(VIDC_ERR, "Failed to queue etb: %d\n", rc);
+			goto err_etbs_and_ftbs;
+		}
+	}
+
+	for (c = 0; c < num_ftbs; ++c, ++queued) {
+		rc = __session_ftb(session, &ftbs[c], true);
+		if (rc) {
+			dprintk(VIDC_ERR, "Failed to queue ftb: %d\n", rc);
+			goto err_etbs_and_ftbs;
+		}
+	}
+
+err_etbs_and_ftbs:
+	/*
+	 * Whatever made it into the cmdq still needs to be kicked, even if
+	 * a later write failed.
+	 */
+	queue = (struct hfi_queue_header *)
+		device->iface_queues[VIDC_IFACEQ_CMDQ_IDX].q_hdr;
+	if (queued && queue && queue->qhdr_rx_req == 1)
+		__write_register(device, VIDC_CPU_IC_SOFTINT,
+				1 << VIDC_CPU_IC_SOFTINT_H2A_SHFT);
+
+	mutex_unlock(&device->lock);
+	return rc;
+}
+
 static int venus_hfi_session_parse_seq_hdr(void *sess,
 					struct vidc_seq_hdr *seq_hdr)
 {
@@ -3611,6 +3666,7 @@ static irqreturn_t venus_hfi_isr(int irq, void *dev)
 {
 	struct venus_hfi_device *device = dev;
 	dprintk(VIDC_INFO, "Received an interrupt %d\n", irq);
+	lpm_sync_event(LPM_SYNC_VIDEO);
 	disable_irq_nosync(irq);
 	queue_work(device->vidc_workq, &venus_hfi_work);
 	return IRQ_HANDLED;
@@ -4667,6 +4723,7 @@ static void venus_init_hfi_callbacks(struct hfi_device *hdev)
 	hdev->session_etb = venus_hfi_session_etb;
 	hdev->session_ftb = venus_hfi_session_ftb;
 	hdev->session_process_batch = venus_hfi_session_process_batch;
+	hdev->session_queue_buffers = venus_hfi_session_queue_buffers;
 	hdev->session_parse_seq_hdr = venus_hfi_session_parse_seq_hdr;
 	hdev->session_get_seq_hdr = venus_hfi_session_get_seq_hdr;
 	hdev->session_get_buf_req = venus_hfi_session_get_buf_req;
@@ -72,6 +72,9 @@
 
 #define QSEECOM_INVALID_KEY_ID  0xff
 
+#define QSEECOM_RT_LISTENERS_MAX	4
+#define QSEECOM_RT_LISTENER_PRIO	1
+
 #define	SCM_SAVE_PARTITION_HASH_ID	0x01
 
 #define	SCM_IS_ACTIVATED_ID		0x02
@@ -124,6 +127,15 @@ static DEFINE_MUTEX(app_access_lock);
 static DEFINE_MUTEX(clk_access_lock);
 static DEFINE_MUTEX(cmnlib_access_lock);
 
+/*
+ * Listener ids whose service thread is moved to SCHED_FIFO when it
+ * registers, so that latency critical secure apps (fingerprint match,
+ * for example) are not delayed behind CFS load while TZ waits on them.
+ */
+static unsigned int rt_listeners[QSEECOM_RT_LISTENERS_MAX];
+static int rt_listeners_count;
+module_param_array(rt_listeners, uint, &rt_listeners_count, 0644);
+
 struct qseecom_registered_listener_list {
 	struct list_head                 list;
 	struct qseecom_register_listener_req svc;
@@ -132,10 +144,13 @@ struct qseecom_registered_listener_list {
 	phys_addr_t sb_phys;
 	size_t sb_length;
 	struct ion_handle *ihandle; 
+	bool                       sb_cached;
 	wait_queue_head_t          rcv_req_wq;
 	int                        rcv_req_flag;
+	wait_queue_head_t          send_resp_wq;
 	int                        send_resp_flag;
 	bool                       listener_in_use;
+	struct task_struct         *rt_task;
 	
 	wait_queue_head_t          listener_block_app_wq;
 };
@@ -192,7 +207,6 @@ struct qseecom_control {
 	struct list_head   registered_kclient_list_head;
 	spinlock_t        registered_kclient_list_lock;
 
-	wait_queue_head_t send_resp_wq;
 	int               send_resp_flag;
 
 	uint32_t          qseos_version;
@@ -903,6 +917,7 @@ static int __qseecom_set_sb_memory(struct qseecom_registered_listener_list *svc,
 	struct qseecom_register_listener_64bit_ireq req_64bit;
 	struct qseecom_command_scm_resp resp;
 	ion_phys_addr_t pa;
+	unsigned long ion_flags = 0;
 	void *cmd_buf = NULL;
 	size_t cmd_len;
 
@@ -914,6 +929,10 @@ static int __qseecom_set_sb_memory(struct qseecom_registered_listener_list *svc,
 		return -ENOMEM;
 	}
 
+	/* Uncached buffers need no maintenance on each response */
+	ret = ion_handle_get_flags(qseecom.ion_clnt, svc->ihandle, &ion_flags);
+	svc->sb_cached = ret || (ion_flags & ION_FLAG_CACHED);
+
 	
 	ret = ion_phys(qseecom.ion_clnt, svc->ihandle, &pa, &svc->sb_length);
 	if (ret) {
@@ -958,6 +977,48 @@ static int __qseecom_set_sb_memory(struct qseecom_registered_listener_list *svc,
 	return 0;
 }
 
+static void __qseecom_listener_set_rt(
+			struct qseecom_registered_listener_list *svc)
+{
+	struct sched_param param = {
+		.sched_priority = QSEECOM_RT_LISTENER_PRIO
+	};
+	int i;
+
+	for (i = 0; i < rt_listeners_count; i++) {
+		if (rt_listeners[i] != svc->svc.listener_id)
+			continue;
+		if (sched_setscheduler_nocheck(current, SCHED_FIFO, &param)) {
+			pr_warn("lstnr %x: failed to raise priority\n",
+				svc->svc.listener_id);
+			return;
+		}
+		get_task_struct(current);
+		svc->rt_task = current;
+		return;
+	}
+}
+
+static void __qseecom_listener_clear_rt(struct task_struct *task)
+{
+	struct sched_param param = { .sched_priority = 0 };
+
+	if (!task)
+		return;
+	sched_setscheduler_nocheck(task, SCHED_NORMAL, &param);
+	put_task_struct(task);
+}
+
+static void __qseecom_listener_sb_maint(
+			struct qseecom_registered_listener_list *svc)
+{
+	if (!svc->ihandle || !svc->sb_cached)
+		return;
+	msm_ion_do_cache_op(qseecom.ion_clnt, svc->ihandle,
+				svc->sb_virt, svc->sb_length,
+				ION_IOC_CLEAN_INV_CACHES);
+}
+
 static int qseecom_register_listener(struct qseecom_dev_handle *data,
 					void __user *argp)
 {
@@ -989,6 +1050,7 @@ static int qseecom_register_listener(struct qseecom_dev_handle *data,
 	}
 	memcpy(&new_entry->svc, &rcvd_lstnr, sizeof(rcvd_lstnr));
 	new_entry->rcv_req_flag = 0;
+	new_entry->rt_task = NULL;
 
 	new_entry->svc.listener_id = rcvd_lstnr.listener_id;
 	new_entry->sb_length = rcvd_lstnr.sb_size;
@@ -1002,8 +1064,10 @@ static int qseecom_register_listener(struct qseecom_dev_handle *data,
 	data->listener.id = rcvd_lstnr.listener_id;
 	init_waitqueue_head(&new_entry->rcv_req_wq);
 	init_waitqueue_head(&new_entry->listener_block_app_wq);
+	init_waitqueue_head(&new_entry->send_resp_wq);
 	new_entry->send_resp_flag = 0;
 	new_entry->listener_in_use = false;
+	__qseecom_listener_set_rt(new_entry);
 	spin_lock_irqsave(&qseecom.registered_listener_list_lock, flags);
 	list_add_tail(&new_entry->list, &qseecom.registered_listener_list_head);
 	spin_unlock_irqrestore(&qseecom.registered_listener_list_lock, flags);
@@ -1020,6 +1084,7 @@ static int qseecom_unregister_listener(struct qseecom_dev_handle *data)
 	struct qseecom_registered_listener_list *ptr_svc = NULL;
 	struct qseecom_command_scm_resp resp;
 	struct ion_handle *ihandle = NULL;		
+	struct task_struct *rt_task = NULL;
 
 	req.qsee_cmd_id = QSEOS_DEREGISTER_LISTENER;
 	req.listener_id = data->listener.id;
@@ -1070,12 +1135,14 @@ static int qseecom_unregister_listener(struct qseecom_dev_handle *data)
 				ihandle = ptr_svc->ihandle;
 				}
 			list_del(&ptr_svc->list);
+			rt_task = ptr_svc->rt_task;
 			kzfree(ptr_svc);
 			break;
 		}
 	}
 	spin_unlock_irqrestore(&qseecom.registered_listener_list_lock, flags);
 
+	__qseecom_listener_clear_rt(rt_task);
 	
 	if (unmap_mem) {
 		if (!IS_ERR_OR_NULL(ihandle)) {
@@ -1413,10 +1480,8 @@ static int __qseecom_qseos_fail_return_resp_tz(struct qseecom_dev_handle *data,
 	if (ptr_svc)
 		pr_warn("listener_id:%x, lstnr: %x\n",
 					ptr_svc->svc.listener_id, lstnr);
-	if (ptr_svc && ptr_svc->ihandle)
-		msm_ion_do_cache_op(qseecom.ion_clnt, ptr_svc->ihandle,
-					ptr_svc->sb_virt, ptr_svc->sb_length,
-					ION_IOC_CLEAN_INV_CACHES);
+	if (ptr_svc)
+		__qseecom_listener_sb_maint(ptr_svc);
 	if (lstnr == RPMB_SERVICE)
 		__qseecom_enable_clk(CLK_QSEE);
 	ret = qseecom_scm_call(SCM_SVC_TZSCHEDULER, 1, send_data_rsp,
@@ -1459,7 +1524,8 @@ static int __qseecom_process_incomplete_cmd(struct qseecom_dev_handle *data,
 				&qseecom.registered_listener_list_head, list) {
 			if (ptr_svc->svc.listener_id == lstnr) {
 				ptr_svc->rcv_req_flag = 1;
-				wake_up_interruptible(&ptr_svc->rcv_req_wq);
+				wake_up_interruptible_sync(
+						&ptr_svc->rcv_req_wq);
 				break;
 			}
 		}
@@ -1495,13 +1561,13 @@ static int __qseecom_process_incomplete_cmd(struct qseecom_dev_handle *data,
 
 		do {
 			if (!qseecom.qsee_reentrancy_support &&
-				!wait_event_freezable(qseecom.send_resp_wq,
+				!wait_event_freezable(ptr_svc->send_resp_wq,
 				__qseecom_listener_has_sent_rsp(data))) {
 					break;
 			}
 
 			if (qseecom.qsee_reentrancy_support &&
-				!wait_event_freezable(qseecom.send_resp_wq,
+				!wait_event_freezable(ptr_svc->send_resp_wq,
 				__qseecom_reentrancy_listener_has_sent_rsp(
 						data, ptr_svc))) {
 					break;
@@ -1523,10 +1589,7 @@ static int __qseecom_process_incomplete_cmd(struct qseecom_dev_handle *data,
 		ptr_svc->send_resp_flag = 0;
 		send_data_rsp.qsee_cmd_id = QSEOS_LISTENER_DATA_RSP_COMMAND;
 		send_data_rsp.listener_id  = lstnr;
-		if (ptr_svc)
-			msm_ion_do_cache_op(qseecom.ion_clnt, ptr_svc->ihandle,
-					ptr_svc->sb_virt, ptr_svc->sb_length,
-						ION_IOC_CLEAN_INV_CACHES);
+		__qseecom_listener_sb_maint(ptr_svc);
 
 		if ((lstnr == RPMB_SERVICE) || (lstnr == SSD_SERVICE))
 			__qseecom_enable_clk(CLK_QSEE);
@@ -1580,7 +1643,8 @@ static int __qseecom_reentrancy_process_incomplete_cmd(
 			if (ptr_svc->svc.listener_id == lstnr) {
 				ptr_svc->listener_in_use = true;
 				ptr_svc->rcv_req_flag = 1;
-				wake_up_interruptible(&ptr_svc->rcv_req_wq);
+				wake_up_interruptible_sync(
+						&ptr_svc->rcv_req_wq);
 				break;
 			}
 		}
@@ -1612,7 +1676,7 @@ static int __qseecom_reentrancy_process_incomplete_cmd(
 		
 		mutex_unlock(&app_access_lock);
 		do {
-			if (!wait_event_freezable(qseecom.send_resp_wq,
+			if (!wait_event_freezable(ptr_svc->send_resp_wq,
 				__qseecom_reentrancy_listener_has_sent_rsp(
 						data, ptr_svc))) {
 					break;
@@ -1636,10 +1700,7 @@ static int __qseecom_reentrancy_process_incomplete_cmd(
 
 		send_data_rsp.qsee_cmd_id = QSEOS_LISTENER_DATA_RSP_COMMAND;
 		send_data_rsp.listener_id  = lstnr;
-		if (ptr_svc)
-			msm_ion_do_cache_op(qseecom.ion_clnt, ptr_svc->ihandle,
-					ptr_svc->sb_virt, ptr_svc->sb_length,
-						ION_IOC_CLEAN_INV_CACHES);
+		__qseecom_listener_sb_maint(ptr_svc);
 
 		if (lstnr == RPMB_SERVICE)
 			__qseecom_enable_clk(CLK_QSEE);
@@ -2001,10 +2062,22 @@ enable_clk_err:
 	return ret;
 }
 
+static void __qseecom_wake_all_listener_waiters(void)
+{
+	struct qseecom_registered_listener_list *ptr_svc;
+	unsigned long flags;
+
+	spin_lock_irqsave(&qseecom.registered_listener_list_lock, flags);
+	list_for_each_entry(ptr_svc, &qseecom.registered_listener_list_head,
+			list)
+		wake_up_all(&ptr_svc->send_resp_wq);
+	spin_unlock_irqrestore(&qseecom.registered_listener_list_lock, flags);
+}
+
 static int __qseecom_cleanup_app(struct qseecom_dev_handle *data)
 {
 	int ret = 1;	
-	wake_up_all(&qseecom.send_resp_wq);
+	__qseecom_wake_all_listener_waiters();
 	if (qseecom.qsee_reentrancy_support)
 		mutex_unlock(&app_access_lock);
 	while (atomic_read(&data->ioctl_count) > 1) {
@@ -4083,10 +4156,15 @@ int qseecom_set_bandwidth(struct qseecom_handle *handle, bool high)
 }
 EXPORT_SYMBOL(qseecom_set_bandwidth);
 
-static int qseecom_send_resp(void)
+static int qseecom_send_resp(struct qseecom_dev_handle *data)
 {
+	struct qseecom_registered_listener_list *this_lstnr = NULL;
+
+	this_lstnr = __qseecom_find_svc(data->listener.id);
+	if (this_lstnr == NULL)
+		return -EINVAL;
 	qseecom.send_resp_flag = 1;
-	wake_up_interruptible(&qseecom.send_resp_wq);
+	wake_up_interruptible_sync(&this_lstnr->send_resp_wq);
 	return 0;
 }
 
@@ -4100,7 +4178,7 @@ static int qseecom_reentrancy_send_resp(struct qseecom_dev_handle *data)
 		return -EINVAL;
 	qseecom.send_resp_flag = 1;
 	this_lstnr->send_resp_flag = 1;
-	wake_up_interruptible(&qseecom.send_resp_wq);
+	wake_up_interruptible_sync(&this_lstnr->send_resp_wq);
 	return 0;
 }
 
@@ -4148,7 +4226,7 @@ static int __qseecom_send_modfd_resp(struct qseecom_dev_handle *data,
 		__qseecom_update_cmd_buf_64(&resp, false, data);
 	qseecom.send_resp_flag = 1;
 	this_lstnr->send_resp_flag = 1;
-	wake_up_interruptible(&qseecom.send_resp_wq);
+	wake_up_interruptible_sync(&this_lstnr->send_resp_wq);
 	return 0;
 }
 
@@ -6229,7 +6307,7 @@ long qseecom_ioctl(struct file *file, unsigned cmd, unsigned long arg)
 		}
 		atomic_inc(&data->ioctl_count);
 		if (!qseecom.qsee_reentrancy_support)
-			ret = qseecom_send_resp();
+			ret = qseecom_send_resp(data);
 		else
 			ret = qseecom_reentrancy_send_resp(data);
 		atomic_dec(&data->ioctl_count);
@@ -7592,7 +7670,6 @@ static int qseecom_probe(struct platform_device *pdev)
 	spin_lock_init(&qseecom.registered_app_list_lock);
 	INIT_LIST_HEAD(&qseecom.registered_kclient_list_head);
 	spin_lock_init(&qseecom.registered_kclient_list_lock);
-	init_waitqueue_head(&qseecom.send_resp_wq);
 	qseecom.send_resp_flag = 0;
 
 	qseecom.qsee_version = QSEEE_VERSION_00;
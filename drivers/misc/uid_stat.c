@@ -24,6 +24,7 @@
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/stat.h>
+#include <linux/sched.h>
 #include <linux/uid_stat.h>
 #include <net/activity_stats.h>
 
@@ -36,6 +37,8 @@ struct uid_stat {
 	uid_t uid;
 	atomic_t tcp_rcv;
 	atomic_t tcp_snd;
+	atomic_t refault;
+	atomic_t activate;
 };
 
 static struct uid_stat *find_uid_stat(uid_t uid) {
@@ -82,6 +85,8 @@ static struct uid_stat *create_stat(uid_t uid) {
 	/* Counters start at INT_MIN, so we can track 4GB of network traffic. */
 	atomic_set(&new_uid->tcp_rcv, INT_MIN);
 	atomic_set(&new_uid->tcp_snd, INT_MIN);
+	atomic_set(&new_uid->refault, INT_MIN);
+	atomic_set(&new_uid->activate, INT_MIN);
 
 	list_add_tail(&new_uid->link, &uid_list);
 	return new_uid;
@@ -100,6 +105,13 @@ static void create_stat_proc(struct uid_stat *new_uid)
 
 	proc_create_data("tcp_rcv", S_IRUGO, entry,
 			 &uid_stat_read_atomic_int_fops, &new_uid->tcp_rcv);
+
+	/* Page cache refaults, and how many of them were activated. */
+	proc_create_data("workingset_refault", S_IRUGO, entry,
+			 &uid_stat_read_atomic_int_fops, &new_uid->refault);
+
+	proc_create_data("workingset_activate", S_IRUGO, entry,
+			 &uid_stat_read_atomic_int_fops, &new_uid->activate);
 }
 
 static struct uid_stat *find_or_create_uid_stat(uid_t uid)
@@ -139,6 +151,26 @@ int uid_stat_tcp_rcv(uid_t uid, int size) {
 	return 0;
 }
 
+/*
+ * Called from the page cache insertion path, possibly under a
+ * filesystem's readpages, so creating the proc entries must not
+ * recurse into the filesystem.
+ */
+int uid_stat_workingset(uid_t uid, bool activate) {
+	struct uid_stat *entry;
+	unsigned int noio_flags;
+
+	noio_flags = memalloc_noio_save();
+	entry = find_or_create_uid_stat(uid);
+	memalloc_noio_restore(noio_flags);
+	if (!entry)
+		return -1;
+	atomic_inc(&entry->refault);
+	if (activate)
+		atomic_inc(&entry->activate);
+	return 0;
+}
+
 static int __init uid_stat_init(void)
 {
 	parent = proc_mkdir("uid_stat", NULL);
@@ -15,6 +15,12 @@
 #include <linux/stacktrace.h>
 #include <linux/wcnss_wlan.h>
 #include <linux/spinlock.h>
+#include <linux/of.h>
+#include <linux/sort.h>
+#include <linux/workqueue.h>
+#include <linux/shrinker.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 static DEFINE_SPINLOCK(alloc_lock);
 
@@ -22,7 +28,11 @@ static DEFINE_SPINLOCK(alloc_lock);
 #define WCNSS_MAX_STACK_TRACE			64
 #endif
 
+/* Entries added to a pool each time it runs dry */
+#define WCNSS_PREALLOC_GROW			2
+
 struct wcnss_prealloc {
+	struct list_head list;
 	int occupied;
 	unsigned int size;
 	void *ptr;
@@ -32,97 +42,207 @@ struct wcnss_prealloc {
 #endif
 };
 
-/* pre-alloced mem for WLAN driver */
-static struct wcnss_prealloc wcnss_allocs[] = {
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 12 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 24 * 1024, NULL},
-	{0, 24 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 76 * 1024, NULL},
+/*
+ * A pool of buffers of one size. Free entries are kept at the head of
+ * the list, occupied ones at the tail. The pool grows up to max entries
+ * when it runs dry and gives back what it holds above reserve when
+ * memory is short.
+ */
+struct wcnss_prealloc_pool {
+	unsigned int size;
+	unsigned int reserve;
+	unsigned int max;
+	unsigned int count;
+	unsigned int in_use;
+	bool grow;
+	struct list_head entries;
+	unsigned long hits;
+	unsigned long misses;
 };
 
-int wcnss_prealloc_init(void)
+/* size, reserve, max: used when there is no qcom,wlan-prealloc-pools */
+static const u32 wcnss_default_pools[][3] = {
+	{8  * 1024, 8, 16},
+	{12 * 1024, 36, 48},
+	{16 * 1024, 6, 12},
+	{24 * 1024, 2, 4},
+	{32 * 1024, 8, 12},
+	{64 * 1024, 4, 6},
+	{76 * 1024, 1, 2},
+};
+
+static struct wcnss_prealloc_pool *wcnss_pools;
+static int wcnss_num_pools;
+static struct dentry *wcnss_prealloc_dent;
+
+static void wcnss_prealloc_grow_fn(struct work_struct *work);
+static DECLARE_WORK(wcnss_prealloc_grow_work, wcnss_prealloc_grow_fn);
+
+static int wcnss_prealloc_pool_cmp(const void *a, const void *b)
 {
-	int i;
+	const struct wcnss_prealloc_pool *pa = a, *pb = b;
 
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		wcnss_allocs[i].occupied = 0;
-		wcnss_allocs[i].ptr = kmalloc(wcnss_allocs[i].size, GFP_KERNEL);
-		if (wcnss_allocs[i].ptr == NULL)
-			return -ENOMEM;
+	if (pa->size != pb->size)
+		return pa->size < pb->size ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Pools come from the qcom,wlan-prealloc-pools property of the
+ * qcom,wcnss-prealloc node, a list of <size reserve max> triplets.
+ */
+static int wcnss_prealloc_parse_pools(void)
+{
+	struct device_node *np;
+	u32 *cfg = NULL;
+	int i, len = 0;
+
+	np = of_find_compatible_node(NULL, NULL, "qcom,wcnss-prealloc");
+	if (np && of_get_property(np, "qcom,wlan-prealloc-pools", &len) &&
+	    len && !(len % (3 * sizeof(u32)))) {
+		cfg = kmalloc(len, GFP_KERNEL);
+		if (cfg && of_property_read_u32_array(np,
+				"qcom,wlan-prealloc-pools", cfg,
+				len / sizeof(u32))) {
+			kfree(cfg);
+			cfg = NULL;
+		}
 	}
+	of_node_put(np);
+
+	if (cfg)
+		wcnss_num_pools = len / (3 * sizeof(u32));
+	else
+		wcnss_num_pools = ARRAY_SIZE(wcnss_default_pools);
+
+	wcnss_pools = kcalloc(wcnss_num_pools, sizeof(*wcnss_pools),
+			      GFP_KERNEL);
+	if (!wcnss_pools) {
+		kfree(cfg);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < wcnss_num_pools; i++) {
+		const u32 *p = cfg ? &cfg[i * 3] : wcnss_default_pools[i];
+
+		wcnss_pools[i].size = p[0];
+		wcnss_pools[i].reserve = p[1];
+		wcnss_pools[i].max = max(p[1], p[2]);
+	}
+	kfree(cfg);
+
+	sort(wcnss_pools, wcnss_num_pools, sizeof(*wcnss_pools),
+	     wcnss_prealloc_pool_cmp, NULL);
+	for (i = 0; i < wcnss_num_pools; i++)
+		INIT_LIST_HEAD(&wcnss_pools[i].entries);
 
 	return 0;
 }
 
+static struct wcnss_prealloc *wcnss_prealloc_alloc_entry(unsigned int size,
+							 gfp_t gfp)
+{
+	struct wcnss_prealloc *entry;
+
+	entry = kzalloc(sizeof(*entry), gfp);
+	if (!entry)
+		return NULL;
+
+	entry->size = size;
+	entry->ptr = kmalloc(size, gfp);
+	if (!entry->ptr) {
+		kfree(entry);
+		return NULL;
+	}
+
+	return entry;
+}
+
+static void wcnss_prealloc_free_entry(struct wcnss_prealloc *entry)
+{
+	kfree(entry->ptr);
+	kfree(entry);
+}
+
+/* Add up to nr free entries to pool, without going above its max */
+static void wcnss_prealloc_pool_fill(struct wcnss_prealloc_pool *pool,
+				     unsigned int nr, gfp_t gfp)
+{
+	struct wcnss_prealloc *entry;
+	unsigned long flags;
+
+	while (nr--) {
+		if (ACCESS_ONCE(pool->count) >= pool->max)
+			break;
+
+		entry = wcnss_prealloc_alloc_entry(pool->size, gfp);
+		if (!entry)
+			break;
+
+		spin_lock_irqsave(&alloc_lock, flags);
+		list_add(&entry->list, &pool->entries);
+		pool->count++;
+		spin_unlock_irqrestore(&alloc_lock, flags);
+	}
+}
+
+static void wcnss_prealloc_grow_fn(struct work_struct *work)
+{
+	unsigned long flags;
+	bool grow;
+	int i;
+
+	for (i = 0; i < wcnss_num_pools; i++) {
+		spin_lock_irqsave(&alloc_lock, flags);
+		grow = wcnss_pools[i].grow;
+		wcnss_pools[i].grow = false;
+		spin_unlock_irqrestore(&alloc_lock, flags);
+
+		if (grow)
+			wcnss_prealloc_pool_fill(&wcnss_pools[i],
+				WCNSS_PREALLOC_GROW,
+				GFP_KERNEL | __GFP_NORETRY | __GFP_NOWARN);
+	}
+}
+
 void wcnss_prealloc_deinit(void)
 {
+	struct wcnss_prealloc *entry, *tmp;
 	int i = 0;
 
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		kfree(wcnss_allocs[i].ptr);
-		wcnss_allocs[i].ptr = NULL;
+	cancel_work_sync(&wcnss_prealloc_grow_work);
+
+	for (i = 0; i < wcnss_num_pools; i++) {
+		list_for_each_entry_safe(entry, tmp, &wcnss_pools[i].entries,
+					 list) {
+			list_del(&entry->list);
+			wcnss_prealloc_free_entry(entry);
+		}
 	}
+	kfree(wcnss_pools);
+	wcnss_pools = NULL;
+	wcnss_num_pools = 0;
+}
+
+int wcnss_prealloc_init(void)
+{
+	struct wcnss_prealloc_pool *pool;
+	int i, ret;
+
+	ret = wcnss_prealloc_parse_pools();
+	if (ret)
+		return ret;
+
+	for (i = 0; i < wcnss_num_pools; i++) {
+		pool = &wcnss_pools[i];
+		wcnss_prealloc_pool_fill(pool, pool->reserve, GFP_KERNEL);
+		if (pool->count < pool->reserve) {
+			wcnss_prealloc_deinit();
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
 }
 
 #ifdef CONFIG_SLUB_DEBUG
@@ -149,24 +269,52 @@ static inline void wcnss_prealloc_save_stack_trace(struct wcnss_prealloc *entry)
 
 void *wcnss_prealloc_get(unsigned int size)
 {
+	struct wcnss_prealloc_pool *pool, *first = NULL;
+	struct wcnss_prealloc *entry;
 	int i = 0;
 	unsigned long flags;
 
 	spin_lock_irqsave(&alloc_lock, flags);
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		if (wcnss_allocs[i].occupied)
+	for (i = 0; i < wcnss_num_pools; i++) {
+		pool = &wcnss_pools[i];
+		if (pool->size <= size)
 			continue;
+		if (!first)
+			first = pool;
 
-		if (wcnss_allocs[i].size > size) {
-			/* we found the slot */
-			wcnss_allocs[i].occupied = 1;
-			spin_unlock_irqrestore(&alloc_lock, flags);
-			wcnss_prealloc_save_stack_trace(&wcnss_allocs[i]);
-			return wcnss_allocs[i].ptr;
+		if (list_empty(&pool->entries))
+			continue;
+		entry = list_first_entry(&pool->entries,
+					 struct wcnss_prealloc, list);
+		if (entry->occupied)
+			continue;
+
+		/* we found the slot */
+		entry->occupied = 1;
+		list_move_tail(&entry->list, &pool->entries);
+		pool->in_use++;
+		if (pool == first) {
+			pool->hits++;
+		} else {
+			/* served from a larger pool, grow the right one */
+			first->misses++;
+			first->grow = true;
 		}
+		spin_unlock_irqrestore(&alloc_lock, flags);
+		if (pool != first)
+			schedule_work(&wcnss_prealloc_grow_work);
+		wcnss_prealloc_save_stack_trace(entry);
+		return entry->ptr;
+	}
+	if (first) {
+		first->misses++;
+		first->grow = true;
 	}
 	spin_unlock_irqrestore(&alloc_lock, flags);
 
+	if (first)
+		schedule_work(&wcnss_prealloc_grow_work);
+
 	pr_err("wcnss: %s: prealloc not available for size: %d\n",
 			__func__, size);
 
@@ -176,15 +324,24 @@ EXPORT_SYMBOL(wcnss_prealloc_get);
 
 int wcnss_prealloc_put(void *ptr)
 {
+	struct wcnss_prealloc *entry;
 	int i = 0;
 	unsigned long flags;
 
 	spin_lock_irqsave(&alloc_lock, flags);
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		if (wcnss_allocs[i].ptr == ptr) {
-			wcnss_allocs[i].occupied = 0;
-			spin_unlock_irqrestore(&alloc_lock, flags);
-			return 1;
+	for (i = 0; i < wcnss_num_pools; i++) {
+		list_for_each_entry_reverse(entry, &wcnss_pools[i].entries,
+					    list) {
+			if (!entry->occupied)
+				break;
+			if (entry->ptr == ptr) {
+				entry->occupied = 0;
+				list_move(&entry->list,
+					  &wcnss_pools[i].entries);
+				wcnss_pools[i].in_use--;
+				spin_unlock_irqrestore(&alloc_lock, flags);
+				return 1;
+			}
 		}
 	}
 	spin_unlock_irqrestore(&alloc_lock, flags);
@@ -196,20 +353,23 @@ EXPORT_SYMBOL(wcnss_prealloc_put);
 #ifdef CONFIG_SLUB_DEBUG
 void wcnss_prealloc_check_memory_leak(void)
 {
+	struct wcnss_prealloc *entry;
 	int i, j = 0;
 
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		if (!wcnss_allocs[i].occupied)
-			continue;
+	for (i = 0; i < wcnss_num_pools; i++) {
+		list_for_each_entry(entry, &wcnss_pools[i].entries, list) {
+			if (!entry->occupied)
+				continue;
 
-		if (j == 0) {
-			pr_err("wcnss_prealloc: Memory leak detected\n");
-			j++;
-		}
+			if (j == 0) {
+				pr_err("wcnss_prealloc: Memory leak detected\n");
+				j++;
+			}
 
-		pr_err("Size: %u, addr: %pK, backtrace:\n",
-				wcnss_allocs[i].size, wcnss_allocs[i].ptr);
-		print_stack_trace(&wcnss_allocs[i].trace, 1);
+			pr_err("Size: %u, addr: %pK, backtrace:\n",
+					entry->size, entry->ptr);
+			print_stack_trace(&entry->trace, 1);
+		}
 	}
 
 }
@@ -217,26 +377,130 @@ void wcnss_prealloc_check_memory_leak(void)
 
 int wcnss_pre_alloc_reset(void)
 {
+	struct wcnss_prealloc *entry;
+	unsigned long flags;
 	int i, n = 0;
 
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		if (!wcnss_allocs[i].occupied)
-			continue;
+	spin_lock_irqsave(&alloc_lock, flags);
+	for (i = 0; i < wcnss_num_pools; i++) {
+		list_for_each_entry(entry, &wcnss_pools[i].entries, list) {
+			if (!entry->occupied)
+				continue;
 
-		wcnss_allocs[i].occupied = 0;
-		n++;
+			entry->occupied = 0;
+			n++;
+		}
+		wcnss_pools[i].in_use = 0;
 	}
+	spin_unlock_irqrestore(&alloc_lock, flags);
 
 	return n;
 }
 
+static unsigned long
+wcnss_prealloc_shrink_count(struct shrinker *shrinker,
+			    struct shrink_control *sc)
+{
+	struct wcnss_prealloc_pool *pool;
+	unsigned long count = 0;
+	int i;
+
+	for (i = 0; i < wcnss_num_pools; i++) {
+		pool = &wcnss_pools[i];
+		if (pool->count - pool->in_use > pool->reserve)
+			count += pool->count - pool->in_use - pool->reserve;
+	}
+
+	return count;
+}
+
+static unsigned long
+wcnss_prealloc_shrink_scan(struct shrinker *shrinker,
+			   struct shrink_control *sc)
+{
+	struct wcnss_prealloc_pool *pool;
+	struct wcnss_prealloc *entry, *tmp;
+	unsigned long flags, freed = 0;
+	LIST_HEAD(free_list);
+	int i;
+
+	spin_lock_irqsave(&alloc_lock, flags);
+	for (i = 0; i < wcnss_num_pools && freed < sc->nr_to_scan; i++) {
+		pool = &wcnss_pools[i];
+		while (freed < sc->nr_to_scan &&
+		       pool->count - pool->in_use > pool->reserve) {
+			entry = list_first_entry(&pool->entries,
+						 struct wcnss_prealloc, list);
+			list_move(&entry->list, &free_list);
+			pool->count--;
+			freed++;
+		}
+	}
+	spin_unlock_irqrestore(&alloc_lock, flags);
+
+	list_for_each_entry_safe(entry, tmp, &free_list, list)
+		wcnss_prealloc_free_entry(entry);
+
+	return freed;
+}
+
+static struct shrinker wcnss_prealloc_shrinker = {
+	.count_objects = wcnss_prealloc_shrink_count,
+	.scan_objects = wcnss_prealloc_shrink_scan,
+	.seeks = DEFAULT_SEEKS,
+};
+
+static int wcnss_prealloc_stats_show(struct seq_file *s, void *unused)
+{
+	struct wcnss_prealloc_pool *pool;
+	unsigned long flags;
+	int i;
+
+	seq_puts(s, "size count in_use reserve max hits misses\n");
+	for (i = 0; i < wcnss_num_pools; i++) {
+		pool = &wcnss_pools[i];
+		spin_lock_irqsave(&alloc_lock, flags);
+		seq_printf(s, "%u %u %u %u %u %lu %lu\n", pool->size,
+			   pool->count, pool->in_use, pool->reserve,
+			   pool->max, pool->hits, pool->misses);
+		spin_unlock_irqrestore(&alloc_lock, flags);
+	}
+
+	return 0;
+}
+
+static int wcnss_prealloc_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, wcnss_prealloc_stats_show, NULL);
+}
+
+static const struct file_operations wcnss_prealloc_stats_fops = {
+	.open = wcnss_prealloc_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int __init wcnss_pre_alloc_init(void)
 {
-	return wcnss_prealloc_init();
+	int ret;
+
+	ret = wcnss_prealloc_init();
+	if (ret)
+		return ret;
+
+	register_shrinker(&wcnss_prealloc_shrinker);
+	wcnss_prealloc_dent = debugfs_create_file("wcnss_prealloc", 0444,
+						  NULL, NULL,
+						  &wcnss_prealloc_stats_fops);
+
+	return 0;
 }
 
 static void __exit wcnss_pre_alloc_exit(void)
 {
+	debugfs_remove(wcnss_prealloc_dent);
+	unregister_shrinker(&wcnss_prealloc_shrinker);
 	wcnss_prealloc_deinit();
 }
 
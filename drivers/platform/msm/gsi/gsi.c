@@ -802,6 +802,19 @@ int gsi_deregister_device(unsigned long dev_hdl, bool force)
 }
 EXPORT_SYMBOL(gsi_deregister_device);
 
+static void __gsi_write_evt_ring_mod(uint8_t evt_id, unsigned int ee,
+		uint16_t int_modt, uint8_t int_modc)
+{
+	uint32_t val;
+
+	val = (((int_modt << GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODT_SHFT) &
+		GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODT_BMSK) |
+		((int_modc << GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODC_SHFT) &
+		 GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODC_BMSK));
+	gsi_writel(val, gsi_ctx->base +
+			GSI_EE_n_EV_CH_k_CNTXT_8_OFFS(evt_id, ee));
+}
+
 static void gsi_program_evt_ring_ctx(struct gsi_evt_ring_props *props,
 		uint8_t evt_id, unsigned int ee)
 {
@@ -837,12 +850,7 @@ static void gsi_program_evt_ring_ctx(struct gsi_evt_ring_props *props,
 	gsi_writel(val, gsi_ctx->base +
 			GSI_EE_n_EV_CH_k_CNTXT_3_OFFS(evt_id, ee));
 
-	val = (((props->int_modt << GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODT_SHFT) &
-		GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODT_BMSK) |
-		((props->int_modc << GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODC_SHFT) &
-		 GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODC_BMSK));
-	gsi_writel(val, gsi_ctx->base +
-			GSI_EE_n_EV_CH_k_CNTXT_8_OFFS(evt_id, ee));
+	__gsi_write_evt_ring_mod(evt_id, ee, props->int_modt, props->int_modc);
 
 	val = (props->intvec & GSI_EE_n_EV_CH_k_CNTXT_9_INTVEC_BMSK) <<
 		GSI_EE_n_EV_CH_k_CNTXT_9_INTVEC_SHFT;
@@ -1095,6 +1103,42 @@ int gsi_write_evt_ring_scratch(unsigned long evt_ring_hdl,
 }
 EXPORT_SYMBOL(gsi_write_evt_ring_scratch);
 
+int gsi_config_evt_ring_mod(unsigned long evt_ring_hdl, uint16_t int_modt,
+		uint8_t int_modc)
+{
+	struct gsi_evt_ctx *ctx;
+
+	if (!gsi_ctx) {
+		pr_err("%s:%d gsi context not allocated\n", __func__, __LINE__);
+		return -GSI_STATUS_NODEV;
+	}
+
+	if (evt_ring_hdl >= GSI_MAX_EVT_RING) {
+		GSIERR("bad params evt_ring_hdl=%lu\n", evt_ring_hdl);
+		return -GSI_STATUS_INVALID_PARAMS;
+	}
+
+	ctx = &gsi_ctx->evtr[evt_ring_hdl];
+
+	if (ctx->state != GSI_EVT_RING_STATE_ALLOCATED) {
+		GSIERR("bad state %d\n", ctx->state);
+		return -GSI_STATUS_UNSUPPORTED_OP;
+	}
+
+	if (ctx->props.int_modt == int_modt &&
+	    ctx->props.int_modc == int_modc)
+		return GSI_STATUS_SUCCESS;
+
+	ctx->props.int_modt = int_modt;
+	ctx->props.int_modc = int_modc;
+	__gsi_write_evt_ring_mod(evt_ring_hdl, gsi_ctx->per.ee, int_modt,
+			int_modc);
+	ctx->stats.mod_updates++;
+
+	return GSI_STATUS_SUCCESS;
+}
+EXPORT_SYMBOL(gsi_config_evt_ring_mod);
+
 int gsi_dealloc_evt_ring(unsigned long evt_ring_hdl)
 {
 	uint32_t val;
@@ -86,6 +86,7 @@ struct gsi_chan_ctx {
 
 struct gsi_evt_stats {
 	unsigned long completed;
+	unsigned long mod_updates;
 };
 
 struct gsi_evt_ctx {
@@ -375,9 +375,15 @@ static ssize_t gsi_dump_stats(struct file *file,
 				ctx->stats.invalid_tre_error);
 			TERR("poll_ok=%lu poll_empty=%lu\n",
 				ctx->stats.poll_ok, ctx->stats.poll_empty);
-			if (ctx->evtr)
+			if (ctx->evtr) {
 				TERR("compl_evt=%lu\n",
 					ctx->evtr->stats.completed);
+				TERR("int_modt=%u int_modc=%u\n",
+					ctx->evtr->props.int_modt,
+					ctx->evtr->props.int_modc);
+				TERR("mod_updates=%lu\n",
+					ctx->evtr->stats.mod_updates);
+			}
 			TERR("\n");
 		}
 	}
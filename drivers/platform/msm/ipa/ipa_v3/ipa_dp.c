@@ -14,6 +14,7 @@
 #include <linux/device.h>
 #include <linux/dmapool.h>
 #include <linux/list.h>
+#include <linux/module.h>
 #include <linux/netdevice.h>
 #include <linux/msm_gsi.h>
 #include "ipa_i.h"
@@ -38,6 +39,16 @@
 #define IPA_GENERIC_RX_BUFF_SZ (IPA_GENERIC_RX_BUFF_BASE_SZ -\
 		(IPA_REAL_GENERIC_RX_BUFF_SZ - IPA_GENERIC_RX_BUFF_BASE_SZ))
 
+static unsigned int lan_rx_page_pool_sz = IPA_GENERIC_RX_POOL_SZ;
+module_param(lan_rx_page_pool_sz, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(lan_rx_page_pool_sz,
+	"Recycled Rx pages of the LAN pipe, taken at connect, 0 to disable");
+
+static unsigned int wan_rx_page_pool_sz = 2 * IPA_GENERIC_RX_POOL_SZ;
+module_param(wan_rx_page_pool_sz, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(wan_rx_page_pool_sz,
+	"Recycled Rx pages of the WAN pipe, taken at connect, 0 to disable");
+
 #define IPA_WLAN_RX_POOL_SZ 100
 #define IPA_WLAN_RX_POOL_SZ_LOW_WM 5
 #define IPA_WLAN_RX_BUFF_SZ 2048
@@ -52,6 +63,10 @@
 #define IPA_GSI_CHANNEL_RING_LEN 4096
 #define IPA_GSI_MAX_CH_LOW_WEIGHT 15
 #define IPA_GSI_EVT_RING_INT_MODT 3200 /* 0.1s under 32KHz clock */
+#define IPA_GSI_EVT_RING_INT_MODT_HZ 32768
+/* adaptive moderation keeps a pipe under this many interrupts a second */
+#define IPA_RX_MOD_IRQ_RATE 2000
+#define IPA_RX_MOD_WINDOW_MS 100
 
 static struct sk_buff *ipa3_get_skb_ipa_rx(unsigned int len, gfp_t flags);
 static void ipa3_replenish_wlan_rx_cache(struct ipa3_sys_context *sys);
@@ -65,6 +80,7 @@ static void ipa3_wlan_wq_rx_common(struct ipa3_sys_context *sys,
 static int ipa3_assign_policy(struct ipa_sys_connect_params *in,
 		struct ipa3_sys_context *sys);
 static void ipa3_cleanup_rx(struct ipa3_sys_context *sys);
+static void ipa3_rx_pool_init(struct ipa3_sys_context *sys, u32 size);
 static void ipa3_wq_rx_avail(struct work_struct *work);
 static void ipa3_alloc_wlan_rx_common_cache(u32 size);
 static void ipa3_cleanup_wlan_rx_common_cache(void);
@@ -408,6 +424,7 @@ fail_mem_alloc:
  * @num_desc: number of packets
  * @desc: packets to send (may be immediate command or data)
  * @in_atomic:  whether caller is in atomic context
+ * @ring_db: whether to notify the HW of the transaction now, see below
  *
  * This function is used for system-to-bam connection.
  * - SPS driver expect struct sps_transfer which will contain all the data
@@ -419,13 +436,17 @@ fail_mem_alloc:
  * - each transfer will be made by calling to sps_transfer()
  * - Each packet (command or data) that will be sent will also be saved in
  *   ipa3_sys_context for later check that all data was sent
+ * - On GSI, the channel doorbell is not rung when ring_db is false. The
+ *   transaction is then picked up by the HW with the next one that rings
+ *   it. A failed send rings it for the transactions left pending.
  *
  * Return codes: 0: success, -EFAULT: failure
  */
-int ipa3_send(struct ipa3_sys_context *sys,
+static int __ipa3_send(struct ipa3_sys_context *sys,
 		u32 num_desc,
 		struct ipa3_desc *desc,
-		bool in_atomic)
+		bool in_atomic,
+		bool ring_db)
 {
 	struct ipa3_tx_pkt_wrapper *tx_pkt, *tx_pkt_first;
 	struct ipa3_ip_packet_tag_status *tag_ret = NULL;
@@ -605,11 +626,12 @@ int ipa3_send(struct ipa3_sys_context *sys,
 
 	if (ipa3_ctx->transport_prototype == IPA_TRANSPORT_TYPE_GSI) {
 		result = gsi_queue_xfer(sys->ep->gsi_chan_hdl, num_desc,
-				gsi_xfer_elem_array, true);
+				gsi_xfer_elem_array, ring_db);
 		if (result != GSI_STATUS_SUCCESS) {
 			IPAERR("GSI xfer failed.\n");
 			goto failure;
 		}
+		sys->db_pending = !ring_db;
 		kfree(gsi_xfer_elem_array);
 	} else {
 		result = sps_transfer(sys->ep->ep_hdl, &transfer);
@@ -639,9 +661,13 @@ failure:
 		if (fail_dma_wrap)
 			kmem_cache_free(ipa3_ctx->tx_pkt_wrapper_cache, tx_pkt);
 
-	if (ipa3_ctx->transport_prototype == IPA_TRANSPORT_TYPE_GSI)
+	if (ipa3_ctx->transport_prototype == IPA_TRANSPORT_TYPE_GSI) {
 		kfree(gsi_xfer_elem_array);
-	else {
+		if (sys->db_pending) {
+			gsi_start_xfer(sys->ep->gsi_chan_hdl);
+			sys->db_pending = false;
+		}
+	} else {
 		if (transfer.iovec_phys) {
 			if (num_desc == IPA_NUM_DESC_PER_SW_TX) {
 				dma_pool_free(ipa3_ctx->dma_pool,
@@ -658,6 +684,14 @@ failure:
 	return -EFAULT;
 }
 
+int ipa3_send(struct ipa3_sys_context *sys,
+		u32 num_desc,
+		struct ipa3_desc *desc,
+		bool in_atomic)
+{
+	return __ipa3_send(sys, num_desc, desc, in_atomic, true);
+}
+
 /**
  * ipa3_transport_irq_cmd_ack - callback function which will be called by SPS/GSI driver after an
  * immediate command is complete.
@@ -839,9 +873,39 @@ static int ipa3_handle_rx_core(struct ipa3_sys_context *sys, bool process_all,
 	else
 		cnt = ipa_handle_rx_core_sps(sys, process_all, in_poll_state);
 
+	sys->mod.events += cnt;
 	return cnt;
 }
 
+/**
+ * ipa3_rx_mod_update() - Retune the interrupt moderation of a pipe
+ * @sys: system pipe context
+ *
+ * Called before the pipe goes back to interrupt mode. Once a sampling
+ * window is over, the moderation counter is set so that the event rate
+ * seen in the window would raise about IPA_RX_MOD_IRQ_RATE interrupts a
+ * second. The moderation timer bounds the latency this adds at low rates.
+ */
+static void ipa3_rx_mod_update(struct ipa3_sys_context *sys)
+{
+	struct ipa3_rx_moderation *mod = &sys->mod;
+	unsigned long elapsed = jiffies - mod->stamp;
+	u32 rate;
+
+	if (!mod->adaptive ||
+	    elapsed < msecs_to_jiffies(IPA_RX_MOD_WINDOW_MS))
+		return;
+
+	rate = mod->events * HZ / elapsed;
+	mod->modc = clamp_t(u32, DIV_ROUND_UP(rate, IPA_RX_MOD_IRQ_RATE),
+		1, mod->max_modc);
+	mod->events = 0;
+	mod->stamp = jiffies;
+
+	gsi_config_evt_ring_mod(sys->ep->gsi_evt_ring_hdl, mod->modt,
+		mod->modc);
+}
+
 /**
  * ipa3_rx_switch_to_intr_mode() - Operate the Rx data path in interrupt mode
  */
@@ -855,6 +919,7 @@ static void ipa3_rx_switch_to_intr_mode(struct ipa3_sys_context *sys)
 	}
 
 	if (ipa3_ctx->transport_prototype == IPA_TRANSPORT_TYPE_GSI) {
+		ipa3_rx_mod_update(sys);
 		atomic_set(&sys->curr_polling_state, 0);
 		ipa3_dec_release_wakelock();
 		ret = gsi_config_channel_mode(sys->ep->gsi_chan_hdl,
@@ -893,6 +958,31 @@ fail:
 			msecs_to_jiffies(1));
 }
 
+/**
+ * ipa3_rx_schedule_poll() - Start draining a pipe that entered polling mode
+ * @sys: system pipe context
+ *
+ * Pipes set up with napi_enabled are handed to the client's NAPI instance,
+ * which calls ipa3_rx_poll() from its poll function. The clock vote taken
+ * here is dropped once the pipe is back in interrupt mode. If the vote
+ * cannot be taken from atomic context the pipe workqueue is used instead.
+ */
+static void ipa3_rx_schedule_poll(struct ipa3_sys_context *sys)
+{
+	struct ipa3_active_client_logging_info log_info;
+
+	if (sys->ep->napi_enabled) {
+		IPA_ACTIVE_CLIENTS_PREP_SIMPLE(log_info);
+		if (ipa3_inc_client_enable_clks_no_block(&log_info) == 0) {
+			sys->ep->client_notify(sys->ep->priv,
+				IPA_CLIENT_START_POLL, 0);
+			return;
+		}
+	}
+
+	queue_work(sys->wq, &sys->work);
+}
+
 /**
  * ipa_rx_notify() - Callback function which is called by the SPS driver when a
  * a packet is received
@@ -935,7 +1025,7 @@ static void ipa3_sps_irq_rx_notify(struct sps_event_notify *notify)
 			ipa3_inc_acquire_wakelock();
 			atomic_set(&sys->curr_polling_state, 1);
 			trace_intr_to_poll3(sys->ep->client);
-			queue_work(sys->wq, &sys->work);
+			ipa3_rx_schedule_poll(sys);
 		}
 		break;
 	default:
@@ -990,6 +1080,139 @@ static void ipa3_handle_rx(struct ipa3_sys_context *sys)
 	IPA_ACTIVE_CLIENTS_DEC_SIMPLE();
 }
 
+/**
+ * ipa3_rx_poll() - Drain a NAPI enabled pipe from the client's poll function
+ * @clnt_hdl:	[in] opaque client handle assigned by IPA to client
+ * @budget:	[in] maximum number of descriptors to process
+ *
+ * Once the pipe is empty the client is notified with IPA_CLIENT_COMP_NAPI
+ * to complete its NAPI instance and the pipe is switched back to interrupt
+ * mode.
+ *
+ * Returns:	number of descriptors processed
+ */
+int ipa3_rx_poll(u32 clnt_hdl, int budget)
+{
+	struct ipa3_ep_context *ep;
+	struct ipa3_sys_context *sys;
+	int cnt = 0;
+	int ret;
+
+	if (clnt_hdl >= ipa3_ctx->ipa_num_pipes ||
+	    ipa3_ctx->ep[clnt_hdl].valid == 0) {
+		IPAERR("bad parm %u\n", clnt_hdl);
+		return 0;
+	}
+
+	ep = &ipa3_ctx->ep[clnt_hdl];
+	sys = ep->sys;
+
+	if (!atomic_read(&sys->curr_polling_state)) {
+		ep->client_notify(ep->priv, IPA_CLIENT_COMP_NAPI, 0);
+		return 0;
+	}
+
+	while (cnt < budget) {
+		ret = ipa3_handle_rx_core(sys, false, true);
+		if (ret == 0)
+			break;
+		cnt += ret;
+	}
+
+	if (cnt < budget) {
+		ep->client_notify(ep->priv, IPA_CLIENT_COMP_NAPI, 0);
+		trace_poll_to_intr3(ep->client);
+		ipa3_rx_switch_to_intr_mode(sys);
+		queue_work(sys->wq, &sys->napi_clk_work);
+	}
+
+	return cnt;
+}
+
+static void ipa3_rx_napi_clk_work_func(struct work_struct *work)
+{
+	IPA_ACTIVE_CLIENTS_DEC_SIMPLE();
+}
+
+/**
+ * ipa3_set_rx_moderation() - Set the interrupt moderation of a GSI pipe
+ * @clnt_hdl:	[in] opaque client handle assigned by IPA to client
+ * @adaptive:	[in] tune the moderation counter from the event rate
+ * @usecs:	[in] moderation timer in microseconds
+ * @frames:	[in] moderation counter, its upper bound when @adaptive
+ *
+ * Returns:	0 on success, negative on failure
+ */
+int ipa3_set_rx_moderation(u32 clnt_hdl, bool adaptive, u32 usecs,
+	u32 frames)
+{
+	struct ipa3_ep_context *ep;
+	struct ipa3_rx_moderation *mod;
+	u64 modt;
+
+	if (clnt_hdl >= ipa3_ctx->ipa_num_pipes ||
+	    ipa3_ctx->ep[clnt_hdl].valid == 0 || !frames) {
+		IPAERR("bad parm %u frames %u\n", clnt_hdl, frames);
+		return -EINVAL;
+	}
+
+	ep = &ipa3_ctx->ep[clnt_hdl];
+	if (ipa3_ctx->transport_prototype != IPA_TRANSPORT_TYPE_GSI ||
+	    ep->gsi_evt_ring_hdl == ~0)
+		return -EOPNOTSUPP;
+
+	modt = div_u64((u64)usecs * IPA_GSI_EVT_RING_INT_MODT_HZ,
+		USEC_PER_SEC);
+	mod = &ep->sys->mod;
+	mod->adaptive = adaptive;
+	mod->modt = min_t(u64, modt, U16_MAX);
+	mod->max_modc = min_t(u32, frames, U8_MAX);
+	mod->modc = adaptive ? 1 : mod->max_modc;
+	mod->events = 0;
+	mod->stamp = jiffies;
+
+	IPA_ACTIVE_CLIENTS_INC_EP(ep->client);
+	gsi_config_evt_ring_mod(ep->gsi_evt_ring_hdl, mod->modt, mod->modc);
+	IPA_ACTIVE_CLIENTS_DEC_EP(ep->client);
+
+	return 0;
+}
+
+/**
+ * ipa3_get_rx_moderation() - Get the interrupt moderation of a GSI pipe
+ * @clnt_hdl:	[in] opaque client handle assigned by IPA to client
+ * @adaptive:	[out] whether the moderation counter is tuned from the rate
+ * @usecs:	[out] moderation timer in microseconds
+ * @frames:	[out] moderation counter, its upper bound when @adaptive
+ *
+ * Returns:	0 on success, negative on failure
+ */
+int ipa3_get_rx_moderation(u32 clnt_hdl, bool *adaptive, u32 *usecs,
+	u32 *frames)
+{
+	struct ipa3_ep_context *ep;
+	struct ipa3_rx_moderation *mod;
+
+	if (clnt_hdl >= ipa3_ctx->ipa_num_pipes ||
+	    ipa3_ctx->ep[clnt_hdl].valid == 0) {
+		IPAERR("bad parm %u\n", clnt_hdl);
+		return -EINVAL;
+	}
+
+	ep = &ipa3_ctx->ep[clnt_hdl];
+	if (ipa3_ctx->transport_prototype != IPA_TRANSPORT_TYPE_GSI ||
+	    ep->gsi_evt_ring_hdl == ~0)
+		return -EOPNOTSUPP;
+
+	mod = &ep->sys->mod;
+	*adaptive = mod->adaptive;
+	*usecs = div_u64((u64)mod->modt * USEC_PER_SEC,
+		IPA_GSI_EVT_RING_INT_MODT_HZ);
+	*frames = mod->max_modc;
+
+	return 0;
+}
+
 static void ipa3_switch_to_intr_rx_work_func(struct work_struct *work)
 {
 	struct delayed_work *dwork;
@@ -1126,6 +1349,8 @@ int ipa3_setup_sys_pipe(struct ipa_sys_connect_params *sys_in, u32 *clnt_hdl)
 	ep->client_notify = sys_in->notify;
 	ep->priv = sys_in->priv;
 	ep->keep_ipa_awake = sys_in->keep_ipa_awake;
+	ep->napi_enabled = sys_in->napi_enabled;
+	INIT_WORK(&ep->sys->napi_clk_work, ipa3_rx_napi_clk_work_func);
 	atomic_set(&ep->avail_fifo_desc,
 		((sys_in->desc_fifo_sz/sizeof(struct sps_iovec))-1));
 
@@ -1245,6 +1470,11 @@ int ipa3_setup_sys_pipe(struct ipa_sys_connect_params *sys_in, u32 *clnt_hdl)
 
 	*clnt_hdl = ipa_ep_idx;
 
+	if (sys_in->client == IPA_CLIENT_APPS_LAN_CONS)
+		ipa3_rx_pool_init(ep->sys, lan_rx_page_pool_sz);
+	else if (sys_in->client == IPA_CLIENT_APPS_WAN_CONS)
+		ipa3_rx_pool_init(ep->sys, wan_rx_page_pool_sz);
+
 	if (IPA_CLIENT_IS_CONS(sys_in->client))
 		ipa3_replenish_rx_cache(ep->sys);
 
@@ -1483,6 +1713,9 @@ static void ipa3_tx_cmd_comp(void *user1, int user2)
  * ipa_sps_irq_tx_comp will call to the user supplied
  * callback (from ipa3_connect)
  *
+ * If meta->xmit_more is set, the doorbell is left for the next packet so
+ * that a burst from the stack is handed to the HW at once.
+ *
  * Returns:	0 on success, negative on failure
  */
 int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
@@ -1493,6 +1726,7 @@ int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 	struct ipa3_ip_packet_init *cmd;
 	struct ipa3_sys_context *sys;
 	int src_ep_idx;
+	bool ring_db = !(meta && meta->xmit_more);
 
 	memset(desc, 0, 3 * sizeof(struct ipa3_desc));
 
@@ -1571,7 +1805,7 @@ int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 			desc[2].dma_address = meta->dma_address;
 		}
 
-		if (ipa3_send(sys, 3, desc, true)) {
+		if (__ipa3_send(sys, 3, desc, true, ring_db)) {
 			IPAERR("fail to send immediate command\n");
 			goto fail_send;
 		}
@@ -1593,7 +1827,7 @@ int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 			desc[1].dma_address = meta->dma_address;
 		}
 
-		if (ipa3_send(sys, 2, desc, true)) {
+		if (__ipa3_send(sys, 2, desc, true, ring_db)) {
 			IPAERR("fail to send skb\n");
 			goto fail_gen;
 		}
@@ -1616,10 +1850,181 @@ static void ipa3_wq_handle_rx(struct work_struct *work)
 	ipa3_handle_rx(sys);
 }
 
+/**
+ * ipa3_rx_pool_init() - Set up the Rx page pool of a pipe
+ * @sys: system pipe context
+ * @size: number of pages, 0 to not use a pool
+ *
+ * Pages are allocated and mapped the first time their slot is used and
+ * stay mapped until the pool is destroyed.
+ */
+static void ipa3_rx_pool_init(struct ipa3_sys_context *sys, u32 size)
+{
+	struct ipa3_rx_page_pool *pool = &sys->page_pool;
+
+	memset(pool, 0, sizeof(*pool));
+	if (!size)
+		return;
+
+	pool->pages = kcalloc(size, sizeof(*pool->pages), GFP_KERNEL);
+	if (!pool->pages) {
+		IPAERR("fail to alloc rx page pool of %u\n", size);
+		return;
+	}
+	pool->size = size;
+	pool->order = get_order(IPA_GENERIC_RX_BUFF_BASE_SZ);
+}
+
+static void ipa3_rx_pool_destroy(struct ipa3_sys_context *sys)
+{
+	struct ipa3_rx_page_pool *pool = &sys->page_pool;
+	u32 i;
+
+	for (i = 0; i < pool->size; i++) {
+		if (!pool->pages[i].page)
+			continue;
+		dma_unmap_page(ipa3_ctx->pdev, pool->pages[i].dma_addr,
+			PAGE_SIZE << pool->order, DMA_FROM_DEVICE);
+		/* pages still held by the stack go away with their skb */
+		put_page(pool->pages[i].page);
+	}
+	kfree(pool->pages);
+	memset(pool, 0, sizeof(*pool));
+}
+
+/**
+ * ipa3_rx_pool_get() - Get the next page of the Rx page pool
+ * @sys: system pipe context
+ * @dma_addr: [out] DMA address of the buffer in the page
+ * @flag: allocation flags, if the slot has no page yet
+ *
+ * The pool keeps one reference on each of its pages. A page is free
+ * again once the skb built on it has been freed and that reference is
+ * the only one left. The page returned has another reference, owned by
+ * the descriptor and then by the skb built on it.
+ *
+ * Return: the page, or NULL if the next page is still in use
+ */
+static struct page *ipa3_rx_pool_get(struct ipa3_sys_context *sys,
+	dma_addr_t *dma_addr, gfp_t flag)
+{
+	struct ipa3_rx_page_pool *pool = &sys->page_pool;
+	struct ipa3_rx_page *slot;
+	struct page *page;
+	dma_addr_t addr;
+
+	if (!pool->size)
+		return NULL;
+
+	slot = &pool->pages[pool->next];
+	if (!slot->page) {
+		page = alloc_pages(flag | __GFP_COMP, pool->order);
+		if (!page)
+			return NULL;
+		addr = dma_map_page(ipa3_ctx->pdev, page, 0,
+			PAGE_SIZE << pool->order, DMA_FROM_DEVICE);
+		if (dma_mapping_error(ipa3_ctx->pdev, addr)) {
+			__free_pages(page, pool->order);
+			return NULL;
+		}
+		slot->page = page;
+		slot->dma_addr = addr;
+	} else if (page_count(slot->page) == 1) {
+		dma_sync_single_for_device(ipa3_ctx->pdev,
+			slot->dma_addr + NET_SKB_PAD, sys->rx_buff_sz,
+			DMA_FROM_DEVICE);
+	} else {
+		return NULL;
+	}
+
+	pool->next = (pool->next + 1) % pool->size;
+	get_page(slot->page);
+	*dma_addr = slot->dma_addr + NET_SKB_PAD;
+	return slot->page;
+}
+
+/**
+ * ipa3_alloc_rx_buff() - Allocate and map the buffer of an Rx descriptor
+ * @sys: system pipe context
+ * @rx_pkt: descriptor to fill
+ * @flag: allocation flags
+ *
+ * The buffer is a page of the Rx page pool of the pipe when one is free,
+ * otherwise a newly allocated and mapped skb.
+ *
+ * Return: 0 on success, negative on failure
+ */
+static int ipa3_alloc_rx_buff(struct ipa3_sys_context *sys,
+	struct ipa3_rx_pkt_wrapper *rx_pkt, gfp_t flag)
+{
+	void *ptr;
+
+	rx_pkt->page = ipa3_rx_pool_get(sys, &rx_pkt->data.dma_addr, flag);
+	if (rx_pkt->page) {
+		rx_pkt->data.skb = NULL;
+		return 0;
+	}
+
+	rx_pkt->data.skb = sys->get_skb(sys->rx_buff_sz, flag);
+	if (rx_pkt->data.skb == NULL)
+		return -ENOMEM;
+
+	ptr = skb_put(rx_pkt->data.skb, sys->rx_buff_sz);
+	rx_pkt->data.dma_addr = dma_map_single(ipa3_ctx->pdev, ptr,
+					     sys->rx_buff_sz,
+					     DMA_FROM_DEVICE);
+	if (rx_pkt->data.dma_addr == 0 ||
+			rx_pkt->data.dma_addr == ~0) {
+		sys->free_skb(rx_pkt->data.skb);
+		return -EFAULT;
+	}
+
+	return 0;
+}
+
+/* Release the buffer of an Rx descriptor which did not complete */
+static void ipa3_free_rx_buff(struct ipa3_sys_context *sys,
+	struct ipa3_rx_pkt_wrapper *rx_pkt)
+{
+	if (rx_pkt->page) {
+		put_page(rx_pkt->page);
+		return;
+	}
+
+	dma_unmap_single(ipa3_ctx->pdev, rx_pkt->data.dma_addr,
+			sys->rx_buff_sz, DMA_FROM_DEVICE);
+	sys->free_skb(rx_pkt->data.skb);
+}
+
+/*
+ * Build the skb of a completed descriptor around its pool page. The
+ * reference of the descriptor on the page goes to the skb.
+ */
+static struct sk_buff *ipa3_rx_page_build_skb(struct ipa3_sys_context *sys,
+	struct ipa3_rx_pkt_wrapper *rx_pkt)
+{
+	struct sk_buff *skb;
+
+	dma_sync_single_for_cpu(ipa3_ctx->pdev, rx_pkt->data.dma_addr,
+			sys->rx_buff_sz, DMA_FROM_DEVICE);
+	skb = build_skb(page_address(rx_pkt->page),
+			IPA_GENERIC_RX_BUFF_BASE_SZ);
+	if (unlikely(!skb)) {
+		pr_err_ratelimited("%s fail build skb sys=%p\n",
+				__func__, sys);
+		put_page(rx_pkt->page);
+		return NULL;
+	}
+
+	skb_reserve(skb, NET_SKB_PAD);
+	skb_put(skb, rx_pkt->len);
+
+	return skb;
+}
+
 static void ipa3_wq_repl_rx(struct work_struct *work)
 {
 	struct ipa3_sys_context *sys;
-	void *ptr;
 	struct ipa3_rx_pkt_wrapper *rx_pkt;
 	gfp_t flag = GFP_KERNEL;
 	u32 next;
@@ -1646,22 +2051,10 @@ begin:
 		INIT_WORK(&rx_pkt->work, ipa3_wq_rx_avail);
 		rx_pkt->sys = sys;
 
-		rx_pkt->data.skb = sys->get_skb(sys->rx_buff_sz, flag);
-		if (rx_pkt->data.skb == NULL) {
-			pr_err_ratelimited("%s fail alloc skb sys=%p\n",
+		if (ipa3_alloc_rx_buff(sys, rx_pkt, flag)) {
+			pr_err_ratelimited("%s fail alloc rx buff sys=%p\n",
 					__func__, sys);
-			goto fail_skb_alloc;
-		}
-		ptr = skb_put(rx_pkt->data.skb, sys->rx_buff_sz);
-		rx_pkt->data.dma_addr = dma_map_single(ipa3_ctx->pdev, ptr,
-						     sys->rx_buff_sz,
-						     DMA_FROM_DEVICE);
-		if (rx_pkt->data.dma_addr == 0 ||
-				rx_pkt->data.dma_addr == ~0) {
-			pr_err_ratelimited("%s dma map fail %p for %p sys=%p\n",
-			       __func__, (void *)rx_pkt->data.dma_addr,
-			       ptr, sys);
-			goto fail_dma_mapping;
+			goto fail_buff_alloc;
 		}
 
 		sys->repl.cache[curr] = rx_pkt;
@@ -1673,9 +2066,7 @@ begin:
 
 	return;
 
-fail_dma_mapping:
-	sys->free_skb(rx_pkt->data.skb);
-fail_skb_alloc:
+fail_buff_alloc:
 	kmem_cache_free(ipa3_ctx->rx_pkt_wrapper_cache, rx_pkt);
 fail_kmem_cache_alloc:
 	if (atomic_read(&sys->repl.tail_idx) ==
@@ -1865,7 +2256,6 @@ fail_kmem_cache_alloc:
  */
 static void ipa3_replenish_rx_cache(struct ipa3_sys_context *sys)
 {
-	void *ptr;
 	struct ipa3_rx_pkt_wrapper *rx_pkt;
 	int ret;
 	int rx_len_cached = 0;
@@ -1886,20 +2276,9 @@ static void ipa3_replenish_rx_cache(struct ipa3_sys_context *sys)
 		INIT_WORK(&rx_pkt->work, ipa3_wq_rx_avail);
 		rx_pkt->sys = sys;
 
-		rx_pkt->data.skb = sys->get_skb(sys->rx_buff_sz, flag);
-		if (rx_pkt->data.skb == NULL) {
-			IPAERR("failed to alloc skb\n");
-			goto fail_skb_alloc;
-		}
-		ptr = skb_put(rx_pkt->data.skb, sys->rx_buff_sz);
-		rx_pkt->data.dma_addr = dma_map_single(ipa3_ctx->pdev, ptr,
-						     sys->rx_buff_sz,
-						     DMA_FROM_DEVICE);
-		if (rx_pkt->data.dma_addr == 0 ||
-				rx_pkt->data.dma_addr == ~0) {
-			IPAERR("dma_map_single failure %p for %p\n",
-			       (void *)rx_pkt->data.dma_addr, ptr);
-			goto fail_dma_mapping;
+		if (ipa3_alloc_rx_buff(sys, rx_pkt, flag)) {
+			IPAERR("failed to alloc rx buff\n");
+			goto fail_buff_alloc;
 		}
 
 		list_add_tail(&rx_pkt->link, &sys->head_desc_list);
@@ -1939,11 +2318,8 @@ static void ipa3_replenish_rx_cache(struct ipa3_sys_context *sys)
 fail_provide_rx_buffer:
 	list_del(&rx_pkt->link);
 	rx_len_cached = --sys->len;
-	dma_unmap_single(ipa3_ctx->pdev, rx_pkt->data.dma_addr,
-			sys->rx_buff_sz, DMA_FROM_DEVICE);
-fail_dma_mapping:
-	sys->free_skb(rx_pkt->data.skb);
-fail_skb_alloc:
+	ipa3_free_rx_buff(sys, rx_pkt);
+fail_buff_alloc:
 	kmem_cache_free(ipa3_ctx->rx_pkt_wrapper_cache, rx_pkt);
 fail_kmem_cache_alloc:
 	if (rx_len_cached == 0)
@@ -2044,9 +2420,7 @@ static void ipa3_cleanup_rx(struct ipa3_sys_context *sys)
 	list_for_each_entry_safe(rx_pkt, r,
 				 &sys->head_desc_list, link) {
 		list_del(&rx_pkt->link);
-		dma_unmap_single(ipa3_ctx->pdev, rx_pkt->data.dma_addr,
-			sys->rx_buff_sz, DMA_FROM_DEVICE);
-		sys->free_skb(rx_pkt->data.skb);
+		ipa3_free_rx_buff(sys, rx_pkt);
 		kmem_cache_free(ipa3_ctx->rx_pkt_wrapper_cache, rx_pkt);
 	}
 
@@ -2055,14 +2429,14 @@ static void ipa3_cleanup_rx(struct ipa3_sys_context *sys)
 		tail = atomic_read(&sys->repl.tail_idx);
 		while (head != tail) {
 			rx_pkt = sys->repl.cache[head];
-			dma_unmap_single(ipa3_ctx->pdev, rx_pkt->data.dma_addr,
-					sys->rx_buff_sz, DMA_FROM_DEVICE);
-			sys->free_skb(rx_pkt->data.skb);
+			ipa3_free_rx_buff(sys, rx_pkt);
 			kmem_cache_free(ipa3_ctx->rx_pkt_wrapper_cache, rx_pkt);
 			head = (head + 1) % sys->repl.capacity;
 		}
 		kfree(sys->repl.cache);
 	}
+
+	ipa3_rx_pool_destroy(sys);
 }
 
 
@@ -2327,7 +2701,7 @@ static struct sk_buff *ipa3_join_prev_skb(struct sk_buff *prev_skb,
 	struct sk_buff *skb2;
 
 	skb2 = skb_copy_expand(prev_skb, 0,
-			len, GFP_KERNEL);
+			len, gfp_any());
 	if (likely(skb2)) {
 		memcpy(skb_put(skb2, len),
 			skb->data, len);
@@ -2480,7 +2854,7 @@ static int ipa3_wan_rx_pyld_hdlr(struct sk_buff *skb,
 			frame_len += IPA_DL_CHECKSUM_LENGTH;
 		IPADBG("frame_len %d\n", frame_len);
 
-		skb2 = skb_clone(skb, GFP_KERNEL);
+		skb2 = skb_clone(skb, gfp_any());
 		if (likely(skb2)) {
 			/*
 			 * the len of actual data is smaller than expected
@@ -2588,14 +2962,22 @@ static void ipa3_wq_rx_common(struct ipa3_sys_context *sys, u32 size)
 	sys->len--;
 	if (size)
 		rx_pkt_expected->len = size;
-	rx_skb = rx_pkt_expected->data.skb;
-	dma_unmap_single(ipa3_ctx->pdev, rx_pkt_expected->data.dma_addr,
+	if (rx_pkt_expected->page) {
+		rx_skb = ipa3_rx_page_build_skb(sys, rx_pkt_expected);
+	} else {
+		rx_skb = rx_pkt_expected->data.skb;
+		dma_unmap_single(ipa3_ctx->pdev,
+			rx_pkt_expected->data.dma_addr,
 			sys->rx_buff_sz, DMA_FROM_DEVICE);
-	skb_set_tail_pointer(rx_skb, rx_pkt_expected->len);
-	rx_skb->len = rx_pkt_expected->len;
-	*(unsigned int *)rx_skb->cb = rx_skb->len;
-	rx_skb->truesize = rx_pkt_expected->len + sizeof(struct sk_buff);
-	sys->pyld_hdlr(rx_skb, sys);
+		skb_set_tail_pointer(rx_skb, rx_pkt_expected->len);
+		rx_skb->len = rx_pkt_expected->len;
+	}
+	if (likely(rx_skb)) {
+		*(unsigned int *)rx_skb->cb = rx_skb->len;
+		rx_skb->truesize = rx_pkt_expected->len +
+			sizeof(struct sk_buff);
+		sys->pyld_hdlr(rx_skb, sys);
+	}
 	sys->repl_hdlr(sys);
 	kmem_cache_free(ipa3_ctx->rx_pkt_wrapper_cache, rx_pkt_expected);
 
@@ -3306,7 +3688,7 @@ static void ipa_gsi_irq_rx_notify_cb(struct gsi_chan_xfer_notify *notify)
 				GSI_CHAN_MODE_POLL);
 			ipa3_inc_acquire_wakelock();
 			atomic_set(&sys->curr_polling_state, 1);
-			queue_work(sys->wq, &sys->work);
+			ipa3_rx_schedule_poll(sys);
 		}
 		break;
 	default:
@@ -3396,8 +3778,12 @@ static int ipa_gsi_setup_channel(struct ipa3_ep_context *ep)
 		ep->gsi_mem_info.evt_ring_base_vaddr =
 			gsi_evt_ring_props.ring_base_vaddr;
 
-		gsi_evt_ring_props.int_modt = IPA_GSI_EVT_RING_INT_MODT;
-		gsi_evt_ring_props.int_modc = 1;
+		ep->sys->mod.modt = IPA_GSI_EVT_RING_INT_MODT;
+		ep->sys->mod.max_modc = 1;
+		ep->sys->mod.modc = 1;
+		ep->sys->mod.stamp = jiffies;
+		gsi_evt_ring_props.int_modt = ep->sys->mod.modt;
+		gsi_evt_ring_props.int_modc = ep->sys->mod.modc;
 		gsi_evt_ring_props.rp_update_addr = 0;
 		gsi_evt_ring_props.exclusive = true;
 		gsi_evt_ring_props.err_cb = ipa_gsi_evt_ring_err_cb;
@@ -512,6 +512,7 @@ struct ipa3_ep_context {
 	u32 dflt_flt6_rule_hdl;
 	bool skip_ep_cfg;
 	bool keep_ipa_awake;
+	bool napi_enabled;
 	struct ipa3_wlan_stats wstats;
 	u32 wdi_state;
 	bool disconnect_in_progress;
@@ -548,6 +549,48 @@ struct ipa3_repl_ctx {
 	u32 capacity;
 };
 
+/**
+ * struct ipa3_rx_page - slot of an Rx page pool
+ * @page: compound page holding an Rx buffer and its skb_shared_info
+ * @dma_addr: DMA address of @page, mapped for as long as the pool lives
+ */
+struct ipa3_rx_page {
+	struct page *page;
+	dma_addr_t dma_addr;
+};
+
+/**
+ * struct ipa3_rx_page_pool - Rx buffers recycled once the stack frees them
+ * @pages: slots of the pool, given a page the first time they are used
+ * @size: number of slots, 0 if the pipe does not use a pool
+ * @next: slot to hand out next
+ * @order: allocation order of the pages
+ */
+struct ipa3_rx_page_pool {
+	struct ipa3_rx_page *pages;
+	u32 size;
+	u32 next;
+	u32 order;
+};
+
+/**
+ * struct ipa3_rx_moderation - GSI event ring interrupt moderation of a pipe
+ * @adaptive: tune @modc from the event rate, up to @max_modc
+ * @modt: moderation timer in 32KHz cycles, bounds the added latency
+ * @max_modc: moderation counter, or its upper bound when @adaptive
+ * @modc: moderation counter currently programmed
+ * @events: events processed since @stamp
+ * @stamp: jiffies at the start of the current sampling window
+ */
+struct ipa3_rx_moderation {
+	bool adaptive;
+	u16 modt;
+	u8 max_modc;
+	u8 modc;
+	u32 events;
+	unsigned long stamp;
+};
+
 struct ipa3_sys_context {
 	u32 len;
 	struct sps_register_event event;
@@ -570,6 +613,10 @@ struct ipa3_sys_context {
 	struct work_struct repl_work;
 	void (*repl_hdlr)(struct ipa3_sys_context *sys);
 	struct ipa3_repl_ctx repl;
+	struct ipa3_rx_page_pool page_pool;
+	struct work_struct napi_clk_work;
+	bool db_pending;
+	struct ipa3_rx_moderation mod;
 
 	
 	struct ipa3_ep_context *ep;
@@ -628,6 +675,7 @@ struct ipa3_desc {
 struct ipa3_rx_pkt_wrapper {
 	struct list_head link;
 	struct ipa_rx_data data;
+	struct page *page;
 	u32 len;
 	struct work_struct work;
 	struct ipa3_sys_context *sys;
@@ -1332,6 +1380,14 @@ int ipa3_setup_sys_pipe(struct ipa_sys_connect_params *sys_in, u32 *clnt_hdl);
 
 int ipa3_teardown_sys_pipe(u32 clnt_hdl);
 
+int ipa3_rx_poll(u32 clnt_hdl, int budget);
+
+int ipa3_set_rx_moderation(u32 clnt_hdl, bool adaptive, u32 usecs,
+	u32 frames);
+
+int ipa3_get_rx_moderation(u32 clnt_hdl, bool *adaptive, u32 *usecs,
+	u32 *frames);
+
 int ipa3_sys_setup(struct ipa_sys_connect_params *sys_in,
 	unsigned long *ipa_bam_hdl,
 	u32 *ipa_pipe_num, u32 *clnt_hdl, bool en_status);
@@ -24,6 +24,7 @@
 #define IPA_NAT_SYSTEM_MEMORY  0
 #define IPA_NAT_SHARED_MEMORY  1
 #define IPA_NAT_TEMP_MEM_SIZE 128
+#define IPA_NAT_DMA_BATCH_MAX 32
 
 static int ipa3_nat_vma_fault_remap(
 	 struct vm_area_struct *vma, struct vm_fault *vmf)
@@ -556,12 +557,10 @@ bail:
  */
 int ipa3_nat_dma_cmd(struct ipa_ioc_nat_dma_cmd *dma)
 {
-#define NUM_OF_DESC 2
-
 	struct ipa3_register_write *reg_write_nop = NULL;
 	struct ipa3_nat_dma *cmd = NULL;
 	struct ipa3_desc *desc = NULL;
-	u16 size = 0, cnt = 0;
+	u16 size = 0, cnt = 0, batch, i;
 	int ret = 0;
 
 	IPADBG("\n");
@@ -572,7 +571,9 @@ int ipa3_nat_dma_cmd(struct ipa_ioc_nat_dma_cmd *dma)
 		goto bail;
 	}
 
-	size = sizeof(struct ipa3_desc) * NUM_OF_DESC;
+	batch = min_t(u16, dma->entries, IPA_NAT_DMA_BATCH_MAX);
+
+	size = sizeof(struct ipa3_desc) * (batch + 1);
 	desc = kzalloc(size, GFP_KERNEL);
 	if (desc == NULL) {
 		IPAERR("Failed to alloc memory\n");
@@ -580,7 +581,7 @@ int ipa3_nat_dma_cmd(struct ipa_ioc_nat_dma_cmd *dma)
 		goto bail;
 	}
 
-	size = sizeof(struct ipa3_nat_dma);
+	size = sizeof(struct ipa3_nat_dma) * batch;
 	cmd = kzalloc(size, GFP_KERNEL);
 	if (cmd == NULL) {
 		IPAERR("Failed to alloc memory\n");
@@ -600,31 +601,38 @@ int ipa3_nat_dma_cmd(struct ipa_ioc_nat_dma_cmd *dma)
 	reg_write_nop->pipeline_clear_options = IPA_HPS_CLEAR;
 	reg_write_nop->value_mask = 0x0;
 
-	desc[0].type = IPA_IMM_CMD_DESC;
-	desc[0].opcode = IPA_REGISTER_WRITE;
-	desc[0].callback = NULL;
-	desc[0].user1 = NULL;
-	desc[0].user2 = 0;
-	desc[0].len = sizeof(*reg_write_nop);
-	desc[0].pyld = (void *)reg_write_nop;
+	/*
+	 * Chain up to IPA_NAT_DMA_BATCH_MAX NAT_DMA commands behind a single
+	 * pipeline clear and wait once per chain, instead of clearing the
+	 * pipeline and waiting for every entry.
+	 */
+	while (cnt < dma->entries) {
+		batch = min_t(u16, dma->entries - cnt, IPA_NAT_DMA_BATCH_MAX);
+		memset(desc, 0, sizeof(struct ipa3_desc) * (batch + 1));
+
+		desc[0].type = IPA_IMM_CMD_DESC;
+		desc[0].opcode = IPA_REGISTER_WRITE;
+		desc[0].len = sizeof(*reg_write_nop);
+		desc[0].pyld = (void *)reg_write_nop;
+
+		for (i = 0; i < batch; i++, cnt++) {
+			cmd[i].table_index = dma->dma[cnt].table_index;
+			cmd[i].base_addr = dma->dma[cnt].base_addr;
+			cmd[i].offset = dma->dma[cnt].offset;
+			cmd[i].data = dma->dma[cnt].data;
+
+			desc[i + 1].type = IPA_IMM_CMD_DESC;
+			desc[i + 1].opcode = IPA_NAT_DMA;
+			desc[i + 1].len = sizeof(struct ipa3_nat_dma);
+			desc[i + 1].pyld = (void *)&cmd[i];
+		}
 
-	for (cnt = 0; cnt < dma->entries; cnt++) {
-		cmd->table_index = dma->dma[cnt].table_index;
-		cmd->base_addr = dma->dma[cnt].base_addr;
-		cmd->offset = dma->dma[cnt].offset;
-		cmd->data = dma->dma[cnt].data;
-
-		desc[1].type = IPA_IMM_CMD_DESC;
-		desc[1].opcode = IPA_NAT_DMA;
-		desc[1].callback = NULL;
-		desc[1].user1 = NULL;
-		desc[1].user2 = 0;
-		desc[1].len = sizeof(struct ipa3_nat_dma);
-		desc[1].pyld = (void *)cmd;
-
-		ret = ipa3_send_cmd(NUM_OF_DESC, desc);
-		if (ret == -EPERM)
-			IPAERR("Fail to send immediate command %d\n", cnt);
+		ret = ipa3_send_cmd(batch + 1, desc);
+		if (ret) {
+			IPAERR("Fail to send immediate command chain at %d\n",
+				cnt - batch);
+			goto bail;
+		}
 	}
 
 bail:
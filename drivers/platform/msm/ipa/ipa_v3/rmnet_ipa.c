@@ -16,6 +16,7 @@
 
 #include <linux/completion.h>
 #include <linux/errno.h>
+#include <linux/ethtool.h>
 #include <linux/if_arp.h>
 #include <linux/interrupt.h>
 #include <linux/init.h>
@@ -51,6 +52,7 @@
 #define IPA_WWAN_DEVICE_COUNT (1)
 
 #define IPA_WWAN_RX_SOFTIRQ_THRESH 16
+#define IPA_WWAN_NAPI_WEIGHT 64
 
 #define INVALID_MUX_ID 0xFF
 #define IPA_QUOTA_REACH_ALERT_MAX_SIZE 64
@@ -115,6 +117,7 @@ struct ipa3_wwan_private {
 	spinlock_t lock;
 	struct completion resource_granted_completion;
 	enum ipa3_wwan_device_status device_status;
+	struct napi_struct napi;
 };
 
 /**
@@ -1024,6 +1027,7 @@ static int ipa3_wwan_xmit(struct sk_buff *skb, struct net_device *dev)
 {
 	int ret = 0;
 	struct ipa3_wwan_private *wwan_ptr = netdev_priv(dev);
+	struct ipa_tx_meta meta = {0};
 
 	if (netif_queue_stopped(dev)) {
 		IPAWANERR("[%s]fatal: ipa3_wwan_xmit stopped\n", dev->name);
@@ -1059,7 +1063,14 @@ static int ipa3_wwan_xmit(struct sk_buff *skb, struct net_device *dev)
 		ret = NETDEV_TX_BUSY;
 		goto out;
 	}
-	ret = ipa3_tx_dp(IPA_CLIENT_APPS_LAN_WAN_PROD, skb, NULL);
+	/*
+	 * Leave the doorbell to the next packet of a burst, unless this one
+	 * fills the pipe and the queue will be stopped before it comes.
+	 */
+	meta.xmit_more = skb->xmit_more &&
+		atomic_read(&wwan_ptr->outstanding_pkts) + 1 <
+		wwan_ptr->outstanding_high;
+	ret = ipa3_tx_dp(IPA_CLIENT_APPS_LAN_WAN_PROD, skb, &meta);
 	if (ret) {
 		ret = NETDEV_TX_BUSY;
 		dev->stats.tx_dropped++;
@@ -1143,19 +1154,33 @@ static void apps_ipa_packet_receive_notify(void *priv,
 {
 	struct sk_buff *skb = (struct sk_buff *)data;
 	struct net_device *dev = (struct net_device *)priv;
+	struct ipa3_wwan_private *wwan_ptr = netdev_priv(dev);
 	int result;
-	unsigned int packet_len = skb->len;
+	unsigned int packet_len;
 
-	IPAWANDBG("Rx packet was received");
-	if (evt != IPA_RECEIVE) {
+	switch (evt) {
+	case IPA_RECEIVE:
+		break;
+	case IPA_CLIENT_START_POLL:
+		napi_schedule(&wwan_ptr->napi);
+		return;
+	case IPA_CLIENT_COMP_NAPI:
+		napi_complete(&wwan_ptr->napi);
+		return;
+	default:
 		IPAWANERR("A none IPA_RECEIVE event in wan_ipa_receive\n");
 		return;
 	}
 
+	IPAWANDBG("Rx packet was received");
+	packet_len = skb->len;
 	skb->dev = ipa3_netdevs[0];
 	skb->protocol = htons(ETH_P_MAP);
 
-	if (dev->stats.rx_packets % IPA_WWAN_RX_SOFTIRQ_THRESH == 0) {
+	if (in_serving_softirq()) {
+		/* called from ipa3_rmnet_poll() */
+		result = netif_receive_skb(skb);
+	} else if (dev->stats.rx_packets % IPA_WWAN_RX_SOFTIRQ_THRESH == 0) {
 		trace_rmnet_ipa_netifni3(dev->stats.rx_packets);
 		result = netif_rx_ni(skb);
 	} else {
@@ -1172,6 +1197,20 @@ static void apps_ipa_packet_receive_notify(void *priv,
 	dev->stats.rx_bytes += packet_len;
 }
 
+/**
+ * ipa3_rmnet_poll() - NAPI poll function of the WAN consumer pipe
+ * @napi: NAPI instance of the wwan device
+ * @budget: maximum number of descriptors to process
+ *
+ * The pipe is scheduled for polling from its interrupt, see
+ * apps_ipa_packet_receive_notify(), and completed by ipa3_rx_poll() once
+ * it is empty.
+ */
+static int ipa3_rmnet_poll(struct napi_struct *napi, int budget)
+{
+	return ipa3_rx_poll(ipa3_to_apps_hdl, budget);
+}
+
 /**
  * ipa3_wwan_ioctl() - I/O control for wwan network driver.
  *
@@ -1503,6 +1542,7 @@ static int ipa3_wwan_ioctl(struct net_device *dev, struct ifreq *ifr, int cmd)
 				apps_ipa_packet_receive_notify;
 			ipa_to_apps_ep_cfg.desc_fifo_sz = IPA_SYS_DESC_FIFO_SZ;
 			ipa_to_apps_ep_cfg.priv = dev;
+			ipa_to_apps_ep_cfg.napi_enabled = true;
 
 			mutex_lock(&ipa_to_apps_pipe_handle_guard);
 			if (atomic_read(&is_ssr)) {
@@ -1590,6 +1630,47 @@ static const struct net_device_ops ipa3_wwan_ops_ip = {
 	.ndo_validate_addr = 0,
 };
 
+/*
+ * Rx coalescing maps to the moderation of the WAN consumer's event ring:
+ * rx-usecs is its timer and rx-frames its counter, or the upper bound of
+ * the counter when adaptive-rx is on.
+ */
+static int ipa3_wwan_get_coalesce(struct net_device *dev,
+		struct ethtool_coalesce *ec)
+{
+	bool adaptive;
+	int ret;
+
+	mutex_lock(&ipa_to_apps_pipe_handle_guard);
+	ret = ipa3_get_rx_moderation(ipa3_to_apps_hdl, &adaptive,
+		&ec->rx_coalesce_usecs, &ec->rx_max_coalesced_frames);
+	mutex_unlock(&ipa_to_apps_pipe_handle_guard);
+	if (ret)
+		return ret;
+
+	ec->use_adaptive_rx_coalesce = adaptive;
+	return 0;
+}
+
+static int ipa3_wwan_set_coalesce(struct net_device *dev,
+		struct ethtool_coalesce *ec)
+{
+	int ret;
+
+	mutex_lock(&ipa_to_apps_pipe_handle_guard);
+	ret = ipa3_set_rx_moderation(ipa3_to_apps_hdl,
+		ec->use_adaptive_rx_coalesce, ec->rx_coalesce_usecs,
+		ec->rx_max_coalesced_frames);
+	mutex_unlock(&ipa_to_apps_pipe_handle_guard);
+
+	return ret;
+}
+
+static const struct ethtool_ops ipa3_wwan_ethtool_ops = {
+	.get_coalesce = ipa3_wwan_get_coalesce,
+	.set_coalesce = ipa3_wwan_set_coalesce,
+};
+
 /**
  * wwan_setup() - Setups the wwan network driver.
  *
@@ -1602,6 +1683,7 @@ static const struct net_device_ops ipa3_wwan_ops_ip = {
 static void ipa3_wwan_setup(struct net_device *dev)
 {
 	dev->netdev_ops = &ipa3_wwan_ops_ip;
+	dev->ethtool_ops = &ipa3_wwan_ethtool_ops;
 	ether_setup(dev);
 	/* set this after calling ether_setup */
 	dev->header_ops = 0;  /* No header */
@@ -1975,6 +2057,8 @@ static int ipa3_wwan_probe(struct platform_device *pdev)
 	atomic_set(&wwan_ptr->outstanding_pkts, 0);
 	spin_lock_init(&wwan_ptr->lock);
 	init_completion(&wwan_ptr->resource_granted_completion);
+	netif_napi_add(dev, &wwan_ptr->napi, ipa3_rmnet_poll,
+		       IPA_WWAN_NAPI_WEIGHT);
 
 	if (!atomic_read(&is_ssr)) {
 		/* IPA_RM configuration starts */
@@ -2024,6 +2108,7 @@ static int ipa3_wwan_probe(struct platform_device *pdev)
 		goto set_perf_err;
 	}
 
+	napi_enable(&wwan_ptr->napi);
 	IPAWANDBG("IPA-WWAN devices (%s) initialization ok :>>>>\n",
 			ipa3_netdevs[0]->name);
 	if (ret) {
@@ -2063,6 +2148,7 @@ timer_init_err:
 create_rsrc_err:
 	ipa3_q6_deinitialize_rm();
 q6_init_err:
+	netif_napi_del(&wwan_ptr->napi);
 	free_netdev(ipa3_netdevs[0]);
 	ipa3_netdevs[0] = NULL;
 alloc_netdev_err:
@@ -2079,6 +2165,7 @@ setup_a7_qmap_hdr_err:
 
 static int ipa3_wwan_remove(struct platform_device *pdev)
 {
+	struct ipa3_wwan_private *wwan_ptr = netdev_priv(ipa3_netdevs[0]);
 	int ret;
 
 	pr_info("rmnet_ipa started deinitialization\n");
@@ -2089,6 +2176,8 @@ static int ipa3_wwan_remove(struct platform_device *pdev)
 	else
 		ipa3_to_apps_hdl = -1;
 	mutex_unlock(&ipa_to_apps_pipe_handle_guard);
+	napi_disable(&wwan_ptr->napi);
+	netif_napi_del(&wwan_ptr->napi);
 	unregister_netdev(ipa3_netdevs[0]);
 	ret = ipa3_rm_delete_dependency(IPA_RM_RESOURCE_WWAN_0_PROD,
 		IPA_RM_RESOURCE_Q6_CONS);
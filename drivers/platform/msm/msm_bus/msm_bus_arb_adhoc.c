@@ -16,6 +16,8 @@
 #include <linux/slab.h>
 #include <linux/rtmutex.h>
 #include <linux/clk.h>
+#include <linux/hrtimer.h>
+#include <linux/workqueue.h>
 #include <linux/msm-bus.h>
 #include "msm_bus_core.h"
 #include "msm_bus_adhoc.h"
@@ -42,6 +44,19 @@ static LIST_HEAD(commit_list);
 
 DEFINE_RT_MUTEX(msm_bus_adhoc_lock);
 
+/*
+ * Votes from clients that are not latency critical are held back for
+ * up to commit_window_us, so that the updates of several clients in a
+ * display commit or GPU frequency change reach each node as a single
+ * request. 0 commits every vote as it comes.
+ */
+static unsigned int commit_window_us;
+module_param(commit_window_us, uint, 0644);
+
+static struct hrtimer commit_timer;
+static void commit_work_fn(struct work_struct *work);
+static DECLARE_WORK(commit_work, commit_work_fn);
+
 static bool chk_bl_list(struct list_head *black_list, unsigned int id)
 {
 	struct msm_bus_node_device_type *bus_node = NULL;
@@ -660,6 +675,43 @@ static void commit_data(void)
 	INIT_LIST_HEAD(&commit_list);
 }
 
+static void commit_work_fn(struct work_struct *work)
+{
+	rt_mutex_lock(&msm_bus_adhoc_lock);
+	if (!list_empty(&commit_list))
+		commit_data();
+	rt_mutex_unlock(&msm_bus_adhoc_lock);
+}
+
+static enum hrtimer_restart commit_timer_fn(struct hrtimer *timer)
+{
+	queue_work(system_highpri_wq, &commit_work);
+	return HRTIMER_NORESTART;
+}
+
+/*
+ * Commit the dirty nodes now or within the commit window. The nodes
+ * stay on commit_list until then, so later votes on the same node are
+ * aggregated into the same request. An immediate commit also flushes
+ * whatever an earlier vote left queued. Caller holds msm_bus_adhoc_lock.
+ */
+static void commit_data_window(bool latency_critical)
+{
+	if (list_empty(&commit_list))
+		return;
+
+	if (!commit_window_us || latency_critical) {
+		hrtimer_try_to_cancel(&commit_timer);
+		commit_data();
+		return;
+	}
+
+	if (!hrtimer_active(&commit_timer))
+		hrtimer_start(&commit_timer,
+			ns_to_ktime((u64)commit_window_us * NSEC_PER_USEC),
+			HRTIMER_MODE_REL);
+}
+
 static void add_node_to_clist(struct msm_bus_node_device_type *node)
 {
 	struct msm_bus_node_device_type *node_parent =
@@ -1104,7 +1156,7 @@ static int update_client_paths(struct msm_bus_client *client, bool log_trns,
 		if (log_trns)
 			getpath_debug(src, lnode, pdata->active_only);
 	}
-	commit_data();
+	commit_data_window(pdata->latency_critical);
 exit_update_client_paths:
 	return ret;
 }
@@ -1278,7 +1330,7 @@ static int update_bw_adhoc(struct msm_bus_client_handle *cl, u64 ab, u64 ib)
 		goto exit_update_request;
 	}
 
-	commit_data();
+	commit_data_window(cl->latency_critical);
 	cl->cur_act_ib = ib;
 	cl->cur_act_ab = ab;
 	cl->cur_slp_ib = slp_ib;
@@ -1324,7 +1376,7 @@ static int update_bw_context(struct msm_bus_client_handle *cl, u64 act_ab,
 				__func__, ret, cl->active_only);
 		goto exit_change_context;
 	}
-	commit_data();
+	commit_data_window(cl->latency_critical);
 	cl->cur_act_ib = act_ib;
 	cl->cur_act_ab = act_ab;
 	cl->cur_slp_ib = slp_ib;
@@ -1429,4 +1481,7 @@ void msm_bus_arb_setops_adhoc(struct msm_bus_arb_ops *arb_ops)
 	arb_ops->unregister = unregister_adhoc;
 	arb_ops->update_bw = update_bw_adhoc;
 	arb_ops->update_bw_context = update_bw_context;
+
+	hrtimer_init(&commit_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	commit_timer.function = commit_timer_fn;
 }
@@ -86,6 +86,9 @@ static struct msm_bus_scale_pdata *get_pdata(struct platform_device *pdev,
 		pr_debug("Using dual context by default\n");
 	}
 
+	if (of_property_read_bool(of_node, "qcom,msm-bus,latency-critical"))
+		pdata->latency_critical = 1;
+
 	usecase = devm_kzalloc(&pdev->dev, (sizeof(struct msm_bus_paths) *
 		pdata->num_usecases), GFP_KERNEL);
 	if (!usecase) {
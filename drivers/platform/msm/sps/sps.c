@@ -1265,6 +1265,38 @@ static inline void sps_bam_unlock(struct sps_bam *bam)
 	spin_unlock_irqrestore(&bam->connection_lock, bam->irqsave_flags);
 }
 
+/**
+ * Lock BAM device for a transfer
+ *
+ * Pipes connected with SPS_O_SINGLE_PRODUCER are only submitted to from
+ * one context at a time. Their descriptors are made visible to the
+ * hardware by the write offset update, so the producer does not need to
+ * exclude the completion path and the BAM lock is not taken.
+ *
+ * @pipe - pointer to client pipe state
+ *
+ * @return pointer to BAM device struct, or NULL on error
+ *
+ */
+static struct sps_bam *sps_bam_lock_xfer(struct sps_pipe *pipe)
+{
+	if (!pipe->sys.single_producer)
+		return sps_bam_lock(pipe);
+
+	if (pipe->bam == NULL)
+		SPS_ERR(sps, "sps:%s:Connection is not in connected state.",
+				__func__);
+
+	return pipe->bam;
+}
+
+static inline void sps_bam_unlock_xfer(struct sps_pipe *pipe,
+				       struct sps_bam *bam)
+{
+	if (!pipe->sys.single_producer)
+		sps_bam_unlock(bam);
+}
+
 /**
  * Connect an SPS connection end point
  *
@@ -1618,7 +1650,7 @@ int sps_transfer(struct sps_pipe *h, struct sps_transfer *transfer)
 		iovec++;
 	}
 
-	bam = sps_bam_lock(pipe);
+	bam = sps_bam_lock_xfer(pipe);
 	if (bam == NULL)
 		return SPS_ERROR;
 
@@ -1626,7 +1658,7 @@ int sps_transfer(struct sps_pipe *h, struct sps_transfer *transfer)
 
 	result = sps_bam_pipe_transfer(bam, pipe->pipe_index, transfer);
 
-	sps_bam_unlock(bam);
+	sps_bam_unlock_xfer(pipe, bam);
 
 	return result;
 }
@@ -1651,7 +1683,7 @@ int sps_transfer_one(struct sps_pipe *h, phys_addr_t addr, u32 size,
 	if (sps_check_iovec_flags(flags))
 		return SPS_ERROR;
 
-	bam = sps_bam_lock(pipe);
+	bam = sps_bam_lock_xfer(pipe);
 	if (bam == NULL)
 		return SPS_ERROR;
 
@@ -1661,12 +1693,51 @@ int sps_transfer_one(struct sps_pipe *h, phys_addr_t addr, u32 size,
 				SPS_GET_LOWER_ADDR(addr), size, user,
 				DESC_FLAG_WORD(flags, addr));
 
-	sps_bam_unlock(bam);
+	sps_bam_unlock_xfer(pipe, bam);
 
 	return result;
 }
 EXPORT_SYMBOL(sps_transfer_one);
 
+/**
+ * Submit several descriptors to an SPS connection end point
+ *
+ */
+int sps_transfer_batch(struct sps_pipe *h, struct sps_iovec *iovec,
+		       void **user, u32 count)
+{
+	struct sps_pipe *pipe = h;
+	struct sps_bam *bam;
+	int result;
+	u32 i;
+
+	if (h == NULL) {
+		SPS_ERR(sps, "sps:%s:pipe is NULL.\n", __func__);
+		return SPS_ERROR;
+	} else if (iovec == NULL) {
+		SPS_ERR(sps, "sps:%s:iovec list is NULL.\n", __func__);
+		return SPS_ERROR;
+	}
+
+	for (i = 0; i < count; i++)
+		if (sps_check_iovec_flags(iovec[i].flags))
+			return SPS_ERROR;
+
+	bam = sps_bam_lock_xfer(pipe);
+	if (bam == NULL)
+		return SPS_ERROR;
+
+	SPS_DBG(bam, "sps:%s: %d descriptors.\n", __func__, count);
+
+	result = sps_bam_pipe_transfer_batch(bam, pipe->pipe_index, iovec,
+					     user, count);
+
+	sps_bam_unlock_xfer(pipe, bam);
+
+	return result;
+}
+EXPORT_SYMBOL(sps_transfer_batch);
+
 /**
  * Read event queue for an SPS connection end point
  *
@@ -1294,6 +1294,7 @@ int sps_bam_pipe_set_params(struct sps_bam *dev, u32 pipe_index, u32 options)
 	pipe->wake_up_is_one_shot = wake_up_is_one_shot;
 	pipe->sys.no_queue = no_queue;
 	pipe->sys.ack_xfers = ack_xfers;
+	pipe->sys.single_producer = options & SPS_O_SINGLE_PRODUCER;
 
 	return 0;
 }
@@ -1420,9 +1421,11 @@ int sps_bam_pipe_transfer_one(struct sps_bam *dev,
 		/*
 		 * If pipe is polled and client is not ACK'ing descriptors,
 		 * perform polling operation so that any outstanding ACKs
-		 * can occur.
+		 * can occur. This needs the BAM lock, which a single
+		 * producer does not hold.
 		 */
-		if (!pipe->sys.ack_xfers && pipe->polled) {
+		if (!pipe->sys.ack_xfers && pipe->polled &&
+		    !pipe->sys.single_producer) {
 			pipe_handler_eot(dev, pipe);
 			if (next_write == pipe->sys.acked_offset) {
 				if (!show_recom) {
@@ -1576,6 +1579,58 @@ int sps_bam_pipe_transfer(struct sps_bam *dev,
 	return 0;
 }
 
+int sps_bam_pipe_transfer_batch(struct sps_bam *dev, u32 pipe_index,
+				struct sps_iovec *iovec, void **user,
+				u32 count)
+{
+	struct sps_pipe *pipe = dev->pipes[pipe_index];
+	u32 avail;
+	u32 flags;
+	u32 n;
+	int result;
+
+	if (count == 0) {
+		SPS_ERR(dev, "sps:iovec count zero: BAM %pa pipe %d\n",
+			BAM_ID(dev), pipe_index);
+		return SPS_ERROR;
+	}
+
+	if (pipe->sys.no_queue && user != NULL) {
+		SPS_ERR(dev, "sps:User pointer arg non-NULL: BAM %pa pipe %d\n",
+			BAM_ID(dev), pipe_index);
+		return SPS_ERROR;
+	}
+
+	if (!pipe->sys.ack_xfers && pipe->polled) {
+		sps_bam_pipe_get_unused_desc_num(dev, pipe_index, &avail);
+		avail = pipe->desc_size / sizeof(struct sps_iovec) - avail - 1;
+	} else
+		sps_bam_get_free_count(dev, pipe_index, &avail);
+
+	if (avail < count) {
+		SPS_DBG1(dev,
+			"sps:Insufficient free desc: BAM %pa pipe %d: %d\n",
+			BAM_ID(dev), pipe_index, avail);
+		return SPS_ERROR;
+	}
+
+	for (n = 0; n < count; n++, iovec++) {
+		/* Only the last descriptor notifies the hardware */
+		flags = iovec->flags;
+		if (n < count - 1)
+			flags |= SPS_IOVEC_FLAG_NO_SUBMIT;
+
+		result = sps_bam_pipe_transfer_one(dev, pipe_index,
+						   iovec->addr, iovec->size,
+						   user ? user[n] : NULL,
+						   flags);
+		if (result)
+			return SPS_ERROR;
+	}
+
+	return 0;
+}
+
 int sps_bam_pipe_inject_zlt(struct sps_bam *dev, u32 pipe_index)
 {
 	struct sps_pipe *pipe = dev->pipes[pipe_index];
@@ -144,6 +144,7 @@ struct sps_bam_sys_mode {
 	struct sps_q_event event;	/* Temp storage for event creation */
 	int no_queue;	/* Whether events are queued */
 	int ack_xfers;	/* Whether client must ACK all descriptors */
+	int single_producer; /* Whether transfers are submitted without lock */
 	int handler_eot; /* Whether EOT handling is in progress (debug) */
 
 	/* Statistics */
@@ -461,6 +462,29 @@ int sps_bam_pipe_transfer_one(struct sps_bam *dev, u32 pipe_index, u32 addr,
 int sps_bam_pipe_transfer(struct sps_bam *dev, u32 pipe_index,
 			 struct sps_transfer *transfer);
 
+/**
+ * Submit a batch of descriptors to a BAM pipe
+ *
+ * This function queues all the descriptors and writes the pipe's
+ * descriptor write offset once.
+ *
+ * @dev - pointer to BAM device descriptor
+ *
+ * @pipe_index - pipe index
+ *
+ * @iovec - descriptors to queue
+ *
+ * @user - user pointers of the descriptors, or NULL
+ *
+ * @count - number of descriptors
+ *
+ * @return 0 on success, negative value on error
+ *
+ */
+int sps_bam_pipe_transfer_batch(struct sps_bam *dev, u32 pipe_index,
+				struct sps_iovec *iovec, void **user,
+				u32 count);
+
 /**
  * Get a BAM pipe event
  *
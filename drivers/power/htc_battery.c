@@ -2561,7 +2561,8 @@ static int htc_battery_probe(struct platform_device *pdev)
 	INIT_DELAYED_WORK(&htc_batt_info.is_usb_overheat_work, is_usb_overheat_worker);
 #endif 
 	INIT_DELAYED_WORK(&htc_batt_info.chk_unknown_chg_work, chk_unknown_chg_worker);
-	init_timer(&htc_batt_timer.batt_timer);
+	/* Aligned to other wakeups, suspend is covered by the wakeup alarm */
+	init_timer_deferrable(&htc_batt_timer.batt_timer);
 	htc_batt_timer.batt_timer.function = batt_regular_timer_handler;
 	alarm_init(&htc_batt_timer.batt_check_wakeup_alarm, ALARM_REALTIME,
 			batt_check_alarm_handler);
@@ -555,6 +555,7 @@ struct fg_chip {
 	int			last_soc;
 	
 	int			last_good_temp;
+	int			last_notified_temp;
 	int			batt_temp_low_limit;
 	int			batt_temp_high_limit;
 	
@@ -2611,6 +2612,7 @@ out:
 				TEMP_SENSE_CHARGE_BIT)
 #define TEMP_PERIOD_UPDATE_MS		10000
 #define TEMP_PERIOD_TIMEOUT_MS		3000
+#define FG_TEMP_NOTIFY_DELTA		10
 #define BATT_TEMP_LOW_LIMIT		-600
 #define BATT_TEMP_HIGH_LIMIT		1500
 static void update_temp_data(struct work_struct *work)
@@ -2687,6 +2689,14 @@ wait:
 
 	get_current_time(&chip->last_temp_update_time);
 
+	/* Only a change of a degree or more is worth waking userspace */
+	if (abs(fg_data[0].value - chip->last_notified_temp)
+			>= FG_TEMP_NOTIFY_DELTA) {
+		chip->last_notified_temp = fg_data[0].value;
+		if (chip->power_supply_registered)
+			power_supply_changed(&chip->bms_psy);
+	}
+
 out:
 	if (chip->sw_rbias_ctrl) {
 		rc = fg_mem_masked_write(chip, EXTERNAL_SENSE_SELECT,
@@ -7184,13 +7194,17 @@ static int fg_probe(struct spmi_device *spmi)
 	mutex_init(&chip->sysfs_restart_lock);
 	mutex_init(&chip->ima_recovery_lock);
 	INIT_DELAYED_WORK(&chip->update_jeita_setting, update_jeita_setting);
-	INIT_DELAYED_WORK(&chip->update_sram_data, update_sram_data_work);
-	INIT_DELAYED_WORK(&chip->update_temp_work, update_temp_data);
+	/*
+	 * The periodic polls are deferrable so that they run on existing
+	 * wakeups, fg_resume() reschedules the ones that fell due in suspend.
+	 */
+	INIT_DEFERRABLE_WORK(&chip->update_sram_data, update_sram_data_work);
+	INIT_DEFERRABLE_WORK(&chip->update_temp_work, update_temp_data);
 	INIT_DELAYED_WORK(&chip->check_empty_work, check_empty_work);
 	INIT_DELAYED_WORK(&chip->batt_profile_init, batt_profile_init);
 	INIT_DELAYED_WORK(&chip->ima_error_recovery_work,
 			ima_error_recovery_work);
-	INIT_DELAYED_WORK(&chip->check_sanity_work, check_sanity_work);
+	INIT_DEFERRABLE_WORK(&chip->check_sanity_work, check_sanity_work);
 	INIT_WORK(&chip->rslow_comp_work, rslow_comp_work);
 	INIT_WORK(&chip->fg_cap_learning_work, fg_cap_learning_work);
 	INIT_WORK(&chip->dump_sram, dump_sram);
@@ -174,6 +174,10 @@ struct smbchg_chip {
 	
 	int				wake_reasons;
 	int				previous_soc;
+	int				previous_temp;
+	int				previous_status;
+	int				previous_icl_ma;
+	enum power_supply_type		previous_usb_type;
 	int				usb_online;
 	bool				dc_present;
 	bool				usb_present;
@@ -505,6 +509,13 @@ module_param_named(
 	int, S_IRUSR | S_IWUSR
 );
 
+/* Battery temperature change, in decidegrees, that is reported to userspace */
+static int smbchg_notify_temp_delta = 10;
+module_param_named(
+	notify_temp_delta, smbchg_notify_temp_delta,
+	int, S_IRUSR | S_IWUSR
+);
+
 static int wipower_dyn_icl_en;
 module_param_named(
 	dynamic_icl_wipower_en, wipower_dyn_icl_en,
@@ -3773,9 +3784,10 @@ static void smbchg_external_power_changed(struct power_supply *psy)
 	struct smbchg_chip *chip = container_of(psy,
 				struct smbchg_chip, batt_psy);
 	union power_supply_propval prop = {0,};
-	int rc, current_limit = 0, soc;
+	int rc, current_limit = 0, soc, temp, status;
 	enum power_supply_type usb_supply_type;
 	char *usb_type_name = "null";
+	bool notify = false;
 
 	if (chip->bms_psy_name)
 		chip->bms_psy =
@@ -3788,6 +3800,14 @@ static void smbchg_external_power_changed(struct power_supply *psy)
 		if (chip->previous_soc != soc) {
 			chip->previous_soc = soc;
 			smbchg_soc_changed(chip);
+			notify = true;
+		}
+
+		temp = get_prop_batt_temp(chip);
+		if (abs(temp - chip->previous_temp)
+				>= smbchg_notify_temp_delta) {
+			chip->previous_temp = temp;
+			notify = true;
 		}
 
 		rc = smbchg_config_chg_battery_type(chip);
@@ -3824,7 +3844,22 @@ static void smbchg_external_power_changed(struct power_supply *psy)
 skip_current_for_non_sdp:
 	smbchg_vfloat_adjust_check(chip);
 
-	power_supply_changed(&chip->batt_psy);
+	/*
+	 * The fuel gauge and usb supplies change often, only pass it on
+	 * when something userspace acts on did change.
+	 */
+	status = get_prop_batt_status(chip);
+	if (status != chip->previous_status
+			|| usb_supply_type != chip->previous_usb_type
+			|| current_limit != chip->previous_icl_ma) {
+		chip->previous_status = status;
+		chip->previous_usb_type = usb_supply_type;
+		chip->previous_icl_ma = current_limit;
+		notify = true;
+	}
+
+	if (notify)
+		power_supply_changed(&chip->batt_psy);
 }
 
 static int smbchg_otg_regulator_enable(struct regulator_dev *rdev)
@@ -1392,6 +1392,70 @@ static const struct file_operations ufsdbg_req_stats_desc = {
 };
 
 
+static int ufsdbg_intr_aggr_show(struct seq_file *file, void *data)
+{
+	struct ufs_hba *hba = (struct ufs_hba *)file->private;
+	struct ufs_intr_aggr *aggr = &hba->intr_aggr;
+	static const char * const names[UFS_INTR_AGGR_MODES] = {
+		"Bypass", "Shallow", "Deep",
+	};
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	seq_printf(file, "adaptive: %d\ncounter: %u\ntimeout: %u\n",
+		   aggr->is_adaptive, aggr->cnt, aggr->tmout);
+	seq_printf(file, "avg depth: %u.%02u\nretunes: %llu\n",
+		   aggr->avg_depth >> 4, ((aggr->avg_depth & 0xF) * 100) >> 4,
+		   aggr->retunes);
+	seq_printf(file, "\t%-10s %-10s %-10s\n", "Mode", "Requests",
+		   "Interrupts");
+	for (i = 0; i < UFS_INTR_AGGR_MODES; i++)
+		seq_printf(file, "\t%-10s %-10llu %-10llu\n", names[i],
+			   aggr->reqs[i], aggr->intrs[i]);
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+
+	return 0;
+}
+
+static int ufsdbg_intr_aggr_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ufsdbg_intr_aggr_show, inode->i_private);
+}
+
+/* Writing 0 or 1 turns adaptive aggregation off or on and clears stats */
+static ssize_t ufsdbg_intr_aggr_write(struct file *filp,
+		const char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	struct ufs_hba *hba = filp->f_mapping->host->i_private;
+	struct ufs_intr_aggr *aggr = &hba->intr_aggr;
+	unsigned long flags;
+	int val;
+	int ret;
+
+	ret = kstrtoint_from_user(ubuf, cnt, 0, &val);
+	if (ret) {
+		dev_err(hba->dev, "%s: Invalid argument\n", __func__);
+		return ret;
+	}
+
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	aggr->is_adaptive = !!val;
+	aggr->avg_depth = 0;
+	aggr->retunes = 0;
+	memset(aggr->reqs, 0, sizeof(aggr->reqs));
+	memset(aggr->intrs, 0, sizeof(aggr->intrs));
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+
+	return cnt;
+}
+
+static const struct file_operations ufsdbg_intr_aggr_fops = {
+	.open		= ufsdbg_intr_aggr_open,
+	.read		= seq_read,
+	.write		= ufsdbg_intr_aggr_write,
+};
+
 static int ufsdbg_reset_controller_show(struct seq_file *file, void *data)
 {
 	seq_puts(file, "echo 1 > /sys/kernel/debug/.../reset_controller\n");
@@ -1583,6 +1647,17 @@ void ufsdbg_add_debugfs(struct ufs_hba *hba)
 		goto err;
 	}
 
+	hba->debugfs_files.intr_aggr =
+		debugfs_create_file("intr_aggr", S_IRUSR | S_IWUSR,
+			hba->debugfs_files.stats_folder, hba,
+			&ufsdbg_intr_aggr_fops);
+	if (!hba->debugfs_files.intr_aggr) {
+		dev_err(hba->dev,
+			"%s:  failed create intr_aggr debugfs entry\n",
+			__func__);
+		goto err;
+	}
+
 	hba->debugfs_files.reset_controller =
 		debugfs_create_file("reset_controller", S_IRUSR | S_IWUSR,
 			hba->debugfs_files.debugfs_root, hba,
@@ -40,6 +40,7 @@
 #include <linux/async.h>
 #include <scsi/ufs/ioctl.h>
 #include <linux/devfreq.h>
+#include <linux/cpu_boost.h>
 #include <linux/nls.h>
 #include <linux/of.h>
 #include "ufshcd.h"
@@ -214,12 +215,23 @@ void ufshcd_update_query_stats(struct ufs_hba *hba,
 /* Interrupt aggregation default timeout, unit: 40us */
 #define INT_AGGR_DEF_TO	0x02
 
+/* Counter thresholds up to this value count as shallow aggregation */
+#define INT_AGGR_SHALLOW_CNT	4
+/* Weight of the latest sample in the queue depth average is 1/8 */
+#define INT_AGGR_AVG_SHIFT	3
+
 /* default value of auto suspend is 3 seconds */
 #define UFSHCD_AUTO_SUSPEND_DELAY_MS 3000 /* millisecs */
 
 #define UFSHCD_CLK_GATING_DELAY_MS_PWR_SAVE	10
 #define UFSHCD_CLK_GATING_DELAY_MS_PERF		50
 
+/* Load at which clocks are scaled up ahead of the devfreq window */
+#define UFSHCD_CLK_SCALING_BOOST_DEPTH	8
+#define UFSHCD_CLK_SCALING_BOOST_BYTES	(512 * 1024)
+/* Time clocks are kept scaled up after a boost or a scale up, in ms */
+#define UFSHCD_CLK_SCALING_BOOST_MS	100
+
 /* IOCTL opcode for command - ufs set device read only */
 #define UFS_IOCTL_BLKROSET      BLKROSET
 
@@ -983,6 +995,60 @@ static inline void ufshcd_disable_intr_aggr(struct ufs_hba *hba)
 	ufshcd_writel(hba, 0, REG_UTP_TRANSFER_REQ_INT_AGG_CONTROL);
 }
 
+static inline enum ufs_intr_aggr_mode
+ufshcd_intr_aggr_mode(struct ufs_hba *hba)
+{
+	return hba->intr_aggr.cnt <= INT_AGGR_SHALLOW_CNT ?
+		UFS_INTR_AGGR_SHALLOW : UFS_INTR_AGGR_DEEP;
+}
+
+/**
+ * ufshcd_intr_aggr_bypass - check if a request should skip aggregation
+ * @hba: per adapter instance
+ *
+ * A request issued while nothing else is in flight would only wait for
+ * the aggregation timer, so let it interrupt on completion right away.
+ */
+static bool ufshcd_intr_aggr_bypass(struct ufs_hba *hba)
+{
+	if (!ufshcd_is_intr_aggr_allowed(hba))
+		return true;
+
+	return hba->intr_aggr.is_adaptive &&
+		!ACCESS_ONCE(hba->outstanding_reqs);
+}
+
+/**
+ * ufshcd_intr_aggr_retune - adjust the aggregation counter threshold
+ * @hba: per adapter instance
+ * @depth: number of requests outstanding when the interrupt was taken
+ *
+ * The threshold follows half of the average queue depth so that deep
+ * queues share one interrupt between several completions while shallow
+ * ones do not wait for the timeout. Called with host_lock held.
+ */
+static void ufshcd_intr_aggr_retune(struct ufs_hba *hba, int depth)
+{
+	struct ufs_intr_aggr *aggr = &hba->intr_aggr;
+	u8 cnt = hba->nutrs - 1;
+
+	aggr->intrs[depth > 1 ? ufshcd_intr_aggr_mode(hba) :
+		    UFS_INTR_AGGR_BYPASS]++;
+
+	if (aggr->is_adaptive) {
+		aggr->avg_depth += ((depth << 4) - (int)aggr->avg_depth) >>
+				   INT_AGGR_AVG_SHIFT;
+		cnt = clamp_t(int, aggr->avg_depth >> 5, 1, hba->nutrs - 1);
+	}
+
+	if (cnt == aggr->cnt)
+		return;
+
+	aggr->cnt = cnt;
+	aggr->retunes++;
+	ufshcd_config_intr_aggr(hba, aggr->cnt, aggr->tmout);
+}
+
 /**
  * ufshcd_enable_run_stop_reg - Enable run-stop registers,
  *			When run-stop registers are set to 1, it indicates the
@@ -1934,6 +2000,65 @@ static void ufshcd_clk_scaling_start_busy(struct ufs_hba *hba)
 	}
 }
 
+/* Must be called with host lock acquired */
+static void ufshcd_clk_scaling_boost(struct ufs_hba *hba, unsigned int ms)
+{
+	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
+	unsigned long until = jiffies + msecs_to_jiffies(ms);
+
+	if (time_after(until, scaling->boost_until))
+		scaling->boost_until = until;
+
+	if (scaling->is_scaled_up || scaling->boost_pending)
+		return;
+
+	scaling->boost_pending = true;
+	queue_work(scaling->workq, &scaling->boost_work);
+}
+
+/*
+ * Account the request in the clock scaling load and scale up right away
+ * if the queue is deep or holds a lot of data, rather than waiting for
+ * devfreq to notice at the end of its window. A short burst of small
+ * requests does not get there and does not pay for the gear switch.
+ * Must be called with host lock acquired.
+ */
+static void ufshcd_clk_scaling_add_load(struct ufs_hba *hba,
+					struct ufshcd_lrb *lrbp)
+{
+	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
+
+	if (!ufshcd_is_clkscaling_supported(hba))
+		return;
+
+	lrbp->scaling_bytes = lrbp->cmd ? scsi_bufflen(lrbp->cmd) : 0;
+	scaling->bytes_in_flight += lrbp->scaling_bytes;
+
+	if (scaling->is_scaled_up || !scaling->is_allowed ||
+	    hba->pm_op_in_progress)
+		return;
+
+	if (scaling->active_reqs >= UFSHCD_CLK_SCALING_BOOST_DEPTH ||
+	    scaling->bytes_in_flight >= UFSHCD_CLK_SCALING_BOOST_BYTES)
+		ufshcd_clk_scaling_boost(hba, UFSHCD_CLK_SCALING_BOOST_MS);
+}
+
+/* Must be called with host lock acquired */
+static void ufshcd_clk_scaling_complete(struct ufs_hba *hba,
+					struct ufshcd_lrb *lrbp)
+{
+	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
+
+	if (!ufshcd_is_clkscaling_supported(hba))
+		return;
+
+	scaling->active_reqs--;
+	scaling->bytes_in_flight -= lrbp->scaling_bytes;
+	lrbp->scaling_bytes = 0;
+	if (!scaling->active_reqs)
+		scaling->bytes_in_flight = 0;
+}
+
 static void ufshcd_clk_scaling_update_busy(struct ufs_hba *hba)
 {
 	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
@@ -1967,9 +2092,14 @@ int ufshcd_send_command(struct ufs_hba *hba, unsigned int task_tag)
 		return ret;
 	}
 
+	if (hba->lrb[task_tag].cmd && ufshcd_is_intr_aggr_allowed(hba))
+		hba->intr_aggr.reqs[hba->lrb[task_tag].intr_cmd ?
+				    UFS_INTR_AGGR_BYPASS :
+				    ufshcd_intr_aggr_mode(hba)]++;
 	hba->lrb[task_tag].issue_time_stamp = ktime_get();
 	hba->lrb[task_tag].complete_time_stamp = ktime_set(0, 0);
 	ufshcd_clk_scaling_start_busy(hba);
+	ufshcd_clk_scaling_add_load(hba, &hba->lrb[task_tag]);
 	__set_bit(task_tag, &hba->outstanding_reqs);
 	ufshcd_writel(hba, 1 << task_tag, REG_UTP_TRANSFER_REQ_DOOR_BELL);
 	/* Make sure that doorbell is committed immediately */
@@ -2615,7 +2745,7 @@ static int ufshcd_queuecommand(struct Scsi_Host *host, struct scsi_cmnd *cmd)
 	lrbp->sense_buffer = cmd->sense_buffer;
 	lrbp->task_tag = tag;
 	lrbp->lun = ufshcd_scsi_to_upiu_lun(cmd->device->lun);
-	lrbp->intr_cmd = !ufshcd_is_intr_aggr_allowed(hba) ? true : false;
+	lrbp->intr_cmd = ufshcd_intr_aggr_bypass(hba);
 	lrbp->command_type = UTP_CMD_TYPE_SCSI;
 	lrbp->req_abort_skip = false;
 
@@ -4267,7 +4397,8 @@ static int ufshcd_make_hba_operational(struct ufs_hba *hba)
 
 	/* Configure interrupt aggregation */
 	if (ufshcd_is_intr_aggr_allowed(hba))
-		ufshcd_config_intr_aggr(hba, hba->nutrs - 1, INT_AGGR_DEF_TO);
+		ufshcd_config_intr_aggr(hba, hba->intr_aggr.cnt,
+					hba->intr_aggr.tmout);
 	else
 		ufshcd_disable_intr_aggr(hba);
 
@@ -4700,6 +4831,16 @@ static int ufshcd_slave_configure(struct scsi_device *sdev)
 	blk_queue_update_dma_pad(q, PRDT_DATA_BYTE_COUNT_PAD - 1);
 	blk_queue_max_segment_size(q, PRDT_DATA_BYTE_COUNT_MAX);
 
+	if (shost_use_blk_mq(sdev->host)) {
+		/*
+		 * blk-mq does not resume a runtime suspended queue on new
+		 * requests, keep the LUNs active. Complete each request on
+		 * the CPU that submitted it rather than on a cache sibling.
+		 */
+		queue_flag_set_unlocked(QUEUE_FLAG_SAME_FORCE, q);
+		return 0;
+	}
+
 	sdev->autosuspend_delay = UFSHCD_AUTO_SUSPEND_DELAY_MS;
 	sdev->use_rpm_auto = 1;
 
@@ -4969,8 +5110,7 @@ void ufshcd_abort_outstanding_transfer_requests(struct ufs_hba *hba, int result)
 				complete(hba->dev_cmd.complete);
 			}
 		}
-		if (ufshcd_is_clkscaling_supported(hba))
-			hba->clk_scaling.active_reqs--;
+		ufshcd_clk_scaling_complete(hba, lrbp);
 	}
 }
 
@@ -5020,8 +5160,7 @@ static void __ufshcd_transfer_req_compl(struct ufs_hba *hba,
 				complete(hba->dev_cmd.complete);
 			}
 		}
-		if (ufshcd_is_clkscaling_supported(hba))
-			hba->clk_scaling.active_reqs--;
+		ufshcd_clk_scaling_complete(hba, lrbp);
 	}
 
 	/* clear corresponding bits of completed commands */
@@ -5049,8 +5188,11 @@ static void ufshcd_transfer_req_compl(struct ufs_hba *hba)
 	 * false interrupt if device completes another request after resetting
 	 * aggregation and before reading the DB.
 	 */
-	if (ufshcd_is_intr_aggr_allowed(hba))
+	if (ufshcd_is_intr_aggr_allowed(hba)) {
 		ufshcd_reset_intr_aggr(hba);
+		ufshcd_intr_aggr_retune(hba,
+					hweight_long(hba->outstanding_reqs));
+	}
 
 	tr_doorbell = ufshcd_readl(hba, REG_UTP_TRANSFER_REQ_DOOR_BELL);
 	completed_reqs = tr_doorbell ^ hba->outstanding_reqs;
@@ -7883,6 +8025,7 @@ static int ufshcd_suspend(struct ufs_hba *hba, enum ufs_pm_op pm_op)
 	if (hba->clk_scaling.is_allowed) {
 		cancel_work_sync(&hba->clk_scaling.suspend_work);
 		cancel_work_sync(&hba->clk_scaling.resume_work);
+		cancel_work_sync(&hba->clk_scaling.boost_work);
 		ufshcd_suspend_clkscaling(hba);
 	}
 
@@ -8413,6 +8556,8 @@ void ufshcd_remove(struct ufs_hba *hba)
 	ufshcd_exit_clk_gating(hba);
 	ufshcd_exit_hibern8_on_idle(hba);
 	if (ufshcd_is_clkscaling_supported(hba)) {
+		cpu_boost_unregister_notifier(&hba->clk_scaling.boost_nb);
+		cancel_work_sync(&hba->clk_scaling.boost_work);
 		device_remove_file(hba->dev, &hba->clk_scaling.enable_attr);
 		devfreq_remove_device(hba->devfreq);
 	}
@@ -8729,6 +8874,7 @@ static ssize_t ufshcd_clkscale_enable_store(struct device *dev,
 
 	cancel_work_sync(&hba->clk_scaling.suspend_work);
 	cancel_work_sync(&hba->clk_scaling.resume_work);
+	cancel_work_sync(&hba->clk_scaling.boost_work);
 
 	hba->clk_scaling.is_allowed = value;
 
@@ -8782,6 +8928,56 @@ static void ufshcd_clk_scaling_resume_work(struct work_struct *work)
 	devfreq_resume_device(hba->devfreq);
 }
 
+static void ufshcd_clk_scaling_boost_work(struct work_struct *work)
+{
+	struct ufs_hba *hba = container_of(work, struct ufs_hba,
+					   clk_scaling.boost_work);
+	unsigned long irq_flags;
+	ktime_t start;
+	bool scale_up;
+	int ret;
+
+	/* Never resume the host just for a hint, only boost it if awake */
+	pm_runtime_get_noresume(hba->dev);
+	mutex_lock(&hba->devfreq->lock);
+
+	spin_lock_irqsave(hba->host->host_lock, irq_flags);
+	hba->clk_scaling.boost_pending = false;
+	scale_up = hba->clk_scaling.is_allowed && !hba->pm_op_in_progress &&
+		   !ufshcd_eh_in_progress(hba) &&
+		   !pm_runtime_suspended(hba->dev) &&
+		   ufshcd_is_devfreq_scaling_required(hba, true);
+	spin_unlock_irqrestore(hba->host->host_lock, irq_flags);
+
+	if (scale_up) {
+		start = ktime_get();
+		ret = ufshcd_devfreq_scale(hba, true);
+		trace_ufshcd_profile_clk_scaling(dev_name(hba->dev), "boost",
+			ktime_to_us(ktime_sub(ktime_get(), start)), ret);
+	}
+
+	mutex_unlock(&hba->devfreq->lock);
+	pm_runtime_put_noidle(hba->dev);
+}
+
+static int ufshcd_clk_scaling_boost_notify(struct notifier_block *nb,
+					   unsigned long event, void *data)
+{
+	struct ufs_hba *hba = container_of(nb, struct ufs_hba,
+					   clk_scaling.boost_nb);
+	unsigned long irq_flags;
+
+	if (event != CPU_BOOST_INPUT)
+		return NOTIFY_DONE;
+
+	spin_lock_irqsave(hba->host->host_lock, irq_flags);
+	if (hba->clk_scaling.is_allowed)
+		ufshcd_clk_scaling_boost(hba, *(unsigned int *)data);
+	spin_unlock_irqrestore(hba->host->host_lock, irq_flags);
+
+	return NOTIFY_OK;
+}
+
 static int ufshcd_devfreq_target(struct device *dev,
 				unsigned long *freq, u32 flags)
 {
@@ -8814,10 +9010,26 @@ static int ufshcd_devfreq_target(struct device *dev,
 		ret = 0;
 		goto out; /* no state change required */
 	}
+
+	/*
+	 * Stay scaled up for a while after a boost or a scale up, a gap of
+	 * one window in a bursty load is not worth two gear switches.
+	 */
+	if (!scale_up &&
+	    time_before(jiffies, hba->clk_scaling.boost_until)) {
+		spin_unlock_irqrestore(hba->host->host_lock, irq_flags);
+		ret = 0;
+		goto out;
+	}
 	spin_unlock_irqrestore(hba->host->host_lock, irq_flags);
 
 	start = ktime_get();
 	ret = ufshcd_devfreq_scale(hba, scale_up);
+	if (!ret && scale_up) {
+		spin_lock_irqsave(hba->host->host_lock, irq_flags);
+		ufshcd_clk_scaling_boost(hba, UFSHCD_CLK_SCALING_BOOST_MS);
+		spin_unlock_irqrestore(hba->host->host_lock, irq_flags);
+	}
 	trace_ufshcd_profile_clk_scaling(dev_name(hba->dev),
 		(scale_up ? "up" : "down"),
 		ktime_to_us(ktime_sub(ktime_get(), start)), ret);
@@ -8986,6 +9198,10 @@ int ufshcd_init(struct ufs_hba *hba, void __iomem *mmio_base, unsigned int irq)
 
 	hba->max_pwr_info.is_valid = false;
 
+	hba->intr_aggr.is_adaptive = true;
+	hba->intr_aggr.cnt = hba->nutrs - 1;
+	hba->intr_aggr.tmout = INT_AGGR_DEF_TO;
+
 	/* Initailize wait queue for task management */
 	init_waitqueue_head(&hba->tm_wq);
 	init_waitqueue_head(&hba->tm_tag_wq);
@@ -9031,6 +9247,13 @@ int ufshcd_init(struct ufs_hba *hba, void __iomem *mmio_base, unsigned int irq)
 		hba->is_irq_enabled = true;
 	}
 
+	/*
+	 * With scsi-mq the blk-mq tag set, sized by can_queue, hands out
+	 * the UTRL slots and no shared legacy tag map is needed.
+	 */
+	if (IS_ENABLED(CONFIG_SCSI_UFSHCD_MQ))
+		host->use_blk_mq = true;
+
 	/* Enable SCSI tag mapping */
 	err = scsi_init_shared_tag_map(host, host->can_queue);
 	if (err) {
@@ -9069,6 +9292,9 @@ int ufshcd_init(struct ufs_hba *hba, void __iomem *mmio_base, unsigned int irq)
 			  ufshcd_clk_scaling_suspend_work);
 		INIT_WORK(&hba->clk_scaling.resume_work,
 			  ufshcd_clk_scaling_resume_work);
+		INIT_WORK(&hba->clk_scaling.boost_work,
+			  ufshcd_clk_scaling_boost_work);
+		hba->clk_scaling.boost_until = jiffies;
 
 		snprintf(wq_name, ARRAY_SIZE(wq_name), "ufs_clkscaling_%d",
 			 host->host_no);
@@ -9077,6 +9303,10 @@ int ufshcd_init(struct ufs_hba *hba, void __iomem *mmio_base, unsigned int irq)
 		/* Suspend devfreq until the UFS device is detected */
 		ufshcd_suspend_clkscaling(hba);
 		ufshcd_clkscaling_init_sysfs(hba);
+
+		hba->clk_scaling.boost_nb.notifier_call =
+			ufshcd_clk_scaling_boost_notify;
+		cpu_boost_register_notifier(&hba->clk_scaling.boost_nb);
 	}
 
 	/*
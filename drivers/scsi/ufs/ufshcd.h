@@ -47,6 +47,7 @@
 #include <linux/spinlock.h>
 #include <linux/rwsem.h>
 #include <linux/workqueue.h>
+#include <linux/notifier.h>
 #include <linux/errno.h>
 #include <linux/types.h>
 #include <linux/wait.h>
@@ -191,6 +192,7 @@ struct ufs_pm_lvl_states {
  * @issue_time_stamp: time stamp for debug purposes
  * @complete_time_stamp: time stamp for statistics
  * @req_abort_skip: skip request abort task flag
+ * @scaling_bytes: transfer length accounted as clock scaling load
  */
 struct ufshcd_lrb {
 	struct utp_transfer_req_desc *utr_descriptor_ptr;
@@ -216,6 +218,7 @@ struct ufshcd_lrb {
 	ktime_t complete_time_stamp;
 
 	bool req_abort_skip;
+	unsigned int scaling_bytes;
 };
 
 /**
@@ -475,6 +478,11 @@ struct ufs_saved_pwr_info {
  * @is_busy_started: tracks if busy period has started or not
  * @is_suspended: tracks if devfreq is suspended or not
  * @is_scaled_up: tracks if we are currently scaled up or scaled down
+ * @bytes_in_flight: data length of the transfer requests pending
+ * @boost_work: worker scaling up ahead of the devfreq window
+ * @boost_until: jiffies before which scaling down is not allowed
+ * @boost_pending: boost_work is queued and has not run yet
+ * @boost_nb: notifier for the input boost hint of cpu-boost
  */
 struct ufs_clk_scaling {
 	int active_reqs;
@@ -490,6 +498,41 @@ struct ufs_clk_scaling {
 	bool is_busy_started;
 	bool is_suspended;
 	bool is_scaled_up;
+	u64 bytes_in_flight;
+	struct work_struct boost_work;
+	unsigned long boost_until;
+	bool boost_pending;
+	struct notifier_block boost_nb;
+};
+
+/* Transfer request interrupt aggregation modes */
+enum ufs_intr_aggr_mode {
+	UFS_INTR_AGGR_BYPASS,	/* lone request, no aggregation */
+	UFS_INTR_AGGR_SHALLOW,	/* small counter threshold */
+	UFS_INTR_AGGR_DEEP,	/* large counter threshold */
+	UFS_INTR_AGGR_MODES,
+};
+
+/**
+ * struct ufs_intr_aggr - UFS interrupt aggregation related data
+ * @is_adaptive: retune the counter threshold from the queue depth when set,
+ * otherwise the static nutrs - 1 threshold is used
+ * @cnt: counter threshold currently programmed
+ * @tmout: timeout currently programmed, unit: 40us
+ * @avg_depth: moving average of the requests outstanding when a completion
+ * interrupt is taken, in 1/16 units
+ * @reqs: number of transfer requests issued in each mode
+ * @intrs: number of completion interrupts taken in each mode
+ * @retunes: number of times the counter threshold was reprogrammed
+ */
+struct ufs_intr_aggr {
+	bool is_adaptive;
+	u8 cnt;
+	u8 tmout;
+	u32 avg_depth;
+	u64 reqs[UFS_INTR_AGGR_MODES];
+	u64 intrs[UFS_INTR_AGGR_MODES];
+	u64 retunes;
 };
 
 /**
@@ -532,6 +575,7 @@ struct debugfs_files {
 	u32 dme_local_attr_id;
 	u32 dme_peer_attr_id;
 	struct dentry *reset_controller;
+	struct dentry *intr_aggr;
 #ifdef CONFIG_UFS_FAULT_INJECTION
 	struct dentry *err_inj_scenario;
 	struct dentry *err_inj_stats;
@@ -832,6 +876,7 @@ struct ufs_hba {
 
 	struct ufs_clk_gating clk_gating;
 	struct ufs_hibern8_on_idle hibern8_on_idle;
+	struct ufs_intr_aggr intr_aggr;
 
 	/* Control to enable/disable host capabilities */
 	u32 caps;
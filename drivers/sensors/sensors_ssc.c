@@ -26,7 +26,14 @@
 #include <linux/err.h>
 #include <linux/delay.h>
 #include <linux/sysfs.h>
+#include <linux/io.h>
+#include <linux/interrupt.h>
+#include <linux/of_gpio.h>
+#include <linux/poll.h>
+#include <linux/suspend.h>
+#include <linux/log2.h>
 #include <soc/qcom/subsystem_restart.h>
+#include <soc/qcom/smem.h>
 
 #define IMAGE_LOAD_CMD 1
 #define IMAGE_UNLOAD_CMD 0
@@ -37,11 +44,41 @@
 #define DSPS_IOCTL_READ_SLOW_TIMER32 _IOR(DSPS_IOCTL_MAGIC, 3, compat_uint_t)
 #endif
 
+/*
+ * Batched sample FIFO shared with the SLPI through an SMEM item. The SLPI
+ * owns the item and the write index, the APSS owns the read index. The
+ * SLPI raises the watermark interrupt only while apss_awake is set, so
+ * non-wakeup sensors keep filling the FIFO during suspend without waking
+ * the APSS; the backlog is drained when the APSS resumes for any reason.
+ */
+#define SNS_BATCH_MAGIC		0x54414253	/* "SBAT" */
+#define SNS_BATCH_HDR_MAGIC	0x00
+#define SNS_BATCH_HDR_SIZE	0x04
+#define SNS_BATCH_HDR_WRITE	0x08
+#define SNS_BATCH_HDR_READ	0x0c
+#define SNS_BATCH_HDR_WM	0x10
+#define SNS_BATCH_HDR_AWAKE	0x14
+#define SNS_BATCH_HDR_LEN	0x20
+#define SNS_BATCH_WM_PCT	75
+#define SNS_BATCH_BOUNCE_LEN	512
+
+struct sns_batch_s {
+	bool enabled;
+	u32 smem_id;
+	u32 wm_pct;
+	u32 size;
+	void __iomem *fifo;
+	int irq;
+	wait_queue_head_t wq;
+	struct mutex lock;
+};
+
 struct sns_ssc_control_s {
 	struct class *dev_class;
 	dev_t dev_num;
 	struct device *dev;
 	struct cdev *cdev;
+	struct sns_batch_s batch;
 };
 static struct sns_ssc_control_s sns_ctl;
 
@@ -241,6 +278,235 @@ static u32 sns_read_qtimer(void)
 	return (u32)val;
 }
 
+/*
+ * The SMEM item only exists once the SLPI image has booted and set up
+ * the FIFO, so it is looked up on first use. Called with batch->lock held.
+ */
+static void __iomem *sns_batch_fifo(struct sns_batch_s *batch)
+{
+	void __iomem *fifo;
+	unsigned size = 0;
+	u32 data_size;
+
+	if (batch->fifo || !batch->enabled)
+		return batch->fifo;
+
+	fifo = (void __iomem *)smem_get_entry(batch->smem_id, &size,
+					SMEM_DSPS, 0);
+	if (!fifo || size <= SNS_BATCH_HDR_LEN)
+		return NULL;
+	if (readl_relaxed(fifo + SNS_BATCH_HDR_MAGIC) != SNS_BATCH_MAGIC)
+		return NULL;
+
+	data_size = readl_relaxed(fifo + SNS_BATCH_HDR_SIZE);
+	if (!is_power_of_2(data_size) ||
+	    data_size > size - SNS_BATCH_HDR_LEN) {
+		pr_err("%s: bad batch FIFO size %u (item %u)\n", __func__,
+			data_size, size);
+		return NULL;
+	}
+
+	batch->size = data_size;
+	writel_relaxed(data_size / 100 * batch->wm_pct,
+			fifo + SNS_BATCH_HDR_WM);
+	writel_relaxed(1, fifo + SNS_BATCH_HDR_AWAKE);
+	wmb();
+	batch->fifo = fifo;
+	return fifo;
+}
+
+static u32 sns_batch_avail(struct sns_batch_s *batch)
+{
+	u32 avail;
+
+	avail = readl_relaxed(batch->fifo + SNS_BATCH_HDR_WRITE) -
+		readl_relaxed(batch->fifo + SNS_BATCH_HDR_READ);
+	/* the SLPI overwrites the oldest samples on overflow */
+	return min(avail, batch->size);
+}
+
+static bool sns_batch_readable(struct sns_batch_s *batch)
+{
+	bool ret;
+
+	mutex_lock(&batch->lock);
+	ret = sns_batch_fifo(batch) && sns_batch_avail(batch);
+	mutex_unlock(&batch->lock);
+	return ret;
+}
+
+static irqreturn_t sns_batch_wm_irq(int irq, void *data)
+{
+	struct sns_batch_s *batch = data;
+
+	wake_up_interruptible(&batch->wq);
+	return IRQ_HANDLED;
+}
+
+static int sns_batch_pm_notifier(struct notifier_block *nb,
+				unsigned long event, void *unused)
+{
+	struct sns_batch_s *batch = &sns_ctl.batch;
+
+	mutex_lock(&batch->lock);
+	if (!sns_batch_fifo(batch))
+		goto out;
+
+	switch (event) {
+	case PM_SUSPEND_PREPARE:
+		writel_relaxed(0, batch->fifo + SNS_BATCH_HDR_AWAKE);
+		wmb();
+		break;
+
+	case PM_POST_SUSPEND:
+		writel_relaxed(1, batch->fifo + SNS_BATCH_HDR_AWAKE);
+		wmb();
+		if (sns_batch_avail(batch))
+			wake_up_interruptible(&batch->wq);
+		break;
+	}
+out:
+	mutex_unlock(&batch->lock);
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block sns_batch_pm_nb = {
+	.notifier_call = sns_batch_pm_notifier,
+};
+
+static int sns_batch_init(struct platform_device *pdev)
+{
+	struct sns_batch_s *batch = &sns_ctl.batch;
+	struct device_node *node = pdev->dev.of_node;
+	int gpio, ret;
+
+	init_waitqueue_head(&batch->wq);
+	mutex_init(&batch->lock);
+	batch->irq = -1;
+
+	if (of_property_read_u32(node, "qcom,batch-smem-id", &batch->smem_id))
+		return 0;
+	if (of_property_read_u32(node, "qcom,batch-watermark-pct",
+				&batch->wm_pct) ||
+	    !batch->wm_pct || batch->wm_pct > 100)
+		batch->wm_pct = SNS_BATCH_WM_PCT;
+
+	gpio = of_get_named_gpio(node, "qcom,batch-wm-gpio", 0);
+	if (gpio == -EPROBE_DEFER)
+		return gpio;
+	if (gpio_is_valid(gpio)) {
+		batch->irq = gpio_to_irq(gpio);
+		ret = request_irq(batch->irq, sns_batch_wm_irq,
+				IRQF_TRIGGER_RISING, "ssc_batch_wm", batch);
+		if (ret) {
+			dev_err(&pdev->dev, "%s: wm irq request failed %d\n",
+				__func__, ret);
+			return ret;
+		}
+	}
+
+	ret = register_pm_notifier(&sns_batch_pm_nb);
+	if (ret) {
+		dev_err(&pdev->dev, "%s: pm notifier failed %d\n",
+			__func__, ret);
+		if (batch->irq >= 0)
+			free_irq(batch->irq, batch);
+		return ret;
+	}
+
+	batch->enabled = true;
+	return 0;
+}
+
+static void sns_batch_exit(void)
+{
+	struct sns_batch_s *batch = &sns_ctl.batch;
+
+	if (!batch->enabled)
+		return;
+	unregister_pm_notifier(&sns_batch_pm_nb);
+	if (batch->irq >= 0)
+		free_irq(batch->irq, batch);
+	batch->enabled = false;
+	batch->fifo = NULL;
+}
+
+static ssize_t sensors_ssc_read(struct file *file, char __user *buf,
+				size_t count, loff_t *ppos)
+{
+	struct sns_batch_s *batch = &sns_ctl.batch;
+	u8 bounce[SNS_BATCH_BOUNCE_LEN];
+	u32 rd, wr, avail, off, len;
+	ssize_t done = 0;
+	int ret;
+
+	if (!batch->enabled)
+		return -ENODEV;
+
+	if (!(file->f_flags & O_NONBLOCK)) {
+		ret = wait_event_interruptible(batch->wq,
+				sns_batch_readable(batch));
+		if (ret)
+			return ret;
+	}
+
+	mutex_lock(&batch->lock);
+	if (!sns_batch_fifo(batch)) {
+		done = -ENODEV;
+		goto out;
+	}
+
+	wr = readl_relaxed(batch->fifo + SNS_BATCH_HDR_WRITE);
+	rd = readl_relaxed(batch->fifo + SNS_BATCH_HDR_READ);
+	avail = min(wr - rd, batch->size);
+	if (!avail) {
+		done = -EAGAIN;
+		goto out;
+	}
+	rd = wr - avail;
+	/* read the samples only after the write index that covers them */
+	rmb();
+
+	while (avail && count) {
+		off = rd & (batch->size - 1);
+		len = min3(avail, (u32)min_t(size_t, count,
+					SNS_BATCH_BOUNCE_LEN),
+			   batch->size - off);
+		memcpy_fromio(bounce, batch->fifo + SNS_BATCH_HDR_LEN + off,
+				len);
+		if (copy_to_user(buf + done, bounce, len)) {
+			if (!done)
+				done = -EFAULT;
+			break;
+		}
+		rd += len;
+		avail -= len;
+		count -= len;
+		done += len;
+	}
+
+	/* hand the space back only once the samples have been copied */
+	mb();
+	writel_relaxed(rd, batch->fifo + SNS_BATCH_HDR_READ);
+out:
+	mutex_unlock(&batch->lock);
+	return done;
+}
+
+static unsigned int sensors_ssc_poll(struct file *file,
+				struct poll_table_struct *wait)
+{
+	struct sns_batch_s *batch = &sns_ctl.batch;
+
+	if (!batch->enabled)
+		return POLLERR;
+
+	poll_wait(file, &batch->wq, wait);
+	if (sns_batch_readable(batch))
+		return POLLIN | POLLRDNORM;
+	return 0;
+}
+
 static int sensors_ssc_open(struct inode *ip, struct file *fp)
 {
 	return 0;
@@ -278,6 +544,8 @@ const struct file_operations sensors_ssc_fops = {
 	.owner = THIS_MODULE,
 	.open = sensors_ssc_open,
 	.release = sensors_ssc_release,
+	.read = sensors_ssc_read,
+	.poll = sensors_ssc_poll,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl = sensors_ssc_ioctl,
 #endif
@@ -286,10 +554,15 @@ const struct file_operations sensors_ssc_fops = {
 
 static int sensors_ssc_probe(struct platform_device *pdev)
 {
-	int ret = slpi_loader_init_sysfs(pdev);
+	int ret = sns_batch_init(pdev);
+
+	if (ret != 0)
+		return ret;
 
+	ret = slpi_loader_init_sysfs(pdev);
 	if (ret != 0) {
 		dev_err(&pdev->dev, "%s: Error in initing sysfs\n", __func__);
+		sns_batch_exit();
 		return ret;
 	}
 
@@ -338,6 +611,7 @@ device_create_err:
 alloc_chrdev_region_err:
 	class_destroy(sns_ctl.dev_class);
 res_err:
+	sns_batch_exit();
 	return -ENODEV;
 }
 
@@ -350,6 +624,7 @@ static int sensors_ssc_remove(struct platform_device *pdev)
 	device_destroy(sns_ctl.dev_class, sns_ctl.dev_num);
 	unregister_chrdev_region(sns_ctl.dev_num, 1);
 	class_destroy(sns_ctl.dev_class);
+	sns_batch_exit();
 
 	return 0;
 }
@@ -64,6 +64,10 @@ static int bam_adaptive_timer_enabled;
 module_param_named(adaptive_timer_enabled,
 			bam_adaptive_timer_enabled,
 		   int, S_IRUGO | S_IWUSR | S_IWGRP);
+/* rx buffers are replenished once this many of them have been used */
+static unsigned int rx_refill_batch = 8;
+module_param_named(rx_refill_batch, rx_refill_batch,
+		   uint, S_IRUGO | S_IWUSR | S_IWGRP);
 
 static struct bam_ops_if bam_default_ops = {
 	/* smsm */
@@ -209,6 +213,10 @@ static unsigned long rx_timer_interval;
 static LIST_HEAD(bam_rx_pool);
 static DEFINE_MUTEX(bam_rx_pool_mutexlock);
 static int bam_rx_pool_len;
+/* rx_pkt_info structs kept for reuse, at most num_buffers of them */
+static LIST_HEAD(bam_rx_info_free);
+static DEFINE_SPINLOCK(bam_rx_info_lock);
+static int bam_rx_info_free_len;
 static LIST_HEAD(bam_tx_pool);
 static DEFINE_SPINLOCK(bam_tx_pool_spinlock);
 static DEFINE_MUTEX(bam_pdev_mutexlock);
@@ -384,13 +392,100 @@ static inline void verify_tx_queue_is_empty(const char *func)
 	spin_unlock_irqrestore(&bam_tx_pool_spinlock, flags);
 }
 
+static struct rx_pkt_info *bam_rx_info_get(gfp_t alloc_flags)
+{
+	struct rx_pkt_info *info = NULL;
+	unsigned long flags;
+
+	spin_lock_irqsave(&bam_rx_info_lock, flags);
+	if (!list_empty(&bam_rx_info_free)) {
+		info = list_first_entry(&bam_rx_info_free, struct rx_pkt_info,
+					list_node);
+		list_del(&info->list_node);
+		bam_rx_info_free_len--;
+	}
+	spin_unlock_irqrestore(&bam_rx_info_lock, flags);
+
+	if (!info) {
+		info = kmalloc(sizeof(struct rx_pkt_info), alloc_flags);
+		if (info)
+			INIT_WORK(&info->work, handle_bam_mux_cmd);
+	}
+
+	return info;
+}
+
+static void bam_rx_info_put(struct rx_pkt_info *info)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&bam_rx_info_lock, flags);
+	if (bam_rx_info_free_len < num_buffers) {
+		list_add(&info->list_node, &bam_rx_info_free);
+		bam_rx_info_free_len++;
+		info = NULL;
+	}
+	spin_unlock_irqrestore(&bam_rx_info_lock, flags);
+
+	kfree(info);
+}
+
+static void bam_rx_info_free_buf(struct rx_pkt_info *info)
+{
+	dma_unmap_single(dma_dev, info->dma_address, info->len,
+						bam_ops->dma_from);
+	dev_kfree_skb_any(info->skb);
+	bam_rx_info_put(info);
+}
+
+/**
+ * bam_rx_submit() - Queue a batch of mapped rx buffers to the rx pipe
+ * @batch:	list of rx_pkt_info to queue
+ *
+ * Only the last descriptor of the batch rings the doorbell. Buffers the
+ * pool has no room for any more, because another context refilled it
+ * meanwhile, are given back.
+ */
+static void bam_rx_submit(struct list_head *batch)
+{
+	struct rx_pkt_info *info, *tmp;
+	uint32_t flags;
+	int room;
+	int ret;
+
+	mutex_lock(&bam_rx_pool_mutexlock);
+	room = num_buffers - bam_rx_pool_len;
+	list_for_each_entry_safe(info, tmp, batch, list_node) {
+		list_del(&info->list_node);
+		if (room <= 0) {
+			bam_rx_info_free_buf(info);
+			continue;
+		}
+
+		flags = (--room && !list_empty(batch)) ?
+			SPS_IOVEC_FLAG_NO_SUBMIT : 0;
+		list_add_tail(&info->list_node, &bam_rx_pool);
+		++bam_rx_pool_len;
+		ret = bam_ops->sps_transfer_one_ptr(bam_rx_pipe,
+				info->dma_address, info->len, info, flags);
+		if (ret) {
+			list_del(&info->list_node);
+			--bam_rx_pool_len;
+			DMUX_LOG_KERR("%s: sps_transfer_one failed %d\n",
+				__func__, ret);
+			bam_rx_info_free_buf(info);
+		}
+	}
+	mutex_unlock(&bam_rx_pool_mutexlock);
+}
+
 static void __queue_rx(gfp_t alloc_flags)
 {
 	void *ptr;
-	struct rx_pkt_info *info;
-	int ret;
+	struct rx_pkt_info *info, *tmp;
 	int rx_len_cached;
 	uint16_t current_buffer_size;
+	LIST_HEAD(batch);
 
 	mutex_lock(&bam_rx_pool_mutexlock);
 	rx_len_cached = bam_rx_pool_len;
@@ -401,7 +496,7 @@ static void __queue_rx(gfp_t alloc_flags)
 		if (in_global_reset)
 			goto fail;
 
-		info = kmalloc(sizeof(struct rx_pkt_info), alloc_flags);
+		info = bam_rx_info_get(alloc_flags);
 		if (!info) {
 			DMUX_LOG_KERR(
 			"%s: unable to alloc rx_pkt_info w/ flags %x, will retry later\n",
@@ -412,8 +507,6 @@ static void __queue_rx(gfp_t alloc_flags)
 
 		info->len = current_buffer_size;
 
-		INIT_WORK(&info->work, handle_bam_mux_cmd);
-
 		info->skb = __dev_alloc_skb(info->len, alloc_flags);
 		if (info->skb == NULL) {
 			DMUX_LOG_KERR(
@@ -432,37 +525,27 @@ static void __queue_rx(gfp_t alloc_flags)
 			goto fail_skb;
 		}
 
-		mutex_lock(&bam_rx_pool_mutexlock);
-		list_add_tail(&info->list_node, &bam_rx_pool);
-		rx_len_cached = ++bam_rx_pool_len;
-		current_buffer_size = buffer_size;
-		ret = bam_ops->sps_transfer_one_ptr(bam_rx_pipe,
-				info->dma_address, info->len, info, 0);
-		if (ret) {
-			list_del(&info->list_node);
-			rx_len_cached = --bam_rx_pool_len;
-			mutex_unlock(&bam_rx_pool_mutexlock);
-			DMUX_LOG_KERR("%s: sps_transfer_one failed %d\n",
-				__func__, ret);
-
-			dma_unmap_single(dma_dev, info->dma_address,
-						info->len,
-						bam_ops->dma_from);
-
-			goto fail_skb;
-		}
-		mutex_unlock(&bam_rx_pool_mutexlock);
-
+		list_add_tail(&info->list_node, &batch);
+		rx_len_cached++;
 	}
+	bam_rx_submit(&batch);
 	return;
 
 fail_skb:
 	dev_kfree_skb_any(info->skb);
 
 fail_info:
-	kfree(info);
+	bam_rx_info_put(info);
 
 fail:
+	if (in_global_reset) {
+		list_for_each_entry_safe(info, tmp, &batch, list_node) {
+			list_del(&info->list_node);
+			bam_rx_info_free_buf(info);
+		}
+		return;
+	}
+	bam_rx_submit(&batch);
 	if (!in_global_reset) {
 		DMUX_LOG_KERR("%s: rescheduling\n", __func__);
 		schedule_work(&queue_rx_work);
@@ -471,6 +554,15 @@ fail:
 
 static void queue_rx(void)
 {
+	unsigned int batch = min(rx_refill_batch, num_buffers / 2);
+
+	/*
+	 * Replenish once a batch of buffers has been used rather than for
+	 * every packet, so that the doorbell is rung once per batch.
+	 */
+	if (ACCESS_ONCE(bam_rx_pool_len) + batch > num_buffers)
+		return;
+
 	/*
 	 * Hot path.  Delays waiting for the allocation to find memory if its
 	 * not immediately available, and delays from logging allocation
@@ -669,7 +761,7 @@ static void handle_bam_mux_cmd(struct work_struct *work)
 	dma_unmap_single(dma_dev, info->dma_address, info->len,
 			bam_ops->dma_from);
 	sps_size = info->sps_size;
-	kfree(info);
+	bam_rx_info_put(info);
 
 	rx_hdr = (struct bam_mux_hdr *)rx_skb->data;
 
@@ -1321,6 +1413,8 @@ static void rx_switch_to_interrupt_mode(void)
 		info->sps_size = iov.size;
 		handle_bam_mux_cmd(&info->work);
 	}
+	/* top up what was held back by the batched replenish */
+	__queue_rx(GFP_NOWAIT | __GFP_NOWARN);
 	return;
 
 fail:
@@ -1415,6 +1509,12 @@ static void rx_timer_work_func(struct work_struct *work)
 			handle_bam_mux_cmd(&info->work);
 		}
 
+		/*
+		 * Give the whole ring back to the A2 before sleeping so DL
+		 * data keeps flowing until the next poll.
+		 */
+		__queue_rx(GFP_NOWAIT | __GFP_NOWARN);
+
 		if (inactive_cycles >= POLLING_INACTIVITY) {
 			BAM_DMUX_LOG("%s: polling exit, no data\n", __func__);
 			rx_switch_to_interrupt_mode();
@@ -2078,10 +2178,7 @@ static void disconnect_to_bam(void)
 		node = bam_rx_pool.next;
 		list_del(node);
 		info = container_of(node, struct rx_pkt_info, list_node);
-		dma_unmap_single(dma_dev, info->dma_address, info->len,
-							bam_ops->dma_from);
-		dev_kfree_skb_any(info->skb);
-		kfree(info);
+		bam_rx_info_free_buf(info);
 	}
 	bam_rx_pool_len = 0;
 	mutex_unlock(&bam_rx_pool_mutexlock);
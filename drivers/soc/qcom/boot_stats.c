@@ -17,11 +17,18 @@
 #include <linux/delay.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
+#include <linux/i2c.h>
+#include <linux/ktime.h>
+#include <linux/spinlock.h>
+#include <linux/kobject.h>
+#include <linux/miscdevice.h>
+#include <linux/uaccess.h>
 #include <linux/clk.h>
 #include <linux/cpu.h>
 #include <linux/sched.h>
 #include <linux/of.h>
 #include <linux/of_address.h>
+#include <soc/qcom/boot_stats.h>
 
 struct boot_stats {
 	uint32_t bootloader_start;
@@ -30,10 +37,329 @@ struct boot_stats {
 	uint32_t bootloader_load_kernel;
 };
 
+#define BOOT_STATS_SLOW_PROBES		16
+#define BOOT_STATS_SLOW_INITCALLS	10
+#define BOOT_STATS_EVENTS		48
+
+struct boot_stats_probe {
+	char drv[32];
+	char dev[48];
+	s64 ts_us;
+	s64 us;
+};
+
+struct boot_stats_initcall {
+	char name[48];
+	s64 ts_us;
+	s64 us;
+};
+
+/*
+ * Boot timeline entry. Timestamps are CLOCK_MONOTONIC microseconds, the
+ * bootloader phases come before the kernel clock starts and are negative.
+ */
+struct boot_stats_event {
+	char name[BOOT_STATS_MARKER_LEN];
+	s64 ts_us;
+	s64 us;
+};
+
 static void __iomem *mpm_counter_base;
 static uint32_t mpm_counter_freq;
 static struct boot_stats __iomem *boot_stats;
 
+static DEFINE_SPINLOCK(boot_stats_lock);
+
+/* Slowest driver probes seen during boot, longest first */
+static struct boot_stats_probe slow_probes[BOOT_STATS_SLOW_PROBES];
+static bool probe_stats_done;
+
+/* Slowest initcalls, longest first */
+static struct boot_stats_initcall slow_initcalls[BOOT_STATS_SLOW_INITCALLS];
+
+/* Timeline events sorted by timestamp */
+static struct boot_stats_event boot_events[BOOT_STATS_EVENTS];
+static int nr_boot_events;
+
+static void boot_stats_add_event(const char *name, s64 ts_us, s64 us)
+{
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&boot_stats_lock, flags);
+	if (nr_boot_events == BOOT_STATS_EVENTS) {
+		spin_unlock_irqrestore(&boot_stats_lock, flags);
+		pr_warn_once("boot_stats: timeline full, dropping %s\n", name);
+		return;
+	}
+
+	/* Only the first occurrence belongs to the boot timeline */
+	for (i = 0; i < nr_boot_events; i++) {
+		if (!strncmp(boot_events[i].name, name,
+			     sizeof(boot_events[i].name) - 1)) {
+			spin_unlock_irqrestore(&boot_stats_lock, flags);
+			return;
+		}
+	}
+
+	for (i = nr_boot_events; i > 0; i--) {
+		if (boot_events[i - 1].ts_us <= ts_us)
+			break;
+		boot_events[i] = boot_events[i - 1];
+	}
+	strlcpy(boot_events[i].name, name, sizeof(boot_events[i].name));
+	boot_events[i].ts_us = ts_us;
+	boot_events[i].us = us;
+	nr_boot_events++;
+	spin_unlock_irqrestore(&boot_stats_lock, flags);
+}
+
+/**
+ * boot_stats_marker() - Add an instant event to the boot timeline
+ * @name: name of the event
+ */
+void boot_stats_marker(const char *name)
+{
+	boot_stats_add_event(name, ktime_to_us(ktime_get()), 0);
+}
+EXPORT_SYMBOL(boot_stats_marker);
+
+/**
+ * boot_stats_event() - Add a phase that started at @start to the timeline
+ * @start: ktime_get() at the start of the phase, the phase ends now
+ * @fmt: printf style name of the phase
+ */
+void boot_stats_event(ktime_t start, const char *fmt, ...)
+{
+	char name[BOOT_STATS_MARKER_LEN];
+	va_list args;
+
+	va_start(args, fmt);
+	vsnprintf(name, sizeof(name), fmt, args);
+	va_end(args);
+
+	boot_stats_add_event(name, ktime_to_us(start),
+			     ktime_us_delta(ktime_get(), start));
+}
+EXPORT_SYMBOL(boot_stats_event);
+
+/**
+ * boot_stats_initcall() - Account a boot initcall that started at @start
+ * @fn: the initcall
+ * @start: ktime_get() before the initcall was called
+ */
+void boot_stats_initcall(initcall_t fn, ktime_t start)
+{
+	struct boot_stats_initcall *ic;
+	unsigned long flags;
+	s64 us = ktime_us_delta(ktime_get(), start);
+	int i;
+
+	if (system_state != SYSTEM_BOOTING)
+		return;
+
+	spin_lock_irqsave(&boot_stats_lock, flags);
+	for (i = BOOT_STATS_SLOW_INITCALLS; i > 0; i--) {
+		if (slow_initcalls[i - 1].us >= us)
+			break;
+		if (i < BOOT_STATS_SLOW_INITCALLS)
+			slow_initcalls[i] = slow_initcalls[i - 1];
+	}
+	if (i < BOOT_STATS_SLOW_INITCALLS) {
+		ic = &slow_initcalls[i];
+		snprintf(ic->name, sizeof(ic->name), "%pf", fn);
+		ic->ts_us = ktime_to_us(start);
+		ic->us = us;
+	}
+	spin_unlock_irqrestore(&boot_stats_lock, flags);
+}
+
+static void probe_start_release(struct device *dev, void *res)
+{
+}
+
+static void boot_stats_record_probe(struct device *dev, ktime_t start)
+{
+	unsigned long flags;
+	s64 us = ktime_us_delta(ktime_get(), start);
+	int i;
+
+	spin_lock_irqsave(&boot_stats_lock, flags);
+	for (i = BOOT_STATS_SLOW_PROBES; i > 0; i--) {
+		if (slow_probes[i - 1].us >= us)
+			break;
+		if (i < BOOT_STATS_SLOW_PROBES)
+			slow_probes[i] = slow_probes[i - 1];
+	}
+	if (i < BOOT_STATS_SLOW_PROBES) {
+		strlcpy(slow_probes[i].drv, dev->driver->name,
+			sizeof(slow_probes[i].drv));
+		strlcpy(slow_probes[i].dev, dev_name(dev),
+			sizeof(slow_probes[i].dev));
+		slow_probes[i].ts_us = ktime_to_us(start);
+		slow_probes[i].us = us;
+	}
+	spin_unlock_irqrestore(&boot_stats_lock, flags);
+}
+
+/*
+ * The probe start time is kept as a device resource so that it goes
+ * away on its own when the probe fails or defers.
+ */
+static int boot_stats_bus_notify(struct notifier_block *nb,
+				 unsigned long action, void *data)
+{
+	struct device *dev = data;
+	ktime_t *start;
+
+	if (probe_stats_done)
+		return NOTIFY_DONE;
+
+	switch (action) {
+	case BUS_NOTIFY_BIND_DRIVER:
+		start = devres_alloc(probe_start_release, sizeof(*start),
+				     GFP_KERNEL);
+		if (!start)
+			break;
+		*start = ktime_get();
+		devres_add(dev, start);
+		break;
+	case BUS_NOTIFY_BOUND_DRIVER:
+		start = devres_find(dev, probe_start_release, NULL, NULL);
+		if (!start)
+			break;
+		boot_stats_record_probe(dev, *start);
+		devres_release(dev, probe_start_release, NULL, NULL);
+		break;
+	}
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block platform_probe_nb = {
+	.notifier_call = boot_stats_bus_notify,
+};
+
+#if IS_BUILTIN(CONFIG_I2C)
+static struct notifier_block i2c_probe_nb = {
+	.notifier_call = boot_stats_bus_notify,
+};
+#endif
+
+static void boot_stats_probe_init(void)
+{
+	bus_register_notifier(&platform_bus_type, &platform_probe_nb);
+#if IS_BUILTIN(CONFIG_I2C)
+	bus_register_notifier(&i2c_bus_type, &i2c_probe_nb);
+#endif
+}
+
+static void print_probe_stats(void)
+{
+	int i;
+
+	probe_stats_done = true;
+	bus_unregister_notifier(&platform_bus_type, &platform_probe_nb);
+#if IS_BUILTIN(CONFIG_I2C)
+	bus_unregister_notifier(&i2c_bus_type, &i2c_probe_nb);
+#endif
+
+	for (i = 0; i < BOOT_STATS_SLOW_PROBES && slow_probes[i].us; i++)
+		pr_info("KPI: Probe %s %s = %lld us\n", slow_probes[i].drv,
+			slow_probes[i].dev, slow_probes[i].us);
+}
+
+/*
+ * /sys/kernel/boot_stats/timeline, one "<monotonic us> <duration us> <event>"
+ * line per event, then the slowest initcalls and driver probes.
+ */
+static ssize_t timeline_show(struct kobject *kobj,
+			     struct kobj_attribute *attr, char *buf)
+{
+	unsigned long flags;
+	ssize_t len = 0;
+	int i;
+
+	spin_lock_irqsave(&boot_stats_lock, flags);
+	for (i = 0; i < nr_boot_events; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%lld %lld %s\n",
+				 boot_events[i].ts_us, boot_events[i].us,
+				 boot_events[i].name);
+
+	for (i = 0; i < BOOT_STATS_SLOW_INITCALLS && slow_initcalls[i].us;
+	     i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				 "%lld %lld initcall %s\n",
+				 slow_initcalls[i].ts_us, slow_initcalls[i].us,
+				 slow_initcalls[i].name);
+
+	for (i = 0; i < BOOT_STATS_SLOW_PROBES && slow_probes[i].us; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				 "%lld %lld probe %s %s\n",
+				 slow_probes[i].ts_us, slow_probes[i].us,
+				 slow_probes[i].drv, slow_probes[i].dev);
+	spin_unlock_irqrestore(&boot_stats_lock, flags);
+
+	return len;
+}
+
+static struct kobj_attribute timeline_attr = __ATTR_RO(timeline);
+
+static long boot_stats_ioctl(struct file *file, unsigned int cmd,
+			     unsigned long arg)
+{
+	struct boot_stats_marker marker;
+
+	if (cmd != BOOT_STATS_IOCTL_MARKER)
+		return -ENOTTY;
+
+	if (copy_from_user(&marker, (void __user *)arg, sizeof(marker)))
+		return -EFAULT;
+	marker.name[sizeof(marker.name) - 1] = '\0';
+
+	boot_stats_marker(marker.name);
+
+	return 0;
+}
+
+static const struct file_operations boot_stats_fops = {
+	.owner		= THIS_MODULE,
+	.unlocked_ioctl	= boot_stats_ioctl,
+	.compat_ioctl	= boot_stats_ioctl,
+};
+
+static struct miscdevice boot_stats_misc = {
+	.minor	= MISC_DYNAMIC_MINOR,
+	.name	= "boot_stats",
+	.fops	= &boot_stats_fops,
+};
+
+static int __init boot_stats_late_init(void)
+{
+	struct kobject *kobj;
+	int ret;
+
+	print_probe_stats();
+	boot_stats_marker("kernel_late_init_done");
+
+	kobj = kobject_create_and_add("boot_stats", kernel_kobj);
+	if (!kobj)
+		return -ENOMEM;
+
+	ret = sysfs_create_file(kobj, &timeline_attr.attr);
+	if (ret) {
+		kobject_put(kobj);
+		return ret;
+	}
+
+	ret = misc_register(&boot_stats_misc);
+	if (ret)
+		pr_err("boot_stats: misc register failed %d\n", ret);
+
+	return 0;
+}
+late_initcall_sync(boot_stats_late_init);
+
 static int mpm_parse_dt(void)
 {
 	struct device_node *np;
@@ -88,15 +414,54 @@ static void print_boot_stats(void)
 		mpm_counter_freq);
 }
 
+/* Place the bootloader MPM counts on the kernel monotonic clock */
+static void boot_stats_add_bootloader(void)
+{
+	static const struct {
+		const char *name;
+		size_t offset;
+	} phases[] = {
+		{ "bootloader_start",
+		  offsetof(struct boot_stats, bootloader_start) },
+		{ "bootloader_display",
+		  offsetof(struct boot_stats, bootloader_display) },
+		{ "bootloader_load_kernel",
+		  offsetof(struct boot_stats, bootloader_load_kernel) },
+		{ "bootloader_end",
+		  offsetof(struct boot_stats, bootloader_end) },
+	};
+	uint32_t now, count;
+	s64 now_us;
+	u64 delta;
+	int i;
+
+	if (!mpm_counter_base || !mpm_counter_freq)
+		return;
+
+	now_us = ktime_to_us(ktime_get());
+	now = readl_relaxed(mpm_counter_base);
+
+	for (i = 0; i < ARRAY_SIZE(phases); i++) {
+		count = readl_relaxed((void __iomem *)boot_stats +
+				      phases[i].offset);
+		delta = (u64)(uint32_t)(now - count) * USEC_PER_SEC;
+		do_div(delta, mpm_counter_freq);
+		boot_stats_add_event(phases[i].name, now_us - (s64)delta, 0);
+	}
+}
+
 int boot_stats_init(void)
 {
 	int ret;
 
+	boot_stats_probe_init();
+
 	ret = mpm_parse_dt();
 	if (ret < 0)
 		return -ENODEV;
 
 	print_boot_stats();
+	boot_stats_add_bootloader();
 
 	iounmap(boot_stats);
 	iounmap(mpm_counter_base);
@@ -17,6 +17,7 @@
 #include <linux/hrtimer.h>
 #include <linux/module.h>
 #include <linux/init.h>
+#include <linux/sched.h>
 #include <soc/qcom/core_ctl.h>
 
 void core_ctl_block_hotplug(void)
@@ -76,3 +77,20 @@ int __ref core_ctl_offline_core(unsigned int cpu)
 	return ret;
 }
 EXPORT_SYMBOL(core_ctl_offline_core);
+
+/*
+ * Isolation keeps the core online, so taking it back costs a mask update
+ * instead of a full hotplug cycle. Callers fall back to offlining when the
+ * scheduler does not support isolation.
+ */
+int core_ctl_isolate_core(unsigned int cpu)
+{
+	return sched_isolate_cpu(cpu);
+}
+EXPORT_SYMBOL(core_ctl_isolate_core);
+
+int core_ctl_unisolate_core(unsigned int cpu)
+{
+	return sched_unisolate_cpu(cpu);
+}
+EXPORT_SYMBOL(core_ctl_unisolate_core);
@@ -1337,6 +1337,7 @@ static struct platform_driver dcc_driver = {
 	.driver         = {
 		.name   = "msm-dcc",
 		.owner	= THIS_MODULE,
+		.probe_type	= PROBE_PREFER_ASYNCHRONOUS,
 		.of_match_table	= msm_dcc_match,
 	},
 };
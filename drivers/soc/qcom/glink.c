@@ -135,7 +135,8 @@ struct channel_ctx {
 	struct list_head local_rx_intent_free_list;
 
 	spinlock_t rmt_rx_intent_lst_lock_lhc2;
-	struct list_head rmt_rx_intent_list;
+	struct list_head rmt_rx_intent_list[GLINK_RMT_INTENT_CLASSES];
+	struct list_head rmt_rx_intent_free_list;
 
 	uint32_t max_used_liid;
 	uint32_t dummy_riid;
@@ -686,17 +687,49 @@ static struct channel_ctx *xprt_rcid_to_ch_ctx_get(
 	return NULL;
 }
 
+/**
+ * ch_rmt_intent_class() - get the remote intent list for a size
+ * @size:	Size of the intent or of the packet to be sent.
+ *
+ * Return: Index into rmt_rx_intent_list[]. Every intent in a class above
+ *	   the one returned for a packet size is large enough for it.
+ */
+static inline int ch_rmt_intent_class(size_t size)
+{
+	int class = fls_long(size >> GLINK_RMT_INTENT_CLASS_SHIFT);
+
+	return min(class, GLINK_RMT_INTENT_CLASSES - 1);
+}
+
+/**
+ * ch_init_rmt_intent_lists() - initialize the remote intent lists
+ * @ctx:	Channel context.
+ */
+static void ch_init_rmt_intent_lists(struct channel_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < GLINK_RMT_INTENT_CLASSES; i++)
+		INIT_LIST_HEAD(&ctx->rmt_rx_intent_list[i]);
+	INIT_LIST_HEAD(&ctx->rmt_rx_intent_free_list);
+}
+
 bool ch_check_duplicate_riid(struct channel_ctx *ctx, int riid)
 {
 	struct glink_core_rx_intent *intent;
 	unsigned long flags;
+	int i;
 
 	spin_lock_irqsave(&ctx->rmt_rx_intent_lst_lock_lhc2, flags);
-	list_for_each_entry(intent, &ctx->rmt_rx_intent_list, list) {
-		if (riid == intent->id) {
-			spin_unlock_irqrestore(
-				&ctx->rmt_rx_intent_lst_lock_lhc2, flags);
-			return true;
+	for (i = 0; i < GLINK_RMT_INTENT_CLASSES; i++) {
+		list_for_each_entry(intent, &ctx->rmt_rx_intent_list[i],
+				list) {
+			if (riid == intent->id) {
+				spin_unlock_irqrestore(
+					&ctx->rmt_rx_intent_lst_lock_lhc2,
+					flags);
+				return true;
+			}
 		}
 	}
 	spin_unlock_irqrestore(&ctx->rmt_rx_intent_lst_lock_lhc2, flags);
@@ -707,8 +740,8 @@ int ch_pop_remote_rx_intent(struct channel_ctx *ctx, size_t size,
 		uint32_t *riid_ptr, size_t *intent_size)
 {
 	struct glink_core_rx_intent *intent;
-	struct glink_core_rx_intent *intent_tmp;
 	unsigned long flags;
+	int class;
 
 	if (GLINK_MAX_PKT_SIZE < size) {
 		GLINK_ERR_CH(ctx, "%s: R[]:%zu Invalid size.\n", __func__,
@@ -727,25 +760,35 @@ int ch_pop_remote_rx_intent(struct channel_ctx *ctx, size_t size,
 					flags);
 		return 0;
 	}
-	list_for_each_entry_safe(intent, intent_tmp, &ctx->rmt_rx_intent_list,
-			list) {
-		if (intent->intent_size >= size) {
-			list_del(&intent->list);
-			GLINK_DBG_CH(ctx,
-					"%s: R[%u]:%zu Removed remote intent\n",
-					__func__,
-					intent->id,
-					intent->intent_size);
-			*riid_ptr = intent->id;
-			*intent_size = intent->intent_size;
-			kfree(intent);
-			spin_unlock_irqrestore(
-				&ctx->rmt_rx_intent_lst_lock_lhc2, flags);
-			return 0;
+
+	/*
+	 * Only the list of the size's own class has to be searched, any
+	 * intent at the head of a higher class list fits.
+	 */
+	class = ch_rmt_intent_class(size);
+	list_for_each_entry(intent, &ctx->rmt_rx_intent_list[class], list) {
+		if (intent->intent_size >= size)
+			goto found;
+	}
+	for (class++; class < GLINK_RMT_INTENT_CLASSES; class++) {
+		if (!list_empty(&ctx->rmt_rx_intent_list[class])) {
+			intent = list_first_entry(
+					&ctx->rmt_rx_intent_list[class],
+					struct glink_core_rx_intent, list);
+			goto found;
 		}
 	}
 	spin_unlock_irqrestore(&ctx->rmt_rx_intent_lst_lock_lhc2, flags);
 	return -EAGAIN;
+
+found:
+	GLINK_DBG_CH(ctx, "%s: R[%u]:%zu Removed remote intent\n", __func__,
+			intent->id, intent->intent_size);
+	*riid_ptr = intent->id;
+	*intent_size = intent->intent_size;
+	list_move(&intent->list, &ctx->rmt_rx_intent_free_list);
+	spin_unlock_irqrestore(&ctx->rmt_rx_intent_lst_lock_lhc2, flags);
+	return 0;
 }
 
 void ch_push_remote_rx_intent(struct channel_ctx *ctx, size_t size,
@@ -767,20 +810,34 @@ void ch_push_remote_rx_intent(struct channel_ctx *ctx, size_t size,
 		return;
 	}
 
-	gfp_flag = (ctx->transport_ptr->capabilities & GCAP_AUTO_QUEUE_RX_INT) ?
-							GFP_ATOMIC : GFP_KERNEL;
-	intent = kzalloc(sizeof(struct glink_core_rx_intent), gfp_flag);
-	if (!intent) {
-		GLINK_ERR_CH(ctx,
-			"%s: R[%u]:%zu Memory allocation for intent failed\n",
-			__func__, riid, size);
-		return;
+	/* reuse an intent freed by ch_pop_remote_rx_intent() if possible */
+	spin_lock_irqsave(&ctx->rmt_rx_intent_lst_lock_lhc2, flags);
+	intent = list_first_entry_or_null(&ctx->rmt_rx_intent_free_list,
+			struct glink_core_rx_intent, list);
+	if (intent)
+		list_del(&intent->list);
+	spin_unlock_irqrestore(&ctx->rmt_rx_intent_lst_lock_lhc2, flags);
+
+	if (intent) {
+		memset(intent, 0, sizeof(*intent));
+	} else {
+		gfp_flag = (ctx->transport_ptr->capabilities &
+			    GCAP_AUTO_QUEUE_RX_INT) ? GFP_ATOMIC : GFP_KERNEL;
+		intent = kzalloc(sizeof(struct glink_core_rx_intent),
+				gfp_flag);
+		if (!intent) {
+			GLINK_ERR_CH(ctx,
+				"%s: R[%u]:%zu Memory allocation for intent failed\n",
+				__func__, riid, size);
+			return;
+		}
 	}
 	intent->id = riid;
 	intent->intent_size = size;
 
 	spin_lock_irqsave(&ctx->rmt_rx_intent_lst_lock_lhc2, flags);
-	list_add_tail(&intent->list, &ctx->rmt_rx_intent_list);
+	list_add_tail(&intent->list,
+		&ctx->rmt_rx_intent_list[ch_rmt_intent_class(size)]);
 
 	complete_all(&ctx->int_req_complete);
 	if (ctx->notify_remote_rx_intent)
@@ -1072,6 +1129,7 @@ void ch_purge_intent_lists(struct channel_ctx *ctx)
 	struct glink_core_rx_intent *ptr_intent, *tmp_intent;
 	struct glink_core_tx_pkt *tx_info, *tx_info_temp;
 	unsigned long flags;
+	int i;
 
 	spin_lock_irqsave(&ctx->tx_lists_lock_lhc3, flags);
 	list_for_each_entry_safe(tx_info, tx_info_temp, &ctx->tx_active,
@@ -1104,8 +1162,11 @@ void ch_purge_intent_lists(struct channel_ctx *ctx)
 	spin_unlock_irqrestore(&ctx->local_rx_intent_lst_lock_lhc1, flags);
 
 	spin_lock_irqsave(&ctx->rmt_rx_intent_lst_lock_lhc2, flags);
+	for (i = 0; i < GLINK_RMT_INTENT_CLASSES; i++)
+		list_splice_init(&ctx->rmt_rx_intent_list[i],
+				&ctx->rmt_rx_intent_free_list);
 	list_for_each_entry_safe(ptr_intent, tmp_intent,
-			&ctx->rmt_rx_intent_list, list) {
+			&ctx->rmt_rx_intent_free_list, list) {
 		list_del(&ptr_intent->list);
 		kfree(ptr_intent);
 	}
@@ -1235,7 +1296,7 @@ static struct channel_ctx *ch_name_to_ch_ctx_create(
 	INIT_LIST_HEAD(&ctx->local_rx_intent_ntfy_list);
 	INIT_LIST_HEAD(&ctx->local_rx_intent_free_list);
 	spin_lock_init(&ctx->local_rx_intent_lst_lock_lhc1);
-	INIT_LIST_HEAD(&ctx->rmt_rx_intent_list);
+	ch_init_rmt_intent_lists(ctx);
 	spin_lock_init(&ctx->rmt_rx_intent_lst_lock_lhc2);
 	INIT_LIST_HEAD(&ctx->tx_active);
 	spin_lock_init(&ctx->tx_pending_rmt_done_lock_lhc4);
@@ -3215,7 +3276,7 @@ static bool ch_migrate(struct channel_ctx *l_ctx, struct channel_ctx *r_ctx)
 	INIT_LIST_HEAD(&ctx_clone->local_rx_intent_list);
 	INIT_LIST_HEAD(&ctx_clone->local_rx_intent_ntfy_list);
 	INIT_LIST_HEAD(&ctx_clone->local_rx_intent_free_list);
-	INIT_LIST_HEAD(&ctx_clone->rmt_rx_intent_list);
+	ch_init_rmt_intent_lists(ctx_clone);
 	INIT_LIST_HEAD(&ctx_clone->tx_active);
 	spin_lock_init(&ctx_clone->tx_pending_rmt_done_lock_lhc4);
 	INIT_LIST_HEAD(&ctx_clone->tx_pending_remote_done);
@@ -4246,12 +4307,15 @@ int glink_get_ch_rintents_queued(struct channel_ctx *ch_ctx)
 {
 	struct glink_core_rx_intent *intent;
 	int irrx_count = 0;
+	int i;
 
 	if (ch_ctx == NULL)
 		return -EINVAL;
 
-	list_for_each_entry(intent, &ch_ctx->rmt_rx_intent_list, list)
-		irrx_count++;
+	for (i = 0; i < GLINK_RMT_INTENT_CLASSES; i++)
+		list_for_each_entry(intent, &ch_ctx->rmt_rx_intent_list[i],
+				list)
+			irrx_count++;
 
 	return irrx_count;
 }
@@ -4267,7 +4331,8 @@ void glink_get_ch_intent_info(struct channel_ctx *ch_ctx,
 	ch_ctx_i->li_avail_list = &ch_ctx->local_rx_intent_list;
 	ch_ctx_i->li_used_list = &ch_ctx->local_rx_intent_ntfy_list;
 	ch_ctx_i->ri_lst_lock = &ch_ctx->rmt_rx_intent_lst_lock_lhc2;
-	ch_ctx_i->ri_list = &ch_ctx->rmt_rx_intent_list;
+	ch_ctx_i->ri_list = ch_ctx->rmt_rx_intent_list;
+	ch_ctx_i->ri_list_cnt = GLINK_RMT_INTENT_CLASSES;
 }
 EXPORT_SYMBOL(glink_get_ch_intent_info);
 
@@ -0,0 +1,566 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * G-Link loopback benchmark. Acts as a client of a G-Link loopback server
+ * (see glink_loopback_server.c), which the remote subsystems run as well,
+ * and measures the echo throughput and round trip time of one data
+ * channel, on demand from debugfs:
+ *
+ *	echo "<transport> <edge> <ctl_ch> <size> <count> <window>" \
+ *		> glink_bench/run
+ *	cat glink_bench/run
+ *
+ * e.g. "smem mpss LOOPBACK_CTL_MPSS 4096 1000 8". The server is asked to
+ * open the data channel and echo every packet back untransformed. Up to
+ * <window> packets are in flight at once, a window of 1 gives the ping
+ * pong latency. The channels are opened for the run and closed after it.
+ */
+
+#include <linux/atomic.h>
+#include <linux/debugfs.h>
+#include <linux/err.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/spinlock.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
+#include <soc/qcom/glink.h>
+#include "glink_loopback_commands.h"
+
+#define GLINK_BENCH_DATA_CH		"LOOPBACK_BENCH_CLNT"
+#define GLINK_BENCH_MAX_SIZE		SZ_64K
+#define GLINK_BENCH_MAX_COUNT		4096
+#define GLINK_BENCH_MAX_WINDOW		64
+/* data intents the server queues up front, it asks for the rest */
+#define GLINK_BENCH_SRV_INTENTS		128
+#define GLINK_BENCH_TIMEOUT		(5 * HZ)
+#define GLINK_BENCH_RESULT_BUF		512
+
+#define BENCH_ERR(x...) pr_err("glink_bench: " x)
+
+/**
+ * struct glink_bench_ch - one channel of the benchmark
+ * @handle:		G-Link handle, NULL while the channel is not open
+ * @connected:		Both sides have opened the channel
+ * @closed:		The local close has completed
+ * @intent_size:	Size of the rx intents queued on the channel
+ * @intents_owed:	Intents to be queued from @intent_work
+ * @intent_work:	Queues intents outside of the G-Link callbacks
+ */
+struct glink_bench_ch {
+	void *handle;
+	bool connected;
+	bool closed;
+	size_t intent_size;
+	atomic_t intents_owed;
+	struct work_struct intent_work;
+};
+
+/**
+ * struct glink_bench - state of the benchmark run
+ * @ctl:	Control channel of the loopback server
+ * @data:	Data channel echoed by the server
+ * @wait:	Woken on channel state changes, responses and echoes
+ * @lock:	Protects @resp and @resp_valid
+ * @req:	Request being sent, kept until the server responds
+ * @resp:	Last response received on @ctl
+ * @resp_valid:	@resp holds a response not yet consumed
+ * @req_id:	Id of the last request sent
+ * @tx_buf:	Payload sent on @data, shared by all packets in flight
+ * @tx_ts:	Send time of every packet
+ * @rtt:	Round trip time of every packet, in ns
+ * @sent:	Packets sent
+ * @recv:	Echoes received, matched to packets in order
+ * @tx_done:	Packets the transport is done with, @tx_buf is freed after
+ *		all of them are
+ * @bad_size:	Echoes whose size did not match
+ */
+struct glink_bench {
+	struct glink_bench_ch ctl;
+	struct glink_bench_ch data;
+	wait_queue_head_t wait;
+	spinlock_t lock;
+	struct req req;
+	struct resp resp;
+	bool resp_valid;
+	uint32_t req_id;
+	void *tx_buf;
+	ktime_t *tx_ts;
+	u32 *rtt;
+	unsigned int sent;
+	atomic_t recv;
+	atomic_t tx_done;
+	atomic_t bad_size;
+};
+
+static struct glink_bench bench;
+static struct dentry *glink_bench_dent;
+static DEFINE_MUTEX(glink_bench_mutex);
+static char glink_bench_result[GLINK_BENCH_RESULT_BUF];
+
+static void glink_bench_intent_worker(struct work_struct *work)
+{
+	struct glink_bench_ch *ch = container_of(work, struct glink_bench_ch,
+						 intent_work);
+	int ret;
+
+	while (atomic_add_unless(&ch->intents_owed, -1, 0)) {
+		ret = glink_queue_rx_intent(ch->handle, ch, ch->intent_size);
+		if (ret) {
+			BENCH_ERR("%s: queue intent size %zu failed %d\n",
+				  __func__, ch->intent_size, ret);
+			break;
+		}
+	}
+}
+
+static void glink_bench_notify_rx(void *handle, const void *priv,
+				  const void *pkt_priv, const void *ptr,
+				  size_t size)
+{
+	struct glink_bench_ch *ch = (struct glink_bench_ch *)priv;
+	unsigned long flags;
+	unsigned int n;
+
+	if (ch == &bench.ctl) {
+		spin_lock_irqsave(&bench.lock, flags);
+		if (size >= sizeof(bench.resp)) {
+			memcpy(&bench.resp, ptr, sizeof(bench.resp));
+			bench.resp_valid = true;
+		}
+		spin_unlock_irqrestore(&bench.lock, flags);
+	} else {
+		n = atomic_read(&bench.recv);
+		if (n < bench.sent) {
+			bench.rtt[n] = ktime_to_ns(ktime_sub(ktime_get(),
+							     bench.tx_ts[n]));
+			if (size != ch->intent_size)
+				atomic_inc(&bench.bad_size);
+			atomic_inc(&bench.recv);
+		}
+	}
+
+	/* intents are reused where the transport can, requeued otherwise */
+	if (glink_rx_done(handle, ptr, true)) {
+		atomic_inc(&ch->intents_owed);
+		schedule_work(&ch->intent_work);
+	}
+	wake_up(&bench.wait);
+}
+
+static void glink_bench_notify_tx_done(void *handle, const void *priv,
+				       const void *pkt_priv, const void *ptr)
+{
+	if (priv != &bench.data)
+		return;
+
+	atomic_inc(&bench.tx_done);
+	wake_up(&bench.wait);
+}
+
+static void glink_bench_notify_state(void *handle, const void *priv,
+				     unsigned event)
+{
+	struct glink_bench_ch *ch = (struct glink_bench_ch *)priv;
+
+	switch (event) {
+	case GLINK_CONNECTED:
+		ch->connected = true;
+		break;
+	case GLINK_REMOTE_DISCONNECTED:
+		ch->connected = false;
+		break;
+	case GLINK_LOCAL_DISCONNECTED:
+		ch->connected = false;
+		ch->closed = true;
+		break;
+	}
+	wake_up(&bench.wait);
+}
+
+static bool glink_bench_notify_rx_intent_req(void *handle, const void *priv,
+					     size_t req_size)
+{
+	struct glink_bench_ch *ch = (struct glink_bench_ch *)priv;
+
+	if (req_size > ch->intent_size)
+		return false;
+
+	atomic_inc(&ch->intents_owed);
+	schedule_work(&ch->intent_work);
+	return true;
+}
+
+static int glink_bench_open(struct glink_bench_ch *ch, const char *transport,
+			    const char *edge, const char *name)
+{
+	struct glink_open_config cfg;
+	void *handle;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.priv = ch;
+	cfg.transport = transport;
+	cfg.edge = edge;
+	cfg.name = name;
+	cfg.notify_rx = glink_bench_notify_rx;
+	cfg.notify_tx_done = glink_bench_notify_tx_done;
+	cfg.notify_state = glink_bench_notify_state;
+	cfg.notify_rx_intent_req = glink_bench_notify_rx_intent_req;
+
+	ch->connected = false;
+	ch->closed = false;
+	atomic_set(&ch->intents_owed, 0);
+	handle = glink_open(&cfg);
+	if (IS_ERR_OR_NULL(handle)) {
+		BENCH_ERR("%s: %s:%s:%s open failed %ld\n", __func__,
+			  transport, edge, name, PTR_ERR(handle));
+		return handle ? PTR_ERR(handle) : -ENODEV;
+	}
+	ch->handle = handle;
+
+	if (!wait_event_timeout(bench.wait, ch->connected,
+				GLINK_BENCH_TIMEOUT)) {
+		BENCH_ERR("%s: %s:%s:%s not connected\n", __func__,
+			  transport, edge, name);
+		return -ETIMEDOUT;
+	}
+
+	return 0;
+}
+
+static void glink_bench_close(struct glink_bench_ch *ch)
+{
+	if (!ch->handle)
+		return;
+
+	cancel_work_sync(&ch->intent_work);
+	if (!glink_close(ch->handle))
+		wait_event_timeout(bench.wait, ch->closed,
+				   GLINK_BENCH_TIMEOUT);
+	ch->handle = NULL;
+}
+
+static int glink_bench_queue_intents(struct glink_bench_ch *ch, size_t size,
+				     unsigned int num)
+{
+	int ret;
+
+	ch->intent_size = size;
+	while (num--) {
+		ret = glink_queue_rx_intent(ch->handle, ch, size);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * Sends the request in bench.req, of @type with a payload of @size, and
+ * waits for the response of the server.
+ */
+static int glink_bench_request(uint32_t type, size_t size)
+{
+	unsigned long flags;
+	bool done = false;
+	int ret;
+
+	spin_lock_irqsave(&bench.lock, flags);
+	bench.resp_valid = false;
+	spin_unlock_irqrestore(&bench.lock, flags);
+
+	bench.req.hdr.req_id = ++bench.req_id;
+	bench.req.hdr.req_type = type;
+	bench.req.hdr.req_size = size;
+
+	ret = glink_tx(bench.ctl.handle, NULL, &bench.req, sizeof(bench.req),
+		       GLINK_TX_REQ_INTENT);
+	if (ret)
+		return ret;
+
+	while (!done) {
+		if (!wait_event_timeout(bench.wait, bench.resp_valid,
+					GLINK_BENCH_TIMEOUT))
+			return -ETIMEDOUT;
+
+		spin_lock_irqsave(&bench.lock, flags);
+		if (bench.resp.req_id == bench.req_id) {
+			ret = bench.resp.response;
+			done = true;
+		}
+		bench.resp_valid = false;
+		spin_unlock_irqrestore(&bench.lock, flags);
+	}
+
+	return ret ? -EIO : 0;
+}
+
+static int glink_bench_open_server(void)
+{
+	union req_payload *p = &bench.req.payload;
+
+	memset(p, 0, sizeof(*p));
+	p->open.name_len = strlen(GLINK_BENCH_DATA_CH);
+	strlcpy(p->open.ch_name, GLINK_BENCH_DATA_CH, MAX_NAME_LEN);
+	return glink_bench_request(OPEN, sizeof(p->open));
+}
+
+static int glink_bench_configure_echo(size_t size, unsigned int count)
+{
+	union req_payload *p = &bench.req.payload;
+	int ret;
+
+	memset(p, 0, sizeof(*p));
+	p->q_rx_int_conf.num_intents = min_t(unsigned int, count,
+					     GLINK_BENCH_SRV_INTENTS);
+	p->q_rx_int_conf.intent_size = size;
+	p->q_rx_int_conf.name_len = strlen(GLINK_BENCH_DATA_CH);
+	strlcpy(p->q_rx_int_conf.ch_name, GLINK_BENCH_DATA_CH, MAX_NAME_LEN);
+	ret = glink_bench_request(QUEUE_RX_INTENT_CONFIG,
+				  sizeof(p->q_rx_int_conf));
+	if (ret)
+		return ret;
+
+	memset(p, 0, sizeof(*p));
+	p->tx_conf.echo_count = 1;
+	p->tx_conf.transform_type = NO_TRANSFORM;
+	p->tx_conf.name_len = strlen(GLINK_BENCH_DATA_CH);
+	strlcpy(p->tx_conf.ch_name, GLINK_BENCH_DATA_CH, MAX_NAME_LEN);
+	return glink_bench_request(TX_CONFIG, sizeof(p->tx_conf));
+}
+
+static void glink_bench_close_server(void)
+{
+	union req_payload *p = &bench.req.payload;
+
+	memset(p, 0, sizeof(*p));
+	p->close.name_len = strlen(GLINK_BENCH_DATA_CH);
+	strlcpy(p->close.ch_name, GLINK_BENCH_DATA_CH, MAX_NAME_LEN);
+	if (glink_bench_request(CLOSE, sizeof(p->close)))
+		BENCH_ERR("%s: server did not close %s\n", __func__,
+			  GLINK_BENCH_DATA_CH);
+}
+
+static int glink_bench_u32_cmp(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static bool glink_bench_can_send(unsigned int window)
+{
+	return atomic_read(&bench.recv) + window > bench.sent ||
+		!bench.data.connected;
+}
+
+static int glink_bench_transfer(size_t size, unsigned int count,
+				unsigned int window, u64 *total_ns)
+{
+	ktime_t start = ktime_get();
+	int ret;
+
+	while (bench.sent < count) {
+		if (!wait_event_timeout(bench.wait,
+					glink_bench_can_send(window),
+					GLINK_BENCH_TIMEOUT))
+			return -ETIMEDOUT;
+		if (!bench.data.connected)
+			return -ENOTCONN;
+
+		bench.tx_ts[bench.sent++] = ktime_get();
+		ret = glink_tx(bench.data.handle, NULL, bench.tx_buf, size,
+			       GLINK_TX_REQ_INTENT);
+		if (ret) {
+			bench.sent--;
+			return ret;
+		}
+	}
+
+	if (!wait_event_timeout(bench.wait,
+				atomic_read(&bench.recv) == count,
+				GLINK_BENCH_TIMEOUT))
+		return -ETIMEDOUT;
+	*total_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	return 0;
+}
+
+static int glink_bench_exec(const char *transport, const char *edge,
+			    const char *ctl_ch, size_t size,
+			    unsigned int count, unsigned int window)
+{
+	u64 total_ns = 0;
+	int ret;
+
+	bench.sent = 0;
+	atomic_set(&bench.recv, 0);
+	atomic_set(&bench.tx_done, 0);
+	atomic_set(&bench.bad_size, 0);
+
+	ret = -ENOMEM;
+	bench.tx_buf = kmalloc(size, GFP_KERNEL);
+	bench.tx_ts = vmalloc(count * sizeof(*bench.tx_ts));
+	bench.rtt = vmalloc(count * sizeof(*bench.rtt));
+	if (!bench.tx_buf || !bench.tx_ts || !bench.rtt)
+		goto out_free;
+	memset(bench.tx_buf, 0x5a, size);
+
+	ret = glink_bench_open(&bench.ctl, transport, edge, ctl_ch);
+	if (ret)
+		goto out_close;
+	ret = glink_bench_queue_intents(&bench.ctl, sizeof(struct resp), 1);
+	if (ret)
+		goto out_close;
+
+	ret = glink_bench_open_server();
+	if (ret)
+		goto out_close;
+
+	ret = glink_bench_open(&bench.data, transport, edge,
+			       GLINK_BENCH_DATA_CH);
+	if (!ret)
+		ret = glink_bench_queue_intents(&bench.data, size, window);
+	if (!ret)
+		ret = glink_bench_configure_echo(size, count);
+	if (!ret)
+		ret = glink_bench_transfer(size, count, window, &total_ns);
+
+	if (bench.data.handle)
+		wait_event_timeout(bench.wait,
+				   atomic_read(&bench.tx_done) == bench.sent,
+				   GLINK_BENCH_TIMEOUT);
+	glink_bench_close_server();
+out_close:
+	glink_bench_close(&bench.data);
+	glink_bench_close(&bench.ctl);
+
+	if (!ret) {
+		sort(bench.rtt, count, sizeof(*bench.rtt), glink_bench_u32_cmp,
+		     NULL);
+		scnprintf(glink_bench_result, sizeof(glink_bench_result),
+			"transport %s edge %s size %zu count %u window %u\n"
+			"kBps %llu rtt_p50_ns %u rtt_p90_ns %u rtt_p99_ns %u rtt_max_ns %u bad_size %d\n",
+			transport, edge, size, count, window,
+			div64_u64((u64)size * count * USEC_PER_SEC,
+				  max_t(u64, total_ns, 1)),
+			bench.rtt[count / 2], bench.rtt[count * 9 / 10],
+			bench.rtt[count * 99 / 100], bench.rtt[count - 1],
+			atomic_read(&bench.bad_size));
+	}
+out_free:
+	if (ret)
+		scnprintf(glink_bench_result, sizeof(glink_bench_result),
+			  "transport %s edge %s error %d\n", transport, edge,
+			  ret);
+	vfree(bench.rtt);
+	vfree(bench.tx_ts);
+	kfree(bench.tx_buf);
+	bench.rtt = NULL;
+	bench.tx_ts = NULL;
+	bench.tx_buf = NULL;
+
+	return ret;
+}
+
+static ssize_t glink_bench_run_write(struct file *file,
+				     const char __user *ubuf, size_t count,
+				     loff_t *ppos)
+{
+	char buf[128], transport[GLINK_NAME_SIZE], edge[GLINK_NAME_SIZE];
+	char ctl_ch[MAX_NAME_LEN];
+	unsigned int pkts, window;
+	size_t size;
+	int ret;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sscanf(buf, "%31s %31s %31s %zu %u %u", transport, edge, ctl_ch,
+		   &size, &pkts, &window) != 6)
+		return -EINVAL;
+
+	if (!size || size > GLINK_BENCH_MAX_SIZE || !pkts ||
+	    pkts > GLINK_BENCH_MAX_COUNT || !window ||
+	    window > GLINK_BENCH_MAX_WINDOW)
+		return -EINVAL;
+
+	mutex_lock(&glink_bench_mutex);
+	ret = glink_bench_exec(transport, edge, ctl_ch, size, pkts, window);
+	mutex_unlock(&glink_bench_mutex);
+
+	return ret ? ret : count;
+}
+
+static ssize_t glink_bench_run_read(struct file *file, char __user *ubuf,
+				    size_t count, loff_t *ppos)
+{
+	ssize_t ret;
+
+	mutex_lock(&glink_bench_mutex);
+	ret = simple_read_from_buffer(ubuf, count, ppos, glink_bench_result,
+				      strlen(glink_bench_result));
+	mutex_unlock(&glink_bench_mutex);
+
+	return ret;
+}
+
+static const struct file_operations glink_bench_run_ops = {
+	.open = simple_open,
+	.read = glink_bench_run_read,
+	.write = glink_bench_run_write,
+};
+
+static int __init glink_bench_init(void)
+{
+	init_waitqueue_head(&bench.wait);
+	spin_lock_init(&bench.lock);
+	INIT_WORK(&bench.ctl.intent_work, glink_bench_intent_worker);
+	INIT_WORK(&bench.data.intent_work, glink_bench_intent_worker);
+
+	glink_bench_dent = debugfs_create_dir("glink_bench", NULL);
+	if (IS_ERR_OR_NULL(glink_bench_dent)) {
+		BENCH_ERR("%s: debugfs_create_dir fail, error %ld\n",
+			  __func__, PTR_ERR(glink_bench_dent));
+		return -ENODEV;
+	}
+
+	if (!debugfs_create_file("run", S_IRUSR | S_IWUSR, glink_bench_dent,
+				 NULL, &glink_bench_run_ops)) {
+		debugfs_remove_recursive(glink_bench_dent);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void __exit glink_bench_exit(void)
+{
+	debugfs_remove_recursive(glink_bench_dent);
+}
+
+module_init(glink_bench_init);
+module_exit(glink_bench_exit);
+
+MODULE_DESCRIPTION("MSM Generic Link (G-Link) Loopback Benchmark");
+MODULE_LICENSE("GPL v2");
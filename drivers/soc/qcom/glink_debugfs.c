@@ -243,6 +243,7 @@ static void glink_dfs_update_ch_intent(struct seq_file *s)
 	struct glink_ch_intent_info ch_intent_info;
 	unsigned long flags;
 	unsigned int count = 0;
+	int i;
 
 	dfs_d = s->private;
 	ch_ctx = dfs_d->priv_data;
@@ -276,10 +277,13 @@ static void glink_dfs_update_ch_intent(struct seq_file *s)
 
 		count = 0;
 		spin_lock_irqsave(ch_intent_info.ri_lst_lock, flags);
-		list_for_each_entry_safe(intent, intent_temp,
-				ch_intent_info.ri_list, list) {
-			count++;
-			write_ch_intent(s, intent, "REMOTE_LIST", count);
+		for (i = 0; i < ch_intent_info.ri_list_cnt; i++) {
+			list_for_each_entry_safe(intent, intent_temp,
+					&ch_intent_info.ri_list[i], list) {
+				count++;
+				write_ch_intent(s, intent, "REMOTE_LIST",
+						count);
+			}
 		}
 		spin_unlock_irqrestore(ch_intent_info.ri_lst_lock,
 					flags);
@@ -85,12 +85,21 @@ struct ch_ctx_iterator {
 	unsigned long ch_list_flags;
 };
 
+/*
+ * Remote intents are kept in lists by size class. Class 0 holds intents
+ * below 64 bytes, class n the ones of [32 << n, 64 << n) bytes and the
+ * last class everything from 64KB up.
+ */
+#define GLINK_RMT_INTENT_CLASSES	12
+#define GLINK_RMT_INTENT_CLASS_SHIFT	6
+
 struct glink_ch_intent_info {
 	spinlock_t *li_lst_lock;
 	struct list_head *li_avail_list;
 	struct list_head *li_used_list;
 	spinlock_t *ri_lst_lock;
 	struct list_head *ri_list;
+	int ri_list_cnt;
 };
 
 /* Tracer Packet Event IDs for G-Link */
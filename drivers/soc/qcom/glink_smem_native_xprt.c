@@ -534,38 +534,51 @@ static int fifo_write(struct edge_info *einfo, const void *data, int len)
 }
 
 /**
- * fifo_write_complex() - writes a transaction of multiple buffers to an edge
+ * fifo_write_pkt() - writes a command and a range of a tx packet to an edge
  * @einfo:	The concerned edge to write to.
- * @data1:	The first buffer of data to write.
- * @len1:	The length of the first buffer in bytes.
- * @data2:	The second buffer of data to write.
- * @len2:	The length of the second buffer in bytes.
- * @data3:	The thirs buffer of data to write.
- * @len3:	The length of the third buffer in bytes.
+ * @cmd:	The command to write ahead of the data.
+ * @cmd_len:	The length of the command in bytes.
+ * @pctx:	The packet to take the data from.
+ * @offset:	The offset of the data into the packet.
+ * @len:	The length of the data in bytes.
+ * @pad:	The padding to write after the data.
+ * @pad_len:	The length of the padding in bytes.
  *
  * A variant of fifo_write() which optimizes the usecase found in tx().  The
  * remote side expects all or none of the transmitted data to be available.
- * This prevents the tx() usecase from calling fifo_write() multiple times.  The
- * alternative would be an allocation and additional memcpy to create a buffer
- * to copy all the data segments into one location before calling fifo_write().
+ * The data is gathered from the buffers of the packet straight into the
+ * fifo, so that a vector packet needs neither a bounce buffer nor one
+ * command per buffer.  The caller must have checked that the packet provides
+ * @len bytes at @offset.
  *
  * Return: Number of bytes written to the edge.
  */
-static int fifo_write_complex(struct edge_info *einfo,
-			      const void *data1, int len1,
-			      const void *data2, int len2,
-			      const void *data3, int len3)
+static int fifo_write_pkt(struct edge_info *einfo, const void *cmd,
+			  int cmd_len, struct glink_core_tx_pkt *pctx,
+			  size_t offset, int len, const void *pad, int pad_len)
 {
-	int orig_len = len1 + len2 + len3;
+	int orig_len = cmd_len + len + pad_len;
 	uint32_t write_index = einfo->tx_ch_desc->write_index;
+	const void *data;
+	size_t seg_size;
+	int n;
 
-	len1 = fifo_write_body(einfo, data1, len1, &write_index);
-	len2 = fifo_write_body(einfo, data2, len2, &write_index);
-	len3 = fifo_write_body(einfo, data3, len3, &write_index);
+	cmd_len = fifo_write_body(einfo, cmd, cmd_len, &write_index);
+	while (len) {
+		data = get_tx_vaddr(pctx, offset, &seg_size);
+		if (!data || !seg_size)
+			break;
+		n = min_t(size_t, seg_size, len);
+		if (fifo_write_body(einfo, data, n, &write_index))
+			break;
+		offset += n;
+		len -= n;
+	}
+	pad_len = fifo_write_body(einfo, pad, pad_len, &write_index);
 	einfo->tx_ch_desc->write_index = write_index;
 	send_irq(einfo);
 
-	return orig_len - len1 - len2 - len3;
+	return orig_len - cmd_len - len - pad_len;
 }
 
 /**
@@ -1865,7 +1878,8 @@ static int tx_data(struct glink_transport_if *if_ptr, uint16_t cmd_id,
 	struct edge_info *einfo;
 	uint32_t size;
 	uint32_t zeros_size;
-	const void *data_start;
+	size_t offset;
+	size_t seg_size;
 	char zeros[FIFO_ALIGNMENT] = { 0 };
 	unsigned long flags;
 	size_t tx_size = 0;
@@ -1906,13 +1920,22 @@ static int tx_data(struct glink_transport_if *if_ptr, uint16_t cmd_id,
 	}
 	cmd.lcid = lcid;
 	cmd.riid = pctx->riid;
-	data_start = get_tx_vaddr(pctx, pctx->size - pctx->size_remaining,
-				  &tx_size);
-	if (!data_start) {
+
+	/* Find how much of the remaining data the packet buffers provide */
+	offset = pctx->size - pctx->size_remaining;
+	while (tx_size < pctx->size_remaining) {
+		if (!get_tx_vaddr(pctx, offset + tx_size, &seg_size) ||
+		    !seg_size)
+			break;
+		tx_size += seg_size;
+	}
+	if (!tx_size) {
 		GLINK_ERR("%s: invalid data_start\n", __func__);
 		srcu_read_unlock(&einfo->use_ref, rcu_id);
 		return -EINVAL;
 	}
+	if (tx_size > pctx->size_remaining)
+		tx_size = pctx->size_remaining;
 
 	spin_lock_irqsave(&einfo->write_lock, flags);
 	size = fifo_write_avail(einfo);
@@ -1942,7 +1965,7 @@ static int tx_data(struct glink_transport_if *if_ptr, uint16_t cmd_id,
 	if (cmd.id == TRACER_PKT_CMD)
 		tracer_pkt_log_event((void *)(pctx->data), GLINK_XPRT_TX);
 
-	fifo_write_complex(einfo, &cmd, sizeof(cmd), data_start, size, zeros,
+	fifo_write_pkt(einfo, &cmd, sizeof(cmd), pctx, offset, size, zeros,
 								zeros_size);
 	GLINK_DBG("%s %s: lcid[%u] riid[%u] cmd[%d], size[%d], size_left[%d]\n",
 		"<SMEM>", __func__, cmd.lcid, cmd.riid, cmd.id, cmd.size,
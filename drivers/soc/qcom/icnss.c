@@ -19,6 +19,10 @@
 #include <linux/platform_device.h>
 #include <linux/interrupt.h>
 #include <linux/sched.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/qmi_encdec.h>
 #include <soc/qcom/memory_dump.h>
 #include <soc/qcom/icnss.h>
@@ -30,6 +34,27 @@ enum icnss_qmi_event_type {
 	ICNSS_QMI_EVENT_SERVER_ARRIVE,
 	ICNSS_QMI_EVENT_SERVER_EXIT,
 	ICNSS_QMI_EVENT_FW_READY_IND,
+	ICNSS_QMI_EVENT_CAL_UPDATE_IND,
+	ICNSS_QMI_EVENT_CAL_DOWNLOAD_IND,
+};
+
+enum icnss_phase {
+	ICNSS_PHASE_SERVER_ARRIVE,
+	ICNSS_PHASE_QMI_CONNECTED,
+	ICNSS_PHASE_CAP_DONE,
+	ICNSS_PHASE_CAL_REPORTED,
+	ICNSS_PHASE_FW_READY,
+	ICNSS_PHASE_DRIVER_PROBED,
+	ICNSS_PHASE_MAX,
+};
+
+static const char * const icnss_phase_name[ICNSS_PHASE_MAX] = {
+	[ICNSS_PHASE_SERVER_ARRIVE] = "server_arrive",
+	[ICNSS_PHASE_QMI_CONNECTED] = "qmi_connected",
+	[ICNSS_PHASE_CAP_DONE] = "cap_done",
+	[ICNSS_PHASE_CAL_REPORTED] = "cal_reported",
+	[ICNSS_PHASE_FW_READY] = "fw_ready",
+	[ICNSS_PHASE_DRIVER_PROBED] = "driver_probed",
 };
 
 struct icnss_qmi_event {
@@ -43,6 +68,7 @@ struct icnss_qmi_event {
 #define WLFW_SERVICE_INS_ID_V01		0
 #define ICNSS_WLFW_QMI_CONNECTED	BIT(0)
 #define ICNSS_FW_READY			BIT(1)
+#define ICNSS_MAX_CAL_SIZE		(256 * 1024)
 
 #define ICNSS_IS_WLFW_QMI_CONNECTED(_state) \
 		((_state) & ICNSS_WLFW_QMI_CONNECTED)
@@ -71,6 +97,21 @@ struct ce_irq_list {
 	irqreturn_t (*handler)(int, void *);
 };
 
+/*
+ * Calibration data uploaded by the firmware. It lives in penv, so it
+ * survives firmware recovery and is handed back on the next bring-up
+ * instead of making the firmware calibrate again.
+ */
+struct icnss_cal_data {
+	bool valid;
+	u32 size;
+	u8 *data;
+	u32 update_count;
+	u32 download_count;
+	s64 update_us;
+	s64 download_us;
+};
+
 static struct {
 	struct platform_device *pdev;
 	struct icnss_driver_ops *ops;
@@ -89,8 +130,25 @@ static struct {
 	u32 num_peers;
 	u32 mac_version;
 	char fw_version[QMI_WLFW_MAX_STR_LEN_V01 + 1];
+	struct icnss_cal_data cal[QMI_WLFW_MAX_NUM_CAL_V01];
+	struct mutex driver_lock;
+	struct work_struct driver_probe_work;
+	bool driver_probed;
+	ktime_t phase_ts[ICNSS_PHASE_MAX];
+	u32 server_arrive_count;
+	struct dentry *debugfs_dir;
 } *penv;
 
+static void icnss_phase_mark(enum icnss_phase phase)
+{
+	int i;
+
+	if (phase == ICNSS_PHASE_SERVER_ARRIVE)
+		for (i = 0; i < ICNSS_PHASE_MAX; i++)
+			penv->phase_ts[i] = ktime_set(0, 0);
+	penv->phase_ts[phase] = ktime_get();
+}
+
 static int icnss_qmi_event_post(enum icnss_qmi_event_type type, void *data)
 {
 	struct icnss_qmi_event *event = NULL;
@@ -132,6 +190,10 @@ static int wlfw_ind_register_send_sync_msg(void)
 
 	req.fw_ready_enable_valid = 1;
 	req.fw_ready_enable = 1;
+	req.initiate_cal_download_enable_valid = 1;
+	req.initiate_cal_download_enable = 1;
+	req.initiate_cal_update_enable_valid = 1;
+	req.initiate_cal_update_enable = 1;
 
 	req_desc.max_msg_len = WLFW_IND_REGISTER_REQ_MSG_V01_MAX_MSG_LEN;
 	req_desc.msg_id = QMI_WLFW_IND_REGISTER_REQ_V01;
@@ -300,6 +362,215 @@ out:
 	return ret;
 }
 
+static int wlfw_cal_report_req(void)
+{
+	int ret;
+	int i;
+	struct wlfw_cal_report_req_msg_v01 req;
+	struct wlfw_cal_report_resp_msg_v01 resp;
+	struct msg_desc req_desc, resp_desc;
+
+	if (!penv || !penv->wlfw_clnt)
+		return -ENODEV;
+
+	memset(&req, 0, sizeof(req));
+	memset(&resp, 0, sizeof(resp));
+
+	for (i = 0; i < QMI_WLFW_MAX_NUM_CAL_V01; i++)
+		if (penv->cal[i].valid)
+			req.meta_data[req.meta_data_len++] = i;
+
+	req_desc.max_msg_len = WLFW_CAL_REPORT_REQ_MSG_V01_MAX_MSG_LEN;
+	req_desc.msg_id = QMI_WLFW_CAL_REPORT_REQ_V01;
+	req_desc.ei_array = wlfw_cal_report_req_msg_v01_ei;
+
+	resp_desc.max_msg_len = WLFW_CAL_REPORT_RESP_MSG_V01_MAX_MSG_LEN;
+	resp_desc.msg_id = QMI_WLFW_CAL_REPORT_RESP_V01;
+	resp_desc.ei_array = wlfw_cal_report_resp_msg_v01_ei;
+
+	ret = qmi_send_req_wait(penv->wlfw_clnt, &req_desc, &req, sizeof(req),
+				&resp_desc, &resp, sizeof(resp),
+				WLFW_TIMEOUT_MS);
+	if (ret < 0) {
+		pr_err("%s: send req failed %d\n", __func__, ret);
+		goto out;
+	}
+
+	if (resp.resp.result != QMI_RESULT_SUCCESS_V01) {
+		pr_err("%s: QMI request failed %d %d\n",
+		       __func__, resp.resp.result, resp.resp.error);
+		ret = resp.resp.result;
+		goto out;
+	}
+	pr_debug("%s: reported %u cached cal entries\n", __func__,
+		 req.meta_data_len);
+out:
+	return ret;
+}
+
+/* Pull calibration data generated by the firmware into the cache. */
+static int wlfw_cal_update_req(u32 cal_id, u32 total_size)
+{
+	int ret;
+	u32 seg_id = 0;
+	u32 offset = 0;
+	u8 *buf;
+	ktime_t start = ktime_get();
+	struct wlfw_cal_update_req_msg_v01 req;
+	struct wlfw_cal_update_resp_msg_v01 *resp;
+	struct msg_desc req_desc, resp_desc;
+	struct icnss_cal_data *cal;
+
+	if (!penv || !penv->wlfw_clnt)
+		return -ENODEV;
+
+	if (cal_id >= QMI_WLFW_MAX_NUM_CAL_V01 || !total_size ||
+	    total_size > ICNSS_MAX_CAL_SIZE) {
+		pr_err("%s: Invalid cal id %u size %u\n", __func__,
+		       cal_id, total_size);
+		return -EINVAL;
+	}
+
+	buf = kzalloc(total_size, GFP_KERNEL);
+	resp = kzalloc(sizeof(*resp), GFP_KERNEL);
+	if (!buf || !resp) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	req_desc.max_msg_len = WLFW_CAL_UPDATE_REQ_MSG_V01_MAX_MSG_LEN;
+	req_desc.msg_id = QMI_WLFW_CAL_UPDATE_REQ_V01;
+	req_desc.ei_array = wlfw_cal_update_req_msg_v01_ei;
+
+	resp_desc.max_msg_len = WLFW_CAL_UPDATE_RESP_MSG_V01_MAX_MSG_LEN;
+	resp_desc.msg_id = QMI_WLFW_CAL_UPDATE_RESP_V01;
+	resp_desc.ei_array = wlfw_cal_update_resp_msg_v01_ei;
+
+	do {
+		memset(&req, 0, sizeof(req));
+		memset(resp, 0, sizeof(*resp));
+		req.cal_id = cal_id;
+		req.seg_id = seg_id++;
+
+		ret = qmi_send_req_wait(penv->wlfw_clnt, &req_desc, &req,
+					sizeof(req), &resp_desc, resp,
+					sizeof(*resp), WLFW_TIMEOUT_MS);
+		if (ret < 0) {
+			pr_err("%s: send req failed %d\n", __func__, ret);
+			goto out;
+		}
+
+		if (resp->resp.result != QMI_RESULT_SUCCESS_V01) {
+			pr_err("%s: QMI request failed %d %d\n",
+			       __func__, resp->resp.result, resp->resp.error);
+			ret = resp->resp.result;
+			goto out;
+		}
+
+		if (!resp->data_valid)
+			break;
+		if (resp->data_len > QMI_WLFW_MAX_DATA_SIZE_V01 ||
+		    resp->data_len > total_size - offset) {
+			pr_err("%s: cal %u segment overflows %u bytes\n",
+			       __func__, cal_id, total_size);
+			ret = -EINVAL;
+			goto out;
+		}
+		memcpy(buf + offset, resp->data, resp->data_len);
+		offset += resp->data_len;
+	} while (!(resp->end_valid && resp->end) && offset < total_size);
+
+	cal = &penv->cal[cal_id];
+	kfree(cal->data);
+	cal->data = buf;
+	cal->size = offset;
+	cal->valid = offset != 0;
+	cal->update_count++;
+	cal->update_us = ktime_us_delta(ktime_get(), start);
+	buf = NULL;
+	pr_debug("%s: cached cal %u, %u bytes\n", __func__, cal_id, offset);
+out:
+	kfree(resp);
+	kfree(buf);
+	return ret;
+}
+
+/* Push cached calibration data back to the firmware. */
+static int wlfw_cal_download_req(u32 cal_id)
+{
+	int ret = 0;
+	u32 seg_id = 0;
+	u32 offset = 0;
+	ktime_t start = ktime_get();
+	struct wlfw_cal_download_req_msg_v01 *req;
+	struct wlfw_cal_download_resp_msg_v01 resp;
+	struct msg_desc req_desc, resp_desc;
+	struct icnss_cal_data *cal;
+
+	if (!penv || !penv->wlfw_clnt)
+		return -ENODEV;
+
+	if (cal_id >= QMI_WLFW_MAX_NUM_CAL_V01 || !penv->cal[cal_id].valid) {
+		pr_debug("%s: No cached cal data for id %u\n", __func__,
+			 cal_id);
+		return -ENOENT;
+	}
+	cal = &penv->cal[cal_id];
+
+	req = kzalloc(sizeof(*req), GFP_KERNEL);
+	if (!req)
+		return -ENOMEM;
+
+	req_desc.max_msg_len = WLFW_CAL_DOWNLOAD_REQ_MSG_V01_MAX_MSG_LEN;
+	req_desc.msg_id = QMI_WLFW_CAL_DOWNLOAD_REQ_V01;
+	req_desc.ei_array = wlfw_cal_download_req_msg_v01_ei;
+
+	resp_desc.max_msg_len = WLFW_CAL_DOWNLOAD_RESP_MSG_V01_MAX_MSG_LEN;
+	resp_desc.msg_id = QMI_WLFW_CAL_DOWNLOAD_RESP_V01;
+	resp_desc.ei_array = wlfw_cal_download_resp_msg_v01_ei;
+
+	while (offset < cal->size) {
+		memset(req, 0, sizeof(*req));
+		memset(&resp, 0, sizeof(resp));
+
+		req->valid = 1;
+		req->file_id_valid = 1;
+		req->file_id = cal_id;
+		req->total_size_valid = 1;
+		req->total_size = cal->size;
+		req->seg_id_valid = 1;
+		req->seg_id = seg_id++;
+		req->data_valid = 1;
+		req->data_len = min_t(u32, cal->size - offset,
+				      QMI_WLFW_MAX_DATA_SIZE_V01);
+		memcpy(req->data, cal->data + offset, req->data_len);
+		offset += req->data_len;
+		req->end_valid = 1;
+		req->end = offset >= cal->size;
+
+		ret = qmi_send_req_wait(penv->wlfw_clnt, &req_desc, req,
+					sizeof(*req), &resp_desc, &resp,
+					sizeof(resp), WLFW_TIMEOUT_MS);
+		if (ret < 0) {
+			pr_err("%s: send req failed %d\n", __func__, ret);
+			goto out;
+		}
+
+		if (resp.resp.result != QMI_RESULT_SUCCESS_V01) {
+			pr_err("%s: QMI request failed %d %d\n",
+			       __func__, resp.resp.result, resp.resp.error);
+			ret = resp.resp.result;
+			goto out;
+		}
+	}
+
+	cal->download_count++;
+	cal->download_us = ktime_us_delta(ktime_get(), start);
+out:
+	kfree(req);
+	return ret;
+}
+
 static void icnss_qmi_wlfw_clnt_notify_work(struct work_struct *work)
 {
 	int ret;
@@ -331,6 +602,35 @@ static void icnss_qmi_wlfw_clnt_notify(struct qmi_handle *handle,
 	}
 }
 
+/*
+ * Indications arrive from the QMI receive work, which also has to deliver
+ * the responses to any request we send, so their payload is decoded here
+ * and handled later from the event work.
+ */
+static void icnss_qmi_post_ind(enum icnss_qmi_event_type type,
+			       unsigned int msg_id, struct elem_info *ei,
+			       size_t size, void *msg, unsigned int msg_len)
+{
+	struct msg_desc ind_desc;
+	void *data;
+
+	data = kzalloc(size, GFP_ATOMIC);
+	if (!data)
+		return;
+
+	ind_desc.msg_id = msg_id;
+	ind_desc.max_msg_len = msg_len;
+	ind_desc.ei_array = ei;
+	if (qmi_kernel_decode(&ind_desc, data, msg, msg_len) < 0) {
+		pr_err("%s: Failed to decode ind 0x%x\n", __func__, msg_id);
+		kfree(data);
+		return;
+	}
+
+	if (icnss_qmi_event_post(type, data))
+		kfree(data);
+}
+
 static void icnss_qmi_wlfw_clnt_ind(struct qmi_handle *handle,
 			  unsigned int msg_id, void *msg,
 			  unsigned int msg_len, void *ind_cb_priv)
@@ -344,6 +644,18 @@ static void icnss_qmi_wlfw_clnt_ind(struct qmi_handle *handle,
 	case QMI_WLFW_FW_READY_IND_V01:
 		icnss_qmi_event_post(ICNSS_QMI_EVENT_FW_READY_IND, NULL);
 		break;
+	case QMI_WLFW_INITIATE_CAL_UPDATE_IND_V01:
+		icnss_qmi_post_ind(ICNSS_QMI_EVENT_CAL_UPDATE_IND, msg_id,
+			wlfw_initiate_cal_update_ind_msg_v01_ei,
+			sizeof(struct wlfw_initiate_cal_update_ind_msg_v01),
+			msg, msg_len);
+		break;
+	case QMI_WLFW_INITIATE_CAL_DOWNLOAD_IND_V01:
+		icnss_qmi_post_ind(ICNSS_QMI_EVENT_CAL_DOWNLOAD_IND, msg_id,
+			wlfw_initiate_cal_download_ind_msg_v01_ei,
+			sizeof(struct wlfw_initiate_cal_download_ind_msg_v01),
+			msg, msg_len);
+		break;
 	default:
 		pr_err("%s: Invalid msg_id 0x%x\n", __func__, msg_id);
 		break;
@@ -357,6 +669,9 @@ static int icnss_qmi_event_server_arrive(void *data)
 	if (!penv)
 		return -ENODEV;
 
+	icnss_phase_mark(ICNSS_PHASE_SERVER_ARRIVE);
+	penv->server_arrive_count++;
+
 	penv->wlfw_clnt = qmi_handle_create(icnss_qmi_wlfw_clnt_notify, penv);
 	if (!penv->wlfw_clnt) {
 		pr_err("%s: QMI client handle alloc failed\n", __func__);
@@ -382,6 +697,7 @@ static int icnss_qmi_event_server_arrive(void *data)
 	}
 
 	penv->state |= ICNSS_WLFW_QMI_CONNECTED;
+	icnss_phase_mark(ICNSS_PHASE_QMI_CONNECTED);
 
 	pr_info("%s: QMI Server Connected\n", __func__);
 
@@ -398,7 +714,12 @@ static int icnss_qmi_event_server_arrive(void *data)
 		       ret);
 		goto out;
 	}
-	return ret;
+	icnss_phase_mark(ICNSS_PHASE_CAP_DONE);
+
+	/* Not fatal: the firmware just calibrates from scratch */
+	if (!wlfw_cal_report_req())
+		icnss_phase_mark(ICNSS_PHASE_CAL_REPORTED);
+	return 0;
 fail:
 	qmi_handle_destroy(penv->wlfw_clnt);
 	penv->wlfw_clnt = NULL;
@@ -421,6 +742,40 @@ static int icnss_qmi_event_server_exit(void *data)
 	return 0;
 }
 
+/*
+ * Bring up the WLAN driver for a firmware that has become ready. After a
+ * firmware recovery an already probed driver is only reinitialised.
+ * Must be called with driver_lock held.
+ */
+static int icnss_call_driver_probe(void)
+{
+	int ret = 0;
+
+	if (!penv->ops || !ICNSS_IS_FW_READY(penv->state))
+		return 0;
+
+	if (penv->driver_probed && penv->ops->reinit)
+		ret = penv->ops->reinit(&penv->pdev->dev);
+	else if (penv->ops->probe)
+		ret = penv->ops->probe(&penv->pdev->dev);
+
+	if (ret < 0) {
+		pr_err("%s: Driver probe failed: %d\n", __func__, ret);
+		return ret;
+	}
+
+	penv->driver_probed = true;
+	icnss_phase_mark(ICNSS_PHASE_DRIVER_PROBED);
+	return ret;
+}
+
+static void icnss_driver_probe_work(struct work_struct *work)
+{
+	mutex_lock(&penv->driver_lock);
+	icnss_call_driver_probe();
+	mutex_unlock(&penv->driver_lock);
+}
+
 static int icnss_qmi_event_fw_ready_ind(void *data)
 {
 	int ret = 0;
@@ -429,6 +784,7 @@ static int icnss_qmi_event_fw_ready_ind(void *data)
 		return -ENODEV;
 
 	penv->state |= ICNSS_FW_READY;
+	icnss_phase_mark(ICNSS_PHASE_FW_READY);
 
 	if (!penv->pdev) {
 		pr_err("%s: Device is not ready\n", __func__);
@@ -441,13 +797,41 @@ static int icnss_qmi_event_fw_ready_ind(void *data)
 		goto out;
 	}
 
-	ret = penv->ops->probe(&penv->pdev->dev);
-	if (ret < 0)
-		pr_err("%s: Driver probe failed: %d\n", __func__, ret);
+	/*
+	 * Probe outside the event work so that indications the firmware
+	 * sends while the driver is coming up are not held behind it.
+	 */
+	schedule_work(&penv->driver_probe_work);
 out:
 	return ret;
 }
 
+static int icnss_qmi_event_cal_update_ind(void *data)
+{
+	struct wlfw_initiate_cal_update_ind_msg_v01 *ind = data;
+	int ret;
+
+	if (!penv || !ind)
+		return -ENODEV;
+
+	ret = wlfw_cal_update_req(ind->cal_id, ind->total_size);
+	kfree(ind);
+	return ret;
+}
+
+static int icnss_qmi_event_cal_download_ind(void *data)
+{
+	struct wlfw_initiate_cal_download_ind_msg_v01 *ind = data;
+	int ret;
+
+	if (!penv || !ind)
+		return -ENODEV;
+
+	ret = wlfw_cal_download_req(ind->cal_id);
+	kfree(ind);
+	return ret;
+}
+
 static int icnss_qmi_wlfw_clnt_svc_event_notify(struct notifier_block *this,
 					       unsigned long code,
 					       void *_cmd)
@@ -497,6 +881,12 @@ static void icnss_qmi_wlfw_event_work(struct work_struct *work)
 		case ICNSS_QMI_EVENT_FW_READY_IND:
 			icnss_qmi_event_fw_ready_ind(event->data);
 			break;
+		case ICNSS_QMI_EVENT_CAL_UPDATE_IND:
+			icnss_qmi_event_cal_update_ind(event->data);
+			break;
+		case ICNSS_QMI_EVENT_CAL_DOWNLOAD_IND:
+			icnss_qmi_event_cal_download_ind(event->data);
+			break;
 		default:
 			pr_debug("Invalid Event type: %d", event->type);
 			break;
@@ -532,11 +922,12 @@ int icnss_register_driver(struct icnss_driver_ops *ops)
 		ret = -EEXIST;
 		goto out;
 	}
+	mutex_lock(&penv->driver_lock);
 	penv->ops = ops;
 
 	/* check for all conditions before invoking probe */
-	if (ICNSS_IS_FW_READY(penv->state) && penv->ops->probe)
-		ret = penv->ops->probe(&pdev->dev);
+	ret = icnss_call_driver_probe();
+	mutex_unlock(&penv->driver_lock);
 
 out:
 	return ret;
@@ -563,10 +954,15 @@ int icnss_unregister_driver(struct icnss_driver_ops *ops)
 		ret = -ENOENT;
 		goto out;
 	}
+
+	flush_work(&penv->driver_probe_work);
+	mutex_lock(&penv->driver_lock);
 	if (penv->ops->remove)
 		penv->ops->remove(&pdev->dev);
 
 	penv->ops = NULL;
+	penv->driver_probed = false;
+	mutex_unlock(&penv->driver_lock);
 out:
 	return ret;
 }
@@ -832,6 +1228,62 @@ int icnss_get_ce_id(int irq)
 }
 EXPORT_SYMBOL(icnss_get_ce_id);
 
+static int icnss_stats_show(struct seq_file *s, void *data)
+{
+	ktime_t base;
+	int i;
+
+	seq_printf(s, "State: 0x%x\n", penv->state);
+	seq_printf(s, "Server arrivals: %u (recoveries %u)\n",
+		   penv->server_arrive_count,
+		   penv->server_arrive_count ?
+		   penv->server_arrive_count - 1 : 0);
+
+	seq_puts(s, "\nLast bring-up (usecs since server arrive):\n");
+	base = penv->phase_ts[ICNSS_PHASE_SERVER_ARRIVE];
+	for (i = 0; i < ICNSS_PHASE_MAX; i++) {
+		if (!ktime_to_ns(penv->phase_ts[i]))
+			seq_printf(s, "%-16s -\n", icnss_phase_name[i]);
+		else
+			seq_printf(s, "%-16s %lld\n", icnss_phase_name[i],
+				   ktime_us_delta(penv->phase_ts[i], base));
+	}
+
+	seq_puts(s, "\nCal  Valid  Size       Updates  Update us  Downloads  Download us\n");
+	for (i = 0; i < QMI_WLFW_MAX_NUM_CAL_V01; i++)
+		seq_printf(s, "%-4d %-6s %-10u %-8u %-10lld %-10u %lld\n",
+			   i, penv->cal[i].valid ? "yes" : "no",
+			   penv->cal[i].size, penv->cal[i].update_count,
+			   penv->cal[i].update_us,
+			   penv->cal[i].download_count,
+			   penv->cal[i].download_us);
+
+	return 0;
+}
+
+static int icnss_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, icnss_stats_show, inode->i_private);
+}
+
+static const struct file_operations icnss_stats_fops = {
+	.open = icnss_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void icnss_debugfs_create(void)
+{
+	penv->debugfs_dir = debugfs_create_dir("icnss", NULL);
+	if (IS_ERR_OR_NULL(penv->debugfs_dir)) {
+		penv->debugfs_dir = NULL;
+		return;
+	}
+	debugfs_create_file("stats", S_IRUSR, penv->debugfs_dir, NULL,
+			    &icnss_stats_fops);
+}
+
 static int icnss_probe(struct platform_device *pdev)
 {
 	int ret = 0;
@@ -881,7 +1333,9 @@ static int icnss_probe(struct platform_device *pdev)
 
 	INIT_WORK(&penv->qmi_event_work, icnss_qmi_wlfw_event_work);
 	INIT_WORK(&penv->qmi_recv_msg_work, icnss_qmi_wlfw_clnt_notify_work);
+	INIT_WORK(&penv->driver_probe_work, icnss_driver_probe_work);
 	INIT_LIST_HEAD(&penv->qmi_event_list);
+	mutex_init(&penv->driver_lock);
 
 	ret = qmi_svc_event_notifier_register(WLFW_SERVICE_ID_V01,
 					      WLFW_SERVICE_VERS_V01,
@@ -893,6 +1347,8 @@ static int icnss_probe(struct platform_device *pdev)
 		goto out;
 	}
 
+	icnss_debugfs_create();
+
 	pr_debug("icnss: Platform driver probed successfully\n");
 out:
 	return ret;
@@ -900,12 +1356,19 @@ out:
 
 static int icnss_remove(struct platform_device *pdev)
 {
+	int i;
+
+	debugfs_remove_recursive(penv->debugfs_dir);
 	qmi_svc_event_notifier_unregister(WLFW_SERVICE_ID_V01,
 					  WLFW_SERVICE_VERS_V01,
 					  WLFW_SERVICE_INS_ID_V01,
 					  &wlfw_clnt_nb);
 	if (penv->qmi_event_wq)
 		destroy_workqueue(penv->qmi_event_wq);
+	cancel_work_sync(&penv->driver_probe_work);
+
+	for (i = 0; i < QMI_WLFW_MAX_NUM_CAL_V01; i++)
+		kfree(penv->cal[i].data);
 
 	return 0;
 }
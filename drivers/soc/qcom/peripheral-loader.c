@@ -32,9 +32,12 @@
 #include <linux/of_address.h>
 #include <linux/io.h>
 #include <linux/dma-mapping.h>
+#include <linux/ktime.h>
+#include <linux/completion.h>
 #include <soc/qcom/ramdump.h>
 #include <soc/qcom/subsystem_restart.h>
 #include <soc/qcom/secure_buffer.h>
+#include <soc/qcom/boot_stats.h>
 
 #include <asm/uaccess.h>
 #include <asm/setup.h>
@@ -59,6 +62,10 @@ static void __iomem *pil_info_base;
 static int proxy_timeout_ms = -1;
 module_param(proxy_timeout_ms, int, S_IRUGO | S_IWUSR);
 
+/* Number of segments of an image read from the filesystem concurrently */
+#define PIL_LOAD_WORKERS	4
+static struct workqueue_struct *pil_load_wq;
+
 struct pil_mdt {
 	struct elf32_hdr hdr;
 	struct elf32_phdr phdr[];
@@ -71,6 +78,10 @@ struct pil_seg {
 	int num;
 	struct list_head list;
 	bool relocated;
+	struct pil_desc *desc;
+	struct work_struct load_work;
+	struct completion loaded;
+	int load_ret;
 };
 
 struct pil_priv {
@@ -550,6 +561,11 @@ static void unmap_fw_mem(void *vaddr, size_t size, void *data)
 	dma_unremap(info->dev, vaddr, size);
 }
 
+/*
+ * Reads a segment's blob into place and zero fills the rest of it. This
+ * does not depend on any other segment, so the segments of an image are
+ * loaded concurrently.
+ */
 static int pil_load_seg(struct pil_desc *desc, struct pil_seg *seg)
 {
 	int ret = 0, count;
@@ -605,10 +621,51 @@ static int pil_load_seg(struct pil_desc *desc, struct pil_seg *seg)
 		paddr += size;
 	}
 
-	if (desc->ops->verify_blob) {
-		ret = desc->ops->verify_blob(desc, seg->paddr, seg->sz);
+	return ret;
+}
+
+static void pil_load_seg_work(struct work_struct *work)
+{
+	struct pil_seg *seg = container_of(work, struct pil_seg, load_work);
+
+	seg->load_ret = pil_load_seg(seg->desc, seg);
+	complete(&seg->loaded);
+}
+
+/*
+ * Loads all segments of an image. verify_blob() may have to see the
+ * segments in order (the MBA accumulates the image length as they come
+ * in), so each segment is verified in list order as soon as it and its
+ * predecessors are loaded, while the later ones are still being read.
+ */
+static int pil_load_segs(struct pil_desc *desc)
+{
+	struct pil_seg *seg;
+	int ret = 0;
+
+	list_for_each_entry(seg, &desc->priv->segs, list) {
+		seg->desc = desc;
+		init_completion(&seg->loaded);
+		INIT_WORK(&seg->load_work, pil_load_seg_work);
+		if (pil_load_wq)
+			queue_work(pil_load_wq, &seg->load_work);
+		else
+			pil_load_seg_work(&seg->load_work);
+	}
+
+	/* wait for every worker, even after a failure, before returning */
+	list_for_each_entry(seg, &desc->priv->segs, list) {
+		wait_for_completion(&seg->loaded);
 		if (ret)
-			pil_err(desc, "Blob%u failed verification\n", num);
+			continue;
+
+		ret = seg->load_ret;
+		if (!ret && desc->ops->verify_blob) {
+			ret = desc->ops->verify_blob(desc, seg->paddr, seg->sz);
+			if (ret)
+				pil_err(desc, "Blob%u failed verification\n",
+					seg->num);
+		}
 	}
 
 	return ret;
@@ -660,11 +717,11 @@ int pil_boot(struct pil_desc *desc)
 	char fw_name[30];
 	const struct pil_mdt *mdt;
 	const struct elf32_hdr *ehdr;
-	struct pil_seg *seg;
 	const struct firmware *fw;
 	struct pil_priv *priv = desc->priv;
 	bool mem_protect = false;
 	bool hyp_assign = false;
+	ktime_t start, load_start, auth_start;
 
 	if (desc->shutdown_fail)
 		pil_err(desc, "Subsystem shutdown failed previously!\n");
@@ -673,6 +730,7 @@ int pil_boot(struct pil_desc *desc)
 	pil_release_mmap(desc);
 
 	down_read(&pil_pm_rwsem);
+	start = ktime_get();
 	snprintf(fw_name, sizeof(fw_name), "%s.mdt", desc->fw_name);
 	ret = request_firmware(&fw, fw_name, desc->dev);
 	if (ret) {
@@ -751,11 +809,10 @@ int pil_boot(struct pil_desc *desc)
 		hyp_assign = true;
 	}
 
-	list_for_each_entry(seg, &desc->priv->segs, list) {
-		ret = pil_load_seg(desc, seg);
-		if (ret)
-			goto err_deinit_image;
-	}
+	load_start = ktime_get();
+	ret = pil_load_segs(desc);
+	if (ret)
+		goto err_deinit_image;
 
 	if (desc->subsys_vmid > 0) {
 		ret =  pil_reclaim_mem(desc, priv->region_start,
@@ -769,12 +826,18 @@ int pil_boot(struct pil_desc *desc)
 		hyp_assign = false;
 	}
 
+	auth_start = ktime_get();
 	ret = desc->ops->auth_and_reset(desc);
 	if (ret) {
 		pil_err(desc, "Failed to bring out of reset\n");
 		goto err_auth_and_reset;
 	}
 	pil_info(desc, "Brought out of reset\n");
+	pil_info(desc, "KPI: init %lld ms, load %lld ms, auth %lld ms\n",
+		 ktime_to_ms(ktime_sub(load_start, start)),
+		 ktime_to_ms(ktime_sub(auth_start, load_start)),
+		 ktime_to_ms(ktime_sub(ktime_get(), auth_start)));
+	boot_stats_event(start, "pil_%s", desc->name);
 err_auth_and_reset:
 	if (ret && desc->subsys_vmid > 0) {
 		pil_assign_mem_to_linux(desc, priv->region_start,
@@ -981,6 +1044,11 @@ static int __init msm_pil_init(void)
 		writel_relaxed(0, pil_info_base + (i * sizeof(u32)));
 
 out:
+	pil_load_wq = alloc_workqueue("pil_load", WQ_UNBOUND,
+				      PIL_LOAD_WORKERS);
+	if (!pil_load_wq)
+		pr_warn("pil: segments will be loaded sequentially\n");
+
 	return register_pm_notifier(&pil_pm_notifier);
 }
 device_initcall(msm_pil_init);
@@ -988,6 +1056,8 @@ device_initcall(msm_pil_init);
 static void __exit msm_pil_exit(void)
 {
 	unregister_pm_notifier(&pil_pm_notifier);
+	if (pil_load_wq)
+		destroy_workqueue(pil_load_wq);
 	if (pil_info_base)
 		iounmap(pil_info_base);
 }
@@ -1215,6 +1215,7 @@ static struct platform_driver qbt1000_plat_driver = {
 	.driver = {
 		.name = "qbt1000",
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		.of_match_table = qbt1000_match,
 	},
 };
@@ -65,6 +65,8 @@ struct qmi_notify_event_work {
 	struct work_struct work;
 };
 static void qmi_notify_event_worker(struct work_struct *work);
+static void qmi_rx_notify_worker(struct work_struct *work);
+static void qmi_txn_timeout_worker(struct work_struct *work);
 
 #define HANDLE_HASH_TBL_SZ 1
 static DEFINE_HASHTABLE(handle_hash_tbl, HANDLE_HASH_TBL_SZ);
@@ -300,6 +302,24 @@ static void qmi_event_notify(unsigned event, void *oob_data,
 	struct qmi_handle *handle;
 	uint32_t key = 0;
 
+	/*
+	 * Data notifications are coalesced on the handle's own work item,
+	 * so a burst of messages is drained by a single QMI_RECV_MSG.
+	 */
+	if (event == IPC_ROUTER_CTRL_CMD_DATA) {
+		mutex_lock(&handle_hash_tbl_lock);
+		hash_for_each_possible(handle_hash_tbl, handle, handle_hash,
+				       key) {
+			if (handle == (struct qmi_handle *)priv) {
+				queue_work(handle->handle_wq,
+					   &handle->rx_notify_work);
+				break;
+			}
+		}
+		mutex_unlock(&handle_hash_tbl_lock);
+		return;
+	}
+
 	notify_work = kmalloc(sizeof(struct qmi_notify_event_work),
 			      GFP_KERNEL);
 	if (!notify_work) {
@@ -343,7 +363,6 @@ static void qmi_notify_event_worker(struct work_struct *work)
 	struct qmi_notify_event_work *notify_work =
 		container_of(work, struct qmi_notify_event_work, work);
 	struct qmi_handle *handle = (struct qmi_handle *)notify_work->priv;
-	unsigned long flags;
 
 	if (!handle)
 		return;
@@ -357,12 +376,6 @@ static void qmi_notify_event_worker(struct work_struct *work)
 	}
 
 	switch (notify_work->event) {
-	case IPC_ROUTER_CTRL_CMD_DATA:
-		spin_lock_irqsave(&handle->notify_lock, flags);
-		handle->notify(handle, QMI_RECV_MSG, handle->notify_priv);
-		spin_unlock_irqrestore(&handle->notify_lock, flags);
-		break;
-
 	case IPC_ROUTER_CTRL_CMD_RESUME_TX:
 		if (handle->handle_type == QMI_CLIENT_HANDLE) {
 			queue_delayed_work(handle->handle_wq,
@@ -400,6 +413,21 @@ static void qmi_notify_event_worker(struct work_struct *work)
 	kfree(notify_work);
 }
 
+static void qmi_rx_notify_worker(struct work_struct *work)
+{
+	struct qmi_handle *handle =
+		container_of(work, struct qmi_handle, rx_notify_work);
+	unsigned long flags;
+
+	mutex_lock(&handle->handle_lock);
+	if (!handle->handle_reset) {
+		spin_lock_irqsave(&handle->notify_lock, flags);
+		handle->notify(handle, QMI_RECV_MSG, handle->notify_priv);
+		spin_unlock_irqrestore(&handle->notify_lock, flags);
+	}
+	mutex_unlock(&handle->handle_lock);
+}
+
 static void clnt_resume_tx_worker(struct work_struct *work)
 {
 	struct delayed_work *rtx_work = to_delayed_work(work);
@@ -601,6 +629,9 @@ struct qmi_handle *qmi_handle_create(
 	init_waitqueue_head(&temp_handle->reset_waitq);
 	INIT_DELAYED_WORK(&temp_handle->resume_tx_work, clnt_resume_tx_worker);
 	INIT_DELAYED_WORK(&temp_handle->ctl_work, handle_ctl_msg);
+	INIT_WORK(&temp_handle->rx_notify_work, qmi_rx_notify_worker);
+	INIT_DELAYED_WORK(&temp_handle->txn_timeout_work,
+			  qmi_txn_timeout_worker);
 
 	
 	INIT_LIST_HEAD(&temp_handle->txn_list);
@@ -665,6 +696,12 @@ static void clean_txn_info(struct qmi_handle *handle)
 				 &handle->txn_list, list) {
 		if (txn_handle->type == QMI_ASYNC_TXN) {
 			list_del(&txn_handle->list);
+			if (txn_handle->resp_cb)
+				txn_handle->resp_cb(txn_handle->handle,
+					txn_handle->resp_desc->msg_id,
+					txn_handle->resp,
+					txn_handle->resp_cb_data,
+					-ENETRESET);
 			kfree(txn_handle);
 		} else if (txn_handle->type == QMI_SYNC_TXN) {
 			wake_up(&txn_handle->wait_q);
@@ -689,6 +726,7 @@ int qmi_handle_destroy(struct qmi_handle *handle)
 	msm_ipc_router_close_port((struct msm_ipc_port *)(handle->ctl_port));
 	msm_ipc_router_close_port((struct msm_ipc_port *)(handle->src_port));
 	mutex_unlock(&handle->handle_lock);
+	cancel_delayed_work_sync(&handle->txn_timeout_work);
 	flush_workqueue(handle->handle_wq);
 	destroy_workqueue(handle->handle_wq);
 
@@ -731,6 +769,76 @@ int qmi_register_ind_cb(struct qmi_handle *handle,
 }
 EXPORT_SYMBOL(qmi_register_ind_cb);
 
+/* Must be called with handle_lock locked. */
+static void qmi_arm_txn_timeout(struct qmi_handle *handle,
+				unsigned long expires)
+{
+	if (delayed_work_pending(&handle->txn_timeout_work) &&
+	    !time_before(expires, handle->txn_timeout))
+		return;
+
+	handle->txn_timeout = expires;
+	mod_delayed_work(handle->handle_wq, &handle->txn_timeout_work,
+			 time_after(expires, jiffies) ? expires - jiffies : 0);
+}
+
+/*
+ * Must be called with handle_lock locked. Fails the asynchronous
+ * transactions on @txn_list whose response is overdue and returns the
+ * earliest expiry left, or 0 if there is none.
+ */
+static unsigned long qmi_expire_txns(struct qmi_handle *handle,
+				     struct list_head *txn_list,
+				     bool pending)
+{
+	struct qmi_txn *txn_handle, *temp_txn_handle;
+	unsigned long next = 0;
+
+	list_for_each_entry_safe(txn_handle, temp_txn_handle, txn_list, list) {
+		if (txn_handle->type != QMI_ASYNC_TXN || !txn_handle->expires)
+			continue;
+		if (time_before(jiffies, txn_handle->expires)) {
+			if (!next || time_before(txn_handle->expires, next))
+				next = txn_handle->expires;
+			continue;
+		}
+		pr_err("%s: Response timeout for txn_id %d\n",
+			__func__, txn_handle->txn_id);
+		list_del(&txn_handle->list);
+		if (txn_handle->resp_cb)
+			txn_handle->resp_cb(txn_handle->handle,
+					    txn_handle->resp_desc->msg_id,
+					    txn_handle->resp,
+					    txn_handle->resp_cb_data,
+					    -ETIMEDOUT);
+		if (pending)
+			kfree(txn_handle->enc_data);
+		kfree(txn_handle);
+	}
+	return next;
+}
+
+static void qmi_txn_timeout_worker(struct work_struct *work)
+{
+	struct delayed_work *to_work = to_delayed_work(work);
+	struct qmi_handle *handle =
+		container_of(to_work, struct qmi_handle, txn_timeout_work);
+	unsigned long next, pend_next;
+
+	mutex_lock(&handle->handle_lock);
+	if (handle->handle_reset)
+		goto out_txn_timeout;
+
+	next = qmi_expire_txns(handle, &handle->txn_list, false);
+	pend_next = qmi_expire_txns(handle, &handle->pending_txn_list, true);
+	if (!next || (pend_next && time_before(pend_next, next)))
+		next = pend_next;
+	if (next)
+		qmi_arm_txn_timeout(handle, next);
+out_txn_timeout:
+	mutex_unlock(&handle->handle_lock);
+}
+
 static int qmi_encode_and_send_req(struct qmi_txn **ret_txn_handle,
 	struct qmi_handle *handle, enum txn_type type,
 	struct msg_desc *req_desc, void *req, unsigned int req_len,
@@ -738,7 +846,7 @@ static int qmi_encode_and_send_req(struct qmi_txn **ret_txn_handle,
 	void (*resp_cb)(struct qmi_handle *handle,
 			unsigned int msg_id, void *msg,
 			void *resp_cb_data, int stat),
-	void *resp_cb_data)
+	void *resp_cb_data, unsigned long timeout_ms)
 {
 	struct qmi_txn *txn_handle;
 	int rc, encoded_req_len;
@@ -778,6 +886,9 @@ static int qmi_encode_and_send_req(struct qmi_txn **ret_txn_handle,
 	txn_handle->resp_cb_data = resp_cb_data;
 	txn_handle->enc_data = NULL;
 	txn_handle->enc_data_len = 0;
+	if (type == QMI_ASYNC_TXN && timeout_ms)
+		txn_handle->expires =
+			(jiffies + msecs_to_jiffies(timeout_ms)) ?: 1;
 
 	
 	encoded_req_len = req_desc->max_msg_len + QMI_HEADER_SIZE;
@@ -824,6 +935,8 @@ append_pend_txn:
 		if (list_empty(&handle->pending_txn_list))
 			list_del(&txn_handle->list);
 		list_add_tail(&txn_handle->list, &handle->pending_txn_list);
+		if (txn_handle->expires)
+			qmi_arm_txn_timeout(handle, txn_handle->expires);
 		if (ret_txn_handle)
 			*ret_txn_handle = txn_handle;
 		mutex_unlock(&handle->handle_lock);
@@ -833,6 +946,8 @@ append_pend_txn:
 		pr_err("%s: send_msg failed %d\n", __func__, rc);
 		goto encode_and_send_req_err3;
 	}
+	if (txn_handle->expires)
+		qmi_arm_txn_timeout(handle, txn_handle->expires);
 	mutex_unlock(&handle->handle_lock);
 
 	kfree(encoded_req);
@@ -864,7 +979,7 @@ int qmi_send_req_wait(struct qmi_handle *handle,
 	rc = qmi_encode_and_send_req(&txn_handle, handle, QMI_SYNC_TXN,
 				     req_desc, req, req_len,
 				     resp_desc, resp, resp_len,
-				     NULL, NULL);
+				     NULL, NULL, 0);
 	if (rc < 0) {
 		pr_err("%s: Error encode & send req: %d\n", __func__, rc);
 		return rc;
@@ -921,10 +1036,28 @@ int qmi_send_req_nowait(struct qmi_handle *handle,
 	return qmi_encode_and_send_req(NULL, handle, QMI_ASYNC_TXN,
 				       req_desc, req, req_len,
 				       resp_desc, resp, resp_len,
-				       resp_cb, resp_cb_data);
+				       resp_cb, resp_cb_data, 0);
 }
 EXPORT_SYMBOL(qmi_send_req_nowait);
 
+int qmi_send_req_nowait_timeout(struct qmi_handle *handle,
+			struct msg_desc *req_desc,
+			void *req, unsigned int req_len,
+			struct msg_desc *resp_desc,
+			void *resp, unsigned int resp_len,
+			void (*resp_cb)(struct qmi_handle *handle,
+					unsigned int msg_id, void *msg,
+					void *resp_cb_data, int stat),
+			void *resp_cb_data,
+			unsigned long timeout_ms)
+{
+	return qmi_encode_and_send_req(NULL, handle, QMI_ASYNC_TXN,
+				       req_desc, req, req_len,
+				       resp_desc, resp, resp_len,
+				       resp_cb, resp_cb_data, timeout_ms);
+}
+EXPORT_SYMBOL(qmi_send_req_nowait_timeout);
+
 static int qmi_encode_and_send_resp(struct qmi_handle *handle,
 	struct qmi_svc_clnt_conn *conn_h, struct req_handle *req_h,
 	struct msg_desc *resp_desc, void *resp, unsigned int resp_len)
@@ -1352,6 +1485,11 @@ static int handle_qmi_response(struct qmi_handle *handle,
 		wake_up(&txn_handle->wait_q);
 		if (txn_handle->type == QMI_ASYNC_TXN) {
 			list_del(&txn_handle->list);
+			if (txn_handle->resp_cb)
+				txn_handle->resp_cb(txn_handle->handle, msg_id,
+						    txn_handle->resp,
+						    txn_handle->resp_cb_data,
+						    rc);
 			kfree(txn_handle);
 		}
 		return rc;
@@ -1391,7 +1529,8 @@ static int handle_qmi_indication(struct qmi_handle *handle, void *msg,
 	return 0;
 }
 
-int qmi_recv_msg(struct qmi_handle *handle)
+/* Must be called with handle_lock locked. */
+static int __qmi_recv_msg(struct qmi_handle *handle)
 {
 	unsigned int recv_msg_len;
 	unsigned char *recv_msg = NULL;
@@ -1400,30 +1539,19 @@ int qmi_recv_msg(struct qmi_handle *handle)
 	uint16_t txn_id, msg_id, msg_len;
 	int rc;
 
-	if (!handle)
-		return -EINVAL;
-
-	mutex_lock(&handle->handle_lock);
-	if (handle->handle_reset) {
-		mutex_unlock(&handle->handle_lock);
+	if (handle->handle_reset)
 		return -ENETRESET;
-	}
 
-	
 	rc = msm_ipc_router_read_msg((struct msm_ipc_port *)(handle->src_port),
 				     &src_addr, &recv_msg, &recv_msg_len);
-	if (rc == -ENOMSG) {
-		mutex_unlock(&handle->handle_lock);
+	if (rc == -ENOMSG)
 		return rc;
-	}
 
 	if (rc < 0) {
 		pr_err("%s: Read failed %d\n", __func__, rc);
-		mutex_unlock(&handle->handle_lock);
 		return rc;
 	}
 
-	
 	decode_qmi_header(recv_msg, &cntl_flag, &txn_id, &msg_id, &msg_len);
 
 	qmi_log(handle, cntl_flag, txn_id, msg_id, msg_len);
@@ -1449,11 +1577,48 @@ int qmi_recv_msg(struct qmi_handle *handle)
 		break;
 	}
 	kfree(recv_msg);
+	return rc;
+}
+
+int qmi_recv_msg(struct qmi_handle *handle)
+{
+	int rc;
+
+	if (!handle)
+		return -EINVAL;
+
+	mutex_lock(&handle->handle_lock);
+	rc = __qmi_recv_msg(handle);
 	mutex_unlock(&handle->handle_lock);
 	return rc;
 }
 EXPORT_SYMBOL(qmi_recv_msg);
 
+int qmi_recv_msgs(struct qmi_handle *handle, unsigned int budget)
+{
+	int count = 0;
+	int rc;
+
+	if (!handle)
+		return -EINVAL;
+
+	mutex_lock(&handle->handle_lock);
+	while (!budget || count < budget) {
+		rc = __qmi_recv_msg(handle);
+		if (rc == -ENOMSG)
+			break;
+		if (rc == -ENETRESET) {
+			mutex_unlock(&handle->handle_lock);
+			return rc;
+		}
+		/* a message that failed to decode is still consumed */
+		count++;
+	}
+	mutex_unlock(&handle->handle_lock);
+	return count;
+}
+EXPORT_SYMBOL(qmi_recv_msgs);
+
 int qmi_connect_to_service(struct qmi_handle *handle,
 			   uint32_t service_id,
 			   uint32_t service_vers,
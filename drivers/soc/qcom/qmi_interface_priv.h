@@ -49,6 +49,7 @@ struct qmi_txn {
 	unsigned int resp_len;
 	int resp_received;
 	int send_stat;
+	unsigned long expires;
 	void (*resp_cb)(struct qmi_handle *handle, unsigned int msg_id,
 			void *msg, void *resp_cb_data, int stat);
 	void *resp_cb_data;
@@ -24,11 +24,20 @@
 #include <linux/uaccess.h>
 #include <linux/elf.h>
 #include <linux/wait.h>
+#include <linux/vmalloc.h>
+#include <linux/mutex.h>
 #include <soc/qcom/ramdump.h>
 #include <linux/dma-mapping.h>
 
 #define RAMDUMP_WAIT_MSECS	120000
 
+/*
+ * Dumps up to this many MB are copied into a staging buffer so that the
+ * subsystem can be restarted without waiting for userspace to read them.
+ */
+static unsigned int staging_max_mb;
+module_param(staging_max_mb, uint, S_IRUGO | S_IWUSR);
+
 struct ramdump_device {
 	char name[256];
 
@@ -45,8 +54,24 @@ struct ramdump_device {
 	size_t elfcore_size;
 	char *elfcore_buf;
 	struct dma_attrs attrs;
+
+	struct mutex staging_lock;
+	void *staging_buf;
+	size_t staging_size;
 };
 
+/* Must be called with staging_lock locked. */
+static void ramdump_free_staged(struct ramdump_device *rd_dev)
+{
+	vfree(rd_dev->staging_buf);
+	rd_dev->staging_buf = NULL;
+	rd_dev->staging_size = 0;
+	kfree(rd_dev->elfcore_buf);
+	rd_dev->elfcore_buf = NULL;
+	rd_dev->elfcore_size = 0;
+	rd_dev->data_ready = 0;
+}
+
 static int ramdump_open(struct inode *inode, struct file *filep)
 {
 	struct ramdump_device *rd_dev = container_of(filep->private_data,
@@ -61,7 +86,11 @@ static int ramdump_release(struct inode *inode, struct file *filep)
 	struct ramdump_device *rd_dev = container_of(filep->private_data,
 				struct ramdump_device, device);
 	rd_dev->consumer_present = 0;
+	mutex_lock(&rd_dev->staging_lock);
+	if (rd_dev->staging_buf)
+		ramdump_free_staged(rd_dev);
 	rd_dev->data_ready = 0;
+	mutex_unlock(&rd_dev->staging_lock);
 	complete(&rd_dev->ramdump_complete);
 	return 0;
 }
@@ -100,6 +129,45 @@ static unsigned long offset_translate(loff_t user_offset,
 
 #define MAX_IOREMAP_SIZE SZ_1M
 
+/* Must be called with staging_lock locked. */
+static ssize_t ramdump_read_staged(struct ramdump_device *rd_dev,
+				   char __user *buf, size_t count, loff_t *pos)
+{
+	size_t total = rd_dev->elfcore_size + rd_dev->staging_size;
+	size_t copied = 0, n;
+	loff_t off = *pos;
+
+	if (off >= total) {
+		pr_debug("Ramdump(%s): Ramdump complete. %lld bytes read.",
+			rd_dev->name, *pos);
+		rd_dev->ramdump_status = 0;
+		ramdump_free_staged(rd_dev);
+		*pos = 0;
+		complete(&rd_dev->ramdump_complete);
+		return 0;
+	}
+
+	if (off < rd_dev->elfcore_size) {
+		n = min_t(size_t, count, rd_dev->elfcore_size - off);
+		if (copy_to_user(buf, rd_dev->elfcore_buf + off, n))
+			return -EFAULT;
+		copied += n;
+		off += n;
+	}
+
+	if (copied < count && off < total) {
+		n = min_t(size_t, count - copied, total - off);
+		if (copy_to_user(buf + copied, rd_dev->staging_buf +
+				 (off - rd_dev->elfcore_size), n))
+			return -EFAULT;
+		copied += n;
+		off += n;
+	}
+
+	*pos = off;
+	return copied;
+}
+
 static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 			loff_t *pos)
 {
@@ -120,6 +188,14 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 	if (ret)
 		return ret;
 
+	mutex_lock(&rd_dev->staging_lock);
+	if (rd_dev->staging_buf) {
+		ret = ramdump_read_staged(rd_dev, buf, count, pos);
+		mutex_unlock(&rd_dev->staging_lock);
+		return ret;
+	}
+	mutex_unlock(&rd_dev->staging_lock);
+
 	if (*pos < rd_dev->elfcore_size) {
 		copy_size = rd_dev->elfcore_size - *pos;
 		copy_size = min(copy_size, count);
@@ -267,6 +343,7 @@ void *create_ramdump_device(const char *dev_name, struct device *parent)
 		 dev_name);
 
 	init_completion(&rd_dev->ramdump_complete);
+	mutex_init(&rd_dev->staging_lock);
 
 	rd_dev->device.minor = MISC_DYNAMIC_MINOR;
 	rd_dev->device.name = rd_dev->name;
@@ -296,10 +373,84 @@ void destroy_ramdump_device(void *dev)
 		return;
 
 	misc_deregister(&rd_dev->device);
+	mutex_lock(&rd_dev->staging_lock);
+	if (rd_dev->staging_buf)
+		ramdump_free_staged(rd_dev);
+	mutex_unlock(&rd_dev->staging_lock);
 	kfree(rd_dev);
 }
 EXPORT_SYMBOL(destroy_ramdump_device);
 
+static int ramdump_copy_seg(struct ramdump_device *rd_dev, void *dst,
+			    struct ramdump_segment *seg)
+{
+	unsigned long addr = seg->address, left = seg->size;
+	void *vaddr = seg->v_address;
+	struct dma_attrs attrs;
+	size_t size;
+	void *src;
+
+	init_dma_attrs(&attrs);
+	dma_set_attr(DMA_ATTR_SKIP_ZEROING, &attrs);
+	while (left) {
+		size = min_t(unsigned long, left, MAX_IOREMAP_SIZE);
+		src = vaddr ?: dma_remap(rd_dev->device.parent, NULL, addr,
+					 size, &attrs);
+		if (!src) {
+			pr_err("Ramdump(%s): Unable to ioremap: addr %lx, size %zd\n",
+				rd_dev->name, addr, size);
+			return -ENOMEM;
+		}
+		memcpy_fromio(dst, src, size);
+		if (vaddr)
+			vaddr += size;
+		else
+			dma_unremap(rd_dev->device.parent, src, size);
+
+		dst += size;
+		addr += size;
+		left -= size;
+	}
+
+	return 0;
+}
+
+/*
+ * Copies the dump into a staging buffer read by ramdump_read_staged(), so
+ * that the caller can go on to restart the subsystem right away.
+ * Must be called with staging_lock locked.
+ */
+static int ramdump_stage(struct ramdump_device *rd_dev,
+			 struct ramdump_segment *segments, int nsegments)
+{
+	size_t total = 0;
+	void *dst;
+	int i, ret;
+
+	for (i = 0; i < nsegments; i++)
+		total += segments[i].size;
+	if (!total || total > (size_t)staging_max_mb * SZ_1M)
+		return -E2BIG;
+
+	rd_dev->staging_buf = vmalloc(total);
+	if (!rd_dev->staging_buf)
+		return -ENOMEM;
+
+	dst = rd_dev->staging_buf;
+	for (i = 0; i < nsegments; i++) {
+		ret = ramdump_copy_seg(rd_dev, dst, &segments[i]);
+		if (ret) {
+			vfree(rd_dev->staging_buf);
+			rd_dev->staging_buf = NULL;
+			return ret;
+		}
+		dst += segments[i].size;
+	}
+	rd_dev->staging_size = total;
+
+	return 0;
+}
+
 static int _do_ramdump(void *handle, struct ramdump_segment *segments,
 		int nsegments, bool use_elf)
 {
@@ -314,6 +465,14 @@ static int _do_ramdump(void *handle, struct ramdump_segment *segments,
 		return -EPIPE;
 	}
 
+	mutex_lock(&rd_dev->staging_lock);
+	if (rd_dev->staging_buf) {
+		pr_info("Ramdump(%s): Dropping unread previous dump\n",
+			rd_dev->name);
+		ramdump_free_staged(rd_dev);
+	}
+	mutex_unlock(&rd_dev->staging_lock);
+
 	for (i = 0; i < nsegments; i++)
 		segments[i].size = PAGE_ALIGN(segments[i].size);
 
@@ -352,6 +511,17 @@ static int _do_ramdump(void *handle, struct ramdump_segment *segments,
 		}
 	}
 
+	mutex_lock(&rd_dev->staging_lock);
+	if (staging_max_mb && !ramdump_stage(rd_dev, segments, nsegments)) {
+		rd_dev->data_ready = 1;
+		rd_dev->ramdump_status = -1;
+		reinit_completion(&rd_dev->ramdump_complete);
+		mutex_unlock(&rd_dev->staging_lock);
+		wake_up(&rd_dev->dump_wait_q);
+		return 0;
+	}
+	mutex_unlock(&rd_dev->staging_lock);
+
 	rd_dev->data_ready = 1;
 	rd_dev->ramdump_status = -1;
 
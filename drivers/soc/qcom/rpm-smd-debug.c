@@ -16,6 +16,7 @@
 #include <linux/init.h>
 #include <linux/module.h>
 #include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/list.h>
 #include <linux/io.h>
 #include <linux/uaccess.h>
@@ -117,6 +118,33 @@ static const struct file_operations rsc_ops = {
 	.write = rsc_ops_write,
 };
 
+static int rpm_stats_show(struct seq_file *m, void *unused)
+{
+	msm_rpm_show_stats(m);
+	return 0;
+}
+
+static int rpm_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, rpm_stats_show, NULL);
+}
+
+/* Any write clears the stats */
+static ssize_t rpm_stats_write(struct file *fp, const char __user *buf,
+						size_t count, loff_t *position)
+{
+	msm_rpm_reset_stats();
+	return count;
+}
+
+static const struct file_operations rpm_stats_ops = {
+	.open = rpm_stats_open,
+	.read = seq_read,
+	.write = rpm_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int __init rpm_smd_debugfs_init(void)
 {
 	rpm_debugfs_dir = debugfs_create_dir("rpm_send_msg", NULL);
@@ -127,6 +155,10 @@ static int __init rpm_smd_debugfs_init(void)
 								&rsc_ops))
 		return -ENOMEM;
 
+	if (!debugfs_create_file("stats", S_IRUGO | S_IWUSR, rpm_debugfs_dir,
+						NULL, &rpm_stats_ops))
+		return -ENOMEM;
+
 	return 0;
 }
 late_initcall(rpm_smd_debugfs_init);
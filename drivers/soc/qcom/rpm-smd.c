@@ -34,6 +34,8 @@
 #include <linux/of.h>
 #include <linux/of_platform.h>
 #include <linux/rbtree.h>
+#include <linux/ktime.h>
+#include <linux/seq_file.h>
 #include <soc/qcom/rpm-notifier.h>
 #include <soc/qcom/rpm-smd.h>
 #include <soc/qcom/smd.h>
@@ -142,8 +144,20 @@ struct slp_buf {
 	char ubuf[MAX_SLEEP_BUFFER];
 	char *buf;
 	bool valid;
+	uint32_t requests;
+	uint32_t sent;
 };
 static struct rb_root tr_root = RB_ROOT;
+static DEFINE_SPINLOCK(slp_buffer_lock);
+
+/*
+ * Last active set values sent for each resource, kept in the same form
+ * as the sleep buffers. An active set request that changes none of them
+ * is not sent.
+ */
+static struct rb_root act_root = RB_ROOT;
+static DEFINE_SPINLOCK(act_buffer_lock);
+static ktime_t stats_reset_ts;
 static int (*msm_rpm_send_buffer)(char *buf, uint32_t size, bool noirq);
 static int msm_rpm_send_smd_buffer(char *buf, uint32_t size, bool noirq);
 static int msm_rpm_glink_send_buffer(char *buf, uint32_t size, bool noirq);
@@ -408,7 +422,6 @@ int msm_rpm_smd_buffer_request(struct msm_rpm_request *cdata,
 		uint32_t size, gfp_t flag)
 {
 	struct slp_buf *slp;
-	static DEFINE_SPINLOCK(slp_buffer_lock);
 	unsigned long flags;
 	char *buf;
 
@@ -434,6 +447,7 @@ int msm_rpm_smd_buffer_request(struct msm_rpm_request *cdata,
 		
 		tr_update(slp, buf);
 	}
+	slp->requests++;
 	trace_rpm_smd_sleep_set(cdata->msg_hdr.msg_id,
 				cdata->msg_hdr.resource_type,
 				cdata->msg_hdr.resource_id);
@@ -559,6 +573,7 @@ static int msm_rpm_flush_requests(bool print)
 					get_rsc_id(s->buf));
 
 		s->valid = false;
+		s->sent++;
 		count++;
 
 		if (count >= MAX_WAIT_ON_ACK) {
@@ -1145,6 +1160,128 @@ static int msm_rpm_glink_send_buffer(char *buf, uint32_t size, bool noirq)
 		return size;
 }
 
+/*
+ * Returns true if the active set request in @cdata would not change any
+ * value last sent for its resource. Otherwise the cached values are
+ * updated from it, ahead of the send.
+ */
+static bool msm_rpm_active_redundant(struct msm_rpm_request *cdata,
+		uint32_t size)
+{
+	struct slp_buf *act;
+	unsigned long flags;
+	bool redundant = false;
+
+	spin_lock_irqsave(&act_buffer_lock, flags);
+	act = tr_search(&act_root, cdata->buf);
+
+	if (act && get_req_len(act->buf) + cdata->msg_hdr.data_len >
+			MAX_SLEEP_BUFFER) {
+		/* The merged copy might not fit, start over from this one */
+		rb_erase(&act->node, &act_root);
+		kfree(act);
+		act = NULL;
+	}
+
+	if (!act) {
+		if (size > MAX_SLEEP_BUFFER)
+			goto out;
+		act = kzalloc(sizeof(struct slp_buf), GFP_ATOMIC);
+		if (!act)
+			goto out;
+		act->buf = PTR_ALIGN(&act->ubuf[0], sizeof(u32));
+		memcpy(act->buf, cdata->buf, size);
+		tr_insert(&act_root, act);
+	} else {
+		act->valid = false;
+		tr_update(act, cdata->buf);
+		redundant = !act->valid;
+	}
+	act->requests++;
+out:
+	spin_unlock_irqrestore(&act_buffer_lock, flags);
+	return redundant;
+}
+
+/* Account a sent active set request, or forget its values if it failed */
+static void msm_rpm_active_sent(struct msm_rpm_request *cdata, bool sent)
+{
+	struct slp_buf *act;
+	unsigned long flags;
+
+	spin_lock_irqsave(&act_buffer_lock, flags);
+	act = tr_search(&act_root, cdata->buf);
+	if (act && sent) {
+		act->sent++;
+	} else if (act) {
+		rb_erase(&act->node, &act_root);
+		kfree(act);
+	}
+	spin_unlock_irqrestore(&act_buffer_lock, flags);
+}
+
+static void msm_rpm_show_tree_stats(struct seq_file *m, struct rb_root *root,
+		const char *set, s64 ms)
+{
+	struct rb_node *t;
+
+	for (t = rb_first(root); t; t = rb_next(t)) {
+		struct slp_buf *s = rb_entry(t, struct slp_buf, node);
+		unsigned int type = get_rsc_type(s->buf);
+
+		seq_printf(m, "%-6s %.4s %5u %10u %10u %8llu\n", set,
+			   (char *)&type, get_rsc_id(s->buf), s->requests,
+			   s->sent, div64_u64((u64)s->requests * MSEC_PER_SEC,
+					      ms));
+	}
+}
+
+void msm_rpm_show_stats(struct seq_file *m)
+{
+	unsigned long flags;
+	s64 ms = ktime_to_ms(ktime_sub(ktime_get(), stats_reset_ts)) ?: 1;
+
+	seq_printf(m, "over %lld ms\n", ms);
+	seq_printf(m, "%-6s %4s %5s %10s %10s %8s\n", "set", "type", "id",
+		   "requests", "sent", "req/s");
+
+	spin_lock_irqsave(&act_buffer_lock, flags);
+	msm_rpm_show_tree_stats(m, &act_root, "active", ms);
+	spin_unlock_irqrestore(&act_buffer_lock, flags);
+
+	spin_lock_irqsave(&slp_buffer_lock, flags);
+	msm_rpm_show_tree_stats(m, &tr_root, "sleep", ms);
+	spin_unlock_irqrestore(&slp_buffer_lock, flags);
+}
+EXPORT_SYMBOL(msm_rpm_show_stats);
+
+static void msm_rpm_reset_tree_stats(struct rb_root *root)
+{
+	struct rb_node *t;
+
+	for (t = rb_first(root); t; t = rb_next(t)) {
+		struct slp_buf *s = rb_entry(t, struct slp_buf, node);
+
+		s->requests = 0;
+		s->sent = 0;
+	}
+}
+
+void msm_rpm_reset_stats(void)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&act_buffer_lock, flags);
+	msm_rpm_reset_tree_stats(&act_root);
+	spin_unlock_irqrestore(&act_buffer_lock, flags);
+
+	spin_lock_irqsave(&slp_buffer_lock, flags);
+	msm_rpm_reset_tree_stats(&tr_root);
+	stats_reset_ts = ktime_get();
+	spin_unlock_irqrestore(&slp_buffer_lock, flags);
+}
+EXPORT_SYMBOL(msm_rpm_reset_stats);
+
 static int msm_rpm_send_data(struct msm_rpm_request *cdata,
 		int msg_type, bool noirq, bool noack)
 {
@@ -1213,6 +1350,14 @@ static int msm_rpm_send_data(struct msm_rpm_request *cdata,
 			GFP_FLAG(noirq)))
 		return 1;
 
+	if (!standalone && cdata->msg_hdr.set == MSM_RPM_CTX_ACTIVE_SET &&
+	    msm_rpm_active_redundant(cdata, msg_size)) {
+		for (i = 0; (i < cdata->write_idx); i++)
+			cdata->kvp[i].valid = false;
+		cdata->msg_hdr.data_len = 0;
+		return 1;
+	}
+
 	cdata->msg_hdr.msg_id = msm_rpm_get_next_msg_id();
 
 	memcpy(cdata->buf + req_hdr_sz, &cdata->msg_hdr, msg_hdr_sz);
@@ -1234,6 +1379,9 @@ static int msm_rpm_send_data(struct msm_rpm_request *cdata,
 
 	ret = msm_rpm_send_buffer(&cdata->buf[0], msg_size, noirq);
 
+	if (cdata->msg_hdr.set == MSM_RPM_CTX_ACTIVE_SET)
+		msm_rpm_active_sent(cdata, ret == msg_size);
+
 	if (ret == msg_size) {
 		for (i = 0; (i < cdata->write_idx); i++)
 			cdata->kvp[i].valid = false;
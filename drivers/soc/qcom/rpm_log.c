@@ -526,6 +526,7 @@ static struct platform_driver msm_rpm_log_driver = {
 	.driver		= {
 		.name = "msm_rpm_log",
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		.of_match_table = rpm_log_table,
 	},
 };
@@ -413,6 +413,7 @@ static struct platform_driver msm_rpm_master_stats_driver = {
 	.driver = {
 		.name = "msm_rpm_master_stats",
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		.of_match_table = rpm_master_table,
 	},
 };
@@ -739,6 +739,7 @@ static struct platform_driver msm_rpmstats_driver = {
 	.driver = {
 		.name = "msm_rpm_stat",
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		.of_match_table = rpm_stats_table,
 	},
 };
@@ -21,6 +21,7 @@
 #include <linux/interrupt.h>
 #include <linux/ipc_logging.h>
 #include <linux/err.h>
+#include <linux/bitops.h>
 #include <soc/qcom/smem.h>
 #include "smp2p_private_api.h"
 #include "smp2p_private.h"
@@ -86,6 +87,9 @@ module_param_named(debug_mask, smp2p_debug_mask,
  * @prev_entry_val: Previous value of the entry.
  * @entry_ptr: Points to the current value in smem item.
  * @notifier_count: Counts the number of notifier registered per pid,entry.
+ * @update_count: Number of update notifications sent for this entry.
+ * @bits_changed: Total number of bits reported as changed.
+ * @coalesced_count: Updates that carried more than one changed bit.
  */
 struct smp2p_in {
 	int remote_pid;
@@ -95,6 +99,9 @@ struct smp2p_in {
 	uint32_t prev_entry_val;
 	uint32_t __iomem *entry_ptr;
 	uint32_t notifier_count;
+	uint32_t update_count;
+	uint32_t bits_changed;
+	uint32_t coalesced_count;
 };
 
 /**
@@ -103,6 +110,7 @@ struct smp2p_in {
  * @in_item_lock_lhb1: Lock protecting all elements of the structure.
  * @list: List head for the entries on remote processor.
  * @smem_edge_in: Pointer to the remote smem item.
+ * @scanned_valid_total_ent: Remote entry count the last name lookup saw.
  */
 struct smp2p_in_list_item {
 	spinlock_t in_item_lock_lhb1;
@@ -110,6 +118,7 @@ struct smp2p_in_list_item {
 	struct smp2p_smem __iomem *smem_edge_in;
 	uint32_t item_size;
 	uint32_t safe_total_entries;
+	uint32_t scanned_valid_total_ent;
 };
 static struct smp2p_in_list_item in_list[SMP2P_NUM_PROCS];
 
@@ -283,6 +292,45 @@ struct smp2p_smem __iomem *smp2p_get_in_item(int remote_pid)
 	return ret;
 }
 
+/**
+ * smp2p_get_in_entry_stats - Copy the inbound entry statistics.
+ *
+ * @remote_pid: Processor ID of the remote system.
+ * @stats:      Array to fill in.
+ * @max:        Number of elements in @stats.
+ * @returns:    Number of elements filled in.
+ *
+ * This is used by debugfs to print the per-entry notification counters.
+ */
+int smp2p_get_in_entry_stats(int remote_pid,
+		struct smp2p_in_entry_stats *stats, int max)
+{
+	struct smp2p_in *pos;
+	unsigned long flags;
+	int n = 0;
+
+	if (remote_pid >= SMP2P_NUM_PROCS)
+		return 0;
+
+	spin_lock_irqsave(&in_list[remote_pid].in_item_lock_lhb1, flags);
+	list_for_each_entry(pos, &in_list[remote_pid].list, in_edge_list) {
+		if (n >= max)
+			break;
+		strlcpy(stats[n].name, pos->name, SMP2P_MAX_ENTRY_NAME);
+		stats[n].value = pos->prev_entry_val;
+		stats[n].is_open = pos->entry_ptr != NULL;
+		stats[n].notifier_count = pos->notifier_count;
+		stats[n].update_count = pos->update_count;
+		stats[n].bits_changed = pos->bits_changed;
+		stats[n].coalesced_count = pos->coalesced_count;
+		n++;
+	}
+	spin_unlock_irqrestore(&in_list[remote_pid].in_item_lock_lhb1,
+								flags);
+
+	return n;
+}
+
 /**
  * smp2p_get_out_item - Return pointer to outbound SMEM item.
  *
@@ -1116,6 +1164,7 @@ static int smp2p_do_negotiation(int remote_pid,
 		(void)out_item->ops_ptr->validate_size(remote_pid, r_smem_ptr,
 				in_list[remote_pid].item_size);
 		in_list[remote_pid].smem_edge_in = r_smem_ptr;
+		in_list[remote_pid].scanned_valid_total_ent = 0;
 		spin_unlock(&in_list[remote_pid].in_item_lock_lhb1);
 	} else {
 		SMP2P_INFO("%s: negotiation pid %d: State %d->%d F0x%08x\n",
@@ -1609,6 +1658,12 @@ static void smp2p_send_interrupt(int remote_pid)
  * the list of the clients registered for the entries on the remote
  * processor and notifies them if  the data changes.
  *
+ * Entries that are not open yet are only looked up by name when the
+ * remote entry count has changed since the last lookup, so bursts of
+ * state changes do not repeat the name scan of the remote item. Each
+ * open entry is diffed against its previous value and gets at most one
+ * update per interrupt, however many of its bits toggled.
+ *
  * Note:  Edge state must be OPENED to avoid a race condition with
  *        out_list[pid].ops_ptr->find_entry.
  */
@@ -1619,6 +1674,9 @@ static void smp2p_in_edge_notify(int pid)
 	unsigned long flags;
 	struct smp2p_smem __iomem *smem_h_ptr;
 	uint32_t curr_data;
+	uint32_t changed;
+	uint32_t valid_total_ent;
+	bool do_scan;
 	struct  msm_smp2p_update_notif data;
 
 	spin_lock_irqsave(&in_list[pid].in_item_lock_lhb1, flags);
@@ -1630,8 +1688,12 @@ static void smp2p_in_edge_notify(int pid)
 		return;
 	}
 
+	valid_total_ent = readl_relaxed(&smem_h_ptr->valid_total_ent);
+	do_scan = valid_total_ent != in_list[pid].scanned_valid_total_ent;
+	in_list[pid].scanned_valid_total_ent = valid_total_ent;
+
 	list_for_each_entry(pos, &in_list[pid].list, in_edge_list) {
-		if (pos->entry_ptr == NULL) {
+		if (pos->entry_ptr == NULL && do_scan) {
 			/* entry not open - try to open it */
 			out_list[pid].ops_ptr->find_entry(smem_h_ptr,
 				in_list[pid].safe_total_entries, pos->name,
@@ -1651,10 +1713,15 @@ static void smp2p_in_edge_notify(int pid)
 		if (pos->entry_ptr != NULL) {
 			/* send update notification */
 			curr_data = readl_relaxed(pos->entry_ptr);
-			if (curr_data != pos->prev_entry_val) {
+			changed = curr_data ^ pos->prev_entry_val;
+			if (changed) {
 				data.previous_value = pos->prev_entry_val;
 				data.current_value = curr_data;
 				pos->prev_entry_val = curr_data;
+				pos->update_count++;
+				pos->bits_changed += hweight32(changed);
+				if (changed & (changed - 1))
+					pos->coalesced_count++;
 				raw_notifier_call_chain(
 					&pos->in_notifier_list,
 					SMP2P_ENTRY_UPDATE, (void *)&data);
@@ -1768,6 +1835,7 @@ int smp2p_reset_mock_edge(void)
 	in_list[rpid].smem_edge_in = NULL;
 	in_list[rpid].item_size = 0;
 	in_list[rpid].safe_total_entries = 0;
+	in_list[rpid].scanned_valid_total_ent = 0;
 
 fail:
 	spin_unlock(&in_list[rpid].in_item_lock_lhb1);
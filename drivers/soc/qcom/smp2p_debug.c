@@ -15,6 +15,7 @@
 #include <linux/list.h>
 #include <linux/debugfs.h>
 #include <linux/io.h>
+#include <linux/slab.h>
 #include "smp2p_private.h"
 
 #if defined(CONFIG_DEBUG_FS)
@@ -286,6 +287,49 @@ static void smp2p_items(struct seq_file *s)
 		smp2p_item(s, pid);
 }
 
+/**
+ * Dump inbound entry notification statistics.
+ *
+ * @s:   pointer to output file
+ */
+static void smp2p_in_entry_stats(struct seq_file *s)
+{
+	struct smp2p_interrupt_config *int_cfg;
+	struct smp2p_in_entry_stats *stats;
+	int pid;
+	int n;
+	int i;
+
+	int_cfg = smp2p_get_interrupt_config();
+	if (!int_cfg)
+		return;
+
+	stats = kcalloc(SMP2P_MAX_ENTRY, sizeof(*stats), GFP_KERNEL);
+	if (!stats)
+		return;
+
+	seq_puts(s, "| Processor | Entry Name       | Value    | Open |");
+	seq_puts(s, " Notifiers | Updates    | Bits       | Coalesced  |\n");
+
+	for (pid = 0; pid < SMP2P_NUM_PROCS; ++pid) {
+		if (!int_cfg[pid].is_configured &&
+				pid != SMP2P_REMOTE_MOCK_PROC)
+			continue;
+
+		n = smp2p_get_in_entry_stats(pid, stats, SMP2P_MAX_ENTRY);
+		for (i = 0; i < n; ++i)
+			seq_printf(s,
+				"| %5s (%d) | %-16s | %08x | %4c | %9u | %10u | %10u | %10u |\n",
+				int_cfg[pid].name, pid, stats[i].name,
+				stats[i].value, stats[i].is_open ? 'Y' : 'N',
+				stats[i].notifier_count,
+				stats[i].update_count,
+				stats[i].bits_changed,
+				stats[i].coalesced_count);
+	}
+	kfree(stats);
+}
+
 static struct dentry *dent;
 
 static int debugfs_show(struct seq_file *s, void *data)
@@ -327,6 +371,7 @@ static int __init smp2p_debugfs_init(void)
 
 	debug_create("int_stats", smp2p_int_stats);
 	debug_create("items", smp2p_items);
+	debug_create("in_entry_stats", smp2p_in_entry_stats);
 
 	return 0;
 }
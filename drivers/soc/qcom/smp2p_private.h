@@ -245,7 +245,20 @@ struct smp2p_interrupt_config {
 	unsigned out_interrupt_count;
 };
 
+/* Inbound entry notification statistics. */
+struct smp2p_in_entry_stats {
+	char name[SMP2P_MAX_ENTRY_NAME];
+	uint32_t value;
+	bool is_open;
+	uint32_t notifier_count;
+	uint32_t update_count;
+	uint32_t bits_changed;
+	uint32_t coalesced_count;
+};
+
 struct smp2p_interrupt_config *smp2p_get_interrupt_config(void);
+int smp2p_get_in_entry_stats(int remote_pid,
+		struct smp2p_in_entry_stats *stats, int max);
 const char *smp2p_pid_to_name(int remote_pid);
 struct smp2p_smem *smp2p_get_in_item(int remote_pid);
 struct smp2p_smem *smp2p_get_out_item(int remote_pid, int *state);
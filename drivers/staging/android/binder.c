@@ -27,6 +27,7 @@
 #include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/mutex.h>
+#include <linux/percpu.h>
 #include <linux/nsproxy.h>
 #include <linux/poll.h>
 #include <linux/debugfs.h>
@@ -45,6 +46,7 @@
 static DEFINE_MUTEX(binder_main_lock);
 static DEFINE_MUTEX(binder_deferred_lock);
 static DEFINE_MUTEX(binder_mmap_lock);
+static DEFINE_MUTEX(binder_procs_lock);
 
 static HLIST_HEAD(binder_procs);
 static HLIST_HEAD(binder_deferred_list);
@@ -87,6 +89,26 @@ BINDER_DEBUG_ENTRY(proc);
 
 #define BINDER_SMALL_BUF_SIZE (PAGE_SIZE * 64)
 
+/*
+ * Small synchronous buffers are recycled through per-proc size class
+ * lists instead of being merged back into free_buffers.  Cached buffers
+ * keep their pages mapped, so reusing one avoids both the rbtree walk
+ * and binder_update_page_range().
+ */
+#define BINDER_BUF_CACHE_CLASSES	3
+#define BINDER_BUF_CACHE_MIN_SIZE	64
+#define BINDER_BUF_CACHE_MAX_SIZE \
+	(BINDER_BUF_CACHE_MIN_SIZE << (BINDER_BUF_CACHE_CLASSES - 1))
+#define BINDER_BUF_CACHE_DEPTH		8
+
+/*
+ * Oneway buffers are accounted per sending process so that a single
+ * spammer cannot exhaust the async half of a target's buffer.  The
+ * number of tracked senders per target is bounded; idle entries are
+ * recycled once the limit is reached.
+ */
+#define BINDER_ASYNC_SENDERS_MAX	64
+
 enum {
 	BINDER_DEBUG_USER_ERROR             = 1U << 0,
 	BINDER_DEBUG_FAILED_TRANSACTION     = 1U << 1,
@@ -128,6 +150,47 @@ static int binder_set_stop_on_user_error(const char *val,
 module_param_call(stop_on_user_error, binder_set_stop_on_user_error,
 	param_get_int, &binder_stop_on_user_error, S_IWUSR | S_IRUGO);
 
+/*
+ * Reservoir of zeroed pages used by binder_update_page_range() so that
+ * the transaction path does not enter direct reclaim.  The pool is
+ * refilled from a work item up to binder_page_pool_watermark pages.
+ */
+static struct {
+	spinlock_t lock;
+	struct list_head pages;
+	int count;
+} binder_page_pool = {
+	.lock = __SPIN_LOCK_UNLOCKED(binder_page_pool.lock),
+	.pages = LIST_HEAD_INIT(binder_page_pool.pages),
+};
+
+static int binder_page_pool_watermark = 32;
+
+static void binder_page_pool_refill(struct work_struct *work);
+static DECLARE_WORK(binder_page_pool_work, binder_page_pool_refill);
+
+static int binder_set_page_pool_watermark(const char *val,
+					  struct kernel_param *kp)
+{
+	int ret;
+
+	ret = param_set_int(val, kp);
+	if (!ret)
+		schedule_work(&binder_page_pool_work);
+	return ret;
+}
+module_param_call(page_pool_watermark, binder_set_page_pool_watermark,
+	param_get_int, &binder_page_pool_watermark, S_IWUSR | S_IRUGO);
+
+/*
+ * Percentage of a target's async space a single sender may hold once
+ * more than half of that space is in use.  0 disables the per-sender
+ * limit.
+ */
+static unsigned int binder_async_sender_share = 25;
+module_param_named(async_sender_share, binder_async_sender_share, uint,
+		   S_IWUSR | S_IRUGO);
+
 #define binder_debug(mask, x...) \
 	do { \
 		if (binder_debug_mask & mask) \
@@ -162,6 +225,14 @@ struct binder_stats {
 
 static struct binder_stats binder_stats;
 
+struct binder_lock_stats {
+	u64 acquired;
+	atomic_t contended;
+	atomic64_t wait_ns;
+};
+
+static struct binder_lock_stats binder_lock_stats;
+
 static inline void binder_stats_deleted(enum binder_stat_types type)
 {
 	binder_stats.obj_deleted[type]++;
@@ -172,6 +243,39 @@ static inline void binder_stats_created(enum binder_stat_types type)
 	binder_stats.obj_created[type]++;
 }
 
+/*
+ * log2 latency histograms, bucket i counts samples below 2^i us and the
+ * last bucket collects everything slower.  "wait" is the time from
+ * queueing a transaction to a thread picking it up, "reply" the time
+ * from queueing to the reply being queued back to the caller.
+ */
+#define BINDER_LAT_BUCKETS	16
+
+struct binder_lat_hist {
+	u32 wait[BINDER_LAT_BUCKETS];
+	u32 reply[BINDER_LAT_BUCKETS];
+};
+
+static inline int binder_lat_bucket(u64 delta_ns)
+{
+	int bucket = fls64(div_u64(delta_ns, NSEC_PER_USEC));
+
+	return min(bucket, BINDER_LAT_BUCKETS - 1);
+}
+
+static void binder_lat_wait(struct binder_lat_hist __percpu *hist, int bucket)
+{
+	if (hist)
+		this_cpu_inc(hist->wait[bucket]);
+}
+
+static void binder_lat_reply(struct binder_lat_hist __percpu *hist,
+			     int bucket)
+{
+	if (hist)
+		this_cpu_inc(hist->reply[bucket]);
+}
+
 struct binder_transaction_log_entry {
 	int debug_id;
 	int call_type;
@@ -219,6 +323,11 @@ struct binder_work {
 	} type;
 };
 
+struct binder_priority {
+	unsigned int sched_policy;
+	int prio;
+};
+
 struct binder_node {
 	int debug_id;
 	struct binder_work work;
@@ -239,8 +348,11 @@ struct binder_node {
 	unsigned pending_weak_ref:1;
 	unsigned has_async_transaction:1;
 	unsigned accept_fds:1;
+	unsigned sched_policy:2;
+	unsigned inherit_rt:1;
 	unsigned min_priority:8;
 	struct list_head async_todo;
+	struct binder_lat_hist __percpu *lat;
 };
 
 struct binder_ref_death {
@@ -267,12 +379,16 @@ struct binder_ref {
 
 struct binder_buffer {
 	struct list_head entry; /* free and allocated entries by address */
-	struct rb_node rb_node; /* free entry by size or allocated entry */
-				/* by address */
+	union {
+		struct rb_node rb_node; /* free entry by size or allocated */
+					/* entry by address */
+		struct list_head cache_entry; /* entry in proc->buf_cache */
+	};
 	unsigned free:1;
 	unsigned allow_user_free:1;
 	unsigned async_transaction:1;
 	unsigned debug_id:29;
+	int async_pid;
 
 	struct binder_transaction *transaction;
 
@@ -288,6 +404,16 @@ enum binder_deferred_state {
 	BINDER_DEFERRED_RELEASE      = 0x04,
 };
 
+struct binder_async_sender {
+	struct rb_node rb_node;
+	int pid;
+	size_t space_used;
+	int buffers;
+	unsigned long allocs;
+	unsigned long refused;
+	unsigned long coalesced;
+};
+
 struct binder_proc {
 	struct hlist_node proc_node;
 	struct rb_root threads;
@@ -308,6 +434,10 @@ struct binder_proc {
 	struct rb_root free_buffers;
 	struct rb_root allocated_buffers;
 	size_t free_async_space;
+	struct list_head buf_cache[BINDER_BUF_CACHE_CLASSES];
+	int buf_cache_count[BINDER_BUF_CACHE_CLASSES];
+	struct rb_root async_senders;
+	int async_senders_count;
 
 	struct page **pages;
 	size_t buffer_size;
@@ -320,8 +450,9 @@ struct binder_proc {
 	int requested_threads;
 	int requested_threads_started;
 	int ready_threads;
-	long default_priority;
+	struct binder_priority default_priority;
 	struct dentry *debugfs_entry;
+	struct binder_lat_hist __percpu *lat;
 };
 
 enum {
@@ -362,9 +493,10 @@ struct binder_transaction {
 	struct binder_buffer *buffer;
 	unsigned int	code;
 	unsigned int	flags;
-	long	priority;
-	long	saved_priority;
+	struct binder_priority	priority;
+	struct binder_priority	saved_priority;
 	kuid_t	sender_euid;
+	u64	queued_ns;
 };
 
 static void
@@ -422,7 +554,15 @@ static long task_close_fd(struct binder_proc *proc, unsigned int fd)
 static inline void binder_lock(const char *tag)
 {
 	trace_binder_lock(tag);
-	mutex_lock(&binder_main_lock);
+	if (!mutex_trylock(&binder_main_lock)) {
+		u64 start = ktime_get_ns();
+
+		mutex_lock(&binder_main_lock);
+		atomic_inc(&binder_lock_stats.contended);
+		atomic64_add(ktime_get_ns() - start,
+			     &binder_lock_stats.wait_ns);
+	}
+	binder_lock_stats.acquired++;
 	trace_binder_locked(tag);
 }
 
@@ -432,22 +572,195 @@ static inline void binder_unlock(const char *tag)
 	mutex_unlock(&binder_main_lock);
 }
 
-static void binder_set_nice(long nice)
+static bool is_rt_policy(int policy)
+{
+	return policy == SCHED_FIFO || policy == SCHED_RR;
+}
+
+static bool is_fair_policy(int policy)
+{
+	return policy == SCHED_NORMAL || policy == SCHED_BATCH;
+}
+
+static bool binder_supported_policy(int policy)
+{
+	return is_fair_policy(policy) || is_rt_policy(policy);
+}
+
+static int to_userspace_prio(int policy, int kernel_priority)
+{
+	if (is_fair_policy(policy))
+		return PRIO_TO_NICE(kernel_priority);
+	else
+		return MAX_USER_RT_PRIO - 1 - kernel_priority;
+}
+
+static int to_kernel_prio(int policy, int user_priority)
+{
+	if (is_fair_policy(policy))
+		return NICE_TO_PRIO(user_priority);
+	else
+		return MAX_USER_RT_PRIO - 1 - user_priority;
+}
+
+static void binder_get_priority(struct task_struct *task,
+				struct binder_priority *p)
+{
+	if (binder_supported_policy(task->policy)) {
+		p->sched_policy = task->policy;
+		p->prio = task->normal_prio;
+	} else {
+		p->sched_policy = SCHED_NORMAL;
+		p->prio = NICE_TO_PRIO(0);
+	}
+}
+
+/*
+ * Move current to the desired policy and priority, capped by its
+ * RLIMIT_RTPRIO/RLIMIT_NICE unless it has CAP_SYS_NICE.
+ */
+static void binder_set_priority(struct binder_priority desired)
 {
-	long min_nice;
+	struct task_struct *task = current;
+	int priority;
+	unsigned int policy = desired.sched_policy;
+	struct sched_param params;
 
-	if (can_nice(current, nice)) {
-		set_user_nice(current, nice);
+	if (task->policy == policy && task->normal_prio == desired.prio)
 		return;
+
+	priority = to_userspace_prio(policy, desired.prio);
+
+	if (is_rt_policy(policy) &&
+	    !has_capability_noaudit(task, CAP_SYS_NICE)) {
+		int max_rtprio = task_rlimit(task, RLIMIT_RTPRIO);
+
+		if (max_rtprio == 0) {
+			policy = SCHED_NORMAL;
+			priority = MIN_NICE;
+		} else if (priority > max_rtprio) {
+			priority = max_rtprio;
+		}
 	}
-	min_nice = rlimit_to_nice(current->signal->rlim[RLIMIT_NICE].rlim_cur);
-	binder_debug(BINDER_DEBUG_PRIORITY_CAP,
-		     "%d: nice value %ld not allowed use %ld instead\n",
-		      current->pid, nice, min_nice);
-	set_user_nice(current, min_nice);
-	if (min_nice <= MAX_NICE)
+
+	if (is_fair_policy(policy) &&
+	    !has_capability_noaudit(task, CAP_SYS_NICE)) {
+		int min_nice = rlimit_to_nice(task_rlimit(task, RLIMIT_NICE));
+
+		if (min_nice > MAX_NICE) {
+			binder_user_error("%d RLIMIT_NICE not set\n",
+					  task->pid);
+			return;
+		} else if (priority < min_nice) {
+			priority = min_nice;
+		}
+	}
+
+	if (policy != desired.sched_policy ||
+	    to_kernel_prio(policy, priority) != desired.prio)
+		binder_debug(BINDER_DEBUG_PRIORITY_CAP,
+			     "%d: priority %d not allowed, using %d instead\n",
+			      task->pid, desired.prio,
+			      to_kernel_prio(policy, priority));
+
+	params.sched_priority = is_rt_policy(policy) ? priority : 0;
+	sched_setscheduler_nocheck(task, policy | SCHED_RESET_ON_FORK,
+				   &params);
+	if (is_fair_policy(policy))
+		set_user_nice(task, priority);
+}
+
+/*
+ * Pick the priority a thread runs at while handling @t for @node: the
+ * caller's priority for synchronous transactions, raised to the node's
+ * minimum if that is higher.  Real-time callers only pass on their
+ * policy when the node opted in with FLAT_BINDER_FLAG_INHERIT_RT.
+ */
+static void binder_transaction_priority(struct binder_transaction *t,
+					struct binder_node *node)
+{
+	struct binder_priority desired = t->priority;
+	struct binder_priority node_prio = {
+		.sched_policy = node->sched_policy,
+		.prio = node->min_priority,
+	};
+
+	if (t->flags & TF_ONE_WAY) {
+		if (node_prio.prio < t->saved_priority.prio)
+			binder_set_priority(node_prio);
 		return;
-	binder_user_error("%d RLIMIT_NICE not set\n", current->pid);
+	}
+
+	if (!node->inherit_rt && is_rt_policy(desired.sched_policy)) {
+		desired.sched_policy = SCHED_NORMAL;
+		desired.prio = NICE_TO_PRIO(0);
+	}
+
+	if (node_prio.prio < desired.prio ||
+	    (node_prio.prio == desired.prio &&
+	     is_rt_policy(node_prio.sched_policy)))
+		desired = node_prio;
+
+	binder_set_priority(desired);
+}
+
+static void binder_page_pool_refill(struct work_struct *work)
+{
+	struct page *page, *n_page;
+	LIST_HEAD(pages);
+	int count;
+
+	spin_lock(&binder_page_pool.lock);
+	count = binder_page_pool_watermark - binder_page_pool.count;
+	spin_unlock(&binder_page_pool.lock);
+
+	for (; count > 0; count--) {
+		page = alloc_page(GFP_KERNEL | __GFP_HIGHMEM | __GFP_ZERO |
+				  __GFP_NORETRY | __GFP_NOWARN);
+		if (!page)
+			break;
+		list_add(&page->lru, &pages);
+	}
+
+	spin_lock(&binder_page_pool.lock);
+	while (!list_empty(&pages)) {
+		page = list_first_entry(&pages, struct page, lru);
+		list_move(&page->lru, &binder_page_pool.pages);
+		binder_page_pool.count++;
+	}
+	/* trim after the watermark was lowered */
+	while (binder_page_pool.count > binder_page_pool_watermark) {
+		page = list_first_entry(&binder_page_pool.pages,
+					struct page, lru);
+		list_move(&page->lru, &pages);
+		binder_page_pool.count--;
+	}
+	spin_unlock(&binder_page_pool.lock);
+
+	list_for_each_entry_safe(page, n_page, &pages, lru)
+		__free_page(page);
+}
+
+static struct page *binder_page_pool_get(void)
+{
+	struct page *page = NULL;
+	int count;
+
+	spin_lock(&binder_page_pool.lock);
+	if (!list_empty(&binder_page_pool.pages)) {
+		page = list_first_entry(&binder_page_pool.pages,
+					struct page, lru);
+		list_del(&page->lru);
+		binder_page_pool.count--;
+	}
+	count = binder_page_pool.count;
+	spin_unlock(&binder_page_pool.lock);
+
+	if (count < binder_page_pool_watermark / 2)
+		schedule_work(&binder_page_pool_work);
+	if (page)
+		return page;
+	return alloc_page(GFP_KERNEL | __GFP_HIGHMEM | __GFP_ZERO);
 }
 
 static size_t binder_buffer_size(struct binder_proc *proc,
@@ -589,7 +902,7 @@ static int binder_update_page_range(struct binder_proc *proc, int allocate,
 		page = &proc->pages[(page_addr - proc->buffer) / PAGE_SIZE];
 
 		BUG_ON(*page);
-		*page = alloc_page(GFP_KERNEL | __GFP_HIGHMEM | __GFP_ZERO);
+		*page = binder_page_pool_get();
 		if (*page == NULL) {
 			pr_err("%d: binder_alloc_buf failed for page at %p\n",
 				proc->pid, page_addr);
@@ -643,14 +956,198 @@ err_no_vma:
 	return -ENOMEM;
 }
 
+static int binder_buf_cache_class(size_t size)
+{
+	int class = 0;
+
+	while (size > (BINDER_BUF_CACHE_MIN_SIZE << class))
+		class++;
+	return class;
+}
+
+static struct binder_buffer *binder_buf_cache_get(struct binder_proc *proc,
+						  size_t size)
+{
+	struct binder_buffer *buffer;
+	int class;
+
+	for (class = binder_buf_cache_class(size);
+	     class < BINDER_BUF_CACHE_CLASSES; class++) {
+		if (list_empty(&proc->buf_cache[class]))
+			continue;
+		buffer = list_first_entry(&proc->buf_cache[class],
+					  struct binder_buffer, cache_entry);
+		list_del(&buffer->cache_entry);
+		proc->buf_cache_count[class]--;
+		binder_insert_allocated_buffer(proc, buffer);
+		return buffer;
+	}
+	return NULL;
+}
+
+static bool binder_buf_cache_put(struct binder_proc *proc,
+				 struct binder_buffer *buffer,
+				 size_t buffer_size)
+{
+	int class;
+
+	if (buffer->async_transaction ||
+	    buffer_size < BINDER_BUF_CACHE_MIN_SIZE ||
+	    buffer_size >= BINDER_BUF_CACHE_MAX_SIZE * 2)
+		return false;
+
+	/* largest class that still fits in this buffer */
+	class = binder_buf_cache_class(buffer_size);
+	if (class >= BINDER_BUF_CACHE_CLASSES ||
+	    buffer_size < (BINDER_BUF_CACHE_MIN_SIZE << class))
+		class--;
+	if (proc->buf_cache_count[class] >= BINDER_BUF_CACHE_DEPTH)
+		return false;
+
+	rb_erase(&buffer->rb_node, &proc->allocated_buffers);
+	list_add(&buffer->cache_entry, &proc->buf_cache[class]);
+	proc->buf_cache_count[class]++;
+	return true;
+}
+
+static void __binder_free_buf(struct binder_proc *proc,
+			      struct binder_buffer *buffer);
+
+static bool binder_buf_cache_drain(struct binder_proc *proc)
+{
+	struct binder_buffer *buffer;
+	bool drained = false;
+	int class;
+
+	for (class = 0; class < BINDER_BUF_CACHE_CLASSES; class++) {
+		while (!list_empty(&proc->buf_cache[class])) {
+			buffer = list_first_entry(&proc->buf_cache[class],
+						  struct binder_buffer,
+						  cache_entry);
+			list_del(&buffer->cache_entry);
+			proc->buf_cache_count[class]--;
+			binder_insert_allocated_buffer(proc, buffer);
+			__binder_free_buf(proc, buffer);
+			drained = true;
+		}
+	}
+	return drained;
+}
+
+static struct binder_async_sender *binder_find_async_sender(
+		struct binder_proc *proc, int pid)
+{
+	struct rb_node *n = proc->async_senders.rb_node;
+	struct binder_async_sender *sender;
+
+	while (n) {
+		sender = rb_entry(n, struct binder_async_sender, rb_node);
+		if (pid < sender->pid)
+			n = n->rb_left;
+		else if (pid > sender->pid)
+			n = n->rb_right;
+		else
+			return sender;
+	}
+	return NULL;
+}
+
+static struct binder_async_sender *binder_get_async_sender(
+		struct binder_proc *proc, int pid)
+{
+	struct rb_node **p = &proc->async_senders.rb_node;
+	struct rb_node *parent = NULL;
+	struct binder_async_sender *sender;
+	struct rb_node *n;
+
+	while (*p) {
+		parent = *p;
+		sender = rb_entry(parent, struct binder_async_sender, rb_node);
+		if (pid < sender->pid)
+			p = &(*p)->rb_left;
+		else if (pid > sender->pid)
+			p = &(*p)->rb_right;
+		else
+			return sender;
+	}
+
+	if (proc->async_senders_count >= BINDER_ASYNC_SENDERS_MAX) {
+		/* recycle an idle sender, or go unaccounted */
+		for (n = rb_first(&proc->async_senders); n; n = rb_next(n)) {
+			sender = rb_entry(n, struct binder_async_sender,
+					  rb_node);
+			if (!sender->buffers)
+				break;
+		}
+		if (!n)
+			return NULL;
+		rb_erase(&sender->rb_node, &proc->async_senders);
+		memset(sender, 0, sizeof(*sender));
+		sender->pid = pid;
+		/* the tree changed under us, redo the walk */
+		p = &proc->async_senders.rb_node;
+		parent = NULL;
+		while (*p) {
+			struct binder_async_sender *s;
+
+			parent = *p;
+			s = rb_entry(parent, struct binder_async_sender,
+				     rb_node);
+			p = pid < s->pid ? &(*p)->rb_left : &(*p)->rb_right;
+		}
+	} else {
+		sender = kzalloc(sizeof(*sender), GFP_KERNEL);
+		if (sender == NULL)
+			return NULL;
+		sender->pid = pid;
+		proc->async_senders_count++;
+	}
+	rb_link_node(&sender->rb_node, parent, p);
+	rb_insert_color(&sender->rb_node, &proc->async_senders);
+	return sender;
+}
+
+static void binder_free_async_senders(struct binder_proc *proc)
+{
+	struct rb_node *n;
+
+	while ((n = rb_first(&proc->async_senders))) {
+		rb_erase(n, &proc->async_senders);
+		kfree(rb_entry(n, struct binder_async_sender, rb_node));
+	}
+	proc->async_senders_count = 0;
+}
+
+/*
+ * A sender may go over its share of the async space only while at least
+ * half of that space would remain free, so a quiet system still lets a
+ * bursty sender through but a saturated one stops the heaviest sender
+ * first.
+ */
+static bool binder_async_sender_over_quota(struct binder_proc *proc,
+					   struct binder_async_sender *sender,
+					   size_t size)
+{
+	size_t total = proc->buffer_size / 2;
+
+	if (!sender || !binder_async_sender_share)
+		return false;
+	if (proc->free_async_space - size >= total / 2)
+		return false;
+	return sender->space_used + size >
+		total / 100 * binder_async_sender_share;
+}
+
 static struct binder_buffer *binder_alloc_buf(struct binder_proc *proc,
 					      size_t data_size,
-					      size_t offsets_size, int is_async)
+					      size_t offsets_size, int is_async,
+					      int sender_pid)
 {
-	struct rb_node *n = proc->free_buffers.rb_node;
+	struct binder_async_sender *sender = NULL;
+	struct rb_node *n;
 	struct binder_buffer *buffer;
 	size_t buffer_size;
-	struct rb_node *best_fit = NULL;
+	struct rb_node *best_fit;
 	void *has_page_addr;
 	void *end_page_addr;
 	size_t size;
@@ -678,6 +1175,37 @@ static struct binder_buffer *binder_alloc_buf(struct binder_proc *proc,
 		return NULL;
 	}
 
+	if (is_async) {
+		sender = binder_get_async_sender(proc, sender_pid);
+		if (binder_async_sender_over_quota(proc, sender,
+				size + sizeof(struct binder_buffer))) {
+			sender->refused++;
+			binder_debug(BINDER_DEBUG_BUFFER_ALLOC_ASYNC,
+				     "%d: binder_alloc_buf size %zd failed, sender %d over async quota (%zd used)\n",
+				     proc->pid, size, sender_pid,
+				     sender->space_used);
+			return NULL;
+		}
+	}
+
+	if (!is_async && size <= BINDER_BUF_CACHE_MAX_SIZE) {
+		buffer = binder_buf_cache_get(proc, size);
+		if (buffer) {
+			binder_debug(BINDER_DEBUG_BUFFER_ALLOC,
+				     "%d: binder_alloc_buf size %zd got cached %p\n",
+				     proc->pid, size, buffer);
+			buffer->data_size = data_size;
+			buffer->offsets_size = offsets_size;
+			buffer->async_transaction = 0;
+			return buffer;
+		}
+		/* round up so the buffer can be recycled when freed */
+		size = BINDER_BUF_CACHE_MIN_SIZE << binder_buf_cache_class(size);
+	}
+
+retry:
+	n = proc->free_buffers.rb_node;
+	best_fit = NULL;
 	while (n) {
 		buffer = rb_entry(n, struct binder_buffer, rb_node);
 		BUG_ON(!buffer->free);
@@ -694,6 +1222,8 @@ static struct binder_buffer *binder_alloc_buf(struct binder_proc *proc,
 		}
 	}
 	if (best_fit == NULL) {
+		if (binder_buf_cache_drain(proc))
+			goto retry;
 		pr_err("%d: binder_alloc_buf size %zd failed, no address space\n",
 			proc->pid, size);
 		return NULL;
@@ -739,8 +1269,16 @@ static struct binder_buffer *binder_alloc_buf(struct binder_proc *proc,
 	buffer->data_size = data_size;
 	buffer->offsets_size = offsets_size;
 	buffer->async_transaction = is_async;
+	buffer->async_pid = 0;
 	if (is_async) {
 		proc->free_async_space -= size + sizeof(struct binder_buffer);
+		if (sender) {
+			sender->space_used += size +
+					      sizeof(struct binder_buffer);
+			sender->buffers++;
+			sender->allocs++;
+			buffer->async_pid = sender_pid;
+		}
 		binder_debug(BINDER_DEBUG_BUFFER_ALLOC_ASYNC,
 			     "%d: binder_alloc_buf size %zd async free %zd\n",
 			      proc->pid, size, proc->free_async_space);
@@ -804,8 +1342,8 @@ static void binder_delete_free_buffer(struct binder_proc *proc,
 	}
 }
 
-static void binder_free_buf(struct binder_proc *proc,
-			    struct binder_buffer *buffer)
+static void __binder_free_buf(struct binder_proc *proc,
+			      struct binder_buffer *buffer)
 {
 	size_t size, buffer_size;
 
@@ -825,7 +1363,17 @@ static void binder_free_buf(struct binder_proc *proc,
 	BUG_ON((void *)buffer > proc->buffer + proc->buffer_size);
 
 	if (buffer->async_transaction) {
+		struct binder_async_sender *sender;
+
 		proc->free_async_space += size + sizeof(struct binder_buffer);
+		sender = buffer->async_pid ?
+			binder_find_async_sender(proc, buffer->async_pid) :
+			NULL;
+		if (sender) {
+			sender->space_used -= size +
+					      sizeof(struct binder_buffer);
+			sender->buffers--;
+		}
 
 		binder_debug(BINDER_DEBUG_BUFFER_ALLOC_ASYNC,
 			     "%d: binder_free_buf size %zd async free %zd\n",
@@ -860,6 +1408,22 @@ static void binder_free_buf(struct binder_proc *proc,
 	binder_insert_free_buffer(proc, buffer);
 }
 
+static void binder_free_buf(struct binder_proc *proc,
+			    struct binder_buffer *buffer)
+{
+	BUG_ON(buffer->free);
+	BUG_ON(buffer->transaction != NULL);
+
+	if (binder_buf_cache_put(proc, buffer,
+				 binder_buffer_size(proc, buffer))) {
+		binder_debug(BINDER_DEBUG_BUFFER_ALLOC,
+			     "%d: binder_free_buf %p cached\n",
+			     proc->pid, buffer);
+		return;
+	}
+	__binder_free_buf(proc, buffer);
+}
+
 static struct binder_node *binder_get_node(struct binder_proc *proc,
 					   binder_uintptr_t ptr)
 {
@@ -902,6 +1466,7 @@ static struct binder_node *binder_new_node(struct binder_proc *proc,
 	node = kzalloc(sizeof(*node), GFP_KERNEL);
 	if (node == NULL)
 		return NULL;
+	node->lat = alloc_percpu(struct binder_lat_hist);
 	binder_stats_created(BINDER_STAT_NODE);
 	rb_link_node(&node->rb_node, parent, p);
 	rb_insert_color(&node->rb_node, &proc->nodes);
@@ -919,6 +1484,24 @@ static struct binder_node *binder_new_node(struct binder_proc *proc,
 	return node;
 }
 
+static void binder_init_node_priority(struct binder_node *node, __u32 flags)
+{
+	unsigned int policy;
+	int priority = (s8)(flags & FLAT_BINDER_FLAG_PRIORITY_MASK);
+
+	policy = (flags & FLAT_BINDER_FLAG_SCHED_POLICY_MASK) >>
+		FLAT_BINDER_FLAG_SCHED_POLICY_SHIFT;
+	if (is_rt_policy(policy))
+		priority = clamp(priority, 1, MAX_USER_RT_PRIO - 1);
+	else {
+		policy = SCHED_NORMAL;
+		priority = clamp(priority, MIN_NICE, MAX_NICE);
+	}
+	node->sched_policy = policy;
+	node->min_priority = to_kernel_prio(policy, priority);
+	node->inherit_rt = !!(flags & FLAT_BINDER_FLAG_INHERIT_RT);
+}
+
 static int binder_inc_node(struct binder_node *node, int strong, int internal,
 			   struct list_head *target_list)
 {
@@ -989,6 +1572,7 @@ static int binder_dec_node(struct binder_node *node, int strong, int internal)
 					     "dead node %d deleted\n",
 					     node->debug_id);
 			}
+			free_percpu(node->lat);
 			kfree(node);
 			binder_stats_deleted(BINDER_STAT_NODE);
 		}
@@ -1310,6 +1894,55 @@ static void binder_transaction_buffer_release(struct binder_proc *proc,
 	}
 }
 
+/*
+ * A oneway transaction flagged TF_UPDATE_TXN supersedes an older pending
+ * one from the same sender with the same code on the same node, e.g. a
+ * stream of state updates where only the latest matters.  The new
+ * transaction takes the old one's place in async_todo and the old buffer
+ * is released.  Transactions carrying objects are never coalesced.
+ */
+static bool binder_coalesce_async(struct binder_proc *target_proc,
+				  struct binder_node *node,
+				  struct binder_transaction *t)
+{
+	struct binder_work *w;
+	struct binder_transaction *t_old;
+	struct binder_async_sender *sender;
+
+	if (!(t->flags & TF_UPDATE_TXN) || t->buffer->offsets_size ||
+	    !t->buffer->async_pid)
+		return false;
+
+	list_for_each_entry(w, &node->async_todo, entry) {
+		if (w->type != BINDER_WORK_TRANSACTION)
+			continue;
+		t_old = container_of(w, struct binder_transaction, work);
+		if (!(t_old->flags & TF_UPDATE_TXN) ||
+		    t_old->code != t->code ||
+		    t_old->buffer->async_pid != t->buffer->async_pid ||
+		    t_old->buffer->offsets_size)
+			continue;
+
+		binder_debug(BINDER_DEBUG_TRANSACTION,
+			     "%d: transaction %d supersedes %d on node %d\n",
+			     target_proc->pid, t->debug_id, t_old->debug_id,
+			     node->debug_id);
+		list_replace(&t_old->work.entry, &t->work.entry);
+		sender = binder_find_async_sender(target_proc,
+						  t->buffer->async_pid);
+		if (sender)
+			sender->coalesced++;
+		binder_transaction_buffer_release(target_proc, t_old->buffer,
+						  NULL);
+		t_old->buffer->transaction = NULL;
+		binder_free_buf(target_proc, t_old->buffer);
+		kfree(t_old);
+		binder_stats_deleted(BINDER_STAT_TRANSACTION);
+		return true;
+	}
+	return false;
+}
+
 static void binder_transaction(struct binder_proc *proc,
 			       struct binder_thread *thread,
 			       struct binder_transaction_data *tr, int reply)
@@ -1323,6 +1956,7 @@ static void binder_transaction(struct binder_proc *proc,
 	struct binder_node *target_node = NULL;
 	struct list_head *target_list;
 	wait_queue_head_t *target_wait;
+	bool coalesced = false;
 	struct binder_transaction *in_reply_to = NULL;
 	struct binder_transaction_log_entry *e;
 	uint32_t return_error;
@@ -1343,7 +1977,7 @@ static void binder_transaction(struct binder_proc *proc,
 			return_error = BR_FAILED_REPLY;
 			goto err_empty_call_stack;
 		}
-		binder_set_nice(in_reply_to->saved_priority);
+		binder_set_priority(in_reply_to->saved_priority);
 		if (in_reply_to->to_thread != thread) {
 			binder_user_error("%d:%d got reply transaction with bad transaction stack, transaction %d has target %d:%d\n",
 				proc->pid, thread->pid, in_reply_to->debug_id,
@@ -1373,6 +2007,17 @@ static void binder_transaction(struct binder_proc *proc,
 			goto err_dead_binder;
 		}
 		target_proc = target_thread->proc;
+		if (in_reply_to->queued_ns) {
+			int bucket = binder_lat_bucket(ktime_get_ns() -
+						       in_reply_to->queued_ns);
+
+			binder_lat_reply(proc->lat, bucket);
+			if (in_reply_to->buffer &&
+			    in_reply_to->buffer->target_node)
+				binder_lat_reply(
+					in_reply_to->buffer->target_node->lat,
+					bucket);
+		}
 	} else {
 		if (tr->target.handle) {
 			struct binder_ref *ref;
@@ -1476,12 +2121,13 @@ static void binder_transaction(struct binder_proc *proc,
 	t->to_thread = target_thread;
 	t->code = tr->code;
 	t->flags = tr->flags;
-	t->priority = task_nice(current);
+	binder_get_priority(current, &t->priority);
 
 	trace_binder_transaction(reply, t, target_node);
 
 	t->buffer = binder_alloc_buf(target_proc, tr->data_size,
-		tr->offsets_size, !reply && (t->flags & TF_ONE_WAY));
+		tr->offsets_size, !reply && (t->flags & TF_ONE_WAY),
+		proc->pid);
 	if (t->buffer == NULL) {
 		return_error = BR_FAILED_REPLY;
 		goto err_binder_alloc_buf_failed;
@@ -1548,7 +2194,7 @@ static void binder_transaction(struct binder_proc *proc,
 					return_error = BR_FAILED_REPLY;
 					goto err_binder_new_node_failed;
 				}
-				node->min_priority = fp->flags & FLAT_BINDER_FLAG_PRIORITY_MASK;
+				binder_init_node_priority(node, fp->flags);
 				node->accept_fds = !!(fp->flags & FLAT_BINDER_FLAG_ACCEPTS_FDS);
 			}
 			if (fp->cookie != node->cookie) {
@@ -1694,11 +2340,15 @@ static void binder_transaction(struct binder_proc *proc,
 		if (target_node->has_async_transaction) {
 			target_list = &target_node->async_todo;
 			target_wait = NULL;
+			coalesced = binder_coalesce_async(target_proc,
+							  target_node, t);
 		} else
 			target_node->has_async_transaction = 1;
 	}
 	t->work.type = BINDER_WORK_TRANSACTION;
-	list_add_tail(&t->work.entry, target_list);
+	t->queued_ns = ktime_get_ns();
+	if (!coalesced)
+		list_add_tail(&t->work.entry, target_list);
 	tcomplete->type = BINDER_WORK_TRANSACTION_COMPLETE;
 	list_add_tail(&tcomplete->entry, &thread->todo);
 
@@ -2204,7 +2854,7 @@ retry:
 			wait_event_interruptible(binder_user_error_wait,
 						 binder_stop_on_user_error < 2);
 		}
-		binder_set_nice(proc->default_priority);
+		binder_set_priority(proc->default_priority);
 		if (non_block) {
 			if (!binder_has_proc_work(proc, thread))
 				ret = -EAGAIN;
@@ -2326,6 +2976,7 @@ retry:
 						     (u64)node->ptr,
 						     (u64)node->cookie);
 					rb_erase(&node->rb_node, &proc->nodes);
+					free_percpu(node->lat);
 					kfree(node);
 					binder_stats_deleted(BINDER_STAT_NODE);
 				} else {
@@ -2385,13 +3036,15 @@ retry:
 
 			tr.target.ptr = target_node->ptr;
 			tr.cookie =  target_node->cookie;
-			t->saved_priority = task_nice(current);
-			if (t->priority < target_node->min_priority &&
-			    !(t->flags & TF_ONE_WAY))
-				binder_set_nice(t->priority);
-			else if (!(t->flags & TF_ONE_WAY) ||
-				 t->saved_priority > target_node->min_priority)
-				binder_set_nice(target_node->min_priority);
+			binder_get_priority(current, &t->saved_priority);
+			binder_transaction_priority(t, target_node);
+			if (t->queued_ns) {
+				int bucket = binder_lat_bucket(ktime_get_ns() -
+							       t->queued_ns);
+
+				binder_lat_wait(proc->lat, bucket);
+				binder_lat_wait(target_node->lat, bucket);
+			}
 			cmd = BR_TRANSACTION;
 		} else {
 			tr.target.ptr = 0;
@@ -2747,6 +3400,17 @@ static long binder_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 	if (ret)
 		goto err_unlocked;
 
+	/* BINDER_VERSION touches no proc or thread state */
+	if (cmd == BINDER_VERSION) {
+		struct binder_version __user *ver = ubuf;
+
+		if (size != sizeof(struct binder_version) ||
+		    put_user(BINDER_CURRENT_PROTOCOL_VERSION,
+			     &ver->protocol_version))
+			ret = -EINVAL;
+		goto err_unlocked;
+	}
+
 	binder_lock(__func__);
 	thread = binder_get_thread(proc);
 	if (thread == NULL) {
@@ -2780,20 +3444,6 @@ static long binder_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 		binder_free_thread(proc, thread);
 		thread = NULL;
 		break;
-	case BINDER_VERSION: {
-		struct binder_version __user *ver = ubuf;
-
-		if (size != sizeof(struct binder_version)) {
-			ret = -EINVAL;
-			goto err;
-		}
-		if (put_user(BINDER_CURRENT_PROTOCOL_VERSION,
-			     &ver->protocol_version)) {
-			ret = -EINVAL;
-			goto err;
-		}
-		break;
-	}
 	default:
 		ret = -EINVAL;
 		goto err;
@@ -2949,6 +3599,7 @@ err_bad_arg:
 static int binder_open(struct inode *nodp, struct file *filp)
 {
 	struct binder_proc *proc;
+	int i;
 
 	binder_debug(BINDER_DEBUG_OPEN_CLOSE, "binder_open: %d:%d\n",
 		     current->group_leader->pid, current->pid);
@@ -2956,21 +3607,29 @@ static int binder_open(struct inode *nodp, struct file *filp)
 	proc = kzalloc(sizeof(*proc), GFP_KERNEL);
 	if (proc == NULL)
 		return -ENOMEM;
+	proc->lat = alloc_percpu(struct binder_lat_hist);
 	get_task_struct(current);
 	proc->tsk = current;
 	INIT_LIST_HEAD(&proc->todo);
+	for (i = 0; i < BINDER_BUF_CACHE_CLASSES; i++)
+		INIT_LIST_HEAD(&proc->buf_cache[i]);
+	proc->async_senders = RB_ROOT;
 	init_waitqueue_head(&proc->wait);
-	proc->default_priority = task_nice(current);
-
-	binder_lock(__func__);
-
-	binder_stats_created(BINDER_STAT_PROC);
-	hlist_add_head(&proc->proc_node, &binder_procs);
+	binder_get_priority(current, &proc->default_priority);
 	proc->pid = current->group_leader->pid;
 	INIT_LIST_HEAD(&proc->delivered_death);
 	filp->private_data = proc;
 
-	binder_unlock(__func__);
+	/*
+	 * A new proc is not reachable by other threads until it is on
+	 * binder_procs, so the global lock is not needed here.  The
+	 * BINDER_STAT_PROC created counter is only ever written under
+	 * binder_procs_lock.
+	 */
+	mutex_lock(&binder_procs_lock);
+	binder_stats_created(BINDER_STAT_PROC);
+	hlist_add_head(&proc->proc_node, &binder_procs);
+	mutex_unlock(&binder_procs_lock);
 
 	if (binder_debugfs_dir_entry_proc) {
 		char strbuf[11];
@@ -3032,6 +3691,7 @@ static int binder_node_release(struct binder_node *node, int refs)
 	binder_release_work(&node->async_todo);
 
 	if (hlist_empty(&node->refs)) {
+		free_percpu(node->lat);
 		kfree(node);
 		binder_stats_deleted(BINDER_STAT_NODE);
 
@@ -3077,7 +3737,9 @@ static void binder_deferred_release(struct binder_proc *proc)
 	BUG_ON(proc->vma);
 	BUG_ON(proc->files);
 
+	mutex_lock(&binder_procs_lock);
 	hlist_del(&proc->proc_node);
+	mutex_unlock(&binder_procs_lock);
 
 	if (binder_context_mgr_node && binder_context_mgr_node->proc == proc) {
 		binder_debug(BINDER_DEBUG_DEAD_BINDER,
@@ -3137,6 +3799,7 @@ static void binder_deferred_release(struct binder_proc *proc)
 		binder_free_buf(proc, buffer);
 		buffers++;
 	}
+	binder_free_async_senders(proc);
 
 	binder_stats_deleted(BINDER_STAT_PROC);
 
@@ -3169,6 +3832,7 @@ static void binder_deferred_release(struct binder_proc *proc)
 		     __func__, proc->pid, threads, nodes, incoming_refs,
 		     outgoing_refs, active_transactions, buffers, page_count);
 
+	free_percpu(proc->lat);
 	kfree(proc);
 }
 
@@ -3231,13 +3895,14 @@ static void print_binder_transaction(struct seq_file *m, const char *prefix,
 				     struct binder_transaction *t)
 {
 	seq_printf(m,
-		   "%s %d: %p from %d:%d to %d:%d code %x flags %x pri %ld r%d",
+		   "%s %d: %p from %d:%d to %d:%d code %x flags %x pri %d:%d r%d",
 		   prefix, t->debug_id, t,
 		   t->from ? t->from->proc->pid : 0,
 		   t->from ? t->from->pid : 0,
 		   t->to_proc ? t->to_proc->pid : 0,
 		   t->to_thread ? t->to_thread->pid : 0,
-		   t->code, t->flags, t->priority, t->need_reply);
+		   t->code, t->flags, t->priority.sched_policy,
+		   t->priority.prio, t->need_reply);
 	if (t->buffer == NULL) {
 		seq_puts(m, " buffer free\n");
 		return;
@@ -3391,6 +4056,16 @@ static void print_binder_proc(struct seq_file *m,
 	for (n = rb_first(&proc->allocated_buffers); n != NULL; n = rb_next(n))
 		print_binder_buffer(m, "  buffer",
 				    rb_entry(n, struct binder_buffer, rb_node));
+	for (n = rb_first(&proc->async_senders); n != NULL; n = rb_next(n)) {
+		struct binder_async_sender *sender =
+			rb_entry(n, struct binder_async_sender, rb_node);
+
+		if (print_all || sender->buffers || sender->refused)
+			seq_printf(m, "  async sender %d: used %zd buffers %d allocs %lu refused %lu coalesced %lu\n",
+				   sender->pid, sender->space_used,
+				   sender->buffers, sender->allocs,
+				   sender->refused, sender->coalesced);
+	}
 	list_for_each_entry(w, &proc->todo, entry)
 		print_binder_work(m, "  ", "  pending transaction", w);
 	list_for_each_entry(w, &proc->delivered_death, entry) {
@@ -3486,12 +4161,21 @@ static void print_binder_stats(struct seq_file *m, const char *prefix,
 	}
 }
 
+static void print_binder_lock_stats(struct seq_file *m)
+{
+	seq_printf(m, "lock: acquired %llu contended %d wait %llu us\n",
+		   binder_lock_stats.acquired,
+		   atomic_read(&binder_lock_stats.contended),
+		   div_u64(atomic64_read(&binder_lock_stats.wait_ns),
+			   NSEC_PER_USEC));
+}
+
 static void print_binder_proc_stats(struct seq_file *m,
 				    struct binder_proc *proc)
 {
 	struct binder_work *w;
 	struct rb_node *n;
-	int count, strong, weak;
+	int count, strong, weak, i;
 
 	seq_printf(m, "proc %d\n", proc->pid);
 	count = 0;
@@ -3524,6 +4208,11 @@ static void print_binder_proc_stats(struct seq_file *m,
 		count++;
 	seq_printf(m, "  buffers: %d\n", count);
 
+	count = 0;
+	for (i = 0; i < BINDER_BUF_CACHE_CLASSES; i++)
+		count += proc->buf_cache_count[i];
+	seq_printf(m, "  cached buffers: %d\n", count);
+
 	count = 0;
 	list_for_each_entry(w, &proc->todo, entry) {
 		switch (w->type) {
@@ -3556,8 +4245,10 @@ static int binder_state_show(struct seq_file *m, void *unused)
 	hlist_for_each_entry(node, &binder_dead_nodes, dead_node)
 		print_binder_node(m, node);
 
+	mutex_lock(&binder_procs_lock);
 	hlist_for_each_entry(proc, &binder_procs, proc_node)
 		print_binder_proc(m, proc, 1);
+	mutex_unlock(&binder_procs_lock);
 	if (do_lock)
 		binder_unlock(__func__);
 	return 0;
@@ -3574,9 +4265,14 @@ static int binder_stats_show(struct seq_file *m, void *unused)
 	seq_puts(m, "binder stats:\n");
 
 	print_binder_stats(m, "", &binder_stats);
+	print_binder_lock_stats(m);
+	seq_printf(m, "page pool: %d/%d\n", binder_page_pool.count,
+		   binder_page_pool_watermark);
 
+	mutex_lock(&binder_procs_lock);
 	hlist_for_each_entry(proc, &binder_procs, proc_node)
 		print_binder_proc_stats(m, proc);
+	mutex_unlock(&binder_procs_lock);
 	if (do_lock)
 		binder_unlock(__func__);
 	return 0;
@@ -3591,8 +4287,10 @@ static int binder_transactions_show(struct seq_file *m, void *unused)
 		binder_lock(__func__);
 
 	seq_puts(m, "binder transactions:\n");
+	mutex_lock(&binder_procs_lock);
 	hlist_for_each_entry(proc, &binder_procs, proc_node)
 		print_binder_proc(m, proc, 0);
+	mutex_unlock(&binder_procs_lock);
 	if (do_lock)
 		binder_unlock(__func__);
 	return 0;
@@ -3612,6 +4310,73 @@ static int binder_proc_show(struct seq_file *m, void *unused)
 	return 0;
 }
 
+static void print_binder_lat_hist(struct seq_file *m, const char *prefix,
+				  struct binder_lat_hist __percpu *hist)
+{
+	struct binder_lat_hist sum;
+	bool empty = true;
+	int cpu, i;
+
+	if (!hist)
+		return;
+
+	memset(&sum, 0, sizeof(sum));
+	for_each_possible_cpu(cpu) {
+		struct binder_lat_hist *h = per_cpu_ptr(hist, cpu);
+
+		for (i = 0; i < BINDER_LAT_BUCKETS; i++) {
+			sum.wait[i] += h->wait[i];
+			sum.reply[i] += h->reply[i];
+			if (h->wait[i] || h->reply[i])
+				empty = false;
+		}
+	}
+	if (empty)
+		return;
+
+	seq_printf(m, "%s  wait: ", prefix);
+	for (i = 0; i < BINDER_LAT_BUCKETS; i++)
+		seq_printf(m, " %u", sum.wait[i]);
+	seq_printf(m, "\n%s  reply:", prefix);
+	for (i = 0; i < BINDER_LAT_BUCKETS; i++)
+		seq_printf(m, " %u", sum.reply[i]);
+	seq_puts(m, "\n");
+}
+
+static int binder_latency_show(struct seq_file *m, void *unused)
+{
+	struct binder_proc *proc;
+	struct rb_node *n;
+	int do_lock = !binder_debug_no_lock;
+	int i;
+
+	if (do_lock)
+		binder_lock(__func__);
+
+	seq_puts(m, "binder latency (us):");
+	for (i = 0; i < BINDER_LAT_BUCKETS - 1; i++)
+		seq_printf(m, " <%u", 1U << i);
+	seq_puts(m, " more\n");
+
+	mutex_lock(&binder_procs_lock);
+	hlist_for_each_entry(proc, &binder_procs, proc_node) {
+		seq_printf(m, "proc %d\n", proc->pid);
+		print_binder_lat_hist(m, "", proc->lat);
+		for (n = rb_first(&proc->nodes); n != NULL; n = rb_next(n)) {
+			struct binder_node *node = rb_entry(n,
+					struct binder_node, rb_node);
+
+			seq_printf(m, "  node %d u%016llx\n", node->debug_id,
+				   (u64)node->ptr);
+			print_binder_lat_hist(m, "  ", node->lat);
+		}
+	}
+	mutex_unlock(&binder_procs_lock);
+	if (do_lock)
+		binder_unlock(__func__);
+	return 0;
+}
+
 static void print_binder_transaction_log_entry(struct seq_file *m,
 					struct binder_transaction_log_entry *e)
 {
@@ -3658,6 +4423,7 @@ BINDER_DEBUG_ENTRY(state);
 BINDER_DEBUG_ENTRY(stats);
 BINDER_DEBUG_ENTRY(transactions);
 BINDER_DEBUG_ENTRY(transaction_log);
+BINDER_DEBUG_ENTRY(latency);
 
 static int __init binder_init(void)
 {
@@ -3667,6 +4433,8 @@ static int __init binder_init(void)
 	if (!binder_deferred_workqueue)
 		return -ENOMEM;
 
+	schedule_work(&binder_page_pool_work);
+
 	binder_debugfs_dir_entry_root = debugfs_create_dir("binder", NULL);
 	if (binder_debugfs_dir_entry_root)
 		binder_debugfs_dir_entry_proc = debugfs_create_dir("proc",
@@ -3698,6 +4466,11 @@ static int __init binder_init(void)
 				    binder_debugfs_dir_entry_root,
 				    &binder_transaction_log_failed,
 				    &binder_transaction_log_fops);
+		debugfs_create_file("latency",
+				    S_IRUGO,
+				    binder_debugfs_dir_entry_root,
+				    NULL,
+				    &binder_latency_fops);
 	}
 	return ret;
 }
@@ -179,6 +179,13 @@ static void ion_buffer_add(struct ion_device *dev,
 	rb_insert_color(&buffer->node, &dev->buffers);
 }
 
+static void ion_heap_account_latency(struct ion_heap *heap, u64 delta_ns)
+{
+	int bucket = fls64(div_u64(delta_ns, NSEC_PER_USEC));
+
+	atomic_inc(&heap->alloc_lat[min(bucket, ION_HEAP_LAT_BUCKETS - 1)]);
+}
+
 /* this function should only be called while dev->lock is held */
 static struct ion_buffer *ion_buffer_create(struct ion_heap *heap,
 				     struct ion_device *dev,
@@ -190,6 +197,7 @@ static struct ion_buffer *ion_buffer_create(struct ion_heap *heap,
 	struct sg_table *table;
 	struct scatterlist *sg;
 	int i, ret;
+	u64 start;
 
 	buffer = kzalloc(sizeof(struct ion_buffer), GFP_KERNEL);
 	if (!buffer)
@@ -199,18 +207,29 @@ static struct ion_buffer *ion_buffer_create(struct ion_heap *heap,
 	buffer->flags = flags;
 	kref_init(&buffer->ref);
 
+	start = ktime_get_ns();
 	ret = heap->ops->allocate(heap, buffer, len, align, flags);
 
 	if (ret) {
 		if (!(heap->flags & ION_HEAP_FLAG_DEFER_FREE))
 			goto err2;
 
-		ion_heap_freelist_drain(heap, 0);
-		ret = heap->ops->allocate(heap, buffer, len, align,
-					  flags);
+		/*
+		 * Release only as much deferred memory as this allocation
+		 * needs before falling back to draining the whole list.
+		 */
+		if (ion_heap_freelist_drain(heap, len))
+			ret = heap->ops->allocate(heap, buffer, len, align,
+						  flags);
+		if (ret) {
+			ion_heap_freelist_drain(heap, 0);
+			ret = heap->ops->allocate(heap, buffer, len, align,
+						  flags);
+		}
 		if (ret)
 			goto err2;
 	}
+	ion_heap_account_latency(heap, ktime_get_ns() - start);
 
 	buffer->dev = dev;
 	buffer->size = len;
@@ -1704,6 +1723,8 @@ static int ion_debug_heap_show(struct seq_file *s, void *unused)
 	struct rb_node *n;
 	size_t total_size = 0;
 	size_t total_orphaned_size = 0;
+	char label[16];
+	int i;
 
 	seq_printf(s, "%16.s %16.s %16.s\n", "client", "pid", "size");
 	seq_puts(s, "----------------------------------------------------\n");
@@ -1755,6 +1776,20 @@ static int ion_debug_heap_show(struct seq_file *s, void *unused)
 				heap->free_list_size);
 	seq_puts(s, "----------------------------------------------------\n");
 
+	seq_puts(s, "allocation latency (us):\n");
+	for (i = 0; i < ION_HEAP_LAT_BUCKETS; i++) {
+		int count = atomic_read(&heap->alloc_lat[i]);
+
+		if (!count)
+			continue;
+		if (i == ION_HEAP_LAT_BUCKETS - 1)
+			snprintf(label, sizeof(label), ">=%u", 1U << (i - 1));
+		else
+			snprintf(label, sizeof(label), "<%u", 1U << i);
+		seq_printf(s, "%16s %16d\n", label, count);
+	}
+	seq_puts(s, "----------------------------------------------------\n");
+
 	if (heap->debug_show)
 		heap->debug_show(heap, s, unused);
 
@@ -20,6 +20,8 @@
 #include <linux/errno.h>
 #include <linux/err.h>
 #include <linux/dma-mapping.h>
+#include <linux/dma-contiguous.h>
+#include <linux/cma.h>
 #include <linux/msm_ion.h>
 
 #include <asm/cacheflush.h>
@@ -235,6 +237,26 @@ void ion_cma_heap_destroy(struct ion_heap *heap)
 	kfree(heap);
 }
 
+/*
+ * Migrate len bytes out of the heap's CMA area in the background, ahead
+ * of an allocation the caller expects soon (camera or secure playback
+ * start), so that the allocation itself does not wait on migration.
+ */
+int ion_cma_prefetch(struct ion_heap *heap, void *data)
+{
+	unsigned long len = (unsigned long)data;
+
+	cma_prefill(dev_get_cma_area(heap->priv),
+		    PAGE_ALIGN(len) >> PAGE_SHIFT);
+	return 0;
+}
+
+int ion_cma_drain(struct ion_heap *heap, void *unused)
+{
+	cma_prefill(dev_get_cma_area(heap->priv), 0);
+	return 0;
+}
+
 static void ion_secure_cma_free(struct ion_buffer *buffer)
 {
 	int ret = 0;
@@ -24,6 +24,7 @@
 #include <linux/scatterlist.h>
 #include <linux/vmalloc.h>
 #include <linux/slab.h>
+#include <linux/sizes.h>
 #include <linux/highmem.h>
 #include <linux/dma-mapping.h>
 #include "ion.h"
@@ -57,7 +58,8 @@ void *ion_heap_map_kernel(struct ion_heap *heap,
 		for (j = 0; j < npages_this_entry; j++)
 			*(tmp++) = page++;
 	}
-	vaddr = vmap(pages, npages, VM_MAP, pgprot);
+	/* small buffers are mapped from the per-cpu vmap blocks */
+	vaddr = vm_map_ram(pages, npages, -1, pgprot);
 	vfree(pages);
 
 	if (vaddr == NULL)
@@ -69,7 +71,7 @@ void *ion_heap_map_kernel(struct ion_heap *heap,
 void ion_heap_unmap_kernel(struct ion_heap *heap,
 			   struct ion_buffer *buffer)
 {
-	vunmap(buffer->vaddr);
+	vm_unmap_ram(buffer->vaddr, PAGE_ALIGN(buffer->size) / PAGE_SIZE);
 }
 
 int ion_heap_map_user(struct ion_heap *heap, struct ion_buffer *buffer,
@@ -226,27 +228,42 @@ size_t ion_heap_freelist_shrink(struct ion_heap *heap, size_t size)
 	return _ion_heap_freelist_drain(heap, size, true);
 }
 
+/*
+ * The deferred free thread lets small frees accumulate for up to
+ * ION_HEAP_DEFER_FREE_DELAY_MS, or until ION_HEAP_DEFER_FREE_BATCH bytes
+ * are queued, and then releases the whole list in one pass.  Memory that
+ * is needed sooner is reclaimed through the shrinker or the allocation
+ * retry in ion_buffer_create().
+ */
+#define ION_HEAP_DEFER_FREE_BATCH	SZ_4M
+#define ION_HEAP_DEFER_FREE_DELAY_MS	20
+
 static int ion_heap_deferred_free(void *data)
 {
 	struct ion_heap *heap = data;
 
 	while (true) {
-		struct ion_buffer *buffer;
+		struct ion_buffer *buffer, *tmp;
+		LIST_HEAD(batch);
 
 		wait_event_freezable(heap->waitqueue,
 				     ion_heap_freelist_size(heap) > 0);
 
+		if (ion_heap_freelist_size(heap) < ION_HEAP_DEFER_FREE_BATCH)
+			wait_event_freezable_timeout(heap->waitqueue,
+				ion_heap_freelist_size(heap) >=
+					ION_HEAP_DEFER_FREE_BATCH,
+				msecs_to_jiffies(ION_HEAP_DEFER_FREE_DELAY_MS));
+
 		spin_lock(&heap->free_lock);
-		if (list_empty(&heap->free_list)) {
-			spin_unlock(&heap->free_lock);
-			continue;
-		}
-		buffer = list_first_entry(&heap->free_list, struct ion_buffer,
-					  list);
-		list_del(&buffer->list);
-		heap->free_list_size -= buffer->size;
+		list_splice_init(&heap->free_list, &batch);
+		heap->free_list_size = 0;
 		spin_unlock(&heap->free_lock);
-		ion_buffer_destroy(buffer);
+
+		list_for_each_entry_safe(buffer, tmp, &batch, list) {
+			list_del(&buffer->list);
+			ion_buffer_destroy(buffer);
+		}
 	}
 
 	return 0;
@@ -25,6 +25,9 @@
 #include <linux/vmalloc.h>
 #include "ion_priv.h"
 
+/* per-cpu magazine size in units of order-0 pages */
+#define ION_PAGE_POOL_CPU_CACHE_PAGES	64
+
 static void *ion_page_pool_alloc_pages(struct ion_page_pool *pool)
 {
 	struct page *page;
@@ -74,6 +77,70 @@ static int ion_page_pool_add(struct ion_page_pool *pool, struct page *page,
 	return 0;
 }
 
+static void ion_page_pool_add_list(struct ion_page_pool *pool,
+				   struct list_head *pages)
+{
+	struct page *page, *tmp;
+
+	mutex_lock(&pool->mutex);
+	list_for_each_entry_safe(page, tmp, pages, lru) {
+		if (PageHighMem(page)) {
+			list_move_tail(&page->lru, &pool->high_items);
+			pool->high_count++;
+		} else {
+			list_move_tail(&page->lru, &pool->low_items);
+			pool->low_count++;
+		}
+		pool->nr_unreserved++;
+	}
+	mutex_unlock(&pool->mutex);
+}
+
+static struct page *ion_page_pool_cpu_get(struct ion_page_pool *pool)
+{
+	struct ion_page_pool_cpu_cache *cache;
+	struct page *page = NULL;
+
+	cache = get_cpu_ptr(pool->cpu_cache);
+	spin_lock(&cache->lock);
+	if (cache->count) {
+		page = list_first_entry(&cache->items, struct page, lru);
+		list_del(&page->lru);
+		cache->count--;
+	}
+	spin_unlock(&cache->lock);
+	put_cpu_ptr(pool->cpu_cache);
+
+	return page;
+}
+
+/*
+ * Puts @page into this cpu's magazine.  When the magazine is full a
+ * batch of its oldest items is moved to @spill for the caller to hand
+ * back to the shared lists.
+ */
+static void ion_page_pool_cpu_put(struct ion_page_pool *pool,
+				  struct page *page, struct list_head *spill)
+{
+	struct ion_page_pool_cpu_cache *cache;
+	int i;
+
+	cache = get_cpu_ptr(pool->cpu_cache);
+	spin_lock(&cache->lock);
+	list_add(&page->lru, &cache->items);
+	cache->count++;
+	if (cache->count > pool->cpu_cache_high) {
+		for (i = 0; i < pool->cpu_cache_batch; i++) {
+			page = list_last_entry(&cache->items, struct page,
+					       lru);
+			list_move(&page->lru, spill);
+			cache->count--;
+		}
+	}
+	spin_unlock(&cache->lock);
+	put_cpu_ptr(pool->cpu_cache);
+}
+
 static struct page *ion_page_pool_remove(struct ion_page_pool *pool, bool high,
 					bool prefetch)
 {
@@ -100,21 +167,54 @@ static struct page *ion_page_pool_remove(struct ion_page_pool *pool, bool high,
 	return page;
 }
 
+/*
+ * Takes one item for the caller and up to a batch more that are put in
+ * this cpu's magazine, all under a single acquisition of pool->mutex.
+ */
+static struct page *ion_page_pool_refill_cpu(struct ion_page_pool *pool)
+{
+	struct page *page = NULL, *extra, *tmp;
+	LIST_HEAD(batch);
+	LIST_HEAD(spill);
+	int i;
+
+	if (!mutex_trylock(&pool->mutex))
+		return NULL;
+	for (i = 0; i <= pool->cpu_cache_batch; i++) {
+		if (pool->high_count)
+			extra = ion_page_pool_remove(pool, true, false);
+		else if (pool->low_count)
+			extra = ion_page_pool_remove(pool, false, false);
+		else
+			break;
+		if (!page)
+			page = extra;
+		else
+			list_add_tail(&extra->lru, &batch);
+	}
+	mutex_unlock(&pool->mutex);
+
+	list_for_each_entry_safe(extra, tmp, &batch, lru) {
+		list_del(&extra->lru);
+		ion_page_pool_cpu_put(pool, extra, &spill);
+	}
+	if (!list_empty(&spill))
+		ion_page_pool_add_list(pool, &spill);
+
+	return page;
+}
+
 void *ion_page_pool_alloc(struct ion_page_pool *pool, bool *from_pool)
 {
-	struct page *page = NULL;
+	struct page *page;
 
 	BUG_ON(!pool);
 
 	*from_pool = true;
 
-	if (mutex_trylock(&pool->mutex)) {
-		if (pool->high_count)
-			page = ion_page_pool_remove(pool, true, false);
-		else if (pool->low_count)
-			page = ion_page_pool_remove(pool, false, false);
-		mutex_unlock(&pool->mutex);
-	}
+	page = ion_page_pool_cpu_get(pool);
+	if (!page)
+		page = ion_page_pool_refill_cpu(pool);
 	if (!page) {
 		page = ion_page_pool_alloc_pages(pool);
 		*from_pool = false;
@@ -122,6 +222,33 @@ void *ion_page_pool_alloc(struct ion_page_pool *pool, bool *from_pool)
 	return page;
 }
 
+/*
+ * Adds up to @nr_items freshly allocated, zeroed and cache-clean items to
+ * the pool.  Allocations never retry hard so that a background refill
+ * backs off as soon as memory gets tight.  Returns the number of items
+ * added.
+ */
+int ion_page_pool_fill(struct ion_page_pool *pool, int nr_items)
+{
+	struct page *page;
+	int i;
+
+	for (i = 0; i < nr_items; i++) {
+		page = alloc_pages((pool->gfp_mask & ~__GFP_ZERO) |
+				   __GFP_NORETRY | __GFP_NOWARN, pool->order);
+		if (!page)
+			break;
+		if (msm_ion_heap_high_order_page_zero(page, pool->order)) {
+			__free_pages(page, pool->order);
+			break;
+		}
+		ion_alloc_inc_usage(ION_TOTAL, 1 << pool->order);
+		ion_page_pool_alloc_set_cache_policy(pool, page);
+		ion_page_pool_add(pool, page, false);
+	}
+	return i;
+}
+
 void *ion_page_pool_prefetch(struct ion_page_pool *pool, bool *from_pool)
 {
 	struct page *page = NULL;
@@ -148,10 +275,14 @@ void *ion_page_pool_prefetch(struct ion_page_pool *pool, bool *from_pool)
  */
 void *ion_page_pool_alloc_pool_only(struct ion_page_pool *pool)
 {
-	struct page *page = NULL;
+	struct page *page;
 
 	BUG_ON(!pool);
 
+	page = ion_page_pool_cpu_get(pool);
+	if (page)
+		return page;
+
 	if (mutex_trylock(&pool->mutex)) {
 		if (pool->high_count)
 			page = ion_page_pool_remove(pool, true, false);
@@ -170,6 +301,16 @@ void ion_page_pool_free(struct ion_page_pool *pool, struct page *page,
 
 	BUG_ON(pool->order != compound_order(page));
 
+	/* prefetch reservations are only accounted on the shared lists */
+	if (!prefetch) {
+		LIST_HEAD(spill);
+
+		ion_page_pool_cpu_put(pool, page, &spill);
+		if (!list_empty(&spill))
+			ion_page_pool_add_list(pool, &spill);
+		return;
+	}
+
 	ret = ion_page_pool_add(pool, page, prefetch);
 	/* FIXME? For a secure page, not hyp unassigned in this err path */
 	if (ret)
@@ -181,6 +322,37 @@ void ion_page_pool_free_immediate(struct ion_page_pool *pool, struct page *page)
 	ion_page_pool_free_pages(pool, page);
 }
 
+int ion_page_pool_cpu_cache_count(struct ion_page_pool *pool)
+{
+	int cpu, count = 0;
+
+	for_each_possible_cpu(cpu)
+		count += per_cpu_ptr(pool->cpu_cache, cpu)->count;
+
+	return count;
+}
+
+/*
+ * Moves every item held in the per-cpu magazines back to the shared
+ * lists so that the shrinker and the secure pool teardown can see them.
+ */
+void ion_page_pool_drain_cpu_caches(struct ion_page_pool *pool)
+{
+	struct ion_page_pool_cpu_cache *cache;
+	LIST_HEAD(pages);
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		cache = per_cpu_ptr(pool->cpu_cache, cpu);
+		spin_lock(&cache->lock);
+		list_splice_init(&cache->items, &pages);
+		cache->count = 0;
+		spin_unlock(&cache->lock);
+	}
+	if (!list_empty(&pages))
+		ion_page_pool_add_list(pool, &pages);
+}
+
 int ion_page_pool_total(struct ion_page_pool *pool, bool high)
 {
 	int count = pool->low_count;
@@ -188,6 +360,9 @@ int ion_page_pool_total(struct ion_page_pool *pool, bool high)
 	if (high)
 		count += pool->high_count;
 
+	/* magazines are drained before shrinking, so count them too */
+	count += ion_page_pool_cpu_cache_count(pool);
+
 	return count << pool->order;
 }
 
@@ -205,6 +380,8 @@ int ion_page_pool_shrink(struct ion_page_pool *pool, gfp_t gfp_mask,
 	if (nr_to_scan == 0)
 		return ion_page_pool_total(pool, high);
 
+	ion_page_pool_drain_cpu_caches(pool);
+
 	while (freed < nr_to_scan) {
 		struct page *page;
 
@@ -229,8 +406,25 @@ struct ion_page_pool *ion_page_pool_create(gfp_t gfp_mask, unsigned int order)
 {
 	struct ion_page_pool *pool = kmalloc(sizeof(struct ion_page_pool),
 					     GFP_KERNEL);
+	int cpu;
+
 	if (!pool)
 		return NULL;
+	pool->cpu_cache = alloc_percpu(struct ion_page_pool_cpu_cache);
+	if (!pool->cpu_cache) {
+		kfree(pool);
+		return NULL;
+	}
+	for_each_possible_cpu(cpu) {
+		struct ion_page_pool_cpu_cache *cache;
+
+		cache = per_cpu_ptr(pool->cpu_cache, cpu);
+		spin_lock_init(&cache->lock);
+		cache->count = 0;
+		INIT_LIST_HEAD(&cache->items);
+	}
+	pool->cpu_cache_high = max(ION_PAGE_POOL_CPU_CACHE_PAGES >> order, 1);
+	pool->cpu_cache_batch = max(pool->cpu_cache_high / 2, 1);
 	pool->high_count = 0;
 	pool->low_count = 0;
 	pool->nr_unreserved = 0;
@@ -246,6 +440,7 @@ struct ion_page_pool *ion_page_pool_create(gfp_t gfp_mask, unsigned int order)
 
 void ion_page_pool_destroy(struct ion_page_pool *pool)
 {
+	free_percpu(pool->cpu_cache);
 	kfree(pool);
 }
 
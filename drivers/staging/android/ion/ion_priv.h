@@ -157,6 +157,8 @@ struct ion_heap_ops {
  */
 #define ION_PRIV_FLAG_SHRINKER_FREE (1 << 0)
 
+#define ION_HEAP_LAT_BUCKETS	20
+
 /**
  * struct ion_heap - represents a heap in the system
  * @node:		rb node to put the heap on the device's tree of heaps
@@ -177,6 +179,8 @@ struct ion_heap_ops {
  * @task:		task struct of deferred free thread
  * @debug_show:		called when heap debug file is read to add any
  *			heap specific debug info to output
+ * @alloc_lat:		log2 histogram of allocation latency, bucket i
+ *			counts allocations that took less than 2^i us
  *
  * Represents a pool of memory from which buffers can be made.  In some
  * systems the only heap is regular system memory allocated via vmalloc.
@@ -202,6 +206,7 @@ struct ion_heap {
 	int (*debug_show)(struct ion_heap *heap, struct seq_file *, void *);
 	atomic_t total_allocated;
 	atomic_t total_handles;
+	atomic_t alloc_lat[ION_HEAP_LAT_BUCKETS];
 };
 
 /**
@@ -421,6 +426,10 @@ void ion_carveout_free(struct ion_heap *heap, ion_phys_addr_t addr,
  * @gfp_mask:		gfp_mask to use from alloc
  * @order:		order of pages in the pool
  * @list:		plist node for list of pools
+ * @cpu_cache:		per-cpu magazines of pages in front of the shared lists
+ * @cpu_cache_high:	max number of items held in one cpu's magazine
+ * @cpu_cache_batch:	number of items moved between a magazine and the
+ *			shared lists at once
  *
  * Allows you to keep a pool of pre allocated pages to use from your heap.
  * Keeping a pool of pages that is ready for dma, ie any cached mapping have
@@ -437,6 +446,22 @@ struct ion_page_pool {
 	gfp_t gfp_mask;
 	unsigned int order;
 	struct plist_node list;
+	struct ion_page_pool_cpu_cache __percpu *cpu_cache;
+	int cpu_cache_high;
+	int cpu_cache_batch;
+};
+
+/**
+ * struct ion_page_pool_cpu_cache - per-cpu front cache of a page pool
+ * @lock:		protects the magazine; only contended while the
+ *			shrinker drains remote cpus
+ * @count:		number of items in the magazine
+ * @items:		list of items
+ */
+struct ion_page_pool_cpu_cache {
+	spinlock_t lock;
+	int count;
+	struct list_head items;
 };
 
 struct ion_page_pool *ion_page_pool_create(gfp_t gfp_mask, unsigned int order);
@@ -446,7 +471,10 @@ void *ion_page_pool_alloc_pool_only(struct ion_page_pool *);
 void ion_page_pool_free(struct ion_page_pool *, struct page *, bool prefetch);
 void ion_page_pool_free_immediate(struct ion_page_pool *, struct page *);
 int ion_page_pool_total(struct ion_page_pool *pool, bool high);
+int ion_page_pool_cpu_cache_count(struct ion_page_pool *pool);
+void ion_page_pool_drain_cpu_caches(struct ion_page_pool *pool);
 void *ion_page_pool_prefetch(struct ion_page_pool *pool, bool *from_pool);
+int ion_page_pool_fill(struct ion_page_pool *pool, int nr_items);
 
 #ifdef CONFIG_ION_POOL_CACHE_POLICY
 static inline void ion_page_pool_alloc_set_cache_policy
@@ -18,13 +18,18 @@
 #include <asm/page.h>
 #include <linux/dma-mapping.h>
 #include <linux/err.h>
+#include <linux/freezer.h>
 #include <linux/highmem.h>
+#include <linux/kthread.h>
 #include <linux/mm.h>
+#include <linux/module.h>
 #include <linux/msm_ion.h>
 #include <linux/scatterlist.h>
 #include <linux/seq_file.h>
+#include <linux/sizes.h>
 #include <linux/slab.h>
 #include <linux/vmalloc.h>
+#include <linux/vmpressure.h>
 #include "ion.h"
 #include "ion_priv.h"
 #include <linux/dma-mapping.h>
@@ -42,7 +47,23 @@ static const unsigned int orders[] = {9, 8, 4, 0};
 static const unsigned int orders[] = {0};
 #endif
 
-static const int num_orders = ARRAY_SIZE(orders);
+#define NUM_ORDERS ARRAY_SIZE(orders)
+
+static const int num_orders = NUM_ORDERS;
+
+/*
+ * The refill thread keeps every uncached pool above pool_refill_low_kb,
+ * topping it up to twice that, and stays idle for a second after
+ * vmpressure reports pool_refill_max_pressure or more.
+ */
+static unsigned int pool_refill_low_kb = 4096;
+module_param(pool_refill_low_kb, uint, S_IRUGO | S_IWUSR);
+
+static unsigned int pool_refill_max_pressure = 60;
+module_param(pool_refill_max_pressure, uint, S_IRUGO | S_IWUSR);
+
+#define POOL_REFILL_BATCH	16
+
 static int order_to_index(unsigned int order)
 {
 	int i;
@@ -63,8 +84,37 @@ struct ion_system_heap {
 	struct ion_page_pool **uncached_pools;
 	struct ion_page_pool **cached_pools;
 	struct ion_page_pool **secure_pools[VMID_LAST];
+	struct task_struct *refill_task;
+	wait_queue_head_t refill_wait;
+	bool refill_pending;
+	unsigned long pressure_jiffies;
+	struct notifier_block vmpressure_nb;
+	atomic_t pool_hits[NUM_ORDERS];
+	atomic_t pool_misses[NUM_ORDERS];
 };
 
+static int pool_refill_low_items(unsigned int order)
+{
+	return ((unsigned long)pool_refill_low_kb * SZ_1K) >>
+		(PAGE_SHIFT + order);
+}
+
+static int pool_items(struct ion_page_pool *pool)
+{
+	return ion_page_pool_total(pool, true) >> pool->order;
+}
+
+static void ion_system_heap_kick_refill(struct ion_system_heap *heap,
+					struct ion_page_pool *pool)
+{
+	if (!heap->refill_task || heap->refill_pending)
+		return;
+	if (pool_items(pool) >= pool_refill_low_items(pool->order))
+		return;
+	heap->refill_pending = true;
+	wake_up(&heap->refill_wait);
+}
+
 struct page_info {
 	struct page *page;
 	bool from_pool;
@@ -95,11 +145,20 @@ static struct page *alloc_buffer_page(struct ion_system_heap *heap,
 			page = ion_page_pool_prefetch(pool, from_pool);
 		else
 			page = ion_page_pool_alloc(pool, from_pool);
+
+		trace_ion_system_heap_page(order, *from_pool, cached);
+		if (*from_pool)
+			atomic_inc(&heap->pool_hits[order_to_index(order)]);
+		else
+			atomic_inc(&heap->pool_misses[order_to_index(order)]);
+		if (vmid <= 0 && !cached)
+			ion_system_heap_kick_refill(heap, pool);
 	} else {
 		gfp_t gfp_mask = low_order_gfp_flags;
 		if (order)
 			gfp_mask = high_order_gfp_flags;
 		page = alloc_pages(gfp_mask, order);
+		trace_ion_system_heap_page(order, false, cached);
 	}
 	if (!page)
 		return 0;
@@ -255,6 +314,7 @@ static int ion_system_heap_allocate(struct ion_heap *heap,
 		i++;
 	}
 
+	trace_ion_heap_sg_build_start(heap->name, size);
 	ret = msm_ion_heap_alloc_pages_mem(&data);
 
 	if (ret)
@@ -306,8 +366,11 @@ static int ion_system_heap_allocate(struct ion_heap *heap,
 		sg = sg_next(sg);
 
 	} while (sg);
+	trace_ion_heap_sg_build_end(heap->name, size);
 
+	trace_ion_heap_zero_start(heap->name, data.size);
 	ret = msm_ion_heap_pages_zero(data.pages, data.size >> PAGE_SHIFT);
+	trace_ion_heap_zero_end(heap->name, data.size);
 	if (ret) {
 		pr_err("Unable to zero pages\n");
 		goto err_free_sg2;
@@ -417,6 +480,8 @@ static int ion_secure_page_pool_shrink(
 	if (nr_to_scan == 0)
 		return ion_page_pool_total(pool, true);
 
+	ion_page_pool_drain_cpu_caches(pool);
+
 	while (freed < nr_to_scan) {
 		page = ion_page_pool_alloc_pool_only(pool);
 		if (!page)
@@ -545,12 +610,19 @@ static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 				pool->low_count, pool->order,
 				(1 << pool->order) * PAGE_SIZE *
 					pool->low_count);
+			seq_printf(s,
+				"%d order %u pages in uncached per-cpu caches = %lu total\n",
+				ion_page_pool_cpu_cache_count(pool), pool->order,
+				(1 << pool->order) * PAGE_SIZE *
+					ion_page_pool_cpu_cache_count(pool));
 		}
 
 		uncached_total += (1 << pool->order) * PAGE_SIZE *
 			pool->high_count;
 		uncached_total += (1 << pool->order) * PAGE_SIZE *
 			pool->low_count;
+		uncached_total += (1 << pool->order) * PAGE_SIZE *
+			ion_page_pool_cpu_cache_count(pool);
 	}
 
 	for (i = 0; i < num_orders; i++) {
@@ -565,12 +637,19 @@ static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 				pool->low_count, pool->order,
 				(1 << pool->order) * PAGE_SIZE *
 					pool->low_count);
+			seq_printf(s,
+				"%d order %u pages in cached per-cpu caches = %lu total\n",
+				ion_page_pool_cpu_cache_count(pool), pool->order,
+				(1 << pool->order) * PAGE_SIZE *
+					ion_page_pool_cpu_cache_count(pool));
 		}
 
 		cached_total += (1 << pool->order) * PAGE_SIZE *
 			pool->high_count;
 		cached_total += (1 << pool->order) * PAGE_SIZE *
 			pool->low_count;
+		cached_total += (1 << pool->order) * PAGE_SIZE *
+			ion_page_pool_cpu_cache_count(pool);
 	}
 
 	for (i = 0; i < num_orders; i++) {
@@ -602,6 +681,11 @@ static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 
 
 	if (use_seq) {
+		for (i = 0; i < num_orders; i++)
+			seq_printf(s, "order %u pool hits %d misses %d\n",
+				   orders[i],
+				   atomic_read(&sys_heap->pool_hits[i]),
+				   atomic_read(&sys_heap->pool_misses[i]));
 		seq_puts(s, "--------------------------------------------\n");
 		seq_printf(s, "uncached pool = %lu cached pool = %lu secure pool = %lu\n",
 				uncached_total, cached_total, secure_total);
@@ -621,6 +705,66 @@ static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 }
 
 
+static bool ion_system_heap_under_pressure(struct ion_system_heap *heap)
+{
+	return time_before(jiffies, heap->pressure_jiffies + HZ);
+}
+
+static void ion_system_heap_refill_pools(struct ion_system_heap *heap)
+{
+	struct ion_page_pool *pool;
+	int i, low, deficit, added;
+
+	for (i = 0; i < num_orders; i++) {
+		pool = heap->uncached_pools[i];
+		low = pool_refill_low_items(pool->order);
+		if (pool_items(pool) >= low)
+			continue;
+
+		deficit = 2 * low - pool_items(pool);
+		while (deficit > 0) {
+			if (ion_system_heap_under_pressure(heap) ||
+			    kthread_should_stop())
+				return;
+			added = ion_page_pool_fill(pool,
+					min(deficit, POOL_REFILL_BATCH));
+			if (!added)
+				break;
+			deficit -= added;
+			cond_resched();
+		}
+	}
+}
+
+static int ion_system_heap_refill_thread(void *data)
+{
+	struct ion_system_heap *heap = data;
+
+	while (!kthread_should_stop()) {
+		wait_event_freezable(heap->refill_wait,
+				     heap->refill_pending ||
+				     kthread_should_stop());
+		if (kthread_should_stop())
+			break;
+		ion_system_heap_refill_pools(heap);
+		heap->refill_pending = false;
+	}
+
+	return 0;
+}
+
+static int ion_system_heap_vmpressure(struct notifier_block *nb,
+				      unsigned long action, void *data)
+{
+	struct ion_system_heap *heap = container_of(nb,
+						    struct ion_system_heap,
+						    vmpressure_nb);
+
+	if (action >= pool_refill_max_pressure)
+		heap->pressure_jiffies = jiffies;
+	return 0;
+}
+
 static void ion_system_heap_destroy_pools(struct ion_page_pool **pools)
 {
 	int i;
@@ -694,6 +838,21 @@ struct ion_heap *ion_system_heap_create(struct ion_platform_heap *unused)
 		goto err_create_cached_pools;
 
 	heap->heap.debug_show = ion_system_heap_debug_show;
+
+	init_waitqueue_head(&heap->refill_wait);
+	heap->pressure_jiffies = jiffies - HZ;
+	heap->vmpressure_nb.notifier_call = ion_system_heap_vmpressure;
+	vmpressure_notifier_register(&heap->vmpressure_nb);
+	heap->refill_task = kthread_run(ion_system_heap_refill_thread, heap,
+					"ion_pool_refill");
+	if (IS_ERR(heap->refill_task)) {
+		pr_err("%s: creating pool refill thread failed\n", __func__);
+		heap->refill_task = NULL;
+	} else {
+		set_user_nice(heap->refill_task, 10);
+		heap->refill_pending = true;
+		wake_up(&heap->refill_wait);
+	}
 	return &heap->heap;
 
 err_create_cached_pools:
@@ -721,6 +880,10 @@ void ion_system_heap_destroy(struct ion_heap *heap)
 							heap);
 	int i, j;
 
+	if (sys_heap->refill_task)
+		kthread_stop(sys_heap->refill_task);
+	vmpressure_notifier_unregister(&sys_heap->vmpressure_nb);
+
 	for (i = 0; i < VMID_LAST; i++) {
 		if (!is_secure_vmid_valid(i))
 			continue;
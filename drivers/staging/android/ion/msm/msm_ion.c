@@ -789,6 +789,20 @@ long msm_ion_custom_ioctl(struct ion_client *client,
 			ion_system_secure_heap_prefetch);
 		if (ret)
 			return ret;
+
+		ret = ion_walk_heaps(client, data.prefetch_data.heap_id,
+			ION_HEAP_TYPE_DMA,
+			(void *)data.prefetch_data.len,
+			ion_cma_prefetch);
+		if (ret)
+			return ret;
+
+		ret = ion_walk_heaps(client, data.prefetch_data.heap_id,
+			ION_HEAP_TYPE_HYP_CMA,
+			(void *)data.prefetch_data.len,
+			ion_cma_prefetch);
+		if (ret)
+			return ret;
 		break;
 	}
 	case ION_IOC_DRAIN:
@@ -800,6 +814,16 @@ long msm_ion_custom_ioctl(struct ion_client *client,
 			(void *)data.prefetch_data.len,
 			ion_secure_cma_drain_pool);
 
+		if (ret)
+			return ret;
+
+		ret = ion_walk_heaps(client, data.prefetch_data.heap_id,
+			ION_HEAP_TYPE_DMA, NULL, ion_cma_drain);
+		if (ret)
+			return ret;
+
+		ret = ion_walk_heaps(client, data.prefetch_data.heap_id,
+			ION_HEAP_TYPE_HYP_CMA, NULL, ion_cma_drain);
 		if (ret)
 			return ret;
 		break;
@@ -0,0 +1,255 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/*
+ * Times ION allocations from one heap at one size, on demand from debugfs:
+ *
+ *	echo "<heap_id> <size> <flags> <iters>" > msm_ion_bench/run
+ *	cat msm_ion_bench/run
+ *
+ * Each iteration allocates a buffer, maps it into the kernel, unmaps it
+ * and frees it, timing every step on its own. Buffers are not touched, so
+ * the alloc latency includes the zeroing done by the heap but no faults. The
+ * map step is skipped for heaps that cannot be mapped, e.g. secure ones.
+ * Page pools are not drained between iterations; the first, untimed,
+ * iteration fills them the way steady state use would.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/err.h>
+#include <linux/msm_ion.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/sort.h>
+#include <linux/ktime.h>
+#include <linux/sizes.h>
+#include <linux/mutex.h>
+#include <linux/debugfs.h>
+#include <linux/uaccess.h>
+
+#define ION_BENCH_MAX_SIZE	SZ_64M
+#define ION_BENCH_MAX_ITERS	4096
+#define ION_BENCH_RESULT_BUF	512
+
+enum ion_bench_step {
+	ION_BENCH_ALLOC,
+	ION_BENCH_MAP,
+	ION_BENCH_FREE,
+	ION_BENCH_STEPS,
+};
+
+static const char * const ion_bench_step_name[ION_BENCH_STEPS] = {
+	[ION_BENCH_ALLOC] = "alloc",
+	[ION_BENCH_MAP] = "map",
+	[ION_BENCH_FREE] = "free",
+};
+
+static struct dentry *ion_bench_dent;
+static struct ion_client *ion_bench_client;
+static DEFINE_MUTEX(ion_bench_mutex);
+static char ion_bench_result[ION_BENCH_RESULT_BUF];
+
+static int ion_bench_u32_cmp(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static u32 ion_bench_elapsed(ktime_t start)
+{
+	return ktime_to_ns(ktime_sub(ktime_get(), start));
+}
+
+/*
+ * One alloc, map, unmap and free cycle. The unmap is counted towards the
+ * free, as a client dropping a mapped buffer pays for both.
+ */
+static int ion_bench_one(unsigned int heap_id, size_t size,
+			 unsigned int flags, bool map, u32 *lat)
+{
+	struct ion_handle *handle;
+	ktime_t start;
+	void *vaddr;
+
+	lat[ION_BENCH_MAP] = 0;
+	start = ktime_get();
+	handle = ion_alloc(ion_bench_client, size, SZ_4K, ION_HEAP(heap_id),
+			   flags);
+	lat[ION_BENCH_ALLOC] = ion_bench_elapsed(start);
+	if (IS_ERR_OR_NULL(handle))
+		return handle ? PTR_ERR(handle) : -ENOMEM;
+
+	if (map) {
+		start = ktime_get();
+		vaddr = ion_map_kernel(ion_bench_client, handle);
+		lat[ION_BENCH_MAP] = ion_bench_elapsed(start);
+		if (IS_ERR_OR_NULL(vaddr)) {
+			ion_free(ion_bench_client, handle);
+			return vaddr ? PTR_ERR(vaddr) : -ENOMEM;
+		}
+	}
+
+	start = ktime_get();
+	if (map)
+		ion_unmap_kernel(ion_bench_client, handle);
+	ion_free(ion_bench_client, handle);
+	lat[ION_BENCH_FREE] = ion_bench_elapsed(start);
+
+	return 0;
+}
+
+static int ion_bench_exec(unsigned int heap_id, size_t size,
+			  unsigned int flags, unsigned int iters)
+{
+	u32 *lat[ION_BENCH_STEPS] = { NULL };
+	u32 one[ION_BENCH_STEPS];
+	bool map = !(flags & ION_FLAG_SECURE);
+	unsigned int i, s;
+	int len, ret;
+
+	/* untimed, fills the pools and finds out whether the heap maps */
+	ret = ion_bench_one(heap_id, size, flags, map, one);
+	if (ret && map) {
+		map = false;
+		ret = ion_bench_one(heap_id, size, flags, map, one);
+	}
+	if (ret)
+		goto out;
+
+	ret = -ENOMEM;
+	for (s = 0; s < ION_BENCH_STEPS; s++) {
+		lat[s] = vzalloc(iters * sizeof(u32));
+		if (!lat[s])
+			goto out;
+	}
+
+	for (i = 0; i < iters; i++) {
+		ret = ion_bench_one(heap_id, size, flags, map, one);
+		if (ret)
+			goto out;
+		for (s = 0; s < ION_BENCH_STEPS; s++)
+			lat[s][i] = one[s];
+	}
+
+	len = scnprintf(ion_bench_result, sizeof(ion_bench_result),
+			"heap %u size %zu flags 0x%x iters %u mapped %d\n",
+			heap_id, size, flags, iters, map);
+	for (s = 0; s < ION_BENCH_STEPS; s++) {
+		const char *name = ion_bench_step_name[s];
+		u32 *l = lat[s];
+
+		if (s == ION_BENCH_MAP && !map)
+			continue;
+		sort(l, iters, sizeof(u32), ion_bench_u32_cmp, NULL);
+		len += scnprintf(ion_bench_result + len,
+				 sizeof(ion_bench_result) - len,
+				 "%s_p50_ns %u %s_p90_ns %u %s_p99_ns %u %s_max_ns %u\n",
+				 name, l[iters / 2], name, l[iters * 9 / 10],
+				 name, l[iters * 99 / 100], name, l[iters - 1]);
+	}
+out:
+	if (ret)
+		scnprintf(ion_bench_result, sizeof(ion_bench_result),
+			  "heap %u size %zu error %d\n", heap_id, size, ret);
+	for (s = 0; s < ION_BENCH_STEPS; s++)
+		vfree(lat[s]);
+
+	return ret;
+}
+
+static ssize_t ion_bench_run_write(struct file *file, const char __user *ubuf,
+				   size_t count, loff_t *ppos)
+{
+	char buf[64];
+	unsigned int heap_id, flags, iters;
+	size_t size;
+	int ret;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sscanf(buf, "%u %zu %x %u", &heap_id, &size, &flags, &iters) != 4)
+		return -EINVAL;
+
+	if (heap_id >= ION_HEAP_ID_RESERVED || !size ||
+	    size > ION_BENCH_MAX_SIZE || !iters || iters > ION_BENCH_MAX_ITERS)
+		return -EINVAL;
+
+	mutex_lock(&ion_bench_mutex);
+	ret = ion_bench_exec(heap_id, PAGE_ALIGN(size), flags, iters);
+	mutex_unlock(&ion_bench_mutex);
+
+	return ret ? ret : count;
+}
+
+static ssize_t ion_bench_run_read(struct file *file, char __user *ubuf,
+				  size_t count, loff_t *ppos)
+{
+	ssize_t ret;
+
+	mutex_lock(&ion_bench_mutex);
+	ret = simple_read_from_buffer(ubuf, count, ppos, ion_bench_result,
+				      strlen(ion_bench_result));
+	mutex_unlock(&ion_bench_mutex);
+
+	return ret;
+}
+
+static const struct file_operations ion_bench_run_ops = {
+	.open = simple_open,
+	.read = ion_bench_run_read,
+	.write = ion_bench_run_write,
+};
+
+static int __init msm_ion_bench_init(void)
+{
+	ion_bench_client = msm_ion_client_create("msm_ion_bench");
+	if (IS_ERR_OR_NULL(ion_bench_client)) {
+		pr_err("msm_ion_bench: ion client create fail\n");
+		return -ENODEV;
+	}
+
+	ion_bench_dent = debugfs_create_dir("msm_ion_bench", NULL);
+	if (IS_ERR_OR_NULL(ion_bench_dent)) {
+		pr_err("msm_ion_bench: debugfs_create_dir fail, error %ld\n",
+		       PTR_ERR(ion_bench_dent));
+		ion_client_destroy(ion_bench_client);
+		return -ENODEV;
+	}
+
+	if (!debugfs_create_file("run", S_IRUSR | S_IWUSR, ion_bench_dent,
+				 NULL, &ion_bench_run_ops)) {
+		debugfs_remove_recursive(ion_bench_dent);
+		ion_client_destroy(ion_bench_client);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void __exit msm_ion_bench_exit(void)
+{
+	debugfs_remove_recursive(ion_bench_dent);
+	ion_client_destroy(ion_bench_client);
+}
+
+module_init(msm_ion_bench_init);
+module_exit(msm_ion_bench_exit);
+
+MODULE_LICENSE("GPL v2");
+MODULE_DESCRIPTION("MSM ION allocation latency benchmark");
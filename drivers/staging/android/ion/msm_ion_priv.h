@@ -74,6 +74,10 @@ int ion_secure_cma_prefetch(struct ion_heap *heap, void *data);
 
 int ion_secure_cma_drain_pool(struct ion_heap *heap, void *unused);
 
+int ion_cma_prefetch(struct ion_heap *heap, void *data);
+
+int ion_cma_drain(struct ion_heap *heap, void *unused);
+
 #else
 static inline int ion_secure_cma_prefetch(struct ion_heap *heap, void *data)
 {
@@ -85,6 +89,16 @@ static inline int ion_secure_cma_drain_pool(struct ion_heap *heap, void *unused)
 	return -ENODEV;
 }
 
+static inline int ion_cma_prefetch(struct ion_heap *heap, void *data)
+{
+	return -ENODEV;
+}
+
+static inline int ion_cma_drain(struct ion_heap *heap, void *unused)
+{
+	return -ENODEV;
+}
+
 
 
 #endif
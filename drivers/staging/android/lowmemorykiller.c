@@ -47,6 +47,7 @@
 #include <linux/cpuset.h>
 #include <linux/vmpressure.h>
 #include <linux/zcache.h>
+#include <linux/memstall.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/almk.h>
@@ -104,6 +105,19 @@ static int vmpressure_file_min;
 module_param_named(vmpressure_file_min, vmpressure_file_min, int,
 	S_IRUGO | S_IWUSR);
 
+/*
+ * Memory stall thresholds for the adaptive killer, in percent of the
+ * last 10s spent stalled on memory (see mm/memstall.c), 0 disables.
+ * Above stall_high it shifts min_score_adj as on critical vmpressure.
+ * Below stall_low tasks above adj_max_shift are spared, since reclaim
+ * keeps up even though the free and file counts are under minfree.
+ */
+static int lmk_stall_high;
+module_param_named(stall_high, lmk_stall_high, int, S_IRUGO | S_IWUSR);
+
+static int lmk_stall_low;
+module_param_named(stall_low, lmk_stall_low, int, S_IRUGO | S_IWUSR);
+
 enum {
 	VMPRESSURE_NO_ADJUST = 0,
 	VMPRESSURE_ADJUST_ENCROACH,
@@ -117,6 +131,9 @@ int adjust_minadj(short *min_score_adj)
 	if (!enable_adaptive_lmk)
 		return 0;
 
+	if (lmk_stall_high && memstall_avg10() >= lmk_stall_high)
+		atomic_set(&shift_adj, 1);
+
 	if (atomic_read(&shift_adj) &&
 		(*min_score_adj > adj_max_shift)) {
 		if (*min_score_adj == OOM_SCORE_ADJ_MAX + 1)
@@ -415,6 +432,15 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 
 	ret = adjust_minadj(&min_score_adj);
 
+	if (enable_adaptive_lmk && lmk_stall_low &&
+	    min_score_adj > adj_max_shift &&
+	    min_score_adj <= OOM_SCORE_ADJ_MAX &&
+	    memstall_avg10() < lmk_stall_low) {
+		lowmem_print(3, "Memory stall low, not killing above %hd\n",
+			     adj_max_shift);
+		min_score_adj = OOM_SCORE_ADJ_MAX + 1;
+	}
+
 	lowmem_print(3, "lowmem_scan %lu, %x, ofree %d %d, ma %hd\n",
 			sc->nr_to_scan, sc->gfp_mask, other_free,
 			other_file, min_score_adj);
@@ -145,6 +145,12 @@ void sync_timeline_signal(struct sync_timeline *obj)
 			list_del_init(pos);
 			list_add(&pt->signaled_list, &signaled_pts);
 			kref_get(&pt->fence->kref);
+		} else if (obj->ordered) {
+			/*
+			 * The active list is sorted and the points signal in
+			 * order so nothing behind this one can be done yet
+			 */
+			break;
 		}
 	}
 
@@ -226,7 +232,24 @@ static void sync_pt_activate(struct sync_pt *pt)
 	if (err != 0)
 		goto out;
 
-	list_add_tail(&pt->active_list, &obj->active_list_head);
+	if (obj->ordered) {
+		struct sync_pt *prev;
+
+		/*
+		 * Keep the list sorted so sync_timeline_signal() only has to
+		 * look at the expired points. New points are almost always
+		 * the latest on the timeline so search from the tail.
+		 */
+		list_for_each_entry_reverse(prev, &obj->active_list_head,
+				active_list) {
+			if (obj->ops->compare(prev, pt) <= 0)
+				break;
+		}
+
+		list_add(&pt->active_list, &prev->active_list);
+	} else {
+		list_add_tail(&pt->active_list, &obj->active_list_head);
+	}
 
 out:
 	spin_unlock_irqrestore(&obj->active_list_lock, flags);
@@ -300,25 +323,6 @@ struct sync_fence *sync_fence_create(const char *name, struct sync_pt *pt)
 }
 EXPORT_SYMBOL(sync_fence_create);
 
-static int sync_fence_copy_pts(struct sync_fence *dst, struct sync_fence *src)
-{
-	struct list_head *pos;
-
-	list_for_each(pos, &src->pt_list_head) {
-		struct sync_pt *orig_pt =
-			container_of(pos, struct sync_pt, pt_list);
-		struct sync_pt *new_pt = sync_pt_dup(orig_pt);
-
-		if (new_pt == NULL)
-			return -ENOMEM;
-
-		new_pt->fence = dst;
-		list_add(&new_pt->pt_list, &dst->pt_list_head);
-	}
-
-	return 0;
-}
-
 static int sync_fence_merge_pts(struct sync_fence *dst, struct sync_fence *src)
 {
 	struct list_head *src_pos, *dst_pos, *n;
@@ -446,7 +450,11 @@ struct sync_fence *sync_fence_merge(const char *name,
 	if (fence == NULL)
 		return NULL;
 
-	err = sync_fence_copy_pts(fence, a);
+	/*
+	 * Merge rather than copy the points of the first fence too so that
+	 * duplicate points on the same timeline collapse into the latest one
+	 */
+	err = sync_fence_merge_pts(fence, a);
 	if (err < 0)
 		goto err;
 
@@ -484,11 +492,11 @@ static void sync_fence_signal_pt(struct sync_pt *pt)
 	status = sync_fence_get_status(fence);
 
 	spin_lock_irqsave(&fence->waiter_list_lock, flags);
-	if (status && !fence->status) {
+	if (status && !atomic_read(&fence->status)) {
 		list_for_each_safe(pos, n, &fence->waiter_list_head)
 			list_move(pos, &signaled_waiters);
 
-		fence->status = status;
+		atomic_set(&fence->status, status);
 	} else {
 		status = 0;
 	}
@@ -515,10 +523,9 @@ int sync_fence_wait_async(struct sync_fence *fence,
 
 	spin_lock_irqsave(&fence->waiter_list_lock, flags);
 
-	if (fence->status) {
-		err = fence->status;
+	err = atomic_read(&fence->status);
+	if (err)
 		goto out;
-	}
 
 	list_add_tail(&waiter->waiter_list, &fence->waiter_list_head);
 out:
@@ -555,17 +562,25 @@ EXPORT_SYMBOL(sync_fence_cancel_async);
 static bool sync_fence_check(struct sync_fence *fence)
 {
 	smp_rmb();
-	return fence->status != 0;
+	return atomic_read(&fence->status) != 0;
 }
 
 int sync_fence_wait(struct sync_fence *fence, long timeout)
 {
 	int err = 0;
+	int status;
 	struct sync_pt *pt;
 
+	/* the status never changes once set, so signaled fences are free */
+	status = atomic_read(&fence->status);
+	if (status > 0)
+		return 0;
+
 	trace_sync_wait(fence, 1);
-	list_for_each_entry(pt, &fence->pt_list_head, pt_list)
-		trace_sync_pt(pt);
+	if (trace_sync_pt_enabled()) {
+		list_for_each_entry(pt, &fence->pt_list_head, pt_list)
+			trace_sync_pt(pt);
+	}
 
 	if (timeout > 0) {
 		timeout = msecs_to_jiffies(timeout);
@@ -581,13 +596,14 @@ int sync_fence_wait(struct sync_fence *fence, long timeout)
 	if (err < 0)
 		return err;
 
-	if (fence->status < 0) {
-		pr_info("fence error %d on [%p]\n", fence->status, fence);
+	status = atomic_read(&fence->status);
+	if (status < 0) {
+		pr_info("fence error %d on [%p]\n", status, fence);
 		sync_dump();
-		return fence->status;
+		return status;
 	}
 
-	if (fence->status == 0) {
+	if (status == 0) {
 		if (timeout > 0) {
 			pr_info("fence timeout on [%p] after %dms\n", fence,
 				jiffies_to_msecs(timeout));
@@ -628,14 +644,22 @@ static int sync_fence_release(struct inode *inode, struct file *file)
 static unsigned int sync_fence_poll(struct file *file, poll_table *wait)
 {
 	struct sync_fence *fence = file->private_data;
+	int status;
 
-	poll_wait(file, &fence->wq, wait);
-
-	smp_rmb();
+	/*
+	 * A fence only ever signals once, so there is no need to queue on
+	 * the waitqueue of one that already has.
+	 */
+	status = atomic_read(&fence->status);
+	if (!status) {
+		poll_wait(file, &fence->wq, wait);
+		smp_rmb();
+		status = atomic_read(&fence->status);
+	}
 
-	if (fence->status == 1)
+	if (status == 1)
 		return POLLIN;
-	else if (fence->status < 0)
+	else if (status < 0)
 		return POLLERR;
 	else
 		return 0;
@@ -651,6 +675,53 @@ static long sync_fence_ioctl_wait(struct sync_fence *fence, unsigned long arg)
 	return sync_fence_wait(fence, value);
 }
 
+static long sync_fence_ioctl_wait_multi(unsigned long arg)
+{
+	struct sync_wait_multi_data data;
+	__s32 fds[SYNC_WAIT_MULTI_MAX];
+	struct sync_fence *fence;
+	unsigned long deadline = 0;
+	long timeout;
+	long ret = 0;
+	__u32 i;
+
+	if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
+		return -EFAULT;
+
+	if (!data.count || data.count > SYNC_WAIT_MULTI_MAX)
+		return -EINVAL;
+
+	if (copy_from_user(fds, (void __user *)(unsigned long)data.fds,
+			   data.count * sizeof(fds[0])))
+		return -EFAULT;
+
+	if (data.timeout > 0)
+		deadline = jiffies + msecs_to_jiffies(data.timeout);
+
+	/*
+	 * Waiting for each fence in turn against one deadline is as good as
+	 * waiting for all of them at once, and most are usually signaled by
+	 * the time we get to them.
+	 */
+	for (i = 0; i < data.count; i++) {
+		fence = sync_fence_fdget(fds[i]);
+		if (fence == NULL)
+			return -ENOENT;
+
+		timeout = data.timeout;
+		if (data.timeout > 0)
+			timeout = time_before(jiffies, deadline) ?
+				jiffies_to_msecs(deadline - jiffies) : 0;
+
+		ret = sync_fence_wait(fence, timeout);
+		sync_fence_put(fence);
+		if (ret < 0)
+			break;
+	}
+
+	return ret;
+}
+
 static long sync_fence_ioctl_merge(struct sync_fence *fence, unsigned long arg)
 {
 	int fd = get_unused_fd_flags(O_CLOEXEC);
@@ -751,7 +822,7 @@ static long sync_fence_ioctl_fence_info(struct sync_fence *fence,
 		return -ENOMEM;
 
 	strlcpy(data->name, fence->name, sizeof(data->name));
-	data->status = fence->status;
+	data->status = atomic_read(&fence->status);
 	len = sizeof(struct sync_fence_info_data);
 
 	list_for_each(pos, &fence->pt_list_head) {
@@ -788,6 +859,9 @@ static long sync_fence_ioctl(struct file *file, unsigned int cmd,
 	case SYNC_IOC_WAIT:
 		return sync_fence_ioctl_wait(fence, arg);
 
+	case SYNC_IOC_WAIT_MULTI:
+		return sync_fence_ioctl_wait_multi(arg);
+
 	case SYNC_IOC_MERGE:
 		return sync_fence_ioctl_merge(fence, arg);
 
@@ -877,7 +951,7 @@ static void sync_print_fence(struct seq_file *s, struct sync_fence *fence)
 	unsigned long flags;
 
 	seq_printf(s, "[%p] %s: %s\n", fence, fence->name,
-		   sync_status_str(fence->status));
+		   sync_status_str(atomic_read(&fence->status)));
 
 	list_for_each(pos, &fence->pt_list_head) {
 		struct sync_pt *pt =
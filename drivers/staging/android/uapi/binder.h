@@ -37,6 +37,15 @@ enum {
 enum {
 	FLAT_BINDER_FLAG_PRIORITY_MASK = 0xff,
 	FLAT_BINDER_FLAG_ACCEPTS_FDS = 0x100,
+	/*
+	 * Scheduling policy (SCHED_NORMAL, SCHED_FIFO or SCHED_RR) that
+	 * FLAT_BINDER_FLAG_PRIORITY_MASK applies to.  For SCHED_NORMAL the
+	 * priority is a signed nice value, otherwise an rt priority.
+	 */
+	FLAT_BINDER_FLAG_SCHED_POLICY_SHIFT = 9,
+	FLAT_BINDER_FLAG_SCHED_POLICY_MASK = 3U << 9,
+	/* Allow real-time callers to run this node's threads at rt priority */
+	FLAT_BINDER_FLAG_INHERIT_RT = 0x800,
 };
 
 #ifdef BINDER_IPC_32BIT
@@ -124,6 +133,7 @@ enum transaction_flags {
 	TF_ROOT_OBJECT	= 0x04,	/* contents are the component's root object */
 	TF_STATUS_CODE	= 0x08,	/* contents are a 32-bit status code */
 	TF_ACCEPT_FDS	= 0x10,	/* allow replies with file descriptors */
+	TF_UPDATE_TXN	= 0x40,	/* oneway may replace a pending one */
 };
 
 struct binder_transaction_data {
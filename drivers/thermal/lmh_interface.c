@@ -27,6 +27,10 @@
 #include "lmh_interface.h"
 #include <linux/string.h>
 #include <linux/uaccess.h>
+#include <linux/cpu.h>
+#include <linux/cpufreq.h>
+#include <linux/percpu.h>
+#include <linux/workqueue.h>
 
 #define LMH_MON_NAME			"lmh_monitor"
 #define LMH_ISR_POLL_DELAY		"interrupt_poll_delay_msec"
@@ -68,6 +72,8 @@ struct lmh_mon_sensor_data {
 	struct lmh_mon_threshold	trip[LMH_TRIP_MAX];
 	struct thermal_zone_device	*tzdev;
 	enum thermal_device_mode	mode;
+	struct cpumask			cpus;
+	long				intensity;
 };
 
 struct lmh_mon_driver_data {
@@ -99,6 +105,9 @@ static int lmh_poll_interval = LMH_POLLING_MSEC;
 static DECLARE_RWSEM(lmh_mon_access_lock);
 static LIST_HEAD(lmh_sensor_list);
 static DECLARE_RWSEM(lmh_dev_access_lock);
+static DEFINE_PER_CPU(unsigned int, lmh_cpu_intensity);
+static void lmh_freq_cap_work_fn(struct work_struct *work);
+static DECLARE_WORK(lmh_freq_cap_work, lmh_freq_cap_work_fn);
 static LIST_HEAD(lmh_device_list);
 
 #define LMH_CREATE_DEBUGFS_FILE(_node, _name, _mode, _parent, _data, _ops, \
@@ -342,6 +351,133 @@ static void lmh_evaluate_and_notify(struct lmh_mon_sensor_data *lmh_sensor,
 	}
 }
 
+/*
+ * The intensity reported by a CPU sensor is the share of the CPU
+ * frequency, in percent, the limits hardware is holding back. It is
+ * applied as a cpufreq policy limit so that the cluster capacity seen by
+ * the scheduler follows the mitigation as soon as it is reported, rather
+ * than when the governor next samples the throttled frequency.
+ */
+static void lmh_freq_cap_work_fn(struct work_struct *work)
+{
+	struct lmh_mon_sensor_data *lmh_sensor = NULL;
+	struct cpufreq_policy *policy = NULL;
+	cpumask_t changed;
+	long val = 0;
+	int cpu = 0, ret = 0;
+
+	cpumask_clear(&changed);
+	down_read(&lmh_mon_access_lock);
+	for_each_possible_cpu(cpu) {
+		val = 0;
+		list_for_each_entry(lmh_sensor, &lmh_sensor_list, list_ptr) {
+			if (cpumask_test_cpu(cpu, &lmh_sensor->cpus))
+				val = max(val, lmh_sensor->intensity);
+		}
+		val = clamp_val(val, 0, 100);
+		if (per_cpu(lmh_cpu_intensity, cpu) == val)
+			continue;
+		per_cpu(lmh_cpu_intensity, cpu) = val;
+		cpumask_set_cpu(cpu, &changed);
+	}
+	up_read(&lmh_mon_access_lock);
+
+	get_online_cpus();
+	for_each_cpu_and(cpu, &changed, cpu_online_mask) {
+		policy = cpufreq_cpu_get(cpu);
+		if (!policy)
+			continue;
+		cpumask_andnot(&changed, &changed, policy->related_cpus);
+		cpufreq_cpu_put(policy);
+		ret = cpufreq_update_policy(cpu);
+		if (ret)
+			pr_err("Unable to update policy for cpu:%d. err:%d\n",
+				cpu, ret);
+	}
+	put_online_cpus();
+}
+
+static unsigned int lmh_get_freq_cap(struct cpufreq_policy *policy)
+{
+	struct cpufreq_frequency_table *table = NULL;
+	unsigned int intensity = 0, cap = 0, freq = 0, max_freq = 0;
+	int cpu = 0, idx = 0;
+
+	for_each_cpu(cpu, policy->related_cpus)
+		intensity = max(intensity, per_cpu(lmh_cpu_intensity, cpu));
+	max_freq = policy->cpuinfo.max_freq;
+	if (!intensity)
+		return max_freq;
+
+	cap = max_freq - mult_frac(max_freq, intensity, 100);
+	/* Snap to a table level, the capacity is computed from this */
+	table = cpufreq_frequency_get_table(policy->cpu);
+	if (!table)
+		return max(cap, policy->cpuinfo.min_freq);
+	freq = policy->cpuinfo.min_freq;
+	for (idx = 0; table[idx].frequency != CPUFREQ_TABLE_END; idx++) {
+		if (table[idx].frequency == CPUFREQ_ENTRY_INVALID)
+			continue;
+		if (table[idx].frequency <= cap && table[idx].frequency > freq)
+			freq = table[idx].frequency;
+	}
+
+	return freq;
+}
+
+static int lmh_cpufreq_callback(struct notifier_block *nfb,
+		unsigned long event, void *data)
+{
+	struct cpufreq_policy *policy = data;
+	unsigned int max_freq_req = 0;
+
+	switch (event) {
+	case CPUFREQ_INCOMPATIBLE:
+		max_freq_req = lmh_get_freq_cap(policy);
+		if (max_freq_req >= policy->cpuinfo.max_freq)
+			break;
+		pr_debug("LMH mitigating CPU%d to freq max:%u\n",
+			policy->cpu, max_freq_req);
+		cpufreq_verify_within_limits(policy, 0, max_freq_req);
+		break;
+	}
+	return NOTIFY_OK;
+}
+
+static struct notifier_block lmh_cpufreq_notifier = {
+	.notifier_call = lmh_cpufreq_callback,
+};
+
+int lmh_sensor_set_cpus(struct lmh_sensor_ops *ops,
+	const struct cpumask *cpus)
+{
+	struct lmh_mon_sensor_data *lmh_sensor = NULL;
+	int ret = 0;
+
+	if (!ops || !cpus) {
+		pr_err("Invalid input\n");
+		return -EINVAL;
+	}
+
+	down_read(&lmh_mon_access_lock);
+	lmh_sensor = lmh_match_sensor_ops(ops);
+	if (!lmh_sensor) {
+		pr_err("Invalid ops\n");
+		ret = -ENODEV;
+		goto set_cpus_exit;
+	}
+	down_write(&lmh_sensor->lock);
+	cpumask_copy(&lmh_sensor->cpus, cpus);
+	up_write(&lmh_sensor->lock);
+	pr_debug("Sensor:[%s] limits CPU%d and siblings\n",
+		lmh_sensor->sensor_name, cpumask_first(cpus));
+	queue_work(system_highpri_wq, &lmh_freq_cap_work);
+
+set_cpus_exit:
+	up_read(&lmh_mon_access_lock);
+	return ret;
+}
+
 void lmh_update_reading(struct lmh_sensor_ops *ops, long trip_val)
 {
 	struct lmh_mon_sensor_data *lmh_sensor = NULL;
@@ -361,6 +497,10 @@ void lmh_update_reading(struct lmh_sensor_ops *ops, long trip_val)
 	pr_debug("Sensor:[%s] intensity:%ld\n", lmh_sensor->sensor_name,
 		trip_val);
 	lmh_evaluate_and_notify(lmh_sensor, trip_val);
+	if (!cpumask_empty(&lmh_sensor->cpus)
+		&& lmh_sensor->intensity != trip_val)
+		queue_work(system_highpri_wq, &lmh_freq_cap_work);
+	lmh_sensor->intensity = trip_val;
 interrupt_exit:
 	if (lmh_sensor)
 		up_write(&lmh_sensor->lock);
@@ -605,6 +745,8 @@ static void lmh_sensor_remove(struct lmh_sensor_ops *ops)
 	thermal_zone_device_unregister(lmh_sensor->tzdev);
 	list_del(&lmh_sensor->list_ptr);
 	up_write(&lmh_sensor->lock);
+	if (!cpumask_empty(&lmh_sensor->cpus))
+		queue_work(system_highpri_wq, &lmh_freq_cap_work);
 	pr_debug("Deregistered sensor:[%s]\n", lmh_sensor->sensor_name);
 	kfree(lmh_sensor);
 
@@ -1192,6 +1334,11 @@ static int __init lmh_mon_init_call(void)
 	ret = class_register(&lmh_class_info);
 	if (ret)
 		goto lmh_init_exit;
+	ret = cpufreq_register_notifier(&lmh_cpufreq_notifier,
+		CPUFREQ_POLICY_NOTIFIER);
+	if (ret)
+		pr_err("Error registering cpufreq notifier. err:%d\n", ret);
+	ret = 0;
 
 lmh_init_exit:
 	if (ret)
@@ -1231,7 +1378,10 @@ static void lmh_debug_cleanup(void)
 
 static void __exit lmh_mon_exit(void)
 {
+	cpufreq_unregister_notifier(&lmh_cpufreq_notifier,
+		CPUFREQ_POLICY_NOTIFIER);
 	lmh_mon_cleanup();
+	flush_work(&lmh_freq_cap_work);
 	lmh_device_cleanup();
 	lmh_debug_cleanup();
 	class_unregister(&lmh_class_info);
@@ -14,6 +14,8 @@
 #ifndef __LMH_INTERFACE_H
 #define __LMH_INTERFACE_H
 
+#include <linux/cpumask.h>
+
 #define LMH_NAME_MAX			20
 #define LMH_READ_LINE_LENGTH		10
 
@@ -56,6 +58,7 @@ int lmh_set_dev_level(char *, int);
 int lmh_get_curr_level(char *, int *);
 int lmh_sensor_register(char *, struct lmh_sensor_ops *);
 void lmh_sensor_deregister(struct lmh_sensor_ops *);
+int lmh_sensor_set_cpus(struct lmh_sensor_ops *, const struct cpumask *);
 int lmh_device_register(char *, struct lmh_device_ops *);
 void lmh_device_deregister(struct lmh_device_ops *);
 int lmh_debug_register(struct lmh_debug_ops *);
@@ -88,6 +91,12 @@ static inline void lmh_sensor_deregister(struct lmh_sensor_ops *ops)
 	return;
 }
 
+static inline int lmh_sensor_set_cpus(struct lmh_sensor_ops *ops,
+	const struct cpumask *cpus)
+{
+	return -ENOSYS;
+}
+
 static inline int lmh_device_register(char *device_name,
 	struct lmh_device_ops *ops)
 {
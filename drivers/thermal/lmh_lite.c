@@ -21,6 +21,7 @@
 #include <linux/io.h>
 #include <linux/err.h>
 #include <linux/of.h>
+#include <linux/cpu.h>
 #include <linux/mutex.h>
 #include "lmh_interface.h"
 #include <linux/slab.h>
@@ -592,6 +593,47 @@ static int lmh_check_tz_sensor_cmds(void)
 	return 0;
 }
 
+/*
+ * "qcom,cpu-sensor-node-ids" lists the hardware node ids of the sensors
+ * limiting a CPU cluster, and "qcom,cpu-sensor-cpus" a CPU of the
+ * cluster each of them limits, in the same order.
+ */
+static void lmh_sensor_map_cpus(struct lmh_sensor_data *lmh_sensor)
+{
+	struct device_node *node = lmh_data->dev->of_node;
+	struct device_node *cpu_node = NULL, *np = NULL;
+	char *key = "qcom,cpu-sensor-node-ids";
+	uint32_t node_id = 0;
+	int idx = 0, cnt = 0, cpu = 0, ret = 0;
+
+	cnt = of_property_count_u32_elems(node, key);
+	for (idx = 0; idx < cnt; idx++) {
+		ret = of_property_read_u32_index(node, key, idx, &node_id);
+		if (ret || node_id != lmh_sensor->sensor_hw_node_id)
+			continue;
+		cpu_node = of_parse_phandle(node, "qcom,cpu-sensor-cpus", idx);
+		if (!cpu_node) {
+			pr_err("No CPU for sensor:[%s]\n",
+				lmh_sensor->sensor_name);
+			return;
+		}
+		for_each_possible_cpu(cpu) {
+			np = of_get_cpu_node(cpu, NULL);
+			of_node_put(np);
+			if (np == cpu_node)
+				break;
+		}
+		of_node_put(cpu_node);
+		if (cpu >= nr_cpu_ids)
+			return;
+		ret = lmh_sensor_set_cpus(&lmh_sensor->ops, cpumask_of(cpu));
+		if (ret)
+			pr_err("Sensor:[%s] CPU map failed. err:%d\n",
+				lmh_sensor->sensor_name, ret);
+		return;
+	}
+}
+
 static int lmh_parse_sensor(struct lmh_sensor_info *sens_info)
 {
 	int ret = 0, idx = 0, size = 0;
@@ -632,6 +674,7 @@ static int lmh_parse_sensor(struct lmh_sensor_info *sens_info)
 		goto sens_exit;
 	}
 	list_add_tail(&lmh_sensor->list_ptr, &lmh_sensor_list);
+	lmh_sensor_map_cpus(lmh_sensor);
 	pr_debug("Registered sensor:[%s] driver\n", lmh_sensor->sensor_name);
 
 sens_exit:
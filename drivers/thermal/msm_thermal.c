@@ -1549,19 +1549,72 @@ static void update_cluster_freq(void)
 	}
 }
 
-static void do_cluster_freq_ctrl(long temp)
+/*
+ * How far ahead, in ms, the sensor temperature is extrapolated from its
+ * slope when deciding on the frequency ceiling. 0 disables prediction.
+ */
+static unsigned int predict_ms = 1000;
+module_param(predict_ms, uint, 0644);
+MODULE_PARM_DESC(predict_ms, "temperature prediction horizon in ms");
+
+/*
+ * Extrapolate @temp predict_ms ahead from a smoothed slope of the last
+ * polls. Only a rising temperature is extrapolated, so the prediction can
+ * bring mitigation forward but never delays it.
+ */
+static long therm_predict_temp(long temp)
+{
+	static long last_temp;
+	static unsigned long last_jiffies;
+	static long slope;	/* mdegC per sec */
+	unsigned long now = jiffies;
+	unsigned int dt_ms;
+
+	dt_ms = jiffies_to_msecs(now - last_jiffies);
+	/* a stale sample, e.g. after interrupt mode, says nothing */
+	if (last_jiffies && dt_ms && dt_ms <= 4 * msm_thermal_info.poll_ms)
+		slope = (3 * slope +
+			 (temp - last_temp) * 1000 * MSEC_PER_SEC / dt_ms) / 4;
+	else
+		slope = 0;
+	last_temp = temp;
+	last_jiffies = now;
+
+	if (!predict_ms || slope <= 0)
+		return temp;
+
+	return temp + slope * (long)predict_ms / (1000 * MSEC_PER_SEC);
+}
+
+/*
+ * Step the ceiling down by bootup_freq_step once the limit is crossed,
+ * and by a single level when it is only predicted to be crossed, so the
+ * ceiling eases in ahead of the limit. It is raised only once both the
+ * temperature and the prediction are below the hysteresis band, which
+ * keeps a rising load from bouncing between caps.
+ */
+static int therm_freq_step(long temp, long pred)
+{
+	long clear = msm_thermal_info.limit_temp_degC -
+		     msm_thermal_info.temp_hysteresis_degC;
+
+	if (temp >= msm_thermal_info.limit_temp_degC)
+		return -msm_thermal_info.bootup_freq_step;
+	if (pred >= msm_thermal_info.limit_temp_degC)
+		return -1;
+	if (temp < clear && pred < clear)
+		return msm_thermal_info.bootup_freq_step;
+	return 0;
+}
+
+static void do_cluster_freq_ctrl(long temp, long pred)
 {
 	uint32_t _cluster = 0;
 	int _cpu = -1, freq_idx = 0;
-	bool mitigate = false;
+	int step = therm_freq_step(temp, pred);
 	struct cluster_info *cluster_ptr = NULL;
 
-	if (temp >= msm_thermal_info.limit_temp_degC)
-		mitigate = true;
-	else if (temp < msm_thermal_info.limit_temp_degC -
-		 msm_thermal_info.temp_hysteresis_degC)
-		mitigate = false;
-	else
+	if (!step)
 		return;
 
 	get_online_cpus();
@@ -1570,14 +1623,9 @@ static void do_cluster_freq_ctrl(long temp)
 		if (!cluster_ptr->freq_table)
 			continue;
 
-		if (mitigate)
-			freq_idx = max_t(int, cluster_ptr->freq_idx_low,
-				(cluster_ptr->freq_idx
-				- msm_thermal_info.bootup_freq_step));
-		else
-			freq_idx = min_t(int, cluster_ptr->freq_idx_high,
-				(cluster_ptr->freq_idx
-				+ msm_thermal_info.bootup_freq_step));
+		freq_idx = clamp_t(int, cluster_ptr->freq_idx + step,
+				   cluster_ptr->freq_idx_low,
+				   cluster_ptr->freq_idx_high);
 		if (freq_idx == cluster_ptr->freq_idx)
 			continue;
 
@@ -3337,30 +3385,24 @@ static void do_freq_control(long temp)
 {
 	uint32_t cpu = 0;
 	uint32_t max_freq = cpus[cpu].limited_max_freq;
+	long pred = therm_predict_temp(temp);
+	int step;
 
 	if (core_ptr)
-		return do_cluster_freq_ctrl(temp);
+		return do_cluster_freq_ctrl(temp, pred);
 	if (!freq_table_get)
 		return;
 
-	if (temp >= msm_thermal_info.limit_temp_degC) {
-		if (limit_idx == limit_idx_low)
-			return;
-
-		limit_idx -= msm_thermal_info.bootup_freq_step;
-		if (limit_idx < limit_idx_low)
-			limit_idx = limit_idx_low;
-	} else if (temp < msm_thermal_info.limit_temp_degC -
-		 msm_thermal_info.temp_hysteresis_degC) {
-		if (limit_idx == limit_idx_high)
-			return;
-
-		limit_idx += msm_thermal_info.bootup_freq_step;
-		if (limit_idx >= limit_idx_high)
-			limit_idx = limit_idx_high;
-	}
+	step = therm_freq_step(temp, pred);
+	if (!step)
+		return;
+	if (step < 0 && limit_idx == limit_idx_low)
+		return;
+	if (step > 0 && limit_idx == limit_idx_high)
+		return;
+	limit_idx = clamp_t(int, limit_idx + step, limit_idx_low,
+			    limit_idx_high);
 
-	
 	get_online_cpus();
 	max_freq = table[limit_idx].frequency;
 	if (max_freq == cpus[cpu].limited_max_freq) {
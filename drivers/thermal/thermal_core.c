@@ -1438,6 +1438,7 @@ int power_actor_set_power(struct thermal_cooling_device *cdev,
 		return ret;
 
 	instance->target = state;
+	instance->granted_power = power;
 	cdev->updated = false;
 	thermal_cdev_update(cdev);
 
@@ -1580,6 +1581,17 @@ thermal_cooling_device_weight_store(struct device *dev,
 	return count;
 }
 
+static ssize_t
+thermal_cooling_device_power_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct thermal_instance *instance;
+
+	instance = container_of(attr, struct thermal_instance, power_attr);
+
+	return sprintf(buf, "%u\n", instance->granted_power);
+}
+
 int thermal_zone_bind_cooling_device(struct thermal_zone_device *tz,
 				     int trip,
 				     struct thermal_cooling_device *cdev,
@@ -1658,6 +1670,15 @@ int thermal_zone_bind_cooling_device(struct thermal_zone_device *tz,
 	if (result)
 		goto remove_trip_file;
 
+	sprintf(dev->power_attr_name, "cdev%d_granted_power", dev->id);
+	sysfs_attr_init(&dev->power_attr.attr);
+	dev->power_attr.attr.name = dev->power_attr_name;
+	dev->power_attr.attr.mode = S_IRUGO;
+	dev->power_attr.show = thermal_cooling_device_power_show;
+	result = device_create_file(&tz->device, &dev->power_attr);
+	if (result)
+		goto remove_weight_file;
+
 	mutex_lock(&tz->lock);
 	mutex_lock(&cdev->lock);
 	list_for_each_entry(pos, &tz->thermal_instances, tz_node)
@@ -1675,6 +1696,8 @@ int thermal_zone_bind_cooling_device(struct thermal_zone_device *tz,
 	if (!result)
 		return 0;
 
+	device_remove_file(&tz->device, &dev->power_attr);
+remove_weight_file:
 	device_remove_file(&tz->device, &dev->weight_attr);
 remove_trip_file:
 	device_remove_file(&tz->device, &dev->attr);
@@ -1711,6 +1734,8 @@ int thermal_zone_unbind_cooling_device(struct thermal_zone_device *tz,
 	return -ENODEV;
 
 unbind:
+	device_remove_file(&tz->device, &pos->power_attr);
+	device_remove_file(&tz->device, &pos->weight_attr);
 	device_remove_file(&tz->device, &pos->attr);
 	sysfs_remove_link(&tz->device.kobj, pos->name);
 	release_idr(&tz->idr, &tz->lock, pos->id);
@@ -48,9 +48,12 @@ struct thermal_instance {
 	struct device_attribute attr;
 	char weight_attr_name[THERMAL_NAME_LENGTH];
 	struct device_attribute weight_attr;
+	char power_attr_name[THERMAL_NAME_LENGTH];
+	struct device_attribute power_attr;
 	struct list_head tz_node; /* node in tz->thermal_instances */
 	struct list_head cdev_node; /* node in cdev->thermal_instances */
 	unsigned int weight; /* The weight of the cooling device */
+	u32 granted_power; /* Last power granted by the governor, in mW */
 };
 
 int thermal_register_governor(struct thermal_governor *);
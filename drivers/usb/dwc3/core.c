@@ -231,6 +231,9 @@ int dwc3_event_buffers_setup(struct dwc3 *dwc)
 					upper_32_bits(evt->dma));
 			dwc3_writel(dwc->regs, DWC3_GEVNTSIZ(n),
 					DWC3_GEVNTSIZ_SIZE(evt->length));
+			if (dwc3_imod_interval(dwc))
+				dwc3_writel(dwc->regs, DWC3_DEV_IMOD(n),
+						dwc3_imod_interval(dwc));
 		} else {
 			dwc3_writel(dwc->regs, DWC3_GEVNTADRHI(n),
 				DWC3_GEVNTADRHI_EVNTADRHI_GSI_EN(
@@ -759,6 +762,9 @@ static int dwc3_probe(struct platform_device *pdev)
 		dwc->disable_clk_gating = of_property_read_bool(node,
 					"snps,disable-clk-gating");
 
+		of_property_read_u32(node, "snps,imod-interval-ns",
+				&dwc->imod_interval_ns);
+
 		dwc->num_normal_event_buffers = 1;
 		ret = of_property_read_u32(node,
 			"snps,num-normal-evt-buffs", &num_evt_buffs);
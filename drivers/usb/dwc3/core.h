@@ -121,6 +121,7 @@
 #define DWC3_GEVNTCOUNT(n)	(0xc40c + (n * 0x10))
 
 #define DWC3_GEVNTCOUNT_EVNTINTRPTMASK		(1 << 31)
+#define DWC3_GEVNTCOUNT_EHB			(1 << 31)
 #define DWC3_GEVNTADRHI_EVNTADRHI_GSI_EN(n)	(n << 22)
 #define DWC3_GEVNTADRHI_EVNTADRHI_GSI_IDX(n)	(n << 16)
 #define DWC3_GEVENT_TYPE_GSI			0x3
@@ -135,6 +136,7 @@
 #define DWC3_DGCMDPAR		0xc710
 #define DWC3_DGCMD		0xc714
 #define DWC3_DALEPENA		0xc720
+#define DWC3_DEV_IMOD(n)	(0xca00 + (n * 0x4))
 #define DWC3_DEPCMDPAR2(n)	(0xc800 + (n * 0x10))
 #define DWC3_DEPCMDPAR1(n)	(0xc804 + (n * 0x10))
 #define DWC3_DEPCMDPAR0(n)	(0xc808 + (n * 0x10))
@@ -199,6 +201,10 @@
 #define DWC3_GEVNTSIZ_INTMASK		(1 << 31)
 #define DWC3_GEVNTSIZ_SIZE(n)		((n) & 0xffff)
 
+/* Device Interrupt Moderation, interval in 250ns units */
+#define DWC3_DEV_IMOD_INTERVAL_NS	250
+#define DWC3_DEV_IMOD_IMODI_MASK	0xffff
+
 #define DWC3_GHWPARAMS1_EN_PWROPT(n)	(((n) & (3 << 24)) >> 24)
 #define DWC3_GHWPARAMS1_EN_PWROPT_NO	0
 #define DWC3_GHWPARAMS1_EN_PWROPT_CLK	1
@@ -710,6 +716,8 @@ struct dwc3 {
 #define DWC3_REVISION_260A	0x5533260a
 #define DWC3_REVISION_270A	0x5533270a
 #define DWC3_REVISION_280A	0x5533280a
+#define DWC3_REVISION_290A	0x5533290a
+#define DWC3_REVISION_300A	0x5533300a
 
 	enum dwc3_ep0_next	ep0_next_event;
 	enum dwc3_ep0_state	ep0state;
@@ -787,6 +795,13 @@ struct dwc3 {
 	unsigned                irq_completion_time[MAX_INTR_STATS];
 	unsigned                irq_event_count[MAX_INTR_STATS];
 	unsigned                irq_dbg_index;
+	/* events handled and irqs that woke the bottom half, for averages */
+	unsigned long		bh_evt_total;
+	unsigned long		bh_irq_total;
+	/* bottom half passes that ran out of budget and polled again */
+	unsigned long		bh_repoll_cnt;
+	/* interrupt moderation interval, 0 if not used */
+	u32			imod_interval_ns;
 
 	wait_queue_head_t	wait_linkstate;
 	
@@ -875,6 +890,17 @@ struct dwc3_gadget_ep_cmd_params {
 void dwc3_set_mode(struct dwc3 *dwc, u32 mode);
 int dwc3_gadget_resize_tx_fifos(struct dwc3 *dwc);
 
+/* IMOD register value, interrupt moderation needs 3.00a or later */
+static inline u32 dwc3_imod_interval(struct dwc3 *dwc)
+{
+	if (dwc->revision < DWC3_REVISION_300A)
+		return 0;
+
+	return min_t(u32, DIV_ROUND_UP(dwc->imod_interval_ns,
+				DWC3_DEV_IMOD_INTERVAL_NS),
+			DWC3_DEV_IMOD_IMODI_MASK);
+}
+
 #if IS_ENABLED(CONFIG_USB_DWC3_HOST) || IS_ENABLED(CONFIG_USB_DWC3_DUAL_ROLE)
 int dwc3_host_init(struct dwc3 *dwc);
 void dwc3_host_exit(struct dwc3 *dwc);
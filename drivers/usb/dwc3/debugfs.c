@@ -1056,6 +1056,9 @@ static ssize_t dwc3_store_int_events(struct file *file,
 		dep->dbg_ep_events_ts = ts;
 	}
 	memset(&dwc->dbg_gadget_events, 0, sizeof(dwc->dbg_gadget_events));
+	dwc->bh_evt_total = 0;
+	dwc->bh_irq_total = 0;
+	dwc->bh_repoll_cnt = 0;
 
 	spin_unlock_irqrestore(&dwc->lock, flags);
 
@@ -1174,6 +1177,13 @@ static int dwc3_gadget_int_events_show(struct seq_file *s, void *unused)
 		seq_printf(s, "%d\t", dwc->bh_completion_time[i]);
 	seq_putc(s, '\n');
 
+	seq_printf(s, "events per irq:%lu (%lu events, %lu irqs)\n",
+		dwc->bh_irq_total ? dwc->bh_evt_total / dwc->bh_irq_total : 0,
+		dwc->bh_evt_total, dwc->bh_irq_total);
+	seq_printf(s, "bh repolls:%lu imod interval (ns):%u\n",
+		dwc->bh_repoll_cnt,
+		dwc3_imod_interval(dwc) * DWC3_DEV_IMOD_INTERVAL_NS);
+
 	seq_printf(s, "t_pwr evt irq : %lld\t",
 			ktime_to_us(dwc->t_pwr_evt_irq));
 
@@ -1764,6 +1764,11 @@ void dwc3_gadget_disable_irq(struct dwc3 *dwc)
 
 static irqreturn_t dwc3_interrupt(int irq, void *_dwc);
 static irqreturn_t dwc3_thread_interrupt(int irq, void *_dwc);
+
+/* Events handled per bottom half pass before yielding, 0 for no limit */
+static unsigned int evt_budget = 64;
+module_param(evt_budget, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(evt_budget, "Events handled per pass before polling again");
 static void dwc3_gadget_disconnect_interrupt(struct dwc3 *dwc);
 
 static int dwc3_gadget_vbus_session(struct usb_gadget *_gadget, int is_active)
@@ -2932,20 +2937,27 @@ static void dwc3_process_event_entry(struct dwc3 *dwc,
 	}
 }
 
-static irqreturn_t dwc3_process_event_buf(struct dwc3 *dwc, u32 buf)
+/*
+ * Handle up to @budget events of event buffer @buf. The interrupt for the
+ * buffer stays masked while events keep arriving, they are picked up here
+ * from GEVNTCOUNT, and it is only unmasked once the buffer is drained.
+ * A buffer left with events when the budget runs out stays pending for the
+ * next pass. Returns the number of events handled.
+ */
+static int dwc3_process_event_buf(struct dwc3 *dwc, u32 buf, int budget)
 {
 	struct dwc3_event_buffer *evt;
-	irqreturn_t ret = IRQ_NONE;
 	int left;
+	int done = 0;
 	u32 reg;
 
 	evt = dwc->ev_buffs[buf];
 	left = evt->count;
 
 	if (!(evt->flags & DWC3_EVENT_PENDING))
-		return IRQ_NONE;
+		return 0;
 
-	while (left > 0) {
+	while (left > 0 && done < budget) {
 		union dwc3_event event;
 
 		event.raw = *(u32 *) (evt->buf + evt->lpos);
@@ -2958,27 +2970,44 @@ static irqreturn_t dwc3_process_event_buf(struct dwc3 *dwc, u32 buf)
 			dwc3_writel(dwc->regs, DWC3_GEVNTCOUNT(buf), left);
 			if (dwc3_notify_event(dwc, DWC3_CONTROLLER_ERROR_EVENT))
 				dwc->err_evt_seen = 0;
+			left = 0;
 			break;
 		}
 
 		evt->lpos = (evt->lpos + 4) % DWC3_EVENT_BUFFERS_SIZE;
 		left -= 4;
+		done++;
 
 		dwc3_writel(dwc->regs, DWC3_GEVNTCOUNT(buf), 4);
+
+		if (!left) {
+			left = dwc3_readl(dwc->regs, DWC3_GEVNTCOUNT(buf));
+			left &= DWC3_GEVNTCOUNT_MASK;
+		}
 	}
 
-	dwc->bh_handled_evt_cnt[dwc->bh_dbg_index] += (evt->count / 4);
+	dwc->bh_handled_evt_cnt[dwc->bh_dbg_index] += done;
+	dwc->bh_evt_total += done;
+
+	evt->count = left;
+	if (left > 0)
+		return done;
 
-	evt->count = 0;
 	evt->flags &= ~DWC3_EVENT_PENDING;
-	ret = IRQ_HANDLED;
+
+	if (dwc3_imod_interval(dwc)) {
+		dwc3_writel(dwc->regs, DWC3_GEVNTCOUNT(buf),
+				DWC3_GEVNTCOUNT_EHB);
+		dwc3_writel(dwc->regs, DWC3_DEV_IMOD(buf),
+				dwc3_imod_interval(dwc));
+	}
 
 	
 	reg = dwc3_readl(dwc->regs, DWC3_GEVNTSIZ(buf));
 	reg &= ~DWC3_GEVNTSIZ_INTMASK;
 	dwc3_writel(dwc->regs, DWC3_GEVNTSIZ(buf), reg);
 
-	return ret;
+	return done;
 }
 
 static void dwc3_interrupt_bh(unsigned long param)
@@ -2986,15 +3015,25 @@ static void dwc3_interrupt_bh(unsigned long param)
 	struct dwc3 *dwc = (struct dwc3 *) param;
 
 	pm_runtime_get(dwc->dev);
-	dwc3_thread_interrupt(dwc->irq, dwc);
+	if (dwc3_thread_interrupt(dwc->irq, dwc) == IRQ_WAKE_THREAD) {
+		/* out of budget, poll again with the irq still disabled */
+		dwc->bh_repoll_cnt++;
+		tasklet_schedule(&dwc->bh);
+		return;
+	}
 	enable_irq(dwc->irq);
 }
 
+/*
+ * Returns IRQ_WAKE_THREAD if events are left over for another pass,
+ * IRQ_HANDLED once all the event buffers are drained and unmasked.
+ */
 static irqreturn_t dwc3_thread_interrupt(int irq, void *_dwc)
 {
 	struct dwc3 *dwc = _dwc;
 	unsigned long flags;
-	irqreturn_t ret = IRQ_NONE;
+	irqreturn_t ret = IRQ_HANDLED;
+	int budget = evt_budget ? evt_budget : INT_MAX;
 	int i;
 	unsigned temp_time;
 	ktime_t start_time;
@@ -3004,8 +3043,11 @@ static irqreturn_t dwc3_thread_interrupt(int irq, void *_dwc)
 	spin_lock_irqsave(&dwc->lock, flags);
 	dwc->bh_handled_evt_cnt[dwc->bh_dbg_index] = 0;
 
-	for (i = 0; i < dwc->num_normal_event_buffers; i++)
-		ret |= dwc3_process_event_buf(dwc, i);
+	for (i = 0; i < dwc->num_normal_event_buffers; i++) {
+		budget -= dwc3_process_event_buf(dwc, i, budget);
+		if (dwc->ev_buffs[i]->flags & DWC3_EVENT_PENDING)
+			ret = IRQ_WAKE_THREAD;
+	}
 
 	spin_unlock_irqrestore(&dwc->lock, flags);
 
@@ -3086,6 +3128,7 @@ static irqreturn_t dwc3_interrupt(int irq, void *_dwc)
 	dwc->irq_dbg_index = (dwc->irq_dbg_index + 1) % MAX_INTR_STATS;
 
 	if (ret == IRQ_WAKE_THREAD) {
+		dwc->bh_irq_total++;
 		disable_irq_nosync(irq);
 		tasklet_schedule(&dwc->bh);
 	}
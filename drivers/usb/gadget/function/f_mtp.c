@@ -28,6 +28,8 @@
 #include <linux/debugfs.h>
 #include <linux/types.h>
 #include <linux/file.h>
+#include <linux/pagemap.h>
+#include <linux/scatterlist.h>
 #include <linux/device.h>
 #include <linux/miscdevice.h>
 
@@ -54,7 +56,9 @@
 #define STATE_ERROR                 4   
 
 #define MTP_TX_REQ_MAX 8
-#define RX_REQ_MAX 2
+/* page cache pages sent by one IN request on the zero copy path */
+#define MTP_TX_SG_MAX 32
+#define RX_REQ_MAX 8
 #define INTR_REQ_MAX 5
 
 #define MTP_OS_STRING_ID   0xEE
@@ -78,6 +82,10 @@ module_param(mtp_tx_req_len, uint, S_IRUGO | S_IWUSR);
 
 unsigned int mtp_tx_reqs = MTP_TX_REQ_MAX;
 module_param(mtp_tx_reqs, uint, S_IRUGO | S_IWUSR);
+
+/* OUT requests kept queued while received data is written to the file */
+unsigned int mtp_rx_reqs = 2;
+module_param(mtp_rx_reqs, uint, S_IRUGO | S_IWUSR);
 static int htc_mtp_open_state;
 
 static const char mtp_shortname[] = DRIVER_NAME "_usb";
@@ -105,7 +113,10 @@ struct mtp_dev {
 	wait_queue_head_t write_wq;
 	wait_queue_head_t intr_wq;
 	struct usb_request *rx_req[RX_REQ_MAX];
+	unsigned int rx_reqs;
 	int rx_done;
+	/* OUT completions so far, the OUT endpoint completes in order */
+	unsigned int rx_completed;
 
 	struct workqueue_struct *wq;
 	struct work_struct send_file_work;
@@ -412,11 +423,22 @@ static struct usb_request *mtp_request_new(struct usb_ep *ep, int buffer_size)
 static void mtp_request_free(struct usb_request *req, struct usb_ep *ep)
 {
 	if (req) {
+		kfree(req->sg);
 		kfree(req->buf);
 		usb_ep_free_request(ep, req);
 	}
 }
 
+/* Drop the page cache pages an IN request was sent from */
+static void mtp_req_put_pages(struct usb_request *req)
+{
+	unsigned int i;
+
+	for (i = 0; i < req->num_sgs; i++)
+		page_cache_release(sg_page(&req->sg[i]));
+	req->num_sgs = 0;
+}
+
 static inline int mtp_lock(atomic_t *excl)
 {
 	if (atomic_inc_return(excl) == 1) {
@@ -466,6 +488,7 @@ static void mtp_complete_in(struct usb_ep *ep, struct usb_request *req)
 	if (req->status != 0 && dev->state != STATE_OFFLINE)
 		dev->state = STATE_ERROR;
 
+	mtp_req_put_pages(req);
 	mtp_req_put(dev, &dev->tx_idle, req);
 
 	wake_up(&dev->write_wq);
@@ -476,7 +499,10 @@ static void mtp_complete_out(struct usb_ep *ep, struct usb_request *req)
 	struct mtp_dev *dev = _mtp_dev;
 
 	dev->rx_done = 1;
-	if (req->status != 0 && dev->state != STATE_OFFLINE)
+	dev->rx_completed++;
+	/* requests queued past the end of a transfer are dequeued */
+	if (req->status != 0 && req->status != -ECONNRESET &&
+	    dev->state != STATE_OFFLINE)
 		dev->state = STATE_ERROR;
 
 	wake_up(&dev->read_wq);
@@ -551,6 +577,14 @@ retry_tx_alloc:
 			mtp_tx_reqs = MTP_TX_REQ_MAX;
 			goto retry_tx_alloc;
 		}
+		if (cdev->gadget->sg_supported) {
+			req->sg = kmalloc_array(MTP_TX_SG_MAX,
+					sizeof(struct scatterlist), GFP_KERNEL);
+			if (!req->sg) {
+				mtp_request_free(req, dev->ep_in);
+				goto fail;
+			}
+		}
 		req->complete = mtp_complete_in;
 		mtp_req_put(dev, &dev->tx_idle, req);
 	}
@@ -558,8 +592,10 @@ retry_tx_alloc:
 	if (mtp_rx_req_len % 1024)
 		mtp_rx_req_len = MTP_BULK_BUFFER_SIZE;
 
+	dev->rx_reqs = clamp_t(unsigned int, mtp_rx_reqs, 2, RX_REQ_MAX);
+
 retry_rx_alloc:
-	for (i = 0; i < RX_REQ_MAX; i++) {
+	for (i = 0; i < dev->rx_reqs; i++) {
 		req = mtp_request_new(dev->ep_out, mtp_rx_req_len);
 		if (!req) {
 			if (mtp_rx_req_len <= MTP_BULK_BUFFER_SIZE)
@@ -770,6 +806,69 @@ static ssize_t mtp_write(struct file *fp, const char __user *buf,
 	return r;
 }
 
+/*
+ * Point @req at up to @len bytes of the page cache of @filp at @offset
+ * instead of copying them into req->buf. @count is what is left of the
+ * transfer and sizes the readahead. Returns the number of bytes mapped,
+ * or 0 if the caller has to fall back to vfs_read().
+ */
+static int mtp_map_file_pages(struct mtp_dev *dev, struct usb_request *req,
+		struct file *filp, loff_t offset, int len, int64_t count)
+{
+	struct address_space *mapping = filp->f_mapping;
+	loff_t isize = i_size_read(mapping->host);
+	pgoff_t index = offset >> PAGE_CACHE_SHIFT;
+	unsigned int off = offset & ~PAGE_CACHE_MASK;
+	unsigned long ra = DIV_ROUND_UP(count + off, PAGE_CACHE_SIZE);
+	int done = 0;
+
+	if (!req->sg || filp->f_op->read_iter != generic_file_read_iter ||
+	    (filp->f_flags & O_DIRECT) || offset >= isize)
+		return 0;
+
+	len = min_t(loff_t, len, isize - offset);
+	len = min_t(int, len, MTP_TX_SG_MAX * PAGE_CACHE_SIZE - off);
+	/* only the last request of a transfer may end in a short packet */
+	if (len < count)
+		len = round_down(len, dev->ep_in->maxpacket);
+	if (len <= 0)
+		return 0;
+
+	sg_init_table(req->sg, MTP_TX_SG_MAX);
+	while (done < len) {
+		unsigned int bytes = min_t(unsigned int,
+				PAGE_CACHE_SIZE - off, len - done);
+		struct page *page;
+
+		page = find_get_page(mapping, index);
+		if (!page)
+			page_cache_sync_readahead(mapping, &filp->f_ra, filp,
+					index, ra);
+		else if (PageReadahead(page))
+			page_cache_async_readahead(mapping, &filp->f_ra, filp,
+					page, index, ra);
+		if (!page || !PageUptodate(page)) {
+			if (page)
+				page_cache_release(page);
+			page = read_mapping_page(mapping, index, filp);
+			if (IS_ERR(page)) {
+				/* vfs_read() reports the error */
+				mtp_req_put_pages(req);
+				return 0;
+			}
+		}
+
+		sg_set_page(&req->sg[req->num_sgs++], page, bytes, off);
+		done += bytes;
+		off = 0;
+		index++;
+		ra--;
+	}
+	sg_mark_end(&req->sg[req->num_sgs - 1]);
+
+	return done;
+}
+
 static void send_file_work(struct work_struct *data)
 {
 	struct mtp_dev *dev = container_of(data, struct mtp_dev,
@@ -784,6 +883,7 @@ static void send_file_work(struct work_struct *data)
 	int r = 0;
 	int sendZLP = 0;
 	ktime_t start_time;
+	unsigned long ra_pages, ra_window;
 
 	
 	smp_rmb();
@@ -793,6 +893,17 @@ static void send_file_work(struct work_struct *data)
 
 	DBG(cdev, "send_file_work(%lld %lld)\n", offset, count);
 
+	/*
+	 * Let readahead run a full set of IN requests ahead of the read
+	 * position, so that the file is read from disk while the previous
+	 * requests are on the bus instead of in between them.
+	 */
+	ra_window = 2 * DIV_ROUND_UP(mtp_tx_req_len * mtp_tx_reqs, PAGE_SIZE);
+	spin_lock(&filp->f_lock);
+	ra_pages = filp->f_ra.ra_pages;
+	filp->f_ra.ra_pages = max(ra_pages, ra_window);
+	spin_unlock(&filp->f_lock);
+
 	if (dev->xfer_send_header) {
 		hdr_size = sizeof(struct mtp_data_header);
 		count += hdr_size;
@@ -843,8 +954,15 @@ static void send_file_work(struct work_struct *data)
 					__cpu_to_le32(dev->xfer_transaction_id);
 		}
 		start_time = ktime_get();
-		ret = vfs_read(filp, req->buf + hdr_size, xfer - hdr_size,
-								&offset);
+		ret = 0;
+		if (!hdr_size) {
+			ret = mtp_map_file_pages(dev, req, filp, offset, xfer,
+					count);
+			offset += ret;
+		}
+		if (!ret)
+			ret = vfs_read(filp, req->buf + hdr_size,
+					xfer - hdr_size, &offset);
 		if (ret < 0) {
 			r = ret;
 			break;
@@ -861,6 +979,7 @@ static void send_file_work(struct work_struct *data)
 		ret = usb_ep_queue(dev->ep_in, req, GFP_KERNEL);
 		if (ret < 0) {
 			DBG(cdev, "send_file_work: xfer error %d\n", ret);
+			mtp_req_put_pages(req);
 			if (dev->state != STATE_OFFLINE)
 				dev->state = STATE_ERROR;
 			r = -EIO;
@@ -876,6 +995,10 @@ static void send_file_work(struct work_struct *data)
 	if (req)
 		mtp_req_put(dev, &dev->tx_idle, req);
 
+	spin_lock(&filp->f_lock);
+	filp->f_ra.ra_pages = ra_pages;
+	spin_unlock(&filp->f_lock);
+
 	DBG(cdev, "send_file_work returning %d state:%d\n", r, dev->state);
 	
 	dev->xfer_result = r;
@@ -887,11 +1010,13 @@ static void receive_file_work(struct work_struct *data)
 	struct mtp_dev *dev = container_of(data, struct mtp_dev,
 						receive_file_work);
 	struct usb_composite_dev *cdev = dev->cdev;
-	struct usb_request *read_req = NULL, *write_req = NULL;
+	struct usb_request *read_req, *write_req;
 	struct file *filp;
 	loff_t offset;
-	int64_t count;
-	int ret, cur_buf = 0;
+	int64_t count, queued = 0;
+	unsigned int head = 0, tail = 0, pending = 0, retired = 0;
+	unsigned int base;
+	int ret;
 	int r = 0;
 	ktime_t start_time;
 
@@ -900,19 +1025,23 @@ static void receive_file_work(struct work_struct *data)
 	filp = dev->xfer_file;
 	offset = dev->xfer_file_offset;
 	count = dev->xfer_file_length;
+	base = ACCESS_ONCE(dev->rx_completed);
 
 	DBG(cdev, "receive_file_work(%lld)\n", count);
 	if (!IS_ALIGNED(count, dev->ep_out->maxpacket))
 		DBG(cdev, "%s- count(%lld) not multiple of mtu(%d)\n", __func__,
 						count, dev->ep_out->maxpacket);
 
-	while (count > 0 || write_req) {
-		if (count > 0) {
-			
-			read_req = dev->rx_req[cur_buf];
-			cur_buf = (cur_buf + 1) % RX_REQ_MAX;
+	while (count > 0) {
+		/*
+		 * Keep every OUT request queued up to the end of the
+		 * transfer, so that the host keeps sending while the
+		 * oldest completed request is written to the file.
+		 */
+		while (pending < dev->rx_reqs && queued < count) {
+			read_req = dev->rx_req[head];
+			head = (head + 1) % dev->rx_reqs;
 
-			
 			read_req->length = mtp_rx_req_len;
 
 			dev->rx_done = 0;
@@ -921,63 +1050,70 @@ static void receive_file_work(struct work_struct *data)
 				r = -EIO;
 				if (dev->state != STATE_OFFLINE)
 					dev->state = STATE_ERROR;
-				break;
+				goto out;
 			}
+			pending++;
+			queued += read_req->length;
 		}
 
-		if (write_req) {
-			DBG(cdev, "rx %p %d\n", write_req, write_req->actual);
-			start_time = ktime_get();
-			ret = vfs_write(filp, write_req->buf, write_req->actual,
-				&offset);
-			DBG(cdev, "vfs_write %d\n", ret);
-			if (ret != write_req->actual) {
+		read_req = dev->rx_req[tail];
+		ret = wait_event_interruptible(dev->read_wq,
+			ACCESS_ONCE(dev->rx_completed) - base > retired ||
+			dev->state != STATE_BUSY);
+		if (dev->state == STATE_CANCELED
+				|| dev->state == STATE_OFFLINE
+				|| dev->state == STATE_ERROR) {
+			if (dev->state == STATE_OFFLINE)
 				r = -EIO;
-				if (dev->state != STATE_OFFLINE)
-					dev->state = STATE_ERROR;
-				break;
-			}
-			dev->perf[dev->dbg_write_index].vfs_wtime =
-				ktime_to_us(ktime_sub(ktime_get(), start_time));
-			dev->perf[dev->dbg_write_index].vfs_wbytes = ret;
-			dev->dbg_write_index =
-				(dev->dbg_write_index + 1) % MAX_ITERATION;
-			write_req = NULL;
+			else if (dev->state == STATE_ERROR)
+				r = -EIO;
+			else
+				r = -ECANCELED;
+			goto out;
+		}
+		if (ret < 0) {
+			r = ret;
+			goto out;
+		}
+		tail = (tail + 1) % dev->rx_reqs;
+		pending--;
+		retired++;
+		queued -= read_req->length;
+
+		if (count < read_req->length)
+			read_req->actual = (read_req->actual > count ?
+					count : read_req->actual);
+		if (count != 0xFFFFFFFF)
+			count -= read_req->actual;
+		if (read_req->actual < read_req->length) {
+			DBG(cdev, "got short packet\n");
+			count = 0;
 		}
 
-		if (read_req) {
-			
-			ret = wait_event_interruptible(dev->read_wq,
-				dev->rx_done || dev->state != STATE_BUSY);
-			
-			if (dev->state == STATE_CANCELED
-					|| dev->state == STATE_OFFLINE
-					|| dev->state == STATE_ERROR) {
-				if (dev->state == STATE_OFFLINE)
-					r = -EIO;
-				else if (dev->state == STATE_ERROR)
-					r = -EIO;
-				else
-					r = -ECANCELED;
-				if (!dev->rx_done)
-					usb_ep_dequeue(dev->ep_out, read_req);
-				break;
-			}
-			
-			
-			if (count < read_req->length)
-				read_req->actual = (read_req->actual > count ?
-						count : read_req->actual);
-			if (count != 0xFFFFFFFF)
-				count -= read_req->actual;
-			if (read_req->actual < read_req->length) {
-				DBG(cdev, "got short packet\n");
-				count = 0;
-			}
-
-			write_req = read_req;
-			read_req = NULL;
+		write_req = read_req;
+		DBG(cdev, "rx %p %d\n", write_req, write_req->actual);
+		start_time = ktime_get();
+		ret = vfs_write(filp, write_req->buf, write_req->actual,
+			&offset);
+		DBG(cdev, "vfs_write %d\n", ret);
+		if (ret != write_req->actual) {
+			r = -EIO;
+			if (dev->state != STATE_OFFLINE)
+				dev->state = STATE_ERROR;
+			goto out;
 		}
+		dev->perf[dev->dbg_write_index].vfs_wtime =
+			ktime_to_us(ktime_sub(ktime_get(), start_time));
+		dev->perf[dev->dbg_write_index].vfs_wbytes = ret;
+		dev->dbg_write_index =
+			(dev->dbg_write_index + 1) % MAX_ITERATION;
+	}
+
+out:
+	/* requests queued past a short packet or an error */
+	while (pending--) {
+		usb_ep_dequeue(dev->ep_out, dev->rx_req[tail]);
+		tail = (tail + 1) % dev->rx_reqs;
 	}
 
 	DBG(cdev, "receive_file_work returning %d\n", r);
@@ -1391,8 +1527,10 @@ mtp_function_unbind(struct usb_configuration *c, struct usb_function *f)
 	mtp_string_defs[INTERFACE_STRING_INDEX].id = 0;
 	while ((req = mtp_req_get(dev, &dev->tx_idle)))
 		mtp_request_free(req, dev->ep_in);
-	for (i = 0; i < RX_REQ_MAX; i++)
+	for (i = 0; i < dev->rx_reqs; i++) {
 		mtp_request_free(dev->rx_req[i], dev->ep_out);
+		dev->rx_req[i] = NULL;
+	}
 	while ((req = mtp_req_get(dev, &dev->intr_idle)))
 		mtp_request_free(req, dev->ep_intr);
 	dev->state = STATE_OFFLINE;
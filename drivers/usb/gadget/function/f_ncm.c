@@ -77,6 +77,13 @@ static inline unsigned ncm_bitrate(struct usb_gadget *g)
 
 #define NTB_DEFAULT_IN_SIZE_NCM	16384
 #define NTB_OUT_SIZE_NCM	16384
+/* NTB16 block lengths are 16 bit */
+#define NTB_OUT_MAX_SIZE_NCM	65535
+
+/* Largest NTB the host may send; bigger NTBs carry more datagrams */
+static unsigned int ntb_out_size = NTB_OUT_SIZE_NCM;
+module_param(ntb_out_size, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(ntb_out_size, "Maximum NTB size accepted from the host");
 
 #define MAX_TX_NONFIXED		(512 * 3)
 
@@ -476,6 +483,9 @@ static inline void ncm_reset_values(struct f_ncm *ncm)
 	
 	ncm->port.header_len = 0;
 
+	ntb_parameters_ncm.dwNtbOutMaxSize = cpu_to_le32(clamp_t(unsigned int,
+			ntb_out_size, USB_CDC_NCM_NTB_MIN_OUT_SIZE,
+			NTB_OUT_MAX_SIZE_NCM));
 	ncm->port.fixed_out_len = le32_to_cpu(ntb_parameters_ncm.dwNtbOutMaxSize);
 	ncm->port.fixed_in_len = NTB_DEFAULT_IN_SIZE_NCM;
 }
@@ -26,6 +26,7 @@
 #include <linux/seq_file.h>
 #include <linux/notifier.h>
 #include <linux/cpufreq.h>
+#include <linux/hrtimer.h>
 #include "u_ether.h"
 
 
@@ -34,6 +35,7 @@
 
 static struct workqueue_struct	*uether_wq;
 static struct workqueue_struct	*uether_tx_wq;
+static struct workqueue_struct	*uether_rx_wq;
 
 static int tx_start_threshold = 1500;
 module_param(tx_start_threshold, uint, S_IRUGO | S_IWUSR);
@@ -93,6 +95,7 @@ struct eth_dev {
 	struct work_struct	work;
 	struct work_struct	rx_work;
 	struct work_struct	tx_work;
+	struct hrtimer		tx_flush_timer;
 
 	unsigned long		todo;
 	unsigned long		flags;
@@ -113,6 +116,13 @@ struct eth_dev {
 	unsigned int		tx_bytes_rcvd;
 	unsigned int		loop_brk_cnt;
 	unsigned long		skb_expand_cnt;
+	unsigned long		tx_aggr_pkts;
+	unsigned long		tx_aggr_xfers;
+	unsigned long		tx_aggr_timeouts;
+	unsigned long		rx_xfers;
+	ktime_t			stats_start;
+	unsigned long		stats_tx_bytes;
+	unsigned long		stats_rx_bytes;
 	struct dentry		*uether_dent;
 
 	enum ifc_state		state;
@@ -154,6 +164,23 @@ static inline int qlen(struct usb_gadget *gadget, unsigned qmult)
 static unsigned int u_ether_rx_pending_thld = U_ETHER_RX_PENDING_TSHOLD;
 module_param(u_ether_rx_pending_thld, uint, S_IRUGO | S_IWUSR);
 
+/*
+ * With multi packet transfers, IN packets are appended to a pending
+ * request while more than tx_aggr_hold_reqs requests are in flight, and
+ * the pending request is sent when one of those completes. Requests are
+ * queued without interrupt in batches, so the hold is also bounded by
+ * tx_aggr_flush_us, after which the pending request is sent anyway.
+ */
+static unsigned int tx_aggr_hold_reqs = MAX_TX_REQ_WITH_NO_INT;
+module_param(tx_aggr_hold_reqs, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(tx_aggr_hold_reqs,
+	"Requests in flight above which IN packets are aggregated");
+
+static unsigned int tx_aggr_flush_us = 500;
+module_param(tx_aggr_flush_us, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(tx_aggr_flush_us,
+	"Longest time an aggregated IN packet waits, 0 waits for completions");
+
 
 
 #undef DBG
@@ -336,6 +363,7 @@ static void rx_complete(struct usb_ep *ep, struct usb_request *req)
 	
 	case 0:
 		skb_put(skb, req->actual);
+		dev->rx_xfers++;
 		if (dev->unwrap) {
 			unsigned long	flags;
 
@@ -405,8 +433,12 @@ clean:
 		spin_unlock(&dev->req_lock);
 	}
 
+	/*
+	 * Frames are handed to the stack on the CPU that completed them,
+	 * instead of all going through the single threaded uether_wq.
+	 */
 	if (queue)
-		queue_work(uether_wq, &dev->rx_work);
+		queue_work(uether_rx_wq, &dev->rx_work);
 }
 
 static int prealloc(struct list_head *list,
@@ -619,16 +651,97 @@ static void eth_work(struct work_struct *work)
 		DBG(dev, "work done, flags = 0x%lx\n", dev->todo);
 }
 
+/*
+ * Send the request at the head of tx_reqs if eth_start_xmit() left
+ * aggregated packets in it.
+ */
+static void eth_tx_flush_held(struct eth_dev *dev, struct gether *port)
+{
+	struct usb_ep *in = port->in_ep;
+	struct usb_request *req;
+	unsigned long flags;
+	int length;
+	int retval;
+
+	spin_lock_irqsave(&dev->req_lock, flags);
+	if (list_empty(&dev->tx_reqs)) {
+		spin_unlock_irqrestore(&dev->req_lock, flags);
+		return;
+	}
+	req = container_of(dev->tx_reqs.next, struct usb_request, list);
+	if (!req->length) {
+		spin_unlock_irqrestore(&dev->req_lock, flags);
+		return;
+	}
+	list_del(&req->list);
+	dev->tx_skb_hold_count = 0;
+
+	length = req->length;
+	if (port->is_fixed && length == port->fixed_in_len &&
+	    (length % in->maxpacket) == 0)
+		req->zero = 0;
+	else
+		req->zero = 1;
+
+	if (req->zero && !dev->zlp && (length % in->maxpacket) == 0) {
+		req->zero = 0;
+		length++;
+	}
+
+	dev->tx_qlen++;
+	if (dev->tx_qlen == MAX_TX_REQ_WITH_NO_INT) {
+		req->no_interrupt = 0;
+		dev->tx_qlen = 0;
+	} else {
+		req->no_interrupt = 1;
+	}
+	spin_unlock_irqrestore(&dev->req_lock, flags);
+
+	req->length = length;
+	req->complete = tx_complete;
+	retval = usb_ep_queue(in, req, GFP_ATOMIC);
+	if (retval) {
+		DBG(dev, "tx queue err %d\n", retval);
+		req->length = 0;
+		spin_lock_irqsave(&dev->req_lock, flags);
+		list_add_tail(&req->list, &dev->tx_reqs);
+		spin_unlock_irqrestore(&dev->req_lock, flags);
+		return;
+	}
+
+	spin_lock_irqsave(&dev->req_lock, flags);
+	dev->no_tx_req_used++;
+	dev->tx_aggr_xfers++;
+	spin_unlock_irqrestore(&dev->req_lock, flags);
+	dev->net->trans_start = jiffies;
+}
+
+static enum hrtimer_restart eth_tx_flush_timer(struct hrtimer *timer)
+{
+	struct eth_dev *dev = container_of(timer, struct eth_dev,
+					   tx_flush_timer);
+	struct gether *port;
+	unsigned long flags;
+
+	spin_lock_irqsave(&dev->lock, flags);
+	port = dev->port_usb;
+	spin_unlock_irqrestore(&dev->lock, flags);
+
+	/* gether_disconnect() cancels the timer before clearing port_usb */
+	if (port && port->multi_pkt_xfer) {
+		dev->tx_aggr_timeouts++;
+		eth_tx_flush_held(dev, port);
+	}
+
+	return HRTIMER_NORESTART;
+}
+
 static void tx_complete(struct usb_ep *ep, struct usb_request *req)
 {
 	struct sk_buff	*skb;
 	struct eth_dev	*dev;
 	struct net_device *net;
-	struct usb_request *new_req;
-	struct usb_ep *in;
 	int n = 1;
-	int length;
-	int retval;
 
 	if (!ep->driver_data) {
 		usb_ep_free_request(ep, req);
@@ -687,66 +800,10 @@ static void tx_complete(struct usb_ep *ep, struct usb_request *req)
 	if (dev->port_usb->multi_pkt_xfer && !req->context) {
 		dev->no_tx_req_used--;
 		req->length = 0;
-		in = dev->port_usb->in_ep;
-
-		
-		if (!req->no_interrupt && !list_empty(&dev->tx_reqs)) {
-			new_req = container_of(dev->tx_reqs.next,
-					struct usb_request, list);
-			list_del(&new_req->list);
-			spin_unlock(&dev->req_lock);
-			if (new_req->length > 0) {
-				length = new_req->length;
-
-				if (dev->port_usb->is_fixed &&
-					length == dev->port_usb->fixed_in_len &&
-					(length % in->maxpacket) == 0)
-					new_req->zero = 0;
-				else
-					new_req->zero = 1;
-
-				if (new_req->zero && !dev->zlp &&
-						(length % in->maxpacket) == 0) {
-					new_req->zero = 0;
-					length++;
-				}
+		spin_unlock(&dev->req_lock);
 
-				
-				spin_lock(&dev->req_lock);
-				dev->tx_qlen++;
-				if (dev->tx_qlen == MAX_TX_REQ_WITH_NO_INT) {
-					new_req->no_interrupt = 0;
-					dev->tx_qlen = 0;
-				} else {
-					new_req->no_interrupt = 1;
-				}
-				spin_unlock(&dev->req_lock);
-				new_req->length = length;
-				new_req->complete = tx_complete;
-				retval = usb_ep_queue(in, new_req, GFP_ATOMIC);
-				switch (retval) {
-				default:
-					DBG(dev, "tx queue err %d\n", retval);
-					new_req->length = 0;
-					spin_lock(&dev->req_lock);
-					list_add_tail(&new_req->list,
-							&dev->tx_reqs);
-					spin_unlock(&dev->req_lock);
-					break;
-				case 0:
-					spin_lock(&dev->req_lock);
-					dev->no_tx_req_used++;
-					spin_unlock(&dev->req_lock);
-					net->trans_start = jiffies;
-				}
-			} else {
-				spin_lock(&dev->req_lock);
-				list_add_tail(&new_req->list, &dev->tx_reqs);
-				spin_unlock(&dev->req_lock);
-			}
-		} else {
-			spin_unlock(&dev->req_lock);
-		}
+		if (!req->no_interrupt)
+			eth_tx_flush_held(dev, dev->port_usb);
 	} else {
 		skb = req->context;
 		
@@ -1076,17 +1133,29 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 		dev_kfree_skb_any(skb);
 
 		spin_lock_irqsave(&dev->req_lock, flags);
+		dev->tx_aggr_pkts++;
 		dev->tx_skb_hold_count++;
-		if (dev->tx_skb_hold_count < dev->dl_max_pkts_per_xfer) {
+		if (dev->tx_skb_hold_count < dev->dl_max_pkts_per_xfer &&
+		    (!dev->dl_max_xfer_size ||
+		     length + dev->header_len + net->mtu + ETH_HLEN <=
+		     dev->dl_max_xfer_size)) {
+
+			if (dev->no_tx_req_used > tx_aggr_hold_reqs) {
+				bool first = dev->tx_skb_hold_count == 1;
 
-			if (dev->no_tx_req_used > MAX_TX_REQ_WITH_NO_INT) {
 				list_add(&req->list, &dev->tx_reqs);
 				spin_unlock_irqrestore(&dev->req_lock, flags);
+				if (first && tx_aggr_flush_us)
+					hrtimer_start(&dev->tx_flush_timer,
+						ns_to_ktime(tx_aggr_flush_us *
+							    NSEC_PER_USEC),
+						HRTIMER_MODE_REL);
 				goto success;
 			}
 		}
 
 		dev->no_tx_req_used++;
+		dev->tx_aggr_xfers++;
 		dev->tx_skb_hold_count = 0;
 		spin_unlock_irqrestore(&dev->req_lock, flags);
 	} else {
@@ -1550,6 +1619,9 @@ struct eth_dev *gether_setup_name(struct usb_gadget *g,
 	INIT_WORK(&dev->work, eth_work);
 	INIT_WORK(&dev->rx_work, process_rx_w);
 	INIT_WORK(&dev->tx_work, process_tx_w);
+	hrtimer_init(&dev->tx_flush_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	dev->tx_flush_timer.function = eth_tx_flush_timer;
+	dev->stats_start = ktime_get();
 	INIT_LIST_HEAD(&dev->tx_reqs);
 	INIT_LIST_HEAD(&dev->rx_reqs);
 	INIT_WORK(&dev->cpu_policy_w, update_cpu_policy_w);
@@ -1623,6 +1695,9 @@ struct net_device *gether_setup_name_default(const char *netname)
 	INIT_WORK(&dev->work, eth_work);
 	INIT_WORK(&dev->rx_work, process_rx_w);
 	INIT_WORK(&dev->tx_work, process_tx_w);
+	hrtimer_init(&dev->tx_flush_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	dev->tx_flush_timer.function = eth_tx_flush_timer;
+	dev->stats_start = ktime_get();
 	INIT_LIST_HEAD(&dev->tx_reqs);
 	INIT_LIST_HEAD(&dev->rx_reqs);
 	INIT_WORK(&dev->cpu_policy_w, update_cpu_policy_w);
@@ -1978,6 +2053,7 @@ void gether_disconnect(struct gether *link)
 
 	netif_stop_queue(dev->net);
 	netif_carrier_off(dev->net);
+	hrtimer_cancel(&dev->tx_flush_timer);
 
 	usb_ep_disable(link->in_ep);
 	spin_lock(&dev->req_lock);
@@ -2052,6 +2128,31 @@ void gether_disconnect(struct gether *link)
 EXPORT_SYMBOL_GPL(gether_disconnect);
 
 
+/* Aggregation ratios and throughput since the last reset of the stats */
+static void uether_aggr_stat_show(struct seq_file *s, struct eth_dev *dev)
+{
+	s64 ms = ktime_to_ms(ktime_sub(ktime_get(), dev->stats_start));
+	unsigned long tx_bytes, rx_bytes;
+
+	tx_bytes = dev->net->stats.tx_bytes - dev->stats_tx_bytes;
+	rx_bytes = dev->net->stats.rx_bytes - dev->stats_rx_bytes;
+	if (ms <= 0)
+		ms = 1;
+
+	seq_printf(s, "tx_aggr_pkts = %lu tx_aggr_xfers = %lu ratio = %lu\n",
+			dev->tx_aggr_pkts, dev->tx_aggr_xfers,
+			dev->tx_aggr_xfers ?
+			dev->tx_aggr_pkts / dev->tx_aggr_xfers : 0);
+	seq_printf(s, "tx_aggr_timeouts = %lu\n", dev->tx_aggr_timeouts);
+	seq_printf(s, "rx_pkts = %lu rx_xfers = %lu ratio = %lu\n",
+			dev->net->stats.rx_packets, dev->rx_xfers,
+			dev->rx_xfers ?
+			dev->net->stats.rx_packets / dev->rx_xfers : 0);
+	seq_printf(s, "tx_kbps = %llu rx_kbps = %llu\n",
+			div64_u64((u64)tx_bytes * 8, ms),
+			div64_u64((u64)rx_bytes * 8, ms));
+}
+
 static int uether_stat_show(struct seq_file *s, void *unused)
 {
 	struct eth_dev *dev = s->private;
@@ -2072,6 +2173,7 @@ static int uether_stat_show(struct seq_file *s, void *unused)
 					dev->tx_pkts_rcvd);
 		seq_printf(s, "skb_expand_cnt = %lu\n",
 					dev->skb_expand_cnt);
+		uether_aggr_stat_show(s, dev);
 	}
 
 	return ret;
@@ -2094,6 +2196,13 @@ static ssize_t uether_stat_reset(struct file *file,
 	dev->tx_throttle = 0;
 	dev->rx_throttle = 0;
 	dev->skb_expand_cnt = 0;
+	dev->tx_aggr_pkts = 0;
+	dev->tx_aggr_xfers = 0;
+	dev->tx_aggr_timeouts = 0;
+	dev->rx_xfers = 0;
+	dev->stats_start = ktime_get();
+	dev->stats_tx_bytes = dev->net->stats.tx_bytes;
+	dev->stats_rx_bytes = dev->net->stats.rx_bytes;
 	spin_unlock_irqrestore(&dev->lock, flags);
 	return count;
 }
@@ -2188,12 +2297,21 @@ static int __init gether_init(void)
 		return -ENOMEM;
 	}
 
+	uether_rx_wq = alloc_workqueue("uether_rx", WQ_HIGHPRI, 0);
+	if (!uether_rx_wq) {
+		destroy_workqueue(uether_tx_wq);
+		destroy_workqueue(uether_wq);
+		pr_err("%s: Unable to create workqueue: uether_rx\n", __func__);
+		return -ENOMEM;
+	}
+
 	return 0;
 }
 module_init(gether_init);
 
 static void __exit gether_exit(void)
 {
+	destroy_workqueue(uether_rx_wq);
 	destroy_workqueue(uether_tx_wq);
 	destroy_workqueue(uether_wq);
 
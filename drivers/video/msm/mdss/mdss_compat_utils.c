@@ -228,6 +228,7 @@ static struct mdp_input_layer *__create_layer_list(
 		layer->src_rect = layer32->src_rect;
 		layer->dst_rect = layer32->dst_rect;
 		layer->buffer = layer32->buffer;
+		layer->damage_rect = layer32->damage_rect;
 		memcpy(&layer->reserved, &layer32->reserved,
 			sizeof(layer->reserved));
 
@@ -505,7 +505,8 @@ struct mdp_input_layer32 {
 	struct mdp_layer_buffer	buffer;
 	compat_caddr_t		pp_info;
 	int			error_code;
-	uint32_t		reserved[6];
+	struct mdp_rect		damage_rect;
+	uint32_t		reserved[2];
 };
 
 struct mdp_output_layer32 {
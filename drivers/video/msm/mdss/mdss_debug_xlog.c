@@ -13,6 +13,7 @@
 
 #include <linux/delay.h>
 #include <linux/spinlock.h>
+#include <linux/percpu.h>
 #include <linux/ktime.h>
 #include <linux/debugfs.h>
 #include <linux/uaccess.h>
@@ -35,15 +36,16 @@
 
 #define MDSS_XLOG_PRINT_ENTRY	256
 
-#define MDSS_XLOG_ENTRY	(MDSS_XLOG_PRINT_ENTRY * 4)
+/* Entries in each per-cpu ring, must be a power of two */
+#define MDSS_XLOG_ENTRY	MDSS_XLOG_PRINT_ENTRY
 #define MDSS_XLOG_MAX_DATA 15
 #define MDSS_XLOG_BUF_MAX 512
 #define MDSS_XLOG_BUF_ALIGN 32
 
-DEFINE_SPINLOCK(xlock);
+/* Serializes the dump cursors, never taken by the logging path */
+static DEFINE_SPINLOCK(xlog_dump_lock);
 
 struct tlog {
-	u32 counter;
 	s64 time;
 	const char *name;
 	int line;
@@ -52,11 +54,27 @@ struct tlog {
 	int pid;
 };
 
-struct mdss_dbg_xlog {
+/*
+ * struct mdss_xlog_ring - per-cpu log ring
+ * @logs: Ring of log entries
+ * @reserved: Index of the next entry to be written, bumped before the write
+ * @committed: Index past the last completely written entry
+ * @next: Index of the next entry to dump
+ *
+ * Only the owning cpu writes the ring, with interrupts off, so no lock is
+ * needed to log. The dump side reads other cpus' rings and uses @reserved to
+ * detect entries overwritten while they were being copied.
+ */
+struct mdss_xlog_ring {
 	struct tlog logs[MDSS_XLOG_ENTRY];
-	u32 first;
-	u32 last;
-	u32 curr;
+	u32 reserved;
+	u32 committed;
+	u32 next;
+};
+
+static DEFINE_PER_CPU(struct mdss_xlog_ring, mdss_xlog_rings);
+
+struct mdss_dbg_xlog {
 	struct dentry *xlog;
 	u32 xlog_enable;
 	u32 panic_on_err;
@@ -71,6 +89,7 @@ struct mdss_dbg_xlog {
 	u32 *dbgbus_dump; 
 	u32 *vbif_dbgbus_dump; 
 	u32 *nrt_vbif_dbgbus_dump; 
+	s64 prev_time;
 } mdss_dbg_xlog;
 
 static inline bool mdss_xlog_is_enabled(u32 flag)
@@ -85,13 +104,20 @@ void mdss_xlog(const char *name, int line, int flag, ...)
 	int i, val = 0;
 	va_list args;
 	struct tlog *log;
+	struct mdss_xlog_ring *ring;
+	u32 idx;
 
 	if (!mdss_xlog_is_enabled(flag))
 		return;
 
-	spin_lock_irqsave(&xlock, flags);
-	log = &mdss_dbg_xlog.logs[mdss_dbg_xlog.curr];
-	log->time = ktime_to_us(ktime_get());
+	local_irq_save(flags);
+	ring = this_cpu_ptr(&mdss_xlog_rings);
+	idx = ring->reserved++;
+	/* Let the dump side see the slot is being reused before it changes */
+	smp_wmb();
+
+	log = &ring->logs[idx & (MDSS_XLOG_ENTRY - 1)];
+	log->time = ktime_to_ns(ktime_get());
 	log->name = name;
 	log->line = line;
 	log->data_cnt = 0;
@@ -108,61 +134,77 @@ void mdss_xlog(const char *name, int line, int flag, ...)
 	}
 	va_end(args);
 	log->data_cnt = i;
-	mdss_dbg_xlog.curr = (mdss_dbg_xlog.curr + 1) % MDSS_XLOG_ENTRY;
-	mdss_dbg_xlog.last++;
 
-	spin_unlock_irqrestore(&xlock, flags);
+	/* Publish the entry only once it is complete */
+	smp_wmb();
+	ring->committed = idx + 1;
+	local_irq_restore(flags);
 }
 
-static bool __mdss_xlog_dump_calc_range(void)
+/*
+ * Copy out the oldest undumped entry of all the cpus. Returns false once
+ * every ring has been dumped up to its last committed entry.
+ */
+static bool __mdss_xlog_dump_next(struct tlog *out, int *out_cpu)
 {
-	static u32 next;
-	bool need_dump = true;
+	struct mdss_xlog_ring *ring;
+	struct tlog log;
+	bool found = false;
 	unsigned long flags;
-	struct mdss_dbg_xlog *xlog = &mdss_dbg_xlog;
-
-	spin_lock_irqsave(&xlock, flags);
+	u32 committed;
+	int cpu, best_cpu = -1;
+
+	spin_lock_irqsave(&xlog_dump_lock, flags);
+
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu_ptr(&mdss_xlog_rings, cpu);
+
+		committed = ACCESS_ONCE(ring->committed);
+		smp_rmb();
+		while (ring->next != committed) {
+			/* Skip what the writer has already lapped */
+			if ((u32)(ACCESS_ONCE(ring->reserved) - ring->next) >
+					MDSS_XLOG_ENTRY) {
+				ring->next = ACCESS_ONCE(ring->reserved) -
+					MDSS_XLOG_ENTRY;
+				continue;
+			}
 
-	xlog->first = next;
+			log = ring->logs[ring->next & (MDSS_XLOG_ENTRY - 1)];
+			smp_rmb();
+			if ((u32)(ACCESS_ONCE(ring->reserved) - ring->next) >
+					MDSS_XLOG_ENTRY)
+				continue;
 
-	if (xlog->last == xlog->first) {
-		need_dump = false;
-		goto dump_exit;
-	}
-
-	if (xlog->last < xlog->first) {
-		xlog->first %= MDSS_XLOG_ENTRY;
-		if (xlog->last < xlog->first)
-			xlog->last += MDSS_XLOG_ENTRY;
+			if (!found || log.time < out->time) {
+				*out = log;
+				best_cpu = cpu;
+				found = true;
+			}
+			break;
+		}
 	}
 
-	if ((xlog->last - xlog->first) > MDSS_XLOG_PRINT_ENTRY) {
-		pr_warn("xlog buffer overflow before dump: %d\n",
-			xlog->last - xlog->first);
-		xlog->first = xlog->last - MDSS_XLOG_PRINT_ENTRY;
+	if (found) {
+		per_cpu_ptr(&mdss_xlog_rings, best_cpu)->next++;
+		*out_cpu = best_cpu;
 	}
-	next = xlog->first + 1;
 
-dump_exit:
-	spin_unlock_irqrestore(&xlock, flags);
+	spin_unlock_irqrestore(&xlog_dump_lock, flags);
 
-	return need_dump;
+	return found;
 }
 
-static ssize_t mdss_xlog_dump_entry(char *xlog_buf, ssize_t xlog_buf_size)
+static ssize_t mdss_xlog_dump_entry(struct tlog *log, int cpu,
+	char *xlog_buf, ssize_t xlog_buf_size)
 {
 	int i;
 	ssize_t off = 0;
-	struct tlog *log, *prev_log;
-	unsigned long flags;
-
-	spin_lock_irqsave(&xlock, flags);
+	s64 delta;
 
-	log = &mdss_dbg_xlog.logs[mdss_dbg_xlog.first %
-		MDSS_XLOG_ENTRY];
-
-	prev_log = &mdss_dbg_xlog.logs[(mdss_dbg_xlog.first - 1) %
-		MDSS_XLOG_ENTRY];
+	delta = mdss_dbg_xlog.prev_time ?
+		log->time - mdss_dbg_xlog.prev_time : 0;
+	mdss_dbg_xlog.prev_time = log->time;
 
 	off = snprintf((xlog_buf + off), (xlog_buf_size - off), "%s:%-4d",
 		log->name, log->line);
@@ -173,8 +215,9 @@ static ssize_t mdss_xlog_dump_entry(char *xlog_buf, ssize_t xlog_buf_size)
 	}
 
 	off += snprintf((xlog_buf + off), (xlog_buf_size - off),
-		"=>[%-8d:%-11llu:%9llu][%-4d]:", mdss_dbg_xlog.first,
-		log->time, (log->time - prev_log->time), log->pid);
+		"=>[%-2d:%-11llu:%9llu][%-4d]:", cpu,
+		div_s64(log->time, NSEC_PER_USEC),
+		div_s64(delta, NSEC_PER_USEC), log->pid);
 
 	for (i = 0; i < log->data_cnt; i++)
 		off += snprintf((xlog_buf + off), (xlog_buf_size - off),
@@ -182,18 +225,17 @@ static ssize_t mdss_xlog_dump_entry(char *xlog_buf, ssize_t xlog_buf_size)
 
 	off += snprintf((xlog_buf + off), (xlog_buf_size - off), "\n");
 
-	spin_unlock_irqrestore(&xlock, flags);
-
 	return off;
 }
 
 static void mdss_xlog_dump_all(void)
 {
 	char xlog_buf[MDSS_XLOG_BUF_MAX];
-	int count = 0;
+	struct tlog log;
+	int count = 0, cpu;
 
-	while (__mdss_xlog_dump_calc_range()) {
-		mdss_xlog_dump_entry(xlog_buf, MDSS_XLOG_BUF_MAX);
+	while (__mdss_xlog_dump_next(&log, &cpu)) {
+		mdss_xlog_dump_entry(&log, cpu, xlog_buf, MDSS_XLOG_BUF_MAX);
 		pr_info("%s", xlog_buf);
 		count++;
 
@@ -669,9 +711,12 @@ static ssize_t mdss_xlog_dump_read(struct file *file, char __user *buff,
 {
 	ssize_t len = 0;
 	char xlog_buf[MDSS_XLOG_BUF_MAX];
+	struct tlog log;
+	int cpu;
 
-	if (__mdss_xlog_dump_calc_range()) {
-		len = mdss_xlog_dump_entry(xlog_buf, MDSS_XLOG_BUF_MAX);
+	if (__mdss_xlog_dump_next(&log, &cpu)) {
+		len = mdss_xlog_dump_entry(&log, cpu, xlog_buf,
+			MDSS_XLOG_BUF_MAX);
 		if (copy_to_user(buff, xlog_buf, len))
 			return -EFAULT;
 		*ppos += len;
@@ -702,8 +747,6 @@ static const struct file_operations mdss_xlog_fops = {
 
 int mdss_create_xlog_debug(struct mdss_debug_data *mdd)
 {
-	int i;
-
 	mdss_dbg_xlog.xlog = debugfs_create_dir("xlog", mdd->root);
 	if (IS_ERR_OR_NULL(mdss_dbg_xlog.xlog)) {
 		pr_err("debugfs_create_dir fail, error %ld\n",
@@ -715,9 +758,6 @@ int mdss_create_xlog_debug(struct mdss_debug_data *mdd)
 	INIT_WORK(&mdss_dbg_xlog.xlog_dump_work, xlog_debug_work);
 	mdss_dbg_xlog.work_panic = false;
 
-	for (i = 0; i < MDSS_XLOG_ENTRY; i++)
-		mdss_dbg_xlog.logs[i].counter = i;
-
 	debugfs_create_file("dump", 0644, mdss_dbg_xlog.xlog, NULL,
 						&mdss_xlog_fops);
 	debugfs_create_u32("enable", 0644, mdss_dbg_xlog.xlog,
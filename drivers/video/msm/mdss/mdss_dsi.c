@@ -26,6 +26,7 @@
 #include <linux/uaccess.h>
 #include <linux/msm-bus.h>
 #include <linux/pm_qos.h>
+#include <linux/seq_file.h>
 
 #include "mdss.h"
 #include "mdss_panel.h"
@@ -465,6 +466,74 @@ static int mdss_dsi_panel_power_lp(struct mdss_panel_data *pdata, int enable)
 	return 0;
 }
 
+static int __mdss_dsi_panel_power_on(struct mdss_panel_data *pdata)
+{
+	if (pdata->panel_info.power_ctrl == PANEL_POWER_CTRL_HX8396C2)
+		return mdss_dsi_panel_power_on_hx8396c2(pdata);
+
+	return mdss_dsi_panel_power_on(pdata);
+}
+
+static void mdss_dsi_panel_power_on_work(struct work_struct *work)
+{
+	struct mdss_dsi_ctrl_pdata *ctrl_pdata;
+	ktime_t start = ktime_get();
+
+	ctrl_pdata = container_of(work, struct mdss_dsi_ctrl_pdata,
+				power_on_work);
+
+	ATRACE_BEGIN(__func__);
+	ctrl_pdata->power_on_status =
+		__mdss_dsi_panel_power_on(&ctrl_pdata->panel_data);
+	ATRACE_END(__func__);
+
+	ctrl_pdata->on_latency.power_on_us =
+		ktime_us_delta(ktime_get(), start);
+}
+
+/*
+ * Start powering the panel from a worker, so that the supply ramp and reset
+ * delays overlap with the MDP resume. Only done from full power off, the
+ * low power states keep going through mdss_dsi_panel_power_ctrl().
+ */
+static void mdss_dsi_panel_power_prepare(struct mdss_panel_data *pdata)
+{
+	struct mdss_dsi_ctrl_pdata *ctrl_pdata = container_of(pdata,
+			struct mdss_dsi_ctrl_pdata, panel_data);
+
+	if (ctrl_pdata->power_on_pending ||
+		!mdss_panel_is_power_off(pdata->panel_info.panel_power_state) ||
+		pdata->panel_info.dynamic_switch_pending)
+		return;
+
+	ctrl_pdata->on_latency.power_on_us = 0;
+	ctrl_pdata->power_on_pending = true;
+	queue_work(system_highpri_wq, &ctrl_pdata->power_on_work);
+}
+
+/* Wait for a power up started by mdss_dsi_panel_power_prepare() */
+static void mdss_dsi_panel_power_sync(struct mdss_panel_data *pdata)
+{
+	struct mdss_dsi_ctrl_pdata *ctrl_pdata = container_of(pdata,
+			struct mdss_dsi_ctrl_pdata, panel_data);
+	ktime_t start;
+
+	if (!ctrl_pdata->power_on_pending)
+		return;
+
+	start = ktime_get();
+	flush_work(&ctrl_pdata->power_on_work);
+	ctrl_pdata->on_latency.power_wait_us =
+		ktime_us_delta(ktime_get(), start);
+	ctrl_pdata->power_on_pending = false;
+
+	if (ctrl_pdata->power_on_status)
+		pr_err("%s: early panel power on failed. rc=%d\n", __func__,
+			ctrl_pdata->power_on_status);
+	else
+		pdata->panel_info.panel_power_state = MDSS_PANEL_POWER_ON;
+}
+
 static int mdss_dsi_panel_power_ctrl(struct mdss_panel_data *pdata,
 	int power_state)
 {
@@ -476,6 +545,8 @@ static int mdss_dsi_panel_power_ctrl(struct mdss_panel_data *pdata,
 		return -EINVAL;
 	}
 
+	mdss_dsi_panel_power_sync(pdata);
+
 	pinfo = &pdata->panel_info;
 	pr_debug("%s: cur_power_state=%d req_power_state=%d\n", __func__,
 		pinfo->panel_power_state, power_state);
@@ -498,12 +569,8 @@ static int mdss_dsi_panel_power_ctrl(struct mdss_panel_data *pdata,
 	case MDSS_PANEL_POWER_ON:
 		if (mdss_dsi_is_panel_on_lp(pdata))
 			ret = mdss_dsi_panel_power_lp(pdata, false);
-		else {
-			if (pinfo->power_ctrl == PANEL_POWER_CTRL_HX8396C2)
-				ret = mdss_dsi_panel_power_on_hx8396c2(pdata);
-			else
-				ret = mdss_dsi_panel_power_on(pdata);
-		}
+		else
+			ret = __mdss_dsi_panel_power_on(pdata);
 		break;
 	case MDSS_PANEL_POWER_LP1:
 	case MDSS_PANEL_POWER_LP2:
@@ -993,6 +1060,33 @@ struct dentry *dsi_debugfs_create_dcs_cmd(const char *name, umode_t mode,
 				   cmd, &mdss_dsi_cmd_fop);
 }
 
+static int mdss_dsi_on_latency_show(struct seq_file *s, void *unused)
+{
+	struct mdss_dsi_on_latency *lat = s->private;
+
+	seq_printf(s, "panel_power_us=%u wait_us=%u\n", lat->power_on_us,
+		lat->power_wait_us);
+	seq_printf(s, "link_on_us=%u\n", lat->link_on_us);
+	seq_printf(s, "panel_on_us=%u\n", lat->panel_on_us);
+	seq_printf(s, "post_panel_on_us=%u\n", lat->post_panel_on_us);
+	seq_printf(s, "panel_on_cmds=%u dma_transfers=%u\n",
+		lat->panel_on_cmd_cnt, lat->panel_on_dma_cnt);
+
+	return 0;
+}
+
+static int mdss_dsi_on_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, mdss_dsi_on_latency_show, inode->i_private);
+}
+
+static const struct file_operations mdss_dsi_on_latency_fops = {
+	.open = mdss_dsi_on_latency_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 #define DEBUGFS_CREATE_DCS_CMD(name, node, cmd, ctrl_cmd) \
 	dsi_debugfs_create_dcs_cmd(name, 0644, node, cmd, ctrl_cmd)
 
@@ -1044,6 +1138,9 @@ static int mdss_dsi_debugfs_setup(struct mdss_panel_data *pdata,
 	debugfs_create_u32("dsi_err_time_delta", 0644, dfs->root,
 			   &dfs_ctrl->err_cont.err_time_delta);
 
+	debugfs_create_file("screen_on_latency", 0444, dfs->root,
+		&ctrl_pdata->on_latency, &mdss_dsi_on_latency_fops);
+
 	dfs->override_flag = 0;
 	dfs->ctrl_pdata = *ctrl_pdata;
 	ctrl_pdata->debugfs_info = dfs;
@@ -1585,6 +1682,11 @@ static int mdss_dsi_unblank(struct mdss_panel_data *pdata)
 
 	if (!(ctrl_pdata->ctrl_state & CTRL_STATE_PANEL_INIT)) {
 		if (!pdata->panel_info.dynamic_switch_pending) {
+			struct mdss_dsi_on_latency *lat =
+				&ctrl_pdata->on_latency;
+			ktime_t start = ktime_get();
+			u32 dma_cnt = ctrl_pdata->cmd_dma_cnt;
+
 			ATRACE_BEGIN("dsi_panel_on");
 			ret = ctrl_pdata->on(pdata);
 			if (ret) {
@@ -1593,6 +1695,11 @@ static int mdss_dsi_unblank(struct mdss_panel_data *pdata)
 				goto error;
 			}
 			ATRACE_END("dsi_panel_on");
+
+			lat->panel_on_us = ktime_us_delta(ktime_get(), start);
+			lat->panel_on_cmd_cnt = ctrl_pdata->on_cmds.cmd_cnt;
+			lat->panel_on_dma_cnt = ctrl_pdata->cmd_dma_cnt -
+				dma_cnt;
 		}
 		ctrl_pdata->ctrl_state |= CTRL_STATE_PANEL_INIT;
 	}
@@ -1716,8 +1823,13 @@ static int mdss_dsi_post_panel_on(struct mdss_panel_data *pdata)
 	mdss_dsi_clk_ctrl(ctrl_pdata, ctrl_pdata->dsi_clk_handle,
 			  MDSS_DSI_ALL_CLKS, MDSS_DSI_CLK_ON);
 
-	if (ctrl_pdata->post_panel_on)
+	if (ctrl_pdata->post_panel_on) {
+		ktime_t start = ktime_get();
+
 		ctrl_pdata->post_panel_on(pdata);
+		ctrl_pdata->on_latency.post_panel_on_us =
+			ktime_us_delta(ktime_get(), start);
+	}
 
 	mdss_dsi_clk_ctrl(ctrl_pdata, ctrl_pdata->dsi_clk_handle,
 			  MDSS_DSI_ALL_CLKS, MDSS_DSI_CLK_OFF);
@@ -2466,6 +2578,7 @@ static int mdss_dsi_event_handler(struct mdss_panel_data *pdata,
 	int power_state;
 	u32 mode;
 	struct mdss_panel_info *pinfo;
+	ktime_t start;
 
 	if (pdata == NULL) {
 		pr_err("%s: Invalid input data\n", __func__);
@@ -2492,7 +2605,10 @@ static int mdss_dsi_event_handler(struct mdss_panel_data *pdata,
 
 		mdss_dsi_get_hw_revision(ctrl_pdata);
 		mdss_dsi_get_phy_revision(ctrl_pdata);
+		start = ktime_get();
 		rc = mdss_dsi_on(pdata);
+		ctrl_pdata->on_latency.link_on_us =
+			ktime_us_delta(ktime_get(), start);
 		mdss_dsi_op_mode_config(pdata->panel_info.mipi.mode,
 							pdata);
 		break;
@@ -2612,6 +2728,9 @@ static int mdss_dsi_event_handler(struct mdss_panel_data *pdata,
 	case MDSS_EVENT_PANEL_VDDIO_SWITCH_OFF:
 		mdss_dsi_vddio_switch(ctrl_pdata, 0);
 		break;
+	case MDSS_EVENT_PANEL_POWER_PREPARE:
+		mdss_dsi_panel_power_prepare(pdata);
+		break;
 	default:
 		pr_debug("%s: unhandled event=%d\n", __func__, event);
 		break;
@@ -3101,6 +3220,7 @@ static int mdss_dsi_ctrl_probe(struct platform_device *pdev)
 	}
 
 	INIT_DELAYED_WORK(&ctrl_pdata->dba_work, mdss_dsi_dba_work);
+	INIT_WORK(&ctrl_pdata->power_on_work, mdss_dsi_panel_power_on_work);
 
 	pr_debug("%s: Dsi Ctrl->%d initialized\n", __func__, index);
 
@@ -335,6 +335,26 @@ struct dsi_err_container {
 	s64 err_time[MAX_ERR_INDEX];
 };
 
+/*
+ * struct mdss_dsi_on_latency - time spent in each step of the last screen on
+ * @link_on_us: Controller power up and link setup
+ * @panel_on_us: Sending the panel on command set
+ * @post_panel_on_us: Sending the post panel on command set
+ * @power_on_us: Panel supply ramp and reset, run ahead of the link
+ * @power_wait_us: Time the link bring-up still had to wait for it
+ * @panel_on_cmd_cnt: Commands in the panel on command set
+ * @panel_on_dma_cnt: DMA transfers used to send them
+ */
+struct mdss_dsi_on_latency {
+	u32 link_on_us;
+	u32 panel_on_us;
+	u32 post_panel_on_us;
+	u32 power_on_us;
+	u32 power_wait_us;
+	u32 panel_on_cmd_cnt;
+	u32 panel_on_dma_cnt;
+};
+
 #define DSI_CTRL_LEFT		DSI_CTRL_0
 #define DSI_CTRL_RIGHT		DSI_CTRL_1
 #define DSI_CTRL_CLK_SLAVE	DSI_CTRL_RIGHT
@@ -412,6 +432,15 @@ struct mdss_dsi_ctrl_pdata {
 
 	bool cmd_sync_wait_broadcast;
 	bool cmd_sync_wait_trigger;
+	/* pack consecutive commands without a wait into one dma transfer */
+	bool cmd_batch;
+	u32 cmd_dma_cnt;
+	struct mdss_dsi_on_latency on_latency;
+
+	/* panel power up started ahead of MDSS_EVENT_LINK_READY */
+	struct work_struct power_on_work;
+	bool power_on_pending;
+	int power_on_status;
 
 	struct mdss_rect roi;
 	struct pwm_device *pwm_bl;
@@ -1432,6 +1432,28 @@ static int mdss_dsi_cmd_dma_tpg_tx(struct mdss_dsi_ctrl_pdata *ctrl,
 	return ret;
 }
 
+/*
+ * With command batching a command is only sent along with the ones queued
+ * before it when it asks for a wait, when it is the last one in the list or
+ * when the next one would not fit in the dma buffer.
+ */
+static bool mdss_dsi_cmd_is_last(struct mdss_dsi_ctrl_pdata *ctrl,
+	struct dsi_cmd_desc *cm, int remaining)
+{
+	struct dsi_buf *tp = &ctrl->tx_buf;
+	int next_len;
+
+	if (cm->dchdr.last || !ctrl->cmd_batch)
+		return cm->dchdr.last;
+
+	if (!remaining || cm->dchdr.wait)
+		return true;
+
+	/* leave room for the 8 byte alignment done by mdss_dsi_buf_init */
+	next_len = DSI_HOST_HDR_SIZE + ALIGN((cm + 1)->dchdr.dlen, 4);
+	return tp->len + next_len + 8 > tp->size;
+}
+
 static int mdss_dsi_cmds2buf_tx(struct mdss_dsi_ctrl_pdata *ctrl,
 			struct dsi_cmd_desc *cmds, int cnt, int use_dma_tpg)
 {
@@ -1439,6 +1461,7 @@ static int mdss_dsi_cmds2buf_tx(struct mdss_dsi_ctrl_pdata *ctrl,
 	struct dsi_cmd_desc *cm;
 	struct dsi_ctrl_hdr *dchdr;
 	int len, wait, tot = 0;
+	struct dsi_cmd_desc batched;
 
 	tp = &ctrl->tx_buf;
 	mdss_dsi_buf_init(tp);
@@ -1454,6 +1477,11 @@ static int mdss_dsi_cmds2buf_tx(struct mdss_dsi_ctrl_pdata *ctrl,
 			return 0;
 		}
 		tot += len;
+		if (ctrl->cmd_batch && !dchdr->last) {
+			batched = *cm;
+			dchdr = &batched.dchdr;
+			dchdr->last = mdss_dsi_cmd_is_last(ctrl, cm, cnt);
+		}
 		if (dchdr->last) {
 			tp->data = tp->start; 
 
@@ -1472,6 +1500,7 @@ static int mdss_dsi_cmds2buf_tx(struct mdss_dsi_ctrl_pdata *ctrl,
 			}
 			pr_debug("%s: cmd_dma_tx for cmd = 0x%x, len = %d\n",
 					__func__,  cm->payload[0], len);
+			ctrl->cmd_dma_cnt++;
 
 			if (!wait || dchdr->wait > VSYNC_PERIOD)
 				usleep_range(dchdr->wait * 1000, dchdr->wait * 1000);
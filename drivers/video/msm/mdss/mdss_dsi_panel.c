@@ -2206,6 +2206,8 @@ static int mdss_panel_parse_dt(struct device_node *np,
 		"qcom,mdss-dsi-rx-eot-ignore");
 	pinfo->mipi.tx_eot_append = of_property_read_bool(np,
 		"qcom,mdss-dsi-tx-eot-append");
+	ctrl_pdata->cmd_batch = of_property_read_bool(np,
+		"qcom,mdss-dsi-cmd-batch");
 
 	rc = of_property_read_u32(np, "qcom,mdss-dsi-stream", &tmp);
 	pinfo->mipi.stream = (!rc ? tmp : 0);
@@ -49,6 +49,7 @@
 #include <linux/file.h>
 #include <linux/kthread.h>
 #include <linux/dma-buf.h>
+#include <soc/qcom/boot_stats.h>
 #include "mdss_fb.h"
 #include "mdss_htc_util.h"
 #include "mdss_mdp_splash_logo.h"
@@ -83,6 +84,8 @@ static u32 mdss_fb_pseudo_palette[16] = {
 };
 
 static struct msm_mdp_interface *mdp_instance;
+static BLOCKING_NOTIFIER_HEAD(mdss_fb_frame_notifier_list);
+static bool first_frame_done;
 
 static int mdss_fb_register(struct msm_fb_data_type *mfd);
 static int mdss_fb_open(struct fb_info *info, int user);
@@ -537,6 +540,10 @@ static void __mdss_fb_idle_notify_work(struct work_struct *work)
 	if (mfd->idle_time)
 		sysfs_notify(&mfd->fbi->dev->kobj, NULL, "idle_notify");
 	mfd->idle_state = MDSS_FB_IDLE;
+
+	if (mfd->panel_info->pdest == DISPLAY_1)
+		blocking_notifier_call_chain(&mdss_fb_frame_notifier_list,
+					     MDSS_FB_FRAME_IDLE, NULL);
 }
 
 static ssize_t mdss_fb_get_idle_time(struct device *dev,
@@ -2436,6 +2443,8 @@ static int mdss_fb_register(struct msm_fb_data_type *mfd)
 	atomic_set(&mfd->commits_pending, 0);
 	atomic_set(&mfd->ioctl_ref_cnt, 0);
 	atomic_set(&mfd->kickoff_pending, 0);
+	atomic_set(&mfd->cfg_pending, 0);
+	mfd->cfg_latched = true;
 
 	init_timer(&mfd->no_update.timer);
 	mfd->no_update.timer.function = mdss_fb_no_update_notify_timer_cb;
@@ -2764,6 +2773,22 @@ static void mdss_fb_release_kickoff(struct msm_fb_data_type *mfd)
 	}
 }
 
+/*
+ * Called once the atomic commit being kicked off has programmed its
+ * configuration. From here on the next commit can be prepared while this one
+ * waits for its fences and goes out to the panel.
+ */
+static void mdss_fb_release_cfg(struct msm_fb_data_type *mfd)
+{
+	mutex_lock(&mfd->mdp_sync_pt_data.sync_mutex);
+	if (!mfd->cfg_latched) {
+		mfd->cfg_latched = true;
+		atomic_dec_if_positive(&mfd->cfg_pending);
+		wake_up_all(&mfd->kickoff_wait_q);
+	}
+	mutex_unlock(&mfd->mdp_sync_pt_data.sync_mutex);
+}
+
 static int __mdss_fb_sync_buf_done_callback(struct notifier_block *p,
 		unsigned long event, void *data)
 {
@@ -2816,10 +2841,12 @@ static int __mdss_fb_sync_buf_done_callback(struct notifier_block *p,
 		mdss_fb_signal_timeline(sync_pt_data);
 		break;
 	case MDP_NOTIFY_FRAME_CFG_DONE:
-		if (sync_pt_data->async_wait_fences)
+		if (sync_pt_data->async_wait_fences) {
 			__mdss_fb_copy_fence(sync_pt_data,
 					sync_pt_data->temp_fen,
 					&sync_pt_data->temp_fen_cnt);
+			mdss_fb_release_cfg(mfd);
+		}
 		break;
 	case MDP_NOTIFY_FRAME_CTX_DONE:
 		mdss_fb_release_kickoff(mfd);
@@ -2862,7 +2889,8 @@ static int mdss_fb_wait_for_kickoff(struct msm_fb_data_type *mfd)
 		return mdss_fb_pan_idle(mfd);
 
 	ret = wait_event_timeout(mfd->kickoff_wait_q,
-			(!atomic_read(&mfd->kickoff_pending) ||
+			((!atomic_read(&mfd->kickoff_pending) &&
+			  !atomic_read(&mfd->cfg_pending)) ||
 			 mfd->shutdown_pending),
 			msecs_to_jiffies(WAIT_DISP_OP_TIMEOUT));
 	if (!ret) {
@@ -2883,6 +2911,43 @@ static int mdss_fb_wait_for_kickoff(struct msm_fb_data_type *mfd)
 	return ret;
 }
 
+/*
+ * Wait for room to queue another atomic commit. The previous commit only
+ * needs to have latched its configuration, its fence waits and kickoff
+ * carry on in the display thread. Up to MDSS_FB_MAX_COMMITS_IN_FLIGHT
+ * commits can be queued at once.
+ */
+static int mdss_fb_wait_for_commit_slot(struct msm_fb_data_type *mfd)
+{
+	int ret = 0;
+
+	if (!mfd->wait_for_kickoff || !mfd->mdp_sync_pt_data.async_wait_fences)
+		return mdss_fb_pan_idle(mfd);
+
+	ret = wait_event_timeout(mfd->kickoff_wait_q,
+			((!atomic_read(&mfd->cfg_pending) &&
+			  atomic_read(&mfd->commits_pending) <
+				MDSS_FB_MAX_COMMITS_IN_FLIGHT) ||
+			 mfd->shutdown_pending),
+			msecs_to_jiffies(WAIT_DISP_OP_TIMEOUT));
+	if (!ret) {
+		pr_err("%pS: wait for commit timeout cfg=%d commits=%d\n",
+				__builtin_return_address(0),
+				atomic_read(&mfd->cfg_pending),
+				atomic_read(&mfd->commits_pending));
+		MDSS_XLOG_TOUT_HANDLER("mdp", "vbif", "vbif_nrt",
+			"dbg_bus", "vbif_dbg_bus");
+		ret = -ETIMEDOUT;
+	} else if (mfd->shutdown_pending) {
+		pr_debug("Shutdown signalled\n");
+		ret = -ESHUTDOWN;
+	} else {
+		ret = 0;
+	}
+
+	return ret;
+}
+
 static int mdss_fb_pan_display_ex(struct fb_info *info,
 		struct mdp_display_commit *disp_commit)
 {
@@ -3042,9 +3107,9 @@ int mdss_fb_atomic_commit(struct fb_info *info,
 		}
 		goto end;
 	} else {
-		ret = mdss_fb_pan_idle(mfd);
+		ret = mdss_fb_wait_for_commit_slot(mfd);
 		if (ret) {
-			pr_err("pan display idle call failed\n");
+			pr_err("wait for commit slot failed\n");
 			goto end;
 		}
 
@@ -3064,6 +3129,7 @@ int mdss_fb_atomic_commit(struct fb_info *info,
 	atomic_inc(&mfd->mdp_sync_pt_data.commit_cnt);
 	atomic_inc(&mfd->commits_pending);
 	atomic_inc(&mfd->kickoff_pending);
+	atomic_inc(&mfd->cfg_pending);
 	MDSS_XLOG(mfd->index, atomic_read(&mfd->commits_pending), atomic_read(&mfd->kickoff_pending));
 	wake_up_all(&mfd->commit_wait_q);
 	mutex_unlock(&mfd->mdp_sync_pt_data.sync_mutex);
@@ -3232,13 +3298,19 @@ static int __mdss_fb_perform_commit(struct msm_fb_data_type *mfd)
 			pr_warn("no kickoff function setup for fb%d\n",
 					mfd->index);
 	} else if (fb_backup->atomic_commit) {
+		/*
+		 * Clear the flag before the kickoff, the next atomic commit
+		 * may be queued as soon as this one has latched its config.
+		 */
+		fb_backup->atomic_commit = false;
+		mfd->cfg_latched = false;
 		if (mfd->mdp.kickoff_fnc)
 			ret = mfd->mdp.kickoff_fnc(mfd,
 					&fb_backup->disp_commit);
 		else
 			pr_warn("no kickoff function setup for fb%d\n",
 				mfd->index);
-		fb_backup->atomic_commit = false;
+		mdss_fb_release_cfg(mfd);
 	} else {
 		ret = mdss_fb_pan_display_sub(&fb_backup->disp_commit.var,
 				&fb_backup->info);
@@ -3248,6 +3320,10 @@ static int __mdss_fb_perform_commit(struct msm_fb_data_type *mfd)
 	}
 	if (!ret) {
 		if (mfd->panel_info->pdest == DISPLAY_1) {
+			if (unlikely(!first_frame_done)) {
+				first_frame_done = true;
+				boot_stats_marker("first_frame");
+			}
 			htc_set_cabc(mfd, 0);	
 			htc_set_color_temp(mfd, 0);
 			htc_set_color_profile(mfd, 0);
@@ -3272,6 +3348,22 @@ static int __mdss_fb_perform_commit(struct msm_fb_data_type *mfd)
 	return ret;
 }
 
+/* Tell frame listeners, such as cpu-boost, that a frame went out */
+static void mdss_fb_notify_frame_commit(struct msm_fb_data_type *mfd)
+{
+	ktime_t now = ktime_get();
+	u64 frame_us;
+
+	if (mfd->panel_info->pdest != DISPLAY_1)
+		return;
+
+	frame_us = ktime_us_delta(now, mfd->last_frame_commit);
+	mfd->last_frame_commit = now;
+
+	blocking_notifier_call_chain(&mdss_fb_frame_notifier_list,
+				     MDSS_FB_FRAME_COMMITTED, &frame_us);
+}
+
 static int __mdss_fb_display_thread(void *data)
 {
 	struct msm_fb_data_type *mfd = data;
@@ -3295,14 +3387,19 @@ static int __mdss_fb_display_thread(void *data)
 		MDSS_XLOG(mfd->index, XLOG_FUNC_ENTRY, atomic_read(&mfd->commits_pending));
 		ret = __mdss_fb_perform_commit(mfd);
 		MDSS_XLOG(mfd->index, XLOG_FUNC_EXIT);
+		if (!ret)
+			mdss_fb_notify_frame_commit(mfd);
 
 		atomic_dec(&mfd->commits_pending);
 		wake_up_all(&mfd->idle_wait_q);
+		wake_up_all(&mfd->kickoff_wait_q);
 	}
 
 	mdss_fb_release_kickoff(mfd);
 	atomic_set(&mfd->commits_pending, 0);
+	atomic_set(&mfd->cfg_pending, 0);
 	wake_up_all(&mfd->idle_wait_q);
+	wake_up_all(&mfd->kickoff_wait_q);
 
 	return ret;
 }
@@ -4407,6 +4504,20 @@ int mdss_fb_register_mdp_instance(struct msm_mdp_interface *mdp)
 }
 EXPORT_SYMBOL(mdss_fb_register_mdp_instance);
 
+int mdss_fb_register_frame_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_register(&mdss_fb_frame_notifier_list,
+						nb);
+}
+EXPORT_SYMBOL(mdss_fb_register_frame_notifier);
+
+int mdss_fb_unregister_frame_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_unregister(&mdss_fb_frame_notifier_list,
+						  nb);
+}
+EXPORT_SYMBOL(mdss_fb_unregister_frame_notifier);
+
 int mdss_fb_get_phys_info(dma_addr_t *start, unsigned long *len, int fb_num)
 {
 	struct fb_info *info;
@@ -51,6 +51,8 @@
 #define MDP_PP_AD_BL_LINEAR	0x0
 #define MDP_PP_AD_BL_LINEAR_INV	0x1
 #define MAX_LAYER_COUNT		0xC
+/* Atomic commits that may be queued to the display thread at once */
+#define MDSS_FB_MAX_COMMITS_IN_FLIGHT	2
 
 enum mdp_notify_event {
 	MDP_NOTIFY_FRAME_BEGIN = 1,
@@ -207,6 +209,7 @@ struct msm_fb_data_type {
 	int idle_time;
 	u32 idle_state;
 	struct delayed_work idle_notify_work;
+	ktime_t last_frame_commit;
 
 	bool validate_pending;
 
@@ -256,6 +259,8 @@ struct msm_fb_data_type {
 	struct task_struct *disp_thread;
 	atomic_t commits_pending;
 	atomic_t kickoff_pending;
+	atomic_t cfg_pending;
+	bool cfg_latched;
 	wait_queue_head_t commit_wait_q;
 	wait_queue_head_t idle_wait_q;
 	wait_queue_head_t kickoff_wait_q;
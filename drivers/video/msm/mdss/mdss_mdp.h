@@ -275,6 +275,9 @@ struct mdss_mdp_ctl {
 	int force_screen_state;
 	struct mdss_mdp_perf_params cur_perf;
 	struct mdss_mdp_perf_params new_perf;
+	struct mdss_mdp_perf_params cached_perf;
+	u32 cached_perf_key;
+	bool cached_perf_valid;
 	u32 perf_transaction_status;
 	bool perf_release_ctl_bw;
 	u64 bw_pending;
@@ -401,6 +404,7 @@ struct mdss_mdp_img_data {
 	u32 domain;
 	bool mapped;
 	bool skip_detach;
+	struct mdss_mdp_buf_cache_entry *cache_entry;
 	struct fd srcp_f;
 	struct dma_buf *srcp_dma_buf;
 	struct dma_buf_attachment *srcp_attachment;
@@ -603,6 +607,11 @@ struct mdss_overlay_private {
 	struct mdss_data_type *mdata;
 	struct mutex ov_lock;
 	struct mutex dfps_lock;
+	bool dfps_auto;
+	ktime_t dfps_window_start;
+	u32 dfps_frame_cnt;
+	u32 dfps_hold_cnt;
+	u32 dfps_hold_fps;
 	struct mdss_mdp_ctl *ctl;
 	struct mdss_mdp_wfd *wfd;
 
@@ -1310,6 +1319,7 @@ struct mult_factor *mdss_mdp_get_comp_factor(u32 format,
 	bool rt_factor);
 int mdss_mdp_data_map(struct mdss_mdp_data *data, bool rotator, int dir);
 void mdss_mdp_data_free(struct mdss_mdp_data *data, bool rotator, int dir);
+void mdss_mdp_data_cache_flush(void);
 int mdss_mdp_data_get_and_validate_size(struct mdss_mdp_data *data,
 	struct msmfb_data *planes, int num_planes, u32 flags,
 	struct device *dev, bool rotator, int dir,
@@ -21,6 +21,7 @@
 #include <linux/sort.h>
 #include <linux/clk.h>
 #include <linux/bitmap.h>
+#include <linux/jhash.h>
 
 #include "mdss_fb.h"
 #include "mdss_mdp.h"
@@ -1418,12 +1419,74 @@ int mdss_mdp_perf_bw_check_pipe(struct mdss_mdp_perf_params *perf,
 	return 0;
 }
 
+static u32 __mdss_mdp_perf_key_mixer(struct mdss_mdp_mixer *mixer,
+		struct mdss_mdp_pipe **plist, int cnt, u32 key)
+{
+	int i;
+
+	if (!mixer)
+		return key;
+
+	key = jhash_3words(mixer->type | (mixer->rotator_mode << 8),
+		mixer->width | (mixer->height << 16), cnt, key);
+
+	for (i = 0; i < cnt; i++) {
+		struct mdss_mdp_pipe *pipe = plist[i];
+		u32 words[] = {
+			pipe->num, pipe->flags,
+			pipe->src.x, pipe->src.y, pipe->src.w, pipe->src.h,
+			pipe->dst.x, pipe->dst.y, pipe->dst.w, pipe->dst.h,
+			pipe->src_fmt ? pipe->src_fmt->format : 0,
+			pipe->horz_deci | (pipe->vert_deci << 8) |
+				(pipe->src_split_req << 16) |
+				(pipe->mixer_stage << 24),
+			pipe->frame_rate,
+			pipe->comp_ratio.numer, pipe->comp_ratio.denom,
+		};
+
+		key = jhash2(words, ARRAY_SIZE(words), key);
+	}
+
+	return key;
+}
+
+/*
+ * The perf parameters of a ctl only depend on the staged pipes, the mixers
+ * and the panel timing. Hash these so that commits with an unchanged layer
+ * set, as in video playback or a static UI, can skip the calculation.
+ */
+static u32 __mdss_mdp_perf_calc_key(struct mdss_mdp_ctl *ctl,
+		struct mdss_mdp_pipe **left_plist, int left_cnt,
+		struct mdss_mdp_pipe **right_plist, int right_cnt)
+{
+	struct mdss_panel_info *pinfo;
+	u32 key;
+
+	key = jhash_3words(ctl->is_video_mode, ctl->intf_type,
+		ctl->dst_format, 0);
+
+	if (ctl->panel_data) {
+		pinfo = &ctl->panel_data->panel_info;
+		key = jhash_3words(mdss_mdp_get_pclk_rate(ctl),
+			mdss_panel_get_framerate(pinfo),
+			mdss_panel_get_vtotal(pinfo), key);
+	}
+
+	key = __mdss_mdp_perf_key_mixer(ctl->mixer_left, left_plist,
+		left_cnt, key);
+	key = __mdss_mdp_perf_key_mixer(ctl->mixer_right, right_plist,
+		right_cnt, key);
+
+	return key;
+}
+
 static void mdss_mdp_perf_calc_ctl(struct mdss_mdp_ctl *ctl,
 		struct mdss_mdp_perf_params *perf)
 {
 	struct mdss_mdp_pipe *left_plist[MAX_PIPES_PER_LM];
 	struct mdss_mdp_pipe *right_plist[MAX_PIPES_PER_LM];
 	int i, left_cnt = 0, right_cnt = 0;
+	u32 key;
 
 	for (i = 0; i < MAX_PIPES_PER_LM; i++) {
 		if (ctl->mixer_left && ctl->mixer_left->stage_pipe[i]) {
@@ -1439,6 +1502,15 @@ static void mdss_mdp_perf_calc_ctl(struct mdss_mdp_ctl *ctl,
 		}
 	}
 
+	key = __mdss_mdp_perf_calc_key(ctl, left_plist, left_cnt,
+		right_plist, right_cnt);
+	if (ctl->cached_perf_valid && ctl->cached_perf_key == key) {
+		*perf = ctl->cached_perf;
+		pr_debug("ctl=%d reusing perf, clk_rate=%u\n", ctl->num,
+			perf->mdp_clk_rate);
+		return;
+	}
+
 	__mdss_mdp_perf_calc_ctl_helper(ctl, perf,
 		left_plist, left_cnt, right_plist, right_cnt, 0);
 
@@ -1455,6 +1527,10 @@ static void mdss_mdp_perf_calc_ctl(struct mdss_mdp_ctl *ctl,
 	pr_debug("ctl=%d clk_rate=%u\n", ctl->num, perf->mdp_clk_rate);
 	pr_debug("bw_overlap=%llu bw_prefill=%llu prefill_bytes=%d\n",
 		 perf->bw_overlap, perf->bw_prefill, perf->prefill_bytes);
+
+	ctl->cached_perf = *perf;
+	ctl->cached_perf_key = key;
+	ctl->cached_perf_valid = true;
 }
 
 static void set_status(u32 *value, bool status, u32 bit_num)
@@ -1820,6 +1896,7 @@ static void mdss_mdp_ctl_perf_update(struct mdss_mdp_ctl *ctl,
 	} else {
 		memset(old, 0, sizeof(*old));
 		memset(new, 0, sizeof(*new));
+		ctl->cached_perf_valid = false;
 		update_bus = 1;
 		update_clk = 1;
 	}
@@ -1905,6 +1982,7 @@ int mdss_mdp_ctl_free(struct mdss_mdp_ctl *ctl)
 	ctl->mixer_right = NULL;
 	ctl->wb = NULL;
 	ctl->cdm = NULL;
+	ctl->cached_perf_valid = false;
 	memset(&ctl->ops, 0, sizeof(ctl->ops));
 	mutex_unlock(&mdss_mdp_ctl_lock);
 
@@ -3210,6 +3288,7 @@ int mdss_mdp_ctl_intf_event(struct mdss_mdp_ctl *ctl, int event, void *arg,
 	case MDSS_EVENT_PANEL_OFF:
 	case MDSS_EVENT_PANEL_VDDIO_SWITCH_ON:
 	case MDSS_EVENT_PANEL_VDDIO_SWITCH_OFF:
+	case MDSS_EVENT_PANEL_POWER_PREPARE:
 		need_lock = true;
 		break;
 	}
@@ -13,6 +13,7 @@
 
 #include <linux/kernel.h>
 #include <linux/pm_runtime.h>
+#include <soc/qcom/lpm-sync.h>
 
 #include "mdss_mdp.h"
 #include "mdss_panel.h"
@@ -755,6 +756,7 @@ static void mdss_mdp_cmd_readptr_done(void *arg)
 
 	vsync_time = ktime_get();
 	ctl->vsync_cnt++;
+	lpm_sync_event(LPM_SYNC_DISPLAY);
 	status = readl_relaxed(mdata->mdp_base + MDSS_REG_HW_INTR2_STATUS);
 	MDSS_XLOG(ctl->num, atomic_read(&ctx->koff_cnt), status);
 
@@ -18,6 +18,7 @@
 #include <linux/dma-mapping.h>
 #include <linux/memblock.h>
 #include <video/msm_hdmi_modes.h>
+#include <soc/qcom/lpm-sync.h>
 
 #include "mdss_fb.h"
 #include "mdss_mdp.h"
@@ -563,6 +564,7 @@ static void mdss_mdp_video_vsync_intr_done(void *arg)
 
 	vsync_time = ktime_get();
 	ctl->vsync_cnt++;
+	lpm_sync_event(LPM_SYNC_DISPLAY);
 
 	MDSS_XLOG(ctl->num, ctl->vsync_cnt, ctl->vsync_cnt);
 
@@ -1238,6 +1238,110 @@ end:
 	return ret;
 }
 
+/* Grow @roi to the start and size alignment the panel can take */
+static void __align_damage_roi(struct mdss_rect *roi,
+	struct mdss_panel_info *pinfo, u32 max_w, u32 max_h)
+{
+	u32 x2, y2;
+
+	if (!roi->w || !roi->h)
+		return;
+
+	x2 = roi->x + roi->w;
+	y2 = roi->y + roi->h;
+
+	if (pinfo->xstart_pix_align)
+		roi->x = rounddown(roi->x, pinfo->xstart_pix_align);
+	if (pinfo->ystart_pix_align)
+		roi->y = rounddown(roi->y, pinfo->ystart_pix_align);
+
+	roi->w = max(x2 - roi->x, pinfo->min_width);
+	roi->h = max(y2 - roi->y, pinfo->min_height);
+
+	if (pinfo->width_pix_align)
+		roi->w = roundup(roi->w, pinfo->width_pix_align);
+	if (pinfo->height_pix_align)
+		roi->h = roundup(roi->h, pinfo->height_pix_align);
+
+	/* Alignment may push the roi off the panel, pull it back in */
+	roi->w = min(roi->w, max_w);
+	roi->h = min(roi->h, max_h);
+	if (roi->x + roi->w > max_w)
+		roi->x = max_w - roi->w;
+	if (roi->y + roi->h > max_h)
+		roi->y = max_h - roi->h;
+}
+
+/*
+ * __compute_damage_roi() - derive the partial update roi from layer damage
+ * @mfd: Framebuffer data structure for display
+ * @commit: Commit version-1 structure for display
+ *
+ * Union the damage of all layers and align it to the panel constraints. The
+ * result replaces the client provided left and right roi. If the frame has no
+ * damage the roi is left empty, which updates the full panel.
+ */
+static void __compute_damage_roi(struct msm_fb_data_type *mfd,
+	struct mdp_layer_commit_v1 *commit)
+{
+	struct mdss_data_type *mdata = mfd_to_mdata(mfd);
+	struct mdss_panel_info *pinfo = mfd->panel_info;
+	struct mdss_rect roi = {0}, l_roi = {0}, r_roi = {0};
+	struct mdss_rect damage, dst;
+	u32 xres = mfd->fbi->var.xres;
+	u32 yres = mfd->fbi->var.yres;
+	u32 left_lm_w = left_lm_w_from_mfd(mfd);
+	u32 x2, y2;
+	int i;
+
+	memset(&commit->left_roi, 0, sizeof(commit->left_roi));
+	memset(&commit->right_roi, 0, sizeof(commit->right_roi));
+
+	if (!pinfo->partial_update_enabled)
+		return;
+
+	for (i = 0; i < commit->input_layer_cnt; i++) {
+		struct mdp_input_layer *layer = &commit->input_layers[i];
+
+		rect_copy_mdp_to_mdss(&layer->damage_rect, &damage);
+		rect_copy_mdp_to_mdss(&layer->dst_rect, &dst);
+		mdss_mdp_intersect_rect(&damage, &damage, &dst);
+		if (!damage.w || !damage.h)
+			continue;
+
+		if (!roi.w || !roi.h) {
+			roi = damage;
+			continue;
+		}
+
+		x2 = max(roi.x + roi.w, damage.x + damage.w);
+		y2 = max(roi.y + roi.h, damage.y + damage.h);
+		roi.x = min(roi.x, damage.x);
+		roi.y = min(roi.y, damage.y);
+		roi.w = x2 - roi.x;
+		roi.h = y2 - roi.y;
+	}
+
+	if (!roi.w || !roi.h)
+		return;
+
+	if (is_split_lm(mfd) && !mdata->has_src_split) {
+		mdss_rect_split(&roi, &l_roi, &r_roi, left_lm_w);
+		__align_damage_roi(&l_roi, pinfo, left_lm_w, yres);
+		__align_damage_roi(&r_roi, pinfo, xres - left_lm_w, yres);
+	} else {
+		l_roi = roi;
+		__align_damage_roi(&l_roi, pinfo, xres, yres);
+	}
+
+	pr_debug("damage roi: l:%d,%d,%d,%d r:%d,%d,%d,%d\n",
+		l_roi.x, l_roi.y, l_roi.w, l_roi.h,
+		r_roi.x, r_roi.y, r_roi.w, r_roi.h);
+
+	rect_copy_mdss_to_mdp(&commit->left_roi, &l_roi);
+	rect_copy_mdss_to_mdp(&commit->right_roi, &r_roi);
+}
+
 int mdss_mdp_layer_pre_commit(struct msm_fb_data_type *mfd,
 	struct file *file, struct mdp_layer_commit_v1 *commit)
 {
@@ -1257,6 +1361,9 @@ int mdss_mdp_layer_pre_commit(struct msm_fb_data_type *mfd,
 
 	layer_list = commit->input_layers;
 
+	if (commit->flags & MDP_COMMIT_PARTIAL_UPDATE_DAMAGE)
+		__compute_damage_roi(mfd, commit);
+
 	
 	if (!layer_count) {
 		__handle_free_list(mdp5_data, NULL, layer_count);
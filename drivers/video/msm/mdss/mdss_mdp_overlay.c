@@ -49,12 +49,17 @@
 
 #define BUF_POOL_SIZE 32
 
+/* Content driven dfps: measurement window and windows to hold a step down */
+#define DFPS_AUTO_WINDOW_MS	1000
+#define DFPS_AUTO_HOLD_WINDOWS	3
+
 static int mdss_mdp_overlay_free_fb_pipe(struct msm_fb_data_type *mfd);
 static int mdss_mdp_overlay_fb_parse_dt(struct msm_fb_data_type *mfd);
 static int mdss_mdp_overlay_off(struct msm_fb_data_type *mfd);
 static void __overlay_kickoff_requeue(struct msm_fb_data_type *mfd);
 static void __vsync_retire_signal(struct msm_fb_data_type *mfd, int val);
 static int __vsync_set_vsync_handler(struct msm_fb_data_type *mfd);
+static void mdss_mdp_dfps_auto_update(struct msm_fb_data_type *mfd);
 static int mdss_mdp_update_panel_info(struct msm_fb_data_type *mfd,
 		int mode, int dest_ctrl);
 
@@ -1769,6 +1774,8 @@ int mdss_mdp_overlay_kickoff(struct msm_fb_data_type *mfd,
 	mdss_mdp_splash_cleanup(mfd, true);
 
 	ATRACE_BEGIN("fps_update");
+	if (mdp5_data->dfps_auto)
+		mdss_mdp_dfps_auto_update(mfd);
 	ret = mdss_mdp_ctl_update_fps(ctl);
 	ATRACE_END("fps_update");
 
@@ -2541,6 +2548,9 @@ static ssize_t dynamic_fps_sysfs_wta_dfps(struct device *dev,
 
 	pr_debug("new_fps:%d\n", dfps);
 
+	/* An explicit request from userspace takes over from content dfps */
+	mdp5_data->dfps_auto = false;
+
 	mdss_mdp_dfps_update_params(pdata, dfps);
 	if (pdata->next)
 		mdss_mdp_dfps_update_params(pdata->next, dfps);
@@ -2552,12 +2562,155 @@ static ssize_t dynamic_fps_sysfs_wta_dfps(struct device *dev,
 	return count;
 } 
 
+/*
+ * Lowest refresh rate in the panel range that is a multiple of the content
+ * rate, so that every content frame is shown for the same number of vsyncs.
+ */
+static u32 __dfps_auto_pick_fps(struct mdss_panel_info *pinfo, u32 content_fps)
+{
+	u32 fps;
+
+	if (!content_fps)
+		return pinfo->min_fps;
+
+	for (fps = content_fps; fps <= pinfo->max_fps; fps += content_fps)
+		if (fps >= pinfo->min_fps)
+			return fps;
+
+	return pinfo->max_fps;
+}
+
+/*
+ * mdss_mdp_dfps_auto_update() - follow the commit rate with the panel fps
+ * @mfd: Framebuffer data structure for display
+ *
+ * Called for every kickoff with content dfps enabled. The commits are counted
+ * over a window and the panel is moved to the lowest rate that shows the
+ * measured content rate without judder. Raising the rate is done as soon as
+ * a window shows the content is limited by the panel rate, lowering it only
+ * after DFPS_AUTO_HOLD_WINDOWS windows agree. The new rate is applied by the
+ * following mdss_mdp_ctl_update_fps() call.
+ */
+static void mdss_mdp_dfps_auto_update(struct msm_fb_data_type *mfd)
+{
+	struct mdss_overlay_private *mdp5_data = mfd_to_mdp5_data(mfd);
+	struct mdss_panel_data *pdata = dev_get_platdata(&mfd->pdev->dev);
+	struct mdss_panel_info *pinfo;
+	ktime_t now = ktime_get();
+	u32 elapsed_ms, content_fps, cur_fps, new_fps;
+
+	if (!pdata || !pdata->panel_info.dynamic_fps)
+		return;
+
+	pinfo = &pdata->panel_info;
+	if (pinfo->dfps_update == DFPS_SUSPEND_RESUME_MODE)
+		return;
+
+	mutex_lock(&mdp5_data->dfps_lock);
+
+	mdp5_data->dfps_frame_cnt++;
+	elapsed_ms = ktime_to_ms(ktime_sub(now, mdp5_data->dfps_window_start));
+	if (elapsed_ms < DFPS_AUTO_WINDOW_MS)
+		goto exit;
+
+	/* A long gap is idle followed by new activity, start over */
+	if (elapsed_ms > 2 * DFPS_AUTO_WINDOW_MS) {
+		mdp5_data->dfps_hold_cnt = 0;
+		goto restart;
+	}
+
+	content_fps = DIV_ROUND_UP(mdp5_data->dfps_frame_cnt * 1000,
+		elapsed_ms);
+	cur_fps = pinfo->mipi.frame_rate;
+
+	/* Commits keep up with the panel, the content may want more */
+	if (content_fps + 2 >= cur_fps)
+		new_fps = pinfo->max_fps;
+	else
+		new_fps = __dfps_auto_pick_fps(pinfo, content_fps);
+
+	if (new_fps < cur_fps) {
+		if (!mdp5_data->dfps_hold_cnt++)
+			mdp5_data->dfps_hold_fps = new_fps;
+		else
+			mdp5_data->dfps_hold_fps = max(new_fps,
+				mdp5_data->dfps_hold_fps);
+
+		if (mdp5_data->dfps_hold_cnt < DFPS_AUTO_HOLD_WINDOWS)
+			goto restart;
+
+		new_fps = mdp5_data->dfps_hold_fps;
+	}
+	mdp5_data->dfps_hold_cnt = 0;
+
+	if (new_fps != cur_fps) {
+		pr_debug("content fps:%d panel fps:%d->%d\n",
+			content_fps, cur_fps, new_fps);
+
+		mdss_mdp_dfps_update_params(pdata, new_fps);
+		if (pdata->next)
+			mdss_mdp_dfps_update_params(pdata->next, new_fps);
+
+		mdss_panelinfo_to_fb_var(pinfo, &mfd->fbi->var);
+		MDSS_XLOG(content_fps, cur_fps, new_fps);
+	}
+
+restart:
+	mdp5_data->dfps_window_start = now;
+	mdp5_data->dfps_frame_cnt = 0;
+exit:
+	mutex_unlock(&mdp5_data->dfps_lock);
+}
+
+static ssize_t dynamic_fps_auto_show(struct device *dev,
+	struct device_attribute *attr, char *buf)
+{
+	struct fb_info *fbi = dev_get_drvdata(dev);
+	struct msm_fb_data_type *mfd = (struct msm_fb_data_type *)fbi->par;
+	struct mdss_overlay_private *mdp5_data = mfd_to_mdp5_data(mfd);
+
+	return snprintf(buf, PAGE_SIZE, "%d\n", mdp5_data->dfps_auto);
+}
+
+static ssize_t dynamic_fps_auto_store(struct device *dev,
+	struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct fb_info *fbi = dev_get_drvdata(dev);
+	struct msm_fb_data_type *mfd = (struct msm_fb_data_type *)fbi->par;
+	struct mdss_overlay_private *mdp5_data = mfd_to_mdp5_data(mfd);
+	bool enable;
+	int rc;
+
+	rc = strtobool(buf, &enable);
+	if (rc) {
+		pr_err("invalid input for dynamic_fps_auto\n");
+		return rc;
+	}
+
+	if (enable && !mfd->panel_info->dynamic_fps) {
+		pr_err_once("Dynamic fps not enabled for this panel\n");
+		return -EINVAL;
+	}
+
+	mutex_lock(&mdp5_data->dfps_lock);
+	mdp5_data->dfps_auto = enable;
+	mdp5_data->dfps_window_start = ktime_get();
+	mdp5_data->dfps_frame_cnt = 0;
+	mdp5_data->dfps_hold_cnt = 0;
+	mutex_unlock(&mdp5_data->dfps_lock);
+
+	return count;
+}
+
 
 static DEVICE_ATTR(dynamic_fps, S_IRUGO | S_IWUSR, dynamic_fps_sysfs_rda_dfps,
 	dynamic_fps_sysfs_wta_dfps);
+static DEVICE_ATTR(dynamic_fps_auto, S_IRUGO | S_IWUSR, dynamic_fps_auto_show,
+	dynamic_fps_auto_store);
 
 static struct attribute *dynamic_fps_fs_attrs[] = {
 	&dev_attr_dynamic_fps.attr,
+	&dev_attr_dynamic_fps_auto.attr,
 	NULL,
 };
 static struct attribute_group dynamic_fps_fs_attrs_group = {
@@ -4255,6 +4408,12 @@ static int mdss_mdp_overlay_on(struct msm_fb_data_type *mfd)
 
 	if (!mfd->panel_info->cont_splash_enabled &&
 		(mfd->panel_info->type != DTV_PANEL)) {
+		/*
+		 * Let the panel ramp its supplies while the MDP is clocked,
+		 * attached and restored below, LINK_READY waits for it.
+		 */
+		mdss_mdp_ctl_intf_event(ctl, MDSS_EVENT_PANEL_POWER_PREPARE,
+			NULL, CTL_INTF_EVENT_FLAG_DEFAULT);
 		rc = mdss_mdp_overlay_start(mfd);
 		if (rc)
 			goto end;
@@ -4374,8 +4533,10 @@ ctl_stop:
 			}
 
 			if (atomic_dec_return(
-				&mdp5_data->mdata->active_intf_cnt) == 0)
+				&mdp5_data->mdata->active_intf_cnt) == 0) {
 				mdss_mdp_rotator_release_all();
+				mdss_mdp_data_cache_flush();
+			}
 
 			if (!mdp5_data->mdata->idle_pc_enabled ||
 				(mfd->panel_info->type != MIPI_CMD_PANEL)) {
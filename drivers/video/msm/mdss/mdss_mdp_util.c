@@ -16,6 +16,7 @@
 #include <linux/errno.h>
 #include <linux/file.h>
 #include <linux/msm_ion.h>
+#include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/types.h>
 #include <linux/major.h>
@@ -32,6 +33,33 @@
 
 #define PHY_ADDR_4G (1ULL<<32)
 
+/* Attached dma-bufs kept around for reuse by later commits */
+#define MDSS_MDP_BUF_CACHE_MAX 32
+
+/*
+ * struct mdss_mdp_buf_cache_entry - dma-buf attachment kept across commits
+ * @list: Node in mdss_mdp_buf_cache, most recently used first
+ * @dma_buf: Buffer, the entry holds a reference on it
+ * @attachment: Attachment to the smmu context bank of @domain
+ * @table: Mapped attachment, its iova comes from the lazy mapping
+ * @domain: Smmu domain the buffer is attached to
+ * @dir: Dma direction of the mapping
+ * @refcnt: Images currently using the entry
+ */
+struct mdss_mdp_buf_cache_entry {
+	struct list_head list;
+	struct dma_buf *dma_buf;
+	struct dma_buf_attachment *attachment;
+	struct sg_table *table;
+	int domain;
+	int dir;
+	int refcnt;
+};
+
+static LIST_HEAD(mdss_mdp_buf_cache);
+static DEFINE_MUTEX(mdss_mdp_buf_cache_lock);
+static int mdss_mdp_buf_cache_cnt;
+
 enum {
 	MDP_INTR_VSYNC_INTF_0,
 	MDP_INTR_VSYNC_INTF_1,
@@ -1019,6 +1047,120 @@ void mdss_mdp_data_calc_offset(struct mdss_mdp_data *data, u16 x, u16 y,
 	}
 }
 
+static void __mdss_mdp_buf_cache_release(struct mdss_mdp_buf_cache_entry *e)
+{
+	dma_buf_unmap_attachment(e->attachment, e->table,
+		mdss_smmu_dma_data_direction(e->dir));
+	dma_buf_detach(e->dma_buf, e->attachment);
+	dma_buf_put(e->dma_buf);
+	kfree(e);
+}
+
+/*
+ * Look up @dma_buf in the cache and take a reference on the entry. On a hit
+ * the reference the caller holds on @dma_buf is dropped, the entry keeps its
+ * own. Returns NULL on a miss.
+ */
+static struct mdss_mdp_buf_cache_entry *mdss_mdp_buf_cache_get(
+	struct dma_buf *dma_buf, int domain, int dir)
+{
+	struct mdss_mdp_buf_cache_entry *e;
+
+	mutex_lock(&mdss_mdp_buf_cache_lock);
+	list_for_each_entry(e, &mdss_mdp_buf_cache, list) {
+		if (e->dma_buf == dma_buf && e->domain == domain &&
+				e->dir == dir) {
+			e->refcnt++;
+			list_move(&e->list, &mdss_mdp_buf_cache);
+			mutex_unlock(&mdss_mdp_buf_cache_lock);
+			dma_buf_put(dma_buf);
+			return e;
+		}
+	}
+	mutex_unlock(&mdss_mdp_buf_cache_lock);
+
+	return NULL;
+}
+
+/* Cache a new attachment, the entry takes over the dma-buf reference */
+static struct mdss_mdp_buf_cache_entry *mdss_mdp_buf_cache_add(
+	struct mdss_mdp_img_data *data, int domain, int dir)
+{
+	struct mdss_mdp_buf_cache_entry *e;
+
+	e = kzalloc(sizeof(*e), GFP_KERNEL);
+	if (!e)
+		return NULL;
+
+	e->dma_buf = data->srcp_dma_buf;
+	e->attachment = data->srcp_attachment;
+	e->table = data->srcp_table;
+	e->domain = domain;
+	e->dir = dir;
+	e->refcnt = 1;
+
+	mutex_lock(&mdss_mdp_buf_cache_lock);
+	list_add(&e->list, &mdss_mdp_buf_cache);
+	mdss_mdp_buf_cache_cnt++;
+	mutex_unlock(&mdss_mdp_buf_cache_lock);
+
+	return e;
+}
+
+/*
+ * Drop a reference on a cache entry. Unused entries beyond the cache size
+ * are released starting from the least recently used one.
+ */
+static void mdss_mdp_buf_cache_put(struct mdss_mdp_buf_cache_entry *entry)
+{
+	struct mdss_mdp_buf_cache_entry *e, *tmp;
+	LIST_HEAD(release);
+
+	mutex_lock(&mdss_mdp_buf_cache_lock);
+	entry->refcnt--;
+	list_for_each_entry_safe_reverse(e, tmp, &mdss_mdp_buf_cache, list) {
+		if (mdss_mdp_buf_cache_cnt <= MDSS_MDP_BUF_CACHE_MAX)
+			break;
+		if (e->refcnt)
+			continue;
+		list_move(&e->list, &release);
+		mdss_mdp_buf_cache_cnt--;
+	}
+	mutex_unlock(&mdss_mdp_buf_cache_lock);
+
+	list_for_each_entry_safe(e, tmp, &release, list)
+		__mdss_mdp_buf_cache_release(e);
+}
+
+/**
+ * mdss_mdp_data_cache_flush() - release all the unused cached buffers
+ *
+ * The cache holds a reference on each buffer, call this when the buffers are
+ * not expected to be used again so they can be freed.
+ */
+void mdss_mdp_data_cache_flush(void)
+{
+	struct mdss_mdp_buf_cache_entry *e, *tmp;
+	LIST_HEAD(release);
+
+	mutex_lock(&mdss_mdp_buf_cache_lock);
+	list_for_each_entry_safe(e, tmp, &mdss_mdp_buf_cache, list) {
+		if (e->refcnt)
+			continue;
+		list_move(&e->list, &release);
+		mdss_mdp_buf_cache_cnt--;
+	}
+	mutex_unlock(&mdss_mdp_buf_cache_lock);
+
+	if (list_empty(&release))
+		return;
+
+	mdss_iommu_ctrl(1);
+	list_for_each_entry_safe(e, tmp, &release, list)
+		__mdss_mdp_buf_cache_release(e);
+	mdss_iommu_ctrl(0);
+}
+
 static int mdss_mdp_put_img(struct mdss_mdp_img_data *data, bool rotator,
 		int dir)
 {
@@ -1047,7 +1189,11 @@ static int mdss_mdp_put_img(struct mdss_mdp_img_data *data, bool rotator,
 							data->srcp_dma_buf);
 				data->mapped = false;
 			}
-			if (!data->skip_detach) {
+			if (data->cache_entry) {
+				mdss_mdp_buf_cache_put(data->cache_entry);
+				data->cache_entry = NULL;
+				data->srcp_dma_buf = NULL;
+			} else if (!data->skip_detach) {
 				dma_buf_unmap_attachment(data->srcp_attachment,
 					data->srcp_table,
 					mdss_smmu_dma_data_direction(dir));
@@ -1115,6 +1261,18 @@ static int mdss_mdp_get_img(struct msmfb_data *img,
 		}
 		domain = mdss_smmu_get_domain_type(data->flags, rotator);
 
+		data->cache_entry = NULL;
+		if (!rotator)
+			data->cache_entry = mdss_mdp_buf_cache_get(
+				data->srcp_dma_buf, domain, dir);
+
+		if (data->cache_entry) {
+			data->srcp_dma_buf = data->cache_entry->dma_buf;
+			data->srcp_attachment = data->cache_entry->attachment;
+			data->srcp_table = data->cache_entry->table;
+			goto cached;
+		}
+
 		data->srcp_attachment =
 			mdss_smmu_dma_buf_attach(data->srcp_dma_buf, dev,
 					domain);
@@ -1131,6 +1289,10 @@ static int mdss_mdp_get_img(struct msmfb_data *img,
 			goto err_detach;
 		}
 
+		if (!rotator)
+			data->cache_entry = mdss_mdp_buf_cache_add(data,
+				domain, dir);
+cached:
 		data->addr = 0;
 		data->len = 0;
 		data->mapped = false;
@@ -1258,6 +1420,11 @@ static int mdss_mdp_map_buffer(struct mdss_mdp_img_data *data, bool rotator,
 	return ret;
 
 err_unmap:
+	if (data->cache_entry) {
+		mdss_mdp_buf_cache_put(data->cache_entry);
+		data->cache_entry = NULL;
+		return ret;
+	}
 	dma_buf_unmap_attachment(data->srcp_attachment, data->srcp_table,
 		mdss_smmu_dma_data_direction(dir));
 	dma_buf_detach(data->srcp_dma_buf, data->srcp_attachment);
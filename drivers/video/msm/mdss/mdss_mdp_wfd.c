@@ -117,6 +117,17 @@ static bool mdss_mdp_wfd_is_config_same(struct mdss_mdp_wfd *wfd,
 	if (mixer->height != layer->buffer.height)
 		return false;
 
+	/*
+	 * The output format follows what the consumer of the buffer prefers,
+	 * e.g. encoders switch to ubwc once the session is up.
+	 */
+	if (ctl->dst_format != layer->buffer.format)
+		return false;
+
+	if (memcmp(&ctl->dst_comp_ratio, &layer->buffer.comp_ratio,
+			sizeof(ctl->dst_comp_ratio)))
+		return false;
+
 	return true;
 }
 
@@ -293,16 +304,31 @@ static int mdss_mdp_wfd_validate_out_configuration(struct mdss_mdp_wfd *wfd,
 {
 	struct mdss_mdp_format_params *fmt = NULL;
 	struct mdss_mdp_ctl *ctl = wfd->ctl;
+	struct mdss_mdp_writeback *wb;
 	u32 wb_idx = layer->writeback_ndx;
 
+	fmt = mdss_mdp_get_format_params(layer->buffer.format);
+	if (!fmt) {
+		pr_err("wb=%d invalid dst fmt:%d\n", wb_idx,
+			layer->buffer.format);
+		return -EINVAL;
+	}
+
 	if (mdss_mdp_is_wb_mdp_intf(wb_idx, ctl->num)) {
-		fmt = mdss_mdp_get_format_params(layer->buffer.format);
-		if (!fmt || !(fmt->flag & VALID_MDP_WB_INTF_FORMAT)) {
+		if (!(fmt->flag & VALID_MDP_WB_INTF_FORMAT)) {
 			pr_err("wb=%d does not support dst fmt:%d\n", wb_idx,
 				layer->buffer.format);
 			return -EINVAL;
 		}
 	}
+
+	wb = ctl->mdata->wb + wb_idx;
+	if (mdss_mdp_is_ubwc_format(fmt) && !(wb->caps & MDSS_MDP_WB_UBWC)) {
+		pr_err("wb=%d does not support ubwc dst fmt:%d\n", wb_idx,
+			layer->buffer.format);
+		return -EINVAL;
+	}
+
 	return 0;
 }
 
@@ -311,14 +337,14 @@ int mdss_mdp_wfd_validate(struct mdss_mdp_wfd *wfd,
 {
 	u32 wb_idx = layer->writeback_ndx;
 
+	if (wb_idx >= wfd->ctl->mdata->nwb)
+		return -EINVAL;
+
 	if (mdss_mdp_wfd_validate_out_configuration(wfd, layer)) {
 		pr_err("failed to validate output config\n");
 		return -EINVAL;
 	}
 
-	if (wb_idx > wfd->ctl->mdata->nwb)
-		return -EINVAL;
-
 	return 0;
 }
 
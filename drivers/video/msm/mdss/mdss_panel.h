@@ -179,6 +179,7 @@ enum mdss_intf_events {
 	MDSS_EVENT_PANEL_TIMING_SWITCH,
 	MDSS_EVENT_PANEL_VDDIO_SWITCH_ON,
 	MDSS_EVENT_PANEL_VDDIO_SWITCH_OFF,
+	MDSS_EVENT_PANEL_POWER_PREPARE,
 };
 
 struct lcd_panel_info {
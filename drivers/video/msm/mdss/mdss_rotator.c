@@ -24,6 +24,8 @@
 #include <linux/msm-bus.h>
 #include <linux/msm-bus-board.h>
 #include <linux/regulator/consumer.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include "mdss_rotator_internal.h"
 #include "mdss_mdp.h"
@@ -65,6 +67,7 @@ static struct msm_bus_scale_pdata rot_reg_bus_scale_table = {
 
 static struct mdss_rot_mgr *rot_mgr;
 static void mdss_rotator_wq_handler(struct work_struct *work);
+static void mdss_rotator_prepare_handler(struct work_struct *work);
 
 static int mdss_rotator_bus_scale_set_quota(struct mdss_rot_bus_data_type *bus,
 		u64 quota)
@@ -816,12 +819,22 @@ static int mdss_rotator_init_queue(struct mdss_rot_mgr *mgr)
 		snprintf(name, sizeof(name), "rot_workq_%d", i);
 		pr_debug("work queue name=%s\n", name);
 		mgr->queues[i].rot_work_queue = alloc_ordered_workqueue("%s",
-				WQ_UNBOUND | WQ_MEM_RECLAIM | WQ_HIGHPRI, name);
+				WQ_UNBOUND | WQ_MEM_RECLAIM | WQ_HIGHPRI |
+				WQ_LATENCY_SENSITIVE, name);
 		if (!mgr->queues[i].rot_work_queue) {
 			ret = -EPERM;
 			break;
 		}
 
+		snprintf(name, sizeof(name), "rot_prepq_%d", i);
+		mgr->queues[i].prep_work_queue = alloc_ordered_workqueue("%s",
+				WQ_UNBOUND | WQ_MEM_RECLAIM | WQ_HIGHPRI |
+				WQ_LATENCY_SENSITIVE, name);
+		if (!mgr->queues[i].prep_work_queue) {
+			ret = -EPERM;
+			break;
+		}
+
 		snprintf(name, sizeof(name), "rot_timeline_%d", i);
 		pr_debug("timeline name=%s\n", name);
 		mgr->queues[i].timeline.timeline =
@@ -850,6 +863,8 @@ static void mdss_rotator_deinit_queue(struct mdss_rot_mgr *mgr)
 		return;
 
 	for (i = 0; i < mgr->queue_count; i++) {
+		if (mgr->queues[i].prep_work_queue)
+			destroy_workqueue(mgr->queues[i].prep_work_queue);
 		if (mgr->queues[i].rot_work_queue)
 			destroy_workqueue(mgr->queues[i].rot_work_queue);
 
@@ -864,6 +879,31 @@ static void mdss_rotator_deinit_queue(struct mdss_rot_mgr *mgr)
 	mgr->queue_count = 0;
 }
 
+/*
+ * Pick the queue with the least work pending so that requests which do not
+ * ask for a specific block are spread over all the rotator blocks.
+ */
+static u32 mdss_rotator_least_loaded_queue(struct mdss_rot_mgr *mgr)
+{
+	struct mdss_rot_queue *queue;
+	u32 i, best = 0, load, best_load = UINT_MAX;
+
+	for (i = 0; i < mgr->queue_count; i++) {
+		queue = mgr->queues + i;
+
+		mutex_lock(&queue->hw_lock);
+		load = queue->hw ? queue->hw->pending_count : 0;
+		mutex_unlock(&queue->hw_lock);
+
+		if (load < best_load) {
+			best_load = load;
+			best = i;
+		}
+	}
+
+	return best;
+}
+
 static int mdss_rotator_assign_queue(struct mdss_rot_mgr *mgr,
 	struct mdss_rot_entry *entry,
 	struct mdss_rot_file_private *private)
@@ -877,8 +917,8 @@ static int mdss_rotator_assign_queue(struct mdss_rot_mgr *mgr,
 	int ret = 0;
 
 	if (wb_idx == MDSS_ROTATION_HW_ANY) {
-		wb_idx = 0;
-		pipe_idx = 0;
+		wb_idx = mdss_rotator_least_loaded_queue(mgr);
+		pipe_idx = wb_idx;
 	}
 
 	if (wb_idx >= mgr->queue_count) {
@@ -973,7 +1013,7 @@ static void mdss_rotator_queue_request(struct mdss_rot_mgr *mgr,
 		entry = req->entries + i;
 		queue = entry->queue;
 		entry->output_fence = NULL;
-		queue_work(queue->rot_work_queue, &entry->commit_work);
+		queue_work(queue->prep_work_queue, &entry->prepare_work);
 	}
 }
 
@@ -1463,6 +1503,7 @@ static int mdss_rotator_add_request(struct mdss_rot_mgr *mgr,
 
 		entry->request = req;
 
+		INIT_WORK(&entry->prepare_work, mdss_rotator_prepare_handler);
 		INIT_WORK(&entry->commit_work, mdss_rotator_wq_handler);
 
 		ret = mdss_rotator_create_fence(entry);
@@ -1509,6 +1550,8 @@ static void mdss_rotator_cancel_request(struct mdss_rot_mgr *mgr,
 
 	for (i = req->count - 1; i >= 0; i--) {
 		entry = req->entries + i;
+		/* prepare queues the commit, so it has to be stopped first */
+		cancel_work_sync(&entry->prepare_work);
 		cancel_work_sync(&entry->commit_work);
 	}
 
@@ -1752,28 +1795,66 @@ static int mdss_rotator_commit_entry(struct mdss_rot_hw_resource *hw,
 	return ret;
 }
 
+static void mdss_rotator_update_stats(struct mdss_rot_entry *entry,
+	ktime_t start)
+{
+	struct mdss_rot_perf *perf = entry->perf;
+
+	if (!perf)
+		return;
+
+	mutex_lock(&perf->work_dis_lock);
+	perf->frame_cnt++;
+	perf->pixel_cnt += entry->item.src_rect.w * entry->item.src_rect.h;
+	perf->hw_time_ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+	mutex_unlock(&perf->work_dis_lock);
+}
+
 static int mdss_rotator_handle_entry(struct mdss_rot_hw_resource *hw,
 	struct mdss_rot_entry *entry)
 {
+	ktime_t start;
+	int ret;
+
+	if (entry->prepare_status)
+		return entry->prepare_status;
+
+	start = ktime_get();
+	ret = mdss_rotator_commit_entry(hw, entry);
+	if (ret)
+		pr_err("rotator commit failed %d\n", ret);
+	else
+		mdss_rotator_update_stats(entry, start);
+
+	return ret;
+}
+
+/*
+ * Wait for the input and map the buffers of an entry from the prepare queue,
+ * so this is done for the next entry while the hw works on the current one.
+ * The commit work is queued even on failure so that the entry is released
+ * and its fence signalled in order.
+ */
+static void mdss_rotator_prepare_handler(struct work_struct *work)
+{
+	struct mdss_rot_entry *entry;
 	int ret;
 
+	entry = container_of(work, struct mdss_rot_entry, prepare_work);
+
 	ret = mdss_rotator_wait_for_input(entry);
 	if (ret) {
 		pr_err("wait for input buffer failed %d\n", ret);
-		return ret;
+		goto done;
 	}
 
 	ret = mdss_rotator_map_and_check_data(entry);
-	if (ret) {
-		pr_err("fail to prepare input/output data %d\n", ret);
-		return ret;
-	}
-
-	ret = mdss_rotator_commit_entry(hw, entry);
 	if (ret)
-		pr_err("rotator commit failed %d\n", ret);
+		pr_err("fail to prepare input/output data %d\n", ret);
 
-	return ret;
+done:
+	entry->prepare_status = ret;
+	queue_work(entry->queue->rot_work_queue, &entry->commit_work);
 }
 
 static void mdss_rotator_wq_handler(struct work_struct *work)
@@ -2434,6 +2515,66 @@ static struct attribute_group mdss_rotator_fs_attr_group = {
 	.attrs = mdss_rotator_fs_attrs
 };
 
+static int mdss_rotator_stats_show(struct seq_file *s, void *unused)
+{
+	struct mdss_rot_mgr *mgr = s->private;
+	struct mdss_rot_file_private *priv;
+	struct mdss_rot_perf *perf;
+	u64 fps, mpps, avg_us;
+
+	seq_puts(s, "session frames avg_hw_us hw_fps hw_mpix_per_sec\n");
+
+	mutex_lock(&mgr->file_lock);
+	list_for_each_entry(priv, &mgr->file_list, list) {
+		mutex_lock(&priv->perf_lock);
+		list_for_each_entry(perf, &priv->perf_list, list) {
+			mutex_lock(&perf->work_dis_lock);
+			fps = mpps = avg_us = 0;
+			if (perf->frame_cnt && perf->hw_time_ns) {
+				avg_us = div64_u64(perf->hw_time_ns,
+					perf->frame_cnt * NSEC_PER_USEC);
+				fps = div64_u64(perf->frame_cnt * NSEC_PER_SEC,
+					perf->hw_time_ns);
+				mpps = div64_u64(perf->pixel_cnt * MSEC_PER_SEC,
+					perf->hw_time_ns);
+			}
+			seq_printf(s, "%u %llu %llu %llu %llu\n",
+				perf->config.session_id, perf->frame_cnt,
+				avg_us, fps, mpps);
+			mutex_unlock(&perf->work_dis_lock);
+		}
+		mutex_unlock(&priv->perf_lock);
+	}
+	mutex_unlock(&mgr->file_lock);
+
+	return 0;
+}
+
+static int mdss_rotator_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, mdss_rotator_stats_show, inode->i_private);
+}
+
+static const struct file_operations mdss_rotator_stats_fops = {
+	.open = mdss_rotator_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void mdss_rotator_debugfs_init(struct mdss_rot_mgr *mgr)
+{
+	mgr->debugfs_root = debugfs_create_dir(DRIVER_NAME, NULL);
+	if (IS_ERR_OR_NULL(mgr->debugfs_root)) {
+		pr_debug("debugfs_create_dir fail\n");
+		mgr->debugfs_root = NULL;
+		return;
+	}
+
+	debugfs_create_file("stats", 0444, mgr->debugfs_root, mgr,
+		&mdss_rotator_stats_fops);
+}
+
 static const struct file_operations mdss_rotator_fops = {
 	.owner = THIS_MODULE,
 	.open = mdss_rotator_open,
@@ -2755,6 +2896,8 @@ static int mdss_rotator_probe(struct platform_device *pdev)
 		pr_err("res_init failed %d\n", ret);
 		goto error_res_init;
 	}
+
+	mdss_rotator_debugfs_init(rot_mgr);
 	return 0;
 
 error_res_init:
@@ -2782,6 +2925,7 @@ static int mdss_rotator_remove(struct platform_device *dev)
 		return -ENODEV;
 
 	sysfs_remove_group(&rot_mgr->device->kobj, &mdss_rotator_fs_attr_group);
+	debugfs_remove_recursive(mgr->debugfs_root);
 
 	mdss_rotator_release_all(mgr);
 
@@ -71,6 +71,8 @@ struct mdss_rot_hw_resource {
 
 struct mdss_rot_queue {
 	struct workqueue_struct *rot_work_queue;
+	/* waits for input and maps buffers ahead of rot_work_queue */
+	struct workqueue_struct *prep_work_queue;
 	struct mdss_rot_timeline timeline;
 
 	struct mutex hw_lock;
@@ -87,7 +89,9 @@ struct mdss_rot_entry_container {
 
 struct mdss_rot_entry {
 	struct mdp_rotation_item item;
+	struct work_struct prepare_work;
 	struct work_struct commit_work;
+	int prepare_status;
 
 	struct mdss_rot_queue *queue;
 	struct mdss_rot_entry_container *request;
@@ -119,6 +123,11 @@ struct mdss_rot_perf {
 	struct mutex work_dis_lock;
 	u32 *work_distribution;
 	int last_wb_idx; /* last known wb index, used when above count is 0 */
+
+	/* throughput statistics, protected by work_dis_lock */
+	u64 frame_cnt;
+	u64 pixel_cnt;
+	u64 hw_time_ns;
 };
 
 struct mdss_rot_file_private {
@@ -184,6 +193,8 @@ struct mdss_rot_mgr {
 
 	bool has_downscale;
 	bool has_ubwc;
+
+	struct dentry *debugfs_root;
 };
 
 #ifdef CONFIG_COMPAT
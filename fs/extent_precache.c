@@ -0,0 +1,192 @@
+/*
+ * fs/extent_precache.c
+ *
+ * Post-boot extent metadata preload.
+ *
+ * The first access to a large file after boot has to read the extent
+ * tree (ext4) or the node blocks (f2fs) that map it before any data
+ * can be read, and on a cold cache each of those is a synchronous read
+ * in front of the data it maps. Userspace writes the absolute paths of
+ * its hot files, one per line, to /proc/fs/extent_precache once boot
+ * has settled; each file is then walked through ->fiemap from an
+ * unbound worker at idle io priority, so that its mapping metadata is
+ * cached by the time it is opened for real.
+ *
+ * ext4 is asked to fill its extent status cache as well. No extent
+ * records are copied out, the walk only counts them.
+ */
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/fs.h>
+#include <linux/file.h>
+#include <linux/sched.h>
+#include <linux/ioprio.h>
+#include <linux/iocontext.h>
+#include <linux/workqueue.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+#include <linux/atomic.h>
+
+/* longest list accepted by a single write */
+#define EP_MAX_WRITE		PAGE_SIZE
+
+struct ep_work {
+	struct work_struct work;
+	char path[0];
+};
+
+static struct workqueue_struct *ep_wq;
+
+static atomic_t ep_queued = ATOMIC_INIT(0);
+static atomic_t ep_done = ATOMIC_INIT(0);
+static atomic_t ep_failed = ATOMIC_INIT(0);
+static atomic_long_t ep_extents = ATOMIC_LONG_INIT(0);
+
+static int ep_fiemap(struct inode *inode, u32 flags)
+{
+	struct fiemap_extent_info fieinfo = {
+		.fi_flags = flags,
+		.fi_extents_max = 0,
+	};
+	int ret;
+
+	ret = inode->i_op->fiemap(inode, &fieinfo, 0, i_size_read(inode));
+	if (!ret)
+		atomic_long_add(fieinfo.fi_extents_mapped, &ep_extents);
+
+	return ret;
+}
+
+static int ep_precache(const char *path)
+{
+	struct file *file;
+	struct inode *inode;
+	int ret = -EOPNOTSUPP;
+
+	file = filp_open(path, O_RDONLY | O_LARGEFILE, 0);
+	if (IS_ERR(file))
+		return PTR_ERR(file);
+
+	inode = file_inode(file);
+	if (S_ISREG(inode->i_mode) && inode->i_op->fiemap) {
+		/*
+		 * ext4 reads its whole extent tree into the extent status
+		 * cache on FIEMAP_FLAG_CACHE and then refuses the flag, as
+		 * does everything else; a plain walk follows in that case.
+		 */
+		ret = ep_fiemap(inode, FIEMAP_FLAG_CACHE);
+		if (ret == -EBADR)
+			ret = ep_fiemap(inode, 0);
+	}
+
+	fput(file);
+
+	return ret;
+}
+
+static void ep_work_fn(struct work_struct *work)
+{
+	struct ep_work *ew = container_of(work, struct ep_work, work);
+	struct io_context *ioc = current->io_context;
+	int ioprio = ioc ? ioc->ioprio : 0;
+
+	/* kworkers are shared, so only hold the idle class for this walk */
+	set_task_ioprio(current, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0));
+
+	if (ep_precache(ew->path))
+		atomic_inc(&ep_failed);
+	else
+		atomic_inc(&ep_done);
+
+	set_task_ioprio(current, ioprio);
+	kfree(ew);
+}
+
+static int ep_queue_path(const char *path)
+{
+	struct ep_work *ew;
+	size_t len = strlen(path);
+
+	if (path[0] != '/')
+		return -EINVAL;
+
+	ew = kmalloc(sizeof(*ew) + len + 1, GFP_KERNEL);
+	if (!ew)
+		return -ENOMEM;
+
+	memcpy(ew->path, path, len + 1);
+	INIT_WORK(&ew->work, ep_work_fn);
+	atomic_inc(&ep_queued);
+	queue_work(ep_wq, &ew->work);
+
+	return 0;
+}
+
+static ssize_t ep_write(struct file *file, const char __user *ubuf,
+			size_t count, loff_t *ppos)
+{
+	char *buf, *line, *cur;
+	int ret = 0;
+
+	if (!capable(CAP_SYS_ADMIN))
+		return -EPERM;
+	if (count >= EP_MAX_WRITE)
+		return -EINVAL;
+
+	buf = kmalloc(count + 1, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+	if (copy_from_user(buf, ubuf, count)) {
+		kfree(buf);
+		return -EFAULT;
+	}
+	buf[count] = '\0';
+
+	cur = buf;
+	while ((line = strsep(&cur, "\n")) != NULL) {
+		line = strim(line);
+		if (!*line)
+			continue;
+		ret = ep_queue_path(line);
+		if (ret)
+			break;
+	}
+	kfree(buf);
+
+	return ret ? ret : count;
+}
+
+static int ep_show(struct seq_file *m, void *v)
+{
+	seq_printf(m, "queued %d\ndone %d\nfailed %d\nextents %ld\n",
+		   atomic_read(&ep_queued), atomic_read(&ep_done),
+		   atomic_read(&ep_failed), atomic_long_read(&ep_extents));
+	return 0;
+}
+
+static int ep_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ep_show, NULL);
+}
+
+static const struct file_operations ep_fops = {
+	.open		= ep_open,
+	.read		= seq_read,
+	.write		= ep_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init extent_precache_init(void)
+{
+	ep_wq = alloc_workqueue("extent_precache", WQ_UNBOUND,
+				num_online_cpus());
+	if (!ep_wq)
+		return -ENOMEM;
+
+	proc_create("fs/extent_precache", S_IRUSR | S_IWUSR, NULL, &ep_fops);
+	return 0;
+}
+module_init(extent_precache_init);
@@ -754,6 +754,28 @@ retry:
 	goto retry;
 }
 
+/*
+ * Start writeback of dirty node and meta pages before freezing the
+ * FS-operations, so that block_operations() and do_checkpoint() only
+ * have to catch up with what was dirtied in the meantime.
+ */
+static void prepare_checkpoint(struct f2fs_sb_info *sbi)
+{
+	struct writeback_control wbc = {
+		.sync_mode = WB_SYNC_NONE,
+		.nr_to_write = LONG_MAX,
+		.for_reclaim = 0,
+	};
+	struct blk_plug plug;
+
+	blk_start_plug(&plug);
+	if (get_pages(sbi, F2FS_DIRTY_NODES))
+		sync_node_pages(sbi, 0, &wbc);
+	if (get_pages(sbi, F2FS_DIRTY_META))
+		sync_meta_pages(sbi, META, LONG_MAX);
+	blk_finish_plug(&plug);
+}
+
 /*
  * Freeze all the FS-operations for checkpoint.
  */
@@ -991,6 +1013,7 @@ void write_checkpoint(struct f2fs_sb_info *sbi, struct cp_control *cpc)
 {
 	struct f2fs_checkpoint *ckpt = F2FS_CKPT(sbi);
 	unsigned long long ckpt_ver;
+	ktime_t start, block_start;
 
 	trace_f2fs_write_checkpoint(sbi->sb, cpc->reason, "start block_ops");
 
@@ -1000,6 +1023,13 @@ void write_checkpoint(struct f2fs_sb_info *sbi, struct cp_control *cpc)
 		goto out;
 	if (unlikely(f2fs_cp_error(sbi)))
 		goto out;
+
+	start = ktime_get();
+	prepare_checkpoint(sbi);
+	if (unlikely(f2fs_cp_error(sbi)))
+		goto out;
+
+	block_start = ktime_get();
 	if (block_operations(sbi))
 		goto out;
 
@@ -1026,6 +1056,8 @@ void write_checkpoint(struct f2fs_sb_info *sbi, struct cp_control *cpc)
 
 	unblock_operations(sbi);
 	stat_inc_cp_count(sbi->stat_info);
+	stat_inc_cp_hist(sbi->cp_block_hist, block_start);
+	stat_inc_cp_hist(sbi->cp_total_hist, start);
 out:
 	mutex_unlock(&sbi->cp_mutex);
 	trace_f2fs_write_checkpoint(sbi->sb, cpc->reason, "finish checkpoint");
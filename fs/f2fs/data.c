@@ -743,6 +743,7 @@ static int f2fs_read_data_page(struct file *file, struct page *page)
 	int ret;
 
 	trace_f2fs_readpage(page, DATA);
+	f2fs_update_req_time(F2FS_I_SB(inode));
 
 	/* If the file has inline data, try to read it directly */
 	if (f2fs_has_inline_data(inode))
@@ -759,6 +760,8 @@ static int f2fs_read_data_pages(struct file *file,
 {
 	struct inode *inode = file->f_mapping->host;
 
+	f2fs_update_req_time(F2FS_I_SB(inode));
+
 	/* If the file has inline data, skip readpages */
 	if (f2fs_has_inline_data(inode))
 		return 0;
@@ -766,6 +769,29 @@ static int f2fs_read_data_pages(struct file *file,
 	return mpage_readpages(mapping, pages, nr_pages, get_data_block);
 }
 
+/*
+ * Track how often the data of a file without a temperature hint is
+ * rewritten, so that databases and their journals end up in the hot log
+ * instead of being mixed with data that is written once.
+ */
+static void update_rewrite_hint(struct inode *inode, bool rewrite)
+{
+	struct f2fs_inode_info *fi = F2FS_I(inode);
+
+	if (fi->i_advise & FADVISE_TEMP_MASK)
+		return;
+
+	if (time_after(jiffies, fi->i_rewrite_stamp + HOT_DATA_WINDOW)) {
+		if (fi->i_rewrites < HOT_DATA_REWRITES)
+			clear_inode_flag(fi, FI_HOT_DATA);
+		fi->i_rewrites = 0;
+		fi->i_rewrite_stamp = jiffies;
+	}
+
+	if (rewrite && ++fi->i_rewrites >= HOT_DATA_REWRITES)
+		set_inode_flag(fi, FI_HOT_DATA);
+}
+
 int do_write_data_page(struct page *page, struct f2fs_io_info *fio)
 {
 	struct inode *inode = page->mapping->host;
@@ -796,6 +822,7 @@ int do_write_data_page(struct page *page, struct f2fs_io_info *fio)
 		rewrite_data_page(page, old_blkaddr, fio);
 		set_inode_flag(F2FS_I(inode), FI_UPDATE_WRITE);
 	} else {
+		update_rewrite_hint(inode, old_blkaddr != NEW_ADDR);
 		write_data_page(page, &dn, &new_blkaddr, fio);
 		update_extent_cache(new_blkaddr, &dn);
 		set_inode_flag(F2FS_I(inode), FI_APPEND_WRITE);
@@ -958,6 +985,7 @@ static int f2fs_write_begin(struct file *file, struct address_space *mapping,
 
 	trace_f2fs_write_begin(inode, pos, len, flags);
 
+	f2fs_update_req_time(sbi);
 	f2fs_balance_fs(sbi);
 repeat:
 	err = f2fs_convert_inline_data(inode, pos + len, NULL);
@@ -1091,6 +1119,8 @@ static ssize_t f2fs_direct_IO(int rw, struct kiocb *iocb,
 	size_t count = iov_iter_count(iter);
 	int err;
 
+	f2fs_update_req_time(F2FS_I_SB(inode));
+
 	/* Let buffer I/O handle the inline data case. */
 	if (f2fs_has_inline_data(inode))
 		return 0;
@@ -58,6 +58,13 @@ static void update_general_status(struct f2fs_sb_info *sbi)
 	si->sits = SIT_I(sbi)->dirty_sentries;
 	si->fnids = NM_I(sbi)->fcnt;
 	si->bg_gc = sbi->bg_gc;
+	si->victim_search_count = sbi->victim_search_count;
+	si->victim_search_segs = sbi->victim_search_segs;
+	si->victim_search_time = sbi->victim_search_time;
+	memcpy(si->cp_total_hist, sbi->cp_total_hist,
+	       sizeof(si->cp_total_hist));
+	memcpy(si->cp_block_hist, sbi->cp_block_hist,
+	       sizeof(si->cp_block_hist));
 	si->util_free = (int)(free_user_blocks(sbi) >> sbi->log_blocks_per_seg)
 		* 100 / (int)(sbi->user_block_count >> sbi->log_blocks_per_seg)
 		/ 2;
@@ -234,10 +241,23 @@ static int stat_show(struct seq_file *s, void *v)
 		seq_printf(s, "  - Prefree: %d\n  - Free: %d (%d)\n\n",
 			   si->prefree_count, si->free_segs, si->free_secs);
 		seq_printf(s, "CP calls: %d\n", si->cp_count);
+		seq_puts(s, "  - latency(<ms):");
+		for (j = 0; j < F2FS_CP_HIST_BUCKETS - 1; j++)
+			seq_printf(s, " %5u", 1U << j);
+		seq_puts(s, "   inf\n  - total       :");
+		for (j = 0; j < F2FS_CP_HIST_BUCKETS; j++)
+			seq_printf(s, " %5u", si->cp_total_hist[j]);
+		seq_puts(s, "\n  - blocked     :");
+		for (j = 0; j < F2FS_CP_HIST_BUCKETS; j++)
+			seq_printf(s, " %5u", si->cp_block_hist[j]);
+		seq_putc(s, '\n');
 		seq_printf(s, "GC calls: %d (BG: %d)\n",
 			   si->call_count, si->bg_gc);
 		seq_printf(s, "  - data segments : %d\n", si->data_segs);
 		seq_printf(s, "  - node segments : %d\n", si->node_segs);
+		seq_printf(s, "Victim searches: %u, %u segments in %llu us\n",
+			   si->victim_search_count, si->victim_search_segs,
+			   div_u64(si->victim_search_time, NSEC_PER_USEC));
 		seq_printf(s, "Try to move %d blocks\n", si->tot_blks);
 		seq_printf(s, "  - data blocks : %d\n", si->data_blks);
 		seq_printf(s, "  - node blocks : %d\n", si->node_blks);
@@ -110,6 +110,9 @@ struct cp_control {
 	__u64 trimmed;
 };
 
+/* log2 millisecond buckets for checkpoint latency statistics */
+#define F2FS_CP_HIST_BUCKETS	11
+
 /*
  * For CP/NAT/SIT/SSA readahead
  */
@@ -199,6 +202,16 @@ static inline bool __has_cursum_space(struct f2fs_summary_block *sum, int size,
 #define F2FS_IOC_START_ATOMIC_WRITE	_IO(F2FS_IOCTL_MAGIC, 1)
 #define F2FS_IOC_COMMIT_ATOMIC_WRITE	_IO(F2FS_IOCTL_MAGIC, 2)
 #define F2FS_IOC_START_VOLATILE_WRITE	_IO(F2FS_IOCTL_MAGIC, 3)
+#define F2FS_IOC_GET_TEMPERATURE	_IOR(F2FS_IOCTL_MAGIC, 4, __u32)
+#define F2FS_IOC_SET_TEMPERATURE	_IOW(F2FS_IOCTL_MAGIC, 5, __u32)
+
+/*
+ * Data temperature hints for F2FS_IOC_[GS]ET_TEMPERATURE. Directories pass
+ * their hint on to the files created in them.
+ */
+#define F2FS_TEMP_AUTO			0	/* inferred by f2fs */
+#define F2FS_TEMP_HOT			1
+#define F2FS_TEMP_COLD			2
 
 #if defined(__KERNEL__) && defined(CONFIG_COMPAT)
 /*
@@ -246,6 +259,9 @@ struct extent_info {
  */
 #define FADVISE_COLD_BIT	0x01
 #define FADVISE_LOST_PINO_BIT	0x02
+#define FADVISE_HOT_BIT		0x20
+
+#define FADVISE_TEMP_MASK	(FADVISE_COLD_BIT | FADVISE_HOT_BIT)
 
 #define DEF_DIR_LEVEL		0
 
@@ -257,6 +273,8 @@ struct f2fs_inode_info {
 	unsigned int i_current_depth;	/* use only in directory structure */
 	unsigned int i_pino;		/* parent inode number */
 	umode_t i_acl_mode;		/* keep file acl mode temporarily */
+	unsigned int i_rewrites;	/* # of data rewrites in this window */
+	unsigned long i_rewrite_stamp;	/* start of the rewrite window */
 
 	/* Use below internally in f2fs*/
 	unsigned long flags;		/* use to pass per-file flags */
@@ -547,6 +565,7 @@ struct f2fs_sb_info {
 
 	/* maximum # of trials to find a victim segment for SSR and GC */
 	unsigned int max_victim_search;
+	unsigned long last_req_time;		/* last user request */
 
 	/*
 	 * for stat information.
@@ -560,6 +579,11 @@ struct f2fs_sb_info {
 	int inline_inode;			/* # of inline_data inodes */
 	int bg_gc;				/* background gc calls */
 	unsigned int n_dirty_dirs;		/* # of dir inodes */
+	unsigned int victim_search_count;	/* # of victim searches */
+	unsigned int victim_search_segs;	/* # of segments costed */
+	unsigned long long victim_search_time;	/* ns spent searching */
+	unsigned int cp_total_hist[F2FS_CP_HIST_BUCKETS]; /* whole cp */
+	unsigned int cp_block_hist[F2FS_CP_HIST_BUCKETS]; /* fs blocked */
 #endif
 	unsigned int last_victim[2];		/* last victim segment # */
 	spinlock_t stat_lock;			/* lock for stat operations */
@@ -662,6 +686,12 @@ static inline void F2FS_RESET_SB_DIRT(struct f2fs_sb_info *sbi)
 	sbi->s_dirty = 0;
 }
 
+/* Note a request from users, so that background GC waits for idle time */
+static inline void f2fs_update_req_time(struct f2fs_sb_info *sbi)
+{
+	sbi->last_req_time = jiffies;
+}
+
 static inline unsigned long long cur_cp_version(struct f2fs_checkpoint *cp)
 {
 	return le64_to_cpu(cp->checkpoint_ver);
@@ -1062,6 +1092,7 @@ enum {
 	FI_NEED_IPU,		/* used for ipu per file */
 	FI_ATOMIC_FILE,		/* indicate atomic file */
 	FI_VOLATILE_FILE,	/* indicate volatile file */
+	FI_HOT_DATA,		/* data is rewritten often */
 };
 
 static inline void set_inode_flag(struct f2fs_inode_info *fi, int flag)
@@ -1406,6 +1437,10 @@ struct f2fs_stat_info {
 	int nats, sits, fnids;
 	int total_count, utilization;
 	int bg_gc, inline_inode;
+	unsigned int victim_search_count, victim_search_segs;
+	unsigned long long victim_search_time;
+	unsigned int cp_total_hist[F2FS_CP_HIST_BUCKETS];
+	unsigned int cp_block_hist[F2FS_CP_HIST_BUCKETS];
 	unsigned int valid_count, valid_node_count, valid_inode_count;
 	unsigned int bimodal, avg_vblocks;
 	int util_free, util_valid, util_invalid;
@@ -1431,6 +1466,21 @@ static inline struct f2fs_stat_info *F2FS_STAT(struct f2fs_sb_info *sbi)
 #define stat_inc_cp_count(si)		((si)->cp_count++)
 #define stat_inc_call_count(si)		((si)->call_count++)
 #define stat_inc_bggc_count(sbi)	((sbi)->bg_gc++)
+#define stat_inc_victim_search(sbi, segs, start)			\
+	do {								\
+		(sbi)->victim_search_count++;				\
+		(sbi)->victim_search_segs += (segs);			\
+		(sbi)->victim_search_time +=				\
+			ktime_to_ns(ktime_sub(ktime_get(), (start)));	\
+	} while (0)
+/* bucket 0 is < 1ms, bucket i is [2^(i-1), 2^i) ms, the last is open */
+#define stat_inc_cp_hist(hist, start)					\
+	do {								\
+		u64 __ms = div_u64(ktime_to_ns(ktime_sub(ktime_get(),	\
+					(start))), NSEC_PER_MSEC);	\
+		int __b = __ms ? ilog2(__ms) + 1 : 0;			\
+		(hist)[min(__b, F2FS_CP_HIST_BUCKETS - 1)]++;		\
+	} while (0)
 #define stat_inc_dirty_dir(sbi)		((sbi)->n_dirty_dirs++)
 #define stat_dec_dirty_dir(sbi)		((sbi)->n_dirty_dirs--)
 #define stat_inc_total_hit(sb)		((F2FS_SB(sb))->total_hit_ext++)
@@ -1486,6 +1536,8 @@ void f2fs_destroy_root_stats(void);
 #define stat_inc_cp_count(si)
 #define stat_inc_call_count(si)
 #define stat_inc_bggc_count(si)
+#define stat_inc_victim_search(sbi, segs, start)
+#define stat_inc_cp_hist(hist, start)
 #define stat_inc_dirty_dir(sbi)
 #define stat_dec_dirty_dir(sbi)
 #define stat_inc_total_hit(sb)
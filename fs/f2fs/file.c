@@ -911,6 +911,52 @@ static int f2fs_ioc_start_volatile_write(struct file *filp)
 	return 0;
 }
 
+static int f2fs_ioc_get_temperature(struct file *filp, unsigned long arg)
+{
+	struct inode *inode = file_inode(filp);
+	__u32 temp = F2FS_TEMP_AUTO;
+
+	if (file_is_hot(inode))
+		temp = F2FS_TEMP_HOT;
+	else if (file_is_cold(inode))
+		temp = F2FS_TEMP_COLD;
+
+	return put_user(temp, (__u32 __user *)arg);
+}
+
+static int f2fs_ioc_set_temperature(struct file *filp, unsigned long arg)
+{
+	struct inode *inode = file_inode(filp);
+	__u32 temp;
+	int ret;
+
+	if (!inode_owner_or_capable(inode))
+		return -EACCES;
+
+	if (get_user(temp, (__u32 __user *)arg))
+		return -EFAULT;
+
+	if (temp > F2FS_TEMP_COLD)
+		return -EINVAL;
+
+	ret = mnt_want_write_file(filp);
+	if (ret)
+		return ret;
+
+	mutex_lock(&inode->i_mutex);
+	clear_file(inode, FADVISE_TEMP_MASK);
+	if (temp == F2FS_TEMP_HOT)
+		file_set_hot(inode);
+	else if (temp == F2FS_TEMP_COLD)
+		file_set_cold(inode);
+	clear_inode_flag(F2FS_I(inode), FI_HOT_DATA);
+	mutex_unlock(&inode->i_mutex);
+
+	mark_inode_dirty(inode);
+	mnt_drop_write_file(filp);
+	return 0;
+}
+
 static int f2fs_ioc_fitrim(struct file *filp, unsigned long arg)
 {
 	struct inode *inode = file_inode(filp);
@@ -954,6 +1000,10 @@ long f2fs_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 		return f2fs_ioc_commit_atomic_write(filp);
 	case F2FS_IOC_START_VOLATILE_WRITE:
 		return f2fs_ioc_start_volatile_write(filp);
+	case F2FS_IOC_GET_TEMPERATURE:
+		return f2fs_ioc_get_temperature(filp, arg);
+	case F2FS_IOC_SET_TEMPERATURE:
+		return f2fs_ioc_set_temperature(filp, arg);
 	case FITRIM:
 		return f2fs_ioc_fitrim(filp, arg);
 	default:
@@ -971,6 +1021,9 @@ long f2fs_compat_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 	case F2FS_IOC32_SETFLAGS:
 		cmd = F2FS_IOC_SETFLAGS;
 		break;
+	case F2FS_IOC_GET_TEMPERATURE:
+	case F2FS_IOC_SET_TEMPERATURE:
+		break;
 	default:
 		return -ENOIOCTLCMD;
 	}
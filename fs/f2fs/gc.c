@@ -26,6 +26,42 @@
 
 static struct kmem_cache *winode_slab;
 
+/*
+ * Forecast from the rate free sections were used up recently whether
+ * foreground GC will be needed within forecast_time ms, so that background
+ * GC can turn urgent before applications stall on it.
+ */
+static bool gc_forecast_urgent(struct f2fs_sb_info *sbi,
+				struct f2fs_gc_kthread *gc_th)
+{
+	unsigned int free_secs = free_sections(sbi);
+	unsigned int elapsed = jiffies_to_msecs(jiffies - gc_th->last_sample);
+	int node_secs = get_blocktype_secs(sbi, F2FS_DIRTY_NODES);
+	int dent_secs = get_blocktype_secs(sbi, F2FS_DIRTY_DENTS);
+	int headroom;
+	u64 rate = 0;
+
+	if (elapsed) {
+		if (free_secs < gc_th->last_free_secs)
+			rate = div_u64((u64)(gc_th->last_free_secs - free_secs)
+					* 60000 << GC_RATE_SHIFT, elapsed);
+		rate = min_t(u64, rate, UINT_MAX / 4);
+		gc_th->secs_rate = (gc_th->secs_rate * 3 + rate) / 4;
+		gc_th->last_free_secs = free_secs;
+		gc_th->last_sample = jiffies;
+	}
+
+	headroom = free_secs - (node_secs + 2 * dent_secs +
+					reserved_sections(sbi));
+	if (headroom <= 0)
+		return true;
+	if (!gc_th->secs_rate)
+		return false;
+
+	return div_u64((u64)headroom * 60000 << GC_RATE_SHIFT,
+			gc_th->secs_rate) < gc_th->forecast_time;
+}
+
 static int gc_thread_func(void *data)
 {
 	struct f2fs_sb_info *sbi = data;
@@ -50,6 +86,19 @@ static int gc_thread_func(void *data)
 			continue;
 		}
 
+		/*
+		 * In urgent mode, either asked for by userspace (e.g. screen
+		 * off and charging) or forecast from the write rate, GC does
+		 * not wait for idle and runs every urgent_sleep_time.
+		 */
+		gc_th->urgent = gc_th->gc_urgent ||
+				gc_forecast_urgent(sbi, gc_th);
+		if (gc_th->urgent) {
+			wait_ms = gc_th->urgent_sleep_time;
+			mutex_lock(&sbi->gc_mutex);
+			goto do_gc;
+		}
+
 		/*
 		 * [GC triggering condition]
 		 * 0. GC is not conducted currently.
@@ -76,7 +125,7 @@ static int gc_thread_func(void *data)
 			wait_ms = decrease_sleep_time(gc_th, wait_ms);
 		else
 			wait_ms = increase_sleep_time(gc_th, wait_ms);
-
+do_gc:
 		stat_inc_bggc_count(sbi);
 
 		/* if return value is not zero, no victim was selected */
@@ -107,8 +156,17 @@ int start_gc_thread(struct f2fs_sb_info *sbi)
 	gc_th->min_sleep_time = DEF_GC_THREAD_MIN_SLEEP_TIME;
 	gc_th->max_sleep_time = DEF_GC_THREAD_MAX_SLEEP_TIME;
 	gc_th->no_gc_sleep_time = DEF_GC_THREAD_NOGC_SLEEP_TIME;
+	gc_th->urgent_sleep_time = DEF_GC_THREAD_URGENT_SLEEP_TIME;
+	gc_th->idle_interval = DEF_GC_IDLE_INTERVAL;
 
 	gc_th->gc_idle = 0;
+	gc_th->gc_urgent = 0;
+	gc_th->urgent = false;
+
+	gc_th->forecast_time = DEF_GC_FORECAST_TIME;
+	gc_th->last_free_secs = free_sections(sbi);
+	gc_th->last_sample = jiffies;
+	gc_th->secs_rate = 0;
 
 	sbi->gc_thread = gc_th;
 	init_waitqueue_head(&sbi->gc_thread->gc_wait_queue_head);
@@ -143,6 +201,10 @@ static int select_gc_type(struct f2fs_gc_kthread *gc_th, int gc_type)
 		else if (gc_th->gc_idle == 2)
 			gc_mode = GC_GREEDY;
 	}
+
+	/* reclaim the most space per section moved while urgent */
+	if (gc_th && gc_th->urgent)
+		gc_mode = GC_GREEDY;
 	return gc_mode;
 }
 
@@ -262,6 +324,7 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 	struct victim_sel_policy p;
 	unsigned int secno, max_cost;
 	int nsearched = 0;
+	ktime_t start = ktime_get();
 
 	mutex_lock(&dirty_i->seglist_lock);
 
@@ -333,6 +396,8 @@ got_it:
 	}
 	mutex_unlock(&dirty_i->seglist_lock);
 
+	stat_inc_victim_search(sbi, nsearched, start);
+
 	return (p.min_segno == NULL_SEGNO) ? 0 : 1;
 }
 
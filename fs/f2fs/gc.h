@@ -16,6 +16,10 @@
 #define DEF_GC_THREAD_MIN_SLEEP_TIME	30000	/* milliseconds */
 #define DEF_GC_THREAD_MAX_SLEEP_TIME	60000
 #define DEF_GC_THREAD_NOGC_SLEEP_TIME	300000	/* wait 5 min */
+#define DEF_GC_THREAD_URGENT_SLEEP_TIME	500	/* 500 ms */
+#define DEF_GC_IDLE_INTERVAL		5000	/* 5 secs */
+#define DEF_GC_FORECAST_TIME		120000	/* 2 min */
+#define GC_RATE_SHIFT			4	/* secs_rate is in 1/16 */
 #define LIMIT_INVALID_BLOCK	40 /* percentage over total user space */
 #define LIMIT_FREE_BLOCK	40 /* percentage over invalid + free space */
 
@@ -30,9 +34,21 @@ struct f2fs_gc_kthread {
 	unsigned int min_sleep_time;
 	unsigned int max_sleep_time;
 	unsigned int no_gc_sleep_time;
+	unsigned int urgent_sleep_time;
+
+	/* ms without requests from users before the fs counts as idle */
+	unsigned int idle_interval;
 
 	/* for changing gc mode */
 	unsigned int gc_idle;
+	unsigned int gc_urgent;		/* urgent set by userspace */
+	bool urgent;			/* running in urgent mode */
+
+	/* for forecasting when free sections run out */
+	unsigned int forecast_time;	/* ms of headroom to turn urgent */
+	unsigned int last_free_secs;
+	unsigned long last_sample;	/* jiffies of last_free_secs */
+	unsigned int secs_rate;		/* sections used per min, 1/16 */
 };
 
 struct inode_entry {
@@ -106,5 +122,10 @@ static inline int is_idle(struct f2fs_sb_info *sbi)
 	struct block_device *bdev = sbi->sb->s_bdev;
 	struct request_queue *q = bdev_get_queue(bdev);
 	struct request_list *rl = &q->root_rl;
-	return !(rl->count[BLK_RW_SYNC]) && !(rl->count[BLK_RW_ASYNC]);
+
+	if (rl->count[BLK_RW_SYNC] || rl->count[BLK_RW_ASYNC])
+		return 0;
+
+	return time_after(jiffies, sbi->last_req_time +
+			msecs_to_jiffies(sbi->gc_thread->idle_interval));
 }
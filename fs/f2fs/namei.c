@@ -43,6 +43,9 @@ static struct inode *f2fs_new_inode(struct inode *dir, umode_t mode)
 
 	inode_init_owner(inode, dir, mode);
 
+	/* inherit the temperature hint of the parent directory */
+	F2FS_I(inode)->i_advise |= F2FS_I(dir)->i_advise & FADVISE_TEMP_MASK;
+
 	inode->i_ino = ino;
 	inode->i_blocks = 0;
 	inode->i_mtime = inode->i_atime = inode->i_ctime = CURRENT_TIME;
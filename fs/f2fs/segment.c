@@ -1032,6 +1032,16 @@ static bool __has_curseg_space(struct f2fs_sb_info *sbi, int type)
 	return false;
 }
 
+/* Hot data shares the log of directory data, which is rewritten often too */
+static inline bool is_hot_data(struct inode *inode)
+{
+	if (file_is_cold(inode))
+		return false;
+
+	return file_is_hot(inode) ||
+		is_inode_flag_set(F2FS_I(inode), FI_HOT_DATA);
+}
+
 static int __get_segment_type_2(struct page *page, enum page_type p_type)
 {
 	if (p_type == DATA)
@@ -1045,7 +1055,7 @@ static int __get_segment_type_4(struct page *page, enum page_type p_type)
 	if (p_type == DATA) {
 		struct inode *inode = page->mapping->host;
 
-		if (S_ISDIR(inode->i_mode))
+		if (S_ISDIR(inode->i_mode) || is_hot_data(inode))
 			return CURSEG_HOT_DATA;
 		else
 			return CURSEG_COLD_DATA;
@@ -1066,6 +1076,8 @@ static int __get_segment_type_6(struct page *page, enum page_type p_type)
 			return CURSEG_HOT_DATA;
 		else if (is_cold_data(page) || file_is_cold(inode))
 			return CURSEG_COLD_DATA;
+		else if (is_hot_data(inode))
+			return CURSEG_HOT_DATA;
 		else
 			return CURSEG_WARM_DATA;
 	} else {
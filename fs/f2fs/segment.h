@@ -495,6 +495,13 @@ static inline int utilization(struct f2fs_sb_info *sbi)
 #define DEF_MIN_IPU_UTIL	70
 #define DEF_MIN_FSYNC_BLOCKS	8
 
+/*
+ * A file without a temperature hint has its data written to the hot log
+ * once HOT_DATA_REWRITES of its blocks are rewritten within HOT_DATA_WINDOW.
+ */
+#define HOT_DATA_REWRITES	64
+#define HOT_DATA_WINDOW		(5 * HZ)
+
 enum {
 	F2FS_IPU_FORCE,
 	F2FS_IPU_SSR,
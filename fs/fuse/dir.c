@@ -7,6 +7,7 @@
 */
 
 #include "fuse_i.h"
+#include "fuse_shortcircuit.h"
 
 #include <linux/pagemap.h>
 #include <linux/file.h>
@@ -934,12 +935,17 @@ static int fuse_do_getattr(struct inode *inode, struct kstat *stat,
 	struct fuse_conn *fc = get_fuse_conn(inode);
 	struct fuse_req *req;
 	u64 attr_version;
+	struct fuse_inode *fi = get_fuse_inode(inode);
+	struct inode *lower_inode = ACCESS_ONCE(fi->lower_inode);
+	struct timespec lower_ctime = {0, 0};
 
 	req = fuse_get_req_nopages(fc);
 	if (IS_ERR(req))
 		return PTR_ERR(req);
 
 	attr_version = fuse_get_attr_version(fc);
+	if (lower_inode)
+		lower_ctime = lower_inode->i_ctime;
 
 	memset(&inarg, 0, sizeof(inarg));
 	memset(&outarg, 0, sizeof(outarg));
@@ -972,6 +978,7 @@ static int fuse_do_getattr(struct inode *inode, struct kstat *stat,
 			fuse_change_attributes(inode, &outarg.attr,
 					       attr_timeout(&outarg),
 					       attr_version);
+			fi->lower_ctime = lower_ctime;
 			if (stat)
 				fuse_fillattr(inode, &outarg.attr, stat);
 		}
@@ -986,7 +993,8 @@ int fuse_update_attributes(struct inode *inode, struct kstat *stat,
 	int err;
 	bool r;
 
-	if (time_before64(fi->i_time, get_jiffies_64())) {
+	if (time_before64(fi->i_time, get_jiffies_64()) &&
+	    !fuse_shortcircuit_attr_valid(inode)) {
 		r = true;
 		err = fuse_do_getattr(inode, stat, file);
 	} else {
@@ -1395,12 +1403,16 @@ static int fuse_readdir(struct file *file, struct dir_context *ctx)
 	struct page *page;
 	struct inode *inode = file_inode(file);
 	struct fuse_conn *fc = get_fuse_conn(inode);
+	struct fuse_file *ff = file->private_data;
 	struct fuse_req *req;
 	u64 attr_version = 0;
 
 	if (is_bad_inode(inode))
 		return -EIO;
 
+	if (ff->rw_lower_file)
+		return fuse_shortcircuit_readdir(file, ctx);
+
 	req = fuse_get_req(fc, 1);
 	if (IS_ERR(req))
 		return PTR_ERR(req);
@@ -225,6 +225,8 @@ void fuse_finish_open(struct inode *inode, struct file *file)
 	}
 	if ((file->f_mode & FMODE_WRITE) && fc->writeback_cache)
 		fuse_link_write_file(file);
+	if (ff->rw_lower_file)
+		fuse_shortcircuit_attach_inode(inode, ff->rw_lower_file);
 }
 
 int fuse_open_common(struct inode *inode, struct file *file, bool isdir)
@@ -2016,6 +2018,17 @@ static const struct vm_operations_struct fuse_file_vm_ops = {
 
 static int fuse_file_mmap(struct file *file, struct vm_area_struct *vma)
 {
+	struct fuse_file *ff = file->private_data;
+
+	/*
+	 * Writable shared mappings can only go to the lower file if it was
+	 * opened for writing too, otherwise keep them on the fuse file.
+	 */
+	if (ff->rw_lower_file && ff->rw_lower_file->f_op->mmap &&
+	    (!(vma->vm_flags & VM_SHARED) || !(vma->vm_flags & VM_MAYWRITE) ||
+	     (ff->rw_lower_file->f_mode & FMODE_WRITE)))
+		return fuse_shortcircuit_mmap(file, vma);
+
 	if ((vma->vm_flags & VM_SHARED) && (vma->vm_flags & VM_MAYWRITE))
 		fuse_link_write_file(file);
 
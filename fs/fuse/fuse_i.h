@@ -109,6 +109,12 @@ struct fuse_inode {
 
 	/** Miscellaneous bits describing inode state */
 	unsigned long state;
+
+	/** Lower inode of a shortcircuited open, held until eviction */
+	struct inode *lower_inode;
+
+	/** ctime of lower_inode when the attributes were last fetched */
+	struct timespec lower_ctime;
 };
 
 /** FUSE inode state bits */
@@ -492,6 +498,9 @@ struct fuse_conn {
 	/** Shortcircuited IO. */
 	unsigned shortcircuit_io:1;
 
+	/** Shortcircuited readdir, needs shortcircuit_io */
+	unsigned shortcircuit_dir:1;
+
 	/*
 	 * The following bitfields are only for optimization purposes
 	 * and hence races in setting them will not cause malfunction
@@ -26,6 +26,17 @@ ssize_t fuse_shortcircuit_read_iter(struct kiocb *iocb, struct iov_iter *to);
 
 ssize_t fuse_shortcircuit_write_iter(struct kiocb *iocb, struct iov_iter *from);
 
+int fuse_shortcircuit_mmap(struct file *file, struct vm_area_struct *vma);
+
+int fuse_shortcircuit_readdir(struct file *file, struct dir_context *ctx);
+
 void fuse_shortcircuit_release(struct fuse_file *ff);
 
+void fuse_shortcircuit_attach_inode(struct inode *inode,
+				    struct file *lower_file);
+
+void fuse_shortcircuit_evict_inode(struct inode *inode);
+
+bool fuse_shortcircuit_attr_valid(struct inode *inode);
+
 #endif /* _FS_FUSE_SHORCIRCUIT_H */
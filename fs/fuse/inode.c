@@ -7,6 +7,7 @@
 */
 
 #include "fuse_i.h"
+#include "fuse_shortcircuit.h"
 
 #include <linux/pagemap.h>
 #include <linux/slab.h>
@@ -93,6 +94,9 @@ static struct inode *fuse_alloc_inode(struct super_block *sb)
 	fi->writectr = 0;
 	fi->orig_ino = 0;
 	fi->state = 0;
+	fi->lower_inode = NULL;
+	fi->lower_ctime.tv_sec = 0;
+	fi->lower_ctime.tv_nsec = 0;
 	INIT_LIST_HEAD(&fi->write_files);
 	INIT_LIST_HEAD(&fi->queued_writes);
 	INIT_LIST_HEAD(&fi->writepages);
@@ -131,6 +135,7 @@ static void fuse_evict_inode(struct inode *inode)
 		fuse_queue_forget(fc, fi->forget, fi->nodeid, fi->nlookup);
 		fi->forget = NULL;
 	}
+	fuse_shortcircuit_evict_inode(inode);
 }
 
 static int fuse_remount_fs(struct super_block *sb, int *flags, char *data)
@@ -910,6 +915,8 @@ static void process_init_reply(struct fuse_conn *fc, struct fuse_req *req)
 				fc->shortcircuit_io = 1;
 				pr_info("FUSE: SHORTCIRCUIT enabled [%s : %d]!\n",
 					current->comm, current->pid);
+				if (arg->flags & FUSE_SHORTCIRCUIT_DIR)
+					fc->shortcircuit_dir = 1;
 			}
 			if (arg->time_gran && arg->time_gran <= 1000000000)
 				fc->sb->s_time_gran = arg->time_gran;
@@ -30,7 +30,8 @@ void fuse_setup_shortcircuit(struct fuse_conn *fc, struct fuse_req *req)
 		return;
 
 	if ((req->in.h.opcode != FUSE_OPEN) &&
-	    (req->in.h.opcode != FUSE_CREATE))
+	    (req->in.h.opcode != FUSE_CREATE) &&
+	    (req->in.h.opcode != FUSE_OPENDIR || !fc->shortcircuit_dir))
 		return;
 
 	open_out_index = req->in.numargs - 1;
@@ -103,6 +104,48 @@ ssize_t fuse_shortcircuit_write_iter(struct kiocb *iocb, struct iov_iter *from)
 	return fuse_shortcircuit_read_write_iter(iocb, from, 1);
 }
 
+/*
+ * Map the lower file instead of the fuse one, so page faults are served by
+ * the lower filesystem. Reads and writes already bypass the fuse page cache
+ * of shortcircuited files, so this also keeps mmap coherent with them.
+ */
+int fuse_shortcircuit_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct fuse_file *ff = file->private_data;
+	struct file *lower_file = ff->rw_lower_file;
+	int ret;
+
+	if (WARN_ON(file != vma->vm_file))
+		return -EIO;
+
+	vma->vm_file = get_file(lower_file);
+	ret = lower_file->f_op->mmap(lower_file, vma);
+	if (ret) {
+		/* the caller drops its reference on vma->vm_file */
+		vma->vm_file = file;
+		fput(lower_file);
+		return ret;
+	}
+
+	fput(file);
+	fsstack_copy_attr_atime(file_inode(file), file_inode(lower_file));
+
+	return 0;
+}
+
+int fuse_shortcircuit_readdir(struct file *file, struct dir_context *ctx)
+{
+	struct fuse_file *ff = file->private_data;
+	struct file *lower_file = ff->rw_lower_file;
+	int ret_val;
+
+	lower_file->f_pos = ctx->pos;
+	ret_val = iterate_dir(lower_file, ctx);
+	fsstack_copy_attr_atime(file_inode(file), file_inode(lower_file));
+
+	return ret_val;
+}
+
 void fuse_shortcircuit_release(struct fuse_file *ff)
 {
 	if (!(ff->rw_lower_file))
@@ -112,3 +155,58 @@ void fuse_shortcircuit_release(struct fuse_file *ff)
 	fput(ff->rw_lower_file);
 	ff->rw_lower_file = NULL;
 }
+
+/*
+ * Remember the lower inode of a shortcircuited file so that getattr can
+ * tell whether the attributes from the daemon are still current: any
+ * change to the lower inode, through fuse or not, moves its ctime.
+ */
+void fuse_shortcircuit_attach_inode(struct inode *inode,
+				    struct file *lower_file)
+{
+	struct fuse_conn *fc = get_fuse_conn(inode);
+	struct fuse_inode *fi = get_fuse_inode(inode);
+	struct inode *lower_inode;
+
+	if (fi->lower_inode)
+		return;
+
+	lower_inode = igrab(file_inode(lower_file));
+	if (!lower_inode)
+		return;
+
+	spin_lock(&fc->lock);
+	if (!fi->lower_inode) {
+		fi->lower_inode = lower_inode;
+		lower_inode = NULL;
+	}
+	spin_unlock(&fc->lock);
+
+	if (lower_inode)
+		iput(lower_inode);
+}
+
+void fuse_shortcircuit_evict_inode(struct inode *inode)
+{
+	struct fuse_inode *fi = get_fuse_inode(inode);
+
+	if (!fi->lower_inode)
+		return;
+
+	iput(fi->lower_inode);
+	fi->lower_inode = NULL;
+}
+
+bool fuse_shortcircuit_attr_valid(struct inode *inode)
+{
+	struct fuse_inode *fi = get_fuse_inode(inode);
+	struct inode *lower_inode = ACCESS_ONCE(fi->lower_inode);
+
+	if (!lower_inode)
+		return false;
+
+	if (!fi->lower_ctime.tv_sec && !fi->lower_ctime.tv_nsec)
+		return false;
+
+	return timespec_equal(&fi->lower_ctime, &lower_inode->i_ctime);
+}
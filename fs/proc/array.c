@@ -142,7 +142,7 @@ static const char * const task_state_array[] = {
 	"Z (zombie)",		/*  32 */
 };
 
-static inline const char *get_task_state(struct task_struct *tsk)
+const char *get_task_state(struct task_struct *tsk)
 {
 	unsigned int state = (tsk->state | tsk->exit_state) & TASK_REPORT;
 
@@ -292,6 +292,29 @@ static int proc_pid_schedstat(struct seq_file *m, struct pid_namespace *ns,
 }
 #endif
 
+#if defined(CONFIG_SCHEDSTATS) || defined(CONFIG_TASK_DELAY_ACCT)
+/*
+ * Histogram of the time the task spent runnable before getting a cpu.
+ * Each line is the bucket's upper bound in microseconds and its count.
+ */
+static int proc_pid_sched_wait_hist(struct seq_file *m,
+		struct pid_namespace *ns, struct pid *pid,
+		struct task_struct *task)
+{
+	int i;
+
+	for (i = 0; i < SCHED_WAIT_HIST_BUCKETS - 1; i++)
+		seq_printf(m, "<%llu %u\n",
+			   (1ULL << (SCHED_WAIT_HIST_SHIFT + i)) / NSEC_PER_USEC,
+			   task->sched_info.wait_hist[i]);
+	seq_printf(m, ">=%llu %u\n",
+		   (1ULL << (SCHED_WAIT_HIST_SHIFT + i - 1)) / NSEC_PER_USEC,
+		   task->sched_info.wait_hist[i]);
+
+	return 0;
+}
+#endif
+
 #ifdef CONFIG_LATENCYTOP
 static int lstats_show_proc(struct seq_file *m, void *v)
 {
@@ -1303,7 +1326,6 @@ static const struct file_operations proc_pid_sched_init_task_load_operations = {
 	.release	= single_release,
 };
 
-#ifndef CONFIG_SCHED_QHMP
 static int sched_group_id_show(struct seq_file *m, void *v)
 {
 	struct inode *inode = m->private;
@@ -1365,7 +1387,71 @@ static const struct file_operations proc_pid_sched_group_id_operations = {
 	.llseek		= seq_lseek,
 	.release	= single_release,
 };
-#endif  
+
+#ifdef CONFIG_SCHED_QHMP
+static int sched_freq_floor_show(struct seq_file *m, void *v)
+{
+	struct inode *inode = m->private;
+	struct task_struct *p;
+
+	p = get_proc_task(inode);
+	if (!p)
+		return -ESRCH;
+
+	seq_printf(m, "%u\n", sched_get_freq_floor(p));
+
+	put_task_struct(p);
+
+	return 0;
+}
+
+static ssize_t
+sched_freq_floor_write(struct file *file, const char __user *buf,
+	    size_t count, loff_t *offset)
+{
+	struct inode *inode = file_inode(file);
+	struct task_struct *p;
+	char buffer[PROC_NUMBUF];
+	unsigned int freq_floor;
+	int err;
+
+	memset(buffer, 0, sizeof(buffer));
+	if (count > sizeof(buffer) - 1)
+		count = sizeof(buffer) - 1;
+	if (copy_from_user(buffer, buf, count)) {
+		err = -EFAULT;
+		goto out;
+	}
+
+	err = kstrtouint(strstrip(buffer), 0, &freq_floor);
+	if (err)
+		goto out;
+
+	p = get_proc_task(inode);
+	if (!p)
+		return -ESRCH;
+
+	err = sched_set_freq_floor(p, freq_floor);
+
+	put_task_struct(p);
+
+out:
+	return err < 0 ? err : count;
+}
+
+static int sched_freq_floor_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, sched_freq_floor_show, inode);
+}
+
+static const struct file_operations proc_pid_sched_freq_floor_operations = {
+	.open		= sched_freq_floor_open,
+	.read		= seq_read,
+	.write		= sched_freq_floor_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+#endif
 #endif	
 
 #ifdef CONFIG_SCHED_AUTOGROUP
@@ -2644,8 +2730,9 @@ static const struct pid_entry tgid_base_stuff[] = {
 #endif
 #ifdef CONFIG_SCHED_HMP
 	REG("sched_init_task_load",      S_IRUGO|S_IWUSR, proc_pid_sched_init_task_load_operations),
-#ifndef CONFIG_SCHED_QHMP
 	REG("sched_group_id",      S_IRUGO|S_IWUSR, proc_pid_sched_group_id_operations),
+#ifdef CONFIG_SCHED_QHMP
+	REG("sched_freq_floor",      S_IRUGO|S_IWUSR, proc_pid_sched_freq_floor_operations),
 #endif
 #endif
 #ifdef CONFIG_SCHED_DEBUG
@@ -2692,6 +2779,9 @@ static const struct pid_entry tgid_base_stuff[] = {
 #ifdef CONFIG_SCHEDSTATS
 	ONE("schedstat",  S_IRUGO, proc_pid_schedstat),
 #endif
+#if defined(CONFIG_SCHEDSTATS) || defined(CONFIG_TASK_DELAY_ACCT)
+	ONE("sched_wait_hist", S_IRUGO, proc_pid_sched_wait_hist),
+#endif
 #ifdef CONFIG_LATENCYTOP
 	REG("latency",  S_IRUGO, proc_lstats_operations),
 #endif
@@ -2993,6 +3083,9 @@ static const struct pid_entry tid_base_stuff[] = {
 #ifdef CONFIG_SCHEDSTATS
 	ONE("schedstat", S_IRUGO, proc_pid_schedstat),
 #endif
+#if defined(CONFIG_SCHEDSTATS) || defined(CONFIG_TASK_DELAY_ACCT)
+	ONE("sched_wait_hist", S_IRUGO, proc_pid_sched_wait_hist),
+#endif
 #ifdef CONFIG_LATENCYTOP
 	REG("latency",  S_IRUGO, proc_lstats_operations),
 #endif
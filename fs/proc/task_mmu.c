@@ -1438,15 +1438,12 @@ cont:
 	return 0;
 }
 
-enum reclaim_type {
-	RECLAIM_FILE,
-	RECLAIM_ANON,
-	RECLAIM_ALL,
-	RECLAIM_RANGE,
-};
-
-struct reclaim_param reclaim_task_anon(struct task_struct *task,
-		int nr_to_reclaim)
+/*
+ * Reclaim up to nr_to_reclaim pages of the given type (RECLAIM_RANGE is
+ * not supported here) from the task's address space.
+ */
+struct reclaim_param reclaim_task(struct task_struct *task,
+		enum reclaim_type type, int nr_to_reclaim)
 {
 	struct mm_struct *mm;
 	struct vm_area_struct *vma;
@@ -1471,7 +1468,10 @@ struct reclaim_param reclaim_task_anon(struct task_struct *task,
 		if (is_vm_hugetlb_page(vma))
 			continue;
 
-		if (vma->vm_file)
+		if (type == RECLAIM_ANON && vma->vm_file)
+			continue;
+
+		if (type == RECLAIM_FILE && !vma->vm_file)
 			continue;
 
 		if (!rp.nr_to_reclaim)
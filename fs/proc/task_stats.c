@@ -0,0 +1,173 @@
+/*
+ * /proc/task_stats: compact binary stats of every process in one read.
+ *
+ * Monitors that sample /proc/<pid>/stat, statm and oom_score_adj for all
+ * processes pay several syscalls, the sighand lock and an mm reference
+ * per process. Here the whole table is gathered in a single walk under
+ * RCU when a read starts at offset 0, and then copied out as an array of
+ * struct proc_task_stat.
+ */
+#include <linux/cred.h>
+#include <linux/fs.h>
+#include <linux/init.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/pid_namespace.h>
+#include <linux/proc_fs.h>
+#include <linux/ptrace.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <linux/proc_task_stats.h>
+#include "internal.h"
+
+/* head room for processes forked between sizing and walking */
+#define TASK_STATS_SLACK	64
+
+struct task_stats_buf {
+	struct mutex lock;
+	struct proc_task_stat *stats;
+	unsigned int nr;
+	unsigned int capacity;
+};
+
+/* Caller holds rcu_read_lock() */
+static void task_stats_fill(struct proc_task_stat *st,
+			    struct task_struct *task,
+			    struct pid_namespace *ns,
+			    struct user_namespace *user_ns)
+{
+	struct signal_struct *sig = task->signal;
+	struct task_struct *t;
+	struct mm_struct *mm;
+	cputime_t utime, stime;
+	unsigned long min_flt, maj_flt;
+
+	memset(st, 0, sizeof(*st));
+	st->pid = task_tgid_nr_ns(task, ns);
+	st->ppid = task_tgid_nr_ns(rcu_dereference(task->real_parent), ns);
+	st->uid = from_kuid_munged(user_ns, task_uid(task));
+	st->oom_score_adj = sig->oom_score_adj;
+	st->nice = task_nice(task);
+	st->state = *get_task_state(task);
+	st->num_threads = get_nr_threads(task);
+	st->start_time = task->real_start_time;
+	get_task_comm(st->comm, task);
+
+	min_flt = sig->min_flt;
+	maj_flt = sig->maj_flt;
+	for_each_thread(task, t) {
+		min_flt += t->min_flt;
+		maj_flt += t->maj_flt;
+	}
+	st->min_flt = min_flt;
+	st->maj_flt = maj_flt;
+
+	thread_group_cputime_adjusted(task, &utime, &stime);
+	st->utime = cputime_to_nsecs(utime);
+	st->stime = cputime_to_nsecs(stime);
+
+	/* the counters are atomic, so no mmap_sem and no mm reference */
+	task_lock(task);
+	mm = task->mm;
+	if (mm && !(task->flags & PF_KTHREAD)) {
+		st->vsize = PAGE_SIZE * mm->total_vm;
+		st->rss = get_mm_rss(mm);
+		st->shared = get_mm_counter(mm, MM_FILEPAGES);
+	}
+	task_unlock(task);
+}
+
+static int task_stats_collect(struct task_stats_buf *buf,
+			      struct pid_namespace *ns)
+{
+	struct user_namespace *user_ns = current_user_ns();
+	struct task_struct *p;
+	unsigned int capacity = nr_threads + TASK_STATS_SLACK;
+
+	if (capacity > buf->capacity) {
+		vfree(buf->stats);
+		buf->stats = vmalloc(capacity * sizeof(*buf->stats));
+		if (!buf->stats) {
+			buf->capacity = buf->nr = 0;
+			return -ENOMEM;
+		}
+		buf->capacity = capacity;
+	}
+
+	buf->nr = 0;
+	rcu_read_lock();
+	for_each_process(p) {
+		if (buf->nr == buf->capacity)
+			break;
+		if (!pid_alive(p) || !task_tgid_nr_ns(p, ns))
+			continue;
+		if (ns->hide_pid && !ptrace_may_access(p, PTRACE_MODE_READ))
+			continue;
+
+		task_stats_fill(&buf->stats[buf->nr++], p, ns, user_ns);
+	}
+	rcu_read_unlock();
+
+	return 0;
+}
+
+static ssize_t task_stats_read(struct file *file, char __user *ubuf,
+			       size_t count, loff_t *ppos)
+{
+	struct task_stats_buf *buf = file->private_data;
+	struct pid_namespace *ns = file_inode(file)->i_sb->s_fs_info;
+	ssize_t ret;
+
+	mutex_lock(&buf->lock);
+	if (*ppos == 0) {
+		ret = task_stats_collect(buf, ns);
+		if (ret)
+			goto out;
+	}
+
+	ret = simple_read_from_buffer(ubuf, count, ppos, buf->stats,
+				      buf->nr * sizeof(*buf->stats));
+out:
+	mutex_unlock(&buf->lock);
+	return ret;
+}
+
+static int task_stats_open(struct inode *inode, struct file *file)
+{
+	struct task_stats_buf *buf;
+
+	buf = kzalloc(sizeof(*buf), GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	mutex_init(&buf->lock);
+	file->private_data = buf;
+
+	return 0;
+}
+
+static int task_stats_release(struct inode *inode, struct file *file)
+{
+	struct task_stats_buf *buf = file->private_data;
+
+	vfree(buf->stats);
+	kfree(buf);
+
+	return 0;
+}
+
+static const struct file_operations task_stats_proc_fops = {
+	.open		= task_stats_open,
+	.read		= task_stats_read,
+	.llseek		= default_llseek,
+	.release	= task_stats_release,
+};
+
+static int __init proc_task_stats_init(void)
+{
+	proc_create("task_stats", S_IRUGO, NULL, &task_stats_proc_fops);
+	return 0;
+}
+fs_initcall(proc_task_stats_init);
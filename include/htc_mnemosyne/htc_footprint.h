@@ -65,6 +65,46 @@ enum HOTPLUG_ON_FOOTPRINT {
 	HOF_LEAVE,
 };
 
+/*
+ * Binary footprint event, one 64-bit word in the ring of the CPU that
+ * recorded it:
+ *	[63:44]	per-cpu sequence number
+ *	[43:40]	cpu the event is about
+ *	[39:32]	event id, FP_EV_NONE marks an empty slot
+ *	[31:0]	event argument
+ */
+#define FP_EV_SEQ_SHIFT		44
+#define FP_EV_SEQ_MASK		0xfffff
+#define FP_EV_CPU_SHIFT		40
+#define FP_EV_CPU_MASK		0xf
+#define FP_EV_ID_SHIFT		32
+#define FP_EV_ID_MASK		0xff
+
+#undef DECLARE_FOOTPRINT_EVENT
+#define DECLARE_FOOTPRINT_EVENT(name, category)	FP_EV_##name,
+enum footprint_event {
+	FP_EV_NONE,
+#include <htc_mnemosyne/htc_footprint_event.inc>
+	FP_EV_NR,
+};
+
+#undef DECLARE_FOOTPRINT_EVENT
+#define DECLARE_FOOTPRINT_EVENT(name, category)				\
+	FP_EV_ON_##name =						\
+		IS_ENABLED(CONFIG_HTC_DEBUG_FOOTPRINT_EVENTS_##category),
+enum {
+#include <htc_mnemosyne/htc_footprint_event.inc>
+};
+#undef DECLARE_FOOTPRINT_EVENT
+
+void __htc_footprint_event(unsigned cpu, enum footprint_event ev, u32 arg);
+
+/* Events of a disabled category compile to nothing */
+#define htc_footprint_event(cpu, name, arg)	do {			\
+		if (FP_EV_ON_##name)					\
+			__htc_footprint_event(cpu, FP_EV_##name, arg);	\
+	} while (0)
+
 int read_backup_cc_uah(void);
 void write_backup_cc_uah(int cc_reading);
 int read_backup_ocv_uv(void);
@@ -126,6 +126,8 @@ struct request {
 	unsigned long start_time;
 #ifdef CONFIG_BLK_CGROUP
 	struct request_list *rl;		
+#endif
+#if defined(CONFIG_BLK_CGROUP) || defined(CONFIG_BLK_LATENCY_HIST)
 	unsigned long long start_time_ns;
 	unsigned long long io_start_time_ns;    
 #endif
@@ -369,6 +371,9 @@ struct request_queue {
 #ifdef CONFIG_BLK_DEV_THROTTLING
 	
 	struct throtl_data *td;
+#endif
+#ifdef CONFIG_BLK_LATENCY_HIST
+	struct blk_latency_hist __percpu *latency_hist;
 #endif
 	struct rcu_head		rcu_head;
 	wait_queue_head_t	mq_freeze_wq;
@@ -1224,7 +1229,7 @@ int kblockd_schedule_work(struct work_struct *work);
 int kblockd_schedule_delayed_work(struct delayed_work *dwork, unsigned long delay);
 int kblockd_schedule_delayed_work_on(int cpu, struct delayed_work *dwork, unsigned long delay);
 
-#ifdef CONFIG_BLK_CGROUP
+#if defined(CONFIG_BLK_CGROUP) || defined(CONFIG_BLK_LATENCY_HIST)
 static inline void set_start_time_ns(struct request *req)
 {
 	preempt_disable();
@@ -28,4 +28,5 @@ extern int cma_init_reserved_mem(phys_addr_t base,
 extern struct page *cma_alloc(struct cma *cma, size_t count,
 				unsigned int align);
 extern bool cma_release(struct cma *cma, struct page *pages, int count);
+extern void cma_prefill(struct cma *cma, size_t count);
 #endif
@@ -0,0 +1,39 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#ifndef _LINUX_CPU_BOOST_H
+#define _LINUX_CPU_BOOST_H
+
+#include <linux/errno.h>
+
+struct notifier_block;
+
+/*
+ * Sent from atomic context when an input event starts a boost, data
+ * points to the boost duration in ms as an unsigned int.
+ */
+#define CPU_BOOST_INPUT		1
+
+#if IS_ENABLED(CONFIG_CPU_BOOST)
+int cpu_boost_register_notifier(struct notifier_block *nb);
+int cpu_boost_unregister_notifier(struct notifier_block *nb);
+#else
+static inline int cpu_boost_register_notifier(struct notifier_block *nb)
+{
+	return -ENODEV;
+}
+static inline int cpu_boost_unregister_notifier(struct notifier_block *nb)
+{
+	return -ENODEV;
+}
+#endif
+
+#endif /* _LINUX_CPU_BOOST_H */
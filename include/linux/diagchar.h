@@ -816,6 +816,32 @@ static const uint32_t log_code_last_tbl[] = {
 	0x0,	
 };
 
+/*
+ * Memory device mode clients can mmap() the diag device to receive their
+ * data through a ring instead of read(). The first page of the mapping
+ * holds struct diag_md_ring_hdr, the data area of hdr->size bytes starts
+ * on the second page. Each packet is a struct diag_md_ring_rec followed
+ * by len bytes of data, padded to four bytes. A record with len set to
+ * DIAG_MD_RING_PAD, or fewer than sizeof(struct diag_md_ring_rec) bytes
+ * left before the end of the data area, means the next record starts at
+ * the beginning. The driver advances head, the client advances tail.
+ */
+#define DIAG_MD_RING_MAGIC	0x44524e47
+#define DIAG_MD_RING_PAD	-1
+
+struct diag_md_ring_hdr {
+	uint32_t magic;
+	uint32_t size;
+	uint32_t head;
+	uint32_t tail;
+	uint32_t dropped;
+};
+
+struct diag_md_ring_rec {
+	int32_t token;
+	int32_t len;
+};
+
 #define LOG_GET_ITEM_NUM(xx_code)	(xx_code & 0x0FFF)
 #define LOG_GET_EQUIP_ID(xx_code)	((xx_code & 0xF000) >> 12)
 #define LOG_ITEMS_TO_SIZE(num_items)	((num_items+7)/8)
@@ -33,6 +33,7 @@ struct user_perf_data {
 };
 
 extern void pnpmgr_init_perf_table(struct user_perf_data *pdata);
+extern void pnpmgr_battery_level_notify(int level);
 
 #endif
 
@@ -79,6 +79,10 @@ struct synaptics_dsx_board_data {
 	uint8_t support_glove;
 	uint8_t support_cover;
 	uint32_t hall_block_touch_time;
+	/* cpus the irq thread is pinned to, 0 leaves it unpinned */
+	uint32_t irq_cpu_mask;
+	/* SCHED_FIFO priority of the irq thread, 0 keeps the default */
+	uint32_t irq_thread_prio;
 	int config_num;
 	struct synaptics_rmi4_config *config_table;
 	struct kobject *vk_obj;
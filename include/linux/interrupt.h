@@ -260,6 +260,14 @@ extern int irq_set_affinity_hint(unsigned int irq, const struct cpumask *m);
 extern int
 irq_set_affinity_notifier(unsigned int irq, struct irq_affinity_notify *notify);
 
+#ifdef CONFIG_IRQ_BALANCE_HMP
+extern void irq_balance_isolate_cpu(int cpu);
+extern void irq_balance_unisolate_cpu(int cpu);
+#else
+static inline void irq_balance_isolate_cpu(int cpu) { }
+static inline void irq_balance_unisolate_cpu(int cpu) { }
+#endif
+
 #else /* CONFIG_SMP */
 
 static inline int irq_set_affinity(unsigned int irq, const struct cpumask *m)
@@ -100,6 +100,8 @@ enum iommu_attr {
 	DOMAIN_ATTR_PROCID,
 	DOMAIN_ATTR_DYNAMIC,
 	DOMAIN_ATTR_NON_FATAL_FAULTS,
+	DOMAIN_ATTR_USE_CONT_HINT,
+	DOMAIN_ATTR_DEFER_TLB_FLUSH,
 	DOMAIN_ATTR_MAX,
 };
 
@@ -89,10 +89,16 @@ enum ipa_aggr_mode {
  * invoked for on data path
  * @IPA_RECEIVE: data is struct sk_buff
  * @IPA_WRITE_DONE: data is struct sk_buff
+ * @IPA_CLIENT_START_POLL: pipe entered polling mode, client should schedule
+ *  its NAPI instance. data is unused
+ * @IPA_CLIENT_COMP_NAPI: pipe is empty and back in interrupt mode, client
+ *  should complete its NAPI instance. data is unused
  */
 enum ipa_dp_evt_type {
 	IPA_RECEIVE,
 	IPA_WRITE_DONE,
+	IPA_CLIENT_START_POLL,
+	IPA_CLIENT_COMP_NAPI,
 };
 
 /**
@@ -500,6 +506,8 @@ struct ipa_ext_intf {
  * @skip_ep_cfg: boolean field that determines if EP should be configured
  *  by IPA driver
  * @keep_ipa_awake: when true, IPA will not be clock gated
+ * @napi_enabled: when true, a consumer pipe is drained by the client's NAPI
+ *  poll through ipa3_rx_poll() instead of the pipe workqueue
  */
 struct ipa_sys_connect_params {
 	struct ipa_ep_cfg ipa_ep_cfg;
@@ -509,12 +517,14 @@ struct ipa_sys_connect_params {
 	ipa_notify_cb notify;
 	bool skip_ep_cfg;
 	bool keep_ipa_awake;
+	bool napi_enabled;
 };
 
 /**
  * struct ipa_tx_meta - meta-data for the TX packet
  * @dma_address: dma mapped address of TX packet
  * @dma_address_valid: is above field valid?
+ * @xmit_more: more packets follow, HW notification may be deferred to them
  */
 struct ipa_tx_meta {
 	u8 pkt_init_dst_ep;
@@ -522,6 +532,7 @@ struct ipa_tx_meta {
 	bool pkt_init_dst_ep_remote;
 	dma_addr_t dma_address;
 	bool dma_address_valid;
+	bool xmit_more;
 };
 
 /**
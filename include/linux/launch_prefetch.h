@@ -0,0 +1,23 @@
+#ifndef __LINUX_LAUNCH_PREFETCH_H
+#define __LINUX_LAUNCH_PREFETCH_H
+
+#include <linux/fs.h>
+
+#ifdef CONFIG_LAUNCH_PREFETCH
+extern bool launch_prefetch_recording;
+extern void __launch_prefetch_record(struct file *file, pgoff_t start,
+				     unsigned long nr);
+
+/* Note a page cache miss on @nr pages of @file starting at @start */
+static inline void launch_prefetch_record(struct file *file, pgoff_t start,
+					  unsigned long nr)
+{
+	if (unlikely(ACCESS_ONCE(launch_prefetch_recording)))
+		__launch_prefetch_record(file, start, nr);
+}
+#else
+static inline void launch_prefetch_record(struct file *file, pgoff_t start,
+					  unsigned long nr) {}
+#endif
+
+#endif /* __LINUX_LAUNCH_PREFETCH_H */
@@ -170,6 +170,14 @@ static inline void mem_cgroup_count_vm_event(struct mm_struct *mm,
 		return;
 	__mem_cgroup_count_vm_event(mm, idx);
 }
+
+void __mem_cgroup_count_workingset(bool activate);
+static inline void mem_cgroup_count_workingset(bool activate)
+{
+	if (mem_cgroup_disabled())
+		return;
+	__mem_cgroup_count_workingset(activate);
+}
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 void mem_cgroup_split_huge_fixup(struct page *head);
 #endif
@@ -345,6 +353,10 @@ static inline
 void mem_cgroup_count_vm_event(struct mm_struct *mm, enum vm_event_item idx)
 {
 }
+
+static inline void mem_cgroup_count_workingset(bool activate)
+{
+}
 #endif /* CONFIG_MEMCG */
 
 #if !defined(CONFIG_MEMCG) || !defined(CONFIG_DEBUG_VM)
@@ -0,0 +1,16 @@
+#ifndef __LINUX_MEMSTALL_H
+#define __LINUX_MEMSTALL_H
+
+#ifdef CONFIG_MEMSTALL
+extern void memstall_enter(void);
+extern void memstall_leave(void);
+extern unsigned long memstall_avg10(void);
+extern unsigned long memstall_avg60(void);
+#else
+static inline void memstall_enter(void) {}
+static inline void memstall_leave(void) {}
+static inline unsigned long memstall_avg10(void) { return 0; }
+static inline unsigned long memstall_avg60(void) { return 0; }
+#endif
+
+#endif /* __LINUX_MEMSTALL_H */
@@ -2170,6 +2170,13 @@ static inline void setup_nr_node_ids(void) {}
 #endif
 
 #ifdef CONFIG_PROCESS_RECLAIM
+enum reclaim_type {
+	RECLAIM_FILE,
+	RECLAIM_ANON,
+	RECLAIM_ALL,
+	RECLAIM_RANGE,
+};
+
 struct reclaim_param {
 	struct vm_area_struct *vma;
 	/* Number of pages scanned */
@@ -2179,8 +2186,14 @@ struct reclaim_param {
 	/* pages reclaimed */
 	int nr_reclaimed;
 };
-extern struct reclaim_param reclaim_task_anon(struct task_struct *task,
-		int nr_to_reclaim);
+extern struct reclaim_param reclaim_task(struct task_struct *task,
+		enum reclaim_type type, int nr_to_reclaim);
+
+static inline struct reclaim_param reclaim_task_anon(struct task_struct *task,
+		int nr_to_reclaim)
+{
+	return reclaim_task(task, RECLAIM_ANON, nr_to_reclaim);
+}
 #endif
 
 #endif /* __KERNEL__ */
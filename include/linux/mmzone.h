@@ -206,6 +206,9 @@ enum zone_watermarks {
 #define low_wmark_pages(z) (z->watermark[WMARK_LOW])
 #define high_wmark_pages(z) (z->watermark[WMARK_HIGH])
 
+/* Highest order kept on the per-cpu lists */
+#define PCP_HORDER_MAX		3
+
 struct per_cpu_pages {
 	int count;		
 	int high;		
@@ -213,6 +216,14 @@ struct per_cpu_pages {
 
 	
 	struct list_head lists[MIGRATE_PCPTYPES];
+
+	/*
+	 * Free blocks of orders 1 to PCP_HORDER_MAX, so that kernel stacks,
+	 * skbs and driver chunks of these orders avoid zone->lock. Counts
+	 * are in blocks, limits derive from high and batch above.
+	 */
+	int horder_count[PCP_HORDER_MAX];
+	struct list_head horder_lists[PCP_HORDER_MAX][MIGRATE_PCPTYPES];
 };
 
 struct per_cpu_pageset {
@@ -463,6 +474,9 @@ struct node_active_region {
 extern struct page *mem_map;
 #endif
 
+/* Upper bound of the vm.kswapd_threads sysctl */
+#define MAX_KSWAPD_THREADS	8
+
 struct bootmem_data;
 typedef struct pglist_data {
 	struct zone node_zones[MAX_NR_ZONES];
@@ -489,6 +503,12 @@ typedef struct pglist_data {
 	struct task_struct *kswapd;	
 	int kswapd_max_order;
 	enum zone_type classzone_idx;
+	/* Extra reclaim threads that kswapd wakes when it falls behind */
+	struct task_struct *kswapd_helper[MAX_KSWAPD_THREADS - 1];
+	wait_queue_head_t kswapd_helper_wait;
+	atomic_t kswapd_helper_tickets;
+	atomic_t kswapd_helpers_running;
+	atomic_long_t kswapd_reclaimed;
 #ifdef CONFIG_NUMA_BALANCING
 	
 	spinlock_t numabalancing_migrate_lock;
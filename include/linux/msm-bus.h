@@ -64,6 +64,11 @@ struct msm_bus_scale_pdata {
 	 * of the CPU state.
 	 */
 	unsigned int active_only;
+	/*
+	 * Latency critical clients have their requests committed as they
+	 * are made instead of within the arbiter's commit window.
+	 */
+	unsigned int latency_critical;
 };
 
 struct msm_bus_client_handle {
@@ -77,6 +82,7 @@ struct msm_bus_client_handle {
 	u64 cur_slp_ib;
 	u64 cur_slp_ab;
 	bool active_only;
+	bool latency_critical;
 };
 
 /* Scaling APIs */
@@ -187,6 +187,9 @@ enum sps_option {
        /* EOT set after pipe SW offset advanced */
 	SPS_O_LATE_EOT   = 0x00080000,
 
+	/* Transfers are submitted from one context at a time, without lock */
+	SPS_O_SINGLE_PRODUCER = 0x00400000,
+
 	/* Options to enable software features */
 	/* Do not disable a pipe during disconnection */
 	SPS_O_NO_DISABLE      = 0x00800000,
@@ -1003,6 +1006,35 @@ int sps_register_event(struct sps_pipe *h, struct sps_register_event *reg);
 int sps_transfer_one(struct sps_pipe *h, phys_addr_t addr, u32 size,
 		     void *user, u32 flags);
 
+/**
+ * Submit several descriptors to an SPS connection end point
+ *
+ * This function queues @count descriptors on a BAM-to-System pipe and
+ * notifies the hardware once, after the last one. Each descriptor is
+ * cached with its own user pointer, so that the completions are reported
+ * one by one as with sps_transfer_one().
+ *
+ * Either all the descriptors are queued or none is, if there is not
+ * enough room in the descriptor FIFO.
+ *
+ * If the last descriptor has SPS_IOVEC_FLAG_NO_SUBMIT set, the hardware
+ * is not notified and the descriptors are picked up with the next
+ * transfer.
+ *
+ * @h - client context for SPS connection end point
+ *
+ * @iovec - descriptors to queue, see sps_transfer_one() for the flags
+ *
+ * @user - array of @count user pointers, or NULL
+ *
+ * @count - number of descriptors
+ *
+ * @return 0 on success, negative value on error
+ *
+ */
+int sps_transfer_batch(struct sps_pipe *h, struct sps_iovec *iovec,
+		       void **user, u32 count);
+
 /**
  * Read event queue for an SPS connection end point
  *
@@ -1492,6 +1524,12 @@ static inline int sps_transfer_one(struct sps_pipe *h, phys_addr_t addr,
 	return -EPERM;
 }
 
+static inline int sps_transfer_batch(struct sps_pipe *h,
+		struct sps_iovec *iovec, void **user, u32 count)
+{
+	return -EPERM;
+}
+
 static inline int sps_get_event(struct sps_pipe *h,
 				struct sps_event_notify *event)
 {
@@ -44,6 +44,12 @@ struct devfreq_msm_adreno_tz_data {
 		unsigned int *index;
 		uint64_t *ib;
 	} bus;
+	struct {
+		bool enable;
+		u64 total_time;
+		u64 busy_time;
+		u32 num;
+	} frame;
 	unsigned int device_id;
 	bool is_64;
 };
@@ -63,6 +69,8 @@ struct msm_busmon_extended_profile {
 	u32 flag;
 	unsigned long percent_ab;
 	unsigned long ab_mbytes;
+	bool coupled;
+	int gpu_mod;
 	struct devfreq_msm_adreno_tz_data *private_data;
 	struct devfreq_dev_profile profile;
 };
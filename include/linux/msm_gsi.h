@@ -661,6 +661,21 @@ int gsi_alloc_evt_ring(struct gsi_evt_ring_props *props, unsigned long dev_hdl,
 int gsi_write_evt_ring_scratch(unsigned long evt_ring_hdl,
 		union __packed gsi_evt_scratch val);
 
+/**
+ * gsi_config_evt_ring_mod - Peripheral should call this function to
+ * change the interrupt moderation of an event ring. This may be called
+ * from atomic context
+ *
+ * @evt_ring_hdl:  Client handle previously obtained from
+ *	   gsi_alloc_evt_ring
+ * @int_modt:      cycles base interrupt moderation (32KHz clock)
+ * @int_modc:      interrupt moderation packet counter
+ *
+ * @Return gsi_status
+ */
+int gsi_config_evt_ring_mod(unsigned long evt_ring_hdl, uint16_t int_modt,
+		uint8_t int_modc);
+
 /**
  * gsi_dealloc_evt_ring - Peripheral should call this function to
  * de-allocate an event ring. There should not exist any active
@@ -1045,6 +1060,12 @@ static inline int gsi_write_evt_ring_scratch(unsigned long evt_ring_hdl,
 	return -GSI_STATUS_UNSUPPORTED_OP;
 }
 
+static inline int gsi_config_evt_ring_mod(unsigned long evt_ring_hdl,
+		uint16_t int_modt, uint8_t int_modc)
+{
+	return -GSI_STATUS_UNSUPPORTED_OP;
+}
+
 static inline int gsi_dealloc_evt_ring(unsigned long evt_ring_hdl)
 {
 	return -GSI_STATUS_UNSUPPORTED_OP;
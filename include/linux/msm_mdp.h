@@ -33,4 +33,27 @@ int msm_fb_writeback_terminate(struct fb_info *info);
 int msm_fb_writeback_set_secure(struct fb_info *info, int enable);
 int msm_fb_writeback_iommu_ref(struct fb_info *info, int enable);
 
+/*
+ * Events on the primary display frame notifier chain. For
+ * MDSS_FB_FRAME_COMMITTED the data is a pointer to the u64 time in
+ * microseconds since the previous frame was committed.
+ */
+#define MDSS_FB_FRAME_COMMITTED	1
+#define MDSS_FB_FRAME_IDLE	2
+
+struct notifier_block;
+#if defined(CONFIG_FB_MSM_MDSS) || defined(CONFIG_FB_MSM_QPIC)
+int mdss_fb_register_frame_notifier(struct notifier_block *nb);
+int mdss_fb_unregister_frame_notifier(struct notifier_block *nb);
+#else
+static inline int mdss_fb_register_frame_notifier(struct notifier_block *nb)
+{
+	return -ENODEV;
+}
+static inline int mdss_fb_unregister_frame_notifier(struct notifier_block *nb)
+{
+	return -ENODEV;
+}
+#endif
+
 #endif /*_MSM_MDP_H_*/
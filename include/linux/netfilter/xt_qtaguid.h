@@ -10,4 +10,38 @@
 #define XT_QTAGUID_SOCKET XT_OWNER_SOCKET
 #define xt_qtaguid_match_info xt_owner_match_info
 
+#include <linux/types.h>
+
+/*
+ * Binary per-uid totals, summed over all interfaces, as laid out by
+ * /proc/net/xt_qtaguid/uid_stats (read() or mmap() it read-only).
+ *
+ * Entries with uid == QTAGUID_UID_STAT_FREE are unused. Each entry is a
+ * seqcount: a reader samples seq, retries while it is odd, copies the
+ * counters, and retries if seq changed meanwhile.
+ */
+#define QTAGUID_UID_TABLE_VERSION	1
+#define QTAGUID_UID_STAT_FREE		((__u32)-1)
+#define QTAGUID_UID_STAT_SETS		2
+
+struct qtaguid_uid_stat {
+	__u32 uid;
+	__u32 seq;
+	struct {
+		__u64 rx_bytes;
+		__u64 rx_packets;
+		__u64 tx_bytes;
+		__u64 tx_packets;
+	} set[QTAGUID_UID_STAT_SETS];
+};
+
+struct qtaguid_uid_table {
+	__u32 version;
+	__u32 nr_entries;
+	__u32 entry_size;
+	/* packets of uids that did not fit in the table */
+	__u32 overflows;
+	struct qtaguid_uid_stat entries[0];
+};
+
 #endif /* _XT_QTAGUID_MATCH_H */
@@ -573,6 +573,8 @@ struct dev_pm_info {
 	struct wakeup_source	*wakeup;
 	bool			wakeup_path:1;
 	bool			syscore:1;
+	ktime_t			resume_start;	/* Owned by the PM core */
+	ktime_t			resume_end;	/* Ditto */
 #else
 	unsigned int		should_wakeup:1;
 #endif
@@ -121,6 +121,8 @@ extern void get_iowait_load(unsigned long *nr_waiters, unsigned long *load);
 
 extern void sched_update_nr_prod(int cpu, long delta, bool inc);
 extern void sched_get_nr_running_avg(int *avg, int *iowait_avg, int *big_avg);
+extern void sched_get_nr_running_forecast(int *avg, int *iowait_avg,
+					  int *big_avg);
 
 extern void calc_global_load(unsigned long ticks);
 extern void update_cpu_load_nohz(void);
@@ -581,6 +583,14 @@ struct backing_dev_info;
 struct reclaim_state;
 
 #if defined(CONFIG_SCHEDSTATS) || defined(CONFIG_TASK_DELAY_ACCT)
+/*
+ * Runnable wait histogram buckets: bucket 0 counts waits shorter than
+ * 2^SCHED_WAIT_HIST_SHIFT ns and each following bucket doubles the bound.
+ * The last bucket collects everything longer.
+ */
+#define SCHED_WAIT_HIST_SHIFT	16
+#define SCHED_WAIT_HIST_BUCKETS	10
+
 struct sched_info {
 	
 	unsigned long pcount;	      
@@ -589,6 +599,8 @@ struct sched_info {
 	
 	unsigned long long last_arrival,
 			   last_queued;	
+
+	unsigned int wait_hist[SCHED_WAIT_HIST_BUCKETS];
 };
 #endif 
 
@@ -1004,6 +1016,7 @@ struct task_struct {
 #ifdef CONFIG_SCHED_HMP
 	struct ravg ravg;
 	u32 init_load_pct;
+	u32 freq_floor;
 	u64 last_wake_ts;
 	u64 last_switch_out_ts;
 #ifdef CONFIG_SCHED_QHMP
@@ -1553,6 +1566,7 @@ extern int task_free_unregister(struct notifier_block *n);
 struct sched_load {
 	unsigned long prev_load;
 	unsigned long new_task_load;
+	unsigned int min_freq;
 };
 
 #if defined(CONFIG_SCHED_FREQ_INPUT)
@@ -1762,6 +1776,14 @@ extern u32 sched_get_wake_up_idle(struct task_struct *p);
 extern int sched_set_group_id(struct task_struct *p, unsigned int group_id);
 extern unsigned int sched_get_group_id(struct task_struct *p);
 
+/* Boost types a sched_boost_vote() can request */
+#define SCHED_BOOST_PLACEMENT	0x1	/* place tasks on big cpus */
+#define SCHED_BOOST_FREQ	0x2	/* report busy cpus as fully loaded */
+#define SCHED_BOOST_MIGRATION	0x4	/* up-migrate at the down threshold */
+#define SCHED_BOOST_ALL		0x7
+
+#define SCHED_BOOST_NAME_LEN	16
+
 #ifdef CONFIG_SCHED_HMP
 
 extern int sched_set_boost(int enable);
@@ -1773,6 +1795,7 @@ extern int sched_set_static_cluster_pwr_cost(int cpu, unsigned int cost);
 extern unsigned int sched_get_static_cluster_pwr_cost(int cpu);
 extern int sched_set_cpu_budget(int cpu, int nr_run);
 extern int sched_get_cpu_budget(int cpu);
+extern unsigned long arch_get_cpu_efficiency(int cpu);
 #ifdef CONFIG_SCHED_QHMP
 extern int sched_set_cpu_prefer_idle(int cpu, int prefer_idle);
 extern int sched_get_cpu_prefer_idle(int cpu);
@@ -1783,6 +1806,31 @@ extern int sched_get_cpu_mostly_idle_nr_run(int cpu);
 extern int
 sched_set_cpu_mostly_idle_freq(int cpu, unsigned int mostly_idle_freq);
 extern unsigned int sched_get_cpu_mostly_idle_freq(int cpu);
+extern int sched_isolate_cpu(int cpu);
+extern int sched_unisolate_cpu(int cpu);
+extern int sched_boost_vote(const char *name, unsigned int type,
+			    unsigned int timeout_ms);
+extern int sched_boost_unvote(const char *name);
+extern int sched_set_freq_floor(struct task_struct *p, unsigned int freq);
+extern unsigned int sched_get_freq_floor(struct task_struct *p);
+#else
+static inline int sched_isolate_cpu(int cpu)
+{
+	return -ENOSYS;
+}
+static inline int sched_unisolate_cpu(int cpu)
+{
+	return -ENOSYS;
+}
+static inline int sched_boost_vote(const char *name, unsigned int type,
+				   unsigned int timeout_ms)
+{
+	return -ENOSYS;
+}
+static inline int sched_boost_unvote(const char *name)
+{
+	return -ENOSYS;
+}
 #endif
 
 #else
@@ -1790,6 +1838,23 @@ static inline int sched_set_boost(int enable)
 {
 	return -EINVAL;
 }
+static inline int sched_isolate_cpu(int cpu)
+{
+	return -ENOSYS;
+}
+static inline int sched_unisolate_cpu(int cpu)
+{
+	return -ENOSYS;
+}
+static inline int sched_boost_vote(const char *name, unsigned int type,
+				   unsigned int timeout_ms)
+{
+	return -EINVAL;
+}
+static inline int sched_boost_unvote(const char *name)
+{
+	return -EINVAL;
+}
 #endif
 
 #ifdef CONFIG_NO_HZ_COMMON
@@ -2518,11 +2583,21 @@ struct migration_notify_data {
 
 extern struct atomic_notifier_head load_alert_notifier_head;
 
+/* Reasons passed as the event value of load_alert_notifier_head */
+#define LOAD_ALERT_FREQ_CHANGE		0
+#define LOAD_ALERT_WINDOW_ROLLOVER	1
+
 extern long sched_setaffinity(pid_t pid, const struct cpumask *new_mask);
 extern long sched_getaffinity(pid_t pid, struct cpumask *mask);
 
 #ifdef CONFIG_CGROUP_SCHED
 extern struct task_group root_task_group;
+extern bool sched_memlat_background(struct task_struct *p);
+#else
+static inline bool sched_memlat_background(struct task_struct *p)
+{
+	return false;
+}
 #endif 
 
 extern int task_can_switch_user(struct user_struct *up,
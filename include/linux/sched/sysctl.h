@@ -51,13 +51,13 @@ extern int sysctl_sched_upmigrate_min_nice;
 extern unsigned int sysctl_sched_boost;
 
 extern unsigned int sysctl_early_detection_duration;
+extern unsigned int sysctl_sched_enable_colocation;
 
 #ifdef CONFIG_SCHED_QHMP
 extern unsigned int sysctl_sched_min_runtime;
 extern unsigned int sysctl_sched_small_task_pct;
 #else
 extern unsigned int sysctl_sched_select_prev_cpu_us;
-extern unsigned int sysctl_sched_enable_colocation;
 extern unsigned int sysctl_sched_restrict_cluster_spill;
 #if defined(CONFIG_SCHED_FREQ_INPUT)
 extern unsigned int sysctl_sched_new_task_windows;
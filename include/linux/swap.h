@@ -169,6 +169,10 @@ struct swap_info_struct {
 	struct work_struct discard_work; 
 	struct swap_cluster_info discard_cluster_head; 
 	struct swap_cluster_info discard_cluster_tail; 
+	/* readahead window state, see swapin_nr_pages() */
+	atomic_t ra_hits;		/* readahead pages found in use */
+	atomic_t ra_last_pages;		/* size of the previous window */
+	unsigned long ra_prev_offset;	/* offset of the last fault */
 };
 
 void *workingset_eviction(struct address_space *mapping, struct page *page);
@@ -268,6 +272,9 @@ extern void check_move_unevictable_pages(struct page **, int nr_pages);
 
 extern int kswapd_run(int nid);
 extern void kswapd_stop(int nid);
+extern int kswapd_threads;
+extern int kswapd_threads_sysctl_handler(struct ctl_table *table, int write,
+			void __user *buffer, size_t *length, loff_t *ppos);
 #ifdef CONFIG_MEMCG
 extern int mem_cgroup_swappiness(struct mem_cgroup *mem);
 #else
@@ -321,6 +328,7 @@ extern struct page *swapin_readahead(swp_entry_t, gfp_t,
 extern atomic_long_t nr_swap_pages;
 extern long total_swap_pages;
 extern bool is_swap_fast(swp_entry_t entry);
+extern struct swap_info_struct *swp_swap_info(swp_entry_t entry);
 
 static inline bool vm_swap_full(struct swap_info_struct *si)
 {
@@ -73,6 +73,7 @@ struct sync_timeline {
 
 	
 	bool			destroyed;
+	bool			ordered;
 
 	struct list_head	child_list_head;
 	spinlock_t		child_list_lock;
@@ -109,7 +110,8 @@ struct sync_fence {
 
 	struct list_head	waiter_list_head;
 	spinlock_t		waiter_list_lock; 
-	int			status;
+	/* cached fence state, 0:active 1:signaled <0:error, set once */
+	atomic_t		status;
 
 	wait_queue_head_t	wq;
 
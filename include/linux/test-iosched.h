@@ -29,6 +29,7 @@
 #define TEST_NO_PATTERN		0xDEADBEEF
 #define BIO_U32_SIZE 1024
 #define TEST_BIO_SIZE		PAGE_SIZE	/* use one page bios */
+#define TEST_IOPS_QD_STEPS	7	/* depths run by the IOPS sweep */
 
 struct test_iosched;
 
@@ -82,6 +83,9 @@ enum req_unique_type {
  * @start_sector:	The start sector for read/write requests
  * @sector_range:	Range of the test, starting from start_sector
  *			(in sectors)
+ * @queue_depth:	Limits the test requests in flight, 0 for no limit
+ * @iops_benchmark:	Runs the queued versus serial IOPS benchmark
+ * @iops_qd_sweep:	Runs the IOPS benchmark once per queue depth
  */
 struct test_debug {
 	struct dentry *debug_root;
@@ -90,6 +94,9 @@ struct test_debug {
 	struct dentry *debug_test_result;
 	struct dentry *start_sector;
 	struct dentry *sector_range;
+	struct dentry *queue_depth;
+	struct dentry *iops_benchmark;
+	struct dentry *iops_qd_sweep;
 };
 
 /**
@@ -213,6 +220,10 @@ struct blk_dev_test_type {
  *			flush request, therefore disqualifying
  *			the results
  * @blk_dev_test_data:	associated specific block device test utility
+ * @queue_depth:	Maximum number of test requests dispatched and not yet
+ *			completed, 0 for no limit
+ * @iops:		Result of the last IOPS benchmark, queued and serial
+ * @qd_iops:		Result of the last queue depth sweep, one per depth
  */
 struct test_iosched {
 	struct list_head queue;
@@ -240,6 +251,9 @@ struct test_iosched {
 	bool ignore_round;
 	bool notified_urgent;
 	void *blk_dev_test_data;
+	u32 queue_depth;
+	unsigned long iops[2];
+	unsigned long qd_iops[TEST_IOPS_QD_STEPS];
 };
 
 extern int test_iosched_start_test(struct test_iosched *,
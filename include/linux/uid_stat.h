@@ -21,9 +21,11 @@
 #ifdef CONFIG_UID_STAT
 int uid_stat_tcp_snd(uid_t uid, int size);
 int uid_stat_tcp_rcv(uid_t uid, int size);
+int uid_stat_workingset(uid_t uid, bool activate);
 #else
 #define uid_stat_tcp_snd(uid, size) do {} while (0);
 #define uid_stat_tcp_rcv(uid, size) do {} while (0);
+#define uid_stat_workingset(uid, activate) do {} while (0);
 #endif
 
 #endif /* _LINUX_UID_STAT_H */
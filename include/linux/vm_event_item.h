@@ -52,6 +52,7 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		COMPACTMIGRATE_SCANNED, COMPACTFREE_SCANNED,
 		COMPACTISOLATED,
 		COMPACTSTALL, COMPACTFAIL, COMPACTSUCCESS,
+		COMPACTPROACTIVE,
 #endif
 #ifdef CONFIG_HUGETLB_PAGE
 		HTLB_BUDDY_PGALLOC, HTLB_BUDDY_PGALLOC_FAIL,
@@ -96,6 +97,11 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		ALLOCSTALL_500,
 		ALLOCSTALL_1000,
 		ALLOCSTALL_HORDER,
+		PGALLOC_ORDER_1, PGALLOC_ORDER_2, PGALLOC_ORDER_3,
+		PGALLOC_ORDER_4, PGALLOC_ORDER_HIGH,
+		PGALLOC_ORDER_1_FAIL, PGALLOC_ORDER_2_FAIL,
+		PGALLOC_ORDER_3_FAIL, PGALLOC_ORDER_4_FAIL,
+		PGALLOC_ORDER_HIGH_FAIL,
 #ifdef CONFIG_COMPACTION
 		COMPACTSTALL_100,
 		COMPACTSTALL_250,
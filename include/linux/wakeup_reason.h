@@ -18,10 +18,27 @@
 #ifndef _LINUX_WAKEUP_REASON_H
 #define _LINUX_WAKEUP_REASON_H
 
+#include <linux/types.h>
+
 #define MAX_SUSPEND_ABORT_LEN 256
 
+/* Points of a suspend cycle timed in /sys/kernel/wakeup_reasons */
+enum suspend_phase {
+	SUSPEND_PHASE_FREEZE,		/* freezing tasks */
+	SUSPEND_PHASE_DEV_SUSPEND,	/* dpm_suspend_start() */
+	SUSPEND_PHASE_LATE_SUSPEND,	/* late, noirq, cpus off */
+	SUSPEND_PHASE_SYSCORE_SUSPEND,	/* syscore and firmware entry */
+	SUSPEND_PHASE_SYSCORE_RESUME,	/* cpus on, noirq, early */
+	SUSPEND_PHASE_DEV_RESUME,	/* dpm_resume_end() */
+	SUSPEND_PHASE_THAW,		/* thawing tasks */
+	SUSPEND_PHASE_END,
+	SUSPEND_PHASE_MAX,
+};
+
 void log_wakeup_reason(int irq);
 void log_suspend_abort_reason(const char *fmt, ...);
 int check_wakeup_reason(int irq);
+void log_suspend_phase(enum suspend_phase phase);
+void log_suspend_slowest_dev(bool resume, const char *name, s64 usecs);
 
 #endif /* _LINUX_WAKEUP_REASON_H */
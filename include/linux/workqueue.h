@@ -313,6 +313,15 @@ enum {
 	 */
 	WQ_POWER_EFFICIENT	= 1 << 7,
 
+	/*
+	 * Unbound workqueues are kept on the CPUs in
+	 * /sys/devices/virtual/workqueue/cpumask, the little cluster in
+	 * power efficient mode.  Queues on a latency critical path, such
+	 * as display commit or GPU dispatch, are marked with this flag to
+	 * be allowed on every CPU.
+	 */
+	WQ_LATENCY_SENSITIVE	= 1 << 8,
+
 	__WQ_DRAINING		= 1 << 16, /* internal: workqueue is draining */
 	__WQ_ORDERED		= 1 << 17, /* internal: workqueue is ordered */
 
@@ -428,6 +437,7 @@ struct workqueue_attrs *alloc_workqueue_attrs(gfp_t gfp_mask);
 void free_workqueue_attrs(struct workqueue_attrs *attrs);
 int apply_workqueue_attrs(struct workqueue_struct *wq,
 			  const struct workqueue_attrs *attrs);
+int workqueue_set_unbound_cpumask(cpumask_var_t cpumask);
 
 extern bool queue_work_on(int cpu, struct workqueue_struct *wq,
 			struct work_struct *work);
@@ -497,6 +497,24 @@ struct msm_isp_buf_request {
 	enum msm_isp_buf_type buf_type;
 };
 
+/*
+ * Keep the buffers of the queue mapped when they are dequeued. A buffer
+ * enqueued again with the same fds is handed to the hardware without any
+ * smmu operation, the mappings are dropped when the queue is released.
+ * Userspace must not reuse the fds for other buffers while the queue exists.
+ */
+#define ISP_BUF_REQ_FLAG_PERSISTENT_MAP 0x1
+
+struct msm_isp_buf_request_ver2 {
+	uint32_t session_id;
+	uint32_t stream_id;
+	uint8_t num_buf;
+	uint32_t handle;
+	enum msm_isp_buf_type buf_type;
+	uint32_t flags;
+	uint32_t reserved[4];
+};
+
 struct msm_isp_qbuf_plane {
 	uint32_t addr;
 	uint32_t offset;
@@ -846,4 +864,7 @@ struct msm_isp_event_data32 {
 #define VIDIOC_MSM_ISP_UNMAP_BUF \
 	_IOWR('V', BASE_VIDIOC_PRIVATE+24, struct msm_isp_unmap_buf_req)
 
+#define VIDIOC_MSM_ISP_REQUEST_BUF_VER2 \
+	_IOWR('V', BASE_VIDIOC_PRIVATE+25, struct msm_isp_buf_request_ver2)
+
 #endif 
@@ -10,8 +10,24 @@
  * GNU General Public License for more details.
  */
 
+#ifndef __SOC_QCOM_BOOT_STATS_H
+#define __SOC_QCOM_BOOT_STATS_H
+
+#include <linux/init.h>
+#include <linux/ktime.h>
+#include <linux/msm_boot_stats.h>
+
 #ifdef CONFIG_MSM_BOOT_STATS
 int boot_stats_init(void);
+void boot_stats_marker(const char *name);
+__printf(2, 3) void boot_stats_event(ktime_t start, const char *fmt, ...);
+void boot_stats_initcall(initcall_t fn, ktime_t start);
 #else
 static inline int boot_stats_init(void) { return 0; }
+static inline void boot_stats_marker(const char *name) { }
+static inline __printf(2, 3)
+void boot_stats_event(ktime_t start, const char *fmt, ...) { }
+static inline void boot_stats_initcall(initcall_t fn, ktime_t start) { }
+#endif
+
 #endif
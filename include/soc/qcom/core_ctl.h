@@ -22,5 +22,7 @@ extern void core_ctl_put_policy(struct cpufreq_policy *policy);
 extern struct device *core_ctl_find_cpu_device(unsigned cpu);
 extern int core_ctl_online_core(unsigned int cpu);
 extern int core_ctl_offline_core(unsigned int cpu);
+extern int core_ctl_isolate_core(unsigned int cpu);
+extern int core_ctl_unisolate_core(unsigned int cpu);
 
 #endif
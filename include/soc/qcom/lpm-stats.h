@@ -26,6 +26,8 @@ void lpm_stats_cluster_exit(struct lpm_stats *stats, uint32_t index,
 				bool success);
 void lpm_stats_cpu_enter(uint32_t index);
 void lpm_stats_cpu_exit(uint32_t index, bool success);
+void lpm_stats_cluster_mispredict(struct lpm_stats *stats, uint32_t index);
+void lpm_stats_cpu_mispredict(uint32_t index);
 void lpm_stats_suspend_enter(void);
 void lpm_stats_suspend_exit(void);
 #else
@@ -58,6 +60,17 @@ static inline void lpm_stats_cpu_exit(uint32_t index, bool success)
 	return;
 }
 
+static inline void lpm_stats_cluster_mispredict(struct lpm_stats *stats,
+						uint32_t index)
+{
+	return;
+}
+
+static inline void lpm_stats_cpu_mispredict(uint32_t index)
+{
+	return;
+}
+
 static inline void lpm_stats_suspend_enter(void)
 {
 	return;
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef __ARCH_ARM_MACH_MSM_LPM_SYNC_H
+#define __ARCH_ARM_MACH_MSM_LPM_SYNC_H
+
+/*
+ * Periodic interrupt sources the idle code aligns cluster sleep with.
+ * Drivers report each occurrence with lpm_sync_event().
+ */
+enum lpm_sync_source {
+	LPM_SYNC_DISPLAY,
+	LPM_SYNC_VIDEO,
+	LPM_SYNC_NR,
+};
+
+#ifdef CONFIG_MSM_PM
+void lpm_sync_event(enum lpm_sync_source src);
+#else
+static inline void lpm_sync_event(enum lpm_sync_source src) {}
+#endif
+
+#endif /* __ARCH_ARM_MACH_MSM_LPM_SYNC_H */
@@ -70,6 +70,9 @@ struct qmi_handle {
 	int handle_reset;
 	wait_queue_head_t reset_waitq;
 	struct delayed_work ctl_work;
+	struct work_struct rx_notify_work;
+	struct delayed_work txn_timeout_work;
+	unsigned long txn_timeout;
 
 	/* Client specific elements */
 	void *dest_info;
@@ -231,6 +234,39 @@ int qmi_send_req_nowait(struct qmi_handle *handle,
 					int stat),
 			void *resp_cb_data);
 
+/**
+ * qmi_send_req_nowait_timeout() - Send an asynchronous QMI request
+ * @handle: QMI handle through which the QMI request is sent.
+ * @request_desc: Structure describing the request data structure.
+ * @req: Buffer containing the request data structure.
+ * @req_len: Length of the request data structure.
+ * @resp_desc: Structure describing the response data structure.
+ * @resp: Buffer to hold the response data structure.
+ * @resp_len: Length of the response data structure.
+ * @resp_cb: Callback function to be invoked when the response arrives.
+ * @resp_cb_data: Private information to be passed along with the callback.
+ * @timeout_ms: Timeout before a response is received, 0 for none.
+ *
+ * @return: 0 on success, < 0 on error.
+ *
+ * Like qmi_send_req_nowait(), except that @resp_cb is called with a stat
+ * of -ETIMEDOUT if no response arrives within @timeout_ms. Any number of
+ * requests may be in flight on a handle; @resp_cb is called exactly once
+ * for each of them, with a negative stat on timeout, decode failure or
+ * handle reset.
+ */
+int qmi_send_req_nowait_timeout(struct qmi_handle *handle,
+			struct msg_desc *req_desc,
+			void *req, unsigned int req_len,
+			struct msg_desc *resp_desc,
+			void *resp, unsigned int resp_len,
+			void (*resp_cb)(struct qmi_handle *handle,
+					unsigned int msg_id, void *msg,
+					void *resp_cb_data,
+					int stat),
+			void *resp_cb_data,
+			unsigned long timeout_ms);
+
 /**
  * qmi_recv_msg() - Receive the QMI message
  * @handle: Handle for which the QMI message has to be received.
@@ -239,6 +275,19 @@ int qmi_send_req_nowait(struct qmi_handle *handle,
  */
 int qmi_recv_msg(struct qmi_handle *handle);
 
+/**
+ * qmi_recv_msgs() - Receive a burst of QMI messages
+ * @handle: Handle for which the QMI messages have to be received.
+ * @budget: Maximum number of messages to receive, 0 for no limit.
+ *
+ * @return: number of messages received on success, < 0 on error.
+ *
+ * Drains the messages pending on the handle in one go, taking the handle
+ * lock once for the whole burst. Meant to be called from the QMI_RECV_MSG
+ * notification in place of a qmi_recv_msg() loop.
+ */
+int qmi_recv_msgs(struct qmi_handle *handle, unsigned int budget);
+
 /**
  * qmi_connect_to_service() - Connect the QMI handle with a QMI service
  * @handle: QMI handle to be connected with the QMI service.
@@ -412,17 +461,37 @@ static inline int qmi_send_req_nowait(struct qmi_handle *handle,
 				void *resp, unsigned int resp_len,
 				void (*resp_cb)(struct qmi_handle *handle,
 						unsigned int msg_id, void *msg,
-						void *resp_cb_data),
+						void *resp_cb_data, int stat),
 				void *resp_cb_data)
 {
 	return -ENODEV;
 }
 
+static inline int qmi_send_req_nowait_timeout(struct qmi_handle *handle,
+				struct msg_desc *req_desc,
+				void *req, unsigned int req_len,
+				struct msg_desc *resp_desc,
+				void *resp, unsigned int resp_len,
+				void (*resp_cb)(struct qmi_handle *handle,
+						unsigned int msg_id, void *msg,
+						void *resp_cb_data, int stat),
+				void *resp_cb_data,
+				unsigned long timeout_ms)
+{
+	return -ENODEV;
+}
+
 static inline int qmi_recv_msg(struct qmi_handle *handle)
 {
 	return -ENODEV;
 }
 
+static inline int qmi_recv_msgs(struct qmi_handle *handle,
+				unsigned int budget)
+{
+	return -ENODEV;
+}
+
 static inline int qmi_connect_to_service(struct qmi_handle *handle,
 					 uint32_t service_id,
 					 uint32_t service_vers,
@@ -25,6 +25,7 @@ enum msm_rpm_set {
 };
 
 struct msm_rpm_request;
+struct seq_file;
 
 struct msm_rpm_kvp {
 	uint32_t key;
@@ -222,6 +223,17 @@ int msm_rpm_send_message_noirq(enum msm_rpm_set set, uint32_t rsc_type,
  */
 int __init msm_rpm_driver_init(void);
 
+/**
+ * msm_rpm_show_stats() - Print the number of requests made and messages
+ * sent for each resource and set since the stats were last reset.
+ */
+void msm_rpm_show_stats(struct seq_file *m);
+
+/**
+ * msm_rpm_reset_stats() - Clear the per resource request stats.
+ */
+void msm_rpm_reset_stats(void);
+
 #else
 
 static inline struct msm_rpm_request *msm_rpm_create_request(
@@ -305,5 +317,13 @@ static inline int __init msm_rpm_driver_init(void)
 {
 	return 0;
 }
+
+static inline void msm_rpm_show_stats(struct seq_file *m)
+{
+}
+
+static inline void msm_rpm_reset_stats(void)
+{
+}
 #endif
 #endif /*__ARCH_ARM_MACH_MSM_RPM_SMD_H*/
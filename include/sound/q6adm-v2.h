@@ -134,6 +134,9 @@ int adm_set_softvolume(int port_id, int copp_idx,
 
 int adm_param_enable(int port_id, int copp_idx, int module_id,  int enable);
 
+int adm_param_enable_multi(int port_id, int copp_idx, int *module_ids,
+			   int num_modules, int enable);
+
 int adm_send_calibration(int port_id, int copp_idx, int path, int perf_mode,
 			 int cal_type, char *params, int size);
 
@@ -13,6 +13,10 @@
 #ifndef _Q6_AUDIO_H_
 #define _Q6_AUDIO_H_
 
+#include <linux/ktime.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
 #include <linux/qdsp6v2/apr.h>
 
 enum {
@@ -33,4 +37,40 @@ int q6audio_is_digital_pcm_interface(u16 port_id);
 
 int q6audio_get_port_id(u16 port_id);
 
+/*
+ * Histogram of DSP command round trip times. Bucket n counts the samples
+ * below 2^n ms, the last bucket everything above. Commands that timed out
+ * are only counted in timeouts.
+ */
+#define Q6AUDIO_LATENCY_BUCKETS 12
+
+struct q6audio_latency_hist {
+	spinlock_t lock;
+	u32 buckets[Q6AUDIO_LATENCY_BUCKETS];
+	u32 count;
+	u32 timeouts;
+	u64 total_us;
+	u32 max_us;
+};
+
+void q6audio_latency_hist_init(struct q6audio_latency_hist *hist);
+
+void q6audio_latency_hist_reset(struct q6audio_latency_hist *hist);
+
+void q6audio_latency_hist_add(struct q6audio_latency_hist *hist, s64 us);
+
+void q6audio_latency_hist_show(struct seq_file *m, const char *name,
+			       struct q6audio_latency_hist *hist);
+
+/* wait_event_timeout() that records how long the DSP took to answer */
+#define q6audio_wait_event_timeout(hist, wq, condition, timeout)	\
+({									\
+	ktime_t __start = ktime_get();					\
+	long __ret = wait_event_timeout(wq, condition, timeout);	\
+									\
+	q6audio_latency_hist_add(hist, __ret ?				\
+		ktime_us_delta(ktime_get(), __start) : -1);		\
+	__ret;								\
+})
+
 #endif
@@ -602,6 +602,86 @@ DEFINE_EVENT(smmu_map, iommu_map_range,
 	TP_ARGS(va, pa, chunk_size, len)
 	);
 
+TRACE_EVENT(ion_system_heap_page,
+
+	TP_PROTO(unsigned int order,
+		 bool from_pool,
+		 bool cached),
+
+	TP_ARGS(order, from_pool, cached),
+
+	TP_STRUCT__entry(
+		__field(unsigned int,	order)
+		__field(bool,		from_pool)
+		__field(bool,		cached)
+	),
+
+	TP_fast_assign(
+		__entry->order		= order;
+		__entry->from_pool	= from_pool;
+		__entry->cached		= cached;
+	),
+
+	TP_printk("order=%u from_pool=%d cached=%d",
+		__entry->order,
+		__entry->from_pool,
+		__entry->cached)
+);
+
+DECLARE_EVENT_CLASS(ion_heap_phase,
+
+	TP_PROTO(const char *heap_name,
+		 size_t len),
+
+	TP_ARGS(heap_name, len),
+
+	TP_STRUCT__entry(
+		__field(const char *,	heap_name)
+		__field(size_t,		len)
+	),
+
+	TP_fast_assign(
+		__entry->heap_name	= heap_name;
+		__entry->len		= len;
+	),
+
+	TP_printk("heap_name=%s len=%zu",
+		__entry->heap_name,
+		__entry->len)
+);
+
+DEFINE_EVENT(ion_heap_phase, ion_heap_zero_start,
+
+	TP_PROTO(const char *heap_name,
+		 size_t len),
+
+	TP_ARGS(heap_name, len)
+);
+
+DEFINE_EVENT(ion_heap_phase, ion_heap_zero_end,
+
+	TP_PROTO(const char *heap_name,
+		 size_t len),
+
+	TP_ARGS(heap_name, len)
+);
+
+DEFINE_EVENT(ion_heap_phase, ion_heap_sg_build_start,
+
+	TP_PROTO(const char *heap_name,
+		 size_t len),
+
+	TP_ARGS(heap_name, len)
+);
+
+DEFINE_EVENT(ion_heap_phase, ion_heap_sg_build_end,
+
+	TP_PROTO(const char *heap_name,
+		 size_t len),
+
+	TP_ARGS(heap_name, len)
+);
+
 DECLARE_EVENT_CLASS(ion_secure_cma_add_to_pool,
 
 	TP_PROTO(unsigned long len,
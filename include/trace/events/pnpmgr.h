@@ -0,0 +1,47 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM pnpmgr
+
+#if !defined(_TRACE_PNPMGR_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_PNPMGR_H
+
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(pnpmgr_policy,
+	TP_PROTO(int level, int batt_level, int charging, int batt_temp,
+		 int app_class, unsigned int bc_max, unsigned int lc_max,
+		 unsigned int gpu_max, unsigned int bus_max),
+	TP_ARGS(level, batt_level, charging, batt_temp, app_class,
+		bc_max, lc_max, gpu_max, bus_max),
+	TP_STRUCT__entry(
+		__field(int,		level		)
+		__field(int,		batt_level	)
+		__field(int,		charging	)
+		__field(int,		batt_temp	)
+		__field(int,		app_class	)
+		__field(unsigned int,	bc_max		)
+		__field(unsigned int,	lc_max		)
+		__field(unsigned int,	gpu_max		)
+		__field(unsigned int,	bus_max		)
+	),
+	TP_fast_assign(
+		__entry->level = level;
+		__entry->batt_level = batt_level;
+		__entry->charging = charging;
+		__entry->batt_temp = batt_temp;
+		__entry->app_class = app_class;
+		__entry->bc_max = bc_max;
+		__entry->lc_max = lc_max;
+		__entry->gpu_max = gpu_max;
+		__entry->bus_max = bus_max;
+	),
+
+	TP_printk("level=%d batt=%d%% charging=%d batt_temp=%d app=%d bc_max=%u lc_max=%u gpu_max=%u bus_max=%u",
+		__entry->level, __entry->batt_level, __entry->charging,
+		__entry->batt_temp, __entry->app_class, __entry->bc_max,
+		__entry->lc_max, __entry->gpu_max, __entry->bus_max)
+);
+
+#endif /* _TRACE_PNPMGR_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
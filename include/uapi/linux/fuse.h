@@ -251,6 +251,7 @@ struct fuse_file_lock {
 #define FUSE_WRITEBACK_CACHE	(1 << 16)
 #define FUSE_NO_OPEN_SUPPORT	(1 << 17)
 
+#define FUSE_SHORTCIRCUIT_DIR	(1 << 30)
 #define FUSE_SHORTCIRCUIT	(1 << 31)
 
 /**
@@ -54,6 +54,13 @@ struct input_keymap_entry {
 	__u8  scancode[32];
 };
 
+struct input_batch {
+#define INPUT_BATCH_LOW_LATENCY	(1 << 0)
+	__u32 flags;
+	__u32 max_latency_ms;
+	__u32 max_events;
+};
+
 #define EVIOCGVERSION		_IOR('E', 0x01, int)			
 #define EVIOCGID		_IOR('E', 0x02, struct input_id)	
 #define EVIOCGREP		_IOR('E', 0x03, unsigned int[2])	
@@ -92,6 +99,8 @@ struct input_keymap_entry {
 #define EVIOCSSUSPENDBLOCK	_IOW('E', 0x91, int)			
 
 #define EVIOCSCLOCKID		_IOW('E', 0xa0, int)			
+#define EVIOCGBATCH		_IOR('E', 0xa1, struct input_batch)
+#define EVIOCSBATCH		_IOW('E', 0xa1, struct input_batch)
 
 
 #define INPUT_PROP_POINTER		0x00	
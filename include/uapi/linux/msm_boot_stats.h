@@ -0,0 +1,17 @@
+#ifndef _UAPI_MSM_BOOT_STATS_H
+#define _UAPI_MSM_BOOT_STATS_H
+
+#include <linux/ioctl.h>
+
+#define BOOT_STATS_MARKER_LEN	32
+
+/* Boot timeline marker from userspace, e.g. system_server start */
+struct boot_stats_marker {
+	char name[BOOT_STATS_MARKER_LEN];
+};
+
+#define BOOT_STATS_IOCTL_MAGIC	0xB5
+#define BOOT_STATS_IOCTL_MARKER	_IOW(BOOT_STATS_IOCTL_MAGIC, 1, \
+				     struct boot_stats_marker)
+
+#endif
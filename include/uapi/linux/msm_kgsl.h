@@ -108,6 +108,7 @@
 /* Flags for GPU command sync points */
 #define KGSL_CMD_SYNCPOINT_TYPE_TIMESTAMP 0
 #define KGSL_CMD_SYNCPOINT_TYPE_FENCE 1
+#define KGSL_CMD_SYNCPOINT_TYPE_DEADLINE 2
 
 /* --- Memory allocation flags --- */
 
@@ -1013,6 +1014,18 @@ struct kgsl_cmd_syncpoint_fence {
 	int fd;
 };
 
+/*
+ * struct kgsl_cmd_syncpoint_deadline
+ * @deadline_ns: CLOCK_MONOTONIC time in nanoseconds by which the command
+ * should be retired (typically derived from the next vsync)
+ *
+ * This is not a dependency - it never blocks the command. It is a hint for
+ * the dispatcher to prefer contexts with the earliest pending deadline.
+ */
+struct kgsl_cmd_syncpoint_deadline {
+	uint64_t deadline_ns;
+};
+
 /**
  * struct kgsl_cmd_syncpoint - Define a sync point for a command batch
  * @type: type of sync point defined here
@@ -88,6 +88,13 @@ VALIDATE/COMMIT FLAG CONFIGURATION
  */
 #define MDP_COMMIT_SYNC_FENCE_WAIT		0x04
 
+/*
+ * This flag is only valid for commit call. Driver computes left_roi and
+ * right_roi from the damage_rect of the input layers, aligned to what the
+ * panel supports, instead of using the values provided by the client.
+ */
+#define MDP_COMMIT_PARTIAL_UPDATE_DAMAGE	0x08
+
 #define MDP_COMMIT_VERSION_1_0		0x00010000
 
 /**********************************************************************
@@ -262,8 +269,17 @@ struct mdp_input_layer {
 	 */
 	int			error_code;
 
+	/*
+	 * Damage_rect is optional configuration, used only when the
+	 * MDP_COMMIT_PARTIAL_UPDATE_DAMAGE flag is set in the commit call.
+	 * It is the part of dst_rect that changed since the previous commit,
+	 * in display coordinates. An empty rectangle means the layer did not
+	 * change.
+	 */
+	struct mdp_rect		damage_rect;
+
 	/* 32bits reserved value for future usage. */
-	uint32_t		reserved[6];
+	uint32_t		reserved[2];
 };
 
 struct mdp_output_layer {
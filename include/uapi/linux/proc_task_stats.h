@@ -0,0 +1,33 @@
+#ifndef _UAPI_PROC_TASK_STATS_H
+#define _UAPI_PROC_TASK_STATS_H
+
+#include <linux/types.h>
+
+#define PROC_TASK_STAT_COMM_LEN	16
+
+/*
+ * One record per process in /proc/task_stats, read() as an array.
+ * Times are in nanoseconds, vsize in bytes, rss and shared in pages.
+ * state is the letter shown in /proc/<pid>/stat.
+ */
+struct proc_task_stat {
+	__s32	pid;
+	__s32	ppid;
+	__u32	uid;
+	__s16	oom_score_adj;
+	__s8	nice;
+	__u8	state;
+	__u32	num_threads;
+	__u32	reserved;
+	__u64	utime;
+	__u64	stime;
+	__u64	start_time;
+	__u64	min_flt;
+	__u64	maj_flt;
+	__u64	vsize;
+	__u64	rss;
+	__u64	shared;
+	char	comm[PROC_TASK_STAT_COMM_LEN];
+};
+
+#endif
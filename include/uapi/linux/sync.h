@@ -62,6 +62,20 @@ struct sync_fence_info_data {
 	__u8	pt_info[0];
 };
 
+/**
+ * struct sync_wait_multi_data - data passed to the multi-fence wait ioctl
+ * @fds:	pointer to an array of __s32 fence fds
+ * @count:	number of fds in the array, at most SYNC_WAIT_MULTI_MAX
+ * @timeout:	timeout for the whole set in milliseconds, < 0 waits forever
+ */
+struct sync_wait_multi_data {
+	__u64	fds;
+	__u32	count;
+	__s32	timeout;
+};
+
+#define SYNC_WAIT_MULTI_MAX	64
+
 #define SYNC_IOC_MAGIC		'>'
 
 /**
@@ -94,4 +108,14 @@ struct sync_fence_info_data {
 #define SYNC_IOC_FENCE_INFO	_IOWR(SYNC_IOC_MAGIC, 2,\
 	struct sync_fence_info_data)
 
+/**
+ * DOC: SYNC_IOC_WAIT_MULTI - wait for several fences to signal
+ *
+ * Takes a struct sync_wait_multi_data and may be issued on any fence fd.
+ * Returns 0 once every fence in the array has signaled, or the error of
+ * the first fence that failed or timed out.
+ */
+#define SYNC_IOC_WAIT_MULTI	_IOW(SYNC_IOC_MAGIC, 3,\
+	struct sync_wait_multi_data)
+
 #endif /* _UAPI_LINUX_SYNC_H */
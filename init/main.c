@@ -93,6 +93,10 @@
 #include <linux/msm_rtb.h>
 #endif
 
+#ifdef CONFIG_MSM_BOOT_STATS
+#include <soc/qcom/boot_stats.h>
+#endif
+
 static int kernel_init(void *);
 
 extern void init_IRQ(void);
@@ -707,6 +711,9 @@ int __init_or_module do_one_initcall(initcall_t fn)
 	int count = preempt_count();
 	int ret;
 	char msgbuf[64];
+#ifdef CONFIG_MSM_BOOT_STATS
+	ktime_t start = ktime_get();
+#endif
 
 	if (initcall_blacklisted(fn))
 		return -EPERM;
@@ -721,6 +728,9 @@ int __init_or_module do_one_initcall(initcall_t fn)
 #ifdef CONFIG_HTC_EARLY_RTB
 	uncached_logk_pc(LOGK_INITCALL, (void *)fn, (void *)(0xffffffff));
 #endif
+#ifdef CONFIG_MSM_BOOT_STATS
+	boot_stats_initcall(fn, start);
+#endif
 
 	msgbuf[0] = 0;
 
@@ -775,6 +785,9 @@ static char *initcall_level_names[] __initdata = {
 static void __init do_initcall_level(int level)
 {
 	initcall_t *fn;
+#ifdef CONFIG_MSM_BOOT_STATS
+	ktime_t start = ktime_get();
+#endif
 
 	strcpy(initcall_command_line, saved_command_line);
 	parse_args(initcall_level_names[level],
@@ -785,6 +798,9 @@ static void __init do_initcall_level(int level)
 
 	for (fn = initcall_levels[level]; fn < initcall_levels[level+1]; fn++)
 		do_one_initcall(*fn);
+#ifdef CONFIG_MSM_BOOT_STATS
+	boot_stats_event(start, "initcall_%s", initcall_level_names[level]);
+#endif
 }
 
 static void __init do_initcalls(void)
@@ -858,6 +874,9 @@ static int __ref kernel_init(void *unused)
 	numa_default_policy();
 
 	flush_delayed_fput();
+#ifdef CONFIG_MSM_BOOT_STATS
+	boot_stats_marker("init_start");
+#endif
 
 	if (ramdisk_execute_command) {
 		ret = run_init_process(ramdisk_execute_command);
@@ -0,0 +1,466 @@
+/*
+ * linux/kernel/irq/balance.c
+ *
+ * Interrupt balancing for heterogeneous cpus.
+ *
+ * Every balance period the interrupt rates are sampled from the irq
+ * statistics. Interrupts firing faster than min_rate whose affinity spans
+ * several cpus are taken over by the balancer, which pins each of them to
+ * one cpu of its original mask. Placement prefers the lowest capacity cpu
+ * whose interrupt load, scaled by its capacity, stays under cpu_limit and
+ * otherwise takes the least loaded cpu. An interrupt that stays below half
+ * of min_rate for a few periods gets its original mask back.
+ *
+ * Interrupts are moved off a cpu before core_ctl isolates it and before
+ * it goes offline. Threaded handlers follow the affinity of their
+ * interrupt, so the irq threads those interrupts wake move along.
+ */
+
+#include <linux/irq.h>
+#include <linux/interrupt.h>
+#include <linux/kernel_stat.h>
+#include <linux/cpu.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/mutex.h>
+#include <linux/jiffies.h>
+#include <linux/workqueue.h>
+#include <linux/moduleparam.h>
+
+#include "internals.h"
+
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "irq_balance."
+
+#define IRQB_MAX_MANAGED	32
+#define IRQB_MAX_EVACUATED	32
+/* periods below min_rate / 2 before an interrupt is released */
+#define IRQB_IDLE_PERIODS	4
+#define IRQB_MIN_PERIOD_MS	100U
+
+struct irqb_irq {
+	unsigned int irq;
+	unsigned int rate;
+	int cpu;
+	int idle;
+	struct cpumask allowed;
+};
+
+static bool irqb_enabled = true;
+module_param_named(enabled, irqb_enabled, bool, 0644);
+static unsigned int irqb_period_ms = 1000;
+module_param_named(period_ms, irqb_period_ms, uint, 0644);
+/* interrupts per second an irq needs before it is balanced */
+static unsigned int irqb_min_rate = 1000;
+module_param_named(min_rate, irqb_min_rate, uint, 0644);
+/* interrupts per second a cpu of full capacity takes before spilling */
+static unsigned int irqb_cpu_limit = 20000;
+module_param_named(cpu_limit, irqb_cpu_limit, uint, 0644);
+
+/* Protects everything below */
+static DEFINE_MUTEX(irqb_mutex);
+static struct irqb_irq irqb_managed[IRQB_MAX_MANAGED];
+static int irqb_nr_managed;
+/* unbalanced interrupts moved off isolated cpus, restored on unisolate */
+static struct irqb_irq irqb_evacuated[IRQB_MAX_EVACUATED];
+static int irqb_nr_evacuated;
+static struct cpumask irqb_isolated;
+static unsigned int irqb_load[NR_CPUS];
+static unsigned long irqb_cap[NR_CPUS];
+static unsigned int *irqb_last_count;
+static unsigned int irqb_nr_irqs;
+static unsigned long irqb_last_time;
+
+static void irqb_work_fn(struct work_struct *work);
+static DECLARE_DEFERRABLE_WORK(irqb_work, irqb_work_fn);
+
+static unsigned long irqb_efficiency(int cpu)
+{
+#ifdef CONFIG_SCHED_HMP
+	return arch_get_cpu_efficiency(cpu) ?: SCHED_CAPACITY_SCALE;
+#else
+	return SCHED_CAPACITY_SCALE;
+#endif
+}
+
+static struct irqb_irq *irqb_find(struct irqb_irq *tbl, int nr,
+				  unsigned int irq)
+{
+	int i;
+
+	for (i = 0; i < nr; i++)
+		if (tbl[i].irq == irq)
+			return &tbl[i];
+
+	return NULL;
+}
+
+static void irqb_remove(struct irqb_irq *tbl, int *nr, int i)
+{
+	tbl[i] = tbl[--(*nr)];
+}
+
+/* interrupt load of @cpu with @rate added, scaled to full capacity */
+static unsigned int irqb_scaled(int cpu, unsigned int rate)
+{
+	return (irqb_load[cpu] + rate) * SCHED_CAPACITY_SCALE / irqb_cap[cpu];
+}
+
+static int irqb_pick_cpu(unsigned int rate, const struct cpumask *cpus)
+{
+	int cpu, best = -1, best_fit = -1;
+
+	for_each_cpu(cpu, cpus) {
+		unsigned int load = irqb_scaled(cpu, rate);
+
+		if (best < 0 || load < irqb_scaled(best, rate))
+			best = cpu;
+		if (load > irqb_cpu_limit)
+			continue;
+		if (best_fit < 0 || irqb_cap[cpu] < irqb_cap[best_fit] ||
+		    (irqb_cap[cpu] == irqb_cap[best_fit] &&
+		     load < irqb_scaled(best_fit, rate)))
+			best_fit = cpu;
+	}
+
+	return best_fit >= 0 ? best_fit : best;
+}
+
+/* Caller holds irqb_mutex and the hotplug lock */
+static void irqb_place(struct irqb_irq *b, int exclude)
+{
+	struct cpumask cpus;
+	int cpu;
+
+	cpumask_and(&cpus, &b->allowed, cpu_online_mask);
+	cpumask_andnot(&cpus, &cpus, &irqb_isolated);
+	if (exclude >= 0)
+		cpumask_clear_cpu(exclude, &cpus);
+	if (cpumask_empty(&cpus)) {
+		cpumask_and(&cpus, &b->allowed, cpu_online_mask);
+		if (exclude >= 0)
+			cpumask_clear_cpu(exclude, &cpus);
+		if (cpumask_empty(&cpus))
+			return;
+	}
+
+	cpu = irqb_pick_cpu(b->rate, &cpus);
+
+	/* stay put unless the move gains a fit or a quarter of the load */
+	if (b->cpu >= 0 && b->cpu != cpu && cpumask_test_cpu(b->cpu, &cpus)) {
+		unsigned int cur = irqb_scaled(b->cpu, b->rate);
+		unsigned int new = irqb_scaled(cpu, b->rate);
+
+		if ((cur <= irqb_cpu_limit &&
+		     irqb_cap[b->cpu] <= irqb_cap[cpu]) ||
+		    (new > irqb_cpu_limit && cur <= new * 5 / 4))
+			cpu = b->cpu;
+	}
+
+	irqb_load[cpu] += b->rate;
+	if (cpu == b->cpu || irq_set_affinity(b->irq, cpumask_of(cpu)))
+		return;
+
+	pr_debug("irq_balance: irq %u (%u/s) cpu %d -> %d\n",
+		 b->irq, b->rate, b->cpu, cpu);
+	b->cpu = cpu;
+}
+
+/* Whether the affinity of @b is still the one the balancer set */
+static bool irqb_owns(struct irqb_irq *b)
+{
+	struct irq_desc *desc = irq_to_desc(b->irq);
+	unsigned long flags;
+	bool ret;
+
+	if (!desc || !desc->action)
+		return false;
+	if (b->cpu < 0)
+		return true;
+
+	raw_spin_lock_irqsave(&desc->lock, flags);
+	ret = cpumask_equal(desc->irq_data.affinity, cpumask_of(b->cpu));
+	raw_spin_unlock_irqrestore(&desc->lock, flags);
+
+	return ret;
+}
+
+static void irqb_release_all(void)
+{
+	while (irqb_nr_managed) {
+		struct irqb_irq *b = &irqb_managed[0];
+
+		if (irqb_owns(b))
+			irq_set_affinity(b->irq, &b->allowed);
+		irqb_remove(irqb_managed, &irqb_nr_managed, 0);
+	}
+}
+
+/*
+ * Update the rates of all interrupts, charge the unbalanced ones to the
+ * cpu they fire on and take over the new high rate ones.
+ */
+static void irqb_sample(unsigned int elapsed_ms)
+{
+	unsigned int irq, nr = min(irqb_nr_irqs, (unsigned int)nr_irqs);
+
+	memset(irqb_load, 0, sizeof(irqb_load));
+
+	irq_lock_sparse();
+	for (irq = 0; irq < nr; irq++) {
+		struct irq_desc *desc = irq_to_desc(irq);
+		struct irqb_irq *b;
+		struct cpumask mask;
+		unsigned long flags;
+		unsigned int count, rate;
+		int cpu;
+
+		if (!desc || !desc->action)
+			continue;
+
+		count = kstat_irqs(irq);
+		rate = div_u64((u64)(count - irqb_last_count[irq]) *
+			       MSEC_PER_SEC, elapsed_ms);
+		irqb_last_count[irq] = count;
+
+		b = irqb_find(irqb_managed, irqb_nr_managed, irq);
+		if (b) {
+			b->rate = rate;
+			continue;
+		}
+
+		raw_spin_lock_irqsave(&desc->lock, flags);
+		cpumask_and(&mask, desc->irq_data.affinity, cpu_online_mask);
+		raw_spin_unlock_irqrestore(&desc->lock, flags);
+
+		cpu = cpumask_first(&mask);
+		if (cpu < nr_cpu_ids)
+			irqb_load[cpu] += rate;
+
+		if (rate < irqb_min_rate || cpumask_weight(&mask) < 2 ||
+		    irqb_nr_managed == IRQB_MAX_MANAGED ||
+		    !irq_can_set_affinity(irq) ||
+		    irqb_find(irqb_evacuated, irqb_nr_evacuated, irq))
+			continue;
+
+		b = &irqb_managed[irqb_nr_managed++];
+		b->irq = irq;
+		b->rate = rate;
+		b->cpu = -1;
+		b->idle = 0;
+		raw_spin_lock_irqsave(&desc->lock, flags);
+		cpumask_copy(&b->allowed, desc->irq_data.affinity);
+		raw_spin_unlock_irqrestore(&desc->lock, flags);
+	}
+	irq_unlock_sparse();
+}
+
+static int irqb_rate_cmp(const void *a, const void *b)
+{
+	const struct irqb_irq *ba = a, *bb = b;
+
+	if (ba->rate == bb->rate)
+		return 0;
+	return ba->rate > bb->rate ? -1 : 1;
+}
+
+static void irqb_rebalance(void)
+{
+	int i = 0;
+
+	while (i < irqb_nr_managed) {
+		struct irqb_irq *b = &irqb_managed[i];
+
+		/* somebody else set the affinity, leave it to them */
+		if (!irqb_owns(b)) {
+			irqb_remove(irqb_managed, &irqb_nr_managed, i);
+			continue;
+		}
+
+		if (b->rate >= irqb_min_rate / 2) {
+			b->idle = 0;
+		} else if (++b->idle >= IRQB_IDLE_PERIODS) {
+			irq_set_affinity(b->irq, &b->allowed);
+			irqb_remove(irqb_managed, &irqb_nr_managed, i);
+			continue;
+		}
+		i++;
+	}
+
+	/* the busiest interrupts pick first */
+	sort(irqb_managed, irqb_nr_managed, sizeof(irqb_managed[0]),
+	     irqb_rate_cmp, NULL);
+
+	for (i = 0; i < irqb_nr_managed; i++)
+		irqb_place(&irqb_managed[i], -1);
+}
+
+static void irqb_work_fn(struct work_struct *work)
+{
+	unsigned long now = jiffies;
+	unsigned int elapsed = jiffies_to_msecs(now - irqb_last_time);
+
+	get_online_cpus();
+	mutex_lock(&irqb_mutex);
+	if (!irqb_enabled) {
+		irqb_release_all();
+	} else if (elapsed) {
+		irqb_sample(elapsed);
+		irqb_rebalance();
+	}
+	irqb_last_time = now;
+	mutex_unlock(&irqb_mutex);
+	put_online_cpus();
+
+	queue_delayed_work(system_power_efficient_wq, &irqb_work,
+		msecs_to_jiffies(max(irqb_period_ms, IRQB_MIN_PERIOD_MS)));
+}
+
+/* Caller holds irqb_mutex and the hotplug lock */
+static void irqb_evacuate_managed(int cpu)
+{
+	int i;
+
+	for (i = 0; i < irqb_nr_managed; i++) {
+		struct irqb_irq *b = &irqb_managed[i];
+
+		if (b->cpu != cpu)
+			continue;
+
+		irqb_load[cpu] -= min(irqb_load[cpu], b->rate);
+		irqb_place(b, cpu);
+	}
+}
+
+/*
+ * Move the other interrupts that fire on @cpu to the rest of their mask,
+ * remembering the mask so that unisolating can restore it.
+ */
+static void irqb_evacuate_unmanaged(int cpu)
+{
+	unsigned int irq;
+
+	irq_lock_sparse();
+	for (irq = 0; irq < nr_irqs; irq++) {
+		struct irq_desc *desc = irq_to_desc(irq);
+		struct cpumask mask, cpus;
+		struct irqb_irq *e;
+		unsigned long flags;
+
+		if (irqb_nr_evacuated == IRQB_MAX_EVACUATED)
+			break;
+		if (!desc || !desc->action || !irq_can_set_affinity(irq) ||
+		    irqb_find(irqb_managed, irqb_nr_managed, irq))
+			continue;
+
+		raw_spin_lock_irqsave(&desc->lock, flags);
+		cpumask_copy(&mask, desc->irq_data.affinity);
+		raw_spin_unlock_irqrestore(&desc->lock, flags);
+
+		cpumask_and(&cpus, &mask, cpu_online_mask);
+		if (cpumask_first(&cpus) != cpu)
+			continue;
+
+		cpumask_andnot(&cpus, &cpus, &irqb_isolated);
+		if (cpumask_empty(&cpus))
+			cpumask_andnot(&cpus, cpu_online_mask, &irqb_isolated);
+		if (cpumask_empty(&cpus) || irq_set_affinity(irq, &cpus))
+			continue;
+
+		e = &irqb_evacuated[irqb_nr_evacuated++];
+		e->irq = irq;
+		e->cpu = cpu;
+		cpumask_copy(&e->allowed, &mask);
+	}
+	irq_unlock_sparse();
+}
+
+/**
+ * irq_balance_isolate_cpu - move interrupts off a cpu about to be isolated
+ * @cpu: the cpu
+ *
+ * Called with the hotplug lock held, before @cpu is marked isolated.
+ */
+void irq_balance_isolate_cpu(int cpu)
+{
+	mutex_lock(&irqb_mutex);
+	cpumask_set_cpu(cpu, &irqb_isolated);
+	irqb_evacuate_managed(cpu);
+	irqb_evacuate_unmanaged(cpu);
+	mutex_unlock(&irqb_mutex);
+}
+
+/**
+ * irq_balance_unisolate_cpu - let interrupts back on a cpu
+ * @cpu: the cpu
+ *
+ * Interrupts moved off @cpu get their mask back, balanced ones return on
+ * the next balance period if @cpu is the better place for them.
+ */
+void irq_balance_unisolate_cpu(int cpu)
+{
+	int i = 0;
+
+	mutex_lock(&irqb_mutex);
+	cpumask_clear_cpu(cpu, &irqb_isolated);
+	while (i < irqb_nr_evacuated) {
+		struct irqb_irq *e = &irqb_evacuated[i];
+		struct irq_desc *desc = irq_to_desc(e->irq);
+
+		if (e->cpu != cpu) {
+			i++;
+			continue;
+		}
+
+		if (desc && desc->action)
+			irq_set_affinity(e->irq, &e->allowed);
+		irqb_remove(irqb_evacuated, &irqb_nr_evacuated, i);
+	}
+	mutex_unlock(&irqb_mutex);
+}
+
+static int irqb_cpu_callback(struct notifier_block *nfb,
+			     unsigned long action, void *hcpu)
+{
+	int cpu = (long)hcpu;
+
+	switch (action & ~CPU_TASKS_FROZEN) {
+	case CPU_DOWN_PREPARE:
+		/* place them ourselves rather than leave it to migrate_irqs */
+		mutex_lock(&irqb_mutex);
+		irqb_evacuate_managed(cpu);
+		mutex_unlock(&irqb_mutex);
+		break;
+	}
+
+	return NOTIFY_OK;
+}
+
+static int __init irq_balance_init(void)
+{
+	unsigned long max_eff = 0;
+	int cpu;
+
+	irqb_nr_irqs = nr_irqs;
+	irqb_last_count = kcalloc(irqb_nr_irqs, sizeof(*irqb_last_count),
+				  GFP_KERNEL);
+	if (!irqb_last_count)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu)
+		max_eff = max(max_eff, irqb_efficiency(cpu));
+	for_each_possible_cpu(cpu)
+		irqb_cap[cpu] = max(1UL, irqb_efficiency(cpu) *
+				    SCHED_CAPACITY_SCALE / max_eff);
+
+	irqb_last_time = jiffies;
+	hotcpu_notifier(irqb_cpu_callback, 0);
+	queue_delayed_work(system_power_efficient_wq, &irqb_work,
+			   msecs_to_jiffies(irqb_period_ms));
+
+	return 0;
+}
+late_initcall(irq_balance_init);
@@ -20,6 +20,10 @@
 #include <linux/slab.h>
 #include <linux/of.h>
 #include <linux/htc_fda.h>
+#include <linux/msm_kgsl.h>
+
+#define CREATE_TRACE_POINTS
+#include <trace/events/pnpmgr.h>
 
 #include "power.h"
 
@@ -113,6 +117,8 @@ static ssize_t _name##_store					\
 extern void set_ktm_freq_limit(uint32_t freq_limit);
 extern void set_bcl_freq_limit(uint32_t freq_limit);
 
+static void pnp_policy_kick(const char *attr);
+
 static char activity_buf[MAX_BUF];
 static char non_activity_buf[MAX_BUF];
 static char media_mode_buf[MAX_BUF];
@@ -279,13 +285,14 @@ define_int_store(thermal_g0, thermal_g0_value, null_cb);
 power_attr(thermal_g0);
 
 define_int_show(thermal_batt, thermal_batt_value);
-define_int_store(thermal_batt, thermal_batt_value, null_cb);
+define_int_store(thermal_batt, thermal_batt_value, pnp_policy_kick);
 int pnpmgr_batt_thermal_notify(int temp)
 {
 	pr_debug("%s: thermal batt temp = %d\n", __func__, temp);
 	if (thermal_batt_value != temp) {
 		thermal_batt_value = temp;
 		sysfs_notify(thermal_kobj, NULL, "thermal_batt");
+		pnp_policy_kick("thermal_batt");
 	}
 	return 0;
 }
@@ -379,6 +386,7 @@ int pnpmgr_battery_charging_enabled(int charging_enabled)
 	if (charging_enabled_value != charging_enabled) {
 		charging_enabled_value = charging_enabled;
 		sysfs_notify(battery_kobj, NULL, "charging_enabled");
+		pnp_policy_kick("charging_enabled");
 	}
 	return 0;
 }
@@ -1101,6 +1109,300 @@ power_attr(user_perf_lvl);
 define_cluster_info_show(user_lvl_to_min_freq);
 power_ro_attr(user_lvl_to_min_freq);
 
+/*
+ * Battery aware policy. Userspace pushes the battery level and the
+ * foreground app class, the battery driver and thermal daemon push
+ * charger state and battery temperature through the hooks above. On
+ * each change the policy picks a restriction level, 0 for none to
+ * PNP_POLICY_LEVELS - 1, and applies that level's CPU, GPU and bus
+ * ceilings. Thresholds are only left once they are crossed back by the
+ * hysteresis margin, so a level does not flap around a threshold.
+ */
+#define PNP_POLICY_LEVELS	4
+
+enum {
+	PNP_APP_DEFAULT,
+	PNP_APP_GAME,
+	PNP_APP_VIDEO,
+};
+
+static int policy_enable_value;
+static int policy_level_value;
+static int battery_level_value = 100;
+static int app_class_value;
+static int low_batt_value = 15;
+static int crit_batt_value = 5;
+static int batt_hyst_value = 5;
+/* battery temperature in 0.1 degC, as reported on thermal_batt */
+static int hot_temp_value = 450;
+static int crit_temp_value = 500;
+static int temp_hyst_value = 20;
+
+/* CPU ceilings in percent of the cluster max, GPU in Hz and bus in MBps */
+static int cpu_ceiling[PNP_POLICY_LEVELS] = { 100, 85, 70, 50 };
+static int gpu_ceiling[PNP_POLICY_LEVELS];
+static int bus_ceiling[PNP_POLICY_LEVELS];
+
+static bool low_batt_state, crit_batt_state, hot_state, crit_temp_state;
+static unsigned int pnp_cpu_max[MAX_TYPE];
+static unsigned int pnp_bus_max;
+static void *pnp_gpu_limit;
+static struct kobject *policy_kobj;
+
+static void pnp_policy_work_fn(struct work_struct *work);
+static DECLARE_WORK(pnp_policy_work, pnp_policy_work_fn);
+
+static void pnp_policy_kick(const char *attr)
+{
+	if (policy_enable_value)
+		schedule_work(&pnp_policy_work);
+}
+
+static bool pnp_above(bool state, int val, int thres, int hyst)
+{
+	if (val >= thres)
+		return true;
+	if (val < thres - hyst)
+		return false;
+	return state;
+}
+
+static bool pnp_below(bool state, int val, int thres, int hyst)
+{
+	if (val <= thres)
+		return true;
+	if (val > thres + hyst)
+		return false;
+	return state;
+}
+
+static int pnp_policy_level(void)
+{
+	int level = 0;
+
+	if (charging_enabled_value) {
+		low_batt_state = crit_batt_state = false;
+	} else {
+		low_batt_state = pnp_below(low_batt_state,
+				battery_level_value, low_batt_value,
+				batt_hyst_value);
+		crit_batt_state = pnp_below(crit_batt_state,
+				battery_level_value, crit_batt_value,
+				batt_hyst_value);
+	}
+	hot_state = pnp_above(hot_state, thermal_batt_value,
+			hot_temp_value, temp_hyst_value);
+	crit_temp_state = pnp_above(crit_temp_state, thermal_batt_value,
+			crit_temp_value, temp_hyst_value);
+
+	if (low_batt_state || hot_state)
+		level = 2;
+	if (crit_batt_state || crit_temp_state)
+		return PNP_POLICY_LEVELS - 1;
+
+	if (app_class_value == PNP_APP_GAME && level)
+		level--;
+	else if (app_class_value == PNP_APP_VIDEO)
+		level = max(level, 1);
+
+	return level;
+}
+
+static int pnp_policy_cpufreq_notifier(struct notifier_block *nb,
+		unsigned long event, void *data)
+{
+	struct cpufreq_policy *policy = data;
+	int i;
+
+	if (event != CPUFREQ_ADJUST || !policy_enable_value)
+		return NOTIFY_OK;
+
+	for (i = 0; i < cluster_num; i++) {
+		if (cpumask_test_cpu(policy->cpu, &info[i].cpu_mask) &&
+		    pnp_cpu_max[i])
+			cpufreq_verify_within_limits(policy, 0, pnp_cpu_max[i]);
+	}
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block pnp_policy_cpufreq_nb = {
+	.notifier_call = pnp_policy_cpufreq_notifier,
+};
+
+#if IS_BUILTIN(CONFIG_MSM_KGSL)
+static void pnp_policy_set_gpu_max(unsigned int gpu_max)
+{
+	if (!pnp_gpu_limit && gpu_max) {
+		pnp_gpu_limit = kgsl_pwr_limits_add(KGSL_DEVICE_3D0);
+		if (IS_ERR(pnp_gpu_limit))
+			pnp_gpu_limit = NULL;
+	}
+	if (!pnp_gpu_limit)
+		return;
+
+	if (gpu_max)
+		kgsl_pwr_limits_set_freq(pnp_gpu_limit, gpu_max);
+	else
+		kgsl_pwr_limits_set_default(pnp_gpu_limit);
+}
+
+static void pnp_policy_put_gpu(void)
+{
+	if (pnp_gpu_limit)
+		kgsl_pwr_limits_del(pnp_gpu_limit);
+	pnp_gpu_limit = NULL;
+}
+#else
+static void pnp_policy_set_gpu_max(unsigned int gpu_max) { }
+static void pnp_policy_put_gpu(void) { }
+#endif
+
+static void pnp_policy_work_fn(struct work_struct *work)
+{
+	int i, cpu, level = 0;
+	unsigned int gpu_max = 0;
+
+	if (policy_enable_value)
+		level = pnp_policy_level();
+
+	for (i = 0; i < cluster_num; i++)
+		pnp_cpu_max[i] = policy_enable_value ?
+			info[i].max_freq_info / 100 * cpu_ceiling[level] : 0;
+
+	get_online_cpus();
+	for (i = 0; i < cluster_num; i++) {
+		for_each_cpu_and(cpu, &info[i].cpu_mask, cpu_online_mask) {
+			cpufreq_update_policy(cpu);
+			if (info[i].is_sync)
+				break;
+		}
+	}
+	put_online_cpus();
+
+	if (policy_enable_value)
+		gpu_max = gpu_ceiling[level];
+	pnp_policy_set_gpu_max(gpu_max);
+
+	pnp_bus_max = policy_enable_value ? bus_ceiling[level] : 0;
+
+	trace_pnpmgr_policy(level, battery_level_value,
+			charging_enabled_value, thermal_batt_value,
+			app_class_value, pnp_cpu_max[BC_TYPE],
+			pnp_cpu_max[LC_TYPE], gpu_max, pnp_bus_max);
+
+	if (policy_level_value != level) {
+		policy_level_value = level;
+		sysfs_notify(policy_kobj, NULL, "level");
+	}
+	sysfs_notify(policy_kobj, NULL, "bus_max");
+}
+
+void pnpmgr_battery_level_notify(int level)
+{
+	if (battery_level_value != level && policy_kobj) {
+		battery_level_value = level;
+		sysfs_notify(policy_kobj, NULL, "battery_level");
+		pnp_policy_kick("battery_level");
+	}
+}
+EXPORT_SYMBOL(pnpmgr_battery_level_notify);
+
+define_int_show(enable, policy_enable_value);
+static ssize_t
+enable_store(struct kobject *kobj, struct kobj_attribute *attr,
+		const char *buf, size_t n)
+{
+	int val;
+
+	if (sscanf(buf, "%d", &val) > 0) {
+		policy_enable_value = !!val;
+		schedule_work(&pnp_policy_work);
+		return n;
+	}
+	return -EINVAL;
+}
+power_attr(enable);
+
+define_int_show(level, policy_level_value);
+power_ro_attr(level);
+
+static ssize_t
+bus_max_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u", pnp_bus_max);
+}
+power_ro_attr(bus_max);
+
+define_int_show(battery_level, battery_level_value);
+define_int_store(battery_level, battery_level_value, pnp_policy_kick);
+power_attr(battery_level);
+
+define_int_show(app_class, app_class_value);
+define_int_store(app_class, app_class_value, pnp_policy_kick);
+power_attr(app_class);
+
+define_int_show(low_batt, low_batt_value);
+define_int_store(low_batt, low_batt_value, pnp_policy_kick);
+power_attr(low_batt);
+
+define_int_show(crit_batt, crit_batt_value);
+define_int_store(crit_batt, crit_batt_value, pnp_policy_kick);
+power_attr(crit_batt);
+
+define_int_show(batt_hyst, batt_hyst_value);
+define_int_store(batt_hyst, batt_hyst_value, pnp_policy_kick);
+power_attr(batt_hyst);
+
+define_int_show(hot_temp, hot_temp_value);
+define_int_store(hot_temp, hot_temp_value, pnp_policy_kick);
+power_attr(hot_temp);
+
+define_int_show(crit_temp, crit_temp_value);
+define_int_store(crit_temp, crit_temp_value, pnp_policy_kick);
+power_attr(crit_temp);
+
+define_int_show(temp_hyst, temp_hyst_value);
+define_int_store(temp_hyst, temp_hyst_value, pnp_policy_kick);
+power_attr(temp_hyst);
+
+static ssize_t show_ceiling(int *table, char *buf)
+{
+	return sprintf(buf, "%d %d %d %d", table[0], table[1], table[2],
+			table[3]);
+}
+
+static ssize_t store_ceiling(int *table, const char *buf, size_t n)
+{
+	int val[PNP_POLICY_LEVELS];
+
+	if (sscanf(buf, "%d %d %d %d", &val[0], &val[1], &val[2],
+			&val[3]) != PNP_POLICY_LEVELS)
+		return -EINVAL;
+
+	memcpy(table, val, sizeof(val));
+	pnp_policy_kick("ceiling");
+	return n;
+}
+
+#define define_ceiling_attr(_name, table)			\
+static ssize_t _name##_show					\
+(struct kobject *kobj, struct kobj_attribute *attr, char *buf)	\
+{								\
+	return show_ceiling(table, buf);			\
+}								\
+static ssize_t _name##_store					\
+(struct kobject *kobj, struct kobj_attribute *attr,		\
+ const char *buf, size_t n)					\
+{								\
+	return store_ceiling(table, buf, n);			\
+}								\
+power_attr(_name)
+
+define_ceiling_attr(cpu_ceiling, cpu_ceiling);
+define_ceiling_attr(gpu_ceiling, gpu_ceiling);
+define_ceiling_attr(bus_ceiling, bus_ceiling);
+
 static struct attribute *mp_hotplug_g[] = {
 #ifdef CONFIG_HOTPLUG_CPU
 	&mp_nw_attr.attr,
@@ -1206,6 +1508,24 @@ static struct attribute *cluster_type_g[] = {
 	NULL,
 };
 
+static struct attribute *policy_g[] = {
+	&enable_attr.attr,
+	&level_attr.attr,
+	&bus_max_attr.attr,
+	&battery_level_attr.attr,
+	&app_class_attr.attr,
+	&low_batt_attr.attr,
+	&crit_batt_attr.attr,
+	&batt_hyst_attr.attr,
+	&hot_temp_attr.attr,
+	&crit_temp_attr.attr,
+	&temp_hyst_attr.attr,
+	&cpu_ceiling_attr.attr,
+	&gpu_ceiling_attr.attr,
+	&bus_ceiling_attr.attr,
+	NULL,
+};
+
 static struct attribute_group mp_hotplug_attr_group = {
 	.attrs = mp_hotplug_g,
 };
@@ -1246,6 +1566,10 @@ static struct attribute_group cluster_type_attr_group = {
 	.attrs = cluster_type_g,
 };
 
+static struct attribute_group policy_attr_group = {
+	.attrs = policy_g,
+};
+
 #ifdef CONFIG_HOTPLUG_CPU
 static int __cpuinit cpu_hotplug_callback(struct notifier_block *nfb, unsigned long action, void *hcpu)
 {
@@ -1515,8 +1839,9 @@ static int __init pnpmgr_init(void)
 	sysinfo_kobj = kobject_create_and_add("sysinfo", pnpmgr_kobj);
 	battery_kobj = kobject_create_and_add("battery", pnpmgr_kobj);
 	cluster_root_kobj = kobject_create_and_add("cluster", pnpmgr_kobj);
+	policy_kobj = kobject_create_and_add("policy", pnpmgr_kobj);
 
-	if (!mp_hotplug_kobj || !thermal_kobj || !apps_kobj || !display_kobj || !sysinfo_kobj || !battery_kobj || !cluster_root_kobj) {
+	if (!mp_hotplug_kobj || !thermal_kobj || !apps_kobj || !display_kobj || !sysinfo_kobj || !battery_kobj || !cluster_root_kobj || !policy_kobj) {
 		pr_err("%s: Can not allocate enough memory.\n", __func__);
 		ret = -ENOMEM;
 		goto err;
@@ -1580,6 +1905,7 @@ static int __init pnpmgr_init(void)
 	ret |= sysfs_create_group(display_kobj, &display_attr_group);
 	ret |= sysfs_create_group(sysinfo_kobj, &sysinfo_attr_group);
 	ret |= sysfs_create_group(battery_kobj, &battery_attr_group);
+	ret |= sysfs_create_group(policy_kobj, &policy_attr_group);
 
 	for (i = 0; i < cluster_num; i++) {
 		ret |= sysfs_create_group(cluster_kobj[i], &cluster_type_attr_group);
@@ -1600,6 +1926,8 @@ static int __init pnpmgr_init(void)
 #ifdef CONFIG_HOTPLUG_CPU
 	register_hotcpu_notifier(&cpu_hotplug_notifier);
 #endif
+	cpufreq_register_notifier(&pnp_policy_cpufreq_nb,
+			CPUFREQ_POLICY_NOTIFIER);
 
 	return 0;
 
@@ -1620,6 +1948,12 @@ static void  __exit pnpmgr_exit(void)
 	sysfs_remove_group(display_kobj, &display_attr_group);
 	sysfs_remove_group(sysinfo_kobj, &sysinfo_attr_group);
 	sysfs_remove_group(battery_kobj, &battery_attr_group);
+	sysfs_remove_group(policy_kobj, &policy_attr_group);
+
+	cpufreq_unregister_notifier(&pnp_policy_cpufreq_nb,
+			CPUFREQ_POLICY_NOTIFIER);
+	cancel_work_sync(&pnp_policy_work);
+	pnp_policy_put_gpu();
 
 	for (i = 0; i < cluster_num; i++) {
 		sysfs_remove_group(cluster_kobj[i], &cluster_type_attr_group);
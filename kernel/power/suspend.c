@@ -209,6 +209,7 @@ static int suspend_prepare(suspend_state_t state)
 	if (error)
 		goto Finish;
 
+	log_suspend_phase(SUSPEND_PHASE_FREEZE);
 	trace_suspend_resume(TPS("freeze_processes"), 0, true);
 	error = suspend_freeze_processes();
 	trace_suspend_resume(TPS("freeze_processes"), 0, false);
@@ -242,6 +243,7 @@ static int suspend_enter(suspend_state_t state, bool *wakeup)
 	if (error)
 		goto Platform_finish;
 
+	log_suspend_phase(SUSPEND_PHASE_LATE_SUSPEND);
 	error = dpm_suspend_late(PMSG_SUSPEND);
 	if (error) {
 		last_dev = suspend_stats.last_failed_dev + REC_FAILED_NUM - 1;
@@ -287,6 +289,7 @@ static int suspend_enter(suspend_state_t state, bool *wakeup)
 	arch_suspend_disable_irqs();
 	BUG_ON(!irqs_disabled());
 
+	log_suspend_phase(SUSPEND_PHASE_SYSCORE_SUSPEND);
 	error = syscore_suspend();
 	if (!error) {
 		*wakeup = pm_wakeup_pending();
@@ -305,6 +308,7 @@ static int suspend_enter(suspend_state_t state, bool *wakeup)
 		}
 		syscore_resume();
 	}
+	log_suspend_phase(SUSPEND_PHASE_SYSCORE_RESUME);
 
 	arch_suspend_enable_irqs();
 	BUG_ON(irqs_disabled());
@@ -342,6 +346,7 @@ int suspend_devices_and_enter(suspend_state_t state)
 		suspend_console();
 
 	suspend_test_start();
+	log_suspend_phase(SUSPEND_PHASE_DEV_SUSPEND);
 	error = dpm_suspend_start(PMSG_SUSPEND);
 	if (error) {
 		pr_err("PM: Some devices failed to suspend, or early wake event detected\n");
@@ -358,6 +363,7 @@ int suspend_devices_and_enter(suspend_state_t state)
 
  Resume_devices:
 	suspend_test_start();
+	log_suspend_phase(SUSPEND_PHASE_DEV_RESUME);
 	dpm_resume_end(PMSG_RESUME);
 	suspend_test_finish("resume devices");
 	trace_suspend_resume(TPS("resume_console"), state, true);
@@ -376,6 +382,7 @@ int suspend_devices_and_enter(suspend_state_t state)
 
 static void suspend_finish(void)
 {
+	log_suspend_phase(SUSPEND_PHASE_THAW);
 	suspend_thaw_processes();
 	pm_notifier_call_chain(PM_POST_SUSPEND);
 	pm_restore_console();
@@ -41,6 +41,27 @@ static ktime_t curr_monotime; /* monotonic time after last suspend */
 static ktime_t last_stime; /* monotonic boottime offset before last suspend */
 static ktime_t curr_stime; /* monotonic boottime offset after last suspend */
 
+#define SUSPEND_HISTORY_LEN	16
+#define SUSPEND_DEV_NAME_LEN	32
+
+/* One suspend attempt, timestamps are zero for phases not reached */
+struct suspend_cycle {
+	ktime_t mono[SUSPEND_PHASE_MAX];
+	ktime_t boot[SUSPEND_PHASE_MAX];
+	char slow_suspend_dev[SUSPEND_DEV_NAME_LEN];
+	s64 slow_suspend_us;
+	char slow_resume_dev[SUSPEND_DEV_NAME_LEN];
+	s64 slow_resume_us;
+	bool aborted;
+	char abort_reason[MAX_SUSPEND_ABORT_LEN];
+};
+
+/* Protected by resume_reason_lock */
+static struct suspend_cycle suspend_history[SUSPEND_HISTORY_LEN];
+static unsigned int suspend_history_next;
+static unsigned int suspend_history_count;
+static struct suspend_cycle *suspend_cycle_cur;
+
 static ssize_t last_resume_reason_show(struct kobject *kobj, struct kobj_attribute *attr,
 		char *buf)
 {
@@ -92,12 +113,89 @@ static ssize_t last_suspend_time_show(struct kobject *kobj,
 				sleep_time.tv_sec, sleep_time.tv_nsec);
 }
 
+static s64 suspend_cycle_us(struct suspend_cycle *c, enum suspend_phase from,
+			    enum suspend_phase to)
+{
+	if (!ktime_to_ns(c->mono[from]) || !ktime_to_ns(c->mono[to]))
+		return -1;
+	return ktime_us_delta(c->mono[to], c->mono[from]);
+}
+
+/*
+ * One line per suspend attempt, oldest first. Times are in usecs and -1
+ * for phases the attempt did not reach. "lowlevel" is the awake part of
+ * syscore suspend, firmware entry and exit and syscore resume, "asleep"
+ * the rest of that window.
+ */
+static ssize_t suspend_history_show(struct kobject *kobj,
+			struct kobj_attribute *attr, char *buf)
+{
+	struct suspend_cycle *c;
+	unsigned int i, idx;
+	s64 asleep;
+	int len = 0;
+
+	spin_lock(&resume_reason_lock);
+	for (i = 0; i < suspend_history_count; i++) {
+		idx = (suspend_history_next - suspend_history_count + i) %
+		      SUSPEND_HISTORY_LEN;
+		c = &suspend_history[idx];
+
+		asleep = -1;
+		if (ktime_to_ns(c->boot[SUSPEND_PHASE_SYSCORE_RESUME]))
+			asleep = ktime_us_delta(
+				c->boot[SUSPEND_PHASE_SYSCORE_RESUME],
+				c->boot[SUSPEND_PHASE_SYSCORE_SUSPEND]) -
+				suspend_cycle_us(c,
+					SUSPEND_PHASE_SYSCORE_SUSPEND,
+					SUSPEND_PHASE_SYSCORE_RESUME);
+
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+			"%lld freeze %lld suspend %lld late %lld lowlevel %lld asleep %lld early %lld resume %lld thaw %lld",
+			ktime_to_ms(c->boot[SUSPEND_PHASE_FREEZE]),
+			suspend_cycle_us(c, SUSPEND_PHASE_FREEZE,
+					 SUSPEND_PHASE_DEV_SUSPEND),
+			suspend_cycle_us(c, SUSPEND_PHASE_DEV_SUSPEND,
+					 SUSPEND_PHASE_LATE_SUSPEND),
+			suspend_cycle_us(c, SUSPEND_PHASE_LATE_SUSPEND,
+					 SUSPEND_PHASE_SYSCORE_SUSPEND),
+			suspend_cycle_us(c, SUSPEND_PHASE_SYSCORE_SUSPEND,
+					 SUSPEND_PHASE_SYSCORE_RESUME),
+			asleep,
+			suspend_cycle_us(c, SUSPEND_PHASE_SYSCORE_RESUME,
+					 SUSPEND_PHASE_DEV_RESUME),
+			suspend_cycle_us(c, SUSPEND_PHASE_DEV_RESUME,
+					 SUSPEND_PHASE_THAW),
+			suspend_cycle_us(c, SUSPEND_PHASE_THAW,
+					 SUSPEND_PHASE_END));
+		if (c->slow_suspend_dev[0])
+			len += scnprintf(buf + len, PAGE_SIZE - len,
+					 " slowest_suspend %s %lld",
+					 c->slow_suspend_dev,
+					 c->slow_suspend_us);
+		if (c->slow_resume_dev[0])
+			len += scnprintf(buf + len, PAGE_SIZE - len,
+					 " slowest_resume %s %lld",
+					 c->slow_resume_dev, c->slow_resume_us);
+		if (c->aborted)
+			len += scnprintf(buf + len, PAGE_SIZE - len,
+					 " abort: %.64s", c->abort_reason);
+		len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+	}
+	spin_unlock(&resume_reason_lock);
+
+	return len;
+}
+
 static struct kobj_attribute resume_reason = __ATTR_RO(last_resume_reason);
 static struct kobj_attribute suspend_time = __ATTR_RO(last_suspend_time);
+static struct kobj_attribute suspend_history_attr =
+	__ATTR(suspend_history, S_IRUGO, suspend_history_show, NULL);
 
 static struct attribute *attrs[] = {
 	&resume_reason.attr,
 	&suspend_time.attr,
+	&suspend_history_attr.attr,
 	NULL,
 };
 static struct attribute_group attr_group = {
@@ -161,6 +259,45 @@ void log_suspend_abort_reason(const char *fmt, ...)
 	va_start(args, fmt);
 	snprintf(abort_reason, MAX_SUSPEND_ABORT_LEN, fmt, args);
 	va_end(args);
+	if (suspend_cycle_cur) {
+		suspend_cycle_cur->aborted = true;
+		strlcpy(suspend_cycle_cur->abort_reason, abort_reason,
+			MAX_SUSPEND_ABORT_LEN);
+	}
+	spin_unlock(&resume_reason_lock);
+}
+
+/*
+ * Timestamp the start of @phase in the current suspend cycle. Called
+ * with interrupts off around syscore, never while timekeeping is
+ * suspended.
+ */
+void log_suspend_phase(enum suspend_phase phase)
+{
+	ktime_t mono = ktime_get(), boot = ktime_get_boottime();
+
+	spin_lock(&resume_reason_lock);
+	if (suspend_cycle_cur) {
+		suspend_cycle_cur->mono[phase] = mono;
+		suspend_cycle_cur->boot[phase] = boot;
+	}
+	spin_unlock(&resume_reason_lock);
+}
+
+/* Note the slowest device callback of the suspend or resume pass */
+void log_suspend_slowest_dev(bool resume, const char *name, s64 usecs)
+{
+	struct suspend_cycle *c;
+
+	spin_lock(&resume_reason_lock);
+	c = suspend_cycle_cur;
+	if (c && resume) {
+		strlcpy(c->slow_resume_dev, name, SUSPEND_DEV_NAME_LEN);
+		c->slow_resume_us = usecs;
+	} else if (c) {
+		strlcpy(c->slow_suspend_dev, name, SUSPEND_DEV_NAME_LEN);
+		c->slow_suspend_us = usecs;
+	}
 	spin_unlock(&resume_reason_lock);
 }
 
@@ -173,6 +310,12 @@ static int wakeup_reason_pm_event(struct notifier_block *notifier,
 		spin_lock(&resume_reason_lock);
 		irqcount = 0;
 		suspend_abort = false;
+		suspend_cycle_cur = &suspend_history[suspend_history_next];
+		memset(suspend_cycle_cur, 0, sizeof(*suspend_cycle_cur));
+		suspend_history_next = (suspend_history_next + 1) %
+				       SUSPEND_HISTORY_LEN;
+		if (suspend_history_count < SUSPEND_HISTORY_LEN)
+			suspend_history_count++;
 		spin_unlock(&resume_reason_lock);
 		/* monotonic time since boot */
 		last_monotime = ktime_get();
@@ -180,6 +323,10 @@ static int wakeup_reason_pm_event(struct notifier_block *notifier,
 		last_stime = ktime_get_boottime();
 		break;
 	case PM_POST_SUSPEND:
+		log_suspend_phase(SUSPEND_PHASE_END);
+		spin_lock(&resume_reason_lock);
+		suspend_cycle_cur = NULL;
+		spin_unlock(&resume_reason_lock);
 		/* monotonic time since boot */
 		curr_monotime = ktime_get();
 		/* monotonic time since boot including the time spent in suspend */
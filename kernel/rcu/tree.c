@@ -311,6 +311,15 @@ static ulong jiffies_till_next_fqs = ULONG_MAX;
 module_param(jiffies_till_first_fqs, ulong, 0644);
 module_param(jiffies_till_next_fqs, ulong, 0644);
 
+/*
+ * The quiescent-state forcing waits use a deferrable timer, which does
+ * not wake an idle system every few jiffies, backed by a normal timeout
+ * of this many jiffies. Zero or a value not above the FQS interval goes
+ * back to plain timeouts.
+ */
+static ulong jiffies_till_fqs_backstop = HZ;
+module_param(jiffies_till_fqs_backstop, ulong, 0644);
+
 /*
  * How long the grace period must be before we start recruiting
  * quiescent-state help from rcu_note_context_switch().
@@ -1773,6 +1782,14 @@ static void rcu_gp_cleanup(struct rcu_state *rsp)
 	raw_spin_unlock_irq(&rnp->lock);
 }
 
+/* Deferrable wakeup of the grace-period kthread for FQS. */
+static void rcu_gp_fqs_timer(unsigned long data)
+{
+	struct rcu_state *rsp = (struct rcu_state *)data;
+
+	wake_up(&rsp->gp_wq);
+}
+
 /*
  * Body of kthread that handles grace periods.
  */
@@ -1781,6 +1798,7 @@ static int __noreturn rcu_gp_kthread(void *arg)
 	int fqs_state;
 	int gf;
 	unsigned long j;
+	unsigned long backstop;
 	int ret;
 	struct rcu_state *rsp = arg;
 	struct rcu_node *rnp = rcu_get_root(rsp);
@@ -1821,12 +1839,22 @@ static int __noreturn rcu_gp_kthread(void *arg)
 					       ACCESS_ONCE(rsp->gpnum),
 					       TPS("fqswait"));
 			rsp->gp_state = RCU_GP_WAIT_FQS;
+			backstop = min_t(ulong,
+					 ACCESS_ONCE(jiffies_till_fqs_backstop),
+					 rcu_jiffies_till_stall_check() / 2);
+			if (backstop > j)
+				mod_timer(&rsp->fqs_timer,
+					  rsp->jiffies_force_qs);
+			else
+				backstop = j;
 			ret = wait_event_interruptible_timeout(rsp->gp_wq,
 					((gf = ACCESS_ONCE(rsp->gp_flags)) &
 					 RCU_GP_FLAG_FQS) ||
 					(!ACCESS_ONCE(rnp->qsmask) &&
-					 !rcu_preempt_blocked_readers_cgp(rnp)),
-					j);
+					 !rcu_preempt_blocked_readers_cgp(rnp)) ||
+					ULONG_CMP_GE(jiffies,
+						     rsp->jiffies_force_qs),
+					backstop);
 			/* Locking provides needed memory barriers. */
 			/* If grace period done, leave loop. */
 			if (!ACCESS_ONCE(rnp->qsmask) &&
@@ -1843,6 +1871,8 @@ static int __noreturn rcu_gp_kthread(void *arg)
 						       ACCESS_ONCE(rsp->gpnum),
 						       TPS("fqsend"));
 				cond_resched_rcu_qs();
+				/* Arm the next forcing deadline. */
+				ret = 0;
 			} else {
 				/* Deal with stray signal. */
 				cond_resched_rcu_qs();
@@ -1862,6 +1892,7 @@ static int __noreturn rcu_gp_kthread(void *arg)
 		}
 
 		/* Handle grace-period end. */
+		del_timer(&rsp->fqs_timer);
 		rcu_gp_cleanup(rsp);
 	}
 }
@@ -3516,9 +3547,11 @@ static int __init rcu_spawn_gp_kthread(void)
 	struct task_struct *t;
 
 	rcu_scheduler_fully_active = 1;
+	rcu_init_nocb_affinity();
 	for_each_rcu_flavor(rsp) {
 		t = kthread_run(rcu_gp_kthread, rsp, "%s", rsp->name);
 		BUG_ON(IS_ERR(t));
+		rcu_nocb_affine_kthread(t);
 		rnp = rcu_get_root(rsp);
 		raw_spin_lock_irqsave(&rnp->lock, flags);
 		rsp->gp_kthread = t;
@@ -3650,6 +3683,8 @@ static void __init rcu_init_one(struct rcu_state *rsp,
 
 	rsp->rda = rda;
 	init_waitqueue_head(&rsp->gp_wq);
+	__setup_timer(&rsp->fqs_timer, rcu_gp_fqs_timer, (unsigned long)rsp,
+		      TIMER_DEFERRABLE);
 	rnp = rsp->level[rcu_num_lvls - 1];
 	for_each_possible_cpu(i) {
 		while (i > rnp->grphi)
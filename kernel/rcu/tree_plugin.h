@@ -44,6 +44,8 @@ static cpumask_var_t rcu_nocb_mask; /* CPUs to have callbacks offloaded. */
 static bool have_rcu_nocb_mask;	    /* Was rcu_nocb_mask allocated? */
 static bool __read_mostly rcu_nocb_poll;    /* Offload kthread are to poll. */
 static char __initdata nocb_buf[NR_CPUS * 5];
+static cpumask_var_t rcu_nocb_affinity;	    /* CPUs for the kthreads. */
+static bool have_rcu_nocb_affinity;	    /* rcu_nocb_affinity set? */
 #endif /* #ifdef CONFIG_RCU_NOCB_CPU */
 
 /*
@@ -2166,6 +2168,48 @@ static int __init parse_rcu_nocb_poll(char *arg)
 }
 early_param("rcu_nocb_poll", parse_rcu_nocb_poll);
 
+/* Parse the boot-time CPU list the rcuo kthreads are to run on. */
+static int __init rcu_nocb_affinity_setup(char *str)
+{
+	alloc_bootmem_cpumask_var(&rcu_nocb_affinity);
+	have_rcu_nocb_affinity = true;
+	cpulist_parse(str, rcu_nocb_affinity);
+	return 1;
+}
+__setup("rcu_nocb_affinity=", rcu_nocb_affinity_setup);
+
+/*
+ * Unless rcu_nocb_affinity= says otherwise, the rcuo and grace-period
+ * kthreads run on the cluster of CPU 0, the little cluster on
+ * big.LITTLE systems, so that callback floods queued by a busy big
+ * CPU are invoked on a little one.  This must run after the CPU
+ * topology is known.  Under nohz_full, housekeeping affinity is
+ * left as it is.
+ */
+static void __init rcu_init_nocb_affinity(void)
+{
+	int cpu, cluster = topology_physical_package_id(0);
+
+	if (have_rcu_nocb_affinity || tick_nohz_full_enabled())
+		return;
+	if (!zalloc_cpumask_var(&rcu_nocb_affinity, GFP_KERNEL))
+		return;
+
+	for_each_possible_cpu(cpu)
+		if (topology_physical_package_id(cpu) == cluster)
+			cpumask_set_cpu(cpu, rcu_nocb_affinity);
+	have_rcu_nocb_affinity = true;
+
+	cpulist_scnprintf(nocb_buf, sizeof(nocb_buf), rcu_nocb_affinity);
+	pr_info("\tRCU kthreads run on CPUs: %s.\n", nocb_buf);
+}
+
+static void rcu_nocb_affine_kthread(struct task_struct *t)
+{
+	if (have_rcu_nocb_affinity)
+		set_cpus_allowed_ptr(t, rcu_nocb_affinity);
+}
+
 /*
  * Wake up any no-CBs CPUs' kthreads that were waiting on the just-ended
  * grace period.
@@ -2755,6 +2799,7 @@ static void rcu_spawn_one_nocb_kthread(struct rcu_state *rsp, int cpu)
 	t = kthread_run(rcu_nocb_kthread, rdp_spawn,
 			"rcuo%c/%d", rsp->abbr, cpu);
 	BUG_ON(IS_ERR(t));
+	rcu_nocb_affine_kthread(t);
 	ACCESS_ONCE(rdp_spawn->nocb_kthread) = t;
 }
 
@@ -2892,6 +2937,14 @@ static void __init rcu_spawn_nocb_kthreads(void)
 {
 }
 
+static void __init rcu_init_nocb_affinity(void)
+{
+}
+
+static void rcu_nocb_affine_kthread(struct task_struct *t)
+{
+}
+
 static bool init_nocb_callback_list(struct rcu_data *rdp)
 {
 	return false;
@@ -96,6 +96,8 @@
 #define CREATE_TRACE_POINTS
 #include <trace/events/sched.h>
 
+EXPORT_TRACEPOINT_SYMBOL_GPL(sched_switch);
+
 
 const char *task_event_names[] = {"PUT_PREV_TASK", "PICK_NEXT_TASK",
 				  "TASK_WAKE", "TASK_MIGRATE", "TASK_UPDATE",
@@ -1590,7 +1592,7 @@ void check_for_freq_change(struct rq *rq)
 	trace_sched_freq_alert(cpu, rq->old_busy_time, rq->prev_runnable_sum);
 
 	atomic_notifier_call_chain(
-		&load_alert_notifier_head, 0,
+		&load_alert_notifier_head, LOAD_ALERT_FREQ_CHANGE,
 		(void *)(long)cpu);
 }
 
@@ -4263,7 +4265,7 @@ void scheduler_tick(void)
 
 	if (early_notif)
 		atomic_notifier_call_chain(&load_alert_notifier_head,
-					0, (void *)(long)cpu);
+			LOAD_ALERT_FREQ_CHANGE, (void *)(long)cpu);
 
 	perf_event_task_tick();
 
@@ -8711,13 +8713,32 @@ static int cpu_cgroup_can_attach(struct cgroup_subsys_state *css,
 	return 0;
 }
 
+/*
+ * A group timer slack overrides the task's own one while it is in the
+ * group, and the default is restored when the task leaves it.
+ */
+static void tg_apply_timer_slack(struct task_group *tg,
+				 struct task_struct *task)
+{
+	if (tg->timer_slack_ns)
+		task->timer_slack_ns = tg->timer_slack_ns;
+	else
+		task->timer_slack_ns = task->default_timer_slack_ns;
+}
+
 static void cpu_cgroup_attach(struct cgroup_subsys_state *css,
 			      struct cgroup_taskset *tset)
 {
+	struct task_group *tg = css_tg(css);
 	struct task_struct *task;
+	unsigned long old_slack;
 
-	cgroup_taskset_for_each(task, tset)
+	cgroup_taskset_for_each(task, tset) {
+		old_slack = task_group(task)->timer_slack_ns;
 		sched_move_task(task);
+		if (old_slack || tg->timer_slack_ns)
+			tg_apply_timer_slack(tg, task);
+	}
 }
 
 static void cpu_cgroup_exit(struct cgroup_subsys_state *css,
@@ -8748,6 +8769,62 @@ static int cpu_notify_on_migrate_write_u64(struct cgroup_subsys_state *css,
 	return 0;
 }
 
+static u64 cpu_memlat_background_read_u64(struct cgroup_subsys_state *css,
+					  struct cftype *cft)
+{
+	struct task_group *tg = css_tg(css);
+
+	return tg->memlat_background;
+}
+
+static int cpu_memlat_background_write_u64(struct cgroup_subsys_state *css,
+					   struct cftype *cft, u64 background)
+{
+	struct task_group *tg = css_tg(css);
+
+	tg->memlat_background = (background > 0);
+
+	return 0;
+}
+
+static u64 cpu_timer_slack_read_u64(struct cgroup_subsys_state *css,
+				    struct cftype *cft)
+{
+	struct task_group *tg = css_tg(css);
+
+	return tg->timer_slack_ns;
+}
+
+static int cpu_timer_slack_write_u64(struct cgroup_subsys_state *css,
+				     struct cftype *cft, u64 slack_ns)
+{
+	struct task_group *tg = css_tg(css);
+	struct css_task_iter it;
+	struct task_struct *task;
+
+	if (slack_ns > ULONG_MAX)
+		return -EINVAL;
+
+	tg->timer_slack_ns = slack_ns;
+
+	css_task_iter_start(css, &it);
+	while ((task = css_task_iter_next(&it)))
+		tg_apply_timer_slack(tg, task);
+	css_task_iter_end(&it);
+
+	return 0;
+}
+
+/*
+ * Tasks in a group marked memlat_background have their share of the
+ * memory latency votes discounted, see governor_memlat.
+ */
+bool sched_memlat_background(struct task_struct *p)
+{
+	return task_group(p)->memlat_background;
+}
+EXPORT_SYMBOL_GPL(sched_memlat_background);
+
 #ifdef CONFIG_SCHED_HMP
 
 static u64 cpu_upmigrate_discourage_read_u64(struct cgroup_subsys_state *css,
@@ -9046,6 +9123,16 @@ static struct cftype cpu_files[] = {
 		.read_u64 = cpu_notify_on_migrate_read_u64,
 		.write_u64 = cpu_notify_on_migrate_write_u64,
 	},
+	{
+		.name = "memlat_background",
+		.read_u64 = cpu_memlat_background_read_u64,
+		.write_u64 = cpu_memlat_background_write_u64,
+	},
+	{
+		.name = "timer_slack_ns",
+		.read_u64 = cpu_timer_slack_read_u64,
+		.write_u64 = cpu_timer_slack_write_u64,
+	},
 #ifdef CONFIG_SCHED_HMP
 	{
 		.name = "upmigrate_discourage",
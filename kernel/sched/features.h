@@ -86,4 +86,10 @@ SCHED_FEAT(NUMA_RESIST_LOWER, false)
 
 #ifdef CONFIG_SCHED_QHMP
 SCHED_FEAT(FORCE_CPU_THROTTLING_IMMINENT, false)
+
+/*
+ * Try a handful of candidate cpus on wakeup before scanning every cpu
+ * in select_best_cpu().
+ */
+SCHED_FEAT(HMP_WAKE_FAST_PATH, true)
 #endif
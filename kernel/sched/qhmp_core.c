@@ -92,6 +92,8 @@
 #define CREATE_TRACE_POINTS
 #include <trace/events/sched.h>
 
+EXPORT_TRACEPOINT_SYMBOL_GPL(sched_switch);
+
 const char *task_event_names[] = {"PUT_PREV_TASK", "PICK_NEXT_TASK",
 				  "TASK_WAKE", "TASK_MIGRATE", "TASK_UPDATE",
 				"IRQ_UPDATE"};
@@ -893,6 +895,7 @@ static void enqueue_task(struct rq *rq, struct task_struct *p, int flags)
 {
 	update_rq_clock(rq);
 	sched_info_queued(rq, p);
+	inc_freq_floor(rq, p);
 	p->sched_class->enqueue_task(rq, p, flags);
 	trace_sched_enq_deq_task(p, 1, cpumask_bits(&p->cpus_allowed)[0]);
 }
@@ -901,6 +904,7 @@ static void dequeue_task(struct rq *rq, struct task_struct *p, int flags)
 {
 	update_rq_clock(rq);
 	sched_info_dequeued(rq, p);
+	dec_freq_floor(rq, p);
 	p->sched_class->dequeue_task(rq, p, flags);
 	trace_sched_enq_deq_task(p, 0, cpumask_bits(&p->cpus_allowed)[0]);
 }
@@ -1152,6 +1156,145 @@ void boost_kick(int cpu)
 		smp_send_reschedule(cpu);
 }
 
+struct cpumask __cpu_isolated_mask __read_mostly;
+static DEFINE_MUTEX(isolation_mutex);
+
+/*
+ * Stop placing work on @cpu without taking it offline. Queued tasks are
+ * pulled away by the other cpus' load balancing and the running task is
+ * pushed off right away through the boost kick, so bringing the cpu back
+ * with sched_unisolate_cpu() is only a mask update.
+ */
+int sched_isolate_cpu(int cpu)
+{
+	cpumask_t avail;
+	int ret = 0;
+
+	if (!sched_enable_hmp || cpu < 0 || cpu >= nr_cpu_ids)
+		return -EINVAL;
+
+	mutex_lock(&isolation_mutex);
+	get_online_cpus();
+
+	cpumask_andnot(&avail, cpu_online_mask, cpu_isolated_mask);
+	cpumask_clear_cpu(cpu, &avail);
+	if (!cpu_online(cpu) || cpumask_empty(&avail)) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	irq_balance_isolate_cpu(cpu);
+	cpumask_set_cpu(cpu, &__cpu_isolated_mask);
+	boost_kick(cpu);
+out:
+	put_online_cpus();
+	mutex_unlock(&isolation_mutex);
+	return ret;
+}
+
+int sched_unisolate_cpu(int cpu)
+{
+	if (cpu < 0 || cpu >= nr_cpu_ids)
+		return -EINVAL;
+
+	mutex_lock(&isolation_mutex);
+	cpumask_clear_cpu(cpu, &__cpu_isolated_mask);
+	irq_balance_unisolate_cpu(cpu);
+	mutex_unlock(&isolation_mutex);
+
+	return 0;
+}
+
+/*
+ * Ask for the cluster a task runs on to stay at or above @freq (kHz)
+ * while the task is runnable there. The floor is reported to governors
+ * through sched_get_cpus_busy() and is released as soon as the task
+ * sleeps. A @freq of 0 removes the floor.
+ */
+int sched_set_freq_floor(struct task_struct *p, unsigned int freq)
+{
+	unsigned long flags;
+	struct rq *rq;
+
+	if (!sched_enable_hmp)
+		return -EINVAL;
+
+	rq = task_rq_lock(p, &flags);
+	if (p->on_rq == TASK_ON_RQ_QUEUED) {
+		dec_freq_floor(rq, p);
+		p->freq_floor = freq;
+		inc_freq_floor(rq, p);
+	} else {
+		p->freq_floor = freq;
+	}
+	task_rq_unlock(rq, p, &flags);
+
+	return 0;
+}
+
+unsigned int sched_get_freq_floor(struct task_struct *p)
+{
+	return p->freq_floor;
+}
+
+/*
+ * Migrations that crossed a frequency domain, counted on both ends.
+ * set_task_cpu() can run without the destination rq lock, hence atomics.
+ */
+struct cluster_migration_stats {
+	atomic_long_t in;
+	atomic_long_t out;
+};
+
+static DEFINE_PER_CPU(struct cluster_migration_stats, cluster_migrations);
+
+static inline void note_cluster_migration(int src_cpu, int dst_cpu)
+{
+	if (same_freq_domain(src_cpu, dst_cpu))
+		return;
+
+	atomic_long_inc(&per_cpu(cluster_migrations, src_cpu).out);
+	atomic_long_inc(&per_cpu(cluster_migrations, dst_cpu).in);
+}
+
+static int sched_cluster_migrations_show(struct seq_file *m, void *v)
+{
+	int cpu;
+
+	seq_puts(m, "cpu in out\n");
+	for_each_possible_cpu(cpu) {
+		struct cluster_migration_stats *stats =
+					&per_cpu(cluster_migrations, cpu);
+
+		seq_printf(m, "%d %ld %ld\n", cpu,
+			   atomic_long_read(&stats->in),
+			   atomic_long_read(&stats->out));
+	}
+
+	return 0;
+}
+
+static int sched_cluster_migrations_open(struct inode *inode,
+					 struct file *file)
+{
+	return single_open(file, sched_cluster_migrations_show, NULL);
+}
+
+static const struct file_operations sched_cluster_migrations_fops = {
+	.open		= sched_cluster_migrations_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init sched_cluster_migrations_init(void)
+{
+	proc_create("sched_cluster_migrations", 0444, NULL,
+		    &sched_cluster_migrations_fops);
+	return 0;
+}
+late_initcall(sched_cluster_migrations_init);
+
 /* Clear any HMP scheduler related requests pending from or on cpu */
 static inline void clear_hmp_request(int cpu)
 {
@@ -1177,6 +1320,7 @@ int sched_set_static_cpu_pwr_cost(int cpu, unsigned int cost)
 	struct rq *rq = cpu_rq(cpu);
 
 	rq->static_cpu_pwr_cost = cost;
+	update_cluster_energy(cpumask_of(cpu));
 	return 0;
 }
 
@@ -1190,6 +1334,7 @@ int sched_set_static_cluster_pwr_cost(int cpu, unsigned int cost)
 	struct rq *rq = cpu_rq(cpu);
 
 	rq->static_cluster_pwr_cost = cost;
+	update_cluster_energy(cpumask_of(cpu));
 	return 0;
 }
 
@@ -1209,6 +1354,8 @@ static inline void clear_boost_kick(int cpu) { }
 
 static inline void clear_hmp_request(int cpu) { }
 
+static inline void note_cluster_migration(int src_cpu, int dst_cpu) { }
+
 #endif	/* CONFIG_SCHED_HMP */
 
 #if defined(CONFIG_SCHED_HMP)
@@ -1465,7 +1612,7 @@ void check_for_freq_change(struct rq *rq)
 	trace_sched_freq_alert(cpu, rq->old_busy_time, rq->prev_runnable_sum);
 
 	atomic_notifier_call_chain(
-		&load_alert_notifier_head, 0,
+		&load_alert_notifier_head, LOAD_ALERT_FREQ_CHANGE,
 		(void *)(long)cpu);
 }
 
@@ -2094,6 +2241,8 @@ void sched_exit(struct task_struct *p)
 	struct rq *rq = cpu_rq(cpu);
 	u64 wallclock;
 
+	sched_set_group_id(p, 0);
+
 	raw_spin_lock_irqsave(&rq->lock, flags);
 	/* rq->curr == p */
 	wallclock = sched_ktime_clock();
@@ -2253,10 +2402,12 @@ void sched_get_cpus_busy(struct sched_load *busy,
 	struct rq *rq;
 	const int cpus = cpumask_weight(query_cpus);
 	u64 load[cpus];
-	unsigned int cur_freq[cpus], max_freq[cpus];
+	unsigned int cur_freq[cpus], max_freq[cpus], min_freq[cpus];
 	int notifier_sent[cpus];
 	int cpu, i = 0;
 	unsigned int window_size;
+	struct related_thread_group *grp;
+	int freq_boost = sched_boost_type_active(SCHED_BOOST_FREQ);
 
 	if (unlikely(cpus == 0))
 		return;
@@ -2278,6 +2429,16 @@ void sched_get_cpus_busy(struct sched_load *busy,
 		update_task_ravg(rq->curr, rq, TASK_UPDATE,
 				 sched_ktime_clock(), 0);
 		load[i] = rq->old_busy_time = rq->prev_runnable_sum;
+		/*
+		 * A frame's worth of work is split across the members of a
+		 * related thread group; report at least the combined group
+		 * demand for the cpu running one of them so the governor
+		 * does not undershoot each time the work bounces between
+		 * threads. p->grp is stable while rq->lock is held.
+		 */
+		grp = rq->curr->grp;
+		if (grp && sysctl_sched_enable_colocation)
+			load[i] = max_t(u64, load[i], grp->demand);
 		/*
 		 * Scale load in reference to rq->max_possible_freq.
 		 *
@@ -2290,6 +2451,7 @@ void sched_get_cpus_busy(struct sched_load *busy,
 		rq->notifier_sent = 0;
 		cur_freq[i] = rq->cur_freq;
 		max_freq[i] = rq->max_freq;
+		min_freq[i] = rq->freq_floor;
 		i++;
 	}
 
@@ -2313,8 +2475,15 @@ void sched_get_cpus_busy(struct sched_load *busy,
 						     rq->max_possible_freq);
 		}
 
+		/* A frequency boost reports the cpu as busy at max_freq */
+		if (freq_boost)
+			load[i] = max_t(u64, load[i],
+					scale_load_to_freq(window_size,
+					max_freq[i], rq->max_possible_freq));
+
 		busy[i].prev_load = div64_u64(load[i], NSEC_PER_USEC);
 		busy[i].new_task_load = 0;
+		busy[i].min_freq = min_freq[i];
 
 		trace_sched_get_busy(cpu, busy[i].prev_load);
 		i++;
@@ -2669,6 +2838,7 @@ static int cpufreq_notifier_policy(struct notifier_block *nb,
 	__update_min_max_capacity();
 	check_for_up_down_migrate_update(policy->related_cpus);
 	post_big_small_task_count_change(cpu_possible_mask);
+	update_cluster_energy(cpus);
 
 	return 0;
 }
@@ -2754,6 +2924,237 @@ static inline void note_run_start(struct task_struct *p, u64 wallclock)
 	p->run_start = wallclock;
 }
 
+unsigned int __read_mostly sysctl_sched_enable_colocation = 1;
+
+static LIST_HEAD(related_thread_groups);
+static DEFINE_RWLOCK(related_thread_group_lock);
+static int nr_related_thread_groups;
+
+/*
+ * Can a cpu of this capacity absorb the combined demand of the group? The
+ * group is allowed to stay on a lower capacity class until its demand drops
+ * below the downmigrate threshold, the same hysteresis used for single tasks.
+ */
+static int group_will_fit(int cpu, struct related_thread_group *grp,
+			  u64 demand)
+{
+	struct rq *rq = cpu_rq(cpu);
+	unsigned int threshold = sched_upmigrate;
+
+	if (rq->capacity == max_capacity)
+		return 1;
+
+	if (rq->capacity < grp->preferred_capacity)
+		threshold = sched_downmigrate;
+
+	return scale_load_to_cpu(demand, cpu) < threshold;
+}
+
+static int
+best_capacity(struct related_thread_group *grp, u64 total_demand)
+{
+	int cpu, best = max_capacity;
+
+	for_each_online_cpu(cpu) {
+		struct rq *rq = cpu_rq(cpu);
+
+		if (rq->capacity < best &&
+		    group_will_fit(cpu, grp, total_demand))
+			best = rq->capacity;
+	}
+
+	return best;
+}
+
+static void _set_preferred_capacity(struct related_thread_group *grp)
+{
+	struct task_struct *p;
+	u64 combined_demand = 0;
+
+	if (!sysctl_sched_enable_colocation) {
+		grp->last_update = sched_ktime_clock();
+		grp->preferred_capacity = 0;
+		grp->demand = 0;
+		return;
+	}
+
+	if (sched_ktime_clock() - grp->last_update < sched_ravg_window / 10)
+		return;
+
+	list_for_each_entry(p, &grp->tasks, grp_list)
+		combined_demand += p->ravg.demand;
+
+	grp->demand = combined_demand;
+	grp->preferred_capacity = best_capacity(grp, combined_demand);
+	grp->last_update = sched_ktime_clock();
+}
+
+static void set_preferred_capacity(struct related_thread_group *grp)
+{
+	raw_spin_lock(&grp->lock);
+	_set_preferred_capacity(grp);
+	raw_spin_unlock(&grp->lock);
+}
+
+static inline int update_preferred_capacity(struct related_thread_group *grp,
+		struct task_struct *p, u32 old_load)
+{
+	u32 new_load = task_demand(p);
+
+	if (!grp)
+		return 0;
+
+	if (abs(new_load - old_load) > sched_ravg_window / 4 ||
+		sched_ktime_clock() - grp->last_update > sched_ravg_window)
+		return 1;
+
+	return 0;
+}
+
+static struct related_thread_group *alloc_related_thread_group(int group_id)
+{
+	struct related_thread_group *grp;
+
+	grp = kzalloc(sizeof(*grp), GFP_KERNEL);
+	if (!grp)
+		return ERR_PTR(-ENOMEM);
+
+	grp->id = group_id;
+	INIT_LIST_HEAD(&grp->tasks);
+	INIT_LIST_HEAD(&grp->list);
+	raw_spin_lock_init(&grp->lock);
+
+	return grp;
+}
+
+static struct related_thread_group *
+lookup_related_thread_group(unsigned int group_id)
+{
+	struct related_thread_group *grp;
+
+	list_for_each_entry(grp, &related_thread_groups, list) {
+		if (grp->id == group_id)
+			return grp;
+	}
+
+	return NULL;
+}
+
+static void remove_task_from_group(struct task_struct *p)
+{
+	struct related_thread_group *grp = p->grp;
+	struct rq *rq;
+	int empty_group = 1;
+
+	raw_spin_lock(&grp->lock);
+
+	rq = __task_rq_lock(p);
+	list_del_init(&p->grp_list);
+	p->grp = NULL;
+	__task_rq_unlock(rq);
+
+	if (!list_empty(&grp->tasks)) {
+		empty_group = 0;
+		_set_preferred_capacity(grp);
+	}
+
+	raw_spin_unlock(&grp->lock);
+
+	if (empty_group) {
+		list_del(&grp->list);
+		nr_related_thread_groups--;
+		/* task_preferred_capacity() may still be looking at it */
+		kfree_rcu(grp, rcu);
+	}
+}
+
+static int
+add_task_to_group(struct task_struct *p, struct related_thread_group *grp)
+{
+	struct rq *rq;
+
+	raw_spin_lock(&grp->lock);
+
+	rq = __task_rq_lock(p);
+	p->grp = grp;
+	list_add(&p->grp_list, &grp->tasks);
+	__task_rq_unlock(rq);
+
+	_set_preferred_capacity(grp);
+
+	raw_spin_unlock(&grp->lock);
+
+	return 0;
+}
+
+int sched_set_group_id(struct task_struct *p, unsigned int group_id)
+{
+	int rc = 0, destroy = 0;
+	unsigned long flags;
+	struct related_thread_group *grp = NULL, *new = NULL;
+
+redo:
+	raw_spin_lock_irqsave(&p->pi_lock, flags);
+
+	if ((current != p && p->flags & PF_EXITING) ||
+			(!p->grp && !group_id) ||
+			(p->grp && p->grp->id == group_id))
+		goto done;
+
+	write_lock(&related_thread_group_lock);
+
+	if (!group_id) {
+		remove_task_from_group(p);
+		write_unlock(&related_thread_group_lock);
+		goto done;
+	}
+
+	if (p->grp && p->grp->id != group_id)
+		remove_task_from_group(p);
+
+	grp = lookup_related_thread_group(group_id);
+	if (!grp && !new) {
+		/* New group */
+		write_unlock(&related_thread_group_lock);
+		raw_spin_unlock_irqrestore(&p->pi_lock, flags);
+		new = alloc_related_thread_group(group_id);
+		if (IS_ERR(new))
+			return -ENOMEM;
+		destroy = 1;
+		/* Rerun checks (like task exiting), since we dropped pi_lock */
+		goto redo;
+	} else if (!grp && new) {
+		/* New group - use object allocated before */
+		destroy = 0;
+		nr_related_thread_groups++;
+		list_add(&new->list, &related_thread_groups);
+		grp = new;
+	}
+
+	BUG_ON(!grp);
+	rc = add_task_to_group(p, grp);
+	write_unlock(&related_thread_group_lock);
+done:
+	raw_spin_unlock_irqrestore(&p->pi_lock, flags);
+
+	if (destroy)
+		kfree(new);
+
+	return rc;
+}
+
+unsigned int sched_get_group_id(struct task_struct *p)
+{
+	unsigned long flags;
+	unsigned int group_id;
+
+	raw_spin_lock_irqsave(&p->pi_lock, flags);
+	group_id = p->grp ? p->grp->id : 0;
+	raw_spin_unlock_irqrestore(&p->pi_lock, flags);
+
+	return group_id;
+}
+
 #else	/* CONFIG_SCHED_HMP */
 
 u64 sched_ktime_clock(void)
@@ -2792,6 +3193,14 @@ restore_orig_mark_start(struct task_struct *p, u64 mark_start)
 
 static inline void note_run_start(struct task_struct *p, u64 wallclock) { }
 
+static inline void set_preferred_capacity(struct related_thread_group *grp) { }
+
+static inline int update_preferred_capacity(struct related_thread_group *grp,
+		struct task_struct *p, u32 old_load)
+{
+	return 0;
+}
+
 #endif	/* CONFIG_SCHED_HMP */
 
 #ifdef CONFIG_SMP
@@ -2831,6 +3240,7 @@ void set_task_cpu(struct task_struct *p, unsigned int new_cpu)
 		p->se.nr_migrations++;
 		perf_sw_event(PERF_COUNT_SW_CPU_MIGRATIONS, 1, NULL, 0);
 
+		note_cluster_migration(task_cpu(p), new_cpu);
 		fixup_busy_time(p, new_cpu);
 	}
 
@@ -3457,8 +3867,10 @@ try_to_wake_up(struct task_struct *p, unsigned int state, int wake_flags)
 	struct migration_notify_data mnd;
 	int heavy_task = 0;
 #ifdef CONFIG_SMP
+	unsigned int old_load;
 	struct rq *rq;
 	u64 wallclock;
+	struct related_thread_group *grp = NULL;
 #endif
 	bool freq_notif_allowed = !(wake_flags & WF_NO_NOTIFIER);
 
@@ -3497,12 +3909,17 @@ try_to_wake_up(struct task_struct *p, unsigned int state, int wake_flags)
 	rq = cpu_rq(task_cpu(p));
 
 	raw_spin_lock(&rq->lock);
+	old_load = task_demand(p);
+	grp = task_related_thread_group(p);
 	wallclock = sched_ktime_clock();
 	update_task_ravg(rq->curr, rq, TASK_UPDATE, wallclock, 0);
 	heavy_task = heavy_task_wakeup(p, rq, TASK_WAKE);
 	update_task_ravg(p, rq, TASK_WAKE, wallclock, 0);
 	raw_spin_unlock(&rq->lock);
 
+	if (update_preferred_capacity(grp, p, old_load))
+		set_preferred_capacity(grp);
+
 	p->sched_contributes_to_load = !!task_contributes_to_load(p);
 	p->state = TASK_WAKING;
 
@@ -3553,7 +3970,8 @@ out:
 		if (!same_freq_domain(src_cpu, cpu)) {
 			check_for_freq_change(cpu_rq(cpu));
 			check_for_freq_change(cpu_rq(src_cpu));
-		} else if (heavy_task) {
+		} else if (heavy_task ||
+			   p->freq_floor > cpu_rq(cpu)->cur_freq) {
 			check_for_freq_change(cpu_rq(cpu));
 		}
 	}
@@ -4392,17 +4810,30 @@ void scheduler_tick(void)
 	int cpu = smp_processor_id();
 	struct rq *rq = cpu_rq(cpu);
 	struct task_struct *curr = rq->curr;
+	struct related_thread_group *grp;
+	u32 old_load;
+	bool window_alert;
 
 	sched_clock_tick();
 
 	raw_spin_lock(&rq->lock);
+	old_load = task_demand(curr);
+	grp = task_related_thread_group(curr);
 	set_window_start(rq);
 	update_rq_clock(rq);
 	curr->sched_class->task_tick(rq, curr, 0);
 	update_cpu_load_active(rq);
 	update_task_ravg(rq->curr, rq, TASK_UPDATE, sched_ktime_clock(), 0);
+	window_alert = window_rollover_alert(rq);
 	raw_spin_unlock(&rq->lock);
 
+	if (window_alert)
+		atomic_notifier_call_chain(&load_alert_notifier_head,
+				LOAD_ALERT_WINDOW_ROLLOVER, (void *)(long)cpu);
+
+	if (update_preferred_capacity(grp, curr, old_load))
+		set_preferred_capacity(grp);
+
 	perf_event_task_tick();
 
 #ifdef CONFIG_SMP
@@ -9873,13 +10304,32 @@ static int cpu_cgroup_can_attach(struct cgroup_subsys_state *css,
 	return 0;
 }
 
+/*
+ * A group timer slack overrides the task's own one while it is in the
+ * group, and the default is restored when the task leaves it.
+ */
+static void tg_apply_timer_slack(struct task_group *tg,
+				 struct task_struct *task)
+{
+	if (tg->timer_slack_ns)
+		task->timer_slack_ns = tg->timer_slack_ns;
+	else
+		task->timer_slack_ns = task->default_timer_slack_ns;
+}
+
 static void cpu_cgroup_attach(struct cgroup_subsys_state *css,
 			      struct cgroup_taskset *tset)
 {
+	struct task_group *tg = css_tg(css);
 	struct task_struct *task;
+	unsigned long old_slack;
 
-	cgroup_taskset_for_each(task, tset)
+	cgroup_taskset_for_each(task, tset) {
+		old_slack = task_group(task)->timer_slack_ns;
 		sched_move_task(task);
+		if (old_slack || tg->timer_slack_ns)
+			tg_apply_timer_slack(tg, task);
+	}
 }
 
 static void cpu_cgroup_exit(struct cgroup_subsys_state *css,
@@ -9915,6 +10365,62 @@ static int cpu_notify_on_migrate_write_u64(struct cgroup_subsys_state *css,
 	return 0;
 }
 
+static u64 cpu_memlat_background_read_u64(struct cgroup_subsys_state *css,
+					  struct cftype *cft)
+{
+	struct task_group *tg = css_tg(css);
+
+	return tg->memlat_background;
+}
+
+static int cpu_memlat_background_write_u64(struct cgroup_subsys_state *css,
+					   struct cftype *cft, u64 background)
+{
+	struct task_group *tg = css_tg(css);
+
+	tg->memlat_background = (background > 0);
+
+	return 0;
+}
+
+static u64 cpu_timer_slack_read_u64(struct cgroup_subsys_state *css,
+				    struct cftype *cft)
+{
+	struct task_group *tg = css_tg(css);
+
+	return tg->timer_slack_ns;
+}
+
+static int cpu_timer_slack_write_u64(struct cgroup_subsys_state *css,
+				     struct cftype *cft, u64 slack_ns)
+{
+	struct task_group *tg = css_tg(css);
+	struct css_task_iter it;
+	struct task_struct *task;
+
+	if (slack_ns > ULONG_MAX)
+		return -EINVAL;
+
+	tg->timer_slack_ns = slack_ns;
+
+	css_task_iter_start(css, &it);
+	while ((task = css_task_iter_next(&it)))
+		tg_apply_timer_slack(tg, task);
+	css_task_iter_end(&it);
+
+	return 0;
+}
+
+/*
+ * Tasks in a group marked memlat_background have their share of the
+ * memory latency votes discounted, see governor_memlat.
+ */
+bool sched_memlat_background(struct task_struct *p)
+{
+	return task_group(p)->memlat_background;
+}
+EXPORT_SYMBOL_GPL(sched_memlat_background);
+
 #ifdef CONFIG_SCHED_HMP
 
 static u64 cpu_upmigrate_discourage_read_u64(struct cgroup_subsys_state *css,
@@ -10246,6 +10752,16 @@ static struct cftype cpu_files[] = {
 		.read_u64 = cpu_notify_on_migrate_read_u64,
 		.write_u64 = cpu_notify_on_migrate_write_u64,
 	},
+	{
+		.name = "memlat_background",
+		.read_u64 = cpu_memlat_background_read_u64,
+		.write_u64 = cpu_memlat_background_write_u64,
+	},
+	{
+		.name = "timer_slack_ns",
+		.read_u64 = cpu_timer_slack_read_u64,
+		.write_u64 = cpu_timer_slack_write_u64,
+	},
 #ifdef CONFIG_SCHED_HMP
 	{
 		.name = "upmigrate_discourage",
@@ -31,6 +31,8 @@
 #include <linux/migrate.h>
 #include <linux/task_work.h>
 #include <linux/ratelimit.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
 
 #include <trace/events/sched.h>
 
@@ -2816,6 +2818,28 @@ static int mostly_idle_cpu_sync(int cpu, u64 load, int sync)
 		nr_running <= rq->mostly_idle_nr_run;
 }
 
+/*
+ * Boost requests are named votes. Each voter holds a refcount, a boost
+ * type mask and an optional expiry, so that a daemon which forgets to
+ * drop its vote cannot keep the system boosted forever. The effective
+ * boost is the union of the types of all voters holding a reference.
+ */
+#define SCHED_BOOST_MAX_VOTERS	32
+
+struct sched_boost_voter {
+	struct list_head list;
+	char name[SCHED_BOOST_NAME_LEN];
+	unsigned int type;
+	int refcount;
+	unsigned long expires;
+	u64 active_since;
+	u64 time_on;
+	struct delayed_work expire_work;
+};
+
+static LIST_HEAD(boost_voters);
+static int nr_boost_voters;
+static unsigned int boost_types;
 static int boost_refcount;
 static DEFINE_SPINLOCK(boost_lock);
 static DEFINE_MUTEX(boost_mutex);
@@ -2832,42 +2856,174 @@ static void boost_kick_cpus(void)
 
 int sched_boost(void)
 {
-	return boost_refcount > 0;
+	return boost_types & SCHED_BOOST_PLACEMENT;
 }
 
-int sched_set_boost(int enable)
+int sched_boost_type_active(unsigned int type)
+{
+	return boost_types & type;
+}
+
+/* Called with boost_lock held */
+static void update_boost_types(void)
 {
+	struct sched_boost_voter *v;
+	unsigned int old_types = boost_types, types = 0;
+	int refcount = 0;
+
+	list_for_each_entry(v, &boost_voters, list) {
+		if (!v->refcount)
+			continue;
+		types |= v->type;
+		refcount += v->refcount;
+	}
+
+	boost_types = types;
+	boost_refcount = refcount;
+
+	if (!(old_types & SCHED_BOOST_PLACEMENT) &&
+	    (types & SCHED_BOOST_PLACEMENT))
+		boost_kick_cpus();
+
+	trace_sched_set_boost(boost_refcount);
+}
+
+/* Called with boost_lock held */
+static void boost_voter_release(struct sched_boost_voter *v)
+{
+	v->time_on += ktime_get_ns() - v->active_since;
+	v->refcount = 0;
+	v->expires = 0;
+}
+
+static void boost_expire_work(struct work_struct *work)
+{
+	struct sched_boost_voter *v = container_of(to_delayed_work(work),
+					struct sched_boost_voter, expire_work);
+	unsigned long flags;
+
+	spin_lock_irqsave(&boost_lock, flags);
+	if (v->refcount && v->expires && time_after_eq(jiffies, v->expires)) {
+		boost_voter_release(v);
+		update_boost_types();
+	}
+	spin_unlock_irqrestore(&boost_lock, flags);
+}
+
+/* Called with boost_lock held */
+static struct sched_boost_voter *find_boost_voter(const char *name, int alloc)
+{
+	struct sched_boost_voter *v;
+
+	list_for_each_entry(v, &boost_voters, list) {
+		if (!strncmp(v->name, name, SCHED_BOOST_NAME_LEN))
+			return v;
+	}
+
+	if (!alloc || nr_boost_voters >= SCHED_BOOST_MAX_VOTERS)
+		return NULL;
+
+	v = kzalloc(sizeof(*v), GFP_ATOMIC);
+	if (!v)
+		return NULL;
+
+	strlcpy(v->name, name, SCHED_BOOST_NAME_LEN);
+	INIT_DELAYED_WORK(&v->expire_work, boost_expire_work);
+	list_add_tail(&v->list, &boost_voters);
+	nr_boost_voters++;
+
+	return v;
+}
+
+/*
+ * Take a boost reference on behalf of @name. @type is a mask of
+ * SCHED_BOOST_* types and replaces the voter's previous type. A non-zero
+ * @timeout_ms drops all of the voter's references once it elapses; a zero
+ * timeout keeps the vote until it is explicitly released.
+ */
+int sched_boost_vote(const char *name, unsigned int type,
+		     unsigned int timeout_ms)
+{
+	struct sched_boost_voter *v;
 	unsigned long flags;
 	int ret = 0;
-	int old_refcount;
 
 	if (!sched_enable_hmp)
 		return -EINVAL;
 
+	if (!type || (type & ~SCHED_BOOST_ALL))
+		return -EINVAL;
+
 	spin_lock_irqsave(&boost_lock, flags);
 
-	old_refcount = boost_refcount;
+	v = find_boost_voter(name, 1);
+	if (!v) {
+		ret = -ENOMEM;
+		goto out;
+	}
 
-	if (enable == 1) {
-		boost_refcount++;
-	} else if (!enable) {
-		if (boost_refcount >= 1)
-			boost_refcount--;
-		else
-			ret = -EINVAL;
+	if (!v->refcount)
+		v->active_since = ktime_get_ns();
+	v->refcount++;
+	v->type = type;
+
+	if (timeout_ms) {
+		v->expires = jiffies + msecs_to_jiffies(timeout_ms);
+		mod_delayed_work(system_wq, &v->expire_work,
+				 msecs_to_jiffies(timeout_ms));
 	} else {
+		v->expires = 0;
+	}
+
+	update_boost_types();
+out:
+	spin_unlock_irqrestore(&boost_lock, flags);
+
+	return ret;
+}
+
+/* Drop one boost reference held by @name */
+int sched_boost_unvote(const char *name)
+{
+	struct sched_boost_voter *v;
+	unsigned long flags;
+	int ret = 0;
+
+	if (!sched_enable_hmp)
+		return -EINVAL;
+
+	spin_lock_irqsave(&boost_lock, flags);
+
+	v = find_boost_voter(name, 0);
+	if (!v || !v->refcount) {
 		ret = -EINVAL;
+		goto out;
 	}
 
-	if (!old_refcount && boost_refcount)
-		boost_kick_cpus();
+	if (v->refcount == 1) {
+		boost_voter_release(v);
+		cancel_delayed_work(&v->expire_work);
+	} else {
+		v->refcount--;
+	}
 
-	trace_sched_set_boost(boost_refcount);
+	update_boost_types();
+out:
 	spin_unlock_irqrestore(&boost_lock, flags);
 
 	return ret;
 }
 
+int sched_set_boost(int enable)
+{
+	if (enable == 1)
+		return sched_boost_vote("kernel", SCHED_BOOST_PLACEMENT, 0);
+	else if (!enable)
+		return sched_boost_unvote("kernel");
+
+	return -EINVAL;
+}
+
 int sched_boost_handler(struct ctl_table *table, int write,
 		void __user *buffer, size_t *lenp,
 		loff_t *ppos)
@@ -2882,14 +3038,104 @@ int sched_boost_handler(struct ctl_table *table, int write,
 	if (ret || !write)
 		goto done;
 
-	ret = (sysctl_sched_boost <= 1) ?
-		sched_set_boost(sysctl_sched_boost) : -EINVAL;
+	if (sysctl_sched_boost == 1)
+		ret = sched_boost_vote("sysctl", SCHED_BOOST_PLACEMENT, 0);
+	else if (!sysctl_sched_boost)
+		ret = sched_boost_unvote("sysctl");
+	else
+		ret = -EINVAL;
 
 done:
 	mutex_unlock(&boost_mutex);
 	return ret;
 }
 
+/*
+ * /proc/sched_boost lists every voter with its type mask, current
+ * refcount, milliseconds left before expiry and total time spent
+ * boosted. Writing "<name> <type> [timeout_ms]" takes a reference and
+ * "<name> 0" drops one.
+ */
+static int sched_boost_show(struct seq_file *m, void *v)
+{
+	struct sched_boost_voter *voter;
+	unsigned long flags;
+	u64 now = ktime_get_ns();
+
+	seq_printf(m, "active: %#x\n", boost_types);
+	seq_puts(m, "name type refcount expires_ms time_on_ms\n");
+
+	spin_lock_irqsave(&boost_lock, flags);
+	list_for_each_entry(voter, &boost_voters, list) {
+		u64 time_on = voter->time_on;
+		unsigned int expires_ms = 0;
+
+		if (voter->refcount) {
+			time_on += now - voter->active_since;
+			if (voter->expires &&
+			    time_after(voter->expires, jiffies))
+				expires_ms = jiffies_to_msecs(voter->expires -
+							      jiffies);
+		}
+
+		seq_printf(m, "%s %#x %d %u %llu\n", voter->name, voter->type,
+			   voter->refcount, expires_ms,
+			   div64_u64(time_on, NSEC_PER_MSEC));
+	}
+	spin_unlock_irqrestore(&boost_lock, flags);
+
+	return 0;
+}
+
+static ssize_t sched_boost_write(struct file *file, const char __user *ubuf,
+				 size_t count, loff_t *ppos)
+{
+	char buf[SCHED_BOOST_NAME_LEN + 32];
+	char name[SCHED_BOOST_NAME_LEN];
+	unsigned int type, timeout_ms = 0;
+	int ret;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	ret = sscanf(buf, "%15s %x %u", name, &type, &timeout_ms);
+	if (ret < 2)
+		return -EINVAL;
+
+	mutex_lock(&boost_mutex);
+	if (type)
+		ret = sched_boost_vote(name, type, timeout_ms);
+	else
+		ret = sched_boost_unvote(name);
+	mutex_unlock(&boost_mutex);
+
+	return ret ? ret : count;
+}
+
+static int sched_boost_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, sched_boost_show, NULL);
+}
+
+static const struct file_operations sched_boost_fops = {
+	.open		= sched_boost_open,
+	.read		= seq_read,
+	.write		= sched_boost_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init sched_boost_proc_init(void)
+{
+	proc_create("sched_boost", 0644, NULL, &sched_boost_fops);
+	return 0;
+}
+late_initcall(sched_boost_proc_init);
+
 /*
  * Task will fit on a cpu if it's bandwidth consumption on that cpu
  * will be less than sched_upmigrate. A big task that was previously
@@ -2916,8 +3162,13 @@ static int task_load_will_fit(struct task_struct *p, u64 task_load, int cpu)
 		if (nice > sched_upmigrate_min_nice || upmigrate_discouraged(p))
 			return 1;
 
+		/*
+		 * A migration boost lets tasks up-migrate as soon as they
+		 * cross the down-migrate threshold.
+		 */
 		upmigrate = sched_upmigrate;
-		if (prev_rq->capacity > rq->capacity)
+		if (prev_rq->capacity > rq->capacity ||
+		    sched_boost_type_active(SCHED_BOOST_MIGRATION))
 			upmigrate = sched_downmigrate;
 
 		if (task_load < upmigrate)
@@ -3029,6 +3280,181 @@ unsigned int power_cost(u64 task_load, int cpu)
 	return power_cost_at_freq(cpu, task_freq) + total_static_pwr_cost;
 }
 
+/*
+ * Energy model cached per cluster for wakeup placement: the power table
+ * of the cluster's OPPs and the static cost of leaving an idle state.
+ * Current capacity already lives in the rq. Each cpu keeps its own copy of its cluster's entry so the wakeup
+ * path stays on local cache lines. The power table is referenced rather
+ * than copied because the platform rewrites its values in place as the
+ * temperature changes.
+ */
+struct cluster_energy {
+	int max_possible_capacity;
+	struct cpu_pstate_pwr *ptable;
+	unsigned int cpu_exit_cost;
+	unsigned int cluster_exit_cost;
+};
+
+static DEFINE_PER_CPU(struct cluster_energy, cluster_energy);
+
+void update_cluster_energy(const struct cpumask *cpus)
+{
+	struct cpu_pwr_stats *per_cpu_info = get_cpu_pwr_stats();
+	int i;
+
+	for_each_cpu(i, cpus) {
+		struct cluster_energy *ce = &per_cpu(cluster_energy, i);
+		struct rq *rq = cpu_rq(i);
+
+		ce->max_possible_capacity = rq->max_possible_capacity;
+		ce->cpu_exit_cost = rq->static_cpu_pwr_cost;
+		ce->cluster_exit_cost = rq->static_cluster_pwr_cost;
+		ACCESS_ONCE(ce->ptable) = per_cpu_info ?
+					  per_cpu_info[i].ptable : NULL;
+	}
+}
+
+int __weak register_cpu_pwr_stats_ready_notifier(struct notifier_block *nb)
+{
+	return 0;
+}
+
+static int cpu_pwr_stats_ready(struct notifier_block *nb,
+			       unsigned long cpu, void *data)
+{
+	update_cluster_energy(cpumask_of(cpu));
+	return NOTIFY_OK;
+}
+
+static struct notifier_block cpu_pwr_stats_ready_nb = {
+	.notifier_call = cpu_pwr_stats_ready,
+};
+
+static int __init register_cluster_energy_notifier(void)
+{
+	update_cluster_energy(cpu_possible_mask);
+	return register_cpu_pwr_stats_ready_notifier(&cpu_pwr_stats_ready_nb);
+}
+late_initcall(register_cluster_energy_notifier);
+
+/* Same as power_cost(), but evaluated against the cached energy model */
+static unsigned int cluster_energy_cost(u64 task_load, int cpu)
+{
+	struct cluster_energy *ce = &per_cpu(cluster_energy, cpu);
+	struct cpu_pstate_pwr *costs = ACCESS_ONCE(ce->ptable);
+	struct rq *rq = cpu_rq(cpu);
+	unsigned int task_freq, cost = 0;
+	u64 demand;
+	int i = 0;
+
+	if (!sysctl_sched_enable_power_aware)
+		return ce->max_possible_capacity;
+
+	if (!costs)
+		return power_cost(task_load, cpu);
+
+	demand = div64_u64(task_load * 100, max_task_load());
+	task_freq = demand * rq->max_possible_freq;
+	task_freq /= 100;
+	task_freq = max(rq->cur_freq, task_freq);
+
+	if (idle_cpu(cpu) && rq->cstate) {
+		cost += ce->cpu_exit_cost;
+		if (rq->dstate)
+			cost += ce->cluster_exit_cost;
+	}
+
+	while (costs[i].freq < task_freq && costs[i + 1].freq)
+		i++;
+
+	return cost + costs[i].power;
+}
+
+/*
+ * Wakeup fast path. Rather than walking every cpu, consider only the
+ * task's previous cpu, the waker's cpu and one sibling per cluster -
+ * preferably an idle one. Cpus of a cluster share a power curve, so one
+ * cpu per cluster is enough to find the cheapest power band. Returns -1
+ * when no candidate is a clear choice, in which case the caller falls
+ * back to the full scan.
+ */
+static int select_best_cpu_fast(struct task_struct *p, int sync)
+{
+	int i, j, best_cpu = -1;
+	int cstate, min_cstate = INT_MAX;
+	unsigned int cpu_cost, min_cost = UINT_MAX;
+	u64 tload, cpu_load, min_load = ULLONG_MAX;
+	cpumask_t search_cpus, candidates;
+
+	hmp_search_cpus(&search_cpus, p);
+	cpumask_clear(&candidates);
+
+	i = task_cpu(p);
+	if (cpumask_test_cpu(i, &search_cpus))
+		cpumask_set_cpu(i, &candidates);
+
+	i = smp_processor_id();
+	if (cpumask_test_cpu(i, &search_cpus))
+		cpumask_set_cpu(i, &candidates);
+
+	while ((i = cpumask_first(&search_cpus)) < nr_cpu_ids) {
+		const struct cpumask *cluster = &cpu_rq(i)->freq_domain_cpumask;
+
+		for_each_cpu_and(j, &search_cpus, cluster) {
+			if (!cpumask_test_cpu(j, &candidates) && idle_cpu(j)) {
+				i = j;
+				break;
+			}
+		}
+		cpumask_set_cpu(i, &candidates);
+		cpumask_andnot(&search_cpus, &search_cpus, cluster);
+		cpumask_clear_cpu(i, &search_cpus);
+	}
+
+	for_each_cpu(i, &candidates) {
+		if (is_reserved(i))
+			continue;
+
+		tload = scale_load_to_cpu(task_load(p), i);
+		if (!task_load_will_fit(p, tload, i))
+			continue;
+
+		cpu_load = cpu_load_sync(i, sync);
+		if (!eligible_cpu(tload, cpu_load, i, sync))
+			continue;
+
+		cpu_cost = cluster_energy_cost(tload, i);
+		cstate = idle_cpu(i) ? cpu_rq(i)->cstate : INT_MAX;
+
+		if (cpu_cost > min_cost)
+			continue;
+
+		if (cpu_cost == min_cost) {
+			if (cstate > min_cstate)
+				continue;
+			if (cstate == min_cstate && (cpu_load > min_load ||
+			    (cpu_load == min_load && i != task_cpu(p))))
+				continue;
+		}
+
+		min_cost = cpu_cost;
+		min_cstate = cstate;
+		min_load = cpu_load;
+		best_cpu = i;
+	}
+
+	/*
+	 * A busy cpu is only a clear choice when it is mostly idle and its
+	 * cluster does not ask for idle cpus to be preferred.
+	 */
+	if (best_cpu >= 0 && !idle_cpu(best_cpu) &&
+	    (cpu_rq(best_cpu)->prefer_idle ||
+	     !mostly_idle_cpu_sync(best_cpu, min_load, sync)))
+		return -1;
+
+	return best_cpu;
+}
+
 static int best_small_task_cpu(struct task_struct *p, int sync)
 {
 	int best_busy_cpu = -1, fallback_cpu = -1;
@@ -3046,7 +3472,7 @@ static int best_small_task_cpu(struct task_struct *p, int sync)
 	cpumask_and(&temp, &mpc_mask, cpu_possible_mask);
 	hmp_capable = !cpumask_full(&temp);
 
-	cpumask_and(&search_cpu, tsk_cpus_allowed(p), cpu_online_mask);
+	hmp_search_cpus(&search_cpu, p);
 	if (unlikely(!cpumask_test_cpu(i, &search_cpu))) {
 		i = cpumask_first(&search_cpu);
 		if (i >= nr_cpu_ids)
@@ -3094,7 +3520,7 @@ static int best_small_task_cpu(struct task_struct *p, int sync)
 	if (min_cstate_cpu != -1)
 		return min_cstate_cpu;
 
-	cpumask_and(&search_cpu, tsk_cpus_allowed(p), cpu_online_mask);
+	hmp_search_cpus(&search_cpu, p);
 	cpumask_andnot(&search_cpu, &search_cpu, &fb_search_cpu);
 	for_each_cpu(i, &search_cpu) {
 		rq = cpu_rq(i);
@@ -3137,6 +3563,7 @@ static int best_small_task_cpu(struct task_struct *p, int sync)
 #define DOWN_MIGRATION		2
 #define EA_MIGRATION		3
 #define IRQLOAD_MIGRATION	4
+#define ISOLATION_MIGRATION	5
 
 static int skip_freq_domain(struct rq *task_rq, struct rq *rq, int reason)
 {
@@ -3159,6 +3586,7 @@ static int skip_freq_domain(struct rq *task_rq, struct rq *rq, int reason)
 		break;
 
 	case IRQLOAD_MIGRATION:
+	case ISOLATION_MIGRATION:
 		/* Purposely fall through */
 
 	default:
@@ -3214,7 +3642,7 @@ static int select_packing_target(struct task_struct *p, int best_cpu)
 	if (rq->max_freq <= rq->mostly_idle_freq)
 		return best_cpu;
 
-	cpumask_and(&search_cpus, tsk_cpus_allowed(p), cpu_online_mask);
+	hmp_search_cpus(&search_cpus, p);
 	cpumask_and(&search_cpus, &search_cpus, &rq->freq_domain_cpumask);
 
 	/* Pick the first lowest power cpu as target */
@@ -3262,6 +3690,7 @@ static int select_best_cpu(struct task_struct *p, int target, int reason,
 	int prefer_idle_override = 0;
 	cpumask_t search_cpus;
 	struct rq *trq;
+	int grp_capacity = task_preferred_capacity(p);
 
 	if (reason) {
 		prefer_idle = 1;
@@ -3279,14 +3708,23 @@ static int select_best_cpu(struct task_struct *p, int target, int reason,
 		sync = 0;
 	}
 
-	if (small_task && !boost) {
+	if (sched_feat(HMP_WAKE_FAST_PATH) && !reason && !boost &&
+	    !grp_capacity && !prefer_idle_override) {
+		best_cpu = select_best_cpu_fast(p, sync);
+		if (best_cpu >= 0) {
+			prefer_idle = 0;	/* For sched_task_load tracepoint */
+			goto done;
+		}
+	}
+
+	if (small_task && !boost && !grp_capacity) {
 		best_cpu = best_small_task_cpu(p, sync);
 		prefer_idle = 0;	/* For sched_task_load tracepoint */
 		goto done;
 	}
 
 	trq = task_rq(p);
-	cpumask_and(&search_cpus, tsk_cpus_allowed(p), cpu_online_mask);
+	hmp_search_cpus(&search_cpus, p);
 	for_each_cpu(i, &search_cpus) {
 		struct rq *rq = cpu_rq(i);
 
@@ -3298,7 +3736,8 @@ static int select_best_cpu(struct task_struct *p, int target, int reason,
 						i), i),
 				     cpu_temp(i));
 
-		if (skip_freq_domain(trq, rq, reason)) {
+		if (skip_freq_domain(trq, rq, reason) ||
+		    rq->capacity < grp_capacity) {
 			cpumask_andnot(&search_cpus, &search_cpus,
 						&rq->freq_domain_cpumask);
 			continue;
@@ -3313,9 +3752,10 @@ static int select_best_cpu(struct task_struct *p, int target, int reason,
 		/*
 		 * The least-loaded mostly-idle CPU where the task
 		 * won't fit is our fallback if we can't find a CPU
-		 * where the task will fit.
+		 * where the task will fit. Members of a related thread
+		 * group are sized by the group's demand instead.
 		 */
-		if (!task_load_will_fit(p, tload, i)) {
+		if (!grp_capacity && !task_load_will_fit(p, tload, i)) {
 			for_each_cpu_and(j, &search_cpus,
 						&rq->freq_domain_cpumask) {
 				cpu_load = cpu_load_sync(j, sync);
@@ -3990,7 +4430,7 @@ static int lower_power_cpu_available(struct task_struct *p, int cpu)
 	 * This function should be called only when task 'p' fits in the current
 	 * CPU which can be ensured by task_will_fit() prior to this.
 	 */
-	cpumask_and(&search_cpus, tsk_cpus_allowed(p), cpu_online_mask);
+	hmp_search_cpus(&search_cpus, p);
 	cpumask_and(&search_cpus, &search_cpus, &rq->freq_domain_cpumask);
 	cpumask_clear_cpu(lowest_power_cpu, &search_cpus);
 
@@ -4021,6 +4461,7 @@ static inline int is_task_migration_throttled(struct task_struct *p);
 static inline int migration_needed(struct rq *rq, struct task_struct *p)
 {
 	int nice = task_nice(p);
+	int grp_capacity;
 
 	if (!sched_enable_hmp || p->state != TASK_RUNNING)
 		return 0;
@@ -4029,6 +4470,9 @@ static inline int migration_needed(struct rq *rq, struct task_struct *p)
 	if (task_will_be_throttled(p))
 		return 0;
 
+	if (cpu_isolated(cpu_of(rq)))
+		return ISOLATION_MIGRATION;
+
 	if (sched_boost()) {
 		if (rq->capacity != max_capacity)
 			return UP_MIGRATION;
@@ -4036,17 +4480,21 @@ static inline int migration_needed(struct rq *rq, struct task_struct *p)
 		return 0;
 	}
 
-	if (is_small_task(p))
+	grp_capacity = task_preferred_capacity(p);
+	if (grp_capacity && rq->capacity < grp_capacity)
+		return UP_MIGRATION;
+
+	if (!grp_capacity && is_small_task(p))
 		return 0;
 
 	if (sched_cpu_high_irqload(cpu_of(rq)))
 		return IRQLOAD_MIGRATION;
 
-	if ((nice > sched_upmigrate_min_nice || upmigrate_discouraged(p)) &&
-			 rq->capacity > min_capacity)
+	if (!grp_capacity && (nice > sched_upmigrate_min_nice ||
+		upmigrate_discouraged(p)) && rq->capacity > min_capacity)
 		return DOWN_MIGRATION;
 
-	if (!task_will_fit(p, cpu_of(rq)))
+	if (!grp_capacity && !task_will_fit(p, cpu_of(rq)))
 		return UP_MIGRATION;
 
 	if (sysctl_sched_enable_power_aware &&
@@ -4241,6 +4689,9 @@ void init_new_task_load(struct task_struct *p)
 	p->init_load_pct = 0;
 	memset(&p->ravg, 0, sizeof(struct ravg));
 	p->se.avg.decay_count	= 0;
+	p->grp = NULL;
+	p->freq_floor = 0;
+	INIT_LIST_HEAD(&p->grp_list);
 
 	if (init_load_pct) {
 		init_load_pelt = div64_u64((u64)init_load_pct *
@@ -9447,7 +9898,7 @@ static int idle_balance(struct rq *this_rq)
 	this_rq->idle_stamp = rq_clock(this_rq);
 
 	if (this_rq->avg_idle < sysctl_sched_migration_cost ||
-	    !this_rq->rd->overload) {
+	    !this_rq->rd->overload || cpu_isolated(this_cpu)) {
 		rcu_read_lock();
 		sd = rcu_dereference_check_sched_domain(this_rq->sd);
 		if (sd)
@@ -9867,6 +10318,10 @@ static void rebalance_domains(struct rq *rq, enum cpu_idle_type idle)
 
 	update_blocked_averages(cpu);
 
+	/* An isolated cpu must not pull work back onto itself */
+	if (cpu_isolated(cpu))
+		return;
+
 	rcu_read_lock();
 	for_each_domain(cpu, sd) {
 		/*
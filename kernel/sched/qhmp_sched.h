@@ -210,6 +210,8 @@ struct task_group {
 	struct cgroup_subsys_state css;
 
 	bool notify_on_migrate;
+	bool memlat_background;
+	unsigned long timer_slack_ns;
 #ifdef CONFIG_SCHED_HMP
 	bool upmigrate_discouraged;
 #endif
@@ -649,10 +651,13 @@ struct rq {
 	u64 irqload_ts;
 	unsigned int static_cpu_pwr_cost;
 	unsigned int static_cluster_pwr_cost;
+	unsigned int freq_floor;
+	int nr_freq_floor_tasks;
 
 #ifdef CONFIG_SCHED_FREQ_INPUT
 	unsigned int old_busy_time;
 	int notifier_sent;
+	u64 alerted_window_start;
 #endif
 #endif
 
@@ -924,6 +929,23 @@ unsigned int cpu_temp(int cpu);
 extern unsigned int nr_eligible_big_tasks(int cpu);
 extern void update_up_down_migrate(void);
 
+/*
+ * Tasks that cooperate on producing a frame (UI thread, render thread and
+ * friends) are placed in a related thread group from userspace. The group
+ * as a whole is sized against its combined demand so that its members are
+ * kept on cpus of the same, sufficiently capable, class.
+ */
+struct related_thread_group {
+	int id;
+	raw_spinlock_t lock;
+	struct list_head tasks;
+	struct list_head list;
+	int preferred_capacity;
+	u64 demand;
+	struct rcu_head rcu;
+	u64 last_update;
+};
+
 /*
  * 'load' is in reference to "best cpu" at its best frequency.
  * Scale that in reference to a given cpu, accounting for how bad it is
@@ -1025,9 +1047,49 @@ static inline int sched_cpu_high_irqload(int cpu)
 	return sched_irqload(cpu) >= sysctl_sched_cpu_high_irqload;
 }
 
+static inline
+struct related_thread_group *task_related_thread_group(struct task_struct *p)
+{
+	return p->grp;
+}
+
+static inline u32 task_demand(struct task_struct *p)
+{
+	return p->ravg.demand;
+}
+
+/* Capacity the task's group should run at, 0 if it has no preference */
+static inline int task_preferred_capacity(struct task_struct *p)
+{
+	struct related_thread_group *grp;
+	int capacity = 0;
+
+	rcu_read_lock();
+	grp = ACCESS_ONCE(p->grp);
+	if (grp)
+		capacity = grp->preferred_capacity;
+	rcu_read_unlock();
+
+	return capacity;
+}
+
 #else	/* CONFIG_SCHED_HMP */
 
 struct hmp_sched_stats;
+struct related_thread_group;
+
+static inline
+struct related_thread_group *task_related_thread_group(struct task_struct *p)
+{
+	return NULL;
+}
+
+static inline u32 task_demand(struct task_struct *p) { return 0; }
+
+static inline int task_preferred_capacity(struct task_struct *p)
+{
+	return 0;
+}
 
 static inline void fixup_nr_big_small_task(int cpu, int reset_stats)
 {
@@ -1082,6 +1144,19 @@ static inline int sched_cpu_high_irqload(int cpu) { return 0; }
 #ifdef CONFIG_SCHED_FREQ_INPUT
 extern void check_for_freq_change(struct rq *rq);
 
+/*
+ * Has this cpu rolled over into a window its governor has not been told
+ * about yet? Called with rq->lock held.
+ */
+static inline bool window_rollover_alert(struct rq *rq)
+{
+	if (rq->alerted_window_start == rq->window_start)
+		return false;
+
+	rq->alerted_window_start = rq->window_start;
+	return true;
+}
+
 /* Is frequency of two cpus synchronized with each other? */
 static inline int same_freq_domain(int src_cpu, int dst_cpu)
 {
@@ -1099,6 +1174,8 @@ static inline int same_freq_domain(int src_cpu, int dst_cpu)
 
 static inline void check_for_freq_change(struct rq *rq) { }
 
+static inline bool window_rollover_alert(struct rq *rq) { return false; }
+
 static inline int same_freq_domain(int src_cpu, int dst_cpu)
 {
 	return 1;
@@ -1133,6 +1210,51 @@ static inline void clear_reserved(int cpu)
 	clear_bit(CPU_RESERVED, &rq->hmp_flags);
 }
 
+/*
+ * Isolated cpus stay online but receive no new work: task placement skips
+ * them, they do not pull in load balance and their running fair task is
+ * pushed away on the next tick.
+ */
+extern struct cpumask __cpu_isolated_mask;
+#define cpu_isolated_mask ((const struct cpumask *)&__cpu_isolated_mask)
+
+static inline int cpu_isolated(int cpu)
+{
+	return cpumask_test_cpu(cpu, cpu_isolated_mask);
+}
+
+/* Cpus @p may be placed on by the HMP placement code */
+static inline void
+hmp_search_cpus(struct cpumask *dst, struct task_struct *p)
+{
+	cpumask_and(dst, tsk_cpus_allowed(p), cpu_online_mask);
+	cpumask_andnot(dst, dst, cpu_isolated_mask);
+}
+
+/*
+ * rq->freq_floor is the highest floor of the runnable tasks that set one.
+ * It is only lowered once the last of them leaves the rq, which keeps
+ * enqueue and dequeue O(1) at the cost of occasionally holding a floor a
+ * little longer than needed.
+ */
+static inline void inc_freq_floor(struct rq *rq, struct task_struct *p)
+{
+	if (!p->freq_floor)
+		return;
+
+	rq->nr_freq_floor_tasks++;
+	rq->freq_floor = max(rq->freq_floor, p->freq_floor);
+}
+
+static inline void dec_freq_floor(struct rq *rq, struct task_struct *p)
+{
+	if (!p->freq_floor)
+		return;
+
+	if (!--rq->nr_freq_floor_tasks)
+		rq->freq_floor = 0;
+}
+
 int mostly_idle_cpu(int cpu);
 extern void check_for_migration(struct rq *rq, struct task_struct *p);
 extern void pre_big_small_task_count_change(const struct cpumask *cpus);
@@ -1140,9 +1262,11 @@ extern void post_big_small_task_count_change(const struct cpumask *cpus);
 extern void set_hmp_defaults(void);
 extern int power_delta_exceeded(unsigned int cpu_cost, unsigned int base_cost);
 extern unsigned int power_cost(u64 load, int cpu);
+extern void update_cluster_energy(const struct cpumask *cpus);
 extern void reset_all_window_stats(u64 window_start, unsigned int window_size);
 extern void boost_kick(int cpu);
 extern int sched_boost(void);
+extern int sched_boost_type_active(unsigned int type);
 
 #else /* CONFIG_SCHED_HMP */
 
@@ -1156,8 +1280,15 @@ static inline void set_hmp_defaults(void) { }
 
 static inline void clear_reserved(int cpu) { }
 
+static inline int cpu_isolated(int cpu) { return 0; }
+
+static inline void inc_freq_floor(struct rq *rq, struct task_struct *p) { }
+static inline void dec_freq_floor(struct rq *rq, struct task_struct *p) { }
+
 #define power_cost(...) 0
 
+static inline void update_cluster_energy(const struct cpumask *cpus) { }
+
 #define trace_sched_cpu_load(...)
 
 #endif /* CONFIG_SCHED_HMP */
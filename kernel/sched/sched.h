@@ -169,6 +169,8 @@ struct task_group {
 	struct cgroup_subsys_state css;
 
 	bool notify_on_migrate;
+	bool memlat_background;
+	unsigned long timer_slack_ns;
 #ifdef CONFIG_SCHED_HMP
 	bool upmigrate_discouraged;
 #endif
@@ -96,6 +96,33 @@ void sched_get_nr_running_avg(int *avg, int *iowait_avg, int *big_avg)
 }
 EXPORT_SYMBOL(sched_get_nr_running_avg);
 
+static int last_avg, last_big_avg;
+
+/**
+ * sched_get_nr_running_forecast
+ * @return: Expected average nr_running, iowait and nr_big_tasks value
+ *	    until the next poll, scaled by 100 like
+ *	    sched_get_nr_running_avg().
+ *
+ * Extrapolates half of the change seen since the previous poll on top of
+ * the average since the last poll, so that a caller sizing cores for the
+ * next period reacts to a ramp before it is fully reflected in the
+ * average. Use instead of, not in addition to, sched_get_nr_running_avg().
+ */
+void sched_get_nr_running_forecast(int *avg, int *iowait_avg, int *big_avg)
+{
+	int cur_avg, cur_big_avg;
+
+	sched_get_nr_running_avg(&cur_avg, iowait_avg, &cur_big_avg);
+
+	*avg = max(cur_avg + (cur_avg - last_avg) / 2, 0);
+	*big_avg = max(cur_big_avg + (cur_big_avg - last_big_avg) / 2, 0);
+
+	last_avg = cur_avg;
+	last_big_avg = cur_big_avg;
+}
+EXPORT_SYMBOL(sched_get_nr_running_forecast);
+
 /**
  * sched_update_nr_prod
  * @cpu: The core id of the nr running driver.
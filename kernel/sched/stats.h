@@ -77,12 +77,24 @@ static inline void sched_info_dequeued(struct rq *rq, struct task_struct *t)
  * long it was waiting to run.  We also note when it began so that we
  * can keep stats on how long its timeslice is.
  */
+static inline void
+sched_info_wait_hist(struct sched_info *si, unsigned long long delta)
+{
+	int i = fls64(delta >> SCHED_WAIT_HIST_SHIFT);
+
+	if (i >= SCHED_WAIT_HIST_BUCKETS)
+		i = SCHED_WAIT_HIST_BUCKETS - 1;
+	si->wait_hist[i]++;
+}
+
 static void sched_info_arrive(struct rq *rq, struct task_struct *t)
 {
 	unsigned long long now = rq_clock(rq), delta = 0;
 
-	if (t->sched_info.last_queued)
+	if (t->sched_info.last_queued) {
 		delta = now - t->sched_info.last_queued;
+		sched_info_wait_hist(&t->sched_info, delta);
+	}
 	sched_info_reset_dequeued(t);
 	t->sched_info.run_delay += delta;
 	t->sched_info.last_arrival = now;
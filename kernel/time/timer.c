@@ -917,9 +917,23 @@ unsigned long apply_slack(struct timer_list *timer, unsigned long expires)
 		long delta = expires - jiffies;
 
 		if (delta < 256)
-			return expires;
+			expires_limit = expires;
+		else
+			expires_limit = expires + delta / 256;
+	}
+
+	/*
+	 * Deferrable timers armed by a task with a raised timer slack, such
+	 * as one in a background cgroup, take that slack too, so that their
+	 * expiries fall on boundaries shared with other such timers.
+	 */
+	if (timer->slack < 0 && tbase_get_deferrable(timer->base) &&
+	    !in_interrupt()) {
+		unsigned long slack;
 
-		expires_limit = expires + delta / 256;
+		slack = nsecs_to_jiffies(current->timer_slack_ns);
+		if (time_after(expires + slack, expires_limit))
+			expires_limit = expires + slack;
 	}
 	mask = expires ^ expires_limit;
 	if (mask == 0)
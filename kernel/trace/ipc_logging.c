@@ -280,6 +280,10 @@ static void msg_drop(struct ipc_log_context *ilctxt)
 /*
  * Commits messages to the FIFO.  If the FIFO is full, then enough
  * messages are dropped to create space for the new message.
+ *
+ * This is on the hot path of every client, so only the context's own lock
+ * is taken and readers are woken once per empty to non-empty transition
+ * rather than once per message.
  */
 void ipc_log_write(void *ctxt, struct encode_context *ectxt)
 {
@@ -292,8 +296,7 @@ void ipc_log_write(void *ctxt, struct encode_context *ectxt)
 		return;
 	}
 
-	read_lock_irqsave(&context_list_lock_lha1, flags);
-	spin_lock(&ilctxt->context_lock_lhb1);
+	spin_lock_irqsave(&ilctxt->context_lock_lhb1, flags);
 	while (ilctxt->write_avail <= ectxt->offset)
 		msg_drop(ilctxt);
 
@@ -322,9 +325,11 @@ void ipc_log_write(void *ctxt, struct encode_context *ectxt)
 	}
 	ilctxt->write_page->hdr.write_offset += bytes_to_write;
 	ilctxt->write_avail -= ectxt->offset;
-	complete(&ilctxt->read_avail);
-	spin_unlock(&ilctxt->context_lock_lhb1);
-	read_unlock_irqrestore(&context_list_lock_lha1, flags);
+	if (!ilctxt->read_avail_posted) {
+		ilctxt->read_avail_posted = true;
+		complete(&ilctxt->read_avail);
+	}
+	spin_unlock_irqrestore(&ilctxt->context_lock_lhb1, flags);
 }
 EXPORT_SYMBOL(ipc_log_write);
 
@@ -545,27 +550,25 @@ int ipc_log_extract(void *ctxt, char *buff, int size)
 	dctxt.output_format = OUTPUT_DEBUGFS;
 	dctxt.buff = buff;
 	dctxt.size = size;
-	read_lock_irqsave(&context_list_lock_lha1, flags);
-	spin_lock(&ilctxt->context_lock_lhb1);
+	spin_lock_irqsave(&ilctxt->context_lock_lhb1, flags);
 	while (dctxt.size >= MAX_MSG_DECODED_SIZE &&
 	       !is_nd_read_empty(ilctxt)) {
 		msg_read(ilctxt, &ectxt);
 		deserialize_func = get_deserialization_func(ilctxt,
 							ectxt.hdr.type);
-		spin_unlock(&ilctxt->context_lock_lhb1);
-		read_unlock_irqrestore(&context_list_lock_lha1, flags);
+		spin_unlock_irqrestore(&ilctxt->context_lock_lhb1, flags);
 		if (deserialize_func)
 			deserialize_func(&ectxt, &dctxt);
 		else
 			pr_err("%s: unknown message 0x%x\n",
 				__func__, ectxt.hdr.type);
-		read_lock_irqsave(&context_list_lock_lha1, flags);
-		spin_lock(&ilctxt->context_lock_lhb1);
+		spin_lock_irqsave(&ilctxt->context_lock_lhb1, flags);
 	}
-	if ((size - dctxt.size) == 0)
+	if ((size - dctxt.size) == 0) {
 		reinit_completion(&ilctxt->read_avail);
-	spin_unlock(&ilctxt->context_lock_lhb1);
-	read_unlock_irqrestore(&context_list_lock_lha1, flags);
+		ilctxt->read_avail_posted = false;
+	}
+	spin_unlock_irqrestore(&ilctxt->context_lock_lhb1, flags);
 	return size - dctxt.size;
 }
 EXPORT_SYMBOL(ipc_log_extract);
@@ -726,13 +729,11 @@ int add_deserialization_func(void *ctxt, int type,
 	if (!df_info)
 		return -ENOSPC;
 
-	read_lock_irqsave(&context_list_lock_lha1, flags);
-	spin_lock(&ilctxt->context_lock_lhb1);
+	spin_lock_irqsave(&ilctxt->context_lock_lhb1, flags);
 	df_info->type = type;
 	df_info->dfunc = dfunc;
 	list_add_tail(&df_info->list, &ilctxt->dfunc_info_list);
-	spin_unlock(&ilctxt->context_lock_lhb1);
-	read_unlock_irqrestore(&context_list_lock_lha1, flags);
+	spin_unlock_irqrestore(&ilctxt->context_lock_lhb1, flags);
 	return 0;
 }
 EXPORT_SYMBOL(add_deserialization_func);
@@ -25,6 +25,8 @@
 #include <linux/of.h>
 #include <linux/of_address.h>
 #include <linux/io.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <asm-generic/sizes.h>
 #include <linux/msm_rtb.h>
 
@@ -61,6 +63,7 @@ struct msm_rtb_state {
 	int initialized;
 	uint32_t filter;
 	int step_size;
+	int seg_nentries;
 };
 
 #if defined(CONFIG_MSM_RTB_SEPARATE_CPUS)
@@ -79,13 +82,61 @@ static struct msm_rtb_state msm_rtb = {
 	.enabled = 1,
 };
 
-module_param_named(filter, msm_rtb.filter, uint, 0644);
-module_param_named(enable, msm_rtb.enabled, int, 0644);
+/*
+ * The types to log, or 0 while RTB is off. Every logging call checks it,
+ * so it is kept on its own in a read mostly line instead of next to the
+ * state written at probe and by the parameters.
+ */
+static uint32_t msm_rtb_log_mask __read_mostly;
+
+static void msm_rtb_update_log_mask(void)
+{
+	bool running = msm_rtb.initialized;
+
+#ifdef CONFIG_HTC_EARLY_RTB
+	running |= (early_rtb_stat == EARLY_RTB_RUNNING);
+#endif
+	/* The buffer set up must be visible before logging is allowed */
+	smp_wmb();
+	msm_rtb_log_mask = (running && msm_rtb.enabled) ? msm_rtb.filter : 0;
+}
+
+static int msm_rtb_filter_set(const char *val, const struct kernel_param *kp)
+{
+	int ret = param_set_uint(val, kp);
+
+	if (!ret)
+		msm_rtb_update_log_mask();
+	return ret;
+}
+
+static struct kernel_param_ops msm_rtb_filter_ops = {
+	.set = msm_rtb_filter_set,
+	.get = param_get_uint,
+};
+
+static int msm_rtb_enable_set(const char *val, const struct kernel_param *kp)
+{
+	int ret = param_set_int(val, kp);
+
+	if (!ret)
+		msm_rtb_update_log_mask();
+	return ret;
+}
+
+static struct kernel_param_ops msm_rtb_enable_ops = {
+	.set = msm_rtb_enable_set,
+	.get = param_get_int,
+};
+
+module_param_cb(filter, &msm_rtb_filter_ops, &msm_rtb.filter, 0644);
+module_param_cb(enable, &msm_rtb_enable_ops, &msm_rtb.enabled, 0644);
 
 #if defined(CONFIG_HTC_DEBUG_RTB)
 void msm_rtb_disable(void)
 {
 	msm_rtb.enabled = 0;
+	msm_rtb_update_log_mask();
 	return;
 }
 EXPORT_SYMBOL(msm_rtb_disable);
@@ -95,6 +146,7 @@ static int msm_rtb_panic_notifier(struct notifier_block *this,
 					unsigned long event, void *ptr)
 {
 	msm_rtb.enabled = 0;
+	msm_rtb_update_log_mask();
 	return NOTIFY_DONE;
 }
 
@@ -105,13 +157,7 @@ static struct notifier_block msm_rtb_panic_blk = {
 
 int notrace msm_rtb_event_should_log(enum logk_event_type log_type)
 {
-#ifdef CONFIG_HTC_EARLY_RTB
-	return ((early_rtb_stat == EARLY_RTB_RUNNING) || msm_rtb.initialized) &&
-		msm_rtb.enabled && ((1 << (log_type & ~LOGTYPE_NOPC)) & msm_rtb.filter);
-#else
-	return msm_rtb.initialized && msm_rtb.enabled &&
-		((1 << (log_type & ~LOGTYPE_NOPC)) & msm_rtb.filter);
-#endif
+	return (1 << (log_type & ~LOGTYPE_NOPC)) & msm_rtb_log_mask;
 }
 EXPORT_SYMBOL(msm_rtb_event_should_log);
 
@@ -150,12 +196,9 @@ static void msm_rtb_write_timestamp(struct msm_rtb_layout *start)
 }
 
 static void uncached_logk_pc_idx(enum logk_event_type log_type, uint64_t caller,
-				 uint64_t data, int idx)
+				 uint64_t data, int idx,
+				 struct msm_rtb_layout *start)
 {
-	struct msm_rtb_layout *start;
-
-	start = &msm_rtb.rtb[idx & (msm_rtb.nentries - 1)];
-
 	msm_rtb_emit_sentinel(start);
 	msm_rtb_write_type(log_type, start);
 	msm_rtb_write_caller(caller, start);
@@ -167,72 +210,91 @@ static void uncached_logk_pc_idx(enum logk_event_type log_type, uint64_t caller,
 	return;
 }
 
-static void uncached_logk_timestamp(int idx)
+static void uncached_logk_timestamp(int idx, struct msm_rtb_layout *start)
 {
 	unsigned long long timestamp;
 
 	timestamp = sched_clock();
 	uncached_logk_pc_idx(LOGK_TIMESTAMP|LOGTYPE_NOPC,
 			(uint64_t)lower_32_bits(timestamp),
-			(uint64_t)upper_32_bits(timestamp), idx);
+			(uint64_t)upper_32_bits(timestamp), idx, start);
 }
 
 #if defined(CONFIG_MSM_RTB_SEPARATE_CPUS)
-static int msm_rtb_get_idx(void)
+/*
+ * Each cpu logs into its own contiguous segment with a local index, so
+ * that no two cpus write to the same cache line. The recorded idx still
+ * interleaves the cpus, idx = local index * step_size + cpu.
+ */
+static struct msm_rtb_layout *msm_rtb_get_entry(int *idx)
 {
-	int cpu, i, offset;
+	struct msm_rtb_layout *seg;
+	int cpu, i, mask;
 	atomic_t *index;
 
 	cpu = raw_smp_processor_id();
+	seg = msm_rtb.rtb + cpu * msm_rtb.seg_nentries;
+	mask = msm_rtb.seg_nentries - 1;
 
 	index = &per_cpu(msm_rtb_idx_cpu, cpu);
 
-	i = atomic_add_return(msm_rtb.step_size, index);
-	i -= msm_rtb.step_size;
+	i = atomic_inc_return(index) - 1;
 
-	
-	offset = (i & (msm_rtb.nentries - 1)) -
-		 ((i - msm_rtb.step_size) & (msm_rtb.nentries - 1));
-	if (offset < 0) {
-		uncached_logk_timestamp(i);
-		i = atomic_add_return(msm_rtb.step_size, index);
-		i -= msm_rtb.step_size;
+	/* Mark each wrap of the segment with a timestamp */
+	if (!(i & mask)) {
+		uncached_logk_timestamp(i * msm_rtb.step_size + cpu, seg);
+		i = atomic_inc_return(index) - 1;
 	}
 
-	return i;
+	*idx = i * msm_rtb.step_size + cpu;
+	return &seg[i & mask];
 }
 #else
-static int msm_rtb_get_idx(void)
+static struct msm_rtb_layout *msm_rtb_get_entry(int *idx)
 {
-	int i, offset;
+	int i, mask = msm_rtb.nentries - 1;
 
-	i = atomic_inc_return(&msm_rtb_idx);
-	i--;
+	i = atomic_inc_return(&msm_rtb_idx) - 1;
 
-	
-	offset = (i & (msm_rtb.nentries - 1)) -
-		 ((i - 1) & (msm_rtb.nentries - 1));
-	if (offset < 0) {
-		uncached_logk_timestamp(i);
-		i = atomic_inc_return(&msm_rtb_idx);
-		i--;
+	/* Mark each wrap of the buffer with a timestamp */
+	if (!(i & mask)) {
+		uncached_logk_timestamp(i, msm_rtb.rtb);
+		i = atomic_inc_return(&msm_rtb_idx) - 1;
 	}
 
-	return i;
+	*idx = i;
+	return &msm_rtb.rtb[i & mask];
 }
 #endif
 
+static void msm_rtb_init_idx(void)
+{
+#if defined(CONFIG_MSM_RTB_SEPARATE_CPUS)
+	unsigned int cpu;
+
+	for_each_possible_cpu(cpu)
+		atomic_set(&per_cpu(msm_rtb_idx_cpu, cpu), 0);
+	msm_rtb.step_size = nr_cpu_ids;
+#else
+	atomic_set(&msm_rtb_idx, 0);
+	msm_rtb.step_size = 1;
+#endif
+	msm_rtb.seg_nentries = __rounddown_pow_of_two(msm_rtb.nentries /
+						      msm_rtb.step_size);
+}
+
 int notrace uncached_logk_pc(enum logk_event_type log_type, void *caller,
 				void *data)
 {
+	struct msm_rtb_layout *start;
 	int i;
 
 	if (!msm_rtb_event_should_log(log_type))
 		return 0;
 
-	i = msm_rtb_get_idx();
+	start = msm_rtb_get_entry(&i);
 	uncached_logk_pc_idx(log_type, (uint64_t)((unsigned long) caller),
-				(uint64_t)((unsigned long) data), i);
+				(uint64_t)((unsigned long) data), i, start);
 
 	return 1;
 }
@@ -244,12 +306,134 @@ noinline int notrace uncached_logk(enum logk_event_type log_type, void *data)
 }
 EXPORT_SYMBOL(uncached_logk);
 
-#ifdef CONFIG_HTC_EARLY_RTB
-int htc_early_rtb_init(void)
+#ifdef CONFIG_DEBUG_FS
+/*
+ * Dump the log oldest first. The cpu segments are merged on the fly by
+ * timestamp, so the writers never have to agree on a global order.
+ */
+struct msm_rtb_dump {
+	int pos[NR_CPUS];
+	int left[NR_CPUS];
+	int seg;
+};
+
+static struct msm_rtb_layout *msm_rtb_dump_entry(struct msm_rtb_dump *d,
+						 int seg)
+{
+	return msm_rtb.rtb + seg * msm_rtb.seg_nentries + d->pos[seg];
+}
+
+static void msm_rtb_dump_reset(struct msm_rtb_dump *d)
 {
+	int seg, n;
+
+	for (seg = 0; seg < msm_rtb.step_size; seg++) {
 #if defined(CONFIG_MSM_RTB_SEPARATE_CPUS)
-        unsigned int cpu;
+		n = cpu_possible(seg) ?
+			atomic_read(&per_cpu(msm_rtb_idx_cpu, seg)) : 0;
+#else
+		n = atomic_read(&msm_rtb_idx);
 #endif
+		if ((unsigned int)n <= msm_rtb.seg_nentries) {
+			d->pos[seg] = 0;
+			d->left[seg] = n;
+		} else {
+			d->pos[seg] = n & (msm_rtb.seg_nentries - 1);
+			d->left[seg] = msm_rtb.seg_nentries;
+		}
+	}
+}
+
+static struct msm_rtb_layout *msm_rtb_dump_next(struct msm_rtb_dump *d)
+{
+	struct msm_rtb_layout *entry, *oldest = NULL;
+	int seg;
+
+	for (seg = 0; seg < msm_rtb.step_size; seg++) {
+		if (!d->left[seg])
+			continue;
+		entry = msm_rtb_dump_entry(d, seg);
+		if (!oldest || entry->timestamp < oldest->timestamp) {
+			oldest = entry;
+			d->seg = seg;
+		}
+	}
+
+	return oldest;
+}
+
+static void *msm_rtb_seq_start(struct seq_file *m, loff_t *pos)
+{
+	struct msm_rtb_dump *d = m->private;
+
+	if (!*pos)
+		msm_rtb_dump_reset(d);
+
+	return msm_rtb_dump_next(d);
+}
+
+static void *msm_rtb_seq_next(struct seq_file *m, void *v, loff_t *pos)
+{
+	struct msm_rtb_dump *d = m->private;
+
+	d->pos[d->seg] = (d->pos[d->seg] + 1) & (msm_rtb.seg_nentries - 1);
+	d->left[d->seg]--;
+	(*pos)++;
+
+	return msm_rtb_dump_next(d);
+}
+
+static void msm_rtb_seq_stop(struct seq_file *m, void *v)
+{
+}
+
+static int msm_rtb_seq_show(struct seq_file *m, void *v)
+{
+	struct msm_rtb_layout *entry = v;
+
+	if (entry->sentinel[0] != SENTINEL_BYTE_1 ||
+	    entry->sentinel[1] != SENTINEL_BYTE_2 ||
+	    entry->sentinel[2] != SENTINEL_BYTE_3)
+		return 0;
+
+	seq_printf(m, "%llu idx:%u type:%u caller:0x%llx data:0x%llx\n",
+		   entry->timestamp, entry->idx, entry->log_type,
+		   entry->caller, entry->data);
+	return 0;
+}
+
+static const struct seq_operations msm_rtb_seq_ops = {
+	.start = msm_rtb_seq_start,
+	.next = msm_rtb_seq_next,
+	.stop = msm_rtb_seq_stop,
+	.show = msm_rtb_seq_show,
+};
+
+static int msm_rtb_dump_open(struct inode *inode, struct file *file)
+{
+	return seq_open_private(file, &msm_rtb_seq_ops,
+				sizeof(struct msm_rtb_dump));
+}
+
+static const struct file_operations msm_rtb_dump_fops = {
+	.open = msm_rtb_dump_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = seq_release_private,
+};
+
+static void msm_rtb_debugfs_init(void)
+{
+	debugfs_create_file("msm_rtb", S_IRUSR, NULL, NULL,
+			    &msm_rtb_dump_fops);
+}
+#else
+static inline void msm_rtb_debugfs_init(void) { }
+#endif
+
+#ifdef CONFIG_HTC_EARLY_RTB
+int htc_early_rtb_init(void)
+{
 	struct device_node *dt_node = NULL;
 	char* rtb_node_name = "qcom,msm-rtb";
 	char* rtb_resource_name = "msm_rtb_res";
@@ -313,19 +497,11 @@ int htc_early_rtb_init(void)
 	msm_rtb.nentries = __rounddown_pow_of_two(msm_rtb.nentries);
 	memset_io(msm_rtb.rtb, 0, msm_rtb.size);
 
-#if defined(CONFIG_MSM_RTB_SEPARATE_CPUS)
-        for_each_possible_cpu(cpu) {
-                atomic_t *a = &per_cpu(msm_rtb_idx_cpu, cpu);
-                atomic_set(a, cpu);
-        }
-        msm_rtb.step_size = num_possible_cpus();
-#else
-        atomic_set(&msm_rtb_idx, 0);
-        msm_rtb.step_size = 1;
-#endif
+	msm_rtb_init_idx();
 
 	early_rtb_stat = EARLY_RTB_RUNNING;
 	smp_mb();
+	msm_rtb_update_log_mask();
 
 	return 0;
 }
@@ -341,6 +517,7 @@ int htc_early_rtb_deinit(void)
 		
 		early_rtb_stat = EARLY_RTB_STOP;
 		smp_mb();
+		msm_rtb_update_log_mask();
 		mdelay(10);
 
 		iounmap(msm_rtb.rtb);
@@ -363,9 +540,6 @@ static int msm_rtb_probe(struct platform_device *pdev)
 {
 	struct msm_rtb_platform_data *d = pdev->dev.platform_data;
 	struct resource *res = NULL;
-#if defined(CONFIG_MSM_RTB_SEPARATE_CPUS)
-	unsigned int cpu;
-#endif
 	int ret;
 
 #ifdef CONFIG_HTC_EARLY_RTB
@@ -430,21 +604,15 @@ static int msm_rtb_probe(struct platform_device *pdev)
 
 	memset_io(msm_rtb.rtb, 0, msm_rtb.size);
 
-
-#if defined(CONFIG_MSM_RTB_SEPARATE_CPUS)
-	for_each_possible_cpu(cpu) {
-		atomic_t *a = &per_cpu(msm_rtb_idx_cpu, cpu);
-		atomic_set(a, cpu);
-	}
-	msm_rtb.step_size = num_possible_cpus();
-#else
-	atomic_set(&msm_rtb_idx, 0);
-	msm_rtb.step_size = 1;
-#endif
+	msm_rtb_init_idx();
+	if (!msm_rtb.seg_nentries)
+		return -EINVAL;
 
 	atomic_notifier_chain_register(&panic_notifier_list,
 						&msm_rtb_panic_blk);
 	msm_rtb.initialized = 1;
+	msm_rtb_update_log_mask();
+	msm_rtb_debugfs_init();
 	return 0;
 }
 
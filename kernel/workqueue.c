@@ -49,6 +49,7 @@
 #include <linux/moduleparam.h>
 #include <linux/uaccess.h>
 #include <linux/bug.h>
+#include <linux/topology.h>
 
 #include "workqueue_internal.h"
 
@@ -201,6 +202,9 @@ static bool wq_power_efficient;
 
 module_param_named(power_efficient, wq_power_efficient, bool, 0444);
 
+/* CPUs unbound workqueues run on, see wq_restrict_cpumask() */
+static cpumask_var_t wq_unbound_cpumask;
+
 static bool wq_numa_enabled;		
 
 static struct workqueue_attrs *wq_update_unbound_numa_attrs_buf;
@@ -2066,11 +2070,51 @@ static ssize_t wq_numa_store(struct device *dev, struct device_attribute *attr,
 	return ret ?: count;
 }
 
+static ssize_t wq_latency_sensitive_show(struct device *dev,
+					 struct device_attribute *attr,
+					 char *buf)
+{
+	struct workqueue_struct *wq = dev_to_wq(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n",
+			 !!(wq->flags & WQ_LATENCY_SENSITIVE));
+}
+
+static ssize_t wq_latency_sensitive_store(struct device *dev,
+					  struct device_attribute *attr,
+					  const char *buf, size_t count)
+{
+	struct workqueue_struct *wq = dev_to_wq(dev);
+	struct workqueue_attrs *attrs;
+	int v, ret;
+
+	if (sscanf(buf, "%d", &v) != 1)
+		return -EINVAL;
+
+	attrs = wq_sysfs_prep_attrs(wq);
+	if (!attrs)
+		return -ENOMEM;
+
+	mutex_lock(&wq->mutex);
+	if (v)
+		wq->flags |= WQ_LATENCY_SENSITIVE;
+	else
+		wq->flags &= ~WQ_LATENCY_SENSITIVE;
+	mutex_unlock(&wq->mutex);
+
+	ret = apply_workqueue_attrs(wq, attrs);
+
+	free_workqueue_attrs(attrs);
+	return ret ?: count;
+}
+
 static struct device_attribute wq_sysfs_unbound_attrs[] = {
 	__ATTR(pool_ids, 0444, wq_pool_ids_show, NULL),
 	__ATTR(nice, 0644, wq_nice_show, wq_nice_store),
 	__ATTR(cpumask, 0644, wq_cpumask_show, wq_cpumask_store),
 	__ATTR(numa, 0644, wq_numa_show, wq_numa_store),
+	__ATTR(latency_sensitive, 0644, wq_latency_sensitive_show,
+	       wq_latency_sensitive_store),
 	__ATTR_NULL,
 };
 
@@ -2079,9 +2123,50 @@ static struct bus_type wq_subsys = {
 	.dev_groups			= wq_sysfs_groups,
 };
 
+static ssize_t wq_unbound_cpumask_show(struct device *dev,
+				       struct device_attribute *attr, char *buf)
+{
+	int written;
+
+	mutex_lock(&wq_pool_mutex);
+	written = cpumask_scnprintf(buf, PAGE_SIZE, wq_unbound_cpumask);
+	mutex_unlock(&wq_pool_mutex);
+
+	written += scnprintf(buf + written, PAGE_SIZE - written, "\n");
+	return written;
+}
+
+static ssize_t wq_unbound_cpumask_store(struct device *dev,
+					struct device_attribute *attr,
+					const char *buf, size_t count)
+{
+	cpumask_var_t cpumask;
+	int ret;
+
+	if (!zalloc_cpumask_var(&cpumask, GFP_KERNEL))
+		return -ENOMEM;
+
+	ret = cpumask_parse(buf, cpumask);
+	if (!ret)
+		ret = workqueue_set_unbound_cpumask(cpumask);
+
+	free_cpumask_var(cpumask);
+	return ret ?: count;
+}
+
+static struct device_attribute wq_sysfs_cpumask_attr =
+	__ATTR(cpumask, 0644, wq_unbound_cpumask_show,
+	       wq_unbound_cpumask_store);
+
 static int __init wq_sysfs_init(void)
 {
-	return subsys_virtual_register(&wq_subsys, NULL);
+	int err;
+
+	err = subsys_virtual_register(&wq_subsys, NULL);
+	if (err)
+		return err;
+
+	return device_create_file(wq_subsys.dev_root, &wq_sysfs_cpumask_attr);
 }
 core_initcall(wq_sysfs_init);
 
@@ -2516,13 +2601,29 @@ static struct pool_workqueue *numa_pwq_tbl_install(struct workqueue_struct *wq,
 	return old_pwq;
 }
 
-int apply_workqueue_attrs(struct workqueue_struct *wq,
-			  const struct workqueue_attrs *attrs)
+/*
+ * Unbound workqueues run on wq_unbound_cpumask unless they are flagged
+ * WQ_LATENCY_SENSITIVE or were explicitly given CPUs outside of it.
+ */
+static void wq_restrict_cpumask(struct workqueue_struct *wq,
+				struct cpumask *cpumask)
+{
+	if (wq->flags & WQ_LATENCY_SENSITIVE)
+		return;
+
+	if (cpumask_intersects(cpumask, wq_unbound_cpumask))
+		cpumask_and(cpumask, cpumask, wq_unbound_cpumask);
+}
+
+static int apply_workqueue_attrs_locked(struct workqueue_struct *wq,
+					const struct workqueue_attrs *attrs)
 {
-	struct workqueue_attrs *new_attrs, *tmp_attrs;
+	struct workqueue_attrs *new_attrs, *pwq_attrs, *tmp_attrs;
 	struct pool_workqueue **pwq_tbl, *dfl_pwq;
 	int node, ret;
 
+	lockdep_assert_held(&wq_pool_mutex);
+
 	
 	if (WARN_ON(!(wq->flags & WQ_UNBOUND)))
 		return -EINVAL;
@@ -2533,26 +2634,28 @@ int apply_workqueue_attrs(struct workqueue_struct *wq,
 
 	pwq_tbl = kzalloc(nr_node_ids * sizeof(pwq_tbl[0]), GFP_KERNEL);
 	new_attrs = alloc_workqueue_attrs(GFP_KERNEL);
+	pwq_attrs = alloc_workqueue_attrs(GFP_KERNEL);
 	tmp_attrs = alloc_workqueue_attrs(GFP_KERNEL);
-	if (!pwq_tbl || !new_attrs || !tmp_attrs)
+	if (!pwq_tbl || !new_attrs || !pwq_attrs || !tmp_attrs)
 		goto enomem;
 
 	
 	copy_workqueue_attrs(new_attrs, attrs);
 	cpumask_and(new_attrs->cpumask, new_attrs->cpumask, cpu_possible_mask);
 
-	copy_workqueue_attrs(tmp_attrs, new_attrs);
-
-	get_online_cpus();
+	/* the pools get the restricted mask, the wq keeps the requested one */
+	copy_workqueue_attrs(pwq_attrs, new_attrs);
+	wq_restrict_cpumask(wq, pwq_attrs->cpumask);
 
-	mutex_lock(&wq_pool_mutex);
+	copy_workqueue_attrs(tmp_attrs, pwq_attrs);
 
-	dfl_pwq = alloc_unbound_pwq(wq, new_attrs);
+	dfl_pwq = alloc_unbound_pwq(wq, pwq_attrs);
 	if (!dfl_pwq)
 		goto enomem_pwq;
 
 	for_each_node(node) {
-		if (wq_calc_node_cpumask(attrs, node, -1, tmp_attrs->cpumask)) {
+		if (wq_calc_node_cpumask(pwq_attrs, node, -1,
+					 tmp_attrs->cpumask)) {
 			pwq_tbl[node] = alloc_unbound_pwq(wq, tmp_attrs);
 			if (!pwq_tbl[node])
 				goto enomem_pwq;
@@ -2562,8 +2665,6 @@ int apply_workqueue_attrs(struct workqueue_struct *wq,
 		}
 	}
 
-	mutex_unlock(&wq_pool_mutex);
-
 	
 	mutex_lock(&wq->mutex);
 
@@ -2584,11 +2685,11 @@ int apply_workqueue_attrs(struct workqueue_struct *wq,
 		put_pwq_unlocked(pwq_tbl[node]);
 	put_pwq_unlocked(dfl_pwq);
 
-	put_online_cpus();
 	ret = 0;
 	
 out_free:
 	free_workqueue_attrs(tmp_attrs);
+	free_workqueue_attrs(pwq_attrs);
 	free_workqueue_attrs(new_attrs);
 	kfree(pwq_tbl);
 	return ret;
@@ -2598,13 +2699,66 @@ enomem_pwq:
 	for_each_node(node)
 		if (pwq_tbl && pwq_tbl[node] != dfl_pwq)
 			free_unbound_pwq(pwq_tbl[node]);
-	mutex_unlock(&wq_pool_mutex);
-	put_online_cpus();
 enomem:
 	ret = -ENOMEM;
 	goto out_free;
 }
 
+int apply_workqueue_attrs(struct workqueue_struct *wq,
+			  const struct workqueue_attrs *attrs)
+{
+	int ret;
+
+	get_online_cpus();
+	mutex_lock(&wq_pool_mutex);
+	ret = apply_workqueue_attrs_locked(wq, attrs);
+	mutex_unlock(&wq_pool_mutex);
+	put_online_cpus();
+
+	return ret;
+}
+
+/**
+ * workqueue_set_unbound_cpumask - set the default CPUs of unbound workqueues
+ * @cpumask: the new mask
+ *
+ * Restricts every unbound workqueue, except the WQ_LATENCY_SENSITIVE and
+ * the ordered ones, to @cpumask and re-creates their pools. Ordered
+ * workqueues only pick up the mask when they are created, since
+ * switching their pool could break the ordering.
+ *
+ * Return: 0 on success, -EINVAL if @cpumask has no possible CPU or
+ * -ENOMEM if the pools could not be re-created.
+ */
+int workqueue_set_unbound_cpumask(cpumask_var_t cpumask)
+{
+	struct workqueue_struct *wq;
+	int ret = 0, err;
+
+	cpumask_and(cpumask, cpumask, cpu_possible_mask);
+	if (cpumask_empty(cpumask))
+		return -EINVAL;
+
+	get_online_cpus();
+	mutex_lock(&wq_pool_mutex);
+
+	cpumask_copy(wq_unbound_cpumask, cpumask);
+
+	list_for_each_entry(wq, &workqueues, list) {
+		if (!(wq->flags & WQ_UNBOUND) || (wq->flags & __WQ_ORDERED))
+			continue;
+
+		err = apply_workqueue_attrs_locked(wq, wq->unbound_attrs);
+		if (err && !ret)
+			ret = err;
+	}
+
+	mutex_unlock(&wq_pool_mutex);
+	put_online_cpus();
+
+	return ret;
+}
+
 static void wq_update_unbound_numa(struct workqueue_struct *wq, int cpu,
 				   bool online)
 {
@@ -2629,7 +2783,9 @@ static void wq_update_unbound_numa(struct workqueue_struct *wq, int cpu,
 	copy_workqueue_attrs(target_attrs, wq->unbound_attrs);
 	pwq = unbound_pwq_by_node(wq, node);
 
-	if (wq_calc_node_cpumask(wq->unbound_attrs, node, cpu_off, cpumask)) {
+	/* the default pool carries the mask after wq_restrict_cpumask() */
+	if (wq_calc_node_cpumask(wq->dfl_pwq->pool->attrs, node, cpu_off,
+				 cpumask)) {
 		if (cpumask_equal(cpumask, pwq->pool->attrs->cpumask))
 			goto out_unlock;
 	} else {
@@ -3308,6 +3464,28 @@ void workqueue_show_pending_work(void)
 
 #endif 
 
+/*
+ * In power efficient mode unbound work is kept on the cluster of CPU 0,
+ * the little cluster on big.LITTLE SoCs, unless the queue is flagged
+ * WQ_LATENCY_SENSITIVE. The mask can be changed at runtime through
+ * /sys/devices/virtual/workqueue/cpumask.
+ */
+static void __init wq_unbound_cpumask_init(void)
+{
+	int cpu, cluster = topology_physical_package_id(0);
+
+	BUG_ON(!zalloc_cpumask_var(&wq_unbound_cpumask, GFP_KERNEL));
+
+	if (!wq_power_efficient) {
+		cpumask_copy(wq_unbound_cpumask, cpu_possible_mask);
+		return;
+	}
+
+	for_each_possible_cpu(cpu)
+		if (topology_physical_package_id(cpu) == cluster)
+			cpumask_set_cpu(cpu, wq_unbound_cpumask);
+}
+
 static int __init init_workqueues(void)
 {
 	int std_nice[NR_STD_WORKER_POOLS] = { 0, HIGHPRI_NICE_LEVEL };
@@ -3321,6 +3499,7 @@ static int __init init_workqueues(void)
 	hotcpu_notifier(workqueue_cpu_down_callback, CPU_PRI_WORKQUEUE_DOWN);
 
 	wq_numa_init();
+	wq_unbound_cpumask_init();
 
 	
 	for_each_possible_cpu(cpu) {
@@ -154,7 +154,17 @@ static int lz4_uncompress(const char *source, char *dest, int osize)
 				goto _output_error;
 			continue;
 		}
-		LZ4_SECURECOPY(ref, op, cpy);
+		/*
+		 * Matches at least FASTCOPYLENGTH back do not overlap within
+		 * a 16 byte step, so they can be copied 16 bytes at a time.
+		 */
+		if ((op - ref) >= FASTCOPYLENGTH &&
+				cpy <= oend - FASTCOPYLENGTH) {
+			if (op < cpy)
+				LZ4_WILDCOPY16(ref, op, cpy);
+		} else {
+			LZ4_SECURECOPY(ref, op, cpy);
+		}
 		op = cpy; /* correction */
 	}
 	/* end of decoding */
@@ -218,7 +228,11 @@ static int lz4_uncompress_unknownoutputsize(const char *source, char *dest,
 			op += length;
 			break;/* Necessarily EOF, due to parsing restrictions */
 		}
-		LZ4_WILDCOPY(ip, op, cpy);
+		if ((cpy <= oend - FASTCOPYLENGTH) &&
+				(ip + length <= iend - FASTCOPYLENGTH))
+			LZ4_WILDCOPY16(ip, op, cpy);
+		else
+			LZ4_WILDCOPY(ip, op, cpy);
 		ip -= (op - cpy);
 		op = cpy;
 
@@ -283,7 +297,17 @@ static int lz4_uncompress_unknownoutputsize(const char *source, char *dest,
 				goto _output_error;
 			continue;
 		}
-		LZ4_SECURECOPY(ref, op, cpy);
+		/*
+		 * Matches at least FASTCOPYLENGTH back do not overlap within
+		 * a 16 byte step, so they can be copied 16 bytes at a time.
+		 */
+		if ((op - ref) >= FASTCOPYLENGTH &&
+				cpy <= oend - FASTCOPYLENGTH) {
+			if (op < cpy)
+				LZ4_WILDCOPY16(ref, op, cpy);
+		} else {
+			LZ4_SECURECOPY(ref, op, cpy);
+		}
 		op = cpy; /* correction */
 	}
 	/* end of decoding */
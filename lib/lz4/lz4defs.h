@@ -59,6 +59,8 @@ typedef struct _U64_S { u64 v; } U64_S;
 #endif
 
 #define COPYLENGTH 8
+/* margin needed by LZ4_WILDCOPY16, which may run 15 bytes past the end */
+#define FASTCOPYLENGTH 16
 #define ML_BITS  4
 #define ML_MASK  ((1U << ML_BITS) - 1)
 #define RUN_BITS (8 - ML_BITS)
@@ -99,6 +101,20 @@ typedef struct _U64_S { u64 v; } U64_S;
 
 #define LZ4_COPYPACKET(s, d)	LZ4_COPYSTEP(s, d)
 
+/* two independent 8 byte moves, paired into ldp/stp on arm64 */
+#define LZ4_COPY16(s, d)		\
+	do {				\
+		PUT8(s, d);		\
+		PUT8(((s) + 8), ((d) + 8));	\
+		d += 16;		\
+		s += 16;		\
+	} while (0)
+
+#define LZ4_WILDCOPY16(s, d, e)		\
+	do {				\
+		LZ4_COPY16(s, d);	\
+	} while (d < e)
+
 #define LZ4_SECURECOPY(s, d, e)			\
 	do {					\
 		if (d < e) {			\
@@ -130,6 +146,7 @@ typedef struct _U64_S { u64 v; } U64_S;
 	} while (0)
 
 #define LZ4_SECURECOPY	LZ4_WILDCOPY
+#define LZ4_WILDCOPY16	LZ4_WILDCOPY
 #define HTYPE const u8*
 
 #ifdef __BIG_ENDIAN
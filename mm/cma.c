@@ -35,10 +35,15 @@
 #include <linux/cma.h>
 #include <linux/highmem.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
 #include <trace/events/cma.h>
 
 #include "cma.h"
 
+/* how long pages migrated by cma_prefill() wait for their cma_alloc() */
+#define CMA_PREFILL_HOLD	(10 * HZ)
+
 struct cma cma_areas[MAX_CMA_AREAS];
 unsigned cma_area_count;
 static DEFINE_MUTEX(cma_mutex);
@@ -78,6 +83,147 @@ static void cma_clear_bitmap(struct cma *cma, unsigned long pfn, int count)
 	mutex_unlock(&cma->lock);
 }
 
+/* Give back the pages held by cma_prefill() */
+static void cma_prefill_release(struct cma *cma)
+{
+	unsigned long pfn, count;
+
+	mutex_lock(&cma->lock);
+	pfn = cma->base_pfn + (cma->prefill_start << cma->order_per_bit);
+	count = cma_prefill_pages(cma);
+	cma->prefill_count = 0;
+	mutex_unlock(&cma->lock);
+
+	if (!count)
+		return;
+
+	free_contig_range(pfn, count);
+	cma_clear_bitmap(cma, pfn, count);
+}
+
+/*
+ * Hand out the front of the prefilled range if the request fits in it.
+ * Bits skipped to honour the alignment go back to the area.
+ */
+static struct page *cma_alloc_prefilled(struct cma *cma, size_t count,
+					unsigned long mask)
+{
+	unsigned long bitmap_count = cma_bitmap_pages_to_bits(cma, count);
+	unsigned long bitmap_no, skip, pfn, nr;
+
+	mutex_lock(&cma->lock);
+	bitmap_no = ALIGN(cma->prefill_start, mask + 1);
+	skip = bitmap_no - cma->prefill_start;
+	if (!cma->prefill_count ||
+	    skip + bitmap_count > cma->prefill_count) {
+		mutex_unlock(&cma->lock);
+		return NULL;
+	}
+	pfn = cma->base_pfn + (cma->prefill_start << cma->order_per_bit);
+	cma->prefill_start = bitmap_no + bitmap_count;
+	cma->prefill_count -= skip + bitmap_count;
+	mutex_unlock(&cma->lock);
+
+	if (skip) {
+		free_contig_range(pfn, skip << cma->order_per_bit);
+		cma_clear_bitmap(cma, pfn, skip << cma->order_per_bit);
+	}
+
+	/* like alloc_contig_range() below, keep only the pages asked for */
+	pfn = cma->base_pfn + (bitmap_no << cma->order_per_bit);
+	nr = bitmap_count << cma->order_per_bit;
+	if (nr > count)
+		free_contig_range(pfn + count, nr - count);
+
+	return pfn_to_page(pfn);
+}
+
+static void cma_prefill_work_fn(struct work_struct *work)
+{
+	struct cma *cma = container_of(work, struct cma, prefill_work);
+	unsigned long bitmap_maxno = cma_bitmap_maxno(cma);
+	unsigned long bitmap_no, bitmap_count, held, pfn, start = 0;
+	int ret;
+
+	mutex_lock(&cma->lock);
+	bitmap_count = cma_bitmap_pages_to_bits(cma, cma->prefill_request);
+	held = cma->prefill_count;
+	mutex_unlock(&cma->lock);
+
+	if (bitmap_count && held >= bitmap_count)
+		goto out;
+
+	cma_prefill_release(cma);
+	if (!bitmap_count)
+		return;
+
+	for (;;) {
+		mutex_lock(&cma->lock);
+		bitmap_no = bitmap_find_next_zero_area(cma->bitmap,
+				bitmap_maxno, start, bitmap_count, 0);
+		if (bitmap_no >= bitmap_maxno) {
+			mutex_unlock(&cma->lock);
+			return;
+		}
+		bitmap_set(cma->bitmap, bitmap_no, bitmap_count);
+		mutex_unlock(&cma->lock);
+
+		pfn = cma->base_pfn + (bitmap_no << cma->order_per_bit);
+		mutex_lock(&cma_mutex);
+		ret = alloc_contig_range(pfn,
+				pfn + (bitmap_count << cma->order_per_bit),
+				MIGRATE_CMA);
+		mutex_unlock(&cma_mutex);
+		if (ret == 0)
+			break;
+
+		cma_clear_bitmap(cma, pfn, bitmap_count << cma->order_per_bit);
+		if (ret != -EBUSY)
+			return;
+		start = bitmap_no + 1;
+		cond_resched();
+	}
+
+	mutex_lock(&cma->lock);
+	cma->prefill_start = bitmap_no;
+	cma->prefill_count = bitmap_count;
+	mutex_unlock(&cma->lock);
+out:
+	mod_delayed_work(system_wq, &cma->prefill_expire, CMA_PREFILL_HOLD);
+}
+
+static void cma_prefill_expire_fn(struct work_struct *work)
+{
+	struct cma *cma = container_of(to_delayed_work(work), struct cma,
+				       prefill_expire);
+
+	cma_prefill_release(cma);
+}
+
+#ifdef CONFIG_CMA_DEBUGFS
+static void cma_account_alloc(struct cma *cma, ktime_t start,
+			      struct page *page, bool prefilled)
+{
+	unsigned long us = ktime_to_us(ktime_sub(ktime_get(), start));
+
+	mutex_lock(&cma->lock);
+	if (page) {
+		cma->nr_alloc++;
+		cma->nr_prefill_hit += prefilled;
+		cma->alloc_us_total += us;
+		cma->alloc_us_max = max(cma->alloc_us_max, us);
+	} else {
+		cma->nr_alloc_fail++;
+	}
+	mutex_unlock(&cma->lock);
+}
+#else
+static inline void cma_account_alloc(struct cma *cma, ktime_t start,
+				     struct page *page, bool prefilled)
+{
+}
+#endif
+
 static int __init cma_activate_area(struct cma *cma)
 {
 	int bitmap_size = BITS_TO_LONGS(cma_bitmap_maxno(cma)) * sizeof(long);
@@ -112,6 +258,8 @@ static int __init cma_activate_area(struct cma *cma)
 	} while (--i);
 
 	mutex_init(&cma->lock);
+	INIT_WORK(&cma->prefill_work, cma_prefill_work_fn);
+	INIT_DELAYED_WORK(&cma->prefill_expire, cma_prefill_expire_fn);
 
 #ifdef CONFIG_CMA_DEBUGFS
 	INIT_HLIST_HEAD(&cma->mem_head);
@@ -343,6 +491,8 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align)
 	struct page *page = NULL;
 	int ret;
 	int retry_after_sleep = 0;
+	bool prefilled = false;
+	ktime_t start_time = ktime_get();
 
 	if (!cma || !cma->count)
 		return NULL;
@@ -359,6 +509,13 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align)
 	bitmap_maxno = cma_bitmap_maxno(cma);
 	bitmap_count = cma_bitmap_pages_to_bits(cma, count);
 
+	page = cma_alloc_prefilled(cma, count, mask);
+	if (page) {
+		pfn = page_to_pfn(page);
+		prefilled = true;
+		goto out;
+	}
+
 	for (;;) {
 		mutex_lock(&cma->lock);
 		bitmap_no = bitmap_find_next_zero_area(cma->bitmap,
@@ -412,6 +569,8 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align)
 		start = bitmap_no + mask + 1;
 	}
 
+out:
+	cma_account_alloc(cma, start_time, page, prefilled);
 	trace_cma_alloc(page ? pfn : -1UL, page, count, align);
 
 	pr_debug("%s(): returned %p\n", __func__, page);
@@ -450,3 +609,26 @@ bool cma_release(struct cma *cma, struct page *pages, int count)
 
 	return true;
 }
+
+/**
+ * cma_prefill() - migrate pages out of a CMA area ahead of demand
+ * @cma:   Contiguous memory region to prepare.
+ * @count: Number of pages to keep ready, 0 to give them back.
+ *
+ * Queues a background pass that allocates @count contiguous pages from
+ * @cma and holds them for a few seconds, so that a cma_alloc() expected
+ * soon, such as a camera or secure video buffer, needs no migration.
+ * Pages not claimed in time are released. At most half of the area is
+ * held, so that other users of the area are not starved.
+ */
+void cma_prefill(struct cma *cma, size_t count)
+{
+	if (!cma || !cma->count)
+		return;
+
+	mutex_lock(&cma->lock);
+	cma->prefill_request = min_t(size_t, count, cma->count / 2);
+	mutex_unlock(&cma->lock);
+
+	queue_work(system_unbound_wq, &cma->prefill_work);
+}
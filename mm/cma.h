@@ -7,9 +7,25 @@ struct cma {
 	unsigned long   *bitmap;
 	unsigned int order_per_bit; /* Order of pages represented by one bit */
 	struct mutex    lock;
+	/*
+	 * Bits migrated ahead of demand by cma_prefill(). They are set in
+	 * the bitmap and handed out by cma_alloc() before it migrates
+	 * anything itself. Protected by lock.
+	 */
+	unsigned long prefill_start;
+	unsigned long prefill_count;
+	unsigned long prefill_request;	/* pages */
+	struct work_struct prefill_work;
+	struct delayed_work prefill_expire;
 #ifdef CONFIG_CMA_DEBUGFS
 	struct hlist_head mem_head;
 	spinlock_t mem_head_lock;
+	/* allocation statistics, protected by lock */
+	unsigned long nr_alloc;
+	unsigned long nr_alloc_fail;
+	unsigned long nr_prefill_hit;
+	unsigned long alloc_us_total;
+	unsigned long alloc_us_max;
 #endif
 };
 
@@ -21,4 +37,9 @@ static unsigned long cma_bitmap_maxno(struct cma *cma)
 	return cma->count >> cma->order_per_bit;
 }
 
+static inline unsigned long cma_prefill_pages(struct cma *cma)
+{
+	return cma->prefill_count << cma->order_per_bit;
+}
+
 #endif
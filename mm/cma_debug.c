@@ -161,6 +161,28 @@ static int cma_alloc_write(void *data, u64 val)
 }
 DEFINE_SIMPLE_ATTRIBUTE(cma_alloc_fops, NULL, cma_alloc_write, "%llu\n");
 
+static int cma_prefill_get(void *data, u64 *val)
+{
+	struct cma *cma = data;
+
+	mutex_lock(&cma->lock);
+	*val = cma_prefill_pages(cma);
+	mutex_unlock(&cma->lock);
+
+	return 0;
+}
+
+static int cma_prefill_set(void *data, u64 val)
+{
+	struct cma *cma = data;
+
+	cma_prefill(cma, val);
+
+	return 0;
+}
+DEFINE_SIMPLE_ATTRIBUTE(cma_prefill_fops, cma_prefill_get, cma_prefill_set,
+			"%llu\n");
+
 static void cma_debugfs_add_one(struct cma *cma, int idx)
 {
 	struct dentry *tmp;
@@ -185,6 +207,19 @@ static void cma_debugfs_add_one(struct cma *cma, int idx)
 				&cma->order_per_bit, &cma_debugfs_fops);
 	debugfs_create_file("used", S_IRUGO, tmp, cma, &cma_used_fops);
 	debugfs_create_file("maxchunk", S_IRUGO, tmp, cma, &cma_maxchunk_fops);
+	debugfs_create_file("prefill", S_IRUGO | S_IWUSR, tmp, cma,
+				&cma_prefill_fops);
+
+	debugfs_create_file("alloc_count", S_IRUGO, tmp,
+				&cma->nr_alloc, &cma_debugfs_fops);
+	debugfs_create_file("alloc_fail", S_IRUGO, tmp,
+				&cma->nr_alloc_fail, &cma_debugfs_fops);
+	debugfs_create_file("prefill_hit", S_IRUGO, tmp,
+				&cma->nr_prefill_hit, &cma_debugfs_fops);
+	debugfs_create_file("alloc_us_total", S_IRUGO, tmp,
+				&cma->alloc_us_total, &cma_debugfs_fops);
+	debugfs_create_file("alloc_us_max", S_IRUGO, tmp,
+				&cma->alloc_us_max, &cma_debugfs_fops);
 
 	u32s = DIV_ROUND_UP(cma_bitmap_maxno(cma), BITS_PER_BYTE * sizeof(u32));
 	debugfs_create_u32_array("bitmap", S_IRUGO, tmp, (u32*)cma->bitmap, u32s);
@@ -17,6 +17,9 @@
 #include <linux/balloon_compaction.h>
 #include <linux/page-isolation.h>
 #include <linux/kasan.h>
+#include <linux/kthread.h>
+#include <linux/freezer.h>
+#include <linux/timer.h>
 #include "internal.h"
 
 #ifdef CONFIG_COMPACTION
@@ -1525,6 +1528,137 @@ int sysctl_extfrag_handler(struct ctl_table *table, int write,
 	return 0;
 }
 
+/*
+ * Proactive compaction. Every sysctl_compaction_proactive_ms, kcompactd
+ * looks at each zone and compacts the ones where more than
+ * sysctl_compaction_proactive_index thousandths of the free memory sit
+ * in blocks smaller than COMPACT_PROACTIVE_ORDER. The order-2 to order-4
+ * allocations of ION, KGSL, binder and the network stack then rarely
+ * need to compact in their slow paths. kcompactd is SCHED_IDLE and
+ * compacts asynchronously, so a pass stops as soon as anything else
+ * wants the CPU. The wakeup timer is deferrable and does not keep an
+ * idle system awake.
+ */
+#define COMPACT_PROACTIVE_ORDER	4
+
+int sysctl_compaction_proactive_ms = 10000;
+int sysctl_compaction_proactive_index = 500;
+
+static DECLARE_WAIT_QUEUE_HEAD(kcompactd_wait);
+static bool kcompactd_kicked;
+
+static void kcompactd_timer_fn(unsigned long data)
+{
+	kcompactd_kicked = true;
+	wake_up_interruptible(&kcompactd_wait);
+}
+
+static struct timer_list kcompactd_timer =
+		TIMER_DEFERRED_INITIALIZER(kcompactd_timer_fn, 0, 0);
+
+static void kcompactd_arm_timer(void)
+{
+	int ms = ACCESS_ONCE(sysctl_compaction_proactive_ms);
+
+	if (ms)
+		mod_timer(&kcompactd_timer, jiffies + msecs_to_jiffies(ms));
+	else
+		del_timer(&kcompactd_timer);
+}
+
+/* Leave busy systems to on-demand compaction */
+static bool kcompactd_system_idle(void)
+{
+	return nr_running() < num_online_cpus();
+}
+
+static bool kcompactd_zone_fragmented(struct zone *zone)
+{
+	unsigned long watermark;
+
+	/* Short of free memory rather than fragmented, leave it to kswapd */
+	watermark = low_wmark_pages(zone) + (2UL << COMPACT_PROACTIVE_ORDER);
+	if (!zone_watermark_ok(zone, 0, watermark, 0, 0))
+		return false;
+
+	return zone_unusable_index(zone, COMPACT_PROACTIVE_ORDER) >
+		sysctl_compaction_proactive_index;
+}
+
+static void kcompactd_compact_zone(struct zone *zone)
+{
+	struct compact_control cc = {
+		.order = -1,
+		.mode = MIGRATE_ASYNC,
+		.zone = zone,
+	};
+
+	INIT_LIST_HEAD(&cc.freepages);
+	INIT_LIST_HEAD(&cc.migratepages);
+
+	compact_zone(zone, &cc);
+	count_vm_event(COMPACTPROACTIVE);
+
+	VM_BUG_ON(!list_empty(&cc.freepages));
+	VM_BUG_ON(!list_empty(&cc.migratepages));
+}
+
+static int kcompactd(void *unused)
+{
+	struct sched_param param = { .sched_priority = 0 };
+	struct zone *zone;
+
+	sched_setscheduler_nocheck(current, SCHED_IDLE, &param);
+	set_freezable();
+
+	while (!kthread_should_stop()) {
+		kcompactd_arm_timer();
+		wait_event_freezable(kcompactd_wait,
+				     kcompactd_kicked || kthread_should_stop());
+		kcompactd_kicked = false;
+
+		if (!sysctl_compaction_proactive_ms || !kcompactd_system_idle())
+			continue;
+
+		for_each_populated_zone(zone) {
+			if (kthread_should_stop())
+				break;
+			if (kcompactd_zone_fragmented(zone))
+				kcompactd_compact_zone(zone);
+		}
+	}
+
+	return 0;
+}
+
+int sysctl_compaction_proactive_handler(struct ctl_table *table, int write,
+			void __user *buffer, size_t *length, loff_t *ppos)
+{
+	int ret;
+
+	ret = proc_dointvec_minmax(table, write, buffer, length, ppos);
+	if (ret || !write)
+		return ret;
+
+	kcompactd_arm_timer();
+
+	return 0;
+}
+
+static int __init kcompactd_init(void)
+{
+	struct task_struct *tsk;
+
+	tsk = kthread_run(kcompactd, NULL, "kcompactd");
+	if (IS_ERR(tsk)) {
+		pr_err("Failed to start kcompactd\n");
+		return PTR_ERR(tsk);
+	}
+
+	return 0;
+}
+module_init(kcompactd_init);
+
 #if defined(CONFIG_SYSFS) && defined(CONFIG_NUMA)
 static ssize_t sysfs_compact_node(struct device *dev,
 			struct device_attribute *attr,
@@ -35,6 +35,8 @@
 #include <linux/memcontrol.h>
 #include <linux/cleancache.h>
 #include <linux/rmap.h>
+#include <linux/memstall.h>
+#include <linux/launch_prefetch.h>
 #include "internal.h"
 
 #define CREATE_TRACE_POINTS
@@ -1489,6 +1491,8 @@ static ssize_t do_generic_file_read(struct file *filp, loff_t *ppos,
 find_page:
 		page = find_get_page(mapping, index);
 		if (!page) {
+			launch_prefetch_record(filp, index,
+					       last_index - index);
 			page_cache_sync_readahead(mapping,
 					ra, filp,
 					index, last_index - index);
@@ -1873,6 +1877,8 @@ int filemap_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 	pgoff_t offset = vmf->pgoff;
 	struct page *page;
 	loff_t size;
+	bool stalled;
+	int locked;
 	int ret = 0;
 
 	size = round_up(i_size_read(inode), PAGE_CACHE_SIZE);
@@ -1891,6 +1897,7 @@ int filemap_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 		do_async_mmap_readahead(vma, ra, file, page, offset);
 	} else if (!page) {
 		/* No page in the page cache at all */
+		launch_prefetch_record(file, offset, 1);
 		do_sync_mmap_readahead(vma, ra, file, offset);
 		count_vm_event(PGMAJFAULT);
 		mem_cgroup_count_vm_event(vma->vm_mm, PGMAJFAULT);
@@ -1901,7 +1908,17 @@ retry_find:
 			goto no_cached_page;
 	}
 
-	if (!lock_page_or_retry(page, vma->vm_mm, vmf->flags)) {
+	/*
+	 * A page still being read in is only active if add_to_page_cache_lru()
+	 * found it to be a working set refault, waiting for it is a stall.
+	 */
+	stalled = PageActive(page) && !PageUptodate(page);
+	if (stalled)
+		memstall_enter();
+	locked = lock_page_or_retry(page, vma->vm_mm, vmf->flags);
+	if (stalled)
+		memstall_leave();
+	if (!locked) {
 		page_cache_release(page);
 		return ret | VM_FAULT_RETRY;
 	}
@@ -0,0 +1,394 @@
+/*
+ * mm/launch_prefetch.c
+ *
+ * App launch prefetch.
+ *
+ * While a launch is being recorded, page cache misses taken by tasks of
+ * the recorded uid in the read and fault paths are logged as file
+ * extents. The trace is kept, sorted and merged, once recording stops.
+ * A later launch hint for the same uid replays the trace from a worker,
+ * issuing readahead for every recorded extent so that the launch finds
+ * its APK, odex and library pages already in the page cache.
+ *
+ * Control is through /proc/launch_prefetch:
+ *	record <uid>	start recording, stops by itself after 10s
+ *	stop		stop recording and keep the trace
+ *	replay <uid>	prefetch the trace recorded for <uid>
+ *	clear		drop all traces
+ * Reading it lists the traces held.
+ */
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/sort.h>
+#include <linux/mm.h>
+#include <linux/file.h>
+#include <linux/cred.h>
+#include <linux/uidgid.h>
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+#include <linux/launch_prefetch.h>
+
+#define LP_RECORD_TIME		(10 * HZ)
+#define LP_MAX_EXTENTS		4096
+#define LP_MAX_TRACES		8
+/* misses this close to the last extent of the same file extend it */
+#define LP_MERGE_GAP		16
+/* number of recent extents looked at when merging a miss */
+#define LP_MERGE_LOOKBACK	8
+
+struct lp_extent {
+	struct file *file;
+	pgoff_t start;
+	unsigned long nr;
+};
+
+struct lp_trace {
+	struct list_head list;
+	kuid_t uid;
+	unsigned int nr_extents;
+	unsigned long nr_pages;
+	unsigned long replays;
+	struct lp_extent *extents;
+};
+
+bool launch_prefetch_recording;
+
+/* Protects lp_recorded while it is being filled */
+static DEFINE_SPINLOCK(lp_record_lock);
+static struct lp_trace *lp_recorded;
+
+/* Protects lp_traces, most recently used first, and lp_replay_uid */
+static DEFINE_MUTEX(lp_mutex);
+static LIST_HEAD(lp_traces);
+static unsigned int lp_nr_traces;
+static kuid_t lp_replay_uid;
+
+static void lp_stop_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(lp_stop_work, lp_stop_work_fn);
+static void lp_replay_work_fn(struct work_struct *work);
+static DECLARE_WORK(lp_replay_work, lp_replay_work_fn);
+
+static struct lp_trace *lp_trace_alloc(kuid_t uid)
+{
+	struct lp_trace *trace;
+
+	trace = kzalloc(sizeof(*trace), GFP_KERNEL);
+	if (!trace)
+		return NULL;
+
+	trace->extents = vzalloc(LP_MAX_EXTENTS * sizeof(struct lp_extent));
+	if (!trace->extents) {
+		kfree(trace);
+		return NULL;
+	}
+	trace->uid = uid;
+	INIT_LIST_HEAD(&trace->list);
+
+	return trace;
+}
+
+static void lp_trace_free(struct lp_trace *trace)
+{
+	unsigned int i;
+
+	if (!trace)
+		return;
+
+	for (i = 0; i < trace->nr_extents; i++)
+		fput(trace->extents[i].file);
+	vfree(trace->extents);
+	kfree(trace);
+}
+
+void __launch_prefetch_record(struct file *file, pgoff_t start,
+			      unsigned long nr)
+{
+	struct lp_trace *trace;
+	struct lp_extent *ext;
+	unsigned int i;
+
+	if (!nr)
+		return;
+
+	spin_lock(&lp_record_lock);
+	trace = lp_recorded;
+	if (!trace || !uid_eq(current_uid(), trace->uid))
+		goto out;
+
+	for (i = 0; i < min_t(unsigned int, trace->nr_extents,
+			      LP_MERGE_LOOKBACK); i++) {
+		ext = &trace->extents[trace->nr_extents - 1 - i];
+		if (file_inode(ext->file) != file_inode(file))
+			continue;
+		if (start + nr + LP_MERGE_GAP < ext->start ||
+		    start > ext->start + ext->nr + LP_MERGE_GAP)
+			continue;
+
+		if (start < ext->start) {
+			ext->nr += ext->start - start;
+			ext->start = start;
+		}
+		if (start + nr > ext->start + ext->nr)
+			ext->nr = start + nr - ext->start;
+		goto out;
+	}
+
+	if (trace->nr_extents == LP_MAX_EXTENTS)
+		goto out;
+
+	ext = &trace->extents[trace->nr_extents++];
+	ext->file = get_file(file);
+	ext->start = start;
+	ext->nr = nr;
+out:
+	spin_unlock(&lp_record_lock);
+}
+
+static int lp_extent_cmp(const void *a, const void *b)
+{
+	const struct lp_extent *ea = a, *eb = b;
+	struct inode *ia = file_inode(ea->file), *ib = file_inode(eb->file);
+
+	if (ia != ib)
+		return ia < ib ? -1 : 1;
+	if (ea->start != eb->start)
+		return ea->start < eb->start ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Sort the extents by file and offset and merge the ones that overlap,
+ * so that replay issues one large readahead per file range in order.
+ */
+static void lp_trace_compact(struct lp_trace *trace)
+{
+	struct lp_extent *ext = trace->extents;
+	unsigned int i, n = 0;
+
+	sort(ext, trace->nr_extents, sizeof(*ext), lp_extent_cmp, NULL);
+
+	trace->nr_pages = 0;
+	for (i = 0; i < trace->nr_extents; i++) {
+		struct lp_extent *prev = n ? &ext[n - 1] : NULL;
+
+		if (prev && file_inode(prev->file) == file_inode(ext[i].file) &&
+		    ext[i].start <= prev->start + prev->nr + LP_MERGE_GAP) {
+			if (ext[i].start + ext[i].nr > prev->start + prev->nr)
+				prev->nr = ext[i].start + ext[i].nr -
+					   prev->start;
+			fput(ext[i].file);
+			continue;
+		}
+		ext[n++] = ext[i];
+	}
+	trace->nr_extents = n;
+
+	for (i = 0; i < n; i++)
+		trace->nr_pages += ext[i].nr;
+}
+
+/* Caller holds lp_mutex */
+static struct lp_trace *lp_find_trace(kuid_t uid)
+{
+	struct lp_trace *trace;
+
+	list_for_each_entry(trace, &lp_traces, list) {
+		if (uid_eq(trace->uid, uid))
+			return trace;
+	}
+
+	return NULL;
+}
+
+/* Caller holds lp_mutex */
+static void lp_remove_trace(struct lp_trace *trace)
+{
+	list_del(&trace->list);
+	lp_nr_traces--;
+	lp_trace_free(trace);
+}
+
+/* Caller holds lp_mutex */
+static void lp_stop_recording(void)
+{
+	struct lp_trace *trace, *old;
+
+	spin_lock(&lp_record_lock);
+	trace = lp_recorded;
+	lp_recorded = NULL;
+	launch_prefetch_recording = false;
+	spin_unlock(&lp_record_lock);
+
+	if (!trace)
+		return;
+
+	if (!trace->nr_extents) {
+		lp_trace_free(trace);
+		return;
+	}
+
+	lp_trace_compact(trace);
+
+	old = lp_find_trace(trace->uid);
+	if (old) {
+		trace->replays = old->replays;
+		lp_remove_trace(old);
+	}
+	if (lp_nr_traces == LP_MAX_TRACES)
+		lp_remove_trace(list_last_entry(&lp_traces, struct lp_trace,
+						list));
+
+	list_add(&trace->list, &lp_traces);
+	lp_nr_traces++;
+}
+
+/* Caller holds lp_mutex */
+static int lp_start_recording(kuid_t uid)
+{
+	struct lp_trace *trace;
+
+	lp_stop_recording();
+
+	trace = lp_trace_alloc(uid);
+	if (!trace)
+		return -ENOMEM;
+
+	spin_lock(&lp_record_lock);
+	lp_recorded = trace;
+	launch_prefetch_recording = true;
+	spin_unlock(&lp_record_lock);
+
+	mod_delayed_work(system_wq, &lp_stop_work, LP_RECORD_TIME);
+
+	return 0;
+}
+
+static void lp_stop_work_fn(struct work_struct *work)
+{
+	mutex_lock(&lp_mutex);
+	lp_stop_recording();
+	mutex_unlock(&lp_mutex);
+}
+
+static void lp_replay_work_fn(struct work_struct *work)
+{
+	struct lp_trace *trace;
+	unsigned int i;
+
+	mutex_lock(&lp_mutex);
+	trace = lp_find_trace(lp_replay_uid);
+	if (!trace)
+		goto out;
+
+	list_move(&trace->list, &lp_traces);
+	trace->replays++;
+
+	/* pages already cached are skipped by the readahead code */
+	for (i = 0; i < trace->nr_extents; i++) {
+		struct lp_extent *ext = &trace->extents[i];
+
+		force_page_cache_readahead(ext->file->f_mapping, ext->file,
+					   ext->start, ext->nr);
+		cond_resched();
+	}
+out:
+	mutex_unlock(&lp_mutex);
+}
+
+static int lp_parse_uid(const char *buf, kuid_t *uid)
+{
+	unsigned int val;
+
+	if (kstrtouint(buf, 10, &val))
+		return -EINVAL;
+
+	*uid = make_kuid(current_user_ns(), val);
+	if (!uid_valid(*uid))
+		return -EINVAL;
+
+	return 0;
+}
+
+static ssize_t lp_write(struct file *file, const char __user *ubuf,
+			size_t count, loff_t *ppos)
+{
+	char buf[32];
+	char *cmd;
+	kuid_t uid;
+	int ret = 0;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+	cmd = strim(buf);
+
+	mutex_lock(&lp_mutex);
+	if (!strncmp(cmd, "record ", 7)) {
+		ret = lp_parse_uid(cmd + 7, &uid);
+		if (!ret)
+			ret = lp_start_recording(uid);
+	} else if (!strcmp(cmd, "stop")) {
+		cancel_delayed_work(&lp_stop_work);
+		lp_stop_recording();
+	} else if (!strncmp(cmd, "replay ", 7)) {
+		ret = lp_parse_uid(cmd + 7, &uid);
+		if (!ret) {
+			lp_replay_uid = uid;
+			queue_work(system_unbound_wq, &lp_replay_work);
+		}
+	} else if (!strcmp(cmd, "clear")) {
+		struct lp_trace *trace, *tmp;
+
+		list_for_each_entry_safe(trace, tmp, &lp_traces, list)
+			lp_remove_trace(trace);
+	} else {
+		ret = -EINVAL;
+	}
+	mutex_unlock(&lp_mutex);
+
+	return ret ? ret : count;
+}
+
+static int lp_show(struct seq_file *m, void *v)
+{
+	struct lp_trace *trace;
+
+	seq_puts(m, "uid extents pages replays\n");
+
+	mutex_lock(&lp_mutex);
+	list_for_each_entry(trace, &lp_traces, list)
+		seq_printf(m, "%u %u %lu %lu\n",
+			   from_kuid_munged(seq_user_ns(m), trace->uid),
+			   trace->nr_extents, trace->nr_pages, trace->replays);
+	mutex_unlock(&lp_mutex);
+
+	return 0;
+}
+
+static int lp_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, lp_show, NULL);
+}
+
+static const struct file_operations lp_fops = {
+	.open		= lp_open,
+	.read		= seq_read,
+	.write		= lp_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init launch_prefetch_init(void)
+{
+	proc_create("launch_prefetch", S_IRUSR | S_IWUSR, NULL, &lp_fops);
+	return 0;
+}
+module_init(launch_prefetch_init);
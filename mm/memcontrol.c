@@ -102,6 +102,8 @@ enum mem_cgroup_events_index {
 	MEM_CGROUP_EVENTS_PGPGOUT,	/* # of pages paged out */
 	MEM_CGROUP_EVENTS_PGFAULT,	/* # of page-faults */
 	MEM_CGROUP_EVENTS_PGMAJFAULT,	/* # of major page-faults */
+	MEM_CGROUP_EVENTS_REFAULT,	/* # of workingset refaults */
+	MEM_CGROUP_EVENTS_ACTIVATE,	/* # of refaults activated */
 	MEM_CGROUP_EVENTS_NSTATS,
 };
 
@@ -110,6 +112,8 @@ static const char * const mem_cgroup_events_names[] = {
 	"pgpgout",
 	"pgfault",
 	"pgmajfault",
+	"workingset_refault",
+	"workingset_activate",
 };
 
 static const char * const mem_cgroup_lru_names[] = {
@@ -1312,6 +1316,26 @@ out:
 }
 EXPORT_SYMBOL(__mem_cgroup_count_vm_event);
 
+/*
+ * Refaults are charged to the memcg of the task reading the page back,
+ * the same way major faults are.
+ */
+void __mem_cgroup_count_workingset(bool activate)
+{
+	struct mem_cgroup *memcg;
+
+	rcu_read_lock();
+	memcg = mem_cgroup_from_task(current);
+	if (unlikely(!memcg))
+		goto out;
+
+	this_cpu_inc(memcg->stat->events[MEM_CGROUP_EVENTS_REFAULT]);
+	if (activate)
+		this_cpu_inc(memcg->stat->events[MEM_CGROUP_EVENTS_ACTIVATE]);
+out:
+	rcu_read_unlock();
+}
+
 /**
  * mem_cgroup_zone_lruvec - get the lru list vector for a zone and memcg
  * @zone: zone of the wanted lruvec
@@ -61,6 +61,7 @@
 #include <linux/string.h>
 #include <linux/dma-debug.h>
 #include <linux/debugfs.h>
+#include <linux/memstall.h>
 
 #include <asm/io.h>
 #include <asm/pgalloc.h>
@@ -2412,6 +2413,7 @@ static int do_swap_page(struct mm_struct *mm, struct vm_area_struct *vma,
 	pte_t pte;
 	int locked;
 	int exclusive = 0;
+	bool stalled = false;
 	int ret = 0;
 
 	if (!pte_unmap_same(mm, pmd, page_table, orig_pte))
@@ -2432,9 +2434,12 @@ static int do_swap_page(struct mm_struct *mm, struct vm_area_struct *vma,
 	delayacct_set_flag(DELAYACCT_PF_SWAPIN);
 	page = lookup_swap_cache(entry);
 	if (!page) {
+		memstall_enter();
+		stalled = true;
 		page = swapin_readahead(entry,
 					GFP_HIGHUSER_MOVABLE, vma, address);
 		if (!page) {
+			memstall_leave();
 			/*
 			 * Back out if somebody else faulted in this pte
 			 * while we released the pte lock.
@@ -2464,6 +2469,8 @@ static int do_swap_page(struct mm_struct *mm, struct vm_area_struct *vma,
 	swapcache = page;
 	locked = lock_page_or_retry(page, mm, flags);
 
+	if (stalled)
+		memstall_leave();
 	delayacct_clear_flag(DELAYACCT_PF_SWAPIN);
 	if (!locked) {
 		ret |= VM_FAULT_RETRY;
@@ -0,0 +1,164 @@
+/*
+ * mm/memstall.c
+ *
+ * Memory stall accounting.
+ *
+ * Tracks the wall time during which at least one task is stalled on
+ * memory: in direct reclaim, reading a page back from swap or waiting
+ * for a refaulted working set page. Sections are bracketed with
+ * memstall_enter()/memstall_leave() and may nest. The share of time
+ * spent stalled is sampled every two seconds into 10s and 60s running
+ * averages, reported in /proc/memstall and to the low memory killer.
+ */
+#include <linux/init.h>
+#include <linux/export.h>
+#include <linux/kernel.h>
+#include <linux/sched.h>
+#include <linux/spinlock.h>
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/memstall.h>
+
+#define MEMSTALL_FREQ		(2 * HZ)
+#define MEMSTALL_FREQ_NS	(2 * NSEC_PER_SEC)
+/* 1/exp(2s/10s) and 1/exp(2s/60s) as fixed-point, see CALC_LOAD() */
+#define EXP_10s			1677
+#define EXP_60s			1981
+/* after this many idle periods both averages have decayed to ~0 */
+#define MEMSTALL_MAX_MISSED	150
+
+#define LOAD_INT(x) ((x) >> FSHIFT)
+#define LOAD_FRAC(x) LOAD_INT(((x) & (FIXED_1-1)) * 100)
+
+static DEFINE_SPINLOCK(memstall_lock);
+/* number of tasks inside a stall section, nested ones counted twice */
+static unsigned int nr_stalled;
+static u64 stall_start;
+static u64 stall_total;
+
+/* only touched from memstall_work */
+static u64 last_total;
+static u64 last_update;
+/* fixed-point percentages, read locklessly */
+static unsigned long avg10;
+static unsigned long avg60;
+
+static void memstall_work_fn(struct work_struct *work);
+static DECLARE_DEFERRABLE_WORK(memstall_work, memstall_work_fn);
+
+/* Caller holds memstall_lock */
+static void memstall_account(u64 now)
+{
+	if (nr_stalled)
+		stall_total += now - stall_start;
+	stall_start = now;
+}
+
+void memstall_enter(void)
+{
+	u64 now = ktime_get_ns();
+
+	spin_lock(&memstall_lock);
+	memstall_account(now);
+	nr_stalled++;
+	spin_unlock(&memstall_lock);
+}
+
+void memstall_leave(void)
+{
+	u64 now = ktime_get_ns();
+
+	spin_lock(&memstall_lock);
+	memstall_account(now);
+	nr_stalled--;
+	spin_unlock(&memstall_lock);
+}
+
+/* Percentage of the last ~10s that some task was stalled on memory */
+unsigned long memstall_avg10(void)
+{
+	return LOAD_INT(ACCESS_ONCE(avg10));
+}
+EXPORT_SYMBOL_GPL(memstall_avg10);
+
+unsigned long memstall_avg60(void)
+{
+	return LOAD_INT(ACCESS_ONCE(avg60));
+}
+EXPORT_SYMBOL_GPL(memstall_avg60);
+
+static void memstall_work_fn(struct work_struct *work)
+{
+	unsigned long a10 = avg10, a60 = avg60;
+	unsigned long pct, missed;
+	u64 now, total, period;
+
+	now = ktime_get_ns();
+	spin_lock(&memstall_lock);
+	memstall_account(now);
+	total = stall_total;
+	spin_unlock(&memstall_lock);
+
+	period = now - last_update;
+	pct = min_t(u64, div64_u64((total - last_total) * 100 * FIXED_1,
+				   max_t(u64, period, 1)), 100 * FIXED_1);
+	last_total = total;
+	last_update = now;
+
+	/*
+	 * The work is deferrable, so on an idle system several periods
+	 * may have passed. Nothing stalled while idle, decay for those.
+	 */
+	missed = min_t(u64, div64_u64(period, MEMSTALL_FREQ_NS),
+		       MEMSTALL_MAX_MISSED);
+	while (missed-- > 1) {
+		CALC_LOAD(a10, EXP_10s, 0);
+		CALC_LOAD(a60, EXP_60s, 0);
+	}
+	CALC_LOAD(a10, EXP_10s, pct);
+	CALC_LOAD(a60, EXP_60s, pct);
+	avg10 = a10;
+	avg60 = a60;
+
+	schedule_delayed_work(&memstall_work, MEMSTALL_FREQ);
+}
+
+static int memstall_show(struct seq_file *m, void *v)
+{
+	unsigned long a10 = avg10, a60 = avg60;
+	u64 total;
+
+	spin_lock(&memstall_lock);
+	memstall_account(ktime_get_ns());
+	total = stall_total;
+	spin_unlock(&memstall_lock);
+
+	seq_printf(m, "some avg10=%lu.%02lu avg60=%lu.%02lu total=%llu\n",
+		   LOAD_INT(a10), LOAD_FRAC(a10),
+		   LOAD_INT(a60), LOAD_FRAC(a60),
+		   div_u64(total, NSEC_PER_USEC));
+	return 0;
+}
+
+static int memstall_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, memstall_show, NULL);
+}
+
+static const struct file_operations memstall_fops = {
+	.open		= memstall_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init memstall_init(void)
+{
+	last_update = ktime_get_ns();
+	schedule_delayed_work(&memstall_work, MEMSTALL_FREQ);
+	proc_create("memstall", S_IRUGO, NULL, &memstall_fops);
+	return 0;
+}
+module_init(memstall_init);
@@ -60,6 +60,7 @@
 #include <linux/page-debug-flags.h>
 #include <linux/hugetlb.h>
 #include <linux/sched/rt.h>
+#include <linux/memstall.h>
 
 #include <asm/sections.h>
 #include <asm/tlbflush.h>
@@ -581,6 +582,59 @@ static void free_pcppages_bulk(struct zone *zone, int count,
 	spin_unlock(&zone->lock);
 }
 
+/*
+ * Limits of the per-cpu lists of order > 0, in blocks. They scale with
+ * the order-0 ones and keep roughly as many pages at each order as a
+ * quarter of the order-0 high mark. A zero high mark, as on the boot
+ * pagesets, disables them.
+ */
+static inline int pcp_horder_high(struct per_cpu_pages *pcp,
+				  unsigned int order)
+{
+	return ACCESS_ONCE(pcp->high) >> (order + 2);
+}
+
+static inline int pcp_horder_batch(struct per_cpu_pages *pcp,
+				   unsigned int order)
+{
+	return max(1, ACCESS_ONCE(pcp->batch) >> (order + 1));
+}
+
+static void free_pcp_horder_bulk(struct zone *zone, int count,
+				 struct per_cpu_pages *pcp, unsigned int order)
+{
+	struct list_head *lists = pcp->horder_lists[order - 1];
+	int migratetype;
+	unsigned long nr_scanned;
+
+	spin_lock(&zone->lock);
+	nr_scanned = zone_page_state(zone, NR_PAGES_SCANNED);
+	if (nr_scanned)
+		__mod_zone_page_state(zone, NR_PAGES_SCANNED, -nr_scanned);
+
+	for (migratetype = 0; count && migratetype < MIGRATE_PCPTYPES;
+	     migratetype++) {
+		struct list_head *list = &lists[migratetype];
+
+		while (count && !list_empty(list)) {
+			struct page *page;
+			int mt;
+
+			page = list_entry(list->prev, struct page, lru);
+			list_del(&page->lru);
+			mt = get_freepage_migratetype(page);
+			if (unlikely(has_isolate_pageblock(zone)))
+				mt = get_pageblock_migratetype(page);
+
+			__free_one_page(page, page_to_pfn(page), zone, order,
+					mt);
+			trace_mm_page_pcpu_drain(page, order, mt);
+			count--;
+		}
+	}
+	spin_unlock(&zone->lock);
+}
+
 static void free_one_page(struct zone *zone,
 				struct page *page, unsigned long pfn,
 				unsigned int order,
@@ -600,6 +654,39 @@ static void free_one_page(struct zone *zone,
 	spin_unlock(&zone->lock);
 }
 
+/* Caller has interrupts disabled */
+static void free_pcp_horder(struct zone *zone, struct page *page,
+			    unsigned long pfn, unsigned int order,
+			    int migratetype)
+{
+	struct per_cpu_pages *pcp;
+	int *count;
+
+	if (migratetype >= MIGRATE_PCPTYPES) {
+		if (unlikely(is_migrate_isolate(migratetype))) {
+			free_one_page(zone, page, pfn, order, migratetype);
+			return;
+		}
+		migratetype = MIGRATE_MOVABLE;
+	}
+
+	/* __free_one_page() would do this once the block left the list */
+	if (unlikely(PageCompound(page)))
+		if (unlikely(destroy_compound_page(page, order)))
+			return;
+
+	pcp = &this_cpu_ptr(zone->pageset)->pcp;
+	count = &pcp->horder_count[order - 1];
+	list_add(&page->lru, &pcp->horder_lists[order - 1][migratetype]);
+	(*count)++;
+	if (*count >= pcp_horder_high(pcp, order)) {
+		int batch = min(pcp_horder_batch(pcp, order), *count);
+
+		free_pcp_horder_bulk(zone, batch, pcp, order);
+		*count -= batch;
+	}
+}
+
 static bool free_pages_prepare(struct page *page, unsigned int order)
 {
 	int i;
@@ -641,7 +728,11 @@ static void __free_pages_ok(struct page *page, unsigned int order)
 	local_irq_save(flags);
 	__count_vm_events(PGFREE, 1 << order);
 	set_freepage_migratetype(page, migratetype);
-	free_one_page(page_zone(page), page, pfn, order, migratetype);
+	if (order && order <= PCP_HORDER_MAX)
+		free_pcp_horder(page_zone(page), page, pfn, order,
+				migratetype);
+	else
+		free_one_page(page_zone(page), page, pfn, order, migratetype);
 	local_irq_restore(flags);
 }
 
@@ -1080,6 +1171,61 @@ static struct list_head *get_populated_pcp_list(struct zone *zone,
 	return list;
 }
 
+/* Caller has interrupts disabled */
+static struct page *rmqueue_pcp_horder(struct zone *zone, unsigned int order,
+				       gfp_t gfp_flags, int migratetype,
+				       bool cold)
+{
+	struct per_cpu_pages *pcp = &this_cpu_ptr(zone->pageset)->pcp;
+	int batch = pcp_horder_batch(pcp, order);
+	struct list_head *list;
+	struct page *page;
+
+	list = &pcp->horder_lists[order - 1][migratetype];
+	if (migratetype == MIGRATE_MOVABLE && gfp_flags & __GFP_CMA) {
+		struct list_head *cma_list;
+
+		cma_list = &pcp->horder_lists[order - 1]
+					     [get_cma_migrate_type()];
+		if (list_empty(cma_list))
+			pcp->horder_count[order - 1] += rmqueue_bulk(zone,
+					order, batch, cma_list,
+					get_cma_migrate_type(), cold);
+		if (!list_empty(cma_list))
+			list = cma_list;
+	}
+
+	if (list_empty(list))
+		pcp->horder_count[order - 1] += rmqueue_bulk(zone, order,
+					batch, list, migratetype, cold);
+	if (list_empty(list))
+		return NULL;
+
+	if (cold)
+		page = list_entry(list->prev, struct page, lru);
+	else
+		page = list_entry(list->next, struct page, lru);
+
+	list_del(&page->lru);
+	pcp->horder_count[order - 1]--;
+
+	return page;
+}
+
+static bool pcp_has_pages(struct per_cpu_pages *pcp)
+{
+	int i;
+
+	if (pcp->count)
+		return true;
+
+	for (i = 0; i < PCP_HORDER_MAX; i++)
+		if (pcp->horder_count[i])
+			return true;
+
+	return false;
+}
+
 #ifdef CONFIG_NUMA
 void drain_zone_pages(struct zone *zone, struct per_cpu_pages *pcp)
 {
@@ -1101,6 +1247,7 @@ static void drain_pages(unsigned int cpu)
 {
 	unsigned long flags;
 	struct zone *zone;
+	unsigned int order;
 
 	for_each_populated_zone(zone) {
 		struct per_cpu_pageset *pset;
@@ -1114,6 +1261,14 @@ static void drain_pages(unsigned int cpu)
 			free_pcppages_bulk(zone, pcp->count, pcp);
 			pcp->count = 0;
 		}
+		for (order = 1; order <= PCP_HORDER_MAX; order++) {
+			int count = pcp->horder_count[order - 1];
+
+			if (count) {
+				free_pcp_horder_bulk(zone, count, pcp, order);
+				pcp->horder_count[order - 1] = 0;
+			}
+		}
 		local_irq_restore(flags);
 	}
 }
@@ -1135,7 +1290,7 @@ void drain_all_pages(void)
 		bool has_pcps = false;
 		for_each_populated_zone(zone) {
 			pcp = per_cpu_ptr(zone->pageset, cpu);
-			if (pcp->pcp.count) {
+			if (pcp_has_pages(&pcp->pcp)) {
 				has_pcps = true;
 				break;
 			}
@@ -1347,6 +1502,15 @@ again:
 
 		list_del(&page->lru);
 		pcp->count--;
+	} else if (order <= PCP_HORDER_MAX) {
+		if (unlikely(gfp_flags & __GFP_NOFAIL)) {
+			WARN_ON_ONCE(order > 1);
+		}
+		local_irq_save(flags);
+		page = rmqueue_pcp_horder(zone, order, gfp_flags, migratetype,
+					  cold);
+		if (!page)
+			goto failed;
 	} else {
 		if (unlikely(gfp_flags & __GFP_NOFAIL)) {
 			WARN_ON_ONCE(order > 1);
@@ -1990,7 +2154,9 @@ __perform_reclaim(gfp_t gfp_mask, unsigned int order, struct zonelist *zonelist,
 	reclaim_state.reclaimed_slab = 0;
 	current->reclaim_state = &reclaim_state;
 
+	memstall_enter();
 	progress = try_to_free_pages(zonelist, order, gfp_mask, nodemask);
+	memstall_leave();
 
 	current->reclaim_state = NULL;
 	lockdep_clear_current_reclaim_state();
@@ -2291,6 +2457,14 @@ got_pg:
 	return page;
 }
 
+/* Count high-order allocation outcomes, orders above 4 together */
+static inline void count_horder_alloc(unsigned int order, struct page *page)
+{
+	unsigned int idx = min(order, 5U) - 1;
+
+	count_vm_event((page ? PGALLOC_ORDER_1 : PGALLOC_ORDER_1_FAIL) + idx);
+}
+
 struct page *
 __alloc_pages_nodemask(gfp_t gfp_mask, unsigned int order,
 			struct zonelist *zonelist, nodemask_t *nodemask)
@@ -2347,6 +2521,9 @@ out:
 	if (unlikely(!page && read_mems_allowed_retry(cpuset_mems_cookie)))
 		goto retry_cpuset;
 
+	if (order)
+		count_horder_alloc(order, page);
+
 	if (page)
 		set_page_owner(page, order, gfp_mask);
 
@@ -3384,8 +3561,13 @@ static void pageset_init(struct per_cpu_pageset *p)
 
 	pcp = &p->pcp;
 	pcp->count = 0;
-	for (migratetype = 0; migratetype < MIGRATE_PCPTYPES; migratetype++)
+	for (migratetype = 0; migratetype < MIGRATE_PCPTYPES; migratetype++) {
+		int i;
+
 		INIT_LIST_HEAD(&pcp->lists[migratetype]);
+		for (i = 0; i < PCP_HORDER_MAX; i++)
+			INIT_LIST_HEAD(&pcp->horder_lists[i][migratetype]);
+	}
 }
 
 static void setup_pageset(struct per_cpu_pageset *p, unsigned long batch)
@@ -3837,6 +4019,7 @@ static void __paginginit free_area_init_core(struct pglist_data *pgdat,
 	pgdat->numabalancing_migrate_next_window = jiffies;
 #endif
 	init_waitqueue_head(&pgdat->kswapd_wait);
+	init_waitqueue_head(&pgdat->kswapd_helper_wait);
 	init_waitqueue_head(&pgdat->pfmemalloc_wait);
 	pgdat_page_cgroup_init(pgdat);
 
@@ -19,6 +19,7 @@
 #include <linux/sched.h>
 #include <linux/rcupdate.h>
 #include <linux/notifier.h>
+#include <linux/mutex.h>
 #include <linux/vmpressure.h>
 
 #define CREATE_TRACE_POINTS
@@ -214,6 +215,87 @@ static void swap_fn(struct work_struct *work)
 	}
 }
 
+/*
+ * Targeted reclaim for callers that know which task to shrink, e.g. the
+ * framework moving an app to the background. Writing
+ * "<pid> <anon|file|all> <nr_pages>" to reclaim_pid reclaims up to
+ * nr_pages of that type from the task right away, regardless of
+ * enable_process_reclaim and vmpressure. Reading it back reports the
+ * last request as "<pid> <nr_scanned> <nr_reclaimed>".
+ */
+static DEFINE_MUTEX(reclaim_pid_mutex);
+static pid_t last_reclaim_pid;
+static int last_reclaim_scanned;
+static int last_reclaim_reclaimed;
+
+static int reclaim_pid_set(const char *val, const struct kernel_param *kp)
+{
+	char type_buf[8];
+	pid_t pid;
+	int nr_to_reclaim;
+	enum reclaim_type type;
+	struct task_struct *tsk;
+	struct reclaim_param rp;
+
+	if (sscanf(val, "%d %7s %d", &pid, type_buf, &nr_to_reclaim) != 3)
+		return -EINVAL;
+
+	if (nr_to_reclaim <= 0)
+		return -EINVAL;
+
+	if (!strcmp(type_buf, "anon"))
+		type = RECLAIM_ANON;
+	else if (!strcmp(type_buf, "file"))
+		type = RECLAIM_FILE;
+	else if (!strcmp(type_buf, "all"))
+		type = RECLAIM_ALL;
+	else
+		return -EINVAL;
+
+	rcu_read_lock();
+	tsk = find_task_by_vpid(pid);
+	if (tsk)
+		get_task_struct(tsk);
+	rcu_read_unlock();
+
+	if (!tsk)
+		return -ESRCH;
+
+	if (tsk->flags & PF_KTHREAD) {
+		put_task_struct(tsk);
+		return -EINVAL;
+	}
+
+	rp = reclaim_task(tsk, type, nr_to_reclaim);
+	put_task_struct(tsk);
+
+	mutex_lock(&reclaim_pid_mutex);
+	last_reclaim_pid = pid;
+	last_reclaim_scanned = rp.nr_scanned;
+	last_reclaim_reclaimed = rp.nr_reclaimed;
+	mutex_unlock(&reclaim_pid_mutex);
+
+	return 0;
+}
+
+static int reclaim_pid_get(char *buf, const struct kernel_param *kp)
+{
+	int ret;
+
+	mutex_lock(&reclaim_pid_mutex);
+	ret = scnprintf(buf, PAGE_SIZE, "%d %d %d\n", last_reclaim_pid,
+			last_reclaim_scanned, last_reclaim_reclaimed);
+	mutex_unlock(&reclaim_pid_mutex);
+
+	return ret;
+}
+
+static const struct kernel_param_ops reclaim_pid_ops = {
+	.set = reclaim_pid_set,
+	.get = reclaim_pid_get,
+};
+module_param_cb(reclaim_pid, &reclaim_pid_ops, NULL, S_IRUGO | S_IWUSR);
+
 static int vmpressure_notifier(struct notifier_block *nb,
 			unsigned long action, void *data)
 {
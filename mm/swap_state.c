@@ -66,8 +66,6 @@ unsigned long total_swapcache_pages(void)
 	return ret;
 }
 
-static atomic_t swapin_readahead_hits = ATOMIC_INIT(4);
-
 void show_swap_cache_info(void)
 {
 	printk("%lu pages in swap cache\n", total_swapcache_pages());
@@ -289,8 +287,12 @@ struct page * lookup_swap_cache(swp_entry_t entry)
 
 	if (page) {
 		INC_CACHE_INFO(find_success);
-		if (TestClearPageReadahead(page))
-			atomic_inc(&swapin_readahead_hits);
+		if (TestClearPageReadahead(page)) {
+			struct swap_info_struct *si = swp_swap_info(entry);
+
+			if (si)
+				atomic_inc(&si->ra_hits);
+		}
 	}
 
 	INC_CACHE_INFO(find_total);
@@ -393,11 +395,15 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 	return found_page;
 }
 
-static unsigned long swapin_nr_pages(unsigned long offset)
+/*
+ * The window adapts to the readahead hits of each swap device separately,
+ * so that a device whose readahead is wasted does not shrink it for the
+ * others, and the other way round.
+ */
+static unsigned long swapin_nr_pages(struct swap_info_struct *si,
+				     unsigned long offset)
 {
-	static unsigned long prev_offset;
 	unsigned int pages, max_pages, last_ra;
-	static atomic_t last_readahead_pages;
 
 	max_pages = 1 << ACCESS_ONCE(page_cluster);
 	if (max_pages <= 1)
@@ -408,16 +414,17 @@ static unsigned long swapin_nr_pages(unsigned long offset)
 	 * random loads, swapping to hard disk or to SSD: please don't ask
 	 * what the "+ 2" means, it just happens to work well, that's all.
 	 */
-	pages = atomic_xchg(&swapin_readahead_hits, 0) + 2;
+	pages = atomic_xchg(&si->ra_hits, 0) + 2;
 	if (pages == 2) {
 		/*
 		 * We can have no readahead hits to judge by: but must not get
 		 * stuck here forever, so check for an adjacent offset instead
 		 * (and don't even bother to check whether swap type is same).
 		 */
-		if (offset != prev_offset + 1 && offset != prev_offset - 1)
+		if (offset != si->ra_prev_offset + 1 &&
+		    offset != si->ra_prev_offset - 1)
 			pages = 1;
-		prev_offset = offset;
+		si->ra_prev_offset = offset;
 	} else {
 		unsigned int roundup = 4;
 		while (roundup < pages)
@@ -429,10 +436,10 @@ static unsigned long swapin_nr_pages(unsigned long offset)
 		pages = max_pages;
 
 	/* Don't shrink readahead too fast */
-	last_ra = atomic_read(&last_readahead_pages) / 2;
+	last_ra = atomic_read(&si->ra_last_pages) / 2;
 	if (pages < last_ra)
 		pages = last_ra;
-	atomic_set(&last_readahead_pages, pages);
+	atomic_set(&si->ra_last_pages, pages);
 
 	return pages;
 }
@@ -454,19 +461,27 @@ static unsigned long swapin_nr_pages(unsigned long offset)
  * This has been extended to use the NUMA policies from the mm triggering
  * the readahead.
  *
+ * No readahead is done on SWP_FAST devices such as zram: reading a slot
+ * is a synchronous decompression, so speculative reads only burn CPU
+ * and memory on pages that are often never touched.
+ *
  * Caller must hold down_read on the vma->vm_mm if vma is not NULL.
  */
 struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
 			struct vm_area_struct *vma, unsigned long addr)
 {
 	struct page *page;
+	struct swap_info_struct *si = swp_swap_info(entry);
 	unsigned long entry_offset = swp_offset(entry);
 	unsigned long offset = entry_offset;
 	unsigned long start_offset, end_offset;
 	unsigned long mask;
 	struct blk_plug plug;
 
-	mask = is_swap_fast(entry) ? 0 : swapin_nr_pages(offset) - 1;
+	if (!si || (si->flags & SWP_FAST))
+		goto skip;
+
+	mask = swapin_nr_pages(si, offset) - 1;
 	if (!mask)
 		goto skip;
 
@@ -91,21 +91,25 @@ static inline unsigned char swap_count(unsigned char ent)
 	return ent & ~SWAP_HAS_CACHE;	/* may include SWAP_HAS_CONT flag */
 }
 
-bool is_swap_fast(swp_entry_t entry)
+struct swap_info_struct *swp_swap_info(swp_entry_t entry)
 {
-	struct swap_info_struct *p;
 	unsigned long type;
 
 	if (non_swap_entry(entry))
-		return false;
+		return NULL;
 
 	type = swp_type(entry);
 	if (type >= nr_swapfiles)
-		return false;
+		return NULL;
 
-	p = swap_info[type];
+	return swap_info[type];
+}
+
+bool is_swap_fast(swp_entry_t entry)
+{
+	struct swap_info_struct *p = swp_swap_info(entry);
 
-	if (p->flags & SWP_FAST)
+	if (p && (p->flags & SWP_FAST))
 		return true;
 
 	return false;
@@ -2155,6 +2159,9 @@ static struct swap_info_struct *alloc_swap_info(void)
 	p->flags = SWP_USED;
 	spin_unlock(&swap_lock);
 	spin_lock_init(&p->lock);
+	atomic_set(&p->ra_hits, 4);
+	atomic_set(&p->ra_last_pages, 0);
+	p->ra_prev_offset = 0;
 
 	return p;
 }
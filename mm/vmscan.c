@@ -131,6 +131,10 @@ struct scan_control {
 int vm_swappiness = 60;
 unsigned long vm_total_pages;
 
+/* kswapd threads per node, the first one plus helpers */
+int kswapd_threads = 1;
+static DEFINE_MUTEX(kswapd_helpers_lock);
+
 #ifdef CONFIG_KSWAPD_CPU_AFFINITY_MASK
 char *kswapd_cpu_mask = CONFIG_KSWAPD_CPU_AFFINITY_MASK;
 #else
@@ -2267,6 +2271,57 @@ static bool kswapd_shrink_zone(struct zone *zone,
 	return sc->nr_scanned >= sc->nr_to_reclaim;
 }
 
+static unsigned long pgdat_free_pages(pg_data_t *pgdat)
+{
+	unsigned long free = 0;
+	int i;
+
+	for (i = 0; i < pgdat->nr_zones; i++)
+		free += zone_page_state(pgdat->node_zones + i, NR_FREE_PAGES);
+
+	return free;
+}
+
+/*
+ * Reclaim rate control, called by kswapd after each reclaim pass with the
+ * free pages of the node and the pages reclaimed by all its kswapd
+ * threads as of the previous pass. If allocations outran reclaim, so
+ * that free memory still dropped, one more helper thread is asked for.
+ * If reclaim outran them by more than one thread's share, one fewer.
+ * Returns the number of helpers now wanted.
+ */
+static int kswapd_pace_helpers(pg_data_t *pgdat, int helpers,
+			       unsigned long *free, unsigned long *reclaimed)
+{
+	unsigned long free_now = pgdat_free_pages(pgdat);
+	unsigned long reclaimed_now;
+	long delta_free = free_now - *free;
+	long delta_reclaimed;
+	int max_helpers = ACCESS_ONCE(kswapd_threads) - 1;
+	int running;
+
+	reclaimed_now = atomic_long_read(&pgdat->kswapd_reclaimed);
+	delta_reclaimed = reclaimed_now - *reclaimed;
+	*free = free_now;
+	*reclaimed = reclaimed_now;
+
+	if (max_helpers <= 0)
+		return 0;
+
+	running = atomic_read(&pgdat->kswapd_helpers_running);
+	if (delta_free < 0)
+		helpers++;
+	else if (delta_free > delta_reclaimed / (running + 1))
+		helpers--;
+	helpers = clamp(helpers, 0, max_helpers);
+
+	atomic_set(&pgdat->kswapd_helper_tickets, max(helpers - running, 0));
+	if (helpers > running)
+		wake_up_interruptible(&pgdat->kswapd_helper_wait);
+
+	return helpers;
+}
+
 static unsigned long balance_pgdat(pg_data_t *pgdat, int order,
 							int *classzone_idx)
 {
@@ -2282,6 +2337,11 @@ static unsigned long balance_pgdat(pg_data_t *pgdat, int order,
 		.may_unmap = 1,
 		.may_swap = 1,
 	};
+	bool primary = current == pgdat->kswapd;
+	unsigned long free = pgdat_free_pages(pgdat);
+	unsigned long reclaimed = atomic_long_read(&pgdat->kswapd_reclaimed);
+	int helpers = 0;
+
 	count_vm_event(PAGEOUTRUN);
 
 	do {
@@ -2366,6 +2426,11 @@ static unsigned long balance_pgdat(pg_data_t *pgdat, int order,
 				pfmemalloc_watermark_ok(pgdat))
 			wake_up(&pgdat->pfmemalloc_wait);
 
+		atomic_long_add(sc.nr_reclaimed, &pgdat->kswapd_reclaimed);
+		if (primary)
+			helpers = kswapd_pace_helpers(pgdat, helpers, &free,
+						      &reclaimed);
+
 		if (order && sc.nr_reclaimed >= 2UL << order)
 			order = sc.order = 0;
 
@@ -2382,6 +2447,9 @@ static unsigned long balance_pgdat(pg_data_t *pgdat, int order,
 		 !pgdat_balanced(pgdat, order, *classzone_idx));
 
 out:
+	/* helpers already running finish when the node is balanced */
+	if (primary)
+		atomic_set(&pgdat->kswapd_helper_tickets, 0);
 	*classzone_idx = end_zone;
 	return order;
 }
@@ -2494,6 +2562,88 @@ static int kswapd(void *p)
 	return 0;
 }
 
+/*
+ * A kswapd helper reclaims alongside kswapd while kswapd_pace_helpers()
+ * asks for it. Concurrent threads split the LRU scanning between them
+ * through the shared memcg reclaim iterators and lru_lock batches.
+ */
+static int kswapd_helper(void *p)
+{
+	pg_data_t *pgdat = p;
+	struct task_struct *tsk = current;
+	struct reclaim_state reclaim_state = {
+		.reclaimed_slab = 0,
+	};
+
+	lockdep_set_current_reclaim_state(GFP_KERNEL);
+	current->reclaim_state = &reclaim_state;
+	tsk->flags |= PF_MEMALLOC | PF_SWAPWRITE | PF_KSWAPD;
+	set_freezable();
+
+	for ( ; ; ) {
+		int classzone_idx = pgdat->nr_zones - 1;
+
+		wait_event_freezable(pgdat->kswapd_helper_wait,
+			atomic_read(&pgdat->kswapd_helper_tickets) > 0 ||
+			kthread_should_stop());
+		if (kthread_should_stop())
+			break;
+		if (atomic_dec_if_positive(&pgdat->kswapd_helper_tickets) < 0)
+			continue;
+
+		atomic_inc(&pgdat->kswapd_helpers_running);
+		balance_pgdat(pgdat, 0, &classzone_idx);
+		atomic_dec(&pgdat->kswapd_helpers_running);
+	}
+
+	tsk->flags &= ~(PF_MEMALLOC | PF_SWAPWRITE | PF_KSWAPD);
+	current->reclaim_state = NULL;
+	lockdep_clear_current_reclaim_state();
+
+	return 0;
+}
+
+/* Start or stop helpers to match kswapd_threads, kswapd_helpers_lock held */
+static void kswapd_update_helpers(int nid)
+{
+	pg_data_t *pgdat = NODE_DATA(nid);
+	int i;
+
+	for (i = 0; i < MAX_KSWAPD_THREADS - 1; i++) {
+		struct task_struct *tsk = pgdat->kswapd_helper[i];
+		bool want = pgdat->kswapd && i < kswapd_threads - 1;
+
+		if (want && !tsk) {
+			tsk = kthread_run(kswapd_helper, pgdat, "kswapd%d:%d",
+					  nid, i + 1);
+			if (IS_ERR(tsk)) {
+				pr_err("Failed to start kswapd helper on node %d\n",
+					nid);
+				break;
+			}
+			pgdat->kswapd_helper[i] = tsk;
+		} else if (!want && tsk) {
+			kthread_stop(tsk);
+			pgdat->kswapd_helper[i] = NULL;
+		}
+	}
+}
+
+int kswapd_threads_sysctl_handler(struct ctl_table *table, int write,
+			void __user *buffer, size_t *length, loff_t *ppos)
+{
+	int nid, ret;
+
+	mutex_lock(&kswapd_helpers_lock);
+	ret = proc_dointvec_minmax(table, write, buffer, length, ppos);
+	if (!ret && write)
+		for_each_node_state(nid, N_MEMORY)
+			kswapd_update_helpers(nid);
+	mutex_unlock(&kswapd_helpers_lock);
+
+	return ret;
+}
+
 void wakeup_kswapd(struct zone *zone, int order, enum zone_type classzone_idx)
 {
 	pg_data_t *pgdat;
@@ -2605,6 +2755,11 @@ int kswapd_run(int nid)
 		if (set_kswapd_cpu_mask(pgdat))
 			pr_warn("error setting kswapd cpu affinity mask\n");
 	}
+
+	mutex_lock(&kswapd_helpers_lock);
+	kswapd_update_helpers(nid);
+	mutex_unlock(&kswapd_helpers_lock);
+
 	return ret;
 }
 
@@ -2616,6 +2771,10 @@ void kswapd_stop(int nid)
 		kthread_stop(kswapd);
 		NODE_DATA(nid)->kswapd = NULL;
 	}
+
+	mutex_lock(&kswapd_helpers_lock);
+	kswapd_update_helpers(nid);
+	mutex_unlock(&kswapd_helpers_lock);
 }
 
 static int __init kswapd_init(void)
@@ -475,6 +475,30 @@ int fragmentation_index(struct zone *zone, unsigned int order)
 	fill_contig_page_info(zone, order, &info);
 	return __fragmentation_index(order, &info);
 }
+
+/*
+ * Return the share of free memory, in thousandths, held in blocks too
+ * small for an allocation of the given order.
+ */
+static int unusable_free_index(unsigned int order,
+				struct contig_page_info *info)
+{
+	/* No free memory is interpreted as all free memory is unusable */
+	if (info->free_pages == 0)
+		return 1000;
+
+	return div_u64((info->free_pages -
+			(info->free_blocks_suitable << order)) * 1000ULL,
+			info->free_pages);
+}
+
+int zone_unusable_index(struct zone *zone, unsigned int order)
+{
+	struct contig_page_info info;
+
+	fill_contig_page_info(zone, order, &info);
+	return unusable_free_index(order, &info);
+}
 #endif
 
 #if defined(CONFIG_PROC_FS) || defined(CONFIG_COMPACTION)
@@ -665,6 +689,7 @@ const char * const vmstat_text[] = {
 	"compact_stall",
 	"compact_fail",
 	"compact_success",
+	"compact_proactive",
 #endif
 
 #ifdef CONFIG_HUGETLB_PAGE
@@ -713,6 +738,16 @@ const char * const vmstat_text[] = {
 	"allocstall_500",
 	"allocstall_1000",
 	"allocstall_horder",
+	"pgalloc_order_1",
+	"pgalloc_order_2",
+	"pgalloc_order_3",
+	"pgalloc_order_4",
+	"pgalloc_order_high",
+	"pgalloc_order_1_fail",
+	"pgalloc_order_2_fail",
+	"pgalloc_order_3_fail",
+	"pgalloc_order_4_fail",
+	"pgalloc_order_high_fail",
 #ifdef CONFIG_COMPACTION
 	"compact_stall_100",
 	"compact_stall_250",
@@ -1352,18 +1387,6 @@ module_init(setup_vmstat)
 #if defined(CONFIG_DEBUG_FS) && defined(CONFIG_COMPACTION)
 #include <linux/debugfs.h>
 
-
-static int unusable_free_index(unsigned int order,
-				struct contig_page_info *info)
-{
-	
-	if (info->free_pages == 0)
-		return 1000;
-
-	return div_u64((info->free_pages - (info->free_blocks_suitable << order)) * 1000ULL, info->free_pages);
-
-}
-
 static void unusable_show_print(struct seq_file *m,
 					pg_data_t *pgdat, struct zone *zone)
 {
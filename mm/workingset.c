@@ -12,6 +12,8 @@
 #include <linux/swap.h>
 #include <linux/fs.h>
 #include <linux/mm.h>
+#include <linux/cred.h>
+#include <linux/uid_stat.h>
 
 /*
  *		Double CLOCK lists
@@ -232,15 +234,19 @@ bool workingset_refault(void *shadow)
 {
 	unsigned long refault_distance;
 	struct zone *zone;
+	bool activate;
 
 	unpack_shadow(shadow, &zone, &refault_distance);
 	inc_zone_state(zone, WORKINGSET_REFAULT);
 
-	if (refault_distance <= zone_page_state(zone, NR_ACTIVE_FILE)) {
+	activate = refault_distance <= zone_page_state(zone, NR_ACTIVE_FILE);
+	if (activate)
 		inc_zone_state(zone, WORKINGSET_ACTIVATE);
-		return true;
-	}
-	return false;
+
+	mem_cgroup_count_workingset(activate);
+	uid_stat_workingset(from_kuid(&init_user_ns, current_uid()), activate);
+
+	return activate;
 }
 
 /**
@@ -31,6 +31,7 @@
 #include <linux/ipc_router.h>
 #include <linux/ipc_router_xprt.h>
 #include <linux/kref.h>
+#include <linux/rculist.h>
 #include <soc/qcom/subsystem_notif.h>
 #include <soc/qcom/subsystem_restart.h>
 
@@ -153,6 +154,7 @@ struct msm_ipc_router_xprt_info {
 struct msm_ipc_routing_table_entry {
 	struct list_head list;
 	struct kref ref;
+	struct rcu_head rcu;
 	uint32_t node_id;
 	uint32_t neighbor_node_id;
 	struct list_head remote_port_list[RP_HASH_SIZE];
@@ -403,14 +405,17 @@ static void ipc_router_log_msg(void *log_ctx, uint32_t xchng_type,
 	}
 }
 
-/* Must be called with routing_table_lock_lha3 locked. */
+/*
+ * Must be called with routing_table_lock_lha3 locked or under
+ * rcu_read_lock().
+ */
 static struct msm_ipc_routing_table_entry *lookup_routing_table(
 	uint32_t node_id)
 {
 	uint32_t key = (node_id % RT_HASH_SIZE);
 	struct msm_ipc_routing_table_entry *rt_entry;
 
-	list_for_each_entry(rt_entry, &routing_table[key], list) {
+	list_for_each_entry_rcu(rt_entry, &routing_table[key], list) {
 		if (rt_entry->node_id == node_id)
 			return rt_entry;
 	}
@@ -454,7 +459,7 @@ static struct msm_ipc_routing_table_entry *create_routing_table_entry(
 		rt_entry->neighbor_node_id = xprt_info->remote_node_id;
 
 	key = (node_id % RT_HASH_SIZE);
-	list_add_tail(&rt_entry->list, &routing_table[key]);
+	list_add_tail_rcu(&rt_entry->list, &routing_table[key]);
 out_create_rtentry1:
 	kref_get(&rt_entry->ref);
 out_create_rtentry2:
@@ -469,18 +474,19 @@ out_create_rtentry2:
  * @return: a reference to the routing table entry on success, NULL on failure.
  *
  * This function is used to obtain a reference to the rounting table entry
- * corresponding to a node id.
+ * corresponding to a node id. It runs on every packet routed, so the lookup
+ * does not take routing_table_lock_lha3.
  */
 static struct msm_ipc_routing_table_entry *ipc_router_get_rtentry_ref(
 	uint32_t node_id)
 {
 	struct msm_ipc_routing_table_entry *rt_entry;
 
-	down_read(&routing_table_lock_lha3);
+	rcu_read_lock();
 	rt_entry = lookup_routing_table(node_id);
-	if (rt_entry)
-		kref_get(&rt_entry->ref);
-	up_read(&routing_table_lock_lha3);
+	if (rt_entry && !kref_get_unless_zero(&rt_entry->ref))
+		rt_entry = NULL;
+	rcu_read_unlock();
 	return rt_entry;
 }
 
@@ -499,9 +505,10 @@ void ipc_router_release_rtentry(struct kref *ref)
 	/*
 	 * All references to a routing entry will be put only under SSR.
 	 * As part of SSR, all the internals of the routing table entry
-	 * are cleaned. So just free the routing table entry.
+	 * are cleaned. So just free the routing table entry once the lockless
+	 * lookups are done with it.
 	 */
-	kfree(rt_entry);
+	kfree_rcu(rt_entry, rcu);
 }
 
 struct rr_packet *rr_read(struct msm_ipc_router_xprt_info *xprt_info)
@@ -1269,7 +1276,7 @@ void msm_ipc_router_add_local_port(struct msm_ipc_port *port_ptr)
 
 	key = (port_ptr->this_port.port_id & (LP_HASH_SIZE - 1));
 	down_write(&local_ports_lock_lhc2);
-	list_add_tail(&port_ptr->list, &local_ports[key]);
+	list_add_tail_rcu(&port_ptr->list, &local_ports[key]);
 	up_write(&local_ports_lock_lhc2);
 }
 
@@ -1345,15 +1352,16 @@ static struct msm_ipc_port *ipc_router_get_port_ref(uint32_t port_id)
 	int key = (port_id & (LP_HASH_SIZE - 1));
 	struct msm_ipc_port *port_ptr;
 
-	down_read(&local_ports_lock_lhc2);
-	list_for_each_entry(port_ptr, &local_ports[key], list) {
+	rcu_read_lock();
+	list_for_each_entry_rcu(port_ptr, &local_ports[key], list) {
 		if (port_ptr->this_port.port_id == port_id) {
-			kref_get(&port_ptr->ref);
-			up_read(&local_ports_lock_lhc2);
+			if (!kref_get_unless_zero(&port_ptr->ref))
+				break;
+			rcu_read_unlock();
 			return port_ptr;
 		}
 	}
-	up_read(&local_ports_lock_lhc2);
+	rcu_read_unlock();
 	return NULL;
 }
 
@@ -1378,7 +1386,7 @@ void ipc_router_release_port(struct kref *ref)
 	wakeup_source_unregister(port_ptr->port_rx_ws);
 	if (port_ptr->endpoint)
 		sock_put(ipc_port_sk(port_ptr->endpoint));
-	kfree(port_ptr);
+	kfree_rcu(port_ptr, rcu);
 }
 
 /**
@@ -2225,7 +2233,7 @@ static void msm_ipc_cleanup_routing_table(
 			cleanup_rmt_ports(xprt_info, rt_entry);
 			rt_entry->xprt_info = NULL;
 			up_write(&rt_entry->lock_lha4);
-			list_del(&rt_entry->list);
+			list_del_rcu(&rt_entry->list);
 			kref_put(&rt_entry->ref, ipc_router_release_rtentry);
 		}
 	}
@@ -3446,7 +3454,7 @@ int msm_ipc_router_close_port(struct msm_ipc_port *port_ptr)
 
 	if (port_ptr->type == SERVER_PORT || port_ptr->type == CLIENT_PORT) {
 		down_write(&local_ports_lock_lhc2);
-		list_del(&port_ptr->list);
+		list_del_rcu(&port_ptr->list);
 		up_write(&local_ports_lock_lhc2);
 
 		mutex_lock(&port_ptr->port_lock_lhc3);
@@ -3481,7 +3489,7 @@ int msm_ipc_router_close_port(struct msm_ipc_port *port_ptr)
 		up_write(&control_ports_lock_lha5);
 	} else if (port_ptr->type == IRSC_PORT) {
 		down_write(&local_ports_lock_lhc2);
-		list_del(&port_ptr->list);
+		list_del_rcu(&port_ptr->list);
 		up_write(&local_ports_lock_lhc2);
 		signal_irsc_completion();
 	}
@@ -3536,8 +3544,10 @@ int msm_ipc_router_bind_control_port(struct msm_ipc_port *port_ptr)
 		return -EINVAL;
 
 	down_write(&local_ports_lock_lhc2);
-	list_del(&port_ptr->list);
+	list_del_rcu(&port_ptr->list);
 	up_write(&local_ports_lock_lhc2);
+	/* lockless lookups may still be walking the local port list */
+	synchronize_rcu();
 	port_ptr->type = CONTROL_PORT;
 	down_write(&control_ports_lock_lha5);
 	list_add_tail(&port_ptr->list, &control_ports);
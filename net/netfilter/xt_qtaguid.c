@@ -15,6 +15,8 @@
 #define DEBUG
 
 #include <linux/file.h>
+#include <linux/hash.h>
+#include <linux/hashtable.h>
 #include <linux/inetdevice.h>
 #include <linux/module.h>
 #include <linux/netfilter/x_tables.h>
@@ -22,6 +24,7 @@
 #include <linux/ratelimit.h>
 #include <linux/seq_file.h>
 #include <linux/skbuff.h>
+#include <linux/vmalloc.h>
 #include <linux/workqueue.h>
 #include <net/addrconf.h>
 #include <net/sock.h>
@@ -57,6 +60,8 @@ module_param_named(stats_perms, proc_stats_perms, uint, S_IRUGO | S_IWUSR);
 
 static struct proc_dir_entry *xt_qtaguid_ctrl_file;
 
+static struct proc_dir_entry *xt_qtaguid_uid_stats_file;
+
 /* Everybody can write. But proc_ctrl_write_limited is true by default which
  * limits what can be controlled. See the can_*() functions.
  */
@@ -127,7 +132,14 @@ static struct proc_dir_entry *iface_stat_fmt_procfile;
 static LIST_HEAD(iface_stat_list);
 static DEFINE_SPINLOCK(iface_stat_list_lock);
 
+/*
+ * sock_tag_tree and sock_tag_hash hold the same entries. The control
+ * paths walk the tree under sock_tag_list_lock, the packet path looks
+ * the socket up in the hash under RCU.
+ */
+#define SOCK_TAG_HASH_BITS 10
 static struct rb_root sock_tag_tree = RB_ROOT;
+static DEFINE_HASHTABLE(sock_tag_hash, SOCK_TAG_HASH_BITS);
 static DEFINE_SPINLOCK(sock_tag_list_lock);
 
 static struct rb_root tag_counter_set_tree = RB_ROOT;
@@ -236,6 +248,36 @@ static struct tag_stat *tag_stat_tree_search(struct rb_root *root, tag_t tag)
 	return rb_entry(&node->node, struct tag_stat, tn.node);
 }
 
+/* Folds the {acct_tag, uid} pair into a tag_stat_hash key */
+static inline u32 tag_stat_hash_key(tag_t tag)
+{
+	return get_uid_from_tag(tag) ^ (u32)(tag >> 32);
+}
+
+/*
+ * Caller must hold rcu_read_lock() or iface_entry->tag_stat_list_lock.
+ */
+static struct tag_stat *tag_stat_hash_search(struct iface_stat *iface_entry,
+					     tag_t tag)
+{
+	struct tag_stat *ts_entry;
+
+	hash_for_each_possible_rcu(iface_entry->tag_stat_hash, ts_entry,
+				   hash_node, tag_stat_hash_key(tag)) {
+		if (ts_entry->tn.tag == tag)
+			return ts_entry;
+	}
+	return NULL;
+}
+
+static void tag_stat_free_rcu(struct rcu_head *head)
+{
+	struct tag_stat *ts_entry = container_of(head, struct tag_stat, rcu);
+
+	free_percpu(ts_entry->counters);
+	kfree(ts_entry);
+}
+
 static void tag_counter_set_tree_insert(struct tag_counter_set *data,
 					struct rb_root *root)
 {
@@ -305,6 +347,21 @@ static void sock_tag_tree_insert(struct sock_tag *data, struct rb_root *root)
 	rb_insert_color(&data->sock_node, root);
 }
 
+/* Caller must hold sock_tag_list_lock */
+static void sock_tag_link(struct sock_tag *st_entry)
+{
+	sock_tag_tree_insert(st_entry, &sock_tag_tree);
+	hash_add_rcu(sock_tag_hash, &st_entry->hash_node,
+		     (unsigned long)st_entry->sk);
+}
+
+/* Caller must hold sock_tag_list_lock */
+static void sock_tag_unlink(struct sock_tag *st_entry)
+{
+	rb_erase(&st_entry->sock_node, &sock_tag_tree);
+	hash_del_rcu(&st_entry->hash_node);
+}
+
 static void sock_tag_tree_erase(struct rb_root *st_to_free_tree)
 {
 	struct rb_node *node;
@@ -321,7 +378,7 @@ static void sock_tag_tree_erase(struct rb_root *st_to_free_tree)
 			 get_uid_from_tag(st_entry->tag));
 		rb_erase(&st_entry->sock_node, st_to_free_tree);
 		sockfd_put(st_entry->socket);
-		kfree(st_entry);
+		kfree_rcu(st_entry, rcu);
 	}
 }
 
@@ -869,6 +926,7 @@ static struct iface_stat *iface_alloc(struct net_device *net_dev)
 	}
 	spin_lock_init(&new_iface->tag_stat_list_lock);
 	new_iface->tag_stat_tree = RB_ROOT;
+	hash_init(new_iface->tag_stat_hash);
 	_iface_stat_set_active(new_iface, net_dev, true);
 
 	/*
@@ -1068,16 +1126,29 @@ static struct sock_tag *get_sock_stat_nl(const struct sock *sk)
 	return sock_tag_tree_search(&sock_tag_tree, sk);
 }
 
-static struct sock_tag *get_sock_stat(const struct sock *sk)
+/*
+ * Lockless lookup of the tag of a socket for the packet path.
+ * Returns false if the socket is not tagged.
+ */
+static bool get_sock_tag(const struct sock *sk, tag_t *tag)
 {
 	struct sock_tag *sock_tag_entry;
-	MT_DEBUG("qtaguid: get_sock_stat(sk=%p)\n", sk);
+	bool found = false;
+
+	MT_DEBUG("qtaguid: get_sock_tag(sk=%p)\n", sk);
 	if (!sk)
-		return NULL;
-	spin_lock_bh(&sock_tag_list_lock);
-	sock_tag_entry = get_sock_stat_nl(sk);
-	spin_unlock_bh(&sock_tag_list_lock);
-	return sock_tag_entry;
+		return false;
+	rcu_read_lock();
+	hash_for_each_possible_rcu(sock_tag_hash, sock_tag_entry, hash_node,
+				   (unsigned long)sk) {
+		if (sock_tag_entry->sk == sk) {
+			*tag = ACCESS_ONCE(sock_tag_entry->tag);
+			found = true;
+			break;
+		}
+	}
+	rcu_read_unlock();
+	return found;
 }
 
 static int ipx_proto(const struct sk_buff *skb,
@@ -1236,6 +1307,125 @@ static void iface_stat_update_from_skb(const struct sk_buff *skb,
 	spin_unlock_bh(&iface_stat_list_lock);
 }
 
+/*
+ * The per-uid table behind /proc/net/xt_qtaguid/uid_stats. It is open
+ * addressed on the uid; slots are claimed under qtu_uid_insert_lock and
+ * never released. Counter updates of one slot are serialized by one of
+ * qtu_uid_locks and published to lockless readers through the slot's
+ * seq, so that nothing on the read side ever takes a lock.
+ */
+#define QTU_UID_TABLE_BITS	12
+#define QTU_UID_TABLE_SLOTS	(1 << QTU_UID_TABLE_BITS)
+#define QTU_UID_MAX_PROBES	64
+#define QTU_UID_LOCKS		64
+
+static struct qtaguid_uid_table *qtu_uid_table;
+static size_t qtu_uid_table_size;
+static spinlock_t qtu_uid_locks[QTU_UID_LOCKS];
+static DEFINE_SPINLOCK(qtu_uid_insert_lock);
+
+static struct qtaguid_uid_stat *qtu_uid_stat_find(uid_t uid, bool create)
+{
+	struct qtaguid_uid_stat *e, *free_e = NULL;
+	u32 slot = hash_32(uid, QTU_UID_TABLE_BITS);
+	u32 euid;
+	int i;
+
+	for (i = 0; i < QTU_UID_MAX_PROBES; i++) {
+		e = &qtu_uid_table->entries[(slot + i) &
+					    (QTU_UID_TABLE_SLOTS - 1)];
+		euid = ACCESS_ONCE(e->uid);
+		if (euid == uid)
+			return e;
+		if (euid == QTAGUID_UID_STAT_FREE)
+			break;
+	}
+	if (!create)
+		return NULL;
+
+	spin_lock(&qtu_uid_insert_lock);
+	for (i = 0; i < QTU_UID_MAX_PROBES; i++) {
+		e = &qtu_uid_table->entries[(slot + i) &
+					    (QTU_UID_TABLE_SLOTS - 1)];
+		if (e->uid == uid)
+			goto unlock;
+		if (e->uid == QTAGUID_UID_STAT_FREE) {
+			free_e = e;
+			break;
+		}
+	}
+	e = free_e;
+	if (e) {
+		/* counters are still zero; make sure they look that way */
+		smp_wmb();
+		e->uid = uid;
+	} else {
+		qtu_uid_table->overflows++;
+	}
+unlock:
+	spin_unlock(&qtu_uid_insert_lock);
+
+	return e;
+}
+
+static inline spinlock_t *qtu_uid_stat_lock(struct qtaguid_uid_stat *e)
+{
+	return &qtu_uid_locks[(e - qtu_uid_table->entries) &
+			      (QTU_UID_LOCKS - 1)];
+}
+
+/* Caller has bottom halves disabled */
+static void qtu_uid_stat_update(uid_t uid, int set,
+				enum ifs_tx_rx direction, int bytes)
+{
+	struct qtaguid_uid_stat *e;
+	spinlock_t *lock;
+
+	if (unlikely(!qtu_uid_table))
+		return;
+
+	e = qtu_uid_stat_find(uid, true);
+	if (!e)
+		return;
+
+	lock = qtu_uid_stat_lock(e);
+	spin_lock(lock);
+	e->seq++;
+	smp_wmb();
+	if (direction == IFS_RX) {
+		e->set[set].rx_bytes += bytes;
+		e->set[set].rx_packets++;
+	} else {
+		e->set[set].tx_bytes += bytes;
+		e->set[set].tx_packets++;
+	}
+	smp_wmb();
+	e->seq++;
+	spin_unlock(lock);
+}
+
+static void qtu_uid_stat_reset(uid_t uid)
+{
+	struct qtaguid_uid_stat *e;
+	spinlock_t *lock;
+
+	if (!qtu_uid_table)
+		return;
+
+	e = qtu_uid_stat_find(uid, false);
+	if (!e)
+		return;
+
+	lock = qtu_uid_stat_lock(e);
+	spin_lock_bh(lock);
+	e->seq++;
+	smp_wmb();
+	memset(e->set, 0, sizeof(e->set));
+	smp_wmb();
+	e->seq++;
+	spin_unlock_bh(lock);
+}
+
 static void tag_stat_update(struct tag_stat *tag_entry,
 			enum ifs_tx_rx direction, int proto, int bytes)
 {
@@ -1245,11 +1435,16 @@ static void tag_stat_update(struct tag_stat *tag_entry,
 		 "dir=%d proto=%d bytes=%d)\n",
 		 tag_entry->tn.tag, get_uid_from_tag(tag_entry->tn.tag),
 		 active_set, direction, proto, bytes);
-	data_counters_update(&tag_entry->counters, active_set, direction,
-			     proto, bytes);
+	/* Keep softirqs off this cpu's counters while they are updated */
+	local_bh_disable();
+	data_counters_update(this_cpu_ptr(tag_entry->counters), active_set,
+			     direction, proto, bytes);
 	if (tag_entry->parent_counters)
-		data_counters_update(tag_entry->parent_counters, active_set,
-				     direction, proto, bytes);
+		data_counters_update(this_cpu_ptr(tag_entry->parent_counters),
+				     active_set, direction, proto, bytes);
+	qtu_uid_stat_update(get_uid_from_tag(tag_entry->tn.tag), active_set,
+			    direction, bytes);
+	local_bh_enable();
 }
 
 /*
@@ -1269,8 +1464,18 @@ static struct tag_stat *create_if_tag_stat(struct iface_stat *iface_entry,
 		pr_err("qtaguid: iface_stat: tag stat alloc failed\n");
 		goto done;
 	}
+	new_tag_stat_entry->counters = alloc_percpu_gfp(struct data_counters,
+							GFP_ATOMIC);
+	if (!new_tag_stat_entry->counters) {
+		pr_err("qtaguid: iface_stat: tag stat counters alloc failed\n");
+		kfree(new_tag_stat_entry);
+		new_tag_stat_entry = NULL;
+		goto done;
+	}
 	new_tag_stat_entry->tn.tag = tag;
 	tag_stat_tree_insert(new_tag_stat_entry, &iface_entry->tag_stat_tree);
+	hash_add_rcu(iface_entry->tag_stat_hash, &new_tag_stat_entry->hash_node,
+		     tag_stat_hash_key(tag));
 done:
 	return new_tag_stat_entry;
 }
@@ -1282,8 +1487,7 @@ static void if_tag_stat_update(const char *ifname, uid_t uid,
 	struct tag_stat *tag_stat_entry;
 	tag_t tag, acct_tag;
 	tag_t uid_tag;
-	struct data_counters *uid_tag_counters;
-	struct sock_tag *sock_tag_entry;
+	struct data_counters __percpu *uid_tag_counters;
 	struct iface_stat *iface_entry;
 	struct tag_stat *new_tag_stat = NULL;
 	MT_DEBUG("qtaguid: if_tag_stat_update(ifname=%s "
@@ -1306,9 +1510,7 @@ static void if_tag_stat_update(const char *ifname, uid_t uid,
 	 * Look for a tagged sock.
 	 * It will have an acct_uid.
 	 */
-	sock_tag_entry = get_sock_stat(sk);
-	if (sock_tag_entry) {
-		tag = sock_tag_entry->tag;
+	if (get_sock_tag(sk, &tag)) {
 		acct_tag = get_atag_from_tag(tag);
 		uid_tag = get_utag_from_tag(tag);
 	} else {
@@ -1319,24 +1521,31 @@ static void if_tag_stat_update(const char *ifname, uid_t uid,
 	MT_DEBUG("qtaguid: iface_stat: stat_update(): "
 		 " looking for tag=0x%llx (uid=%u) in ife=%p\n",
 		 tag, get_uid_from_tag(tag), iface_entry);
-	/* Loop over tag list under this interface for {acct_tag,uid_tag} */
-	spin_lock_bh(&iface_entry->tag_stat_list_lock);
-
-	tag_stat_entry = tag_stat_tree_search(&iface_entry->tag_stat_tree,
-					      tag);
+	/* Look for {acct_tag,uid_tag} under this interface */
+	rcu_read_lock();
+	tag_stat_entry = tag_stat_hash_search(iface_entry, tag);
 	if (tag_stat_entry) {
 		/*
 		 * Updating the {acct_tag, uid_tag} entry handles both stats:
 		 * {0, uid_tag} will also get updated.
 		 */
 		tag_stat_update(tag_stat_entry, direction, proto, bytes);
-		spin_unlock_bh(&iface_entry->tag_stat_list_lock);
+		rcu_read_unlock();
 		return;
 	}
+	rcu_read_unlock();
+
+	/* Not there yet, the entries get created under the lock */
+	spin_lock_bh(&iface_entry->tag_stat_list_lock);
+	tag_stat_entry = tag_stat_hash_search(iface_entry, tag);
+	if (tag_stat_entry) {
+		/* Raced with another cpu creating it */
+		tag_stat_update(tag_stat_entry, direction, proto, bytes);
+		goto unlock;
+	}
 
-	/* Loop over tag list under this interface for {0,uid_tag} */
-	tag_stat_entry = tag_stat_tree_search(&iface_entry->tag_stat_tree,
-					      uid_tag);
+	/* Look for {0,uid_tag} under this interface */
+	tag_stat_entry = tag_stat_hash_search(iface_entry, uid_tag);
 	if (!tag_stat_entry) {
 		/* Here: the base uid_tag did not exist */
 		/*
@@ -1346,9 +1555,9 @@ static void if_tag_stat_update(const char *ifname, uid_t uid,
 		new_tag_stat = create_if_tag_stat(iface_entry, uid_tag);
 		if (!new_tag_stat)
 			goto unlock;
-		uid_tag_counters = &new_tag_stat->counters;
+		uid_tag_counters = new_tag_stat->counters;
 	} else {
-		uid_tag_counters = &tag_stat_entry->counters;
+		uid_tag_counters = tag_stat_entry->counters;
 	}
 
 	if (acct_tag) {
@@ -2049,7 +2258,7 @@ static int ctrl_cmd_delete(const char *input)
 			 input, st_entry->tag, entry_uid);
 
 		if (!acct_tag || st_entry->tag == tag) {
-			rb_erase(&st_entry->sock_node, &sock_tag_tree);
+			sock_tag_unlink(st_entry);
 			/* Can't sockfd_put() within spinlock, do it later. */
 			sock_tag_tree_insert(st_entry, &st_to_free_tree);
 			tr_entry = lookup_tag_ref(st_entry->tag, NULL);
@@ -2113,13 +2322,17 @@ static int ctrl_cmd_delete(const char *input)
 					 entry_uid);
 				rb_erase(&ts_entry->tn.node,
 					 &iface_entry->tag_stat_tree);
-				kfree(ts_entry);
+				hash_del_rcu(&ts_entry->hash_node);
+				call_rcu(&ts_entry->rcu, tag_stat_free_rcu);
 			}
 		}
 		spin_unlock_bh(&iface_entry->tag_stat_list_lock);
 	}
 	spin_unlock_bh(&iface_stat_list_lock);
 
+	if (!acct_tag)
+		qtu_uid_stat_reset(uid_int);
+
 	/* Cleanup the uid_tag_data */
 	spin_lock_bh(&uid_tag_data_tree_lock);
 	node = rb_first(&uid_tag_data_tree);
@@ -2302,7 +2515,7 @@ static int ctrl_cmd_tag(const char *input)
 		BUG_ON(IS_ERR_OR_NULL(prev_tag_ref_entry));
 		BUG_ON(prev_tag_ref_entry->num_sock_tags <= 0);
 		prev_tag_ref_entry->num_sock_tags--;
-		sock_tag_entry->tag = full_tag;
+		ACCESS_ONCE(sock_tag_entry->tag) = full_tag;
 	} else {
 		CT_DEBUG("qtaguid: ctrl_tag(%s): newtag for sk=%p\n",
 			 input, el_socket->sk);
@@ -2340,7 +2553,7 @@ static int ctrl_cmd_tag(const char *input)
 				 &pqd_entry->sock_tag_list);
 		spin_unlock_bh(&uid_tag_data_tree_lock);
 
-		sock_tag_tree_insert(sock_tag_entry, &sock_tag_tree);
+		sock_tag_link(sock_tag_entry);
 		atomic64_inc(&qtu_events.sockets_tagged);
 	}
 	spin_unlock_bh(&sock_tag_list_lock);
@@ -2406,7 +2619,7 @@ static int ctrl_cmd_untag(const char *input)
 	 * The socket already belongs to the current process
 	 * so it can do whatever it wants to it.
 	 */
-	rb_erase(&sock_tag_entry->sock_node, &sock_tag_tree);
+	sock_tag_unlink(sock_tag_entry);
 
 	tag_ref_entry = lookup_tag_ref(sock_tag_entry->tag, &utd_entry);
 	BUG_ON(!tag_ref_entry);
@@ -2443,7 +2656,7 @@ static int ctrl_cmd_untag(const char *input)
 		 atomic_long_read(&el_socket->file->f_count) - 1);
 	sockfd_put(el_socket);
 
-	kfree(sock_tag_entry);
+	kfree_rcu(sock_tag_entry, rcu);
 	atomic64_inc(&qtu_events.sockets_untagged);
 
 	return 0;
@@ -2543,7 +2756,7 @@ static int pp_stats_line(struct seq_file *m, struct tag_stat *ts_entry,
 			 int cnt_set)
 {
 	int ret;
-	struct data_counters *cnts;
+	struct data_counters counters, *cnts;
 	tag_t tag = ts_entry->tn.tag;
 	uid_t stat_uid = get_uid_from_tag(tag);
 	struct proc_print_info *ppi = m->private;
@@ -2560,7 +2773,8 @@ static int pp_stats_line(struct seq_file *m, struct tag_stat *ts_entry,
 		return 0;
 	}
 	ppi->item_index++;
-	cnts = &ts_entry->counters;
+	dc_fold(&counters, ts_entry->counters);
+	cnts = &counters;
 	ret = seq_printf(m, "%d %s 0x%llx %u %u "
 		"%llu %llu "
 		"%llu %llu "
@@ -2862,7 +3076,7 @@ static int qtudev_release(struct inode *inode, struct file *file)
 		tr->num_sock_tags--;
 		free_tag_ref_from_utd_entry(tr, utd_entry);
 
-		rb_erase(&st_entry->sock_node, &sock_tag_tree);
+		sock_tag_unlink(st_entry);
 		list_del(&st_entry->list);
 		/* Can't sockfd_put() within spinlock, do it later. */
 		sock_tag_tree_insert(st_entry, &st_to_free_tree);
@@ -2948,6 +3162,74 @@ static const struct file_operations proc_qtaguid_stats_fops = {
 	.release	= seq_release_private,
 };
 
+static int proc_qtaguid_uid_stats_open(struct inode *inode, struct file *file)
+{
+	/* the table holds every uid, so it is all or nothing */
+	if (!can_read_other_uid_stats(INVALID_UID))
+		return -EACCES;
+
+	return 0;
+}
+
+static ssize_t proc_qtaguid_uid_stats_read(struct file *file,
+					   char __user *buf, size_t count,
+					   loff_t *ppos)
+{
+	return simple_read_from_buffer(buf, count, ppos, qtu_uid_table,
+				       qtu_uid_table_size);
+}
+
+static int proc_qtaguid_uid_stats_mmap(struct file *file,
+				       struct vm_area_struct *vma)
+{
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return remap_vmalloc_range(vma, qtu_uid_table, vma->vm_pgoff);
+}
+
+static const struct file_operations proc_qtaguid_uid_stats_fops = {
+	.open		= proc_qtaguid_uid_stats_open,
+	.read		= proc_qtaguid_uid_stats_read,
+	.mmap		= proc_qtaguid_uid_stats_mmap,
+	.llseek		= default_llseek,
+};
+
+static int __init qtu_uid_table_init(struct proc_dir_entry *parent_procdir)
+{
+	int i;
+
+	qtu_uid_table_size = PAGE_ALIGN(sizeof(*qtu_uid_table) +
+			QTU_UID_TABLE_SLOTS * sizeof(struct qtaguid_uid_stat));
+	qtu_uid_table = vmalloc_user(qtu_uid_table_size);
+	if (!qtu_uid_table) {
+		pr_err("qtaguid: failed to allocate the uid stats table\n");
+		return -ENOMEM;
+	}
+
+	qtu_uid_table->version = QTAGUID_UID_TABLE_VERSION;
+	qtu_uid_table->nr_entries = QTU_UID_TABLE_SLOTS;
+	qtu_uid_table->entry_size = sizeof(struct qtaguid_uid_stat);
+	for (i = 0; i < QTU_UID_TABLE_SLOTS; i++)
+		qtu_uid_table->entries[i].uid = QTAGUID_UID_STAT_FREE;
+	for (i = 0; i < QTU_UID_LOCKS; i++)
+		spin_lock_init(&qtu_uid_locks[i]);
+
+	xt_qtaguid_uid_stats_file = proc_create("uid_stats", proc_stats_perms,
+					parent_procdir,
+					&proc_qtaguid_uid_stats_fops);
+	if (!xt_qtaguid_uid_stats_file) {
+		pr_err("qtaguid: failed to create xt_qtaguid/uid_stats "
+			"file\n");
+		vfree(qtu_uid_table);
+		qtu_uid_table = NULL;
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
 /*------------------------------------------*/
 static int __init qtaguid_proc_register(struct proc_dir_entry **res_procdir)
 {
@@ -3011,6 +3293,7 @@ static int __init qtaguid_mt_init(void)
 {
 	if (qtaguid_proc_register(&xt_qtaguid_procdir)
 	    || iface_stat_init(xt_qtaguid_procdir)
+	    || qtu_uid_table_init(xt_qtaguid_procdir)
 	    || xt_register_match(&qtaguid_mt_reg)
 	    || misc_register(&qtu_device))
 		return -1;
@@ -11,7 +11,10 @@
 #define __XT_QTAGUID_INTERNAL_H__
 
 #include <linux/types.h>
+#include <linux/hashtable.h>
+#include <linux/percpu.h>
 #include <linux/rbtree.h>
+#include <linux/rcupdate.h>
 #include <linux/spinlock_types.h>
 #include <linux/workqueue.h>
 
@@ -197,6 +200,23 @@ static inline uint64_t dc_sum_packets(struct data_counters *counters,
 		+ counters->bpc[set][direction][IFS_PROTO_OTHER].packets;
 }
 
+/* Sum the per-cpu copies of @src into @dst */
+static inline void dc_fold(struct data_counters *dst,
+			   struct data_counters __percpu *src)
+{
+	struct byte_packet_counters *d = &dst->bpc[0][0][0];
+	struct byte_packet_counters *s;
+	int cpu, i;
+
+	memset(dst, 0, sizeof(*dst));
+	for_each_possible_cpu(cpu) {
+		s = &per_cpu_ptr(src, cpu)->bpc[0][0][0];
+		for (i = 0; i < sizeof(dst->bpc) / sizeof(*d); i++) {
+			d[i].bytes += s[i].bytes;
+			d[i].packets += s[i].packets;
+		}
+	}
+}
 
 /* Generic X based nodes used as a base for rb_tree ops */
 struct tag_node {
@@ -206,14 +226,20 @@ struct tag_node {
 
 struct tag_stat {
 	struct tag_node tn;
-	struct data_counters counters;
+	/* in iface_stat.tag_stat_hash, looked up under RCU */
+	struct hlist_node hash_node;
+	struct rcu_head rcu;
+	/* Per-cpu, updated without locking and folded with dc_fold() */
+	struct data_counters __percpu *counters;
 	/*
 	 * If this tag is acct_tag based, we need to count against the
 	 * matching parent uid_tag.
 	 */
-	struct data_counters *parent_counters;
+	struct data_counters __percpu *parent_counters;
 };
 
+#define TAG_STAT_HASH_BITS 6
+
 struct iface_stat {
 	struct list_head list;  /* in iface_stat_list */
 	char *ifname;
@@ -237,7 +263,13 @@ struct iface_stat {
 
 	struct proc_dir_entry *proc_ptr;
 
+	/*
+	 * Both hold the same tag_stat entries: the tree is for ordered
+	 * walks by the proc readers, the hash for the packet path.
+	 * Changes are made under tag_stat_list_lock.
+	 */
 	struct rb_root tag_stat_tree;
+	DECLARE_HASHTABLE(tag_stat_hash, TAG_STAT_HASH_BITS);
 	spinlock_t tag_stat_list_lock;
 };
 
@@ -255,6 +287,9 @@ struct iface_stat_work {
  */
 struct sock_tag {
 	struct rb_node sock_node;
+	/* in sock_tag_hash, looked up under RCU */
+	struct hlist_node hash_node;
+	struct rcu_head rcu;
 	struct sock *sk;  /* Only used as a number, never dereferenced */
 	/* The socket is needed for sockfd_put() */
 	struct socket *socket;
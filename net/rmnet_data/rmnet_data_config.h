@@ -38,7 +38,6 @@ struct rmnet_logical_ep_conf_s {
 	uint8_t refcount;
 	uint8_t rmnet_mode;
 	uint8_t mux_id;
-	struct timespec flush_time;
 	struct net_device *egress_dev;
 };
 
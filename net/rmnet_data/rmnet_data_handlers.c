@@ -44,15 +44,9 @@ unsigned int dump_pkt_tx;
 module_param(dump_pkt_tx, uint, S_IRUGO | S_IWUSR);
 MODULE_PARM_DESC(dump_pkt_tx, "Dump packets exiting egress handler");
 #endif /* CONFIG_RMNET_DATA_DEBUG_PKT */
-long gro_flush_time __read_mostly = 10000L;
-module_param(gro_flush_time, long, S_IRUGO | S_IWUSR);
-MODULE_PARM_DESC(gro_flush_time, "Flush GRO when spaced more than this");
-
 #define RMNET_DATA_IP_VERSION_4 0x40
 #define RMNET_DATA_IP_VERSION_6 0x60
 
-#define RMNET_DATA_GRO_RCV_FAIL 0
-#define RMNET_DATA_GRO_RCV_PASS 1
 
 /* ***************** Helper Functions *************************************** */
 
@@ -188,63 +182,6 @@ static void rmnet_reset_mac_header(struct sk_buff *skb)
 }
 #endif /*NET_SKBUFF_DATA_USES_OFFSET*/
 
-/**
- * rmnet_check_skb_can_gro() - Check is skb can be passed through GRO handler
- *
- * Determines whether to pass the skb to the GRO handler napi_gro_receive() or
- * handle normally by passing to netif_receive_skb().
- *
- * Tuning this parameter will trade TCP slow start performance for power.
- *
- */
-static int rmnet_check_skb_can_gro(struct sk_buff *skb)
-{
-	switch (skb->data[0] & 0xF0) {
-	case RMNET_DATA_IP_VERSION_4:
-		if (ip_hdr(skb)->protocol == IPPROTO_TCP)
-			return RMNET_DATA_GRO_RCV_PASS;
-		break;
-	case RMNET_DATA_IP_VERSION_6:
-		if (ipv6_hdr(skb)->nexthdr == IPPROTO_TCP)
-			return RMNET_DATA_GRO_RCV_PASS;
-		/* Fall through */
-	}
-
-	return RMNET_DATA_GRO_RCV_FAIL;
-}
-
-/**
- * rmnet_check_gro_can_flush() - Check if GRO handler needs to flush now
- *
- * Determines whether GRO handler needs to flush packets which it has
- * coalesced so far.
- *
- * Warning:
- * This assumes that only TCP packets can be coalesced by the GRO handler which
- * is not true in general. We lose the ability to use GRO for cases like UDP
- * encapsulation protocols.
- *
- * Return:
- * - RMNET_DATA_GRO_RCV_FAIL if packet is sent to netif_receive_skb()
- * - RMNET_DATA_GRO_RCV_PASS if packet is sent to napi_gro_receive()
- */
-static void rmnet_check_gro_can_flush(struct napi_struct *napi,
-					 struct rmnet_logical_ep_conf_s *ep)
-{
-	struct timespec curr_time, diff;
-
-	if (unlikely(ep->flush_time.tv_sec == 0))
-		getnstimeofday(&(ep->flush_time));
-	else {
-		getnstimeofday(&(curr_time));
-		diff = timespec_sub(curr_time, ep->flush_time);
-		if ((diff.tv_sec > 0) || (diff.tv_nsec > gro_flush_time)) {
-			napi_gro_flush(napi, false);
-			getnstimeofday(&(ep->flush_time));
-		}
-	}
-}
-
 /**
  * __rmnet_deliver_skb() - Deliver skb
  *
@@ -258,9 +195,6 @@ static void rmnet_check_gro_can_flush(struct napi_struct *napi,
 static rx_handler_result_t __rmnet_deliver_skb(struct sk_buff *skb,
 					 struct rmnet_logical_ep_conf_s *ep)
 {
-	struct napi_struct *napi = NULL;
-	gro_result_t gro_res;
-
 	trace___rmnet_deliver_skb(skb);
 	switch (ep->rmnet_mode) {
 	case RMNET_EPMODE_NONE:
@@ -279,20 +213,7 @@ static rx_handler_result_t __rmnet_deliver_skb(struct sk_buff *skb,
 		case RX_HANDLER_PASS:
 			skb->pkt_type = PACKET_HOST;
 			rmnet_reset_mac_header(skb);
-
-			if (rmnet_check_skb_can_gro(skb)) {
-				if (skb->dev->features & NETIF_F_GRO) {
-					napi = rmnet_vnd_get_napi(skb->dev);
-					napi_schedule(napi);
-					gro_res = napi_gro_receive(napi, skb);
-					trace_rmnet_gro_downlink(gro_res);
-					rmnet_check_gro_can_flush(napi, ep);
-				} else {
-					netif_receive_skb(skb);
-				}
-			} else {
-				netif_receive_skb(skb);
-			}
+			rmnet_vnd_rx_enqueue(skb, ep->mux_id);
 			return RX_HANDLER_CONSUMED;
 		}
 		return RX_HANDLER_PASS;
@@ -414,7 +335,7 @@ static rx_handler_result_t _rmnet_map_ingress_handler(struct sk_buff *skb,
 
 	/* Subtract MAP header */
 	skb_pull(skb, sizeof(struct rmnet_map_header_s));
-	skb_trim(skb, len);
+	pskb_trim(skb, len);
 	__rmnet_data_set_skb_proto(skb);
 	return __rmnet_deliver_skb(skb, ep);
 }
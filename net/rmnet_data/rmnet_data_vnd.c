@@ -16,6 +16,10 @@
  */
 
 #include <linux/types.h>
+#include <linux/module.h>
+#include <linux/percpu.h>
+#include <linux/smp.h>
+#include <linux/jhash.h>
 #include <linux/rmnet_data.h>
 #include <linux/msm_rmnet.h>
 #include <linux/etherdevice.h>
@@ -38,8 +42,13 @@ RMNET_LOG_MODULE(RMNET_DATA_LOGMASK_VND);
 #define RMNET_MAP_FLOW_NUM_TC_HANDLE 3
 #define RMNET_VND_UF_ACTION_ADD 0
 #define RMNET_VND_UF_ACTION_DEL 1
-#define RMNET_DATA_NAPI_WEIGHT 1
-#define RMNET_DATA_NAPI_WORK 0
+#define RMNET_DATA_NAPI_WEIGHT 64
+#define RMNET_RX_CPU_IPI_PENDING 0
+
+/* ***************** Module Parameters ************************************** */
+static unsigned int rx_steer_cpus __read_mostly;
+module_param(rx_steer_cpus, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(rx_steer_cpus, "Mask of CPUs ingress flows are spread on");
 
 enum {
 	RMNET_VND_UPDATE_FLOW_OK,
@@ -63,11 +72,30 @@ struct rmnet_vnd_private_s {
 	uint32_t qos_version;
 	struct rmnet_logical_ep_conf_s local_ep;
 	struct napi_struct napi;
+	struct sk_buff_head rx_queue;
 	rwlock_t flow_map_lock;
 	struct list_head flow_head;
 	struct rmnet_map_flow_mapping_s root_flow;
 };
 
+/**
+ * struct rmnet_rx_cpu_s - Per-CPU ingress backlog used for flow steering
+ * @queue:     Packets steered to this CPU
+ * @napi:      NAPI instance delivering @queue, runs on this CPU only
+ * @csd:       IPI used to schedule @napi from another CPU
+ * @ipi_state: RMNET_RX_CPU_IPI_PENDING is set while @csd is in flight
+ */
+struct rmnet_rx_cpu_s {
+	struct sk_buff_head queue;
+	struct napi_struct napi;
+	struct call_single_data csd;
+	unsigned long ipi_state;
+};
+
+static DEFINE_PER_CPU(struct rmnet_rx_cpu_s, rmnet_rx_cpu);
+/* NAPI instances of the per-CPU backlogs are not tied to a real device */
+static struct net_device rmnet_rx_napi_dev;
+
 #define RMNET_VND_FC_QUEUED      0
 #define RMNET_VND_FC_NOT_ENABLED 1
 #define RMNET_VND_FC_KMALLOC_ERR 2
@@ -133,6 +161,112 @@ int rmnet_vnd_rx_fixup(struct sk_buff *skb, struct net_device *dev)
 	return RX_HANDLER_PASS;
 }
 
+/**
+ * rmnet_vnd_rx_steer_cpu() - Select the CPU to process an ingress packet on
+ * @skb:      Packet, with skb->protocol set
+ * @mux_id:   MAP mux ID the packet was received on
+ *
+ * The flow hash of the packet, computed over the IP 5-tuple, is mixed with
+ * the mux ID so that the same flow on different logical endpoints may land
+ * on different CPUs. A flow always lands on the same CPU as long as
+ * rx_steer_cpus and the set of online CPUs do not change.
+ *
+ * Return:
+ *      - CPU number
+ *      - -1 if steering is disabled or none of rx_steer_cpus is online
+ */
+static int rmnet_vnd_rx_steer_cpu(struct sk_buff *skb, uint8_t mux_id)
+{
+	unsigned long mask = ACCESS_ONCE(rx_steer_cpus);
+	unsigned int n, cpu;
+
+	mask &= cpumask_bits(cpu_online_mask)[0];
+	if (!mask)
+		return -1;
+
+	n = reciprocal_scale(jhash_1word(skb_get_hash(skb), mux_id),
+			     hweight_long(mask));
+	for_each_set_bit(cpu, &mask, BITS_PER_LONG)
+		if (!n--)
+			return cpu;
+
+	return -1;
+}
+
+static void rmnet_rx_cpu_ipi(void *data)
+{
+	struct rmnet_rx_cpu_s *rx_cpu = data;
+
+	clear_bit(RMNET_RX_CPU_IPI_PENDING, &rx_cpu->ipi_state);
+	napi_schedule(&rx_cpu->napi);
+}
+
+/**
+ * rmnet_vnd_rx_enqueue() - Queue an ingress packet for NAPI delivery
+ * @skb:      Packet, with skb->dev set to the virtual network device
+ * @mux_id:   MAP mux ID the packet was received on
+ *
+ * The packet is handed to the network stack from a NAPI poll, so all the
+ * packets of a MAP aggregate go up together and GRO is flushed once per
+ * poll rather than after a timeout. By default this is the NAPI instance
+ * of the device, on the CPU taking the ingress interrupt. When
+ * rx_steer_cpus is set, packets are steered per flow to the backlog of
+ * one of these CPUs instead, so that multi-flow downloads are not limited
+ * by a single core.
+ */
+void rmnet_vnd_rx_enqueue(struct sk_buff *skb, uint8_t mux_id)
+{
+	struct rmnet_vnd_private_s *dev_conf;
+	struct rmnet_rx_cpu_s *rx_cpu;
+	int cpu;
+
+	cpu = rmnet_vnd_rx_steer_cpu(skb, mux_id);
+	if (cpu < 0) {
+		dev_conf = (struct rmnet_vnd_private_s *)
+			   netdev_priv(skb->dev);
+		skb_queue_tail(&dev_conf->rx_queue, skb);
+		napi_schedule(&dev_conf->napi);
+		return;
+	}
+
+	rx_cpu = &per_cpu(rmnet_rx_cpu, cpu);
+	skb_queue_tail(&rx_cpu->queue, skb);
+
+	if (cpu == smp_processor_id())
+		napi_schedule(&rx_cpu->napi);
+	else if (!test_bit(NAPI_STATE_SCHED, &rx_cpu->napi.state) &&
+		 !test_and_set_bit(RMNET_RX_CPU_IPI_PENDING,
+				   &rx_cpu->ipi_state))
+		smp_call_function_single_async(cpu, &rx_cpu->csd);
+}
+
+/**
+ * rmnet_vnd_rx_flush() - Drop the packets of a device from the backlogs
+ * @dev:      Virtual network device going away
+ */
+static void rmnet_vnd_rx_flush(struct net_device *dev)
+{
+	struct sk_buff_head *queue;
+	struct sk_buff *skb, *tmp;
+	unsigned long flags;
+	int cpu;
+
+	skb_queue_purge(&((struct rmnet_vnd_private_s *)
+			  netdev_priv(dev))->rx_queue);
+
+	for_each_possible_cpu(cpu) {
+		queue = &per_cpu(rmnet_rx_cpu, cpu).queue;
+		spin_lock_irqsave(&queue->lock, flags);
+		skb_queue_walk_safe(queue, skb, tmp) {
+			if (skb->dev == dev) {
+				__skb_unlink(skb, queue);
+				kfree_skb(skb);
+			}
+		}
+		spin_unlock_irqrestore(&queue->lock, flags);
+	}
+}
+
 /**
  * rmnet_vnd_tx_fixup() - Virtual Network Device transmic fixup hook
  * @skb:      Socket buffer ("packet") to modify
@@ -505,19 +639,81 @@ static void rmnet_vnd_setup(struct net_device *dev)
 	/* Flow control */
 	rwlock_init(&dev_conf->flow_map_lock);
 	INIT_LIST_HEAD(&dev_conf->flow_head);
+
+	skb_queue_head_init(&dev_conf->rx_queue);
+}
+
+/**
+ * rmnet_data_napi_deliver() - Deliver queued ingress packets
+ * @napi:      NAPI struct being polled
+ * @queue:     Packets queued by rmnet_vnd_rx_enqueue()
+ * @budget:    Maximum number of packets to deliver
+ *
+ * Packets go through GRO when it is enabled on their device. GRO decides
+ * by itself which packets can be merged.
+ *
+ * Return:
+ *      - Number of packets delivered
+ */
+static int rmnet_data_napi_deliver(struct napi_struct *napi,
+				   struct sk_buff_head *queue, int budget)
+{
+	struct sk_buff *skb;
+	int work = 0;
+
+	while (work < budget && (skb = skb_dequeue(queue)) != NULL) {
+		if (skb->dev->features & NETIF_F_GRO)
+			trace_rmnet_gro_downlink(napi_gro_receive(napi, skb));
+		else
+			netif_receive_skb(skb);
+		work++;
+	}
+
+	if (work < budget) {
+		napi_complete(napi);
+		/* Packets queued while the poll was still scheduled */
+		if (!skb_queue_empty(queue))
+			napi_schedule(napi);
+	}
+
+	return work;
 }
 
 /**
  * rmnet_data_napi_poll() - NAPI poll function
  * @napi:      NAPI struct
+ * @budget:    Maximum number of packets to deliver
+ *
+ * Called by net_rx_action() when NAPI is scheduled. Delivers the packets
+ * queued on the device by rmnet_vnd_rx_enqueue().
  *
- * Called by net_rx_action() when NAPI is scheduled. Since we have already
- * queued packets to network stack, we just flush and return here.
+ * Return:
+ *      - Number of packets delivered
  */
 static int rmnet_data_napi_poll(struct napi_struct *napi, int budget)
 {
-	napi_complete(napi);
-	return RMNET_DATA_NAPI_WORK;
+	struct rmnet_vnd_private_s *dev_conf;
+
+	dev_conf = container_of(napi, struct rmnet_vnd_private_s, napi);
+	return rmnet_data_napi_deliver(napi, &dev_conf->rx_queue, budget);
+}
+
+/**
+ * rmnet_rx_cpu_poll() - NAPI poll function of the per-CPU backlogs
+ * @napi:      NAPI struct
+ * @budget:    Maximum number of packets to deliver
+ *
+ * Delivers the packets steered to this CPU by rmnet_vnd_rx_enqueue().
+ *
+ * Return:
+ *      - Number of packets delivered
+ */
+static int rmnet_rx_cpu_poll(struct napi_struct *napi, int budget)
+{
+	struct rmnet_rx_cpu_s *rx_cpu;
+
+	rx_cpu = container_of(napi, struct rmnet_rx_cpu_s, napi);
+	return rmnet_data_napi_deliver(napi, &rx_cpu->queue, budget);
 }
 
 /* ***************** Exposed API ******************************************** */
@@ -530,12 +726,20 @@ static int rmnet_data_napi_poll(struct napi_struct *napi, int budget)
  */
 void rmnet_vnd_exit(void)
 {
+	struct rmnet_rx_cpu_s *rx_cpu;
 	int i;
 	for (i = 0; i < RMNET_DATA_MAX_VND; i++)
 		if (rmnet_devices[i]) {
 			unregister_netdev(rmnet_devices[i]);
 			free_netdev(rmnet_devices[i]);
 	}
+
+	for_each_possible_cpu(i) {
+		rx_cpu = &per_cpu(rmnet_rx_cpu, i);
+		napi_disable(&rx_cpu->napi);
+		netif_napi_del(&rx_cpu->napi);
+		skb_queue_purge(&rx_cpu->queue);
+	}
 }
 
 /**
@@ -545,8 +749,22 @@ void rmnet_vnd_exit(void)
  */
 int rmnet_vnd_init(void)
 {
+	struct rmnet_rx_cpu_s *rx_cpu;
+	int cpu;
+
 	memset(rmnet_devices, 0,
 	       sizeof(struct net_device *) * RMNET_DATA_MAX_VND);
+
+	init_dummy_netdev(&rmnet_rx_napi_dev);
+	for_each_possible_cpu(cpu) {
+		rx_cpu = &per_cpu(rmnet_rx_cpu, cpu);
+		skb_queue_head_init(&rx_cpu->queue);
+		rx_cpu->csd.func = rmnet_rx_cpu_ipi;
+		rx_cpu->csd.info = rx_cpu;
+		netif_napi_add(&rmnet_rx_napi_dev, &rx_cpu->napi,
+			       rmnet_rx_cpu_poll, RMNET_DATA_NAPI_WEIGHT);
+		napi_enable(&rx_cpu->napi);
+	}
 	return 0;
 }
 
@@ -685,6 +903,7 @@ int rmnet_vnd_free_dev(int id)
 
 		napi_disable(n);
 		netif_napi_del(n);
+		rmnet_vnd_rx_flush(dev);
 		unregister_netdev(dev);
 		free_netdev(dev);
 		return 0;
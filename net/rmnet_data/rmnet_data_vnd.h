@@ -30,6 +30,7 @@ int rmnet_vnd_create_dev(int id, struct net_device **new_device,
 			 const char *prefix);
 int rmnet_vnd_free_dev(int id);
 int rmnet_vnd_rx_fixup(struct sk_buff *skb, struct net_device *dev);
+void rmnet_vnd_rx_enqueue(struct sk_buff *skb, uint8_t mux_id);
 int rmnet_vnd_tx_fixup(struct sk_buff *skb, struct net_device *dev);
 int rmnet_vnd_is_vnd(struct net_device *dev);
 int rmnet_vnd_add_tc_flow(uint32_t id, uint32_t map_flow, uint32_t tc_flow);
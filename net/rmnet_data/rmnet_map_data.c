@@ -57,6 +57,8 @@ struct agg_work {
 
 #define RMNET_MAP_DEAGGR_SPACING  64
 #define RMNET_MAP_DEAGGR_HEADROOM (RMNET_MAP_DEAGGR_SPACING/2)
+/* MAP header + IPv6 header + TCP header with options */
+#define RMNET_MAP_DEAGGR_HDR_LEN  128
 /******************************************************************************/
 
 /**
@@ -122,15 +124,59 @@ done:
 	return map_header;
 }
 
+/**
+ * rmnet_map_deaggregate_frag() - Builds a packet sharing the source page
+ * @skb:        Source socket buffer, with its data in a page fragment
+ * @packet_len: Length of the MAP frame at skb->data
+ *
+ * Only the first RMNET_MAP_DEAGGR_HDR_LEN bytes, which hold the MAP and
+ * IP/transport headers, are copied into the linear area of the new buffer.
+ * The rest of the frame is attached as a fragment pointing into the page
+ * of the source buffer, which stays allocated until all the packets
+ * sharing it are freed.
+ *
+ * Return:
+ *     - Pointer to new skb
+ *     - 0 (null) if allocation failed
+ */
+static struct sk_buff *rmnet_map_deaggregate_frag(struct sk_buff *skb,
+						  uint32_t packet_len)
+{
+	struct sk_buff *skbn;
+	struct page *page;
+	unsigned char *payload;
+
+	skbn = alloc_skb(RMNET_MAP_DEAGGR_HDR_LEN + RMNET_MAP_DEAGGR_SPACING,
+			 GFP_ATOMIC);
+	if (!skbn)
+		return 0;
+
+	skb_reserve(skbn, RMNET_MAP_DEAGGR_HEADROOM);
+	memcpy(skb_put(skbn, RMNET_MAP_DEAGGR_HDR_LEN), skb->data,
+	       RMNET_MAP_DEAGGR_HDR_LEN);
+
+	payload = skb->data + RMNET_MAP_DEAGGR_HDR_LEN;
+	page = virt_to_head_page(payload);
+	get_page(page);
+	skb_add_rx_frag(skbn, 0, page,
+			payload - (unsigned char *)page_address(page),
+			packet_len - RMNET_MAP_DEAGGR_HDR_LEN,
+			packet_len - RMNET_MAP_DEAGGR_HDR_LEN);
+
+	return skbn;
+}
+
 /**
  * rmnet_map_deaggregate() - Deaggregates a single packet
  * @skb:        Source socket buffer containing multiple MAP frames
  * @config:     Physical endpoint configuration of the ingress device
  *
- * A whole new buffer is allocated for each portion of an aggregated frame.
- * Caller should keep calling deaggregate() on the source skb until 0 is
- * returned, indicating that there are no more packets to deaggregate. Caller
- * is responsible for freeing the original skb.
+ * When the aggregated frame sits in a page fragment, each packet shares it
+ * and only its headers are copied. Otherwise a whole new buffer is
+ * allocated for each portion of an aggregated frame. Caller should keep
+ * calling deaggregate() on the source skb until 0 is returned, indicating
+ * that there are no more packets to deaggregate. Caller is responsible for
+ * freeing the original skb.
  *
  * Return:
  *     - Pointer to new skb
@@ -158,14 +204,23 @@ struct sk_buff *rmnet_map_deaggregate(struct sk_buff *skb,
 		return 0;
 	}
 
-	skbn = alloc_skb(packet_len + RMNET_MAP_DEAGGR_SPACING, GFP_ATOMIC);
-	if (!skbn)
-		return 0;
+	if (skb->head_frag && packet_len <= skb_headlen(skb) &&
+	    packet_len > RMNET_MAP_DEAGGR_HDR_LEN) {
+		skbn = rmnet_map_deaggregate_frag(skb, packet_len);
+		if (!skbn)
+			return 0;
+	} else {
+		skbn = alloc_skb(packet_len + RMNET_MAP_DEAGGR_SPACING,
+				 GFP_ATOMIC);
+		if (!skbn)
+			return 0;
+
+		skb_reserve(skbn, RMNET_MAP_DEAGGR_HEADROOM);
+		skb_put(skbn, packet_len);
+		skb_copy_bits(skb, 0, skbn->data, packet_len);
+	}
 
 	skbn->dev = skb->dev;
-	skb_reserve(skbn, RMNET_MAP_DEAGGR_HEADROOM);
-	skb_put(skbn, packet_len);
-	memcpy(skbn->data, skb->data, packet_len);
 	skb_pull(skb, packet_len);
 
 
@@ -595,7 +650,7 @@ static int rmnet_map_validate_ipv6_packet_checksum(unsigned char *map_payload,
  */
 int rmnet_map_checksum_downlink_packet(struct sk_buff *skb)
 {
-	struct rmnet_map_dl_checksum_trailer_s *cksum_trailer;
+	struct rmnet_map_dl_checksum_trailer_s *cksum_trailer, trailer;
 	unsigned int data_len;
 	unsigned char *map_payload;
 	unsigned char ip_version;
@@ -606,9 +661,10 @@ int rmnet_map_checksum_downlink_packet(struct sk_buff *skb)
 	    sizeof(struct rmnet_map_dl_checksum_trailer_s))))
 		return RMNET_MAP_CHECKSUM_ERR_BAD_BUFFER;
 
-	cksum_trailer = (struct rmnet_map_dl_checksum_trailer_s *)
-			(skb->data + data_len
-			+ sizeof(struct rmnet_map_header_s));
+	/* The trailer is in the shared fragment of deaggregated packets */
+	cksum_trailer = skb_header_pointer(skb,
+			data_len + sizeof(struct rmnet_map_header_s),
+			sizeof(trailer), &trailer);
 
 	if (unlikely(!ntohs(cksum_trailer->valid)))
 		return RMNET_MAP_CHECKSUM_VALID_FLAG_NOT_SET;
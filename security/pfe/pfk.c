@@ -258,10 +258,43 @@ static int pfk_set_ecryptfs_data(struct inode *inode, void *ecryptfs_data)
 	}
 
 	isec->pfk_data = ecryptfs_data;
+	isec->pfk_key_index = 0;
 
 	return 0;
 }
 
+/**
+ * pfk_get_key_index_hint() - ice key index last used for the inode's key
+ * @inode: inode
+ *
+ * Return the index or 0 if there isn't any
+ */
+static u32 pfk_get_key_index_hint(const struct inode *inode)
+{
+	struct inode_security_struct *isec = inode->i_security;
+
+	if (!isec)
+		return 0;
+
+	return ACCESS_ONCE(isec->pfk_key_index);
+}
+
+/**
+ * pfk_set_key_index_hint() - remember the ice key index of the inode's key
+ * @inode: inode
+ * @key_index: index the key is loaded at
+ *
+ * This is only a hint for the key cache lookup, which always verifies it,
+ * so it is updated without taking pfk_lock.
+ */
+static void pfk_set_key_index_hint(struct inode *inode, u32 key_index)
+{
+	struct inode_security_struct *isec = inode->i_security;
+
+	if (isec)
+		ACCESS_ONCE(isec->pfk_key_index) = key_index;
+}
+
 
 /**
  * pfk_parse_cipher() - translate string cipher to enum
@@ -430,12 +463,14 @@ int pfk_load_key(const struct bio *bio, struct ice_crypto_setting *ice_setting)
 	if (ret != 0)
 		return ret;
 
+	key_index = pfk_get_key_index_hint(inode);
 	ret = pfk_kc_load_key(key, key_size, salt, salt_size, &key_index);
 	if (ret != 0) {
 		pr_err("could not load key into pfk key cache, error %d\n",
 			 ret);
 		return -EINVAL;
 	}
+	pfk_set_key_index_hint(inode, key_index);
 
 	ice_setting->key_size = key_size_type;
 	ice_setting->algo_mode = algo_mode;
@@ -161,6 +161,38 @@ static struct kc_entry *kc_find_key(const unsigned char *key, size_t key_size,
 	return kc_find_key_at_index(key, key_size, salt, salt_size, &index);
 }
 
+/**
+ * kc_find_key_hint() - find kc entry, trying the hinted ice index first
+ * @key: key to look for
+ * @key_size: the key size
+ * @salt: salt to look for
+ * @salt_size: the salt size
+ * @hint: ice key index the key was last found at, 0 if unknown
+ *
+ * Requests for the same file keep hitting the same entry, so a valid hint
+ * saves walking and comparing against the whole table.
+ * Return entry or NULL in case of error
+ * Should be invoked under lock
+ */
+static struct kc_entry *kc_find_key_hint(const unsigned char *key,
+		size_t key_size, const unsigned char *salt, size_t salt_size,
+		u32 hint)
+{
+	int index = hint - PFK_KC_STARTING_INDEX;
+	struct kc_entry *entry = NULL;
+
+	if (hint >= PFK_KC_STARTING_INDEX && index < PFK_KC_TABLE_SIZE) {
+		entry = &(kc_table[index]);
+		if (entry->time_stamp && entry->key_size == key_size &&
+			entry->salt_size == salt_size &&
+			0 == memcmp(entry->key, key, key_size) &&
+			0 == memcmp(entry->salt, salt, salt_size))
+			return entry;
+	}
+
+	return kc_find_key(key, key_size, salt, salt_size);
+}
+
 /**
  * kc_find_oldest_entry() - finds the entry with minimal timestamp
  *
@@ -312,9 +344,11 @@ int pfk_kc_deinit(void)
  * @key_size: the size of the key
  * @salt: pointer to the salt
  * @salt_size: the size of the salt
- * @key_index: the pointer to key_index where the output will be stored
+ * @key_index: the pointer to key_index where the output will be stored, on
+ * input it may hold the index the key was last loaded to, or 0
  *
  * If key is present in cache, than the key_index will be retrieved from cache.
+ * The entry at the incoming key_index is checked before the rest of the table.
  * If it is not present, the oldest entry from kc table will be evicted,
  * the key will be loaded to ICE via QSEE to the index that is the evicted
  * entry number and stored in cache
@@ -340,7 +374,7 @@ int pfk_kc_load_key(const unsigned char *key, size_t key_size,
 		return -EPERM;
 
 	spin_lock(&kc_lock);
-	entry = kc_find_key(key, key_size, salt, salt_size);
+	entry = kc_find_key_hint(key, key_size, salt, salt_size, *key_index);
 	if (!entry) {
 		entry = kc_find_oldest_entry();
 		if (!entry) {
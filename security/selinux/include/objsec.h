@@ -48,6 +48,7 @@ struct inode_security_struct {
 
 	u32 tag;		/* Per-File-Encryption tag */
 	void *pfk_data; /* Per-File-Key data from ecryptfs */
+	u32 pfk_key_index; /* ICE key slot last used for pfk_data */
 	struct mutex lock;
 };
 
@@ -65,7 +65,8 @@ static struct snd_pcm_hw_constraint_list constraints_sample_rates = {
 
 
 static struct snd_pcm_hardware msm_pcm_hardware_listen = {
-	.info =	(SNDRV_PCM_INFO_BLOCK_TRANSFER |
+	.info =	(SNDRV_PCM_INFO_MMAP |
+		 SNDRV_PCM_INFO_BLOCK_TRANSFER |
 		 SNDRV_PCM_INFO_MMAP_VALID |
 		 SNDRV_PCM_INFO_INTERLEAVED |
 		 SNDRV_PCM_INFO_PAUSE |
@@ -2878,6 +2879,41 @@ fail:
 	return rc;
 }
 
+/*
+ * The LAB ring is coherent memory owned by the slimbus controller, so it
+ * has to be mapped against that device rather than the card. Userspace
+ * then follows the hw_ptr published on each period from the lab thread.
+ */
+static int msm_cpe_lsm_mmap(struct snd_pcm_substream *substream,
+				struct vm_area_struct *vma)
+{
+	struct cpe_lsm_data *lsm_d = cpe_get_lsm_data(substream);
+	struct snd_soc_pcm_runtime *rtd = substream->private_data;
+	struct cpe_lsm_lab *lab_d = &lsm_d->lab;
+	struct msm_slim_dma_data *dma_data = NULL;
+
+	if (!lab_d->is_buf_allocated || !lab_d->pcm_buf) {
+		dev_err(rtd->dev,
+			"%s: LAB buffer not allocated\n", __func__);
+		return -EINVAL;
+	}
+
+	if (rtd->cpu_dai)
+		dma_data = snd_soc_dai_get_dma_data(rtd->cpu_dai,
+					substream);
+	if (!dma_data || !dma_data->sdev) {
+		dev_err(rtd->dev,
+			"%s: dma_data is not set\n", __func__);
+		return -EINVAL;
+	}
+
+	return dma_mmap_coherent(dma_data->sdev->dev.parent, vma,
+				 lab_d->pcm_buf[0].mem,
+				 lab_d->pcm_buf[0].phys,
+				 lsm_d->hw_params.buf_sz *
+				 lsm_d->hw_params.period_count);
+}
+
 static int msm_asoc_cpe_lsm_probe(struct snd_soc_platform *platform)
 {
 	struct snd_soc_card *card;
@@ -2941,6 +2977,7 @@ static struct snd_pcm_ops msm_cpe_lsm_ops = {
 	.trigger = msm_cpe_lsm_trigger,
 	.pointer = msm_cpe_lsm_pointer,
 	.copy = msm_cpe_lsm_copy,
+	.mmap = msm_cpe_lsm_mmap,
 	.hw_params = msm_cpe_lsm_hwparams,
 	.compat_ioctl = msm_cpe_lsm_ioctl_compat,
 };
@@ -66,6 +66,7 @@ int msm_audio_effects_enable_extn(struct audio_client *ac,
 				bool flag)
 {
 	uint32_t updt_params[MAX_ENABLE_CMD_SIZE] = {0};
+	uint32_t *p = updt_params;
 	uint32_t params_length;
 	int rc = 0;
 
@@ -75,33 +76,33 @@ int msm_audio_effects_enable_extn(struct audio_client *ac,
 		return -EINVAL;
 	}
 	params_length = 0;
-	updt_params[0] = AUDPROC_MODULE_ID_VIRTUALIZER;
-	updt_params[1] = AUDPROC_PARAM_ID_ENABLE;
-	updt_params[2] = VIRTUALIZER_ENABLE_PARAM_SZ;
-	updt_params[3] = flag;
-	params_length += COMMAND_PAYLOAD_SZ + VIRTUALIZER_ENABLE_PARAM_SZ;
-	if (effects->virtualizer.enable_flag)
-		q6asm_send_audio_effects_params(ac, (char *)&updt_params[0],
-					params_length);
-	memset(updt_params, 0, MAX_ENABLE_CMD_SIZE);
-	params_length = 0;
-	updt_params[0] = AUDPROC_MODULE_ID_BASS_BOOST;
-	updt_params[1] = AUDPROC_PARAM_ID_ENABLE;
-	updt_params[2] = BASS_BOOST_ENABLE_PARAM_SZ;
-	updt_params[3] = flag;
-	params_length += COMMAND_PAYLOAD_SZ + BASS_BOOST_ENABLE_PARAM_SZ;
-	if (effects->bass_boost.enable_flag)
-		q6asm_send_audio_effects_params(ac, (char *)&updt_params[0],
-					params_length);
-	memset(updt_params, 0, MAX_ENABLE_CMD_SIZE);
-	params_length = 0;
-	updt_params[0] = AUDPROC_MODULE_ID_POPLESS_EQUALIZER;
-	updt_params[1] = AUDPROC_PARAM_ID_ENABLE;
-	updt_params[2] = EQ_ENABLE_PARAM_SZ;
-	updt_params[3] = flag;
-	params_length += COMMAND_PAYLOAD_SZ + EQ_ENABLE_PARAM_SZ;
-	if (effects->equalizer.enable_flag)
-		q6asm_send_audio_effects_params(ac, (char *)&updt_params[0],
+	if (effects->virtualizer.enable_flag) {
+		*p++ = AUDPROC_MODULE_ID_VIRTUALIZER;
+		*p++ = AUDPROC_PARAM_ID_ENABLE;
+		*p++ = VIRTUALIZER_ENABLE_PARAM_SZ;
+		*p++ = flag;
+		params_length += COMMAND_PAYLOAD_SZ +
+				 VIRTUALIZER_ENABLE_PARAM_SZ;
+	}
+	if (effects->bass_boost.enable_flag) {
+		*p++ = AUDPROC_MODULE_ID_BASS_BOOST;
+		*p++ = AUDPROC_PARAM_ID_ENABLE;
+		*p++ = BASS_BOOST_ENABLE_PARAM_SZ;
+		*p++ = flag;
+		params_length += COMMAND_PAYLOAD_SZ +
+				 BASS_BOOST_ENABLE_PARAM_SZ;
+	}
+	if (effects->equalizer.enable_flag) {
+		*p++ = AUDPROC_MODULE_ID_POPLESS_EQUALIZER;
+		*p++ = AUDPROC_PARAM_ID_ENABLE;
+		*p++ = EQ_ENABLE_PARAM_SZ;
+		*p++ = flag;
+		params_length += COMMAND_PAYLOAD_SZ + EQ_ENABLE_PARAM_SZ;
+	}
+	/* All the enables go to the DSP in a single set-param */
+	if (params_length)
+		rc = q6asm_send_audio_effects_params(ac,
+					(char *)&updt_params[0],
 					params_length);
 	return rc;
 }
@@ -645,9 +645,36 @@ static inline int msm_ds2_dap_can_enable_module(int32_t module_id)
 	return true;
 }
 
+/*
+ * Disable every module of the topology list @mod_list that DS2 may
+ * toggle, in one set-param so that the DSP is only queried once.
+ * The list is compacted in place.
+ */
+static void msm_ds2_dap_disable_modules(int port_id, int copp_idx,
+					int32_t *mod_list)
+{
+	int i, num_modules = 0;
+
+	for (i = 1; i < mod_list[0]; i++) {
+		if (!msm_ds2_dap_can_enable_module(mod_list[i]) ||
+		    (mod_list[i] == DS2_MODULE_ID)) {
+			pr_debug("%s: Do not enable/disable %d\n",
+				 __func__, mod_list[i]);
+			continue;
+		}
+
+		pr_debug("%s: param disable %d\n", __func__, mod_list[i]);
+		mod_list[1 + num_modules++] = mod_list[i];
+	}
+	mod_list[0] = num_modules + 1;
+
+	adm_param_enable_multi(port_id, copp_idx, (int *)&mod_list[1],
+			       num_modules, MODULE_DISABLE);
+}
+
 static int msm_ds2_dap_init_modules_in_topology(int dev_map_idx)
 {
-	int rc = 0, i = 0, port_id, copp_idx;
+	int rc = 0, port_id, copp_idx;
 	
 	int32_t param_sz = (ADM_GET_TOPO_MODULE_LIST_LENGTH / sizeof(uint32_t));
 	int32_t *update_param_val = NULL;
@@ -687,20 +714,8 @@ static int msm_ds2_dap_init_modules_in_topology(int dev_map_idx)
 			goto end;
 		}
 		
-		for (i = 1; i < update_param_val[0]; i++) {
-			if (!msm_ds2_dap_can_enable_module(
-				update_param_val[i]) ||
-				(update_param_val[i] == DS2_MODULE_ID)) {
-				pr_debug("%s: Do not enable/disable %d\n",
-					 __func__, update_param_val[i]);
-				continue;
-			}
-
-			pr_debug("%s: param disable %d\n",
-				__func__, update_param_val[i]);
-			adm_param_enable(port_id, copp_idx, update_param_val[i],
-					 MODULE_DISABLE);
-		}
+		msm_ds2_dap_disable_modules(port_id, copp_idx,
+					    update_param_val);
 	} else {
 		msm_ds2_dap_send_cal_data(dev_map_idx);
 
@@ -875,7 +890,7 @@ static int msm_ds2_dap_handle_bypass_wait(int port_id, int copp_idx,
 
 static int msm_ds2_dap_handle_bypass(struct dolby_param_data *dolby_data)
 {
-	int rc = 0, i = 0, j = 0;
+	int rc = 0, i = 0;
 	
 	int32_t param_sz = (ADM_GET_TOPO_MODULE_LIST_LENGTH / sizeof(uint32_t));
 	int32_t *mod_list = NULL;
@@ -985,18 +1000,8 @@ static int msm_ds2_dap_handle_bypass(struct dolby_param_data *dolby_data)
 				}
 			} else {
 				
-				for (j = 1; j < mod_list[0]; j++) {
-					if (!msm_ds2_dap_can_enable_module(
-						mod_list[j]) ||
-						mod_list[j] ==
-						DS2_MODULE_ID)
-						continue;
-					pr_debug("%s: param disable %d\n",
-						__func__, mod_list[j]);
-					adm_param_enable(port_id, copp_idx,
-							 mod_list[j],
-							 MODULE_DISABLE);
-				}
+				msm_ds2_dap_disable_modules(port_id, copp_idx,
+							    mod_list);
 
 				
 				pr_debug("%s:DS2 param enable\n", __func__);
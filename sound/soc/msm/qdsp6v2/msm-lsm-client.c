@@ -44,6 +44,7 @@
 
 static struct snd_pcm_hardware msm_pcm_hardware_capture = {
 	.info =                 (SNDRV_PCM_INFO_MMAP |
+				SNDRV_PCM_INFO_MMAP_VALID |
 				SNDRV_PCM_INFO_BLOCK_TRANSFER |
 				SNDRV_PCM_INFO_INTERLEAVED |
 				SNDRV_PCM_INFO_PAUSE | SNDRV_PCM_INFO_RESUME),
@@ -1914,6 +1915,36 @@ static int msm_lsm_pcm_copy(struct snd_pcm_substream *substream, int ch,
 	return 0;
 }
 
+/*
+ * Map the LAB ION buffer straight into the recognizer so it can consume
+ * keyword audio from the mmap'd ring as each period completes, driven by
+ * the hw_ptr updates from snd_pcm_period_elapsed(), without waiting for
+ * a copy through the kernel.
+ */
+static int msm_lsm_pcm_mmap(struct snd_pcm_substream *substream,
+				struct vm_area_struct *vma)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	struct lsm_priv *prtd = runtime->private_data;
+	struct lsm_lab_buffer *lab;
+	struct audio_buffer ab;
+
+	if (!prtd || !prtd->lsm_client || !prtd->lsm_client->lab_buffer) {
+		pr_err("%s: LAB buffer not allocated\n", __func__);
+		return -EINVAL;
+	}
+
+	lab = &prtd->lsm_client->lab_buffer[0];
+	memset(&ab, 0, sizeof(ab));
+	ab.phys = lab->phys;
+	ab.data = lab->data;
+	ab.size = snd_pcm_lib_buffer_bytes(substream);
+	ab.handle = lab->handle;
+	ab.client = lab->client;
+
+	return msm_audio_ion_mmap(&ab, vma);
+}
+
 static struct snd_pcm_ops msm_lsm_ops = {
 	.open           = msm_lsm_open,
 	.close          = msm_lsm_close,
@@ -1923,6 +1954,7 @@ static struct snd_pcm_ops msm_lsm_ops = {
 	.hw_params      = msm_lsm_hw_params,
 	.copy           = msm_lsm_pcm_copy,
 	.pointer        = msm_lsm_pcm_pointer,
+	.mmap           = msm_lsm_pcm_mmap,
 };
 
 static int msm_asoc_lsm_new(struct snd_soc_pcm_runtime *rtd)
@@ -508,6 +508,7 @@ static int msm_pcm_open(struct snd_pcm_substream *substream)
 {
 	struct snd_pcm_runtime *runtime = substream->runtime;
 	struct snd_soc_pcm_runtime *soc_prtd = substream->private_data;
+	struct msm_plat_data *pdata;
 	struct msm_audio *prtd;
 	int ret = 0;
 
@@ -538,6 +539,16 @@ static int msm_pcm_open(struct snd_pcm_substream *substream)
 		return -EINVAL;
 	}
 
+	/*
+	 * Once the buffer is mmapped the DSP is fed straight from it by
+	 * the write/read done events, so low latency clients that track
+	 * the position themselves do not need to be woken up every period.
+	 */
+	pdata = (struct msm_plat_data *)
+		dev_get_drvdata(soc_prtd->platform->dev);
+	if (pdata && pdata->perf_mode != LEGACY_PCM_MODE)
+		runtime->hw.info |= SNDRV_PCM_INFO_NO_PERIOD_WAKEUP;
+
 	ret = snd_pcm_hw_constraint_list(runtime, 0,
 				SNDRV_PCM_HW_PARAM_RATE,
 				&constraints_sample_rates);
@@ -75,6 +75,23 @@ static struct mutex routing_lock;
 
 static struct cal_type_data *cal_data;
 
+/*
+ * Topology last picked for each FE and path, so that re-routing an FE to
+ * a new BE does not walk the calibration list again. Entries are only
+ * valid for the app type config they were looked up with and are all
+ * dropped when new topology calibration comes in.
+ */
+struct msm_pcm_routing_topology_cache {
+	bool valid;
+	int app_type;
+	int acdb_dev_id;
+	int sample_rate;
+	int topology;
+};
+
+static struct msm_pcm_routing_topology_cache
+	topology_cache[MSM_FRONTEND_DAI_MM_SIZE][MAX_PATH_TYPE];
+
 static int fm_switch_enable;
 static int hfp_switch_enable;
 static int fm_pcmrx_switch_enable;
@@ -623,6 +640,7 @@ static int msm_routing_get_adm_topology(int path, int fedai_id)
 {
 	int				topology = NULL_COPP_TOPOLOGY;
 	struct cal_block_data		*cal_block = NULL;
+	struct msm_pcm_routing_topology_cache *cache = NULL;
 	int app_type = 0, acdb_dev_id = 0, sample_rate = 0;
 	pr_debug("%s\n", __func__);
 
@@ -637,13 +655,30 @@ static int msm_routing_get_adm_topology(int path, int fedai_id)
 		acdb_dev_id = fe_dai_app_type_cfg[fedai_id].acdb_dev_id;
 		sample_rate = fe_dai_app_type_cfg[fedai_id].sample_rate;
 	}
+
+	if (fedai_id >= 0 && fedai_id < MSM_FRONTEND_DAI_MM_SIZE) {
+		cache = &topology_cache[fedai_id][path];
+		if (cache->valid && cache->app_type == app_type &&
+		    cache->acdb_dev_id == acdb_dev_id &&
+		    cache->sample_rate == sample_rate) {
+			topology = cache->topology;
+			goto unlock;
+		}
+	}
+
 	cal_block = msm_routing_find_topology(path, app_type,
 					      acdb_dev_id, sample_rate);
-	if (cal_block == NULL)
-		goto unlock;
-
-	topology = ((struct audio_cal_info_adm_top *)
-		cal_block->cal_info)->topology;
+	if (cal_block != NULL)
+		topology = ((struct audio_cal_info_adm_top *)
+			cal_block->cal_info)->topology;
+
+	if (cache) {
+		cache->app_type = app_type;
+		cache->acdb_dev_id = acdb_dev_id;
+		cache->sample_rate = sample_rate;
+		cache->topology = topology;
+		cache->valid = true;
+	}
 unlock:
 	mutex_unlock(&cal_data->lock);
 done:
@@ -9261,6 +9296,10 @@ static int msm_routing_set_cal(int32_t cal_type,
 		ret = -EINVAL;
 		goto done;
 	}
+
+	mutex_lock(&cal_data->lock);
+	memset(topology_cache, 0, sizeof(topology_cache));
+	mutex_unlock(&cal_data->lock);
 done:
 	return ret;
 }
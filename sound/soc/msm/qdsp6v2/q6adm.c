@@ -16,6 +16,8 @@
 #include <linux/uaccess.h>
 #include <linux/atomic.h>
 #include <linux/wait.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/qdsp6v2/apr.h>
 #include <sound/apr_audio-v2.h>
 #include <sound/q6adm-v2.h>
@@ -103,6 +105,30 @@ struct adm_ctl {
 
 static struct adm_ctl			this_adm;
 
+/* Round trip time of every ADM command the driver waits on */
+static struct q6audio_latency_hist adm_apr_latency;
+
+#define adm_wait_event_timeout(wq, condition, timeout)			\
+	q6audio_wait_event_timeout(&adm_apr_latency, wq, condition, timeout)
+
+static int adm_apr_latency_show(struct seq_file *m, void *unused)
+{
+	q6audio_latency_hist_show(m, "adm apr", &adm_apr_latency);
+	return 0;
+}
+
+static int adm_apr_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, adm_apr_latency_show, inode->i_private);
+}
+
+static const struct file_operations adm_apr_latency_fops = {
+	.open = adm_apr_latency_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 struct adm_multi_ch_map {
 	bool set_channel_map;
 	char channel_mapping[PCM_FORMAT_MAX_NUM_CHANNEL];
@@ -337,7 +363,7 @@ int adm_dts_eagle_set(int port_id, int copp_idx, int param_id,
 		ret = -EINVAL;
 		goto fail_cmd;
 	}
-	ret = wait_event_timeout(this_adm.copp.wait[p_idx][copp_idx],
+	ret = adm_wait_event_timeout(this_adm.copp.wait[p_idx][copp_idx],
 			atomic_read(&this_adm.copp.stat
 			[p_idx][copp_idx]) >= 0,
 			msecs_to_jiffies(TIMEOUT_MS));
@@ -447,7 +473,7 @@ int adm_dts_eagle_get(int port_id, int copp_idx, int param_id,
 		ret = -EINVAL;
 		goto fail_cmd;
 	}
-	ret = wait_event_timeout(this_adm.copp.wait[p_idx][copp_idx],
+	ret = adm_wait_event_timeout(this_adm.copp.wait[p_idx][copp_idx],
 			atomic_read(&this_adm.copp.stat
 			[p_idx][copp_idx]) >= 0,
 			msecs_to_jiffies(TIMEOUT_MS));
@@ -532,7 +558,7 @@ int q6adm_enable_effect(u16 port_id, int copp_idx, uint32_t payload_size, void *
 	}
 	
 
-	rc = wait_event_timeout(this_adm.copp.wait[index][copp_idx],
+	rc = adm_wait_event_timeout(this_adm.copp.wait[index][copp_idx],
 			atomic_read(&this_adm.copp.stat[index][copp_idx])>=0,
 			msecs_to_jiffies(TIMEOUT_MS));
 	if (!rc) {
@@ -781,7 +807,7 @@ int srs_trumedia_open(int port_id, int copp_idx, __s32 srs_tech_id,
 		goto fail_cmd;
 	}
 	
-	ret = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	ret = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 			atomic_read(&this_adm.copp.stat
 			[port_idx][copp_idx]) >= 0,
 			msecs_to_jiffies(TIMEOUT_MS));
@@ -867,7 +893,7 @@ int adm_set_stereo_to_custom_stereo(int port_id, int copp_idx,
 		goto set_stereo_to_custom_stereo_return;
 	}
 	
-	rc = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	rc = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 				atomic_read(&this_adm.copp.stat
 				[port_idx][copp_idx]) >= 0,
 				msecs_to_jiffies(TIMEOUT_MS));
@@ -943,7 +969,7 @@ int adm_dolby_dap_send_params(int port_id, int copp_idx, char *params,
 		goto dolby_dap_send_param_return;
 	}
 	
-	rc = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	rc = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 		atomic_read(&this_adm.copp.stat[port_idx][copp_idx]) >= 0,
 		msecs_to_jiffies(TIMEOUT_MS));
 	if (!rc) {
@@ -1018,7 +1044,7 @@ int adm_send_params_v5(int port_id, int copp_idx, char *params,
 		goto send_param_return;
 	}
 	
-	rc = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	rc = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 		atomic_read(&this_adm.copp.stat[port_idx][copp_idx]) >= 0,
 		msecs_to_jiffies(TIMEOUT_MS));
 	if (!rc) {
@@ -1097,7 +1123,7 @@ int adm_get_params_v2(int port_id, int copp_idx, uint32_t module_id,
 		goto adm_get_param_return;
 	}
 	
-	rc = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	rc = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 	atomic_read(&this_adm.copp.stat[port_idx][copp_idx]) >= 0,
 		msecs_to_jiffies(TIMEOUT_MS));
 	if (!rc) {
@@ -1212,7 +1238,7 @@ int adm_get_pp_topo_module_list(int port_id, int copp_idx, int32_t param_length,
 		goto adm_pp_module_list_l;
 	}
 	
-	rc = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	rc = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 		atomic_read(&this_adm.copp.stat[port_idx][copp_idx]) >= 0,
 		msecs_to_jiffies(TIMEOUT_MS));
 	if (!rc) {
@@ -1701,7 +1727,7 @@ static int adm_memory_map_regions(phys_addr_t *buf_add, uint32_t mempool_id,
 		goto fail_cmd;
 	}
 
-	ret = wait_event_timeout(this_adm.adm_wait,
+	ret = adm_wait_event_timeout(this_adm.adm_wait,
 				 atomic_read(&this_adm.adm_stat) >= 0,
 				 5 * HZ);
 	if (!ret) {
@@ -1754,7 +1780,7 @@ static int adm_memory_unmap_regions(void)
 		goto fail_cmd;
 	}
 
-	ret = wait_event_timeout(this_adm.adm_wait,
+	ret = adm_wait_event_timeout(this_adm.adm_wait,
 				 atomic_read(&this_adm.adm_stat) >= 0,
 				 5 * HZ);
 	if (!ret) {
@@ -1877,7 +1903,7 @@ static void send_adm_custom_topology(void)
 		goto unlock;
 	}
 	
-	result = wait_event_timeout(this_adm.adm_wait,
+	result = adm_wait_event_timeout(this_adm.adm_wait,
 				    atomic_read(&this_adm.adm_stat) >= 0,
 				    msecs_to_jiffies(TIMEOUT_MS));
 	if (!result) {
@@ -1969,7 +1995,7 @@ static int send_adm_cal_block(int port_id, int copp_idx,
 		goto done;
 	}
 	
-	result = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	result = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 		atomic_read(&this_adm.copp.stat[port_idx][copp_idx]) >= 0,
 		msecs_to_jiffies(TIMEOUT_MS));
 	if (!result) {
@@ -2223,7 +2249,7 @@ int adm_connect_afe_port(int mode, int session_id, int port_id)
 		goto fail_cmd;
 	}
 	
-	ret = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	ret = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 		atomic_read(&this_adm.copp.stat[port_idx][copp_idx]) >= 0,
 		msecs_to_jiffies(TIMEOUT_MS));
 	if (!ret) {
@@ -2511,7 +2537,8 @@ int adm_open(int port_id, int path, int rate, int channel_mode, int topology,
 			return -EINVAL;
 		}
 		
-		ret = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+		ret = adm_wait_event_timeout(
+			this_adm.copp.wait[port_idx][copp_idx],
 			atomic_read(&this_adm.copp.stat
 			[port_idx][copp_idx]) >= 0,
 			msecs_to_jiffies(TIMEOUT_MS));
@@ -2633,7 +2660,7 @@ void adm_copp_mfc_cfg(int port_id, int copp_idx, int dst_sample_rate)
 		goto fail_cmd;
 	}
 	
-	rc = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	rc = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 		atomic_read(&this_adm.copp.stat
 		[port_idx][copp_idx]) >= 0,
 		msecs_to_jiffies(TIMEOUT_MS));
@@ -2743,7 +2770,7 @@ int adm_matrix_map(int path, struct route_payload payload_map, int perf_mode)
 		ret = -EINVAL;
 		goto fail_cmd;
 	}
-	ret = wait_event_timeout(this_adm.matrix_map_wait,
+	ret = adm_wait_event_timeout(this_adm.matrix_map_wait,
 				atomic_read(&this_adm.matrix_map_stat) >= 0,
 				msecs_to_jiffies(TIMEOUT_MS));
 	if (!ret) {
@@ -2932,7 +2959,8 @@ int adm_close(int port_id, int perf_mode, int copp_idx)
 			return -EINVAL;
 		}
 
-		ret = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+		ret = adm_wait_event_timeout(
+			this_adm.copp.wait[port_idx][copp_idx],
 			atomic_read(&this_adm.copp.stat
 			[port_idx][copp_idx]) >= 0,
 			msecs_to_jiffies(TIMEOUT_MS));
@@ -3424,7 +3452,7 @@ int adm_set_volume(int port_id, int copp_idx, int volume)
 		goto fail_cmd;
 	}
 	
-	rc = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	rc = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 		atomic_read(&this_adm.copp.stat[port_idx][copp_idx]) >= 0,
 		msecs_to_jiffies(TIMEOUT_MS));
 	if (!rc) {
@@ -3516,7 +3544,7 @@ int adm_set_softvolume(int port_id, int copp_idx,
 		goto fail_cmd;
 	}
 	
-	rc = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	rc = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 		atomic_read(&this_adm.copp.stat[port_idx][copp_idx]) >= 0,
 		msecs_to_jiffies(TIMEOUT_MS));
 	if (!rc) {
@@ -3601,7 +3629,7 @@ int adm_param_enable(int port_id, int copp_idx, int module_id,  int enable)
 		goto fail_cmd;
 	}
 	
-	rc = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	rc = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 		atomic_read(&this_adm.copp.stat[port_idx][copp_idx]) >= 0,
 		msecs_to_jiffies(TIMEOUT_MS));
 	if (!rc) {
@@ -3626,6 +3654,55 @@ fail_cmd:
 
 }
 
+/*
+ * Enable or disable several modules of a copp with a single
+ * ADM_CMD_SET_PP_PARAMS_V5 instead of one round trip per module.
+ */
+int adm_param_enable_multi(int port_id, int copp_idx, int *module_ids,
+			   int num_modules, int enable)
+{
+	struct adm_param_data_v5 *param;
+	char *params;
+	uint32_t params_length;
+	int i, rc;
+
+	if (num_modules <= 0 || !module_ids)
+		return 0;
+
+	if (copp_idx < 0 || copp_idx >= MAX_COPPS_PER_PORT) {
+		pr_err("%s: Invalid copp_num: %d\n", __func__, copp_idx);
+		return -EINVAL;
+	}
+
+	params_length = num_modules *
+			(sizeof(struct adm_param_data_v5) + sizeof(uint32_t));
+	params = kzalloc(params_length, GFP_KERNEL);
+	if (!params) {
+		pr_err("%s: params memory alloc failed\n", __func__);
+		return -ENOMEM;
+	}
+
+	param = (struct adm_param_data_v5 *)params;
+	for (i = 0; i < num_modules; i++) {
+		pr_debug("%s port_id %d, module_id 0x%x, enable %d\n",
+			 __func__, port_id, module_ids[i], enable);
+		param->module_id = module_ids[i];
+		param->param_id = AUDPROC_PARAM_ID_ENABLE;
+		param->param_size = sizeof(uint32_t);
+		param->reserved = 0;
+		*(uint32_t *)(param + 1) = enable;
+		param = (struct adm_param_data_v5 *)
+			((u8 *)(param + 1) + sizeof(uint32_t));
+	}
+
+	rc = adm_send_params_v5(port_id, copp_idx, params, params_length);
+	if (rc)
+		pr_err("%s: %d modules enable %d failed on port = %#x rc %d\n",
+		       __func__, num_modules, enable, port_id, rc);
+	kfree(params);
+	return rc;
+}
+
 int adm_send_calibration(int port_id, int copp_idx, int path, int perf_mode,
 			 int cal_type, char *params, int size)
 {
@@ -3692,7 +3769,7 @@ int adm_send_calibration(int port_id, int copp_idx, int path, int perf_mode,
 		goto end;
 	}
 	
-	rc = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	rc = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 		atomic_read(&this_adm.copp.stat[port_idx][copp_idx]) >= 0,
 		msecs_to_jiffies(TIMEOUT_MS));
 	if (!rc) {
@@ -3790,7 +3867,7 @@ int adm_wait_timeout(int port_id, int copp_idx, int wait_time)
 		return -EINVAL;
 	}
 
-	ret = wait_event_timeout(
+	ret = adm_wait_event_timeout(
 		this_adm.copp.adm_delay_wait[port_idx][copp_idx],
 		atomic_read(&this_adm.copp.adm_delay_stat[port_idx][copp_idx]),
 		msecs_to_jiffies(wait_time));
@@ -3939,7 +4016,7 @@ int adm_send_compressed_device_mute(int port_id, int copp_idx, bool mute_on)
 	}
 
 	
-	ret = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	ret = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 		atomic_read(&this_adm.copp.stat[port_idx][copp_idx]) >= 0,
 		msecs_to_jiffies(TIMEOUT_MS));
 	if (!ret) {
@@ -4016,7 +4093,7 @@ int adm_send_compressed_device_latency(int port_id, int copp_idx, int latency)
 	}
 
 	
-	ret = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	ret = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 		atomic_read(&this_adm.copp.stat[port_idx][copp_idx]) >= 0,
 		msecs_to_jiffies(TIMEOUT_MS));
 	if (!ret) {
@@ -4122,7 +4199,7 @@ int adm_set_sound_focus(int port_id, int copp_idx,
 		goto done;
 	}
 	
-	ret = wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
+	ret = adm_wait_event_timeout(this_adm.copp.wait[port_idx][copp_idx],
 		atomic_read(&this_adm.copp.stat[port_idx][copp_idx]),
 		msecs_to_jiffies(TIMEOUT_MS));
 	if (!ret) {
@@ -4338,7 +4415,7 @@ int adm_get_source_tracking(int port_id, int copp_idx,
 		ret = -EINVAL;
 		goto done;
 	}
-	ret = wait_event_timeout(this_adm.copp.wait[p_idx][copp_idx],
+	ret = adm_wait_event_timeout(this_adm.copp.wait[p_idx][copp_idx],
 			atomic_read(&this_adm.copp.stat[p_idx][copp_idx]) >= 0,
 			msecs_to_jiffies(TIMEOUT_MS));
 	if (!ret) {
@@ -4410,6 +4487,7 @@ static int __init adm_init(void)
 	init_waitqueue_head(&this_adm.matrix_map_wait);
 	atomic_set(&this_adm.adm_stat, 0);
 	init_waitqueue_head(&this_adm.adm_wait);
+	q6audio_latency_hist_init(&adm_apr_latency);
 
 	for (i = 0; i < AFE_MAX_PORTS; i++) {
 		for (j = 0; j < MAX_COPPS_PER_PORT; j++) {
@@ -4446,6 +4524,9 @@ static int __init adm_init(void)
 	atomic_set(&this_adm.mem_map_handles[ADM_MEM_MAP_INDEX_SOURCE_TRACKING],
 		   0);
 
+	debugfs_create_file("q6adm_apr_latency", S_IRUGO, NULL, NULL,
+			    &adm_apr_latency_fops);
+
 	return 0;
 }
 
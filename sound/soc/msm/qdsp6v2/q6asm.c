@@ -25,6 +25,7 @@
 #include <linux/msm_audio.h>
 
 #include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/time.h>
 #include <linux/atomic.h>
 #include <linux/msm_audio_ion.h>
@@ -68,6 +69,64 @@ struct asm_mmap {
 static struct asm_mmap this_mmap;
 static struct audio_client *session[SESSION_MAX+1];
 
+/*
+ * Command round trip and ARM/DSP position drift statistics of each
+ * session, slot 0 collects the commands sent outside of a session.
+ */
+struct asm_session_latency {
+	struct q6audio_latency_hist apr;
+	struct q6audio_latency_hist drift;
+	bool drift_valid;
+	ktime_t drift_arm_time;
+	uint64_t drift_dsp_time;
+	s64 drift_total_us;
+};
+
+static struct asm_session_latency session_latency[SESSION_MAX+1];
+
+static struct q6audio_latency_hist *q6asm_apr_latency(struct audio_client *ac)
+{
+	if (ac->session > 0 && ac->session <= SESSION_MAX)
+		return &session_latency[ac->session].apr;
+	return &session_latency[0].apr;
+}
+
+#define q6asm_wait_event_timeout(ac, wq, condition, timeout)		\
+	q6audio_wait_event_timeout(q6asm_apr_latency(ac), wq, condition, \
+				   timeout)
+
+/* Forget the drift baseline, the DSP clock restarts on run/pause/flush */
+static void q6asm_reset_drift(struct audio_client *ac)
+{
+	if (ac->session > 0 && ac->session <= SESSION_MAX)
+		session_latency[ac->session].drift_valid = false;
+}
+
+/*
+ * Compare how far the DSP session time moved since the previous query
+ * with the ARM time elapsed over the same interval.
+ */
+static void q6asm_update_drift(struct audio_client *ac, uint64_t dsp_time)
+{
+	struct asm_session_latency *lat;
+	ktime_t now = ktime_get();
+	s64 delta;
+
+	if (ac->session <= 0 || ac->session > SESSION_MAX)
+		return;
+
+	lat = &session_latency[ac->session];
+	if (lat->drift_valid && dsp_time >= lat->drift_dsp_time) {
+		delta = ktime_us_delta(now, lat->drift_arm_time) -
+			(s64)(dsp_time - lat->drift_dsp_time);
+		lat->drift_total_us += delta;
+		q6audio_latency_hist_add(&lat->drift, abs64(delta));
+	}
+	lat->drift_arm_time = now;
+	lat->drift_dsp_time = dsp_time;
+	lat->drift_valid = true;
+}
+
 struct asm_no_wait_node {
 	struct list_head	list;
 	int32_t			opcode;
@@ -166,7 +225,7 @@ int q6asm_enable_effect(struct audio_client *ac, uint32_t module_id,
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) == 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout in sending command to aprn", __func__);
@@ -285,6 +344,42 @@ static const struct file_operations audio_input_latency_debug_fops = {
 	.write = audio_input_latency_dbgfs_write
 };
 
+static int q6asm_apr_latency_show(struct seq_file *m, void *unused)
+{
+	struct asm_session_latency *lat;
+	char name[32];
+	int n;
+
+	for (n = 0; n <= SESSION_MAX; n++) {
+		lat = &session_latency[n];
+		if (!lat->apr.count && !lat->apr.timeouts && !lat->drift.count)
+			continue;
+
+		snprintf(name, sizeof(name), "session %d apr", n);
+		q6audio_latency_hist_show(m, name, &lat->apr);
+		if (!lat->drift.count)
+			continue;
+
+		snprintf(name, sizeof(name), "session %d drift", n);
+		q6audio_latency_hist_show(m, name, &lat->drift);
+		seq_printf(m, "session %d drift total %lld us\n", n,
+			   lat->drift_total_us);
+	}
+	return 0;
+}
+
+static int q6asm_apr_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, q6asm_apr_latency_show, inode->i_private);
+}
+
+static const struct file_operations q6asm_apr_latency_fops = {
+	.open = q6asm_apr_latency_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static void config_debug_fs_write_cb(void)
 {
 	if (out_enable_flag) {
@@ -376,6 +471,8 @@ static void config_debug_fs_init(void)
 		pr_err("%s: debugfs_create_file failed\n", __func__);
 		goto file_fail;
 	}
+	debugfs_create_file("q6asm_apr_latency", S_IRUGO, NULL, NULL,
+			    &q6asm_apr_latency_fops);
 	return;
 file_fail:
 	kfree(in_buffer);
@@ -437,6 +534,10 @@ static int q6asm_session_alloc(struct audio_client *ac)
 	for (n = 1; n <= SESSION_MAX; n++) {
 		if (!session[n]) {
 			session[n] = ac;
+			q6audio_latency_hist_reset(&session_latency[n].apr);
+			q6audio_latency_hist_reset(&session_latency[n].drift);
+			session_latency[n].drift_valid = false;
+			session_latency[n].drift_total_us = 0;
 			return n;
 		}
 	}
@@ -744,7 +845,7 @@ int send_asm_custom_topology(struct audio_client *ac)
 
 	}
 
-	result = wait_event_timeout(ac->mem_wait,
+	result = q6asm_wait_event_timeout(ac, ac->mem_wait,
 			(atomic_read(&ac->mem_state) >= 0), 5*HZ);
 	if (!result) {
 		pr_err("%s: Set topologies failed timeout\n", __func__);
@@ -2275,7 +2376,7 @@ static int __q6asm_open_read(struct audio_client *ac,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for open read\n",
@@ -2370,7 +2471,7 @@ int q6asm_open_write_compressed(struct audio_client *ac, uint32_t format,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 		(atomic_read(&ac->cmd_state) >= 0), 1*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for OPEN_WRITE_COMPR rc[%d]\n",
@@ -2516,7 +2617,7 @@ static int __q6asm_open_write(struct audio_client *ac, uint32_t format,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for open write\n", __func__);
@@ -2698,7 +2799,7 @@ static int __q6asm_open_read_write(struct audio_client *ac, uint32_t rd_format,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for open read-write\n",
@@ -2780,7 +2881,7 @@ int q6asm_open_loopback_v2(struct audio_client *ac, uint16_t bits_per_sample)
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for open_loopback\n",
@@ -2830,6 +2931,7 @@ int q6asm_run(struct audio_client *ac, uint32_t flags,
 	run.time_msw = msw_ts;
 
 	config_debug_fs_run();
+	q6asm_reset_drift(ac);
 
 	rc = apr_send_pkt(ac->apr, (uint32_t *) &run);
 	if (rc < 0) {
@@ -2839,7 +2941,7 @@ int q6asm_run(struct audio_client *ac, uint32_t flags,
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for run success",
@@ -2884,7 +2986,7 @@ static int __q6asm_run_nowait(struct audio_client *ac, uint32_t flags,
 	run.time_lsw = lsw_ts;
 	run.time_msw = msw_ts;
 
-	
+	q6asm_reset_drift(ac);
 	atomic_inc(&ac->nowait_cmd_cnt);
 	q6asm_add_nowait_opcode(ac, run.hdr.opcode);
 	rc = apr_send_pkt(ac->apr, (uint32_t *) &run);
@@ -2944,7 +3046,7 @@ int q6asm_enc_cfg_blk_aac(struct audio_client *ac,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for FORMAT_UPDATE\n",
@@ -2996,7 +3098,7 @@ int q6asm_set_encdec_chan_map(struct audio_client *ac,
 			   ASM_PARAM_ID_DEC_OUTPUT_CHAN_MAP, rc);
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 				 (atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout opcode[0x%x]\n", __func__,
@@ -3075,7 +3177,7 @@ int q6asm_enc_cfg_blk_pcm_v2(struct audio_client *ac,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout opcode[0x%x]\n",
@@ -3158,7 +3260,7 @@ int q6asm_enc_cfg_blk_pcm_native(struct audio_client *ac,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout opcode[0x%x]\n",
@@ -3267,7 +3369,7 @@ int q6asm_enable_sbrps(struct audio_client *ac,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout opcode[0x%x] ", __func__, sbrps.hdr.opcode);
@@ -3315,7 +3417,7 @@ int q6asm_cfg_dual_mono_aac(struct audio_client *ac,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout opcode[0x%x]\n", __func__,
@@ -3359,7 +3461,7 @@ int q6asm_cfg_aac_sel_mix_coef(struct audio_client *ac, uint32_t mix_coeff)
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 		(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout opcode[0x%x]\n",
@@ -3414,7 +3516,7 @@ int q6asm_enc_cfg_blk_qcelp(struct audio_client *ac, uint32_t frames_per_buf,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for setencdec v13k resp\n",
@@ -3468,7 +3570,7 @@ int q6asm_enc_cfg_blk_evrc(struct audio_client *ac, uint32_t frames_per_buf,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for encdec evrc\n", __func__);
@@ -3517,7 +3619,7 @@ int q6asm_enc_cfg_blk_amrnb(struct audio_client *ac, uint32_t frames_per_buf,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for set encdec amrnb\n", __func__);
@@ -3566,7 +3668,7 @@ int q6asm_enc_cfg_blk_amrwb(struct audio_client *ac, uint32_t frames_per_buf,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for FORMAT_UPDATE\n", __func__);
@@ -3637,7 +3739,7 @@ static int __q6asm_media_format_block_pcm(struct audio_client *ac,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for format update\n", __func__);
@@ -3733,7 +3835,7 @@ static int __q6asm_media_format_block_multi_ch_pcm(struct audio_client *ac,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for format update\n", __func__);
@@ -3811,7 +3913,7 @@ static int __q6asm_media_format_block_multi_aac(struct audio_client *ac,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for FORMAT_UPDATE\n", __func__);
@@ -3884,7 +3986,7 @@ int q6asm_media_format_block_wma(struct audio_client *ac,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for FORMAT_UPDATE\n", __func__);
@@ -3944,7 +4046,7 @@ int q6asm_media_format_block_wmapro(struct audio_client *ac,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for FORMAT_UPDATE\n", __func__);
@@ -3992,7 +4094,7 @@ int q6asm_media_format_block_amrwbplus(struct audio_client *ac,
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 				(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for FORMAT_UPDATE\n", __func__);
@@ -4044,7 +4146,7 @@ int q6asm_stream_media_format_block_flac(struct audio_client *ac,
 				__func__, rc);
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 				(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s :timeout. waited for FORMAT_UPDATE\n", __func__);
@@ -4100,7 +4202,7 @@ int q6asm_media_format_block_alac(struct audio_client *ac,
 				__func__, rc);
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 				(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s :timeout. waited for FORMAT_UPDATE\n", __func__);
@@ -4145,7 +4247,7 @@ int q6asm_stream_media_format_block_vorbis(struct audio_client *ac,
 				__func__, rc);
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 				(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s :timeout. waited for FORMAT_UPDATE\n", __func__);
@@ -4199,7 +4301,7 @@ int q6asm_media_format_block_ape(struct audio_client *ac,
 				__func__, rc);
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s :timeout. waited for FORMAT_UPDATE\n", __func__);
@@ -4247,7 +4349,7 @@ static int __q6asm_ds1_set_endp_params(struct audio_client *ac, int param_id,
 			__func__, ASM_STREAM_CMD_SET_ENCDEC_PARAM, rc);
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 		(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout opcode[0x%x]\n", __func__,
@@ -4351,7 +4453,7 @@ int q6asm_memory_map(struct audio_client *ac, phys_addr_t buf_add, int dir,
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->mem_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->mem_wait,
 			(atomic_read(&ac->mem_state) >= 0 &&
 			 ac->port[dir].tmp_hdl), 5*HZ);
 	if (!rc) {
@@ -4432,7 +4534,7 @@ int q6asm_memory_unmap(struct audio_client *ac, phys_addr_t buf_add, int dir)
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->mem_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->mem_wait,
 			(atomic_read(&ac->mem_state) >= 0), 5 * HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for memory_unmap of handle 0x%x\n",
@@ -4564,7 +4666,7 @@ static int q6asm_memory_map_regions(struct audio_client *ac, int dir,
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->mem_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->mem_wait,
 			(atomic_read(&ac->mem_state) >= 0)
 			 , 5*HZ);
 	if (!rc) {
@@ -4658,7 +4760,7 @@ static int q6asm_memory_unmap_regions(struct audio_client *ac, int dir)
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->mem_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->mem_wait,
 			(atomic_read(&ac->mem_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for memory_unmap of handle 0x%x\n",
@@ -4741,7 +4843,7 @@ int q6asm_set_lrgain(struct audio_client *ac, int left_gain, int right_gain)
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout, set-params paramid[0x%x]\n", __func__,
@@ -4839,7 +4941,7 @@ int q6asm_set_multich_gain(struct audio_client *ac, uint32_t channels,
 		goto done;
 	}
 
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout, set-params paramid[0x%x]\n", __func__,
@@ -4902,7 +5004,7 @@ int q6asm_set_mute(struct audio_client *ac, int muteflag)
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout, set-params paramid[0x%x]\n", __func__,
@@ -5007,7 +5109,7 @@ int q6asm_dts_eagle_set(struct audio_client *ac, int param_id, uint32_t size,
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 1*HZ);
 	if (!rc) {
 		pr_err("DTS_EAGLE_ASM - %s: timeout, set-params paramid[0x%x]\n",
@@ -5118,7 +5220,7 @@ int q6asm_dts_eagle_get(struct audio_client *ac, int param_id, uint32_t size,
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 1*HZ);
 	if (!rc) {
 		pr_err("DTS_EAGLE_ASM - %s: timeout in get\n",
@@ -5202,7 +5304,7 @@ static int __q6asm_set_volume(struct audio_client *ac, int volume, int instance)
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout, set-params paramid[0x%x]\n", __func__,
@@ -5281,7 +5383,7 @@ int q6asm_set_softpause(struct audio_client *ac,
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout, set-params paramid[0x%x]\n", __func__,
@@ -5359,7 +5461,7 @@ static int __q6asm_set_softvolume(struct audio_client *ac,
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout, set-params paramid[0x%x]\n", __func__,
@@ -5466,7 +5568,7 @@ int q6asm_equalizer(struct audio_client *ac, void *eq_p)
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout, set-params paramid[0x%x]\n", __func__,
@@ -5975,7 +6077,7 @@ int q6asm_get_session_time(struct audio_client *ac, uint64_t *tstamp)
 		       mtmx_params.hdr.opcode, rc);
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->time_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->time_wait,
 			(atomic_read(&ac->time_flag) == 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout in getting session time from DSP\n",
@@ -5983,6 +6085,7 @@ int q6asm_get_session_time(struct audio_client *ac, uint64_t *tstamp)
 		goto fail_cmd;
 	}
 
+	q6asm_update_drift(ac, ac->time_stamp);
 	*tstamp = ac->time_stamp;
 	return 0;
 
@@ -6040,7 +6143,7 @@ int q6asm_send_audio_effects_params(struct audio_client *ac, char *params,
 		rc = -EINVAL;
 		goto fail_send_param;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 				(atomic_read(&ac->cmd_state) >= 0), 1*HZ);
 	if (!rc) {
 		pr_err("%s: timeout, audio effects set-params\n", __func__);
@@ -6112,7 +6215,7 @@ int q6asm_send_mtmx_strtr_window(struct audio_client *ac,
 		goto fail_cmd;
 	}
 
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout, Render window start paramid[0x%x]\n",
@@ -6193,6 +6296,7 @@ static int __q6asm_cmd(struct audio_client *ac, int cmd, uint32_t stream_id)
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
+	q6asm_reset_drift(ac);
 	pr_debug("%s: session[%d]opcode[0x%x]\n", __func__,
 			ac->session,
 			hdr.opcode);
@@ -6203,7 +6307,8 @@ static int __q6asm_cmd(struct audio_client *ac, int cmd, uint32_t stream_id)
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait, (atomic_read(state) >= 0), 5*HZ);
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
+			(atomic_read(state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for response opcode[0x%x]\n",
 				__func__, hdr.opcode);
@@ -6298,6 +6403,7 @@ static int __q6asm_cmd_nowait(struct audio_client *ac, int cmd,
 		pr_err("%s: Invalid format[%d]\n", __func__, cmd);
 		goto fail_cmd;
 	}
+	q6asm_reset_drift(ac);
 	pr_debug("%s: session[%d]opcode[0x%x]\n", __func__,
 			ac->session,
 			hdr.opcode);
@@ -6455,7 +6561,7 @@ int q6asm_reg_tx_overflow(struct audio_client *ac, uint16_t enable)
 		rc = -EINVAL;
 		goto fail_cmd;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 				(atomic_read(&ac->cmd_state) >= 0), 5*HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for tx overflow\n", __func__);
@@ -6530,7 +6636,7 @@ int q6asm_get_path_delay(struct audio_client *ac)
 		return rc;
 	}
 
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 			(atomic_read(&ac->cmd_state) >= 0), 5 * HZ);
 	if (!rc) {
 		pr_err("%s: timeout. waited for response opcode[0x%x]\n",
@@ -6729,7 +6835,7 @@ int q6asm_send_cal(struct audio_client *ac)
 		rc = -EINVAL;
 		goto free;
 	}
-	rc = wait_event_timeout(ac->cmd_wait,
+	rc = q6asm_wait_event_timeout(ac, ac->cmd_wait,
 				(atomic_read(&ac->cmd_state) <= 0), 5 * HZ);
 	if (!rc) {
 		pr_err("%s: timeout, audio audstrm cal send\n", __func__);
@@ -6941,6 +7047,10 @@ static int __init q6asm_init(void)
 
 	memset(session, 0, sizeof(session));
 	set_custom_topology = 1;
+	for (lcnt = 0; lcnt <= SESSION_MAX; lcnt++) {
+		q6audio_latency_hist_init(&session_latency[lcnt].apr);
+		q6audio_latency_hist_init(&session_latency[lcnt].drift);
+	}
 
 	
 	common_client.session = ASM_CONTROL_SESSION;
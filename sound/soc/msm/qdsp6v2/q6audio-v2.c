@@ -16,9 +16,66 @@
 #include <linux/jiffies.h>
 #include <linux/uaccess.h>
 #include <linux/atomic.h>
+#include <linux/math64.h>
 #include <sound/q6afe-v2.h>
 #include <sound/q6audio-v2.h>
 
+void q6audio_latency_hist_init(struct q6audio_latency_hist *hist)
+{
+	spin_lock_init(&hist->lock);
+	q6audio_latency_hist_reset(hist);
+}
+
+void q6audio_latency_hist_reset(struct q6audio_latency_hist *hist)
+{
+	spin_lock(&hist->lock);
+	memset(hist->buckets, 0, sizeof(hist->buckets));
+	hist->count = 0;
+	hist->timeouts = 0;
+	hist->total_us = 0;
+	hist->max_us = 0;
+	spin_unlock(&hist->lock);
+}
+
+void q6audio_latency_hist_add(struct q6audio_latency_hist *hist, s64 us)
+{
+	int idx;
+
+	if (!hist)
+		return;
+
+	spin_lock(&hist->lock);
+	if (us < 0) {
+		hist->timeouts++;
+		goto unlock;
+	}
+
+	idx = us < USEC_PER_MSEC ? 0 : fls(div_s64(us, USEC_PER_MSEC));
+	hist->buckets[min(idx, Q6AUDIO_LATENCY_BUCKETS - 1)]++;
+	hist->count++;
+	hist->total_us += us;
+	if (us > hist->max_us)
+		hist->max_us = us;
+unlock:
+	spin_unlock(&hist->lock);
+}
+
+void q6audio_latency_hist_show(struct seq_file *m, const char *name,
+			       struct q6audio_latency_hist *hist)
+{
+	int i;
+
+	spin_lock(&hist->lock);
+	seq_printf(m, "%s: count %u timeouts %u avg %llu us max %u us\n",
+		   name, hist->count, hist->timeouts,
+		   hist->count ? div_u64(hist->total_us, hist->count) : 0,
+		   hist->max_us);
+	for (i = 0; i < Q6AUDIO_LATENCY_BUCKETS - 1; i++)
+		seq_printf(m, "  <%ums: %u\n", 1 << i, hist->buckets[i]);
+	seq_printf(m, "  >=%ums: %u\n", 1 << i, hist->buckets[i]);
+	spin_unlock(&hist->lock);
+}
+
 int q6audio_get_port_index(u16 port_id)
 {
 	switch (port_id) {